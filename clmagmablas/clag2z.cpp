@@ -117,7 +117,7 @@ magmablas_clag2z(
         err |= clSetKernelArg( kernel, arg++, sizeof(lda      ), &lda       );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
@@ -0,0 +1,54 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include "kernels_header.h"
+
+/*
+    Copies n elements of x, with stride incx, to y, with stride incy,
+    one thread per element. Used to gather a strided vector into a dense
+    buffer, or scatter a dense buffer into a strided vector.
+
+    Elements are moved as raw 4, 8, or 16 byte words, so one kernel of
+    each size serves every data type of that size; no double support is
+    needed for double and complex data.
+*/
+
+__kernel
+void copyvector_kernel_4(
+    magma_int_t n,
+    __global const uint *x, unsigned long x_offset, magma_int_t incx,
+    __global uint       *y, unsigned long y_offset, magma_int_t incy )
+{
+    int i = get_global_id(0);
+    if ( i < n ) {
+        y[ y_offset + (unsigned long) i*incy ] = x[ x_offset + (unsigned long) i*incx ];
+    }
+}
+
+__kernel
+void copyvector_kernel_8(
+    magma_int_t n,
+    __global const uint2 *x, unsigned long x_offset, magma_int_t incx,
+    __global uint2       *y, unsigned long y_offset, magma_int_t incy )
+{
+    int i = get_global_id(0);
+    if ( i < n ) {
+        y[ y_offset + (unsigned long) i*incy ] = x[ x_offset + (unsigned long) i*incx ];
+    }
+}
+
+__kernel
+void copyvector_kernel_16(
+    magma_int_t n,
+    __global const uint4 *x, unsigned long x_offset, magma_int_t incx,
+    __global uint4       *y, unsigned long y_offset, magma_int_t incy )
+{
+    int i = get_global_id(0);
+    if ( i < n ) {
+        y[ y_offset + (unsigned long) i*incy ] = x[ x_offset + (unsigned long) i*incx ];
+    }
+}
@@ -0,0 +1,120 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include "clmagma_runtime.h"
+#include "common_magma.h"
+#include "trace.h"
+
+#define BLOCK_SIZE 256
+
+// (no precision generation; elements are copied as raw words)
+
+/**
+    Purpose
+    -------
+    MAGMABLAS_COPYVECTOR copies n elements of dx, with stride incx, to dy,
+    with stride incy, in one kernel. With incy = 1 it gathers a strided
+    vector into a dense buffer; with incx = 1 it scatters a dense buffer
+    into a strided vector. magma_setvector and magma_getvector use it so
+    that strided transfers are one contiguous DMA plus one kernel.
+
+    The kernel is only enqueued; it is not waited for.
+
+    Arguments
+    ---------
+    @param[in]
+    n       INTEGER
+            Number of elements to copy.  N >= 0.
+
+    @param[in]
+    elemSize INTEGER
+            Size of an element in bytes: 4, 8, or 16.
+
+    @param[in]
+    dx      Array on the GPU, of elements of elemSize bytes.
+            Offset dx_offset and stride incx are in elements.  INCX > 0.
+
+    @param[out]
+    dy      Array on the GPU, of elements of elemSize bytes.
+            Offset dy_offset and stride incy are in elements.  INCY > 0.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    event   magma_event_t
+            If not NULL, on exit, an event for the kernel.
+
+    @return
+      -     MAGMA_SUCCESS
+      -     MAGMA_ERR_NOT_SUPPORTED if elemSize is not 4, 8, or 16;
+            nothing is copied.
+      -     < 0: if -i, the i-th argument had an illegal value.
+
+    @ingroup magma_aux1
+    ********************************************************************/
+extern "C" magma_int_t
+magmablas_copyvector_async(
+    magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magma_ptr       dy, size_t dy_offset, magma_int_t incy,
+    magma_queue_t queue, magma_event_t *event )
+{
+    cl_kernel kernel;
+    cl_int err;
+    int arg;
+
+    magma_int_t info = 0;
+    if ( n < 0 )
+        info = -1;
+    else if ( incx <= 0 )
+        info = -5;
+    else if ( incy <= 0 )
+        info = -8;
+    if ( info != 0 ) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
+
+    const char* name;
+    switch( elemSize ) {
+        case  4: name = "copyvector_kernel_4";  break;
+        case  8: name = "copyvector_kernel_8";  break;
+        case 16: name = "copyvector_kernel_16"; break;
+        default: return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    if ( n == 0 )
+        return MAGMA_SUCCESS;
+
+    size_t threads[1];
+    threads[0] = BLOCK_SIZE;
+    size_t grid[1];
+    grid[0] = magma_ceildiv( n, BLOCK_SIZE );
+    grid[0] *= threads[0];
+
+    kernel = g_runtime.get_kernel( name );
+    if ( kernel == NULL ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    err = 0;
+    arg = 0;
+    err |= clSetKernelArg( kernel, arg++, sizeof(n        ), &n         );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dx       ), &dx        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dx_offset), &dx_offset );
+    err |= clSetKernelArg( kernel, arg++, sizeof(incx     ), &incx      );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dy       ), &dy        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dy_offset), &dy_offset );
+    err |= clSetKernelArg( kernel, arg++, sizeof(incy     ), &incy      );
+    check_error( err );
+    err = magma_enqueue_kernel( queue, kernel, 1, NULL, grid, threads, 0, NULL,
+                                trace_event( event ));
+    check_error( err );
+    trace_command( queue, "kernel", __func__ );
+    return MAGMA_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "kernels_header.h"
+#include "dzasum.h"
+
+#define COMPLEX
+
+// |Re(x)| + |Im(x)|, as in reference BLAS dcabs1
+#ifdef COMPLEX
+#define ABS1( a )  (fabs( (a).x ) + fabs( (a).y ))
+#else
+#define ABS1( a )  fabs( a )
+#endif
+
+
+// ----------------------------------------
+/// Sum reduction of NB_X values, leaving the total in x[0].
+void dzasum_reduce( int i, __local double* x );  // prototype to suppress compiler warning
+void dzasum_reduce( int i, __local double* x )
+{
+    for( int k = NB_X/2; k > 0; k /= 2 ) {
+        barrier( CLK_LOCAL_MEM_FENCE );
+        if ( i < k ) {
+            x[i] += x[i+k];
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+}
+
+
+// ----------------------------------------
+/// First pass: each block sums its strided part of x into work[ block ].
+__kernel void
+dzasum_kernel(
+    int n,
+    __global const magmaDoubleComplex* x, unsigned long x_offset, int incx,
+    __global double* work, unsigned long work_offset )
+{
+    x    += x_offset;
+    work += work_offset;
+
+    __local double ssum[ NB_X ];
+    int tx = get_local_id(0);
+
+    double sum = 0;
+    for( int i = get_global_id(0); i < n; i += get_global_size(0) ) {
+        sum += ABS1( x[ i*incx ] );
+    }
+    ssum[tx] = sum;
+    dzasum_reduce( tx, ssum );
+    if ( tx == 0 ) {
+        work[ get_group_id(0) ] = ssum[0];
+    }
+}
+
+
+// ----------------------------------------
+/// Second pass, with one block: sums the nblocks partial results into
+/// result[0].
+__kernel void
+dzasum_final_kernel(
+    int nblocks,
+    __global const double* work,   unsigned long work_offset,
+    __global double*       result, unsigned long result_offset )
+{
+    work   += work_offset;
+    result += result_offset;
+
+    __local double ssum[ NB_X ];
+    int tx = get_local_id(0);
+
+    ssum[tx] = (tx < nblocks ? work[tx] : 0);
+    dzasum_reduce( tx, ssum );
+    if ( tx == 0 ) {
+        result[0] = ssum[0];
+    }
+}
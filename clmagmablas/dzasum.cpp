@@ -0,0 +1,187 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "clmagma_runtime.h"
+#include "common_magma.h"
+#include "dzasum.h"
+
+// scratch layout: MAX_BLOCKS partial sums, then the result for magma_dzasum
+#define RESULT_BYTES  (MAX_BLOCKS*sizeof(double))
+
+
+// ----------------------------------------
+// Enqueues both passes of dzasum, with partial sums in the queue's scratch
+// buffer. Writes the sum to dresult[ dresult_offset ], or if dresult is
+// NULL, to the scratch buffer, which is returned in dresult and
+// dresult_offset.
+static magma_int_t
+dzasum_launch(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magmaDouble_ptr* dresult, size_t* dresult_offset,
+    magma_queue_t queue, magma_event_t* event )
+{
+    cl_kernel kernel;
+    cl_int err;
+    int arg;
+
+    cl_mem dwork;
+    magma_int_t info = g_runtime.get_scratch().get(
+        queue, RESULT_BYTES + sizeof(double), &dwork );
+    if ( info != MAGMA_SUCCESS ) {
+        return info;
+    }
+    if ( *dresult == NULL ) {
+        *dresult = dwork;
+        *dresult_offset = RESULT_BYTES / sizeof(double);
+    }
+    size_t work_offset = 0;
+
+    int nn      = (int) n;
+    int inc     = (int) incx;
+    int nblocks = (int) min( magma_ceildiv( n, NB_X ), MAX_BLOCKS );
+    size_t threads[1] = { NB_X };
+    size_t grid[1]    = { (size_t) nblocks*NB_X };
+    kernel = g_runtime.get_kernel( "dzasum_kernel" );
+    if ( kernel == NULL ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    err = 0;
+    arg = 0;
+    err |= clSetKernelArg( kernel, arg++, sizeof(nn         ), &nn          );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dx         ), &dx          );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dx_offset  ), &dx_offset   );
+    err |= clSetKernelArg( kernel, arg++, sizeof(inc        ), &inc         );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dwork      ), &dwork       );
+    err |= clSetKernelArg( kernel, arg++, sizeof(work_offset), &work_offset );
+    check_error( err );
+    err = magma_enqueue_kernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, NULL );
+    check_error( err );
+    if ( err != CL_SUCCESS ) {
+        return err;
+    }
+
+    grid[0] = NB_X;
+    kernel = g_runtime.get_kernel( "dzasum_final_kernel" );
+    if ( kernel == NULL ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    err = 0;
+    arg = 0;
+    err |= clSetKernelArg( kernel, arg++, sizeof(nblocks        ), &nblocks        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dwork          ), &dwork          );
+    err |= clSetKernelArg( kernel, arg++, sizeof(work_offset    ), &work_offset    );
+    err |= clSetKernelArg( kernel, arg++, sizeof(*dresult       ), dresult         );
+    err |= clSetKernelArg( kernel, arg++, sizeof(*dresult_offset), dresult_offset  );
+    check_error( err );
+    err = magma_enqueue_kernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, event );
+    check_error( err );
+    return err;
+}
+
+
+/**
+    Purpose
+    -------
+    Computes the sum of absolute values of vector x, |Re(x_i)| + |Im(x_i)|,
+    i.e., one norm, as in BLAS dzasum, leaving the result on the device.
+    The reduction is done on the device in two passes, using the queue's
+    scratch buffer, so nothing is allocated or copied to the host.
+
+    Arguments
+    ---------
+    @param[in]
+    n       Number of elements in vector x. n >= 0.
+
+    @param[in]
+    dx      COMPLEX_16 array on GPU device.
+            The n element vector x of dimension (1 + (n-1)*incx).
+
+    @param[in]
+    dx_offset   Offset of x in dx.
+
+    @param[in]
+    incx    Stride between consecutive elements of dx. incx > 0.
+
+    @param[out]
+    dresult DOUBLE PRECISION array on GPU device.
+            On exit, dresult[ dresult_offset ] is the sum,
+            or 0 if n <= 0 or incx <= 0, as in BLAS.
+
+    @param[in]
+    dresult_offset  Offset of result in dresult.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    event   magma_event_t
+            If not NULL, event recorded when the result is written.
+
+    @ingroup magma_zblas1
+*/
+extern "C" magma_int_t
+magma_dzasum_async(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magmaDouble_ptr dresult, size_t dresult_offset,
+    magma_queue_t queue, magma_event_t* event )
+{
+    if ( n <= 0 || incx <= 0 ) {
+        static const double c_zero = 0;
+        cl_int err = clEnqueueWriteBuffer(
+            queue, dresult, CL_FALSE, dresult_offset*sizeof(double), sizeof(double),
+            &c_zero, 0, NULL, event );
+        check_error( err );
+        return err;
+    }
+    return dzasum_launch( n, dx, dx_offset, incx, &dresult, &dresult_offset, queue, event );
+}
+
+
+/**
+    Returns the sum of absolute values of vector x; i.e., one norm.
+    Same as magma_dzasum_async, but returns the result to the CPU,
+    which synchronizes with the queue.
+
+    @param[in]
+    n       Number of elements in vector x. n >= 0.
+
+    @param[in]
+    dx      COMPLEX_16 array on GPU device.
+            The n element vector x of dimension (1 + (n-1)*incx).
+
+    @param[in]
+    incx    Stride between consecutive elements of dx. incx > 0.
+
+    @ingroup magma_zblas1
+*/
+extern "C" double
+magma_dzasum(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magma_queue_t queue )
+{
+    // match reference BLAS edge cases
+    if ( n <= 0 || incx <= 0 )
+        return 0;
+
+    magmaDouble_ptr dresult = NULL;
+    size_t dresult_offset = 0;
+    double result = 0;
+    cl_int err = dzasum_launch( n, dx, dx_offset, incx, &dresult, &dresult_offset, queue, NULL );
+    if ( err == CL_SUCCESS ) {
+        err = clEnqueueReadBuffer(
+            queue, dresult, CL_TRUE, dresult_offset*sizeof(double), sizeof(double),
+            &result, 0, NULL, NULL );
+        check_error( err );
+    }
+    return result;
+}
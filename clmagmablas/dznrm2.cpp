@@ -50,7 +50,7 @@ magmablas_dznrm2_adjust(int k, magmaDouble_ptr xnorm, size_t xnorm_offset, magma
     ciErrNum |= clSetKernelArg( kernel, nn++, sizeof(int), (void*)&c_offset   );
     //magma_dznrm2_adjust_kernel<<< 1, k, 0, magma_stream >>> (xnorm, c);
     // launch kernel
-    ciErrNum = clEnqueueNDRangeKernel(
+    ciErrNum = magma_enqueue_kernel(
         queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
     if (ciErrNum != CL_SUCCESS)
     {
@@ -103,7 +103,7 @@ magmablas_dznrm2(int m, int num, magmaDoubleComplex_ptr da, size_t da_offset, ma
     }
     
     // launch kernel
-    ciErrNum = clEnqueueNDRangeKernel(
+    ciErrNum = magma_enqueue_kernel(
         queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
     if (ciErrNum != CL_SUCCESS)
     {
@@ -68,7 +68,7 @@ magmablas_empty(
         err |= clSetKernelArg( kernel, arg++, sizeof(dC), &dC );
         check_error( err );
         
-        err = clEnqueueNDRangeKernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
@@ -0,0 +1,105 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "kernels_header.h"
+#include "izamax.h"
+
+#define COMPLEX
+
+// |Re(x)| + |Im(x)|, as in reference BLAS dcabs1
+#ifdef COMPLEX
+#define ABS1( a )  (fabs( (a).x ) + fabs( (a).y ))
+#else
+#define ABS1( a )  fabs( a )
+#endif
+
+
+// ----------------------------------------
+/// Max reduction of NB_X (value, index) pairs, leaving the largest value in
+/// x[0] and its index in ix[0]. Ties go to the smaller index, as in BLAS.
+void izamax_reduce( int i, __local double* x, __local int* ix );  // prototype to suppress compiler warning
+void izamax_reduce( int i, __local double* x, __local int* ix )
+{
+    for( int k = NB_X/2; k > 0; k /= 2 ) {
+        barrier( CLK_LOCAL_MEM_FENCE );
+        if ( i < k ) {
+            if ( x[i+k] > x[i] || (x[i+k] == x[i] && ix[i+k] < ix[i]) ) {
+                x[i]  = x[i+k];
+                ix[i] = ix[i+k];
+            }
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+}
+
+
+// ----------------------------------------
+/// First pass: each block finds the max of its strided part of x and writes
+/// the value and 0-based index to work[ block ] and iwork[ block ].
+/// NaN entries are skipped, since comparisons with NaN are false.
+__kernel void
+izamax_kernel(
+    int n,
+    __global const magmaDoubleComplex* x, unsigned long x_offset, int incx,
+    __global double* work,  unsigned long work_offset,
+    __global int*    iwork, unsigned long iwork_offset )
+{
+    x     += x_offset;
+    work  += work_offset;
+    iwork += iwork_offset;
+
+    __local double smax[ NB_X ];
+    __local int    simax[ NB_X ];
+    int tx = get_local_id(0);
+
+    // empty threads get -1, which any entry beats
+    double vmax = -1;
+    int    imax = 0;
+    for( int i = get_global_id(0); i < n; i += get_global_size(0) ) {
+        double v = ABS1( x[ i*incx ] );
+        if ( v > vmax ) {
+            vmax = v;
+            imax = i;
+        }
+    }
+    smax[tx]  = vmax;
+    simax[tx] = imax;
+    izamax_reduce( tx, smax, simax );
+    if ( tx == 0 ) {
+        work [ get_group_id(0) ] = smax[0];
+        iwork[ get_group_id(0) ] = simax[0];
+    }
+}
+
+
+// ----------------------------------------
+/// Second pass, with one block: reduces the nblocks partial results and
+/// writes the 1-based index of the max to imax[0].
+__kernel void
+izamax_final_kernel(
+    int nblocks,
+    __global const double* work,  unsigned long work_offset,
+    __global const int*    iwork, unsigned long iwork_offset,
+    __global magma_int_t*  imax,  unsigned long imax_offset )
+{
+    work  += work_offset;
+    iwork += iwork_offset;
+    imax  += imax_offset;
+
+    __local double smax[ NB_X ];
+    __local int    simax[ NB_X ];
+    int tx = get_local_id(0);
+
+    smax[tx]  = (tx < nblocks ? work[tx]  : -1);
+    simax[tx] = (tx < nblocks ? iwork[tx] :  0);
+    izamax_reduce( tx, smax, simax );
+    if ( tx == 0 ) {
+        imax[0] = simax[0] + 1;
+    }
+}
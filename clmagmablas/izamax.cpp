@@ -0,0 +1,203 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "clmagma_runtime.h"
+#include "common_magma.h"
+#include "izamax.h"
+
+// scratch layout: MAX_BLOCKS partial values, MAX_BLOCKS partial indices,
+// then the result for magma_izamax
+#define IWORK_BYTES   (MAX_BLOCKS*sizeof(double))
+#define RESULT_BYTES  (MAX_BLOCKS*(sizeof(double) + sizeof(int)))
+
+
+// ----------------------------------------
+// Enqueues both passes of izamax, with partial results in the queue's
+// scratch buffer. Writes the 1-based index to dimax[ dimax_offset ], or if
+// dimax is NULL, to the scratch buffer, which is returned in dimax and
+// dimax_offset. A result in the scratch buffer is overwritten by the next
+// routine that uses the scratch buffer of the same queue (another izamax,
+// dzasum, etc.), so the caller must read it with the next command it
+// enqueues on queue, as magma_izamax does.
+static magma_int_t
+izamax_launch(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magmaInt_ptr* dimax, size_t* dimax_offset,
+    magma_queue_t queue, magma_event_t* event )
+{
+    cl_kernel kernel;
+    cl_int err;
+    int arg;
+
+    cl_mem dwork;
+    magma_int_t info = g_runtime.get_scratch().get(
+        queue, RESULT_BYTES + sizeof(magma_int_t), &dwork );
+    if ( info != MAGMA_SUCCESS ) {
+        return info;
+    }
+    if ( *dimax == NULL ) {
+        *dimax = dwork;
+        *dimax_offset = RESULT_BYTES / sizeof(magma_int_t);
+    }
+    size_t work_offset  = 0;
+    size_t iwork_offset = IWORK_BYTES / sizeof(int);
+
+    int nn      = (int) n;
+    int inc     = (int) incx;
+    int nblocks = (int) min( magma_ceildiv( n, NB_X ), MAX_BLOCKS );
+    size_t threads[1] = { NB_X };
+    size_t grid[1]    = { (size_t) nblocks*NB_X };
+    kernel = g_runtime.get_kernel( "izamax_kernel" );
+    if ( kernel == NULL ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    err = 0;
+    arg = 0;
+    err |= clSetKernelArg( kernel, arg++, sizeof(nn          ), &nn           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dx          ), &dx           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dx_offset   ), &dx_offset    );
+    err |= clSetKernelArg( kernel, arg++, sizeof(inc         ), &inc          );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dwork       ), &dwork        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(work_offset ), &work_offset  );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dwork       ), &dwork        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(iwork_offset), &iwork_offset );
+    check_error( err );
+    err = magma_enqueue_kernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, NULL );
+    check_error( err );
+    if ( err != CL_SUCCESS ) {
+        return err;
+    }
+
+    grid[0] = NB_X;
+    kernel = g_runtime.get_kernel( "izamax_final_kernel" );
+    if ( kernel == NULL ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    err = 0;
+    arg = 0;
+    err |= clSetKernelArg( kernel, arg++, sizeof(nblocks      ), &nblocks       );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dwork        ), &dwork         );
+    err |= clSetKernelArg( kernel, arg++, sizeof(work_offset  ), &work_offset   );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dwork        ), &dwork         );
+    err |= clSetKernelArg( kernel, arg++, sizeof(iwork_offset ), &iwork_offset  );
+    err |= clSetKernelArg( kernel, arg++, sizeof(*dimax       ), dimax          );
+    err |= clSetKernelArg( kernel, arg++, sizeof(*dimax_offset), dimax_offset   );
+    check_error( err );
+    err = magma_enqueue_kernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, event );
+    check_error( err );
+    return err;
+}
+
+
+/**
+    Purpose
+    -------
+    Finds the index of the element of vector x having max. absolute value,
+    |Re(x_i)| + |Im(x_i)|, as in BLAS izamax, leaving the result on the
+    device. The reduction is done on the device in two passes, using the
+    queue's scratch buffer, so nothing is allocated or copied to the host.
+
+    Arguments
+    ---------
+    @param[in]
+    n       Number of elements in vector x. n >= 0.
+
+    @param[in]
+    dx      COMPLEX_16 array on GPU device.
+            The n element vector x of dimension (1 + (n-1)*incx).
+
+    @param[in]
+    dx_offset   Offset of x in dx.
+
+    @param[in]
+    incx    Stride between consecutive elements of dx. incx > 0.
+
+    @param[out]
+    dimax   INTEGER array on GPU device. Must not be NULL.
+            On exit, dimax[ dimax_offset ] is the 1-based index of the max,
+            or 0 if n <= 0 or incx <= 0, as in BLAS.
+            Only the partial results are in the queue's scratch buffer, so
+            later routines that use it don't affect dimax.
+
+    @param[in]
+    dimax_offset    Offset of result in dimax.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    event   magma_event_t
+            If not NULL, event recorded when the result is written.
+
+    @ingroup magma_zblas1
+*/
+extern "C" magma_int_t
+magma_izamax_async(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magmaInt_ptr dimax, size_t dimax_offset,
+    magma_queue_t queue, magma_event_t* event )
+{
+    if ( dimax == NULL ) {
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    if ( n <= 0 || incx <= 0 ) {
+        static const magma_int_t c_zero = 0;
+        cl_int err = clEnqueueWriteBuffer(
+            queue, dimax, CL_FALSE, dimax_offset*sizeof(magma_int_t), sizeof(magma_int_t),
+            &c_zero, 0, NULL, event );
+        check_error( err );
+        return err;
+    }
+    return izamax_launch( n, dx, dx_offset, incx, &dimax, &dimax_offset, queue, event );
+}
+
+
+/**
+    Returns index of element of vector x having max. absolute value;
+    i.e., max (infinity) norm.
+    Same as magma_izamax_async, but returns the result to the CPU,
+    which synchronizes with the queue.
+
+    @param[in]
+    n       Number of elements in vector x. n >= 0.
+
+    @param[in]
+    dx      COMPLEX_16 array on GPU device.
+            The n element vector x of dimension (1 + (n-1)*incx).
+
+    @param[in]
+    incx    Stride between consecutive elements of dx. incx > 0.
+
+    @ingroup magma_zblas1
+*/
+extern "C" magma_int_t
+magma_izamax(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magma_queue_t queue )
+{
+    // match reference BLAS edge cases
+    if ( n <= 0 || incx <= 0 )
+        return 0;
+
+    magmaInt_ptr dimax = NULL;
+    size_t dimax_offset = 0;
+    magma_int_t imax = 0;
+    cl_int err = izamax_launch( n, dx, dx_offset, incx, &dimax, &dimax_offset, queue, NULL );
+    if ( err == CL_SUCCESS ) {
+        err = clEnqueueReadBuffer(
+            queue, dimax, CL_TRUE, dimax_offset*sizeof(magma_int_t), sizeof(magma_int_t),
+            &imax, 0, NULL, NULL );
+        check_error( err );
+    }
+    return imax;
+}
@@ -0,0 +1,20 @@
+#ifndef MAGMA_IZAMAX_H
+#define MAGMA_IZAMAX_H
+
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// NB_X is number of threads in a block, a power of 2.
+// MAX_BLOCKS is max number of blocks in the first pass; <= NB_X, since
+// the second pass reduces one partial result per thread.
+#define NB_X       256
+#define MAX_BLOCKS 64
+
+#endif // MAGMA_IZAMAX_H
@@ -9,6 +9,10 @@ const struct kernel_files_t c_kernel_files[] = {
 { "caxpycp_kernel",                        "caxpycp.cl"             },
 { "cgeadd_full",                           "cgeadd.cl"              },
 { "magmablas_cgemm_reduce_kernel",         "cgemm_reduce.cl"        },
+{ "cgeqrf_batched_panel_kernel",           "cgeqrf_batched.cl"      },
+{ "cgeqrf_batched_update_kernel",          "cgeqrf_batched.cl"      },
+{ "cgetrf_batched_panel_kernel",           "cgetrf_batched.cl"      },
+{ "cgetrf_batched_update_kernel",          "cgetrf_batched.cl"      },
 { "clacpy_full_kernel",                    "clacpy.cl"              },
 { "clacpy_lower_kernel",                   "clacpy.cl"              },
 { "clacpy_upper_kernel",                   "clacpy.cl"              },
@@ -42,6 +46,11 @@ const struct kernel_files_t c_kernel_files[] = {
 { "claswp_kernel",                         "claswp.cl"              },
 { "claswpx_kernel",                        "claswp.cl"              },
 { "claswp2_kernel",                        "claswp.cl"              },
+{ "copyvector_kernel_4",                   "copyvector.cl"          },
+{ "copyvector_kernel_8",                   "copyvector.cl"          },
+{ "copyvector_kernel_16",                  "copyvector.cl"          },
+{ "cpotrf_batched_panel_kernel",           "cpotrf_batched.cl"      },
+{ "cpotrf_batched_update_kernel",          "cpotrf_batched.cl"      },
 { "cswap_kernel",                          "cswap.cl"               },
 { "csymmetrize_lower",                     "csymmetrize.cl"         },
 { "csymmetrize_upper",                     "csymmetrize.cl"         },
@@ -51,12 +60,24 @@ const struct kernel_files_t c_kernel_files[] = {
 { "ctranspose_inplace_odd",                "ctranspose_inplace.cl"  },
 { "ctranspose_inplace_even",               "ctranspose_inplace.cl"  },
 { "empty_kernel",                          "empty.cl"               },
+{ "icamax_kernel",                         "icamax.cl"              },
+{ "icamax_final_kernel",                   "icamax.cl"              },
+{ "isamax_kernel",                         "isamax.cl"              },
+{ "isamax_final_kernel",                   "isamax.cl"              },
 { "magma_smax_nan_kernel",                 "magma_smax_nan.cl"      },
+{ "sasum_kernel",                          "sasum.cl"               },
+{ "sasum_final_kernel",                    "sasum.cl"               },
 { "saxpycp_kernel",                        "saxpycp.cl"             },
+{ "scasum_kernel",                         "scasum.cl"              },
+{ "scasum_final_kernel",                   "scasum.cl"              },
 { "magmablas_scnrm2_kernel",               "scnrm2.cl"              },
 { "magmablas_scnrm2_adjust_kernel",        "scnrm2.cl"              },
 { "sgeadd_full",                           "sgeadd.cl"              },
 { "magmablas_sgemm_reduce_kernel",         "sgemm_reduce.cl"        },
+{ "sgeqrf_batched_panel_kernel",           "sgeqrf_batched.cl"      },
+{ "sgeqrf_batched_update_kernel",          "sgeqrf_batched.cl"      },
+{ "sgetrf_batched_panel_kernel",           "sgetrf_batched.cl"      },
+{ "sgetrf_batched_update_kernel",          "sgetrf_batched.cl"      },
 { "slacpy_full_kernel",                    "slacpy.cl"              },
 { "slacpy_lower_kernel",                   "slacpy.cl"              },
 { "slacpy_upper_kernel",                   "slacpy.cl"              },
@@ -92,6 +113,8 @@ const struct kernel_files_t c_kernel_files[] = {
 { "slaswp2_kernel",                        "slaswp.cl"              },
 { "magmablas_snrm2_kernel",                "snrm2.cl"               },
 { "magmablas_snrm2_adjust_kernel",         "snrm2.cl"               },
+{ "spotrf_batched_panel_kernel",           "spotrf_batched.cl"      },
+{ "spotrf_batched_update_kernel",          "spotrf_batched.cl"      },
 { "sswap_kernel",                          "sswap.cl"               },
 { "ssymmetrize_lower",                     "ssymmetrize.cl"         },
 { "ssymmetrize_upper",                     "ssymmetrize.cl"         },
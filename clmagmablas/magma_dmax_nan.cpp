@@ -38,7 +38,7 @@ magmablas_dmax_nan(
         err |= clSetKernelArg( kernel, arg++, sizeof(dx_offset), &dx_offset );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, 1, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
     
@@ -49,7 +49,7 @@ magmablas_zaxpycp(
         err |= clSetKernelArg( kernel, arg++, sizeof(b_offset), &b_offset );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
@@ -52,7 +52,7 @@ magmablas_zcaxpycp(
         err |= clSetKernelArg( kernel, arg++, sizeof(w_offset), &w_offset );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
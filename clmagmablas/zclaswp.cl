@@ -0,0 +1,47 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+*/
+#include "kernels_header.h"
+#include "zclaswp.h"
+
+// each thread does one row i, in all n columns:
+// if inc > 0, SA(i,:) = A(perm(i),:), converting to single;
+// else        A(perm(i),:) = SA(i,:), converting to double.
+__kernel void
+zclaswp_kernel(
+    int n, int m,
+    __global magmaDoubleComplex *A,  unsigned long A_offset,  int lda,
+    __global magmaFloatComplex  *SA, unsigned long SA_offset, int ldsa,
+    __global const magma_int_t *perm, unsigned long perm_offset,
+    int inc )
+{
+    A    += A_offset;
+    SA   += SA_offset;
+    perm += perm_offset;
+
+    magmaDoubleComplex tmp;
+    magmaFloatComplex  stmp;
+
+    const int i = get_local_id(0) + get_group_id(0)*NB;
+    if ( i < m ) {
+        const int p = perm[i];
+        if ( inc > 0 ) {
+            for( int j = 0; j < n; ++j ) {
+                tmp = A[p + j*lda];
+                SA[i + j*ldsa] = MAGMA_C_MAKE( MAGMA_Z_REAL(tmp), MAGMA_Z_IMAG(tmp) );
+            }
+        }
+        else {
+            for( int j = 0; j < n; ++j ) {
+                stmp = SA[i + j*ldsa];
+                A[p + j*lda] = MAGMA_Z_MAKE( MAGMA_C_REAL(stmp), MAGMA_C_IMAG(stmp) );
+            }
+        }
+    }
+}
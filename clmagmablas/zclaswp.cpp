@@ -0,0 +1,128 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+*/
+#include "clmagma_runtime.h"
+#include "common_magma.h"
+#include "zclaswp.h"
+
+
+/**
+    Purpose
+    -------
+    ZCLASWP permutes the rows of a double-complex matrix A and converts
+    it to a single-complex matrix SA, or the reverse.
+
+    If incx > 0, SA(i,:) = A(perm(i),:), converting to single.
+    If incx < 0, A(perm(i),:) = SA(i,:), converting to double.
+
+    Unlike LAPACK's zlaswp, perm is a permutation, not a sequence of
+    interchanges to apply one after another, so all rows are done in
+    parallel. Row i of P*A is row perm(i) of A, where P*A = L*U from ZGETRF.
+
+    Arguments
+    ---------
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrices A and SA.  n >= 0.
+
+    @param[in,out]
+    A       COMPLEX_16 array on the GPU, dimension (LDA,n)
+            The m-by-n matrix A. Input if incx > 0, output otherwise.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,m).
+
+    @param[in,out]
+    SA      COMPLEX array on the GPU, dimension (LDSA,n)
+            The m-by-n matrix SA. Output if incx > 0, input otherwise.
+
+    @param[in]
+    ldsa    INTEGER
+            The leading dimension of the array SA.  LDSA >= max(1,m).
+
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrices A and SA.  m >= 0.
+
+    @param[in]
+    perm    INTEGER array on the GPU, dimension (m)
+            The 0-based row permutation.
+
+    @param[in]
+    incx    INTEGER
+            The direction of the permutation and conversion, see above.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @ingroup magma_zaux2
+    ********************************************************************/
+extern "C" void
+magmablas_zclaswp(
+    magma_int_t n,
+    magmaDoubleComplex_ptr A,  size_t A_offset,  magma_int_t lda,
+    magmaFloatComplex_ptr  SA, size_t SA_offset, magma_int_t ldsa,
+    magma_int_t m,
+    magmaInt_const_ptr perm, size_t perm_offset, magma_int_t incx,
+    magma_queue_t queue )
+{
+    cl_kernel kernel;
+    cl_int err;
+    int arg;
+
+    magma_int_t info = 0;
+    if ( n < 0 )
+        info = -1;
+    else if ( lda < max(1,m) )
+        info = -4;
+    else if ( ldsa < max(1,m) )
+        info = -7;
+    else if ( m < 0 )
+        info = -8;
+
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return;
+    }
+
+    /* quick return */
+    if ( m == 0 || n == 0 )
+        return;
+
+    int nn = (int) n, mm = (int) m, ldda = (int) lda, lddsa = (int) ldsa, inc = (int) incx;
+
+    const int ndim = 1;
+    size_t threads[ndim];
+    threads[0] = NB;
+    size_t grid[ndim];
+    grid[0] = magma_ceildiv( m, NB );
+    grid[0] *= threads[0];
+    kernel = g_runtime.get_kernel( "zclaswp_kernel" );
+    if ( kernel != NULL ) {
+        err = 0;
+        arg = 0;
+        err |= clSetKernelArg( kernel, arg++, sizeof(nn         ), &nn          );
+        err |= clSetKernelArg( kernel, arg++, sizeof(mm         ), &mm          );
+        err |= clSetKernelArg( kernel, arg++, sizeof(A          ), &A           );
+        err |= clSetKernelArg( kernel, arg++, sizeof(A_offset   ), &A_offset    );
+        err |= clSetKernelArg( kernel, arg++, sizeof(ldda       ), &ldda        );
+        err |= clSetKernelArg( kernel, arg++, sizeof(SA         ), &SA          );
+        err |= clSetKernelArg( kernel, arg++, sizeof(SA_offset  ), &SA_offset   );
+        err |= clSetKernelArg( kernel, arg++, sizeof(lddsa      ), &lddsa       );
+        err |= clSetKernelArg( kernel, arg++, sizeof(perm       ), &perm        );
+        err |= clSetKernelArg( kernel, arg++, sizeof(perm_offset), &perm_offset );
+        err |= clSetKernelArg( kernel, arg++, sizeof(inc        ), &inc         );
+        check_error( err );
+
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        check_error( err );
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef MAGMA_ZCLASWP_H
+#define MAGMA_ZCLASWP_H
+
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+*/
+
+#define NB 64
+
+#endif // MAGMA_ZCLASWP_H
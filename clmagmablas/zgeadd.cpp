@@ -112,7 +112,7 @@ magmablas_zgeadd(
         err |= clSetKernelArg( kernel, arg++, sizeof(lddb     ), &lddb      );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
@@ -99,7 +99,7 @@ magmablas_zgemm_reduce(
         GlobalWorkSize[2] = 1*LocalWorkSize[2];
     
         // launch kernel
-        ciErrNum = clEnqueueNDRangeKernel(
+        ciErrNum = magma_enqueue_kernel(
             queue, kernel, 3, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
         if (ciErrNum != CL_SUCCESS)
         {
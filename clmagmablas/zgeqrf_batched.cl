@@ -0,0 +1,189 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "kernels_header.h"
+#include "zgeqrf_batched.h"
+
+#define COMPLEX
+
+// |x|^2
+#ifdef COMPLEX
+#define ABS2( a )  ((a).x*(a).x + (a).y*(a).y)
+#else
+#define ABS2( a )  ((a)*(a))
+#endif
+
+// Matrix batchid of the batch. For fixed size, dm is NULL and matrices are
+// strideA apart; for variable size, dm, dn, dldda, and dA_offsets give each
+// matrix's size and position, and strideA is 0.
+#define GET_MATRIX()                                       \
+    const int batchid = get_group_id(1);                   \
+    int lda = ldda;                                        \
+    dA += dA_offset + batchid*strideA;                     \
+    if ( dm != 0 ) {                                       \
+        m   = dm[ batchid ];                               \
+        n   = dn[ batchid ];                               \
+        lda = dldda[ batchid ];                            \
+        dA += dA_offsets[ batchid ];                       \
+    }                                                      \
+    dtau += dtau_offset + batchid*stridetau;
+
+
+// ----------------------------------------
+/// Sum reduction of NTX values, leaving the sum in x[0].
+void zgeqrf_batched_reduce( int i, __local double* x );  // prototype to suppress compiler warning
+void zgeqrf_batched_reduce( int i, __local double* x )
+{
+    for( int k = NTX/2; k > 0; k /= 2 ) {
+        barrier( CLK_LOCAL_MEM_FENCE );
+        if ( i < k ) {
+            x[i] += x[i+k];
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+}
+
+
+// ----------------------------------------
+/// Factors the panel A(j:m, j:j+jb) of each matrix with Householder
+/// reflectors, as in LAPACK zgeqr2, keeping the panel in local memory sA,
+/// followed by jb elements of workspace. One block per matrix, with the
+/// batch along the second grid dimension. Writes tau(j:j+jb).
+__kernel void
+zgeqrf_batched_panel_kernel(
+    int m, int n, int j, int nb,
+    __global magmaDoubleComplex* dA, unsigned long dA_offset, int ldda, unsigned long strideA,
+    __global const magma_int_t* dm,
+    __global const magma_int_t* dn,
+    __global const magma_int_t* dldda,
+    __global const magma_int_t* dA_offsets,
+    __global magmaDoubleComplex* dtau, unsigned long dtau_offset, int stridetau,
+    __local magmaDoubleComplex* sA )
+{
+    GET_MATRIX();
+
+    const int tx     = get_local_id(0);
+    const int min_mn = min( m, n );
+    if ( j >= min_mn )
+        return;
+    const int jb   = min( nb, min_mn - j );
+    const int rows = m - j;  // also leading dimension of sA
+
+    __local magmaDoubleComplex* sW = sA + rows*jb;
+    __local double snorm[ NTX ];
+    __local magmaDoubleComplex sscal[ 2 ];
+
+    for( int c = 0; c < jb; ++c ) {
+        for( int i = tx; i < rows; i += NTX ) {
+            sA[ i + c*rows ] = dA[ (j+i) + (j+c)*lda ];
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    for( int k = 0; k < jb; ++k ) {
+        // generate reflector H(k) to annihilate sA(k+1:rows, k), as in zlarfg
+        double sum = 0;
+        for( int i = k + 1 + tx; i < rows; i += NTX ) {
+            sum += ABS2( sA[ i + k*rows ] );
+        }
+        snorm[tx] = sum;
+        zgeqrf_batched_reduce( tx, snorm );
+        if ( tx == 0 ) {
+            magmaDoubleComplex alpha = sA[ k + k*rows ];
+            double alphr = MAGMA_Z_REAL( alpha );
+            double alphi = MAGMA_Z_IMAG( alpha );
+            double xnorm2 = snorm[0];
+            if ( xnorm2 == 0 && alphi == 0 ) {
+                // H = I
+                sscal[0] = MAGMA_Z_ZERO;
+                sscal[1] = MAGMA_Z_ZERO;
+            }
+            else {
+                double beta = -copysign( sqrt( alphr*alphr + alphi*alphi + xnorm2 ), alphr );
+                sscal[0] = MAGMA_Z_MAKE( (beta - alphr)/beta, -alphi/beta );
+                sscal[1] = MAGMA_Z_DIV( MAGMA_Z_ONE, MAGMA_Z_SUB( alpha, MAGMA_Z_MAKE( beta, 0 )));
+                sA[ k + k*rows ] = MAGMA_Z_MAKE( beta, 0 );
+            }
+            dtau[ j+k ] = sscal[0];
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+        const magmaDoubleComplex tau   = sscal[0];
+        const magmaDoubleComplex scale = sscal[1];
+        for( int i = k + 1 + tx; i < rows; i += NTX ) {
+            sA[ i + k*rows ] = MAGMA_Z_MUL( sA[ i + k*rows ], scale );
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+
+        // apply H(k)^H to sA(k:rows, k+1:jb), from the left:
+        // w = v^H A, then A -= conj(tau) v w, with v(k) = 1
+        for( int c = k + 1 + tx; c < jb; c += NTX ) {
+            magmaDoubleComplex w = sA[ k + c*rows ];
+            for( int i = k+1; i < rows; ++i ) {
+                w = MAGMA_Z_ADD( w, MAGMA_Z_MUL( MAGMA_Z_CNJG( sA[ i + k*rows ] ), sA[ i + c*rows ] ));
+            }
+            sW[ c ] = MAGMA_Z_MUL( MAGMA_Z_CNJG( tau ), w );
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+        for( int i = k + tx; i < rows; i += NTX ) {
+            magmaDoubleComplex v = (i == k ? MAGMA_Z_ONE : sA[ i + k*rows ]);
+            for( int c = k+1; c < jb; ++c ) {
+                sA[ i + c*rows ] = MAGMA_Z_SUB( sA[ i + c*rows ], MAGMA_Z_MUL( v, sW[ c ] ));
+            }
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+    }
+
+    for( int c = 0; c < jb; ++c ) {
+        for( int i = tx; i < rows; i += NTX ) {
+            dA[ (j+i) + (j+c)*lda ] = sA[ i + c*rows ];
+        }
+    }
+}
+
+
+// ----------------------------------------
+/// Applies H(j+jb-1)^H ... H(j)^H of the panel to columns c >= j+jb, one
+/// reflector at a time. Each thread does one column c; the batch is along
+/// the second grid dimension.
+__kernel void
+zgeqrf_batched_update_kernel(
+    int m, int n, int j, int nb,
+    __global magmaDoubleComplex* dA, unsigned long dA_offset, int ldda, unsigned long strideA,
+    __global const magma_int_t* dm,
+    __global const magma_int_t* dn,
+    __global const magma_int_t* dldda,
+    __global const magma_int_t* dA_offsets,
+    __global magmaDoubleComplex* dtau, unsigned long dtau_offset, int stridetau )
+{
+    GET_MATRIX();
+
+    const int c      = get_global_id(0);
+    const int min_mn = min( m, n );
+    if ( j >= min_mn || c >= n )
+        return;
+    const int jb = min( nb, min_mn - j );
+    if ( c < j + jb )
+        return;
+
+    #define A( i_, j_ )  dA[ (i_) + (j_)*lda ]
+
+    for( int k = j; k < j + jb; ++k ) {
+        magmaDoubleComplex w = A( k, c );
+        for( int i = k+1; i < m; ++i ) {
+            w = MAGMA_Z_ADD( w, MAGMA_Z_MUL( MAGMA_Z_CNJG( A( i, k )), A( i, c )));
+        }
+        w = MAGMA_Z_MUL( MAGMA_Z_CNJG( dtau[ k ] ), w );
+        A( k, c ) = MAGMA_Z_SUB( A( k, c ), w );
+        for( int i = k+1; i < m; ++i ) {
+            A( i, c ) = MAGMA_Z_SUB( A( i, c ), MAGMA_Z_MUL( A( i, k ), w ));
+        }
+    }
+
+    #undef A
+}
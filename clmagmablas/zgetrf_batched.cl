@@ -0,0 +1,215 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "kernels_header.h"
+#include "zgetrf_batched.h"
+
+#define COMPLEX
+
+// |Re(x)| + |Im(x)|, as in LAPACK izamax
+#ifdef COMPLEX
+#define ABS1( a )  (fabs( (a).x ) + fabs( (a).y ))
+#else
+#define ABS1( a )  fabs( a )
+#endif
+
+// Matrix batchid of the batch. For fixed size, dm is NULL and matrices are
+// strideA apart; for variable size, dm, dn, dldda, and dA_offsets give each
+// matrix's size and position, and strideA is 0.
+#define GET_MATRIX()                                       \
+    const int batchid = get_group_id(1);                   \
+    int lda = ldda;                                        \
+    dA += dA_offset + batchid*strideA;                     \
+    if ( dm != 0 ) {                                       \
+        m   = dm[ batchid ];                               \
+        n   = dn[ batchid ];                               \
+        lda = dldda[ batchid ];                            \
+        dA += dA_offsets[ batchid ];                       \
+    }                                                      \
+    dipiv += dipiv_offset + batchid*strideipiv;            \
+    dinfo += dinfo_offset + batchid;
+
+
+// ----------------------------------------
+/// Max reduction of NTX (value, index) pairs, leaving the largest value in
+/// x[0] and its index in ix[0]. Ties go to the smaller index, as in LAPACK.
+void zgetrf_batched_reduce( int i, __local double* x, __local int* ix );  // prototype to suppress compiler warning
+void zgetrf_batched_reduce( int i, __local double* x, __local int* ix )
+{
+    for( int k = NTX/2; k > 0; k /= 2 ) {
+        barrier( CLK_LOCAL_MEM_FENCE );
+        if ( i < k ) {
+            if ( x[i+k] > x[i] || (x[i+k] == x[i] && ix[i+k] < ix[i]) ) {
+                x[i]  = x[i+k];
+                ix[i] = ix[i+k];
+            }
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+}
+
+
+// ----------------------------------------
+/// Factors the panel A(j:m, j:j+jb) of each matrix with partial pivoting,
+/// keeping the panel in local memory sA. One block per matrix, with the
+/// batch along the second grid dimension. Writes 1-based pivots to
+/// ipiv(j:j+jb), relative to the whole matrix, and sets info on the first
+/// zero pivot.
+__kernel void
+zgetrf_batched_panel_kernel(
+    int m, int n, int j, int nb,
+    __global magmaDoubleComplex* dA, unsigned long dA_offset, int ldda, unsigned long strideA,
+    __global const magma_int_t* dm,
+    __global const magma_int_t* dn,
+    __global const magma_int_t* dldda,
+    __global const magma_int_t* dA_offsets,
+    __global magma_int_t* dipiv, unsigned long dipiv_offset, int strideipiv,
+    __global magma_int_t* dinfo, unsigned long dinfo_offset,
+    __local magmaDoubleComplex* sA )
+{
+    GET_MATRIX();
+
+    const int tx     = get_local_id(0);
+    const int min_mn = min( m, n );
+    if ( j >= min_mn ) {
+        if ( j == 0 && tx == 0 ) {
+            *dinfo = 0;  // empty matrix
+        }
+        return;
+    }
+    const int jb   = min( nb, min_mn - j );
+    const int rows = m - j;  // also leading dimension of sA
+
+    __local double smax[ NTX ];
+    __local int    simax[ NTX ];
+
+    for( int c = 0; c < jb; ++c ) {
+        for( int i = tx; i < rows; i += NTX ) {
+            sA[ i + c*rows ] = dA[ (j+i) + (j+c)*lda ];
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+    int info = (j == 0 ? 0 : *dinfo);
+
+    for( int k = 0; k < jb; ++k ) {
+        // find pivot in column k
+        double vmax = -1;
+        int    imax = k;
+        for( int i = k + tx; i < rows; i += NTX ) {
+            double v = ABS1( sA[ i + k*rows ] );
+            if ( v > vmax ) {
+                vmax = v;
+                imax = i;
+            }
+        }
+        smax[tx]  = vmax;
+        simax[tx] = imax;
+        zgetrf_batched_reduce( tx, smax, simax );
+        const int    p     = simax[0];
+        const double pmax  = smax[0];
+        const magmaDoubleComplex pivot = sA[ p + k*rows ];
+        barrier( CLK_LOCAL_MEM_FENCE );
+
+        if ( tx == 0 ) {
+            dipiv[ j+k ] = j + p + 1;
+            if ( pmax == 0 && info == 0 ) {
+                info = j + k + 1;
+            }
+        }
+        if ( pmax != 0 ) {
+            // swap rows k and p
+            if ( p != k ) {
+                for( int c = tx; c < jb; c += NTX ) {
+                    magmaDoubleComplex tmp = sA[ k + c*rows ];
+                    sA[ k + c*rows ] = sA[ p + c*rows ];
+                    sA[ p + c*rows ] = tmp;
+                }
+            }
+            barrier( CLK_LOCAL_MEM_FENCE );
+
+            // scale column k below the diagonal and update the rest of the panel;
+            // each thread owns its rows, and row k is only read
+            for( int i = k + 1 + tx; i < rows; i += NTX ) {
+                magmaDoubleComplex l = MAGMA_Z_DIV( sA[ i + k*rows ], pivot );
+                sA[ i + k*rows ] = l;
+                for( int c = k+1; c < jb; ++c ) {
+                    sA[ i + c*rows ] = MAGMA_Z_SUB( sA[ i + c*rows ],
+                                                    MAGMA_Z_MUL( l, sA[ k + c*rows ] ));
+                }
+            }
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+    }
+
+    for( int c = 0; c < jb; ++c ) {
+        for( int i = tx; i < rows; i += NTX ) {
+            dA[ (j+i) + (j+c)*lda ] = sA[ i + c*rows ];
+        }
+    }
+    if ( tx == 0 ) {
+        *dinfo = info;
+    }
+}
+
+
+// ----------------------------------------
+/// Applies the panel's row interchanges to the columns outside the panel,
+/// then for columns right of the panel, solves A(j:j+jb, c) = L11^{-1} A(j:j+jb, c)
+/// and updates A(j+jb:m, c) -= L21 A(j:j+jb, c).
+/// Each thread does one column c; the batch is along the second grid dimension.
+__kernel void
+zgetrf_batched_update_kernel(
+    int m, int n, int j, int nb,
+    __global magmaDoubleComplex* dA, unsigned long dA_offset, int ldda, unsigned long strideA,
+    __global const magma_int_t* dm,
+    __global const magma_int_t* dn,
+    __global const magma_int_t* dldda,
+    __global const magma_int_t* dA_offsets,
+    __global magma_int_t* dipiv, unsigned long dipiv_offset, int strideipiv,
+    __global magma_int_t* dinfo, unsigned long dinfo_offset )
+{
+    GET_MATRIX();
+
+    const int c      = get_global_id(0);
+    const int min_mn = min( m, n );
+    if ( j >= min_mn || c >= n )
+        return;
+    const int jb = min( nb, min_mn - j );
+    if ( c >= j && c < j + jb )
+        return;
+
+    #define A( i_, j_ )  dA[ (i_) + (j_)*lda ]
+
+    for( int k = j; k < j + jb; ++k ) {
+        int p = dipiv[ k ] - 1;
+        if ( p != k ) {
+            magmaDoubleComplex tmp = A( k, c );
+            A( k, c ) = A( p, c );
+            A( p, c ) = tmp;
+        }
+    }
+
+    if ( c >= j + jb ) {
+        for( int k = j; k < j + jb; ++k ) {
+            magmaDoubleComplex x = A( k, c );
+            for( int i = k+1; i < j + jb; ++i ) {
+                A( i, c ) = MAGMA_Z_SUB( A( i, c ), MAGMA_Z_MUL( A( i, k ), x ));
+            }
+        }
+        for( int i = j + jb; i < m; ++i ) {
+            magmaDoubleComplex s = A( i, c );
+            for( int k = j; k < j + jb; ++k ) {
+                s = MAGMA_Z_SUB( s, MAGMA_Z_MUL( A( i, k ), A( k, c )));
+            }
+            A( i, c ) = s;
+        }
+    }
+
+    #undef A
+}
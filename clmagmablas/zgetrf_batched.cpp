@@ -0,0 +1,331 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "clmagma_runtime.h"
+#include "common_magma.h"
+#include "zgetrf_batched.h"
+
+
+// ----------------------------------------
+// Sets the arguments shared by the panel and update kernels.
+static cl_int
+zgetrf_batched_setargs(
+    cl_kernel kernel, int m, int n, int j, int nb,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, int ldda, size_t strideA,
+    magmaInt_const_ptr dm, magmaInt_const_ptr dn,
+    magmaInt_const_ptr dldda, magmaInt_const_ptr dA_offsets,
+    magmaInt_ptr dipiv, size_t dipiv_offset, int strideipiv,
+    magmaInt_ptr dinfo, size_t dinfo_offset )
+{
+    cl_int err = 0;
+    int arg = 0;
+    err |= clSetKernelArg( kernel, arg++, sizeof(m           ), &m            );
+    err |= clSetKernelArg( kernel, arg++, sizeof(n           ), &n            );
+    err |= clSetKernelArg( kernel, arg++, sizeof(j           ), &j            );
+    err |= clSetKernelArg( kernel, arg++, sizeof(nb          ), &nb           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dA          ), &dA           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dA_offset   ), &dA_offset    );
+    err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
+    err |= clSetKernelArg( kernel, arg++, sizeof(strideA     ), &strideA      );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dm          ), &dm           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dn          ), &dn           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dldda       ), &dldda        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dA_offsets  ), &dA_offsets   );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dipiv       ), &dipiv        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dipiv_offset), &dipiv_offset );
+    err |= clSetKernelArg( kernel, arg++, sizeof(strideipiv  ), &strideipiv   );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dinfo       ), &dinfo        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dinfo_offset), &dinfo_offset );
+    return err;
+}
+
+
+// ----------------------------------------
+// Factors the batch by panels of nb columns, where nb is as wide as local
+// memory allows for m rows, so small matrices take a single panel launch.
+// Each step is one panel launch and one update launch over the whole batch.
+// For fixed size, dm, dn, dldda, and dA_offsets are NULL; for variable
+// size, m and n are the max sizes and strideA is 0.
+static magma_int_t
+zgetrf_batched_launch(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t strideA,
+    magmaInt_const_ptr dm, magmaInt_const_ptr dn,
+    magmaInt_const_ptr dldda, magmaInt_const_ptr dA_offsets,
+    magmaInt_ptr dipiv, size_t dipiv_offset,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue )
+{
+    cl_kernel panel_kernel, update_kernel;
+    cl_int err;
+
+    magma_int_t min_mn = min( m, n );
+    size_t lmem = magma_queue_local_meminfo( queue );
+    size_t reserved = NTX*(sizeof(double) + sizeof(int));
+    magma_int_t nb = 0;
+    if ( lmem > reserved ) {
+        nb = (lmem - reserved) / (m*sizeof(magmaDoubleComplex));
+    }
+    nb = min( nb, min_mn );
+    if ( nb < 1 ) {
+        // a column doesn't fit in local memory
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    panel_kernel  = g_runtime.get_kernel( "zgetrf_batched_panel_kernel"  );
+    update_kernel = g_runtime.get_kernel( "zgetrf_batched_update_kernel" );
+    if ( panel_kernel == NULL || update_kernel == NULL ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+
+    size_t panel_threads[2]  = { NTX, 1 };
+    size_t panel_grid[2]     = { NTX, (size_t) batchCount };
+    size_t update_threads[2] = { NTX, 1 };
+    size_t update_grid[2]    = { (size_t) magma_roundup( n, NTX ), (size_t) batchCount };
+    size_t panel_bytes       = m*nb*sizeof(magmaDoubleComplex);
+
+    for( magma_int_t j = 0; j < min_mn; j += nb ) {
+        err = zgetrf_batched_setargs(
+            panel_kernel, m, n, j, nb, dA, dA_offset, ldda, strideA,
+            dm, dn, dldda, dA_offsets, dipiv, dipiv_offset, min_mn,
+            dinfo, dinfo_offset );
+        err |= clSetKernelArg( panel_kernel, 17, panel_bytes, NULL );
+        check_error( err );
+        err = magma_enqueue_kernel( queue, panel_kernel, 2, NULL,
+                                    panel_grid, panel_threads, 0, NULL, NULL );
+        check_error( err );
+        if ( err != CL_SUCCESS ) {
+            return err;
+        }
+
+        // for variable size, some matrix may have columns right of its panel
+        magma_int_t jb = min( nb, min_mn - j );
+        if ( j > 0 || j + jb < n || dm != NULL ) {
+            err = zgetrf_batched_setargs(
+                update_kernel, m, n, j, nb, dA, dA_offset, ldda, strideA,
+                dm, dn, dldda, dA_offsets, dipiv, dipiv_offset, min_mn,
+                dinfo, dinfo_offset );
+            check_error( err );
+            err = magma_enqueue_kernel( queue, update_kernel, 2, NULL,
+                                        update_grid, update_threads, 0, NULL, NULL );
+            check_error( err );
+            if ( err != CL_SUCCESS ) {
+                return err;
+            }
+        }
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+    ZGETRF_BATCHED computes LU factorizations of a batch of general M-by-N
+    matrices using partial pivoting with row interchanges, A = P * L * U.
+
+    This is meant for many small matrices, e.g., 32x32 or 64x64. Each
+    matrix is factored by one block of threads, in local memory, so the
+    whole batch takes one kernel launch if a matrix fits in local memory;
+    otherwise, matrices are factored by panels as wide as fit, with one
+    panel and one update launch per panel over the whole batch.
+
+    Arguments
+    ---------
+    @param[in]
+    m       INTEGER
+            The number of rows of each matrix A.  M >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of each matrix A.  N >= 0.
+
+    @param[in,out]
+    dA      COMPLEX_16 array on the GPU, holding the batch of M-by-N
+            matrices, the i-th one at dA_offset + i*strideA.
+            On exit, the factors L and U of each matrix;
+            the unit diagonal elements of L are not stored.
+
+    @param[in]
+    dA_offset   Offset of the first matrix in dA.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of each matrix.  LDDA >= max(1,M).
+
+    @param[in]
+    strideA INTEGER
+            The distance between consecutive matrices in dA.
+            STRIDEA >= LDDA*N.
+
+    @param[out]
+    dipiv   INTEGER array on the GPU, dimension (min(M,N)*BATCHCOUNT).
+            The pivot indices of the i-th matrix are at
+            dipiv_offset + i*min(M,N); row k of that matrix was
+            interchanged with row IPIV(k), as in LAPACK.
+
+    @param[in]
+    dipiv_offset    Offset of the first pivot in dipiv.
+
+    @param[out]
+    dinfo   INTEGER array on the GPU, dimension (BATCHCOUNT).
+            dinfo[ dinfo_offset + i ] is the LAPACK info of the i-th matrix:
+      -     = 0:  successful exit
+      -     > 0:  if INFO = k, U(k,k) is exactly zero.
+
+    @param[in]
+    dinfo_offset    Offset of the first info in dinfo.
+
+    @param[in]
+    batchCount  INTEGER
+            The number of matrices.  BATCHCOUNT >= 0.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @return
+      -     = 0:  successful exit
+      -     < 0:  if -i, the i-th argument had an illegal value, or
+                  MAGMA_ERR_NOT_SUPPORTED if a column of A doesn't fit
+                  in local memory.
+
+    @ingroup magma_zgesv_comp
+*/
+extern "C" magma_int_t
+magma_zgetrf_batched(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t strideA,
+    magmaInt_ptr dipiv, size_t dipiv_offset,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if (m < 0)
+        info = -1;
+    else if (n < 0)
+        info = -2;
+    else if (ldda < max(1,m))
+        info = -5;
+    else if (strideA < ldda*n)
+        info = -6;
+    else if (batchCount < 0)
+        info = -11;
+
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
+
+    if (m == 0 || n == 0 || batchCount == 0)
+        return info;
+
+    return zgetrf_batched_launch(
+        m, n, dA, dA_offset, ldda, strideA, NULL, NULL, NULL, NULL,
+        dipiv, dipiv_offset, dinfo, dinfo_offset, batchCount, queue );
+}
+
+
+/**
+    Purpose
+    -------
+    ZGETRF_VBATCHED computes LU factorizations of a batch of general
+    matrices of variable sizes using partial pivoting with row
+    interchanges, A = P * L * U. See magma_zgetrf_batched.
+
+    Arguments
+    ---------
+    @param[in]
+    dm      INTEGER array on the GPU, dimension (BATCHCOUNT).
+            The number of rows of each matrix.  0 <= dm[i] <= MAX_M.
+
+    @param[in]
+    dn      INTEGER array on the GPU, dimension (BATCHCOUNT).
+            The number of columns of each matrix.  0 <= dn[i] <= MAX_N.
+
+    @param[in]
+    max_m   INTEGER
+            The largest number of rows in the batch.
+
+    @param[in]
+    max_n   INTEGER
+            The largest number of columns in the batch.
+
+    @param[in,out]
+    dA      COMPLEX_16 array on the GPU, holding the batch of matrices,
+            the i-th one at dA_offset + dA_offsets[i].
+            On exit, the factors L and U of each matrix;
+            the unit diagonal elements of L are not stored.
+
+    @param[in]
+    dA_offset   Offset added to each of dA_offsets.
+
+    @param[in]
+    dA_offsets  INTEGER array on the GPU, dimension (BATCHCOUNT).
+            The offset of each matrix in dA.
+
+    @param[in]
+    dldda   INTEGER array on the GPU, dimension (BATCHCOUNT).
+            The leading dimension of each matrix.  dldda[i] >= max(1,dm[i]).
+
+    @param[out]
+    dipiv   INTEGER array on the GPU, dimension (min(MAX_M,MAX_N)*BATCHCOUNT).
+            The pivot indices of the i-th matrix are at
+            dipiv_offset + i*min(MAX_M,MAX_N), as in LAPACK.
+
+    @param[in]
+    dipiv_offset    Offset of the first pivot in dipiv.
+
+    @param[out]
+    dinfo   INTEGER array on the GPU, dimension (BATCHCOUNT).
+            dinfo[ dinfo_offset + i ] is the LAPACK info of the i-th matrix.
+
+    @param[in]
+    dinfo_offset    Offset of the first info in dinfo.
+
+    @param[in]
+    batchCount  INTEGER
+            The number of matrices.  BATCHCOUNT >= 0.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @ingroup magma_zgesv_comp
+*/
+extern "C" magma_int_t
+magma_zgetrf_vbatched(
+    magmaInt_const_ptr dm, magmaInt_const_ptr dn,
+    magma_int_t max_m, magma_int_t max_n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset,
+    magmaInt_const_ptr dA_offsets, magmaInt_const_ptr dldda,
+    magmaInt_ptr dipiv, size_t dipiv_offset,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if (max_m < 0)
+        info = -3;
+    else if (max_n < 0)
+        info = -4;
+    else if (batchCount < 0)
+        info = -13;
+
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
+
+    if (max_m == 0 || max_n == 0 || batchCount == 0)
+        return info;
+
+    return zgetrf_batched_launch(
+        max_m, max_n, dA, dA_offset, max_m, 0, dm, dn, dldda, dA_offsets,
+        dipiv, dipiv_offset, dinfo, dinfo_offset, batchCount, queue );
+}
@@ -145,7 +145,7 @@ magmablas_zlacpy(
                         err |= clSetKernelArg( kernel, arg++, sizeof(lddb        ), &lddb        );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -166,7 +166,7 @@ magmablas_zlacpy(
                         err |= clSetKernelArg( kernel, arg++, sizeof(lddb        ), &lddb        );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -199,7 +199,7 @@ magmablas_zlacpy(
                         err |= clSetKernelArg( kernel, arg++, sizeof(lddb        ), &lddb        );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -220,7 +220,7 @@ magmablas_zlacpy(
                         err |= clSetKernelArg( kernel, arg++, sizeof(lddb        ), &lddb        );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -253,7 +253,7 @@ magmablas_zlacpy(
                     err |= clSetKernelArg( kernel, arg++, sizeof(lddb        ), &lddb        );
                     check_error( err );
 
-                    err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                    err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                     check_error( err );
                 }
             }
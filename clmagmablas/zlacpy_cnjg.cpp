@@ -45,7 +45,7 @@ magmablas_zlacpy_cnjg(
         err |= clSetKernelArg( kernel, arg++, sizeof(lda2      ), &lda2       );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, blocks, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, blocks, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
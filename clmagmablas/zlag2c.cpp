@@ -127,7 +127,7 @@ magmablas_zlag2c(
         err |= clSetKernelArg( kernel, arg++, sizeof(rmax     ), &rmax      );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
     
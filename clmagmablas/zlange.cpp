@@ -131,7 +131,7 @@ magmablas_zlange(
             err |= clSetKernelArg( kernel, arg++, sizeof(dwork_offset), &dwork_offset );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
         result = magmablas_dmax_nan( m, dwork, dwork_offset, queue );
@@ -153,7 +153,7 @@ magmablas_zlange(
             err |= clSetKernelArg( kernel, arg++, sizeof(dwork_offset), &dwork_offset );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
         result = magmablas_dmax_nan( m, dwork, dwork_offset, queue );
@@ -175,7 +175,7 @@ magmablas_zlange(
             err |= clSetKernelArg( kernel, arg++, sizeof(dwork_offset), &dwork_offset );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
         result = magmablas_dmax_nan( n, dwork, dwork_offset, queue );  // note N instead of M
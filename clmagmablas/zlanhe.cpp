@@ -55,7 +55,7 @@ zlanhe_inf(
             err |= clSetKernelArg( kernel, arg++, sizeof(n_mod_bs    ), &n_mod_bs     );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -74,7 +74,7 @@ zlanhe_inf(
             err |= clSetKernelArg( kernel, arg++, sizeof(n_mod_bs    ), &n_mod_bs     );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -113,7 +113,7 @@ zlanhe_max(
             err |= clSetKernelArg( kernel, arg++, sizeof(dwork_offset), &dwork_offset );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -130,7 +130,7 @@ zlanhe_max(
             err |= clSetKernelArg( kernel, arg++, sizeof(dwork_offset), &dwork_offset );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -68,7 +68,7 @@ magma_zlarfbx_gpu(int m, int k, magmaDoubleComplex_ptr V, size_t V_offset, int l
     //magma_zgemv_kernel1<<< k, BLOCK_SIZE, 0, magma_stream >>>(m, V, ldv, c, dwork); 
     
     // launch kernel magma_zgemv_kernel1
-    ciErrNum = clEnqueueNDRangeKernel(
+    ciErrNum = magma_enqueue_kernel(
         queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
     if (ciErrNum != CL_SUCCESS)
     {
@@ -110,7 +110,7 @@ magma_zlarfbx_gpu(int m, int k, magmaDoubleComplex_ptr V, size_t V_offset, int l
     //magma_ztrmv_tkernel<<< k, k, 0, magma_stream >>>( T, ldt, dwork, dwork+k);
     
     // launch kernel magma_ztrmv_tkernel
-    ciErrNum = clEnqueueNDRangeKernel(
+    ciErrNum = magma_enqueue_kernel(
         queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
     if (ciErrNum != CL_SUCCESS)
     {
@@ -153,7 +153,7 @@ magma_zlarfbx_gpu(int m, int k, magmaDoubleComplex_ptr V, size_t V_offset, int l
     // launch kernel magma_zgemv_kernel2
     /* c = c - V dwork                */
     //magma_zgemv_kernel2<<< blocks3, threads3, 0, magma_stream >>>( m, k, V, ldv, dwork+k, c);
-    ciErrNum = clEnqueueNDRangeKernel(
+    ciErrNum = magma_enqueue_kernel(
         queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
     if (ciErrNum != CL_SUCCESS)
     {
@@ -101,7 +101,7 @@ void magmablas_zlarfg(
         err |= clSetKernelArg( kernel, arg++, sizeof(dtau_offset  ), &dtau_offset   );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, blocks, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, blocks, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
@@ -76,7 +76,7 @@ magma_zlarfgx_gpu(
     GlobalWorkSize[0] = magma_ceildiv( n, BLOCK_SIZE )*LocalWorkSize[0];
     
     // launch kernel
-    ciErrNum = clEnqueueNDRangeKernel(
+    ciErrNum = magma_enqueue_kernel(
         queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
     if (ciErrNum != CL_SUCCESS) {
         printf("Error: clEnqueueNDRangeKernel at %d in file %s \"%s\"\n",
@@ -152,7 +152,7 @@ magma_zlarfgtx_gpu(
         GlobalWorkSize[0] = i*LocalWorkSize[0];
     
         // launch kernel
-        ciErrNum = clEnqueueNDRangeKernel(
+        ciErrNum = magma_enqueue_kernel(
             queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
         if (ciErrNum != CL_SUCCESS) {
             printf("Error: clEnqueueNDRangeKernel at %d in file %s \"%s\"\n",
@@ -192,7 +192,7 @@ magma_zlarfgtx_gpu(
         GlobalWorkSize[0] = i*LocalWorkSize[0];
     
         // launch kernel
-        ciErrNum = clEnqueueNDRangeKernel(
+        ciErrNum = magma_enqueue_kernel(
             queue, kernel, 1, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
         if (ciErrNum != CL_SUCCESS) {
             printf("Error: clEnqueueNDRangeKernel at %d in file %s \"%s\"\n",
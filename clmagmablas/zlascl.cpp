@@ -179,7 +179,7 @@ magmablas_zlascl(
                 err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
                 check_error( err );
 
-                err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                 check_error( err );
             }
         }
@@ -196,7 +196,7 @@ magmablas_zlascl(
                 err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
                 check_error( err );
 
-                err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                 check_error( err );
             }
         }
@@ -213,7 +213,7 @@ magmablas_zlascl(
                 err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
                 check_error( err );
 
-                err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                 check_error( err );
             }
         }
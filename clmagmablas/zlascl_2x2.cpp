@@ -105,7 +105,7 @@ magmablas_zlascl_2x2(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -123,7 +123,7 @@ magmablas_zlascl_2x2(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -111,7 +111,7 @@ magmablas_zlascl_diag(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -130,7 +130,7 @@ magmablas_zlascl_diag(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -142,7 +142,7 @@ void magmablas_zlaset(
                         err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -161,7 +161,7 @@ void magmablas_zlaset(
                         err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -192,7 +192,7 @@ void magmablas_zlaset(
                         err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -211,7 +211,7 @@ void magmablas_zlaset(
                         err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -242,7 +242,7 @@ void magmablas_zlaset(
                         err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -261,7 +261,7 @@ void magmablas_zlaset(
                         err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
                         check_error( err );
 
-                        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+                        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
                         check_error( err );
                     }
                 }
@@ -120,7 +120,7 @@ magmablas_zlaset_band(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -144,7 +144,7 @@ magmablas_zlaset_band(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -129,7 +129,7 @@ magmablas_zlaswp(
             err |= clSetKernelArg( kernel, arg++, sizeof(params         ), &params          );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -251,7 +251,7 @@ magmablas_zlaswpx(
             err |= clSetKernelArg( kernel, arg++, sizeof(params        ), &params         );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -363,7 +363,7 @@ magmablas_zlaswp2(
         err |= clSetKernelArg( kernel, arg++, sizeof(inci              ), &inci               );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
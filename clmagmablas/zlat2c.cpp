@@ -133,7 +133,7 @@ magmablas_zlat2c(
             err |= clSetKernelArg( kernel, arg++, sizeof(dflag    ), &dflag     );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -153,7 +153,7 @@ magmablas_zlat2c(
             err |= clSetKernelArg( kernel, arg++, sizeof(dflag    ), &dflag     );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
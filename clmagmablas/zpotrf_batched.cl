@@ -0,0 +1,143 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "kernels_header.h"
+#include "zpotrf_batched.h"
+
+// Matrix batchid of the batch. For fixed size, dn is NULL and matrices are
+// strideA apart; for variable size, dn, dldda, and dA_offsets give each
+// matrix's size and position, and strideA is 0.
+#define GET_MATRIX()                                       \
+    const int batchid = get_group_id(1);                   \
+    int lda = ldda;                                        \
+    dA += dA_offset + batchid*strideA;                     \
+    if ( dn != 0 ) {                                       \
+        n   = dn[ batchid ];                               \
+        lda = dldda[ batchid ];                            \
+        dA += dA_offsets[ batchid ];                       \
+    }                                                      \
+    dinfo += dinfo_offset + batchid;
+
+// Element (i,k), i >= k, of the lower triangle L, which for upper is
+// stored as L^H in the upper triangle of A.
+#define L( i_, k_ )  (upper ? MAGMA_Z_CNJG( dA[ (k_) + (i_)*lda ] ) : dA[ (i_) + (k_)*lda ])
+
+#define SET_L( i_, k_, x_ )                                \
+    if ( upper )                                           \
+        dA[ (k_) + (i_)*lda ] = MAGMA_Z_CNJG( x_ );        \
+    else                                                   \
+        dA[ (i_) + (k_)*lda ] = (x_);
+
+
+// ----------------------------------------
+/// Factors the panel A(j:n, j:j+jb) of each matrix, i.e., the diagonal
+/// block and the block column below it, keeping the panel in local memory
+/// sA. One block per matrix, with the batch along the second grid dimension.
+/// Sets info and stops if a leading minor is not positive definite.
+__kernel void
+zpotrf_batched_panel_kernel(
+    int upper, int n, int j, int nb,
+    __global magmaDoubleComplex* dA, unsigned long dA_offset, int ldda, unsigned long strideA,
+    __global const magma_int_t* dn,
+    __global const magma_int_t* dldda,
+    __global const magma_int_t* dA_offsets,
+    __global magma_int_t* dinfo, unsigned long dinfo_offset,
+    __local magmaDoubleComplex* sA )
+{
+    GET_MATRIX();
+
+    const int tx = get_local_id(0);
+    if ( j >= n || (j > 0 && *dinfo != 0) ) {
+        if ( j == 0 && tx == 0 ) {
+            *dinfo = 0;  // empty matrix
+        }
+        return;
+    }
+    const int jb   = min( nb, n - j );
+    const int rows = n - j;  // also leading dimension of sA
+
+    for( int c = 0; c < jb; ++c ) {
+        for( int i = c + tx; i < rows; i += NTX ) {
+            sA[ i + c*rows ] = L( j+i, j+c );
+        }
+    }
+
+    int info = 0;
+    for( int k = 0; k < jb; ++k ) {
+        barrier( CLK_LOCAL_MEM_FENCE );
+        double d = MAGMA_Z_REAL( sA[ k + k*rows ] );
+        if ( ! (d > 0) ) {
+            // not positive definite, or NaN
+            info = j + k + 1;
+            break;
+        }
+        d = sqrt( d );
+        barrier( CLK_LOCAL_MEM_FENCE );
+
+        // scale column k; each thread owns its rows
+        for( int i = k + tx; i < rows; i += NTX ) {
+            if ( i == k )
+                sA[ i + k*rows ] = MAGMA_Z_MAKE( d, 0 );
+            else
+                sA[ i + k*rows ] = MAGMA_Z_MUL( sA[ i + k*rows ], MAGMA_Z_MAKE( 1/d, 0 ));
+        }
+        barrier( CLK_LOCAL_MEM_FENCE );
+
+        // update the lower triangle of the rest of the panel
+        for( int i = k + 1 + tx; i < rows; i += NTX ) {
+            magmaDoubleComplex l = sA[ i + k*rows ];
+            for( int c = k+1; c < jb && c <= i; ++c ) {
+                sA[ i + c*rows ] = MAGMA_Z_SUB( sA[ i + c*rows ],
+                                                MAGMA_Z_MUL( l, MAGMA_Z_CNJG( sA[ c + k*rows ] )));
+            }
+        }
+    }
+    barrier( CLK_LOCAL_MEM_FENCE );
+
+    for( int c = 0; c < jb; ++c ) {
+        for( int i = c + tx; i < rows; i += NTX ) {
+            SET_L( j+i, j+c, sA[ i + c*rows ] );
+        }
+    }
+    if ( tx == 0 ) {
+        *dinfo = info;
+    }
+}
+
+
+// ----------------------------------------
+/// Updates the lower triangle of the trailing matrix,
+/// A(c:n, c) -= L(c:n, j:j+jb) L(c, j:j+jb)^H, for columns c >= j+jb.
+/// Each thread does one column c; the batch is along the second grid dimension.
+__kernel void
+zpotrf_batched_update_kernel(
+    int upper, int n, int j, int nb,
+    __global magmaDoubleComplex* dA, unsigned long dA_offset, int ldda, unsigned long strideA,
+    __global const magma_int_t* dn,
+    __global const magma_int_t* dldda,
+    __global const magma_int_t* dA_offsets,
+    __global magma_int_t* dinfo, unsigned long dinfo_offset )
+{
+    GET_MATRIX();
+
+    const int c = get_global_id(0);
+    if ( j >= n || c >= n || *dinfo != 0 )
+        return;
+    const int jb = min( nb, n - j );
+    if ( c < j + jb )
+        return;
+
+    for( int i = c; i < n; ++i ) {
+        magmaDoubleComplex s = L( i, c );
+        for( int k = j; k < j + jb; ++k ) {
+            s = MAGMA_Z_SUB( s, MAGMA_Z_MUL( L( i, k ), MAGMA_Z_CNJG( L( c, k ))));
+        }
+        SET_L( i, c, s );
+    }
+}
@@ -0,0 +1,296 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "clmagma_runtime.h"
+#include "common_magma.h"
+#include "zpotrf_batched.h"
+
+
+// ----------------------------------------
+// Sets the arguments shared by the panel and update kernels.
+static cl_int
+zpotrf_batched_setargs(
+    cl_kernel kernel, int upper, int n, int j, int nb,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, int ldda, size_t strideA,
+    magmaInt_const_ptr dn, magmaInt_const_ptr dldda, magmaInt_const_ptr dA_offsets,
+    magmaInt_ptr dinfo, size_t dinfo_offset )
+{
+    cl_int err = 0;
+    int arg = 0;
+    err |= clSetKernelArg( kernel, arg++, sizeof(upper       ), &upper        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(n           ), &n            );
+    err |= clSetKernelArg( kernel, arg++, sizeof(j           ), &j            );
+    err |= clSetKernelArg( kernel, arg++, sizeof(nb          ), &nb           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dA          ), &dA           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dA_offset   ), &dA_offset    );
+    err |= clSetKernelArg( kernel, arg++, sizeof(ldda        ), &ldda         );
+    err |= clSetKernelArg( kernel, arg++, sizeof(strideA     ), &strideA      );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dn          ), &dn           );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dldda       ), &dldda        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dA_offsets  ), &dA_offsets   );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dinfo       ), &dinfo        );
+    err |= clSetKernelArg( kernel, arg++, sizeof(dinfo_offset), &dinfo_offset );
+    return err;
+}
+
+
+// ----------------------------------------
+// Factors the batch by panels of nb columns, where nb is as wide as local
+// memory allows for n rows, so small matrices take a single panel launch.
+// Each step is one panel launch and one update launch over the whole batch.
+// For fixed size, dn, dldda, and dA_offsets are NULL; for variable size,
+// n is the max size and strideA is 0.
+static magma_int_t
+zpotrf_batched_launch(
+    magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t strideA,
+    magmaInt_const_ptr dn, magmaInt_const_ptr dldda, magmaInt_const_ptr dA_offsets,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue )
+{
+    cl_kernel panel_kernel, update_kernel;
+    cl_int err;
+
+    size_t lmem = magma_queue_local_meminfo( queue );
+    magma_int_t nb = lmem / (n*sizeof(magmaDoubleComplex));
+    nb = min( nb, n );
+    if ( nb < 1 ) {
+        // a column doesn't fit in local memory
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    panel_kernel  = g_runtime.get_kernel( "zpotrf_batched_panel_kernel"  );
+    update_kernel = g_runtime.get_kernel( "zpotrf_batched_update_kernel" );
+    if ( panel_kernel == NULL || update_kernel == NULL ) {
+        return MAGMA_ERR_NOT_FOUND;
+    }
+
+    int upper = (uplo == MagmaUpper);
+    size_t panel_threads[2]  = { NTX, 1 };
+    size_t panel_grid[2]     = { NTX, (size_t) batchCount };
+    size_t update_threads[2] = { NTX, 1 };
+    size_t update_grid[2]    = { (size_t) magma_roundup( n, NTX ), (size_t) batchCount };
+    size_t panel_bytes       = n*nb*sizeof(magmaDoubleComplex);
+
+    for( magma_int_t j = 0; j < n; j += nb ) {
+        err = zpotrf_batched_setargs(
+            panel_kernel, upper, n, j, nb, dA, dA_offset, ldda, strideA,
+            dn, dldda, dA_offsets, dinfo, dinfo_offset );
+        err |= clSetKernelArg( panel_kernel, 13, panel_bytes, NULL );
+        check_error( err );
+        err = magma_enqueue_kernel( queue, panel_kernel, 2, NULL,
+                                    panel_grid, panel_threads, 0, NULL, NULL );
+        check_error( err );
+        if ( err != CL_SUCCESS ) {
+            return err;
+        }
+
+        if ( j + nb < n ) {
+            err = zpotrf_batched_setargs(
+                update_kernel, upper, n, j, nb, dA, dA_offset, ldda, strideA,
+                dn, dldda, dA_offsets, dinfo, dinfo_offset );
+            check_error( err );
+            err = magma_enqueue_kernel( queue, update_kernel, 2, NULL,
+                                        update_grid, update_threads, 0, NULL, NULL );
+            check_error( err );
+            if ( err != CL_SUCCESS ) {
+                return err;
+            }
+        }
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+    ZPOTRF_BATCHED computes Cholesky factorizations of a batch of Hermitian
+    positive definite N-by-N matrices,
+        A = U**H * U,  if UPLO = MagmaUpper, or
+        A = L  * L**H, if UPLO = MagmaLower.
+
+    This is meant for many small matrices, e.g., 32x32 or 64x64. Each
+    matrix is factored by one block of threads, in local memory, so the
+    whole batch takes one kernel launch if a matrix fits in local memory;
+    otherwise, matrices are factored by panels as wide as fit, with one
+    panel and one update launch per panel over the whole batch.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+      -     = MagmaUpper:  Upper triangle of A is stored;
+      -     = MagmaLower:  Lower triangle of A is stored.
+
+    @param[in]
+    n       INTEGER
+            The order of each matrix A.  N >= 0.
+
+    @param[in,out]
+    dA      COMPLEX_16 array on the GPU, holding the batch of N-by-N
+            matrices, the i-th one at dA_offset + i*strideA.
+            On exit, if INFO = 0, the factor U or L of each matrix.
+
+    @param[in]
+    dA_offset   Offset of the first matrix in dA.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of each matrix.  LDDA >= max(1,N).
+
+    @param[in]
+    strideA INTEGER
+            The distance between consecutive matrices in dA.
+            STRIDEA >= LDDA*N.
+
+    @param[out]
+    dinfo   INTEGER array on the GPU, dimension (BATCHCOUNT).
+            dinfo[ dinfo_offset + i ] is the LAPACK info of the i-th matrix:
+      -     = 0:  successful exit
+      -     > 0:  if INFO = k, the leading minor of order k is not
+                  positive definite, and the factorization could not be
+                  completed.
+
+    @param[in]
+    dinfo_offset    Offset of the first info in dinfo.
+
+    @param[in]
+    batchCount  INTEGER
+            The number of matrices.  BATCHCOUNT >= 0.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @return
+      -     = 0:  successful exit
+      -     < 0:  if -i, the i-th argument had an illegal value, or
+                  MAGMA_ERR_NOT_SUPPORTED if a column of A doesn't fit
+                  in local memory.
+
+    @ingroup magma_zposv_comp
+*/
+extern "C" magma_int_t
+magma_zpotrf_batched(
+    magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t strideA,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if (uplo != MagmaUpper && uplo != MagmaLower)
+        info = -1;
+    else if (n < 0)
+        info = -2;
+    else if (ldda < max(1,n))
+        info = -5;
+    else if (strideA < ldda*n)
+        info = -6;
+    else if (batchCount < 0)
+        info = -9;
+
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
+
+    if (n == 0 || batchCount == 0)
+        return info;
+
+    return zpotrf_batched_launch(
+        uplo, n, dA, dA_offset, ldda, strideA, NULL, NULL, NULL,
+        dinfo, dinfo_offset, batchCount, queue );
+}
+
+
+/**
+    Purpose
+    -------
+    ZPOTRF_VBATCHED computes Cholesky factorizations of a batch of
+    Hermitian positive definite matrices of variable sizes.
+    See magma_zpotrf_batched.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+      -     = MagmaUpper:  Upper triangle of A is stored;
+      -     = MagmaLower:  Lower triangle of A is stored.
+
+    @param[in]
+    dn      INTEGER array on the GPU, dimension (BATCHCOUNT).
+            The order of each matrix.  0 <= dn[i] <= MAX_N.
+
+    @param[in]
+    max_n   INTEGER
+            The largest order in the batch.
+
+    @param[in,out]
+    dA      COMPLEX_16 array on the GPU, holding the batch of matrices,
+            the i-th one at dA_offset + dA_offsets[i].
+            On exit, if INFO = 0, the factor U or L of each matrix.
+
+    @param[in]
+    dA_offset   Offset added to each of dA_offsets.
+
+    @param[in]
+    dA_offsets  INTEGER array on the GPU, dimension (BATCHCOUNT).
+            The offset of each matrix in dA.
+
+    @param[in]
+    dldda   INTEGER array on the GPU, dimension (BATCHCOUNT).
+            The leading dimension of each matrix.  dldda[i] >= max(1,dn[i]).
+
+    @param[out]
+    dinfo   INTEGER array on the GPU, dimension (BATCHCOUNT).
+            dinfo[ dinfo_offset + i ] is the LAPACK info of the i-th matrix.
+
+    @param[in]
+    dinfo_offset    Offset of the first info in dinfo.
+
+    @param[in]
+    batchCount  INTEGER
+            The number of matrices.  BATCHCOUNT >= 0.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @ingroup magma_zposv_comp
+*/
+extern "C" magma_int_t
+magma_zpotrf_vbatched(
+    magma_uplo_t uplo,
+    magmaInt_const_ptr dn, magma_int_t max_n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset,
+    magmaInt_const_ptr dA_offsets, magmaInt_const_ptr dldda,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    if (uplo != MagmaUpper && uplo != MagmaLower)
+        info = -1;
+    else if (max_n < 0)
+        info = -3;
+    else if (batchCount < 0)
+        info = -10;
+
+    if (info != 0) {
+        magma_xerbla( __func__, -(info) );
+        return info;
+    }
+
+    if (max_n == 0 || batchCount == 0)
+        return info;
+
+    return zpotrf_batched_launch(
+        uplo, max_n, dA, dA_offset, max_n, 0, dn, dldda, dA_offsets,
+        dinfo, dinfo_offset, batchCount, queue );
+}
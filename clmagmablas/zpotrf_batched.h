@@ -0,0 +1,18 @@
+#ifndef MAGMA_ZPOTRF_BATCHED_H
+#define MAGMA_ZPOTRF_BATCHED_H
+
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+// NTX is number of threads in a block, a power of 2.
+// Each block factors one matrix of the batch.
+#define NTX 64
+
+#endif // MAGMA_ZPOTRF_BATCHED_H
@@ -75,7 +75,7 @@ magmablas_zswap(
         err |= clSetKernelArg( kernel, arg++, sizeof(incy     ), &incy      );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
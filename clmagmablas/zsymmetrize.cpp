@@ -93,7 +93,7 @@ magmablas_zsymmetrize(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -108,7 +108,7 @@ magmablas_zsymmetrize(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -124,7 +124,7 @@ magmablas_zsymmetrize_tiles(
             err |= clSetKernelArg( kernel, arg++, sizeof(nstride  ), &nstride   );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -141,7 +141,7 @@ magmablas_zsymmetrize_tiles(
             err |= clSetKernelArg( kernel, arg++, sizeof(nstride  ), &nstride   );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -109,7 +109,7 @@ magmablas_ztranspose(
         err |= clSetKernelArg( kernel, arg++, sizeof(lddat     ), &lddat      );
         check_error( err );
 
-        err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+        err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
         check_error( err );
     }
 }
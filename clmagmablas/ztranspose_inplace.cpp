@@ -90,7 +90,7 @@ magmablas_ztranspose_inplace(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
@@ -110,7 +110,7 @@ magmablas_ztranspose_inplace(
             err |= clSetKernelArg( kernel, arg++, sizeof(ldda     ), &ldda      );
             check_error( err );
 
-            err = clEnqueueNDRangeKernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
+            err = magma_enqueue_kernel( queue, kernel, ndim, NULL, grid, threads, 0, NULL, NULL );
             check_error( err );
         }
     }
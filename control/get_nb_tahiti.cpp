@@ -18,30 +18,43 @@ extern "C" {
 #endif
 
 // ==== Definition of blocking sizes for AMD Tahiti cards
+// If the calling thread's device has an nb profile (see testing_ztune_nb
+// and magma_nb_profile_set_device), its tuned nb takes precedence for the
+// sizes it covers; these tables are the fallback.
 #ifdef HAVE_clBLAS
 
+#define NB_PROFILE( routine, m )                              \
+    do {                                                      \
+        magma_int_t nb_ = magma_nb_profile_get( routine, m ); \
+        if ( nb_ > 0 ) return nb_;                            \
+    } while(0)
+
 /* ////////////////////////////////////////////////////////////////////////////
    -- Return nb for potrf based on m
 */
 magma_int_t magma_get_spotrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "spotrf", m );
     if      (m <= 1024) return 128;
     else                return 320;
 }
 
 magma_int_t magma_get_dpotrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "dpotrf", m );
     if      (m <= 4256) return 128;
     else                return 256;
 }
 
 magma_int_t magma_get_cpotrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "cpotrf", m );
     return 128;
 }
 
 magma_int_t magma_get_zpotrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "zpotrf", m );
     return 64;
 }
 
@@ -50,21 +63,25 @@ magma_int_t magma_get_zpotrf_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgeqp3_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgeqp3", m );
     return 32;
 }
 
 magma_int_t magma_get_dgeqp3_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgeqp3", m );
     return 32;
 }
 
 magma_int_t magma_get_cgeqp3_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgeqp3", m );
     return 32;
 }
 
 magma_int_t magma_get_zgeqp3_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgeqp3", m );
     return 32;
 }
 
@@ -73,18 +90,21 @@ magma_int_t magma_get_zgeqp3_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgeqrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgeqrf", m );
     if      (m <  2000) return 128;
     else                return 128;
 }
 
 magma_int_t magma_get_dgeqrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgeqrf", m );
     if      (m <= 2048) return 64;
     else                return 128;
 }
 
 magma_int_t magma_get_cgeqrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgeqrf", m );
     if      (m <= 2048) return 32;
     else if (m <= 4032) return 64;
     else                return 128;
@@ -92,6 +112,7 @@ magma_int_t magma_get_cgeqrf_nb( magma_int_t m )
 
 magma_int_t magma_get_zgeqrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgeqrf", m );
     if      (m <= 2048) return 32;
     else if (m <= 4032) return 64;
     else                return 128;
@@ -102,16 +123,19 @@ magma_int_t magma_get_zgeqrf_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgeqlf_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgeqlf", m );
     return magma_get_sgeqrf_nb(m);
 }
 
 magma_int_t magma_get_dgeqlf_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgeqlf", m );
     return magma_get_dgeqrf_nb(m);
 }
 
 magma_int_t magma_get_cgeqlf_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgeqlf", m );
     if      (m <= 2048) return 32;
     else if (m <= 4032) return 64;
     else                return 128;
@@ -119,6 +143,7 @@ magma_int_t magma_get_cgeqlf_nb( magma_int_t m )
 
 magma_int_t magma_get_zgeqlf_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgeqlf", m );
     if      (m <= 1024) return 64;
     else                return 128;
 }
@@ -128,16 +153,19 @@ magma_int_t magma_get_zgeqlf_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgelqf_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgelqf", m );
     return magma_get_sgeqrf_nb(m);
 }
 
 magma_int_t magma_get_dgelqf_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgelqf", m );
     return magma_get_dgeqrf_nb(m);
 }
 
 magma_int_t magma_get_cgelqf_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgelqf", m );
     if      (m <= 2048) return 32;
     else if (m <= 4032) return 64;
     else                return 128;
@@ -145,6 +173,7 @@ magma_int_t magma_get_cgelqf_nb( magma_int_t m )
 
 magma_int_t magma_get_zgelqf_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgelqf", m );
     if      (m <= 1024) return 64;
     else                return 128;
 }
@@ -154,6 +183,7 @@ magma_int_t magma_get_zgelqf_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgetrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgetrf", m );
     if      (m <= 3200) return 128;
     else if (m <  9000) return 256;
     else                return 320;
@@ -161,6 +191,7 @@ magma_int_t magma_get_sgetrf_nb( magma_int_t m )
 
 magma_int_t magma_get_dgetrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgetrf", m );
     if      (m <= 2048) return 64;
     else if (m <  7200) return 192;
     else                return 256;
@@ -168,40 +199,77 @@ magma_int_t magma_get_dgetrf_nb( magma_int_t m )
 
 magma_int_t magma_get_cgetrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgetrf", m );
     if      (m <= 2048) return 64;
     else                return 128;
 }
 
 magma_int_t magma_get_zgetrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgetrf", m );
     if      (m <= 3072) return 32;
     else if (m <= 9024) return 64;
     else                return 128;
 }
 
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Return look-ahead depth for getrf based on m and n
+*/
+magma_int_t magma_get_sgetrf_lookahead( magma_int_t m, magma_int_t n )
+{
+    if      (n <= 4096)  return 1;
+    else if (n <= 12288) return 2;
+    else                 return 3;
+}
+
+magma_int_t magma_get_dgetrf_lookahead( magma_int_t m, magma_int_t n )
+{
+    if      (n <= 4096)  return 1;
+    else if (n <= 12288) return 2;
+    else                 return 3;
+}
+
+magma_int_t magma_get_cgetrf_lookahead( magma_int_t m, magma_int_t n )
+{
+    if      (n <= 3072)  return 1;
+    else if (n <= 9216)  return 2;
+    else                 return 3;
+}
+
+magma_int_t magma_get_zgetrf_lookahead( magma_int_t m, magma_int_t n )
+{
+    if      (n <= 3072)  return 1;
+    else if (n <= 9216)  return 2;
+    else                 return 3;
+}
+
 /* ////////////////////////////////////////////////////////////////////////////
    -- Return nb for gehrd based on m
 */
 magma_int_t magma_get_sgehrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgehrd", m );
     if      (m <= 1024) return 32;
     else                return 96;
 }
 
 magma_int_t magma_get_dgehrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgehrd", m );
     if      (m <= 2048) return 32;
     else                return 64;
 }
 
 magma_int_t magma_get_cgehrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgehrd", m );
     if      (m <= 1024) return 32;
     else                return 64;
 }
 
 magma_int_t magma_get_zgehrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgehrd", m );
     if      (m <= 2048) return 32;
     else                return 64;
 }
@@ -211,65 +279,108 @@ magma_int_t magma_get_zgehrd_nb( magma_int_t m )
 */
 magma_int_t magma_get_ssytrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "ssytrd", m );
     return 32;
 }
 
 magma_int_t magma_get_dsytrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "dsytrd", m );
     return 32;
 }
 
 magma_int_t magma_get_chetrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "chetrd", m );
     return 32;
 }
 
 magma_int_t magma_get_zhetrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "zhetrd", m );
     return 32;
 }
 
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Return bandwidth for the two-stage tridiagonal reduction based on m
+  */
+magma_int_t magma_get_sbulge_nb( magma_int_t m, magma_int_t nbthreads )
+{
+    NB_PROFILE( "sbulge", m );
+    if      (m < 4000) return 32;
+    else               return 64;
+}
+
+magma_int_t magma_get_dbulge_nb( magma_int_t m, magma_int_t nbthreads )
+{
+    NB_PROFILE( "dbulge", m );
+    if      (m < 4000) return 32;
+    else               return 64;
+}
+
+magma_int_t magma_get_cbulge_nb( magma_int_t m, magma_int_t nbthreads )
+{
+    NB_PROFILE( "cbulge", m );
+    if      (m < 4000) return 32;
+    else               return 64;
+}
+
+magma_int_t magma_get_zbulge_nb( magma_int_t m, magma_int_t nbthreads )
+{
+    NB_PROFILE( "zbulge", m );
+    if      (m < 4000) return 32;
+    else               return 64;
+}
+
 /* ////////////////////////////////////////////////////////////////////////////
    -- Return nb for sytrf based on m
   */
 magma_int_t magma_get_zhetrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "zhetrf", m );
     return 256;
 }
 
 magma_int_t magma_get_chetrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "chetrf", m );
     return 256;
 }
 
 magma_int_t magma_get_dsytrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "dsytrf", m );
     return 96;
 }
 
 magma_int_t magma_get_ssytrf_nb( magma_int_t m )
 {
+    NB_PROFILE( "ssytrf", m );
     return 256;
 }
 
 /* //////////////////////////////////////////////////////////////////////// */
 magma_int_t magma_get_zhetrf_nopiv_nb( magma_int_t m )
 {
+    NB_PROFILE( "zhetrf_nopiv", m );
     return 256;
 }
 
 magma_int_t magma_get_chetrf_nopiv_nb( magma_int_t m )
 {
+    NB_PROFILE( "chetrf_nopiv", m );
     return 256;
 }
 
 magma_int_t magma_get_dsytrf_nopiv_nb( magma_int_t m )
 {
+    NB_PROFILE( "dsytrf_nopiv", m );
     return 128;
 }
 
 magma_int_t magma_get_ssytrf_nopiv_nb( magma_int_t m )
 {
+    NB_PROFILE( "ssytrf_nopiv", m );
     return 256;
 }
 
@@ -278,21 +389,25 @@ magma_int_t magma_get_ssytrf_nopiv_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgebrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgebrd", m );
     return 32;
 }
 
 magma_int_t magma_get_dgebrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgebrd", m );
     return 32;
 }
 
 magma_int_t magma_get_cgebrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgebrd", m );
     return 32;
 }
 
 magma_int_t magma_get_zgebrd_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgebrd", m );
     return 32;
 }
 
@@ -301,21 +416,25 @@ magma_int_t magma_get_zgebrd_nb( magma_int_t m )
 */
 magma_int_t magma_get_ssygst_nb( magma_int_t m )
 {
+    NB_PROFILE( "ssygst", m );
     return 64;
 }
 
 magma_int_t magma_get_dsygst_nb( magma_int_t m )
 {
+    NB_PROFILE( "dsygst", m );
     return 64;
 }
 
 magma_int_t magma_get_chegst_nb( magma_int_t m )
 {
+    NB_PROFILE( "chegst", m );
     return 64;
 }
 
 magma_int_t magma_get_zhegst_nb( magma_int_t m )
 {
+    NB_PROFILE( "zhegst", m );
     return 64;
 }
 
@@ -324,21 +443,25 @@ magma_int_t magma_get_zhegst_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgetri_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgetri", m );
     return 64;
 }
 
 magma_int_t magma_get_dgetri_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgetri", m );
     return 64;
 }
 
 magma_int_t magma_get_cgetri_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgetri", m );
     return 64;
 }
 
 magma_int_t magma_get_zgetri_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgetri", m );
     return 64;
 }
 
@@ -347,21 +470,25 @@ magma_int_t magma_get_zgetri_nb( magma_int_t m )
 */
 magma_int_t magma_get_sgesvd_nb( magma_int_t m )
 {
+    NB_PROFILE( "sgesvd", m );
     return magma_get_sgebrd_nb(m);
 }
 
 magma_int_t magma_get_dgesvd_nb( magma_int_t m )
 {
+    NB_PROFILE( "dgesvd", m );
     return magma_get_dgebrd_nb(m);
 }
 
 magma_int_t magma_get_cgesvd_nb( magma_int_t m )
 {
+    NB_PROFILE( "cgesvd", m );
     return magma_get_cgebrd_nb(m);
 }
 
 magma_int_t magma_get_zgesvd_nb( magma_int_t m )
 {
+    NB_PROFILE( "zgesvd", m );
     return magma_get_zgebrd_nb(m);
 }
 
@@ -0,0 +1,492 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <map>
+
+#include "magma_stats.h"
+
+
+// ----------------------------------------
+// number of queues whose counters each thread caches; routines that
+// alternate between a few queues, e.g., with look-ahead, hit the cache
+#define MAGMA_STATS_QUEUE_CACHE 8
+
+// State of one thread: its innermost routine, and the counters of the
+// queues it used last, replaced round-robin; valid while generation
+// matches g_stats_generation.
+struct magma_stats_thread
+{
+    magma_stats_counters* routine;
+    magma_queue_t         queues[ MAGMA_STATS_QUEUE_CACHE ];
+    magma_stats_counters* queue_counters[ MAGMA_STATS_QUEUE_CACHE ];
+    int                   next;
+    long                  generation;
+};
+
+// Counters a kernel's completion callback adds its time to.
+struct magma_stats_kernel
+{
+    magma_stats_counters* routine;
+    magma_stats_counters* queue;
+};
+
+
+// ----------------------------------------
+// globals
+bool g_stats_kernel_time = false;
+
+// Counters are never freed, as call sites and callbacks keep pointers to them.
+// Lists are in order of registration; the mutex guards the lists and map.
+static pthread_mutex_t        g_stats_mutex    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t          g_stats_key;
+static pthread_once_t         g_stats_key_once = PTHREAD_ONCE_INIT;
+static magma_stats_counters*  g_stats_routines = NULL;
+static magma_stats_counters** g_stats_routines_tail = &g_stats_routines;
+static magma_stats_counters*  g_stats_queues   = NULL;
+static magma_stats_counters** g_stats_queues_tail = &g_stats_queues;
+static int                    g_stats_nqueues  = 0;
+static std::map< magma_queue_t, magma_stats_counters* > g_stats_queue_map;
+static volatile long          g_stats_generation = 0;
+
+// work outside any MAGMA_STATS_ROUTINE, such as the user's own transfers
+static magma_stats_counters*  g_stats_outside  = magma_stats_routine( "(outside routines)" );
+
+
+// ----------------------------------------
+static void magma_stats_create_key()
+{
+    pthread_key_create( &g_stats_key, free );
+}
+
+
+// ----------------------------------------
+// Returns calling thread's state, creating it on first use, or NULL if out of memory.
+static magma_stats_thread* magma_stats_get_thread()
+{
+    pthread_once( &g_stats_key_once, magma_stats_create_key );
+    magma_stats_thread* ts = (magma_stats_thread*) pthread_getspecific( g_stats_key );
+    if ( ts == NULL ) {
+        ts = (magma_stats_thread*) calloc( 1, sizeof(magma_stats_thread) );
+        if ( ts == NULL ) {
+            return NULL;
+        }
+        ts->generation = -1;
+        pthread_setspecific( g_stats_key, ts );
+    }
+    return ts;
+}
+
+
+// ----------------------------------------
+// Returns counters to charge the calling thread's work to.
+static magma_stats_counters* magma_stats_current( magma_stats_thread* ts )
+{
+    if ( ts == NULL || ts->routine == NULL )
+        return g_stats_outside;
+    return ts->routine;
+}
+
+
+// ----------------------------------------
+// Returns counters of queue, registering it on first use.
+// Only queues missing from the thread's cache take the lock.
+static magma_stats_counters* magma_stats_queue( magma_stats_thread* ts, magma_queue_t queue )
+{
+    if ( ts != NULL && ts->generation == g_stats_generation ) {
+        for( int i = 0; i < MAGMA_STATS_QUEUE_CACHE; ++i ) {
+            if ( ts->queues[i] == queue && ts->queue_counters[i] != NULL )
+                return ts->queue_counters[i];
+        }
+    }
+
+    pthread_mutex_lock( &g_stats_mutex );
+    magma_stats_counters* qc = NULL;
+    std::map< magma_queue_t, magma_stats_counters* >::const_iterator q
+        = g_stats_queue_map.find( queue );
+    if ( q != g_stats_queue_map.end() ) {
+        qc = q->second;
+    }
+    else {
+        qc = (magma_stats_counters*) calloc( 1, sizeof(magma_stats_counters) );
+        if ( qc != NULL ) {
+            cl_device_id device = NULL;
+            char name[ 64 ] = "unknown";
+            clGetCommandQueueInfo( queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL );
+            if ( device == NULL ||
+                 clGetDeviceInfo( device, CL_DEVICE_NAME, sizeof(name), name, NULL ) != CL_SUCCESS ) {
+                strcpy( name, "unknown" );
+            }
+            name[ sizeof(name)-1 ] = '\0';
+            snprintf( qc->name, sizeof(qc->name), "queue %d: %s", g_stats_nqueues, name );
+            g_stats_nqueues += 1;
+            *g_stats_queues_tail = qc;
+            g_stats_queues_tail  = &qc->next;
+            g_stats_queue_map[ queue ] = qc;
+        }
+    }
+    if ( ts != NULL && qc != NULL ) {
+        if ( ts->generation != g_stats_generation ) {
+            memset( ts->queues,         0, sizeof(ts->queues)         );
+            memset( ts->queue_counters, 0, sizeof(ts->queue_counters) );
+            ts->next       = 0;
+            ts->generation = g_stats_generation;
+        }
+        ts->queues        [ ts->next ] = queue;
+        ts->queue_counters[ ts->next ] = qc;
+        ts->next = (ts->next + 1) % MAGMA_STATS_QUEUE_CACHE;
+    }
+    pthread_mutex_unlock( &g_stats_mutex );
+    return qc;
+}
+
+
+// ----------------------------------------
+static void add( volatile long long* counter, long long value )
+{
+    __sync_fetch_and_add( counter, value );
+}
+
+
+// ----------------------------------------
+// Completion callback of a kernel's event; adds its profiled run time.
+static void CL_CALLBACK magma_stats_kernel_done( cl_event event, cl_int status, void* data )
+{
+    magma_stats_kernel* k = (magma_stats_kernel*) data;
+    cl_ulong start = 0, end = 0;
+    if ( status == CL_COMPLETE
+         && clGetEventProfilingInfo( event, CL_PROFILING_COMMAND_START,
+                                     sizeof(start), &start, NULL ) == CL_SUCCESS
+         && clGetEventProfilingInfo( event, CL_PROFILING_COMMAND_END,
+                                     sizeof(end), &end, NULL ) == CL_SUCCESS
+         && end > start ) {
+        add( &k->routine->kernel_ns, end - start );
+        if ( k->queue != NULL ) {
+            add( &k->queue->kernel_ns, end - start );
+        }
+    }
+    free( k );
+}
+
+
+// ----------------------------------------
+// Enables kernel timing if $MAGMA_STATS_KERNEL_TIME is nonzero or $MAGMA_TRACE
+// is set. Called by magma_init, before trace_startup.
+void magma_stats_startup()
+{
+    const char* timing = getenv( "MAGMA_STATS_KERNEL_TIME" );
+    const char* trace  = getenv( "MAGMA_TRACE" );
+    g_stats_kernel_time = ((timing != NULL && atoi( timing ) != 0) ||
+                           (trace  != NULL && trace[0] != '\0'));
+}
+
+
+// ----------------------------------------
+// Writes the counters to $MAGMA_STATS, if set, and forgets the queues,
+// which are about to be released. Called by magma_finalize.
+void magma_stats_shutdown()
+{
+    const char* filename = getenv( "MAGMA_STATS" );
+    if ( filename != NULL && filename[0] != '\0' ) {
+        magma_stats_print_json( filename );
+    }
+
+    pthread_mutex_lock( &g_stats_mutex );
+    g_stats_queue_map.clear();
+    g_stats_generation += 1;
+    pthread_mutex_unlock( &g_stats_mutex );
+    g_stats_kernel_time = false;
+}
+
+
+// ----------------------------------------
+// Returns the counters of routine name, registering it on first use.
+// MAGMA_STATS_ROUTINE caches the result, so this is called once per call site.
+magma_stats_counters* magma_stats_routine( const char* name )
+{
+    pthread_mutex_lock( &g_stats_mutex );
+    magma_stats_counters* rc = g_stats_routines;
+    while( rc != NULL && strcmp( rc->name, name ) != 0 ) {
+        rc = rc->next;
+    }
+    if ( rc == NULL ) {
+        rc = (magma_stats_counters*) calloc( 1, sizeof(magma_stats_counters) );
+        if ( rc != NULL ) {
+            magma_strlcpy( rc->name, name, sizeof(rc->name) );
+            *g_stats_routines_tail = rc;
+            g_stats_routines_tail  = &rc->next;
+        }
+    }
+    pthread_mutex_unlock( &g_stats_mutex );
+    return rc;
+}
+
+
+// ----------------------------------------
+// Counts a call of routine and charges the calling thread's work to it,
+// returning the routine to restore with magma_stats_leave.
+magma_stats_counters* magma_stats_enter( magma_stats_counters* routine )
+{
+    magma_stats_thread* ts = magma_stats_get_thread();
+    if ( ts == NULL )
+        return NULL;
+    if ( routine == NULL )
+        return ts->routine;
+
+    add( &routine->calls, 1 );
+    magma_stats_counters* previous = ts->routine;
+    ts->routine = routine;
+    return previous;
+}
+
+
+// ----------------------------------------
+void magma_stats_leave( magma_stats_counters* previous )
+{
+    magma_stats_thread* ts = magma_stats_get_thread();
+    if ( ts != NULL ) {
+        ts->routine = previous;
+    }
+}
+
+
+// ----------------------------------------
+// Forgets queue, which is being released, so a new queue at the same address
+// gets its own counters. Its counters are still reported.
+void magma_stats_queue_destroy( magma_queue_t queue )
+{
+    pthread_mutex_lock( &g_stats_mutex );
+    g_stats_queue_map.erase( queue );
+    g_stats_generation += 1;
+    pthread_mutex_unlock( &g_stats_mutex );
+}
+
+
+// ----------------------------------------
+// Counts bytes of a transfer enqueued on queue.
+void magma_stats_transfer( magma_queue_t queue, size_t bytes_h2d, size_t bytes_d2h )
+{
+    magma_stats_thread*   ts = magma_stats_get_thread();
+    magma_stats_counters* rc = magma_stats_current( ts );
+    magma_stats_counters* qc = magma_stats_queue( ts, queue );
+    if ( bytes_h2d > 0 ) {
+        add( &rc->bytes_h2d, bytes_h2d );
+        if ( qc != NULL ) add( &qc->bytes_h2d, bytes_h2d );
+    }
+    if ( bytes_d2h > 0 ) {
+        add( &rc->bytes_d2h, bytes_d2h );
+        if ( qc != NULL ) add( &qc->bytes_d2h, bytes_d2h );
+    }
+}
+
+
+// ----------------------------------------
+// Counts a command enqueued on queue, as recorded by trace_command.
+// For kernels with an event, adds their run time once they complete, if
+// kernel timing is on. Transfers are counted by magma_stats_transfer.
+void magma_stats_command( magma_queue_t queue, const char* tag, cl_event event )
+{
+    if ( strcmp( tag, "kernel" ) != 0 )
+        return;
+
+    magma_stats_thread*   ts = magma_stats_get_thread();
+    magma_stats_counters* rc = magma_stats_current( ts );
+    magma_stats_counters* qc = magma_stats_queue( ts, queue );
+    add( &rc->kernel_launches, 1 );
+    if ( qc != NULL ) {
+        add( &qc->kernel_launches, 1 );
+    }
+
+    if ( g_stats_kernel_time && event != NULL ) {
+        magma_stats_kernel* k = (magma_stats_kernel*) malloc( sizeof(magma_stats_kernel) );
+        if ( k != NULL ) {
+            k->routine = rc;
+            k->queue   = qc;
+            if ( clSetEventCallback( event, CL_COMPLETE, magma_stats_kernel_done, k ) != CL_SUCCESS ) {
+                free( k );
+            }
+        }
+    }
+}
+
+
+// ----------------------------------------
+// Adds seconds of CPU work, such as a LAPACK panel, to the calling thread's routine.
+void magma_stats_cpu( double seconds )
+{
+    if ( seconds > 0 ) {
+        add( &magma_stats_current( magma_stats_get_thread() )->cpu_ns,
+             (long long) (seconds * 1e9) );
+    }
+}
+
+
+// ----------------------------------------
+// Counts an allocation by the calling thread's routine.
+void magma_stats_alloc()
+{
+    add( &magma_stats_current( magma_stats_get_thread() )->allocs, 1 );
+}
+
+
+// ========================================
+// public interface
+
+// ----------------------------------------
+static void magma_stats_copy( magma_stats_t* out, const magma_stats_counters* c )
+{
+    magma_strlcpy( out->name, c->name, sizeof(out->name) );
+    out->calls           = c->calls;
+    out->bytes_h2d       = c->bytes_h2d;
+    out->bytes_d2h       = c->bytes_d2h;
+    out->kernel_launches = c->kernel_launches;
+    out->kernel_time     = c->kernel_ns * 1e-9;
+    out->cpu_time        = c->cpu_ns    * 1e-9;
+    out->allocs          = c->allocs;
+}
+
+
+// ----------------------------------------
+// Copies counters from list into out, up to *n of them, setting *n to the
+// number available.
+static void magma_stats_copy_list(
+    const magma_stats_counters* list, magma_stats_t* out, magma_int_t* n )
+{
+    if ( n == NULL )
+        return;
+
+    magma_int_t count = 0;
+    for( const magma_stats_counters* c = list; c != NULL; c = c->next ) {
+        if ( out != NULL && count < *n ) {
+            magma_stats_copy( &out[ count ], c );
+        }
+        count += 1;
+    }
+    *n = count;
+}
+
+
+// ----------------------------------------
+// Gets the counters of routines, in order of first call, and of queues, in
+// order of first use. Work outside any counted routine is in
+// "(outside routines)". On entry, *nroutines and *nqueues are the dimensions
+// of routines and queues; on exit, the numbers available, which may be more.
+// If nroutines or nqueues is NULL, that list is skipped.
+extern "C" magma_int_t
+magma_stats_get(
+    magma_stats_t* routines, magma_int_t* nroutines,
+    magma_stats_t* queues,   magma_int_t* nqueues )
+{
+    pthread_mutex_lock( &g_stats_mutex );
+    magma_stats_copy_list( g_stats_routines, routines, nroutines );
+    magma_stats_copy_list( g_stats_queues,   queues,   nqueues   );
+    pthread_mutex_unlock( &g_stats_mutex );
+    return MAGMA_SUCCESS;
+}
+
+
+// ----------------------------------------
+// Zeros the counters of every routine and queue.
+// Kernels still running are added when they complete.
+extern "C" void
+magma_stats_reset( void )
+{
+    pthread_mutex_lock( &g_stats_mutex );
+    magma_stats_counters* lists[2] = { g_stats_routines, g_stats_queues };
+    for( int i = 0; i < 2; ++i ) {
+        for( magma_stats_counters* c = lists[i]; c != NULL; c = c->next ) {
+            c->calls           = 0;
+            c->bytes_h2d       = 0;
+            c->bytes_d2h       = 0;
+            c->kernel_launches = 0;
+            c->kernel_ns       = 0;
+            c->cpu_ns          = 0;
+            c->allocs          = 0;
+        }
+    }
+    pthread_mutex_unlock( &g_stats_mutex );
+}
+
+
+// ----------------------------------------
+// Writes str as a JSON string, with quotes. Also used by trace.cpp.
+void magma_fput_json( FILE* file, const char* str )
+{
+    fputc( '"', file );
+    for( ; *str != '\0'; ++str ) {
+        unsigned char c = *str;
+        if ( c == '"' || c == '\\' ) {
+            fprintf( file, "\\%c", c );
+        }
+        else if ( c < 0x20 ) {
+            fprintf( file, "\\u%04x", c );
+        }
+        else {
+            fputc( c, file );
+        }
+    }
+    fputc( '"', file );
+}
+
+
+// ----------------------------------------
+static void fput_json_list( FILE* file, const magma_stats_counters* list )
+{
+    fprintf( file, "[" );
+    for( const magma_stats_counters* c = list; c != NULL; c = c->next ) {
+        fprintf( file, "%s\n    { \"name\": ", (c == list ? "" : ",") );
+        magma_fput_json( file, c->name );
+        fprintf( file, ", \"calls\": %lld, \"bytes_h2d\": %lld, \"bytes_d2h\": %lld, "
+                 "\"kernel_launches\": %lld, \"kernel_time\": %.9f, \"cpu_time\": %.9f, "
+                 "\"allocs\": %lld }",
+                 c->calls, c->bytes_h2d, c->bytes_d2h, c->kernel_launches,
+                 c->kernel_ns * 1e-9, c->cpu_ns * 1e-9, c->allocs );
+    }
+    fprintf( file, "\n  ]" );
+}
+
+
+// ----------------------------------------
+// Writes the counters as JSON to filename, or stdout if filename is NULL or "-":
+// an object with "routines" and "queues" arrays, whose objects have the
+// fields of magma_stats_t, with times in seconds, and "kernel_time_measured".
+// magma_finalize calls this with $MAGMA_STATS, if set.
+extern "C" magma_int_t
+magma_stats_print_json( const char* filename )
+{
+    bool to_stdout = (filename == NULL || strcmp( filename, "-" ) == 0);
+    FILE* file = (to_stdout ? stdout : fopen( filename, "w" ));
+    if ( file == NULL ) {
+        fprintf( stderr, "Error: can't write stats '%s': %s (%d)\n",
+                 filename, strerror(errno), errno );
+        return MAGMA_ERR_FILESYSTEM;
+    }
+
+    pthread_mutex_lock( &g_stats_mutex );
+    fprintf( file, "{\n  \"kernel_time_measured\": %s,\n  \"routines\": ",
+             (g_stats_kernel_time ? "true" : "false") );
+    fput_json_list( file, g_stats_routines );
+    fprintf( file, ",\n  \"queues\": " );
+    fput_json_list( file, g_stats_queues );
+    fprintf( file, "\n}\n" );
+    pthread_mutex_unlock( &g_stats_mutex );
+
+    bool ok = (fflush( file ) == 0);
+    if ( ! to_stdout ) {
+        ok = (fclose( file ) == 0) && ok;
+    }
+    if ( ! ok ) {
+        fprintf( stderr, "Error: can't write stats '%s': %s (%d)\n",
+                 filename, strerror(errno), errno );
+        return MAGMA_ERR_FILESYSTEM;
+    }
+    return MAGMA_SUCCESS;
+}
@@ -0,0 +1,85 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#ifndef MAGMA_STATS_H
+#define MAGMA_STATS_H
+
+#include "common_magma.h"
+
+// ----------------------------------------
+// Always-on performance counters, per routine and per queue, read by
+// magma_stats_get and written as JSON by magma_stats_print_json.
+//
+// A routine counts itself with MAGMA_STATS_ROUTINE() at its top; until it
+// returns, transfers, kernels, CPU time, and allocations on the calling
+// thread are charged to it (to the innermost one, if routines nest).
+// Transfers and kernels are also charged to their queue.
+// Counters are updated with atomic adds, without locking.
+//
+// Kernel time needs profiling events, so it is measured only if
+// $MAGMA_STATS_KERNEL_TIME is nonzero or tracing is on (see trace.h);
+// queues created then have profiling enabled.
+
+struct magma_stats_counters
+{
+    char                  name[ 64 ];
+    volatile long long    calls;
+    volatile long long    bytes_h2d;
+    volatile long long    bytes_d2h;
+    volatile long long    kernel_launches;
+    volatile long long    kernel_ns;
+    volatile long long    cpu_ns;
+    volatile long long    allocs;
+    magma_stats_counters* next;
+};
+
+extern bool g_stats_kernel_time;
+
+inline bool magma_stats_kernel_time() { return g_stats_kernel_time; }
+
+void magma_stats_startup();
+void magma_stats_shutdown();
+
+magma_stats_counters* magma_stats_routine( const char* name );
+
+magma_stats_counters* magma_stats_enter( magma_stats_counters* routine );
+void                  magma_stats_leave( magma_stats_counters* previous );
+
+void magma_stats_queue_destroy( magma_queue_t queue );
+
+void magma_stats_transfer( magma_queue_t queue, size_t bytes_h2d, size_t bytes_d2h );
+void magma_stats_command ( magma_queue_t queue, const char* tag, cl_event event );
+void magma_stats_cpu     ( double seconds );
+void magma_stats_alloc   ();
+
+void magma_fput_json( FILE* file, const char* str );
+
+
+// ----------------------------------------
+// Charges the calling thread's work to routine while in scope.
+class magma_stats_scope
+{
+public:
+    magma_stats_scope( magma_stats_counters* routine ):
+        m_previous( magma_stats_enter( routine ))
+    {}
+
+    ~magma_stats_scope()
+    {
+        magma_stats_leave( m_previous );
+    }
+
+private:
+    magma_stats_counters* m_previous;
+};
+
+// Put at the top of a routine to count its calls and charge its work to it.
+#define MAGMA_STATS_ROUTINE()                                                \
+    static magma_stats_counters* magma_stats_routine_ = magma_stats_routine( __func__ ); \
+    magma_stats_scope magma_stats_scope_( magma_stats_routine_ )
+
+#endif        //  #ifndef MAGMA_STATS_H
@@ -25,17 +25,29 @@ static void check( int err )
     
     Purpose
     -------
-    Implements a thread pool with a multi-producer, multi-consumer queue.
+    Implements a thread pool with a work-stealing, dependency-aware scheduler.
     
     Typical use:
     A main thread creates the queue and tells it to launch worker threads. Then
-    the main thread inserts (pushes) tasks into the queue. Threads will execute
-    the tasks. No dependencies are tracked. The main thread can sync the queue,
-    waiting for all current tasks to finish, and then insert more tasks into the
-    queue. When finished, the main thread calls quit or simply destructs the
-    queue, which will exit all worker threads.
+    the main thread inserts (pushes) tasks into the queue, each with a priority
+    and the earlier tasks it depends on. A task becomes ready when all its
+    dependencies have finished; threads execute ready tasks, higher priority
+    first. The main thread can sync the queue, waiting for all current tasks to
+    finish, and then insert more tasks into the queue. When finished, the main
+    thread calls quit or simply destructs the queue, which will exit all worker
+    threads after the remaining tasks finish.
+    
+    Each thread has its own deque of ready tasks. A thread takes tasks from the
+    back of its deque, where the highest priority and newest tasks are, and puts
+    the tasks its finished task made ready there too, so successors tend to
+    run on the thread that produced their data. An idle thread steals from
+    other threads' deques, taking the oldest task unless a newer one has higher
+    priority.
     
     Tasks are sub-classes of magma_task. They must implement the run() function.
+    Tasks must be allocated with new; the queue deletes them in sync or quit,
+    so the main thread can name any task pushed since the last sync as a
+    dependency, even if it has already finished.
     
     Example
     -------
@@ -63,15 +75,20 @@ static void check( int err )
     void master( int n ) {
         magma_thread_queue queue;
         queue.launch( 12 );  // 12 worker threads
+        std::vector< magma_task* > t1( n );
         for( int i=0; i < n; ++i ) {
-            queue.push_task( new task1( i ));
+            t1[i] = new task1( i );
+            queue.push_task( t1[i] );
         }
-        queue.sync();  // wait for all task1 to finish before doing task2.
         for( int i=0; i < n; ++i ) {
             for( int j=0; j < i; ++j ) {
-                queue.push_task( new task2( i, j ));
+                // task2( i, j ) waits for task1( i ) and task1( j ),
+                // and runs before task2( i, j-1 )
+                magma_task* deps[2] = { t1[i], t1[j] };
+                queue.push_task( new task2( i, j ), j, 2, deps );
             }
         }
+        queue.sync();  // wait for all tasks to finish
         queue.quit();  // [optional] explicitly exit worker threads
     }
     @endcode
@@ -84,24 +101,25 @@ static void check( int err )
 
 // ---------------------------------------------
 /// Thread's main routine, executed by pthread_create.
-/// Executes tasks from queue (given as arg), until a NULL task is returned.
-/// Deletes each task when it is done.
-/// @param[in,out] arg    magma_thread_queue to get tasks from.
+/// Executes tasks from queue (given in arg), until a NULL task is returned.
+/// @param[in,out] arg    thread_arg with magma_thread_queue to get tasks from
+///                       and the thread's index.
 extern "C"
 void* magma_thread_main( void* arg )
 {
-    magma_thread_queue* queue = (magma_thread_queue*) arg;
+    magma_thread_queue::thread_arg* targ = (magma_thread_queue::thread_arg*) arg;
+    magma_thread_queue* queue = targ->queue;
+    magma_int_t index = targ->index;
     magma_task* task;
     
     while( true ) {
-        task = queue->pop_task();
+        task = queue->pop_task( index );
         if ( task == NULL ) {
             break;
         }
         
         task->run();
-        queue->task_done();
-        delete task;
+        queue->task_done( task, index );
         task = NULL;
     }
     
@@ -112,11 +130,16 @@ void* magma_thread_main( void* arg )
 // ---------------------------------------------
 /// Creates queue with NO threads. Use \ref launch to create threads.
 magma_thread_queue::magma_thread_queue():
-    q        (),
-    quit_flag( false ),
-    ntask    ( 0     ),
-    threads  ( NULL  ),
-    nthread  ( 0     )
+    deques    ( NULL  ),
+    args      ( NULL  ),
+    nready    ( 0     ),
+    nsleep    ( 0     ),
+    next_deque( 0     ),
+    finished  (),
+    quit_flag ( false ),
+    ntask     ( 0     ),
+    threads   ( NULL  ),
+    nthread   ( 0     )
 {
     check( pthread_mutex_init( &mutex,      NULL ));
     check( pthread_cond_init(  &cond,       NULL ));
@@ -134,7 +157,7 @@ magma_thread_queue::~magma_thread_queue()
 }
 
 
-/// Creates threads.
+/// Creates threads, each with its deque.
 /// @param[in] in_nthread    Number of threads to launch.
 void magma_thread_queue::launch( magma_int_t in_nthread )
 {
@@ -143,70 +166,196 @@ void magma_thread_queue::launch( magma_int_t in_nthread )
     if ( nthread < 1 ) {
         nthread = 1;
     }
+    deques  = new ready_deque[ nthread ];
+    args    = new thread_arg[ nthread ];
     threads = new pthread_t[ nthread ];
     for( magma_int_t i=0; i < nthread; ++i ) {
-        check( pthread_create( &threads[i], NULL, magma_thread_main, this ));
+        check( pthread_mutex_init( &deques[i].mutex, NULL ));
+    }
+    for( magma_int_t i=0; i < nthread; ++i ) {
+        args[i].queue = this;
+        args[i].index = i;
+        check( pthread_create( &threads[i], NULL, magma_thread_main, &args[i] ));
         //printf( "launch %d (%lx)\n", i, (long) threads[i] );
     }
 }
 
 
-/// Add task to queue. Task must be allocated with C++ new.
+/// Add task with no dependencies to queue. Task must be allocated with C++ new.
+/// @param[in] task        Task to queue.
+/// @param[in] priority    Tasks with higher priority run first; default 0.
+void magma_thread_queue::push_task( magma_task* task, magma_int_t priority )
+{
+    push_task( task, priority, 0, NULL );
+}
+
+
+/// Add task to queue, to run after the tasks in deps finish.
+/// Task must be allocated with C++ new.
 /// Increments number of outstanding tasks.
-/// Signals threads that are waiting in pop_task.
-/// @param[in] task    Task to queue.
-void magma_thread_queue::push_task( magma_task* task )
+/// If task is ready, puts it in a thread's deque, round-robin,
+/// and signals a thread that is waiting in pop_task.
+/// @param[in] task        Task to queue.
+/// @param[in] priority    Tasks with higher priority run first.
+/// @param[in] ndeps       Number of dependencies.
+/// @param[in] deps        Array of ndeps tasks pushed since the last \ref sync,
+///                        which may have finished. NULL entries are ignored.
+void magma_thread_queue::push_task(
+    magma_task* task, magma_int_t priority,
+    magma_int_t ndeps, magma_task* const* deps )
 {
+    assert( threads != NULL );  // else launch was not called
     check( pthread_mutex_lock( &mutex ));
     if ( quit_flag ) {
+        check( pthread_mutex_unlock( &mutex ));
         fprintf( stderr, "Error: push_task() called after quit()\n" );
         throw std::exception();
     }
-    q.push( task );
+    task->m_priority = priority;
+    task->m_ndeps    = 0;
+    for( magma_int_t i=0; i < ndeps; ++i ) {
+        if ( deps[i] != NULL && ! deps[i]->m_done ) {
+            deps[i]->m_successors.push_back( task );
+            task->m_ndeps += 1;
+        }
+    }
     ntask += 1;
+    bool ready = (task->m_ndeps == 0);
     //printf( "push; ntask %d\n", ntask );
-    check( pthread_cond_broadcast( &cond ));
     check( pthread_mutex_unlock( &mutex ));
+    
+    if ( ready ) {
+        long index = __sync_fetch_and_add( &next_deque, 1 ) % nthread;
+        push_ready( task, index );
+    }
 }
 
 
-/// Get next task from queue.
-/// @return next task, blocking until a task is inserted if necesary.
-/// @return NULL if queue is empty *and* \ref quit has been called.
+/// Puts ready task in deque of thread index, after tasks of the same or
+/// lower priority, and signals a thread waiting in pop_task, if any.
+void magma_thread_queue::push_ready( magma_task* task, magma_int_t index )
+{
+    ready_deque& dq = deques[ index ];
+    check( pthread_mutex_lock( &dq.mutex ));
+    std::deque< magma_task* >::iterator it = dq.tasks.end();
+    while( it != dq.tasks.begin() && (*(it-1))->m_priority > task->m_priority ) {
+        --it;
+    }
+    dq.tasks.insert( it, task );
+    check( pthread_mutex_unlock( &dq.mutex ));
+    
+    // full barrier: waiting threads increment nsleep, then read nready
+    __sync_fetch_and_add( &nready, 1 );
+    if ( nsleep > 0 ) {
+        check( pthread_mutex_lock( &mutex ));
+        check( pthread_cond_signal( &cond ));
+        check( pthread_mutex_unlock( &mutex ));
+    }
+}
+
+
+/// Get next task for thread index: from the back of its own deque, else
+/// stolen from another thread's deque.
+/// @return next task, blocking until a task is ready if necesary.
+/// @return NULL if all tasks are finished *and* \ref quit has been called.
 ///
 /// This does *not* decrement number of outstanding tasks;
 /// thread should call \ref task_done when task is completed.
-magma_task* magma_thread_queue::pop_task()
+magma_task* magma_thread_queue::pop_task( magma_int_t index )
 {
     magma_task* task = NULL;
-    check( pthread_mutex_lock( &mutex ));
-    while( q.empty() && ! quit_flag ) {
-        check( pthread_cond_wait( &cond, &mutex ));
-    }
-    // q has item or quit is set (or both)
-    if ( ! q.empty()) {
-        task = q.front();
-        q.pop();
+    while( true ) {
+        // own deque: highest priority, newest
+        ready_deque& own = deques[ index ];
+        check( pthread_mutex_lock( &own.mutex ));
+        if ( ! own.tasks.empty() ) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+        }
+        check( pthread_mutex_unlock( &own.mutex ));
+        
+        // steal: oldest, unless newest has higher priority
+        for( magma_int_t i=1; task == NULL && i < nthread; ++i ) {
+            ready_deque& victim = deques[ (index + i) % nthread ];
+            check( pthread_mutex_lock( &victim.mutex ));
+            if ( ! victim.tasks.empty() ) {
+                if ( victim.tasks.back()->m_priority > victim.tasks.front()->m_priority ) {
+                    task = victim.tasks.back();
+                    victim.tasks.pop_back();
+                }
+                else {
+                    task = victim.tasks.front();
+                    victim.tasks.pop_front();
+                }
+            }
+            check( pthread_mutex_unlock( &victim.mutex ));
+        }
+        
+        if ( task != NULL ) {
+            __sync_fetch_and_sub( &nready, 1 );
+            return task;
+        }
+        
+        // wait for a ready task, or for quit once all tasks are finished
+        check( pthread_mutex_lock( &mutex ));
+        __sync_fetch_and_add( &nsleep, 1 );  // full barrier before reading nready
+        while( nready == 0 && ! (quit_flag && ntask == 0) ) {
+            check( pthread_cond_wait( &cond, &mutex ));
+        }
+        __sync_fetch_and_sub( &nsleep, 1 );
+        bool done = (nready == 0);
+        check( pthread_mutex_unlock( &mutex ));
+        if ( done ) {
+            return NULL;
+        }
     }
-    //printf( "pop;  ntask %d\n", ntask );
-    check( pthread_mutex_unlock( &mutex ));
-    return task;
 }
 
 
 /// Marks task as finished, decrementing number of outstanding tasks.
-/// Signals threads that are waiting in \ref sync.
-void magma_thread_queue::task_done()
+/// Puts successors that are now ready in the deque of thread index.
+/// Signals threads that are waiting in \ref sync and, on quit, in pop_task.
+void magma_thread_queue::task_done( magma_task* task, magma_int_t index )
 {
+    std::vector< magma_task* > ready;
     check( pthread_mutex_lock( &mutex ));
+    task->m_done = true;
+    for( size_t i=0; i < task->m_successors.size(); ++i ) {
+        magma_task* succ = task->m_successors[i];
+        succ->m_ndeps -= 1;
+        if ( succ->m_ndeps == 0 ) {
+            ready.push_back( succ );
+        }
+    }
+    task->m_successors.clear();
+    finished.push_back( task );
     ntask -= 1;
     //printf( "fini; ntask %d\n", ntask );
-    check( pthread_cond_broadcast( &cond_ntask ));
+    if ( ntask == 0 ) {
+        check( pthread_cond_broadcast( &cond_ntask ));
+        if ( quit_flag ) {
+            check( pthread_cond_broadcast( &cond ));
+        }
+    }
     check( pthread_mutex_unlock( &mutex ));
+    
+    for( size_t i=0; i < ready.size(); ++i ) {
+        push_ready( ready[i], index );
+    }
 }
 
 
-/// Block until all outstanding tasks have been finished.
+/// Deletes tasks that have finished. Called when no task can name them.
+void magma_thread_queue::delete_finished()
+{
+    for( size_t i=0; i < finished.size(); ++i ) {
+        delete finished[i];
+    }
+    finished.clear();
+}
+
+
+/// Block until all outstanding tasks have been finished, then deletes them.
 /// Threads continue to be alive; more tasks can be pushed after sync.
 void magma_thread_queue::sync()
 {
@@ -217,14 +366,15 @@ void magma_thread_queue::sync()
         //printf( "sync; ntask %d\n", ntask );
     }
     //printf( "sync; ntask %d [done]\n", ntask );
+    delete_finished();
     check( pthread_mutex_unlock( &mutex ));
 }
 
 
-/// Sets quit_flag, so \ref pop_task will return NULL once queue is empty,
-/// telling threads to exit.
+/// Sets quit_flag, so \ref pop_task will return NULL once all tasks are
+/// finished, telling threads to exit.
 /// Signals all threads that are waiting in pop_task.
-/// Waits for all threads to exit (i.e., joins them).
+/// Waits for all threads to exit (i.e., joins them), then deletes tasks.
 /// It is safe to call quit multiple times -- the first time all the threads are
 /// joined; subsequent times it does nothing.
 /// (Destructor also calls quit, but you may prefer to call it explicitly.)
@@ -244,14 +394,21 @@ void magma_thread_queue::quit()
     check( pthread_mutex_unlock( &mutex ));
     
     // next, join all threads
-    if ( join ) {
-        assert( threads != NULL );
+    if ( join && threads != NULL ) {
         for( magma_int_t i=0; i < nthread; ++i ) {
             check( pthread_join( threads[i], NULL ));
             //printf( "joined %d (%lx)\n", i, (long) threads[i] );
         }
+        for( magma_int_t i=0; i < nthread; ++i ) {
+            check( pthread_mutex_destroy( &deques[i].mutex ));
+        }
         delete[] threads;
+        delete[] args;
+        delete[] deques;
         threads = NULL;
+        args    = NULL;
+        deques  = NULL;
+        delete_finished();
     }
 }
 
@@ -266,3 +423,97 @@ magma_int_t magma_thread_queue::get_thread_index( pthread_t thread ) const
     }
     return -1;
 }
+
+
+/**
+    @class magma_queue_pool
+    
+    Purpose
+    -------
+    Lends device queues to tasks of a magma_thread_queue. A task running on
+    device d acquires one of d's queues, enqueues its commands, syncs, and
+    releases the queue, so concurrent tasks on one device never share a queue,
+    and a device runs at most nqueue tasks at once.
+*/
+
+/// @param[in] ndevice    Number of devices.
+/// @param[in] nqueue     Number of queues per device.
+/// @param[in] queues     Array of ndevice*nqueue queues; queue q of device d
+///                       is queues[ d*nqueue + q ].
+magma_queue_pool::magma_queue_pool(
+    magma_int_t ndevice, magma_int_t nqueue, magma_queue_t* queues ):
+    free_queues( ndevice )
+{
+    for( magma_int_t d=0; d < ndevice; ++d ) {
+        for( magma_int_t q=0; q < nqueue; ++q ) {
+            free_queues[d].push_back( queues[ d*nqueue + q ] );
+        }
+    }
+    check( pthread_mutex_init( &mutex,        NULL ));
+    check( pthread_cond_init(  &cond,         NULL ));
+    for( int i=0; i < nkernel_locks; ++i ) {
+        check( pthread_mutex_init( &kernel_mutexes[i], NULL ));
+    }
+}
+
+
+magma_queue_pool::~magma_queue_pool()
+{
+    check( pthread_mutex_destroy( &mutex ));
+    check( pthread_cond_destroy( &cond ));
+    for( int i=0; i < nkernel_locks; ++i ) {
+        check( pthread_mutex_destroy( &kernel_mutexes[i] ));
+    }
+}
+
+
+/// @return a queue of device dev, blocking until one is released if necessary.
+magma_queue_t magma_queue_pool::acquire( magma_int_t dev )
+{
+    check( pthread_mutex_lock( &mutex ));
+    while( free_queues[dev].empty() ) {
+        check( pthread_cond_wait( &cond, &mutex ));
+    }
+    magma_queue_t queue = free_queues[dev].back();
+    free_queues[dev].pop_back();
+    check( pthread_mutex_unlock( &mutex ));
+    return queue;
+}
+
+
+/// Returns queue, acquired from device dev, to the pool.
+/// The caller must have synced it if later tasks depend on its commands.
+void magma_queue_pool::release( magma_int_t dev, magma_queue_t queue )
+{
+    check( pthread_mutex_lock( &mutex ));
+    free_queues[dev].push_back( queue );
+    check( pthread_cond_broadcast( &cond ));
+    check( pthread_mutex_unlock( &mutex ));
+}
+
+
+/// @return the mutex of BLAS routine, e.g., "gemm".
+pthread_mutex_t* magma_queue_pool::kernel_mutex( const char* routine )
+{
+    // FNV-1a
+    unsigned h = 2166136261u;
+    for( ; *routine != '\0'; ++routine ) {
+        h ^= (unsigned char) *routine;
+        h *= 16777619u;
+    }
+    return &kernel_mutexes[ h % nkernel_locks ];
+}
+
+
+/// Locks enqueueing kernels of BLAS routine, e.g., "gemm";
+/// see magma_queue_pool in thread_queue.hpp.
+void magma_queue_pool::lock_kernels( const char* routine )
+{
+    check( pthread_mutex_lock( kernel_mutex( routine )));
+}
+
+
+void magma_queue_pool::unlock_kernels( const char* routine )
+{
+    check( pthread_mutex_unlock( kernel_mutex( routine )));
+}
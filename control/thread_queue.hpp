@@ -11,7 +11,8 @@
 #ifndef MAGMA_THREAD_HPP
 #define MAGMA_THREAD_HPP
 
-#include <queue>
+#include <deque>
+#include <vector>
 
 #include "common_magma.h"
 
@@ -20,51 +21,137 @@
 extern "C"
 void* magma_thread_main( void* arg );
 
+class magma_thread_queue;
+
 
 // ---------------------------------------------
 class magma_task
 {
 public:
-    magma_task() {}
+    magma_task():
+        m_priority( 0 ),
+        m_ndeps   ( 0 ),
+        m_done    ( false )
+    {}
     virtual ~magma_task() {}
-    
+
     virtual void run() = 0;  // pure virtual function to execute task
+
+private:
+    friend class magma_thread_queue;
+
+    magma_int_t                m_priority;    ///<  higher runs first
+    magma_int_t                m_ndeps;       ///<  number of unfinished dependencies
+    bool                       m_done;        ///<  set when task has run
+    std::vector< magma_task* > m_successors;  ///<  tasks that depend on this one
 };
 
 
 // ---------------------------------------------
-// Thread pool with multi-producer, multi-consumer queue.
+// Task that does nothing, to join several dependencies into one.
+class magma_empty_task: public magma_task
+{
+public:
+    virtual void run() {}
+};
+
+
+// ---------------------------------------------
+// Thread pool with a work-stealing scheduler for a DAG of tasks.
 //
-// This is similar to python's queue class, but also implements worker threads
-// and adds quit mechanism.
+// Each thread has a deque of ready tasks, sorted by priority. A thread runs
+// the highest priority task of its own deque, newest first; when that is
+// empty, it steals from other threads' deques, taking the oldest task unless
+// a newer one has higher priority. Tasks whose dependencies are unfinished
+// wait outside the deques; the thread finishing the last dependency puts the
+// task in its own deque.
 // sync is like python's join. Threads do not exit, so I find join to be a misleading name.
 class magma_thread_queue
 {
 public:
     magma_thread_queue();
     ~magma_thread_queue();
-    
+
     void launch( magma_int_t in_nthread );
-    void push_task( magma_task* task );
+    void push_task( magma_task* task, magma_int_t priority=0 );
+    void push_task( magma_task* task, magma_int_t priority,
+                    magma_int_t ndeps, magma_task* const* deps );
     void sync();
     void quit();
-    
+
+    magma_int_t get_nthread() const { return nthread; }
+
 protected:
     friend void* magma_thread_main( void* arg );
-    magma_task* pop_task();
-    void task_done();
-    
+    magma_task* pop_task( magma_int_t index );
+    void task_done( magma_task* task, magma_int_t index );
+    void push_ready( magma_task* task, magma_int_t index );
+    void delete_finished();
+
     magma_int_t get_thread_index( pthread_t thread ) const;
-    
+
 private:
-    std::queue< magma_task* > q;  ///<  queue of tasks
+    // deque of ready tasks of one thread
+    struct ready_deque {
+        pthread_mutex_t           mutex;  ///<  lock for tasks
+        std::deque< magma_task* > tasks;  ///<  sorted by priority, highest at back
+    };
+
+    // argument to magma_thread_main
+    struct thread_arg {
+        magma_thread_queue* queue;
+        magma_int_t         index;
+    };
+
+    ready_deque*    deques;       ///<  array of nthread deques
+    thread_arg*     args;         ///<  array of nthread thread arguments
+    volatile long   nready;       ///<  number of tasks in deques (updated atomically)
+    volatile long   nsleep;       ///<  number of threads waiting in pop_task
+    volatile long   next_deque;   ///<  round-robin deque for tasks pushed from outside
+    std::vector< magma_task* > finished;  ///<  tasks that ran, deleted by sync and quit
     bool            quit_flag;    ///<  quit() sets this to true; after this, pop returns NULL
-    magma_int_t     ntask;        ///<  number of unfinished tasks (in queue or currently executing)
-    pthread_mutex_t mutex;        ///<  mutex lock for queue, quit, ntask
-    pthread_cond_t  cond;         ///<  condition variable for changes to queue and quit (see push, pop, quit)
-    pthread_cond_t  cond_ntask;   ///<  condition variable for changes to ntask (see sync, task_done)
+    magma_int_t     ntask;        ///<  number of unfinished tasks (waiting, ready, or executing)
+    pthread_mutex_t mutex;        ///<  mutex lock for dependencies, finished, quit, ntask
+    pthread_cond_t  cond;         ///<  condition variable for changes to nready and quit (see push, pop, quit)
+    pthread_cond_t  cond_ntask;   ///<  condition variable for ntask reaching 0 (see sync, task_done)
     pthread_t*      threads;      ///<  array of threads
     magma_int_t     nthread;      ///<  number of threads
 };
 
+
+// ---------------------------------------------
+// Device queues that tasks check out for exclusive use, so tasks running
+// concurrently on one device enqueue to different queues.
+// Queues of device d are queues[ d*nqueue ], ..., queues[ d*nqueue + nqueue-1 ].
+//
+// clmagmablas kernels are per-thread clones (see clmagma_runtime.h) and need
+// no lock. The BLAS library's kernels may be cl_kernel objects shared by all
+// callers of a routine, whose arguments are set and enqueued in separate
+// calls that must not interleave with another thread's; tasks enqueue each
+// BLAS call between lock_kernels( routine ) and unlock_kernels( routine ).
+// Each routine's kernels come from its own program, so calls to different
+// routines, e.g., "gemm" and "trsm", proceed concurrently. Routine names are
+// hashed to one of nkernel_locks mutexes; a collision only serializes more.
+class magma_queue_pool
+{
+public:
+    magma_queue_pool( magma_int_t ndevice, magma_int_t nqueue, magma_queue_t* queues );
+    ~magma_queue_pool();
+
+    magma_queue_t acquire( magma_int_t dev );
+    void release( magma_int_t dev, magma_queue_t queue );
+
+    void lock_kernels  ( const char* routine );
+    void unlock_kernels( const char* routine );
+
+private:
+    std::vector< std::vector< magma_queue_t > > free_queues;  ///<  per device
+    pthread_mutex_t mutex;         ///<  mutex lock for free_queues
+    pthread_cond_t  cond;          ///<  condition variable for queues released
+
+    static const int nkernel_locks = 16;
+    pthread_mutex_t* kernel_mutex( const char* routine );
+    pthread_mutex_t kernel_mutexes[ nkernel_locks ];  ///<  see lock_kernels
+};
+
 #endif        //  #ifndef MAGMA_THREAD_HPP
@@ -1,215 +1,623 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <errno.h>
 #include <string.h>      // strerror_r
 
-#include <set>
-#include <string>
+#include <algorithm>  // sort
+#include <map>
+#include <vector>
 
+#include "clmagma_runtime.h"  // memory pool
 #include "trace.h"
+#include "magma_stats.h"
 
-// define TRACING to compile these functions, e.g.,
-// gcc -DTRACING -c trace.cpp
-#ifdef TRACING
 
-// set TRACE_METHOD = 2 to record start time as
-// later of CPU time and previous event's end time.
-// set TRACE_METHOD = 1 to record start time using CUDA event.
-//#define TRACE_METHOD 2
+// ----------------------------------------
+// kinds of trace records
+enum {
+    TRACE_CPU,      // CPU span, [cpu_start, cpu_end] in magma_wtime seconds
+    TRACE_SPAN,     // GPU span, from end of marker ev_start to end of marker ev_end
+    TRACE_COMMAND,  // GPU command, ev_start's profiled start and end
+    TRACE_WAIT,     // queue waits on marker ev_start; ev_end is its barrier
+    TRACE_SYNC      // CPU waits on marker ev_start, [cpu_start, cpu_end]
+};
 
-extern cl_context gContext;
+struct trace_record
+{
+    int           kind;
+    int           depth;                   // CPU span nesting level
+    double        cpu_start;
+    double        cpu_end;
+    magma_queue_t queue;
+    cl_device_id  device;
+    cl_event      ev_start;                // owned by the record
+    cl_event      ev_end;                  // owned by the record
+    char          tag  [ MAX_TAG_LEN   ];
+    char          label[ MAX_LABEL_LEN ];
+};
 
+const int MAX_CPU_DEPTH = 32;
 
-// ----------------------------------------
-struct event_log
+// Ring buffer of one thread. Only that thread writes records; count is the
+// number written so far, published after each record is complete.
+// Buffers stay in the list for the life of the process, as the thread's key
+// refers to them; trace_shutdown frees only their records.
+struct trace_buffer
 {
-    int    ncore;
-    int    cpu_id   [ MAX_CORES ];
-    double cpu_first;
-    double cpu_start[ MAX_CORES ][ MAX_EVENTS ];
-    double cpu_end  [ MAX_CORES ][ MAX_EVENTS ];
-    char   cpu_tag  [ MAX_CORES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    char   cpu_label[ MAX_CORES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    
-    int           ngpu;
-    int           nqueue;
-    magma_queue_t queues   [ MAX_GPU_QUEUES ];
-    int           gpu_id   [ MAX_GPU_QUEUES ];
-    magma_event_t gpu_first[ MAX_GPU_QUEUES ];
-#if TRACE_METHOD == 2
-    double        gpu_start[ MAX_GPU_QUEUES ][ MAX_EVENTS ];
-#endif
-    magma_event_t gpu_end  [ MAX_GPU_QUEUES ][ MAX_EVENTS ];
-    char          gpu_tag  [ MAX_GPU_QUEUES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
-    char          gpu_label[ MAX_GPU_QUEUES ][ MAX_EVENTS ][ MAX_LABEL_LEN ];
+    int           tid;
+    trace_buffer* next;
+
+    trace_record* records;
+    long          capacity;
+    volatile long count;
+
+    // open CPU spans
+    int           cpu_depth;
+    double        cpu_start[ MAX_CPU_DEPTH ];
+    char          cpu_tag  [ MAX_CPU_DEPTH ][ MAX_TAG_LEN   ];
+    char          cpu_label[ MAX_CPU_DEPTH ][ MAX_LABEL_LEN ];
+
+    // open GPU spans, by trace_init queue index
+    cl_event      gpu_start[ MAX_GPU_QUEUES ];
+    char          gpu_tag  [ MAX_GPU_QUEUES ][ MAX_TAG_LEN   ];
+    char          gpu_label[ MAX_GPU_QUEUES ][ MAX_LABEL_LEN ];
+
+    // event of the command being enqueued, between trace_event and trace_command
+    magma_event_t* pending;
+    magma_event_t  slot;
+    char           next_label[ MAX_LABEL_LEN ];
 };
 
-// global log object
-struct event_log glog;
+
+// ----------------------------------------
+// globals
+bool g_trace_enabled = false;
+
+static pthread_mutex_t g_trace_mutex = PTHREAD_MUTEX_INITIALIZER;  // lock for buffer list
+static pthread_key_t   g_trace_key;
+static pthread_once_t  g_trace_key_once = PTHREAD_ONCE_INIT;
+static trace_buffer*   g_trace_buffers  = NULL;
+static int             g_trace_nthreads = 0;
+static long            g_trace_capacity = 65536;
+static double          g_trace_first    = 0;
+
+// queues from trace_init, for trace_gpu_start( dev, queue_num, ... )
+static int             g_trace_nqueue   = 0;
+static int             g_trace_ntotal   = 0;
+static magma_queue_t   g_trace_queues[ MAX_GPU_QUEUES ];
+
+
+// ----------------------------------------
+static void trace_create_key()
+{
+    pthread_key_create( &g_trace_key, NULL );
+}
+
+
+// ----------------------------------------
+// Returns calling thread's buffer, creating it on first use, without records.
+static trace_buffer* trace_get_thread()
+{
+    pthread_once( &g_trace_key_once, trace_create_key );
+    trace_buffer* tb = (trace_buffer*) pthread_getspecific( g_trace_key );
+    if ( tb == NULL ) {
+        tb = (trace_buffer*) calloc( 1, sizeof(trace_buffer) );
+        if ( tb == NULL ) {
+            return NULL;
+        }
+        pthread_mutex_lock( &g_trace_mutex );
+        tb->tid  = g_trace_nthreads++;
+        tb->next = g_trace_buffers;
+        g_trace_buffers = tb;
+        pthread_mutex_unlock( &g_trace_mutex );
+        pthread_setspecific( g_trace_key, tb );
+    }
+    return tb;
+}
+
+
+// ----------------------------------------
+// Returns calling thread's buffer, allocating its records on first use.
+// Only while tracing; records are not needed just to time kernels.
+static trace_buffer* trace_get_buffer()
+{
+    trace_buffer* tb = trace_get_thread();
+    if ( tb == NULL ) {
+        return NULL;
+    }
+    if ( tb->records == NULL ) {
+        // first use, or first use since trace_shutdown
+        tb->records = (trace_record*) calloc( g_trace_capacity, sizeof(trace_record) );
+        if ( tb->records == NULL ) {
+            return NULL;
+        }
+        tb->capacity = g_trace_capacity;
+        tb->count    = 0;
+    }
+    return tb;
+}
+
+
+// ----------------------------------------
+// Returns the next record to fill, releasing the events of the record it
+// overwrites. Call trace_push after filling it.
+static trace_record* trace_next_record( trace_buffer* tb )
+{
+    trace_record* rec = &tb->records[ tb->count % tb->capacity ];
+    if ( tb->count >= tb->capacity ) {
+        if ( rec->ev_start != NULL ) clReleaseEvent( rec->ev_start );
+        if ( rec->ev_end   != NULL ) clReleaseEvent( rec->ev_end   );
+    }
+    rec->ev_start = NULL;
+    rec->ev_end   = NULL;
+    return rec;
+}
+
+static void trace_push( trace_buffer* tb )
+{
+    __sync_synchronize();
+    tb->count = tb->count + 1;
+}
+
+
+// ----------------------------------------
+static cl_device_id trace_queue_device( magma_queue_t queue )
+{
+    cl_device_id device = NULL;
+    clGetCommandQueueInfo( queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL );
+    return device;
+}
+
+
+// ----------------------------------------
+// Enables tracing if $MAGMA_TRACE is set. Called by magma_init.
+void trace_startup()
+{
+    const char* filename = getenv( "MAGMA_TRACE" );
+    if ( filename == NULL || filename[0] == '\0' )
+        return;
+
+    const char* events = getenv( "MAGMA_TRACE_EVENTS" );
+    if ( events != NULL && atol( events ) > 0 ) {
+        g_trace_capacity = atol( events );
+    }
+    g_trace_first   = magma_wtime();
+    g_trace_enabled = true;
+}
 
 
 // ----------------------------------------
-void trace_init( int ncore, int ngpu, int nqueue, magma_queue_t* queues )
+// Writes the trace to $MAGMA_TRACE and disables tracing. Called by magma_finalize.
+void trace_shutdown()
 {
-    if ( ncore > MAX_CORES ) {
-        fprintf( stderr, "Error in trace_init: ncore %d > MAX_CORES %d\n",
-                 ncore, MAX_CORES );
-        exit(1);
+    if ( ! g_trace_enabled )
+        return;
+
+    const char* filename = getenv( "MAGMA_TRACE" );
+    trace_finalize( filename );
+    g_trace_enabled = false;
+    g_trace_nqueue  = 0;
+    g_trace_ntotal  = 0;
+
+    pthread_mutex_lock( &g_trace_mutex );
+    for( trace_buffer* tb = g_trace_buffers; tb != NULL; tb = tb->next ) {
+        for( int t = 0; t < MAX_GPU_QUEUES; ++t ) {
+            if ( tb->gpu_start[t] != NULL ) {
+                clReleaseEvent( tb->gpu_start[t] );
+                tb->gpu_start[t] = NULL;
+            }
+        }
+        free( tb->records );
+        tb->records   = NULL;
+        tb->capacity  = 0;
+        tb->count     = 0;
+        tb->cpu_depth = 0;
+        tb->pending   = NULL;
     }
+    pthread_mutex_unlock( &g_trace_mutex );
+}
+
+
+// ----------------------------------------
+// Sets the queues that trace_gpu_start( dev, queue_num, ... ) refers to:
+// queue_num of device dev is queues[ dev*nqueue + queue_num ].
+void trace_init( int ngpu, int nqueue, magma_queue_t* queues )
+{
+    if ( ! g_trace_enabled )
+        return;
+
     if ( ngpu*nqueue > MAX_GPU_QUEUES ) {
         fprintf( stderr, "Error in trace_init: (ngpu=%d)*(nqueue=%d) > MAX_GPU_QUEUES=%d\n",
                  ngpu, nqueue, MAX_GPU_QUEUES );
-        exit(1);
-    }
-    
-    glog.ncore  = ncore;
-    glog.ngpu   = ngpu;
-    glog.nqueue = nqueue;
-    
-    // initialize ID = 0
-    for( int core = 0; core < ncore; ++core ) {
-        glog.cpu_id[core] = 0;
+        ngpu = MAX_GPU_QUEUES / nqueue;
     }
-    for( int dev = 0; dev < ngpu; ++dev ) {
-        for( int s = 0; s < nqueue; ++s ) {
-            int t = dev*glog.nqueue + s;
-            glog.gpu_id[t] = 0;
-            glog.queues[t] = queues[t];
-        }
-        #ifdef HAVE_CUBLAS
-        cudaSetDevice( dev );
-        cudaDeviceSynchronize();
-        #endif
+    for( int t = 0; t < ngpu*nqueue; ++t ) {
+        g_trace_queues[t] = queues[t];
     }
-    // now that all GPUs are sync'd, record start time
-    // using clEnqueueCopyBuffer as a GPU dummy point
-    cl_mem dA[MagmaMaxGPUs];
-    cl_mem dB[MagmaMaxGPUs];
-    for( int dev = 0; dev < ngpu; ++dev ) {
-        dA[dev] = clCreateBuffer(gContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sizeof(int), NULL, NULL);
-        dB[dev] = clCreateBuffer(gContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sizeof(int), NULL, NULL);
-        for( int s = 0; s < nqueue; ++s ) {
-            int t = dev*glog.nqueue + s;
-            clEnqueueCopyBuffer(glog.queues[t], dA[dev], dB[dev], 0, 0, sizeof(int), 0, NULL, &(glog.gpu_first[t]));
-        }
+    g_trace_nqueue = nqueue;
+    g_trace_ntotal = ngpu*nqueue;
+}
+
+
+// ----------------------------------------
+// Starts a CPU span on the calling thread; spans nest.
+void trace_cpu_start( const char* tag, const char* lbl )
+{
+    if ( ! g_trace_enabled )
+        return;
+
+    trace_buffer* tb = trace_get_buffer();
+    if ( tb == NULL )
+        return;
+    int d = tb->cpu_depth++;
+    if ( d < MAX_CPU_DEPTH ) {
+        tb->cpu_start[d] = magma_wtime();
+        magma_strlcpy( tb->cpu_tag  [d], tag, MAX_TAG_LEN   );
+        magma_strlcpy( tb->cpu_label[d], lbl, MAX_LABEL_LEN );
     }
+}
 
-    // sync again
-    for( int dev = 0; dev < ngpu; ++dev ) {
-        for( int s = 0; s < nqueue; ++s ) {
-            int t = dev*glog.nqueue + s;
-            clFinish(glog.queues[t]);
-        }
+
+// ----------------------------------------
+// Ends the innermost CPU span of the calling thread.
+void trace_cpu_end()
+{
+    if ( ! g_trace_enabled )
+        return;
+
+    trace_buffer* tb = trace_get_buffer();
+    if ( tb == NULL || tb->cpu_depth == 0 )
+        return;
+    int d = --tb->cpu_depth;
+    if ( d < MAX_CPU_DEPTH ) {
+        trace_record* rec = trace_next_record( tb );
+        rec->kind      = TRACE_CPU;
+        rec->depth     = d;
+        rec->cpu_start = tb->cpu_start[d];
+        rec->cpu_end   = magma_wtime();
+        rec->queue     = NULL;
+        rec->device    = NULL;
+        magma_strlcpy( rec->tag,   tb->cpu_tag  [d], MAX_TAG_LEN   );
+        magma_strlcpy( rec->label, tb->cpu_label[d], MAX_LABEL_LEN );
+        trace_push( tb );
     }
-    glog.cpu_first = magma_wtime();
+}
+
+
+// ----------------------------------------
+// Labels the next command this thread enqueues through the set/get or BLAS
+// wrappers with label, instead of its function name; the command keeps its
+// "transfer" or "kernel" category.
+// Returns NULL, so it can be passed as the event of an _async call.
+magma_event_t*
+trace_gpu_event( const char* lbl )
+{
+    if ( ! g_trace_enabled )
+        return NULL;
 
-    for( int dev = 0; dev < ngpu; ++dev ) {
-        clReleaseMemObject(dA[dev]);
-        clReleaseMemObject(dB[dev]);
+    trace_buffer* tb = trace_get_buffer();
+    if ( tb != NULL ) {
+        magma_strlcpy( tb->next_label, lbl, MAX_LABEL_LEN );
     }
+    return NULL;
 }
 
 
 // ----------------------------------------
-void trace_cpu_start( int core, const char* tag, const char* lbl )
+// Starts a GPU span on queue s of device dev, covering the commands
+// enqueued on it until trace_gpu_end.
+void trace_gpu_start( int dev, int s, const char* tag, const char* lbl )
 {
-    int id = glog.cpu_id[core];
-    glog.cpu_start[core][id] = magma_wtime();
-    magma_strlcpy( glog.cpu_tag  [core][id], tag, MAX_LABEL_LEN );
-    magma_strlcpy( glog.cpu_label[core][id], lbl, MAX_LABEL_LEN );
+    if ( ! g_trace_enabled )
+        return;
+
+    int t = dev*g_trace_nqueue + s;
+    trace_buffer* tb = trace_get_buffer();
+    if ( tb == NULL || t < 0 || t >= g_trace_ntotal )
+        return;
+    if ( tb->gpu_start[t] != NULL ) {
+        clReleaseEvent( tb->gpu_start[t] );  // unmatched start
+        tb->gpu_start[t] = NULL;
+    }
+    clEnqueueMarkerWithWaitList( g_trace_queues[t], 0, NULL, &tb->gpu_start[t] );
+    magma_strlcpy( tb->gpu_tag  [t], tag, MAX_TAG_LEN   );
+    magma_strlcpy( tb->gpu_label[t], lbl, MAX_LABEL_LEN );
 }
 
 
 // ----------------------------------------
-void trace_cpu_end( int core )
+// Ends the GPU span on queue s of device dev.
+void trace_gpu_end( int dev, int s )
 {
-    int id = glog.cpu_id[core];
-    glog.cpu_end[core][id] = magma_wtime();
-    if ( id+1 < MAX_EVENTS ) {
-        glog.cpu_id[core] = id+1;
+    if ( ! g_trace_enabled )
+        return;
+
+    int t = dev*g_trace_nqueue + s;
+    trace_buffer* tb = trace_get_buffer();
+    if ( tb == NULL || t < 0 || t >= g_trace_ntotal || tb->gpu_start[t] == NULL )
+        return;
+
+    cl_event marker = NULL;
+    if ( clEnqueueMarkerWithWaitList( g_trace_queues[t], 0, NULL, &marker ) != CL_SUCCESS ) {
+        clReleaseEvent( tb->gpu_start[t] );
+        tb->gpu_start[t] = NULL;
+        return;
     }
-    else {
-        fprintf( stderr, "Error in %s: not enough CPU events.\n", __func__ );
+    trace_record* rec = trace_next_record( tb );
+    rec->kind      = TRACE_SPAN;
+    rec->depth     = 0;
+    rec->queue     = g_trace_queues[t];
+    rec->device    = trace_queue_device( rec->queue );
+    rec->ev_start  = tb->gpu_start[t];
+    rec->ev_end    = marker;
+    magma_strlcpy( rec->tag,   tb->gpu_tag  [t], MAX_TAG_LEN   );
+    magma_strlcpy( rec->label, tb->gpu_label[t], MAX_LABEL_LEN );
+    tb->gpu_start[t] = NULL;
+    trace_push( tb );
+}
+
+
+// ----------------------------------------
+// Returns the event pointer to pass to a clEnqueue* or BLAS call, whose
+// command trace_command then records: event itself if it is not NULL,
+// otherwise, while tracing or timing kernels (see magma_stats.h), a slot of
+// the calling thread.
+magma_event_t*
+trace_event( magma_event_t* event )
+{
+    if ( ! g_trace_enabled && ! magma_stats_kernel_time() )
+        return event;
+
+    trace_buffer* tb = trace_get_thread();
+    if ( tb == NULL )
+        return event;
+    if ( event == NULL ) {
+        tb->slot = NULL;
+        event = &tb->slot;
     }
+    tb->pending = event;
+    return event;
 }
 
 
 // ----------------------------------------
-// pass returned event into kernels to profile
-magma_event_t* 
-trace_next_gpu_event( int dev, int s )
+// Records the command enqueued on queue with the event from trace_event,
+// and counts it in the performance counters and notes the queue's use for
+// the memory pool, which are done even when tracing is off.
+// tag is "transfer" or "kernel"; label is usually __func__.
+void trace_command( magma_queue_t queue, const char* tag, const char* lbl )
 {
-    int t = dev*glog.nqueue + s;
-    int id = glog.gpu_id[t];
-    glog.gpu_end[t][id] = NULL;
-    magma_event_t* re_ptr = &(glog.gpu_end[t][id]);
-    if ( id+1 < MAX_EVENTS ) {
-        glog.gpu_id[t] = id+1;
+    g_runtime.get_mempool().note_use( queue );
+
+    if ( ! g_trace_enabled && ! magma_stats_kernel_time() ) {
+        magma_stats_command( queue, tag, NULL );
+        return;
+    }
+
+    trace_buffer* tb = trace_get_thread();
+    if ( tb == NULL || tb->pending == NULL ) {
+        magma_stats_command( queue, tag, NULL );
+        return;
+    }
+
+    cl_event event = *tb->pending;
+    bool owned = (tb->pending == &tb->slot);
+    tb->pending = NULL;
+    tb->slot    = NULL;
+    magma_stats_command( queue, tag, event );
+    if ( event == NULL )
+        return;
+
+    if ( ! g_trace_enabled || trace_get_buffer() == NULL ) {
+        if ( owned ) {
+            clReleaseEvent( event );
+        }
+        return;
+    }
+    if ( ! owned ) {
+        clRetainEvent( event );
+    }
+
+    trace_record* rec = trace_next_record( tb );
+    rec->kind      = TRACE_COMMAND;
+    rec->depth     = 0;
+    rec->queue     = queue;
+    rec->device    = trace_queue_device( queue );
+    rec->ev_start  = event;
+    magma_strlcpy( rec->tag, tag, MAX_TAG_LEN );
+    if ( tb->next_label[0] != '\0' ) {
+        magma_strlcpy( rec->label, tb->next_label, MAX_LABEL_LEN );
+        tb->next_label[0] = '\0';
     }
     else {
-        fprintf( stderr, "Error in %s: not enough GPU events (dev %d, queue %d).\n", __func__, dev, s );
+        magma_strlcpy( rec->label, lbl, MAX_LABEL_LEN );
     }
-    return re_ptr;
+    trace_push( tb );
 }
 
 
 // ----------------------------------------
-void trace_gpu_start( int dev, int s, const char* tag, const char* lbl )
+// Records that queue waits on marker, through barrier, the barrier that
+// magma_queue_wait_event enqueued on queue. The trace draws a flow arrow
+// from the last command before marker on its queue to the first command
+// after barrier.
+void trace_wait( magma_queue_t queue, cl_event marker, cl_event barrier )
 {
-    int t = dev*glog.nqueue + s;
-    int id = glog.gpu_id[t];
-#if TRACE_METHOD == 2
-    glog.gpu_start[t][id] = magma_wtime();
-#else
-    #ifdef HAVE_CUBLAS
-    cudaEventCreate( &glog.gpu_start[t][id] );
-    cudaEventRecord(  glog.gpu_start[t][id], glog.streams[t] );
-    #endif
-#endif
-    magma_strlcpy( glog.gpu_tag  [t][id], tag, MAX_LABEL_LEN );
-    magma_strlcpy( glog.gpu_label[t][id], lbl, MAX_LABEL_LEN );
-
-    magma_setevent( trace_next_gpu_event( dev, s ) );
-    return;
+    if ( ! g_trace_enabled )
+        return;
+
+    trace_buffer* tb = trace_get_buffer();
+    if ( tb == NULL )
+        return;
+    clRetainEvent( marker  );
+    clRetainEvent( barrier );
+    trace_record* rec = trace_next_record( tb );
+    rec->kind      = TRACE_WAIT;
+    rec->depth     = 0;
+    rec->queue     = queue;
+    rec->device    = trace_queue_device( queue );
+    rec->ev_start  = marker;
+    rec->ev_end    = barrier;
+    magma_strlcpy( rec->tag,   "wait", MAX_TAG_LEN   );
+    magma_strlcpy( rec->label, "magma_queue_wait_event", MAX_LABEL_LEN );
+    trace_push( tb );
+}
+
+
+// ----------------------------------------
+// Records that the calling thread waited on marker, from cpu_start until
+// now, in magma_event_sync. The trace shows the wait as a CPU span, with a
+// flow arrow to it from the last command before marker on its queue.
+void trace_sync( cl_event marker, double cpu_start )
+{
+    if ( ! g_trace_enabled )
+        return;
+
+    trace_buffer* tb = trace_get_buffer();
+    if ( tb == NULL )
+        return;
+    clRetainEvent( marker );
+    trace_record* rec = trace_next_record( tb );
+    rec->kind      = TRACE_SYNC;
+    rec->depth     = tb->cpu_depth;
+    rec->cpu_start = cpu_start;
+    rec->cpu_end   = magma_wtime();
+    rec->queue     = NULL;
+    rec->device    = NULL;
+    rec->ev_start  = marker;
+    magma_strlcpy( rec->tag,   "sync", MAX_TAG_LEN   );
+    magma_strlcpy( rec->label, "magma_event_sync", MAX_LABEL_LEN );
+    trace_push( tb );
 }
 
-magma_event_t* 
-trace_gpu_event( int dev, int s, const char* tag, const char* lbl )
+
+// ========================================
+// output
+
+// GPU record with times converted to trace microseconds
+struct trace_gpu_slice
+{
+    double      start;
+    double      end;
+    int         pid;
+    int         tid;
+    bool        command;
+    const char* tag;
+    const char* label;
+};
+
+static bool slice_before( const trace_gpu_slice& a, const trace_gpu_slice& b )
 {
-    int t = dev*glog.nqueue + s;
-    int id = glog.gpu_id[t];
-#if TRACE_METHOD == 2
-    glog.gpu_start[t][id] = magma_wtime();
-#else
-    #ifdef HAVE_CUBLAS
-    cudaEventCreate( &glog.gpu_start[t][id] );
-    cudaEventRecord(  glog.gpu_start[t][id], glog.streams[t] );
-    #endif
-#endif
-    magma_strlcpy( glog.gpu_tag  [t][id], tag, MAX_LABEL_LEN );
-    magma_strlcpy( glog.gpu_label[t][id], lbl, MAX_LABEL_LEN );
-
-    return trace_next_gpu_event( dev, s );
+    if ( a.pid != b.pid ) return a.pid < b.pid;
+    if ( a.tid != b.tid ) return a.tid < b.tid;
+    return a.start < b.start;
 }
 
+// wait of a queue (TRACE_WAIT) or CPU thread (TRACE_SYNC) on a marker
+struct trace_flow
+{
+    cl_event      marker;
+    cl_event      barrier;  // wait: barrier on the waiting queue
+    int           tid;      // sync: waiting thread
+    double        start;    // sync: start of the wait, in trace microseconds
+    const char*   name;
+};
+
+// GPU pids and tids, and clock offsets, assigned while reading the records
+struct trace_gpu_ids
+{
+    std::map< cl_device_id, int >    device_pid;
+    std::map< cl_device_id, double > device_offset;
+    std::map< magma_queue_t, int >   queue_tid;
+};
+
 
 // ----------------------------------------
-void trace_finalize( const char* filename, const char* cssfile )
+// Gets the pid and tid of the queue that event was enqueued on, and the
+// event's end in trace microseconds. Returns false if the queue has no
+// traced commands or is not profiled.
+static bool trace_event_end( cl_event event, const trace_gpu_ids& ids,
+                             int* pid, int* tid, double* end )
 {
-    // these are all in SVG "pixels"
-    double xscale = 200.; // pixels per second
-    double height = 20.;  // of each row
-    double margin =  5.;  // page margin and between some elements
-    double space  =  2.;  // between rows
-    double pad    =  5.;  // around text
-    double label  = 75.;  // width of "CPU:", "GPU:" labels
-    double left   = 2*margin + label;
-    double xtick  = 0.5;  // interval of xticks (in seconds)
+    magma_queue_t queue = NULL;
+    cl_ulong ns;
+    clWaitForEvents( 1, &event );
+    if ( clGetEventInfo( event, CL_EVENT_COMMAND_QUEUE, sizeof(queue), &queue, NULL ) != CL_SUCCESS ||
+         clGetEventProfilingInfo( event, CL_PROFILING_COMMAND_END, sizeof(ns), &ns, NULL ) != CL_SUCCESS ) {
+        return false;
+    }
+    std::map< magma_queue_t, int >::const_iterator q = ids.queue_tid.find( queue );
+    if ( q == ids.queue_tid.end() )
+        return false;
+    cl_device_id device = trace_queue_device( queue );
+    double offset = ids.device_offset.find( device )->second - g_trace_first;
+    *pid = ids.device_pid.find( device )->second;
+    *tid = q->second;
+    *end = (ns*1e-9 + offset)*1e6;
+    return true;
+}
+
+
+// ----------------------------------------
+// Writes a flow arrow from slice src to the slice enclosing time ts on pid, tid.
+static void trace_put_flow( FILE* file, const trace_gpu_slice& src,
+                            int pid, int tid, double ts,
+                            const char* name, int id )
+{
+    fprintf( file, ",\n{\"ph\": \"s\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f,"
+             " \"id\": %d, \"cat\": \"dependency\", \"name\": \"%s\"}",
+             src.pid, src.tid, src.start, id, name );
+    fprintf( file, ",\n{\"ph\": \"f\", \"bp\": \"e\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f,"
+             " \"id\": %d, \"cat\": \"dependency\", \"name\": \"%s\"}",
+             pid, tid, ts, id, name );
+}
+
+
+// ----------------------------------------
+// Returns offset in seconds from device's profiling clock to magma_wtime,
+// by timing a marker on a new profiling queue; context is from event.
+static double trace_clock_offset( cl_device_id device, cl_event event )
+{
+    cl_context context = NULL;
+    cl_int err = clGetEventInfo( event, CL_EVENT_CONTEXT, sizeof(context), &context, NULL );
+    if ( err != CL_SUCCESS )
+        return 0;
+
+    cl_command_queue queue = clCreateCommandQueue( context, device, CL_QUEUE_PROFILING_ENABLE, &err );
+    if ( err != CL_SUCCESS )
+        return 0;
+
+    double offset = 0;
+    cl_event marker;
+    cl_ulong end;
+    if ( clEnqueueMarkerWithWaitList( queue, 0, NULL, &marker ) == CL_SUCCESS ) {
+        clFinish( queue );
+        double now = magma_wtime();
+        if ( clGetEventProfilingInfo( marker, CL_PROFILING_COMMAND_END,
+                                      sizeof(end), &end, NULL ) == CL_SUCCESS ) {
+            offset = now - end*1e-9;
+        }
+        clReleaseEvent( marker );
+    }
+    clReleaseCommandQueue( queue );
+    return offset;
+}
+
+
+// ----------------------------------------
+// Writes the recorded trace to filename as Chrome trace-event JSON,
+// then discards it. Waits for recorded GPU commands to finish.
+// CPU threads are pid 0; GPU device d is pid d+1, with a tid per queue.
+// Flow arrows connect consecutive transfers and kernels on a queue, and
+// the command an event was recorded after to the queue or thread that
+// waits on it, which shows transfer -> kernel dependencies across queues.
+void trace_finalize( const char* filename )
+{
+    if ( ! g_trace_enabled || filename == NULL )
+        return;
+
     char buf[ 1024 ];
-    magma_event_t prof_event;
-    
-    double time = magma_wtime() - glog.cpu_first;
-    
     FILE* trace_file = fopen( filename, "w" );
     if ( trace_file == NULL ) {
         strerror_r( errno, buf, sizeof(buf) );
@@ -217,163 +625,191 @@ void trace_finalize( const char* filename, const char* cssfile )
         return;
     }
     fprintf( stderr, "writing trace to '%s'\n", filename );
-    
-    // row for each CPU and GPU/queue (with space between), time scale, legend
-    // 4 margins: at top, above time scale, above legend, at bottom
-    int h = (int)( (glog.ncore + glog.ngpu*glog.nqueue)*(height + space) - space + 2*height + 4*margin );
-    int w = (int)( left + time*xscale + margin );
-    fprintf( trace_file,
-             "<?xml version=\"1.0\" standalone=\"no\"?>\n"
-             "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\"\n"
-             "    \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n\n"
-             "<svg version=\"1.1\" baseProfile=\"full\"\n"
-             "    xmlns=\"http://www.w3.org/2000/svg\"\n"
-             "    xmlns:inkscape=\"http://www.inkscape.org/namespaces/inkscape\"\n"
-             "    viewBox=\"0 0 %d %d\" width=\"%d\" height=\"%d\" preserveAspectRatio=\"none\">\n\n",
-             w, h, w, h );
-    
-    // Inkscape does not currently (Jan 2012) support external CSS;
-    // see http://wiki.inkscape.org/wiki/index.php/CSS_Support
-    // So embed CSS file here
-    FILE* css_file = fopen( cssfile, "r" );
-    if ( css_file == NULL ) {
-        strerror_r( errno, buf, sizeof(buf) );
-        fprintf( stderr, "Can't open file '%s': %s; skipping CSS\n", cssfile, buf );
-    }
-    else {
-        fprintf( trace_file, "<style type=\"text/css\">\n" );
-        while( fgets( buf, sizeof(buf), css_file ) != NULL ) {
-            fputs( buf, trace_file );
+
+    trace_gpu_ids                    ids;
+    std::map< int, int >             pid_nqueue;
+    std::vector< trace_gpu_slice >   slices;
+    std::vector< trace_flow >        flows;
+
+    fprintf( trace_file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n" );
+    fprintf( trace_file, "{\"ph\": \"M\", \"pid\": 0, \"name\": \"process_name\", \"args\": {\"name\": \"CPU\"}}" );
+
+    pthread_mutex_lock( &g_trace_mutex );
+    for( trace_buffer* tb = g_trace_buffers; tb != NULL; tb = tb->next ) {
+        long count = tb->count;
+        long n     = min( count, tb->capacity );
+        long first = count - n;
+        if ( count > tb->capacity ) {
+            fprintf( stderr, "WARNING: trace of thread %d overwrote its oldest %ld of %ld events;"
+                     " set $MAGMA_TRACE_EVENTS to keep more.\n",
+                     tb->tid, count - tb->capacity, count );
         }
-        fclose( css_file );
-        fprintf( trace_file, "</style>\n\n" );
-    }
-    
-    // format takes: x, y, width, height, class (tag), id (label)
-    const char* format =
-        "<rect x=\"%8.3f\" y=\"%4.0f\" width=\"%8.3f\" height=\"%2.0f\" class=\"%-8s\" inkscape:label=\"%s\"/>\n";
-    
-    // accumulate unique legend entries
-    std::set< std::string > legend;
-    
-    // output CPU events
-    double top = margin;
-    for( int core = 0; core < glog.ncore; ++core ) {
-        if ( glog.cpu_id[core] > MAX_EVENTS ) {
-            glog.cpu_id[core] += 1;  // count last event
-            fprintf( stderr, "WARNING: trace on core %d, reached limit of %d events; output will be truncated.\n",
-                     core, glog.cpu_id[core] );
+        fprintf( trace_file, ",\n{\"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"name\": \"thread_name\","
+                 " \"args\": {\"name\": \"thread %d\"}}", tb->tid, tb->tid );
+
+        for( long i = first; i < count; ++i ) {
+            trace_record* rec = &tb->records[ i % tb->capacity ];
+            if ( rec->kind == TRACE_WAIT ) {
+                trace_flow flow;
+                flow.marker  = rec->ev_start;
+                flow.barrier = rec->ev_end;
+                flow.tid     = 0;
+                flow.start   = 0;
+                flow.name    = rec->tag;
+                flows.push_back( flow );
+                continue;
+            }
+            if ( rec->kind == TRACE_CPU || rec->kind == TRACE_SYNC ) {
+                fprintf( trace_file, ",\n{\"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"cat\": ",
+                         tb->tid,
+                         (rec->cpu_start - g_trace_first)*1e6,
+                         (rec->cpu_end - rec->cpu_start)*1e6 );
+                magma_fput_json( trace_file, rec->tag );
+                fprintf( trace_file, ", \"name\": " );
+                magma_fput_json( trace_file, rec->label );
+                fprintf( trace_file, ", \"args\": {\"depth\": %d}}", rec->depth );
+                if ( rec->kind == TRACE_SYNC ) {
+                    trace_flow flow;
+                    flow.marker  = rec->ev_start;
+                    flow.barrier = NULL;
+                    flow.tid     = tb->tid;
+                    flow.start   = (rec->cpu_start - g_trace_first)*1e6;
+                    flow.name    = rec->tag;
+                    flows.push_back( flow );
+                }
+                continue;
+            }
+
+            // GPU span or command
+            cl_event ev_end = (rec->kind == TRACE_SPAN ? rec->ev_end : rec->ev_start);
+            cl_profiling_info start_info = (rec->kind == TRACE_SPAN ? CL_PROFILING_COMMAND_END
+                                                                    : CL_PROFILING_COMMAND_START);
+            cl_ulong start, end;
+            clWaitForEvents( 1, &ev_end );
+            if ( clGetEventProfilingInfo( rec->ev_start, start_info,
+                                          sizeof(start), &start, NULL ) != CL_SUCCESS ||
+                 clGetEventProfilingInfo( ev_end, CL_PROFILING_COMMAND_END,
+                                          sizeof(end), &end, NULL ) != CL_SUCCESS ) {
+                continue;  // queue without profiling
+            }
+            if ( ids.device_pid.count( rec->device ) == 0 ) {
+                int pid = (int) ids.device_pid.size() + 1;
+                ids.device_pid[ rec->device ]    = pid;
+                ids.device_offset[ rec->device ] = trace_clock_offset( rec->device, rec->ev_start );
+                char name[ 256 ];
+                clGetDeviceInfo( rec->device, CL_DEVICE_NAME, sizeof(name), name, NULL );
+                name[ sizeof(name)-1 ] = '\0';
+                snprintf( buf, sizeof(buf), "GPU %d: %s", pid-1, name );
+                fprintf( trace_file, ",\n{\"ph\": \"M\", \"pid\": %d, \"name\": \"process_name\","
+                         " \"args\": {\"name\": ", pid );
+                magma_fput_json( trace_file, buf );
+                fprintf( trace_file, "}}" );
+            }
+            int pid = ids.device_pid[ rec->device ];
+            if ( ids.queue_tid.count( rec->queue ) == 0 ) {
+                int tid = pid_nqueue[ pid ]++;
+                ids.queue_tid[ rec->queue ] = tid;
+                fprintf( trace_file, ",\n{\"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"name\": \"thread_name\","
+                         " \"args\": {\"name\": \"queue %d\"}}", pid, tid, tid );
+            }
+            double offset = ids.device_offset[ rec->device ] - g_trace_first;
+
+            trace_gpu_slice slice;
+            slice.start   = (start*1e-9 + offset)*1e6;
+            slice.end     = (end  *1e-9 + offset)*1e6;
+            slice.pid     = pid;
+            slice.tid     = ids.queue_tid[ rec->queue ];
+            slice.command = (rec->kind == TRACE_COMMAND);
+            slice.tag     = rec->tag;
+            slice.label   = rec->label;
+            slices.push_back( slice );
         }
-        fprintf( trace_file, "<!-- core %d, nevents %d -->\n", core, glog.cpu_id[core] );
-        fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"core %d\">\n", core );
-        fprintf( trace_file, "<text x=\"%8.3f\" y=\"%4.0f\" width=\"%4.0f\" height=\"%2.0f\">CPU %d:</text>\n",
-                 margin,
-                 top + height - pad,
-                 label, height,
-                 core );
-        for( int i = 0; i < glog.cpu_id[core]; ++i ) {
-            double start  = glog.cpu_start[core][i] - glog.cpu_first;
-            double end    = glog.cpu_end  [core][i] - glog.cpu_first;
-            fprintf( trace_file, format,
-                     left + start*xscale,
-                     top,
-                     (end - start)*xscale,
-                     height,
-                     glog.cpu_tag[core][i],
-                     glog.cpu_label[core][i] );
-            legend.insert( glog.cpu_tag[core][i] );
+    }
+
+    // GPU slices, with a flow arrow from each transfer to the next kernel on
+    // its queue, and from each kernel to the next transfer
+    std::sort( slices.begin(), slices.end(), slice_before );
+    int flow_id = 0;
+    const trace_gpu_slice* prev = NULL;
+    for( size_t i = 0; i < slices.size(); ++i ) {
+        const trace_gpu_slice& s = slices[i];
+        fprintf( trace_file, ",\n{\"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"cat\": ",
+                 s.pid, s.tid, s.start, s.end - s.start );
+        magma_fput_json( trace_file, s.tag );
+        fprintf( trace_file, ", \"name\": " );
+        magma_fput_json( trace_file, s.label );
+        fprintf( trace_file, "}" );
+        if ( ! s.command )
+            continue;
+
+        if ( prev != NULL && prev->pid == s.pid && prev->tid == s.tid
+             && strcmp( prev->tag, s.tag ) != 0 ) {
+            trace_put_flow( trace_file, *prev, s.pid, s.tid, s.start, "in-order", flow_id );
+            flow_id += 1;
         }
-        top += (height + space);
-        fprintf( trace_file, "</g>\n\n" );
+        prev = &s;
     }
-    
-    // output GPU events
-    cl_ulong start_time, end_time, first_time;
-    double exec_time;
-    size_t return_bytes;
-    for( int dev = 0; dev < glog.ngpu; ++dev ) {
-        for( int s = 0; s < glog.nqueue; ++s ) {
-            int t = dev*glog.nqueue + s;
-            if ( glog.gpu_id[t] >= MAX_EVENTS-1 ) {
-                glog.gpu_id[t] += 1;  // count last event
-                fprintf( stderr, "WARNING: trace on gpu %d/queue %d reached limit of %d events; output will be truncated.\n",
-                         dev, s, glog.gpu_id[t] );
+
+    // flow arrows for waits, from the last command on the marker's queue
+    // that ended by the marker's end, to the first command on the waiting
+    // queue after its barrier, or to the CPU thread's wait
+    const double tol = 1e-3;  // microseconds
+    for( size_t i = 0; i < flows.size(); ++i ) {
+        const trace_flow& flow = flows[i];
+        trace_gpu_slice key;
+        double end;
+        if ( ! trace_event_end( flow.marker, ids, &key.pid, &key.tid, &end ) )
+            continue;
+        key.start = end + tol;
+        std::vector< trace_gpu_slice >::const_iterator src
+            = std::upper_bound( slices.begin(), slices.end(), key, slice_before );
+        const trace_gpu_slice* producer = NULL;
+        while ( src != slices.begin() ) {
+            --src;
+            if ( src->pid != key.pid || src->tid != key.tid )
+                break;
+            if ( src->command && src->end <= end + tol ) {
+                producer = &*src;
+                break;
             }
-            fprintf( trace_file, "<!-- gpu %d, queue %d (t %d), nevents %d -->\n", dev, s, t, glog.gpu_id[t] );
-            fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"gpu %d queue %d\">\n", dev, s );
-            fprintf( trace_file, "<text x=\"%8.3f\" y=\"%4.0f\" width=\"%4.0f\" height=\"%2.0f\">GPU %d (s%d):</text>\n",
-                     margin,
-                     margin + (dev*glog.nqueue + s + glog.ncore)*(height + space) + height - pad,
-                     label, height,
-                     dev, s );
-            prof_event = glog.gpu_first[t];
-            clGetEventProfilingInfo(prof_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &first_time, &return_bytes);
-          
-            double start, end;
-            for( int i = 0; i < glog.gpu_id[t]; ++i ) {
-                prof_event = glog.gpu_end[t][i];
-                clGetEventProfilingInfo(prof_event, CL_PROFILING_COMMAND_START,
-                                        sizeof(cl_ulong), &start_time, &return_bytes);
-                clGetEventProfilingInfo(prof_event, CL_PROFILING_COMMAND_END,
-                                        sizeof(cl_ulong), &end_time, &return_bytes);
-                // nanoseconds
-                exec_time = (double)(start_time - first_time);
-                start = exec_time * 1e-9;
-
-                exec_time = (double)(end_time - first_time);
-                end = exec_time * 1e-9;
-
-                fprintf( trace_file, format,
-                         left + start*xscale,
-                         top,
-                         (end - start)*xscale,
-                         height,
-                         glog.gpu_tag[t][i],
-                         glog.gpu_label[t][i] );
-                legend.insert( glog.gpu_tag[t][i] );
+        }
+        if ( producer == NULL )
+            continue;
+
+        if ( flow.barrier == NULL ) {
+            trace_put_flow( trace_file, *producer, 0, flow.tid, flow.start, flow.name, flow_id );
+            flow_id += 1;
+            continue;
+        }
+        if ( ! trace_event_end( flow.barrier, ids, &key.pid, &key.tid, &end ) )
+            continue;
+        key.start = end - tol;
+        std::vector< trace_gpu_slice >::const_iterator dst
+            = std::lower_bound( slices.begin(), slices.end(), key, slice_before );
+        for( ; dst != slices.end() && dst->pid == key.pid && dst->tid == key.tid; ++dst ) {
+            if ( dst->command ) {
+                trace_put_flow( trace_file, *producer, dst->pid, dst->tid, dst->start,
+                                flow.name, flow_id );
+                flow_id += 1;
+                break;
             }
-            top += (height + space);
-            fprintf( trace_file, "</g>\n\n" );
         }
     }
-    
-    // output time scale
-    top += (-space + margin);
-    fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"scale\">\n" );
-    fprintf( trace_file, "<text x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\">Time (sec):</text>\n",
-             margin, top + height - pad, label, height );
-    for( double s=0; s < time; s += xtick ) {
-        fprintf( trace_file,
-            "<line x1=\"%8.1f\" y1=\"0\" x2=\"%8.1f\" y2=\"%4.0f\"/>"
-            "<text x=\"%8.1f\" y=\"%4.0f\">%4.1f</text>\n",
-            left + s*xscale,
-            left + s*xscale,
-            top,
-            left + s*xscale,
-            top + height - pad,
-            s );
-    }
-    fprintf( trace_file, "</g>\n\n" );
-    top += (height + margin);
-    
-    // output legend
-    fprintf( trace_file, "<g inkscape:groupmode=\"layer\" inkscape:label=\"legend\">\n" );
-    fprintf( trace_file, "<text x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\">Legend:</text>\n",
-             margin, top + height - pad, label, height );
-    double x=left;
-    for( std::set<std::string>::iterator it=legend.begin(); it != legend.end(); ++it ) {
-        fprintf( trace_file,
-            "<rect x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\" class=\"%s\"/>"
-            "<text x=\"%8.1f\" y=\"%4.0f\" width=\"%2.0f\" height=\"%2.0f\">%s</text>",
-            x,       top,                label, height, (*it).c_str(),
-            x + pad, top + height - pad, label, height, (*it).c_str() );
-        x += label + margin;
-    }
-    fprintf( trace_file, "</g>\n\n" );
-    
-    fprintf( trace_file, "</svg>\n" );
-    
+    fprintf( trace_file, "\n]}\n" );
     fclose( trace_file );
-}
 
-#endif // TRACING
+    // discard records
+    for( trace_buffer* tb = g_trace_buffers; tb != NULL; tb = tb->next ) {
+        long count = tb->count;
+        long n = min( count, tb->capacity );
+        for( long i = 0; i < n; ++i ) {
+            trace_record* rec = &tb->records[i];
+            if ( rec->ev_start != NULL ) clReleaseEvent( rec->ev_start );
+            if ( rec->ev_end   != NULL ) clReleaseEvent( rec->ev_end   );
+            rec->ev_start = NULL;
+            rec->ev_end   = NULL;
+        }
+        tb->count = 0;
+    }
+    pthread_mutex_unlock( &g_trace_mutex );
+}
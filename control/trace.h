@@ -14,40 +14,56 @@
 #include "common_magma.h"
 
 // ----------------------------------------
-const int MAX_CORES       = 1;                 // CPU cores
+// Tracing of CPU tasks and GPU commands, written as Chrome trace-event JSON,
+// which chrome://tracing and https://ui.perfetto.dev display.
+//
+// Tracing is off unless $MAGMA_TRACE is set to an output file name when
+// magma_init is called; magma_finalize writes the trace there. While tracing,
+// queues are created with CL_QUEUE_PROFILING_ENABLE, and every transfer and
+// BLAS command enqueued through the magma_*set*, magma_*get*, and magma_z*
+// BLAS wrappers is recorded, with flow arrows between consecutive transfers
+// and kernels on a queue, and from the command an event was recorded after
+// to the queue (magma_queue_wait_event) or thread (magma_event_sync) that
+// waits on it. Routines add CPU spans with trace_cpu_start/end,
+// which nest, and GPU spans covering several commands with
+// trace_gpu_start/end.
+//
+// Each thread records into its own ring buffer of $MAGMA_TRACE_EVENTS
+// entries (default 65536), without locking; when full, the oldest entries
+// are overwritten. The trace must be written while no thread is recording.
+//
+// When tracing is off, each function returns after testing one flag, except
+// that trace_event and trace_command also serve the performance counters
+// (see magma_stats.h), which count every command.
+
 const int MAX_GPU_QUEUES  = MagmaMaxGPUs * 4;  // #devices * #queues per device
-const int MAX_EVENTS      = 20000;
-const int MAX_LABEL_LEN   = 16;
+const int MAX_TAG_LEN     = 16;
+const int MAX_LABEL_LEN   = 64;
 
+extern bool g_trace_enabled;
 
-// ----------------------------------------
-#ifdef TRACING
+inline bool trace_enabled() { return g_trace_enabled; }
 
-void trace_init     ( int ncore, int ngpu, int nqueue, magma_queue_t *queues );
+void trace_startup  ();
+void trace_shutdown ();
 
-void trace_cpu_start( int core, const char* tag, const char* label );
-void trace_cpu_end  ( int core );
+void trace_init     ( int ngpu, int nqueue, magma_queue_t *queues );
+
+void trace_cpu_start( const char* tag, const char* label );
+void trace_cpu_end  ();
 
 magma_event_t*
-     trace_gpu_event( int dev, int queue_num, const char* tag, const char* label );
+     trace_gpu_event( const char* label );
 void trace_gpu_start( int dev, int queue_num, const char* tag, const char* label );
 void trace_gpu_end  ( int dev, int queue_num );
 
-void trace_finalize ( const char* filename, const char* cssfile );
-
-#else
-
-#define trace_init(      x1, x2, x3, x4 ) ((void)(0))
-
-#define trace_cpu_start( x1, x2, x3     ) ((void)(0))
-#define trace_cpu_end(   x1             ) ((void)(0))
-
-#define trace_gpu_event( x1, x2, x3, x4 ) (NULL)
-#define trace_gpu_start( x1, x2, x3, x4 ) ((void)(0))
-#define trace_gpu_end(   x1, x2         ) ((void)(0))
+magma_event_t*
+     trace_event    ( magma_event_t* event );
+void trace_command  ( magma_queue_t queue, const char* tag, const char* label );
 
-#define trace_finalize(  x1, x2         ) ((void)(0))
+void trace_wait     ( magma_queue_t queue, cl_event marker, cl_event barrier );
+void trace_sync     ( cl_event marker, double cpu_start );
 
-#endif
+void trace_finalize ( const char* filename );
 
 #endif        //  #ifndef TRACE_H
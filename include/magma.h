@@ -42,12 +42,18 @@ magma_int_t magma_get_smlsize_divideconquer();
 magma_int_t
 magma_init( void );
 
+magma_int_t
+magma_init_subdevices( const char* partition );
+
 magma_int_t
 magma_init_1(std::vector<cl_device_id> devices, cl_context context);
 
 magma_int_t
 magma_init_opencl( cl_platform_id platform, cl_context context, magma_int_t setup_clBlas );
 
+magma_int_t
+magma_warmup( const char* routines );
+
 magma_int_t
 magma_finalize( void );
 
@@ -65,8 +71,11 @@ magma_malloc( magma_ptr *ptrPtr, size_t bytes );
 magma_int_t
 magma_malloc_cpu( void **ptrPtr, size_t bytes );
 
-//magma_int_t
-//magma_malloc_pinned( void **ptrPtr, size_t bytes );
+magma_int_t
+magma_malloc_pinned( void **ptrPtr, size_t bytes );
+
+magma_int_t
+magma_malloc_pinned_device( magma_device_t device, void **ptrPtr, size_t bytes );
 
 magma_int_t
 magma_free( magma_ptr ptr );
@@ -74,8 +83,27 @@ magma_free( magma_ptr ptr );
 magma_int_t
 magma_free_cpu( void *ptr );
 
-//magma_int_t
-//magma_free_pinned( void *ptr );
+magma_int_t
+magma_free_pinned( void *ptr );
+
+// device memory pool used by magma_malloc and magma_free.
+// Sizes are in bytes, rounded up to the pool's size classes.
+typedef struct {
+    size_t bytes_in_use;     // allocated by magma_malloc and not yet freed
+    size_t bytes_cached;     // freed and held in the pool for reuse
+    size_t high_water_mark;  // max of bytes_in_use + bytes_cached
+    size_t num_allocs;       // number of magma_malloc calls
+    size_t num_hits;         // allocations satisfied from the pool
+    size_t num_frees;        // number of magma_free calls
+    size_t num_trims;        // number of times the pool was emptied
+    int    enabled;          // 0 if disabled by $MAGMA_MEMPOOL=0
+} magma_mempool_stats_t;
+
+magma_int_t
+magma_mempool_trim( void );
+
+magma_int_t
+magma_mempool_stats( magma_mempool_stats_t *stats );
 
 
 // type-safe convenience functions to avoid using (void**) cast and sizeof(...)
@@ -94,12 +122,12 @@ static inline magma_int_t magma_dmalloc_cpu( double             **ptrPtr, size_t
 static inline magma_int_t magma_cmalloc_cpu( magmaFloatComplex  **ptrPtr, size_t n ) { return magma_malloc_cpu( (void**) ptrPtr, n*sizeof(magmaFloatComplex)  ); }
 static inline magma_int_t magma_zmalloc_cpu( magmaDoubleComplex **ptrPtr, size_t n ) { return magma_malloc_cpu( (void**) ptrPtr, n*sizeof(magmaDoubleComplex) ); }
 
-//static inline magma_int_t magma_imalloc_pinned( magma_int_t        **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magma_int_t)        ); }
-//static inline magma_int_t magma_index_malloc_pinned( magma_index_t **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magma_index_t)      ); }
-//static inline magma_int_t magma_smalloc_pinned( float              **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(float)              ); }
-//static inline magma_int_t magma_dmalloc_pinned( double             **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(double)             ); }
-//static inline magma_int_t magma_cmalloc_pinned( magmaFloatComplex  **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magmaFloatComplex)  ); }
-//static inline magma_int_t magma_zmalloc_pinned( magmaDoubleComplex **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magmaDoubleComplex) ); }
+static inline magma_int_t magma_imalloc_pinned( magma_int_t        **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magma_int_t)        ); }
+static inline magma_int_t magma_index_malloc_pinned( magma_index_t **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magma_index_t)      ); }
+static inline magma_int_t magma_smalloc_pinned( float              **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(float)              ); }
+static inline magma_int_t magma_dmalloc_pinned( double             **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(double)             ); }
+static inline magma_int_t magma_cmalloc_pinned( magmaFloatComplex  **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magmaFloatComplex)  ); }
+static inline magma_int_t magma_zmalloc_pinned( magmaDoubleComplex **ptrPtr, size_t n ) { return magma_malloc_pinned( (void**) ptrPtr, n*sizeof(magmaDoubleComplex) ); }
 
 
 // ========================================
@@ -111,20 +139,79 @@ magma_getdevices(
     magma_int_t*    numPtr );
 
 
+// ========================================
+// nb profile support
+magma_int_t
+magma_nb_profile_get( const char* routine, magma_int_t m );
+
+void
+magma_nb_profile_set( const char* routine, magma_int_t m, magma_int_t nb );
+
+magma_int_t
+magma_nb_profile_set_device( magma_device_t device );
+
+void
+magma_nb_profile_enable( magma_bool_t enable );
+
+magma_int_t
+magma_nb_profile_save( void );
+
+
+// ========================================
+// performance counters, per routine and per queue.
+// Counters accumulate from magma_init, or the last magma_stats_reset.
+// kernel_time is 0 unless $MAGMA_STATS_KERNEL_TIME or $MAGMA_TRACE is set.
+typedef struct {
+    char      name[64];         // routine name, or "queue <n>: <device>"
+    long long calls;            // number of calls; 0 for queues
+    long long bytes_h2d;        // bytes transferred host to device
+    long long bytes_d2h;        // bytes transferred device to host
+    long long kernel_launches;  // BLAS kernels enqueued
+    double    kernel_time;      // seconds kernels ran on the device
+    double    cpu_time;         // seconds in CPU panels; 0 for queues
+    long long allocs;           // magma_malloc and magma_malloc_pinned calls; 0 for queues
+} magma_stats_t;
+
+magma_int_t
+magma_stats_get( magma_stats_t* routines, magma_int_t* nroutines,
+                 magma_stats_t* queues,   magma_int_t* nqueues );
+
+void
+magma_stats_reset( void );
+
+magma_int_t
+magma_stats_print_json( const char* filename );
+
+
 // ========================================
 // queue support
 magma_int_t
 magma_queue_meminfo(magma_queue_t queue );
 
+magma_int_t
+magma_queue_local_meminfo( magma_queue_t queue );
+
 magma_int_t
 magma_queue_create( magma_device_t device, magma_queue_t* queuePtr );
 
 magma_int_t
 magma_queue_destroy( magma_queue_t  queue );
 
+magma_int_t
+magma_queues_create_mgpu( magma_int_t ngpu, magma_queue_t* queues );
+
+magma_int_t
+magma_queues_destroy_mgpu( magma_int_t ngpu, magma_queue_t* queues );
+
 magma_int_t
 magma_queue_sync( magma_queue_t queue );
 
+magma_int_t
+magma_queue_get_companion( magma_queue_t queue, magma_queue_t* companionPtr );
+
+magma_int_t
+magma_queue_wait_event( magma_queue_t queue, magma_event_t event );
+
 
 // ========================================
 // event support
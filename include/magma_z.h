@@ -28,6 +28,7 @@ magma_int_t magma_get_dlaex3_m_nb();       // defined in dlaex3_m.cpp
 
 magma_int_t magma_get_zpotrf_nb( magma_int_t m );
 magma_int_t magma_get_zgetrf_nb( magma_int_t m );
+magma_int_t magma_get_zgetrf_lookahead( magma_int_t m, magma_int_t n );
 magma_int_t magma_get_zgetri_nb( magma_int_t m );
 magma_int_t magma_get_zgeqp3_nb( magma_int_t m );
 magma_int_t magma_get_zgeqrf_nb( magma_int_t m );
@@ -43,7 +44,7 @@ magma_int_t magma_get_zgesvd_nb( magma_int_t m );
 magma_int_t magma_get_zhegst_nb_m( magma_int_t m );
 magma_int_t magma_get_zbulge_nb( magma_int_t m, magma_int_t nbthreads );
 magma_int_t magma_get_zbulge_nb_mgpu( magma_int_t m );
-magma_int_t magma_zbulge_get_Vblksiz( magma_int_t m, magma_int_t nb, magma_int_t nbthreads );
+magma_int_t magma_zbulge_get_Vblksiz( magma_int_t m, magma_int_t nb );
 magma_int_t magma_get_zbulge_gcperf();
 
 
@@ -51,6 +52,26 @@ magma_int_t magma_get_zbulge_gcperf();
    -- MAGMA function definitions / Data on CPU (alphabetical order)
 */
 
+magma_int_t
+magma_zgb2bd(
+    magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    double *d, double *e,
+    magmaDoubleComplex *VQ2, magmaDoubleComplex *tauq2,
+    magmaDoubleComplex *VP2, magmaDoubleComplex *taup2,
+    magma_int_t ldtau,
+    magma_int_t wantz,
+    magma_int_t *info);
+
+magma_int_t
+magma_zge2gb(
+    magma_int_t m, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *tauq, magmaDoubleComplex *taup,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    magma_queue_t queue,
+    magma_int_t *info);
+
 magma_int_t
 magma_zgebrd(
     magma_int_t m, magma_int_t n,
@@ -116,6 +137,14 @@ magma_zgeqrf(
     magma_queue_t queues[2],
     magma_int_t *info);
 
+magma_int_t
+magma_zgeqrf_ooc(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex *A,    magma_int_t lda, magmaDoubleComplex *tau,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    magma_queue_t queues[2],
+    magma_int_t *info );
+
 magma_int_t
 magma_zgesdd(
     magma_vec_t jobz, magma_int_t m, magma_int_t n,
@@ -152,6 +181,21 @@ magma_zgesvd(
     magma_queue_t queue,
     magma_int_t *info);
 
+#ifdef COMPLEX
+// only applicable to complex [cz] precisions
+magma_int_t
+magma_zgesvd_2stage(
+    magma_vec_t jobu, magma_vec_t jobvt, magma_int_t m, magma_int_t n,
+    magmaDoubleComplex *A,  magma_int_t lda, double *s,
+    magmaDoubleComplex *U,  magma_int_t ldu,
+    magmaDoubleComplex *VT, magma_int_t ldvt,
+    magma_int_t divconq,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    double *rwork, magma_int_t *iwork,
+    magma_queue_t queue,
+    magma_int_t *info);
+#endif  // COMPLEX
+
 magma_int_t
 magma_zgetrf(
     magma_int_t m, magma_int_t n,
@@ -159,6 +203,13 @@ magma_zgetrf(
     magma_queue_t queues[2],
     magma_int_t *info);
 
+magma_int_t
+magma_zgetrf_m(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex *A, magma_int_t lda, magma_int_t *ipiv,
+    magma_queue_t queues[2],
+    magma_int_t *info);
+
 magma_int_t
 magma_zheevd(
     magma_vec_t jobz, magma_uplo_t uplo, magma_int_t n,
@@ -172,6 +223,33 @@ magma_zheevd(
     magma_queue_t queue,
     magma_int_t *info);
 
+magma_int_t
+magma_zheevd_2stage(
+    magma_vec_t jobz, magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex *A, magma_int_t lda,
+    double *w,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    #ifdef COMPLEX
+    double *rwork, magma_int_t lrwork,
+    #endif
+    magma_int_t *iwork, magma_int_t liwork,
+    magma_queue_t queue,
+    magma_int_t *info);
+
+magma_int_t
+magma_zheevdx(
+    magma_vec_t jobz, magma_range_t range, magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex *A, magma_int_t lda,
+    double vl, double vu, magma_int_t il, magma_int_t iu,
+    magma_int_t *m, double *w,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    #ifdef COMPLEX
+    double *rwork, magma_int_t lrwork,
+    #endif
+    magma_int_t *iwork, magma_int_t liwork,
+    magma_queue_t queue,
+    magma_int_t *info);
+
 magma_int_t
 magma_zhesv(
     magma_uplo_t uplo, magma_int_t n, magma_int_t nrhs,
@@ -190,6 +268,25 @@ magma_zhetrd(
     magma_queue_t queue,
     magma_int_t *info);
 
+magma_int_t
+magma_zhetrd_hb2st(
+    magma_uplo_t uplo, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    double *d, double *e,
+    magmaDoubleComplex *V2, magmaDoubleComplex *tau2, magma_int_t ldtau,
+    magma_int_t wantz,
+    magma_int_t *info);
+
+magma_int_t
+magma_zhetrd_he2hb(
+    magma_uplo_t uplo, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *tau,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    magma_queue_t queue,
+    magma_int_t *info);
+
 magma_int_t
 magma_zhetrf(
     magma_uplo_t uplo, magma_int_t n,
@@ -205,8 +302,24 @@ magma_zhetrf_nopiv(
     magma_queue_t queues[2],
     magma_int_t *info);
 
+#ifdef COMPLEX
+// only applicable to complex [cz] precisions
+magma_int_t
+magma_zhseqr(
+    magma_int_t wantt, magma_int_t wantz, magma_int_t n,
+    magma_int_t ilo, magma_int_t ihi,
+    magmaDoubleComplex *H, magma_int_t ldh,
+    magmaDoubleComplex *w,
+    magmaDoubleComplex *Z, magma_int_t ldz,
+    magma_queue_t queue,
+    magma_int_t *info);
+#endif  // COMPLEX
+
 #ifdef REAL
 // only applicable to real [sd] precisions
+magma_int_t
+magma_get_dlaed3_k();
+
 magma_int_t
 magma_dlaex0(
     magma_int_t n, double *d, double *e,
@@ -223,7 +336,7 @@ magma_dlaex1(
     double *Q, magma_int_t ldq,
     magma_int_t *indxq, double rho, magma_int_t cutpnt,
     double *work, magma_int_t *iwork,
-    magmaDouble_ptr dwork,
+    magmaDouble_ptr dwork, size_t dwork_offset,
     magma_range_t range, double vl, double vu, magma_int_t il, magma_int_t iu,
     magma_queue_t queue,
     magma_int_t *info);
@@ -235,10 +348,15 @@ magma_dlaex3(
     double rho,
     double *dlamda, double *Q2, magma_int_t *indx,
     magma_int_t *ctot, double *w, double *s, magma_int_t *indxq,
-    magmaDouble_ptr dwork,
+    magmaDouble_ptr dwork, size_t dwork_offset,
     magma_range_t range, double vl, double vu, magma_int_t il, magma_int_t iu,
     magma_queue_t queue,
     magma_int_t *info);
+
+void
+magma_dmove_eig(
+    magma_range_t range, magma_int_t n, double *w,
+    magma_int_t *il, magma_int_t *iu, double vl, double vu, magma_int_t *m);
 #endif  // REAL
 
 magma_int_t
@@ -329,6 +447,22 @@ magma_zstedx(
     magma_queue_t queue,
     magma_int_t *info);
 
+#ifdef COMPLEX
+// only applicable to complex [cz] precisions
+magma_int_t
+magma_ztrevc3_mt_gpu(
+    magma_side_t side, magma_vec_t howmany,
+    magma_int_t *select, magma_int_t n,
+    magmaDoubleComplex *T,  magma_int_t ldt,
+    magmaDoubleComplex *VL, magma_int_t ldvl,
+    magmaDoubleComplex *VR, magma_int_t ldvr,
+    magma_int_t mm, magma_int_t *mout,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    double *rwork,
+    magma_queue_t queue,
+    magma_int_t *info);
+#endif  // COMPLEX
+
 magma_int_t
 magma_ztrtri(
     magma_uplo_t uplo, magma_diag_t diag, magma_int_t n,
@@ -421,6 +555,14 @@ magma_zunmtr(
 /* ////////////////////////////////////////////////////////////////////////////
    -- MAGMA function definitions / Data on GPU (alphabetical order)
 */
+magma_int_t
+magma_zbulge_back(
+    magma_int_t n, magma_int_t nb, magma_int_t ne, magma_int_t Vblksiz,
+    magmaDoubleComplex *V2, magmaDoubleComplex *tau2, magma_int_t ldtau,
+    magmaDoubleComplex_ptr dZ, size_t dZ_offset, magma_int_t lddz,
+    magma_queue_t queue,
+    magma_int_t *info);
+
 
 magma_int_t
 magma_zgels_gpu(
@@ -527,6 +669,14 @@ magma_zgetrf_mgpu(
     magma_queue_t queues[],
     magma_int_t *info);
 
+magma_int_t
+magma_zgetrf_tile_mgpu(
+    magma_int_t ngpu,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr d_lA[], size_t dlA_offset, magma_int_t ldda, magma_int_t *ipiv,
+    magma_queue_t queues[],
+    magma_int_t *info);
+
 magma_int_t
 magma_zgetrf_msub(
     magma_trans_t trans, magma_int_t num_subs, magma_int_t ngpu,
@@ -542,6 +692,14 @@ magma_zgetrf2_gpu(
     magma_queue_t queues[],
     magma_int_t *info);
 
+magma_int_t
+magma_zgetrf_lookahead_gpu(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t *ipiv,
+    magma_int_t depth,
+    magma_queue_t queues[2],
+    magma_int_t *info);
+
 magma_int_t
 magma_zgetrf2_mgpu(
     magma_int_t ngpu,
@@ -638,6 +796,14 @@ magma_zpotrf_mgpu(
     magma_queue_t queues[],
     magma_int_t *info);
 
+magma_int_t
+magma_zpotrf_tile_mgpu(
+    magma_int_t ngpu,
+    magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex_ptr d_lA[], size_t dA_offset, magma_int_t ldda,
+    magma_queue_t queues[],
+    magma_int_t *info);
+
 magma_int_t
 magma_zpotrf_msub(
     magma_int_t num_subs, magma_int_t ngpu,
@@ -709,6 +875,17 @@ magma_zunmqr_gpu(
     magma_queue_t queue,
     magma_int_t *info);
 
+magma_int_t
+magma_zunmqr_gpu_2stages(
+    magma_side_t side, magma_trans_t trans,
+    magma_int_t m, magma_int_t n, magma_int_t k,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda,
+    magmaDoubleComplex_ptr dC, size_t dC_offset, magma_int_t lddc,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    magma_int_t nb,
+    magma_queue_t queue,
+    magma_int_t *info);
+
 
 /* ////////////////////////////////////////////////////////////////////////////
    -- MAGMA utility function definitions
@@ -755,6 +932,36 @@ void magma_zq_to_panel(
 }
 #endif
 
+#if defined(__cplusplus) && defined(REAL)
+// Variants for the concurrent tasks of magma_dlaex0, which lock the BLAS
+// kernels they enqueue in pool (see magma_queue_pool in thread_queue.hpp).
+// The C versions above take no pool and lock nothing.
+class magma_queue_pool;
+
+magma_int_t
+magma_dlaex1(
+    magma_int_t n, double *d,
+    double *Q, magma_int_t ldq,
+    magma_int_t *indxq, double rho, magma_int_t cutpnt,
+    double *work, magma_int_t *iwork,
+    magmaDouble_ptr dwork, size_t dwork_offset,
+    magma_range_t range, double vl, double vu, magma_int_t il, magma_int_t iu,
+    magma_queue_t queue, magma_queue_pool* pool,
+    magma_int_t *info);
+
+magma_int_t
+magma_dlaex3(
+    magma_int_t k, magma_int_t n, magma_int_t n1, double *d,
+    double *Q, magma_int_t ldq,
+    double rho,
+    double *dlamda, double *Q2, magma_int_t *indx,
+    magma_int_t *ctot, double *w, double *s, magma_int_t *indxq,
+    magmaDouble_ptr dwork, size_t dwork_offset,
+    magma_range_t range, double vl, double vu, magma_int_t il, magma_int_t iu,
+    magma_queue_t queue, magma_queue_pool* pool,
+    magma_int_t *info);
+#endif
+
 #undef COMPLEX
 
 #endif /* MAGMA_Z_H */
@@ -101,6 +101,7 @@ extern "C" {
 #define lapackf77_zlacrm   FORTRAN_NAME( zlacrm, ZLACRM )
 #define lapackf77_zladiv   FORTRAN_NAME( zladiv, ZLADIV )
 #define lapackf77_zlahef   FORTRAN_NAME( zlahef, ZLAHEF )
+#define lapackf77_zlahqr   FORTRAN_NAME( zlahqr, ZLAHQR )
 #define lapackf77_zlange   FORTRAN_NAME( zlange, ZLANGE )
 #define lapackf77_zlanhe   FORTRAN_NAME( zlanhe, ZLANHE )
 #define lapackf77_zlanht   FORTRAN_NAME( zlanht, ZLANHT )
@@ -712,6 +713,19 @@ void   lapackf77_zlahef( const char *uplo,
                          magmaDoubleComplex *work, const magma_int_t *ldwork,
                          magma_int_t *info );
 
+void   lapackf77_zlahqr( const magma_int_t *wantt, const magma_int_t *wantz,
+                         const magma_int_t *n,
+                         const magma_int_t *ilo, const magma_int_t *ihi,
+                         magmaDoubleComplex *H, const magma_int_t *ldh,
+                         #ifdef COMPLEX
+                         magmaDoubleComplex *w,
+                         #else
+                         double *wr, double *wi,
+                         #endif
+                         const magma_int_t *iloz, const magma_int_t *ihiz,
+                         magmaDoubleComplex *Z, const magma_int_t *ldz,
+                         magma_int_t *info );
+
 double lapackf77_zlange( const char *norm,
                          const magma_int_t *m, const magma_int_t *n,
                          const magmaDoubleComplex *A, const magma_int_t *lda,
@@ -70,6 +70,15 @@ magma_copyvector_async(
     magma_ptr       dy_dst, size_t dy_offset, magma_int_t incy,
     magma_queue_t queue, magma_event_t *event );
 
+// strided copy on the device, in one kernel, for elements of 4, 8, or 16 bytes;
+// returns MAGMA_ERR_NOT_SUPPORTED for other sizes
+magma_int_t
+magmablas_copyvector_async(
+    magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magma_ptr       dy, size_t dy_offset, magma_int_t incy,
+    magma_queue_t queue, magma_event_t *event );
+
 
 // ========================================
 // copying sub-matrices (contiguous columns)
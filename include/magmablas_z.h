@@ -261,6 +261,59 @@ magmablas_zsymmetrize_tiles(
     magma_int_t ntile, magma_int_t mstride, magma_int_t nstride,
     magma_queue_t queue );
 
+  /*
+   * Batched factorizations of small matrices (alphabetical order)
+   */
+magma_int_t
+magma_zgeqrf_batched(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t strideA,
+    magmaDoubleComplex_ptr dtau, size_t dtau_offset,
+    magma_int_t batchCount, magma_queue_t queue );
+
+magma_int_t
+magma_zgeqrf_vbatched(
+    magmaInt_const_ptr dm, magmaInt_const_ptr dn,
+    magma_int_t max_m, magma_int_t max_n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset,
+    magmaInt_const_ptr dA_offsets, magmaInt_const_ptr dldda,
+    magmaDoubleComplex_ptr dtau, size_t dtau_offset,
+    magma_int_t batchCount, magma_queue_t queue );
+
+magma_int_t
+magma_zgetrf_batched(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t strideA,
+    magmaInt_ptr dipiv, size_t dipiv_offset,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue );
+
+magma_int_t
+magma_zgetrf_vbatched(
+    magmaInt_const_ptr dm, magmaInt_const_ptr dn,
+    magma_int_t max_m, magma_int_t max_n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset,
+    magmaInt_const_ptr dA_offsets, magmaInt_const_ptr dldda,
+    magmaInt_ptr dipiv, size_t dipiv_offset,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue );
+
+magma_int_t
+magma_zpotrf_batched(
+    magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda, magma_int_t strideA,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue );
+
+magma_int_t
+magma_zpotrf_vbatched(
+    magma_uplo_t uplo,
+    magmaInt_const_ptr dn, magma_int_t max_n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset,
+    magmaInt_const_ptr dA_offsets, magmaInt_const_ptr dldda,
+    magmaInt_ptr dinfo, size_t dinfo_offset,
+    magma_int_t batchCount, magma_queue_t queue );
+
   /*
    * Level 1 BLAS (alphabetical order)
    */
@@ -400,12 +453,32 @@ magma_zcopymatrix_async(
 // ========================================
 // Level 1 BLAS (alphabetical order)
 
+double
+magma_dzasum(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magma_queue_t queue );
+
+magma_int_t
+magma_dzasum_async(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magmaDouble_ptr dresult, size_t dresult_offset,
+    magma_queue_t queue, magma_event_t *event );
+
 magma_int_t
 magma_izamax(
     magma_int_t n,
-    const magmaDoubleComplex_ptr dx, size_t dx_offset, magma_int_t incx,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
     magma_queue_t queue );
 
+magma_int_t
+magma_izamax_async(
+    magma_int_t n,
+    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
+    magmaInt_ptr dimax, size_t dimax_offset,
+    magma_queue_t queue, magma_event_t *event );
+
 void
 magma_zcopy(
     magma_int_t n,
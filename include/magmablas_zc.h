@@ -35,13 +35,13 @@ magmablas_zaxpycp(
     magmaDoubleComplex_const_ptr b, size_t b_offset,
     magma_queue_t queue );
 
-    // TODO add ldsa                                                                                                           
 void
 magmablas_zclaswp(
     magma_int_t n,
-    magmaDoubleComplex_ptr  A, size_t A_offset, magma_int_t lda,
-    magmaFloatComplex_ptr  SA, size_t SA_offset,
-    magma_int_t m, const magma_int_t *ipiv, magma_int_t incx,
+    magmaDoubleComplex_ptr  A, size_t A_offset,  magma_int_t lda,
+    magmaFloatComplex_ptr  SA, size_t SA_offset, magma_int_t ldsa,
+    magma_int_t m,
+    magmaInt_const_ptr perm, size_t perm_offset, magma_int_t incx,
     magma_queue_t queue );
 
 void
@@ -14,35 +14,56 @@
 #include "clmagma_runtime.h"
 #include "magma.h"
 #include "error.h"
+#include "magma_stats.h"
 
 #ifdef HAVE_clBLAS
 
 // ========================================
 // memory allocation
 // Allocate size bytes on GPU, returning pointer in ptrPtr.
+// Buffers come from the runtime's memory pool, which caches freed buffers
+// for reuse; see clmagma_mempool.
 extern "C" magma_int_t
 magma_malloc( magma_ptr* ptrPtr, size_t size )
 {
     // malloc and free sometimes don't work for size=0, so allocate some minimal size
     if ( size == 0 )
         size = sizeof(magmaDoubleComplex);
-    cl_int err;
-    *ptrPtr = clCreateBuffer( g_runtime.get_context(), CL_MEM_READ_WRITE, size, NULL, &err );
-    if ( err != CLBlastSuccess ) {
-        return MAGMA_ERR_DEVICE_ALLOC;
-    }
-    return MAGMA_SUCCESS;
+    magma_stats_alloc();
+    return g_runtime.get_mempool().malloc( ptrPtr, size );
 }
 
 // --------------------
 // Free GPU memory allocated by magma_malloc.
+// The buffer is returned to the memory pool rather than released. The pool
+// hands it out again only after commands enqueued before the free, on queues
+// from magma_queue_create, are done.
 extern "C" magma_int_t
 magma_free( magma_ptr ptr )
 {
-    cl_int err = clReleaseMemObject( ptr );
-    if ( err != CLBlastSuccess ) {
-        return MAGMA_ERR_INVALID_PTR;
+    return g_runtime.get_mempool().free( ptr );
+}
+
+// --------------------
+// Release all device buffers cached by the memory pool, and all pinned
+// host buffers cached by magma_free_pinned.
+// Buffers currently allocated are not affected.
+extern "C" magma_int_t
+magma_mempool_trim( void )
+{
+    g_runtime.get_pinned().trim();
+    return g_runtime.get_mempool().trim();
+}
+
+// --------------------
+// Get memory pool statistics: bytes in use, bytes cached, high-water mark, etc.
+extern "C" magma_int_t
+magma_mempool_stats( magma_mempool_stats_t* stats )
+{
+    if ( stats == NULL ) {
+        return MAGMA_ERR_ILLEGAL_VALUE;
     }
+    g_runtime.get_mempool().get_stats( stats );
     return MAGMA_SUCCESS;
 }
 
@@ -82,7 +103,7 @@ magma_malloc_cpu( void** ptrPtr, size_t size )
 }
 
 // --------------------
-// Free CPU pinned memory previously allocated by magma_malloc_pinned.
+// Free CPU memory previously allocated by magma_malloc_cpu.
 // The default implementation uses free(), which works for both malloc and posix_memalign.
 // For Windows, _aligned_free() is used.
 extern "C" magma_int_t
@@ -96,4 +117,42 @@ magma_free_cpu( void* ptr )
     return MAGMA_SUCCESS;
 }
 
+// --------------------
+// Allocate size bytes of pinned (page-locked) memory on CPU,
+// returning pointer in ptrPtr.
+// The memory is a CL_MEM_ALLOC_HOST_PTR buffer that remains mapped until
+// freed, so magma_setmatrix, magma_getmatrix, etc. DMA directly to and from
+// it instead of staging through pageable memory.
+// It is mapped for the first device; see magma_malloc_pinned_device.
+// Use magma_free_pinned() to free this memory.
+extern "C" magma_int_t
+magma_malloc_pinned( void** ptrPtr, size_t size )
+{
+    return magma_malloc_pinned_device( NULL, ptrPtr, size );
+}
+
+// --------------------
+// Like magma_malloc_pinned, but maps the memory for the given device,
+// which it is then best transferred to and from.
+extern "C" magma_int_t
+magma_malloc_pinned_device( magma_device_t device, void** ptrPtr, size_t size )
+{
+    // malloc and free sometimes don't work for size=0, so allocate some minimal size
+    if ( size == 0 )
+        size = sizeof(magmaDoubleComplex);
+    magma_stats_alloc();
+    return g_runtime.get_pinned().malloc( ptrPtr, size, device );
+}
+
+// --------------------
+// Free CPU pinned memory previously allocated by magma_malloc_pinned.
+// The memory stays mapped and is cached for reuse by a later
+// magma_malloc_pinned of a similar size for the same device;
+// see magma_mempool_trim.
+extern "C" magma_int_t
+magma_free_pinned( void* ptr )
+{
+    return g_runtime.get_pinned().free( ptr );
+}
+
 #endif // HAVE_clBLAS
@@ -17,6 +17,7 @@
 
 #include "magma.h"
 #include "error.h"
+#include "trace.h"
 
 #define COMPLEX
 #define PRECISION_z
@@ -32,97 +33,6 @@ extern magma_event_t* g_event;
 // ========================================
 // Level 1 BLAS
 
-// --------------------
-/** Returns index of element of vector x having max. absolute value;
-    i.e., max (infinity) norm.
-    
-    @param[in]
-    n       Number of elements in vector x. n >= 0.
-            
-    @param[in]
-    dx      COMPLEX_16 array on GPU device.
-            The n element vector x of dimension (1 + (n-1)*incx).
-            
-    @param[in]
-    incx    Stride between consecutive elements of dx. incx > 0.
-            
-    @ingroup magma_zblas1
-*/
-extern "C" magma_int_t
-magma_izamax(
-    magma_int_t n,
-    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
-    magma_queue_t queue )
-{
-    // match reference BLAS edge cases
-    if ( n <= 0 || incx <= 0 )
-        return 0;
-    
-//printf( "%s queue %p\n", __func__, queue );
-    magmaDoubleComplex hx[10];
-    magma_zgetvector( 1, dx, 0, 1, hx, 1, queue );
-    
-    magma_ptr dimax, scratchBuff;
-    magma_int_t e;
-//printf( "%s malloc n %d, 2*n+1 %d\n", __func__, n, 2*n+1 );
-    e = magma_malloc( &dimax,       sizeof(unsigned int) );
-    check_error( e );
-    e = magma_malloc( &scratchBuff, (2*n+1)*sizeof(magmaDoubleComplex) );
-    check_error( e );
-//printf( "diamax %p, scratchBuff %p\n", dimax, scratchBuff );
-
-    unsigned int imax_cpu = 0;
-    magma_setvector( 1, sizeof(unsigned int), &imax_cpu, 1, dimax, 0, 1, queue );
-    
-//printf( "%s clblasiZamax\n", __func__ );
-    cl_int err = CLBlastiZamax(
-        n, dimax, 0,
-        dx, dx_offset, incx,
-        &queue, g_event);
-    check_error( err );
-    
-//printf( "%s getvector\n", __func__ );
-    magma_getvector( 1, sizeof(unsigned int), dimax, 0, 1, &imax_cpu, 1, queue );
-    clFlush(queue);
-    
-    // work around clBLAS bug: if dx is zero vector it returns 0 instead of 1.
-    if ( imax_cpu == 0 )
-        imax_cpu = 1;
-
-//printf( "%s free\n", __func__ );
-    magma_free( dimax );
-    magma_free( scratchBuff );
-
-//printf( "%s done\n", __func__ );
-    return imax_cpu;
-}
-
-// --------------------
-/** Returns the sum of absolute values of vector x; i.e., one norm.
-
-    @param[in]
-    n       Number of elements in vector x. n >= 0.
-
-    @param[in]
-    dx      COMPLEX_16 array on GPU device.
-            The n element vector x of dimension (1 + (n-1)*incx).
-
-    @param[in]
-    incx    Stride between consecutive elements of dx. incx > 0.
-
-    @ingroup magma_zblas1
-*/
-extern "C" double
-magma_dzasum(
-    magma_int_t n,
-    magmaDoubleComplex_const_ptr dx, size_t dx_offset, magma_int_t incx,
-    magma_queue_t queue )
-{
-    assert( false );
-    // TODO return clblasDzasum( n, dx, dx_offset, incx );
-    return -1;
-}
-
 // --------------------
 /** Constant times a vector plus a vector; \f$ y = \alpha x + y \f$.
 
@@ -160,8 +70,9 @@ magma_zaxpy(
         n, alpha,
         dx, dx_offset, incx,
         dy, dy_offset, incy,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -199,8 +110,9 @@ magma_zcopy(
     cl_int err = CLBlastZcopy( n,
         dx, dx_offset, incx,
         dy, dy_offset, incy,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -355,8 +267,9 @@ magma_zrot(
         dx, dx_offset, incx,
         dy, dy_offset, incy,
         c, s,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 #endif // REAL
 
@@ -406,8 +319,9 @@ magma_zdrot(
         dx, dx_offset, incx,
         dy, dy_offset, incy,
         c, s,
-        &queue, g_event);
+        &queue, trace_event( g_event ));
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 #endif // COMPLEX
 
@@ -430,8 +344,9 @@ magma_zrotm(
         dx, dx_offset, incx,
         dy, dy_offset, incy,
         param, param_offset,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -454,8 +369,9 @@ magma_zrotmg(
         x1, x1_offset,
         y1, y1_offset,
         param, param_offset,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 #endif // REAL
 
@@ -489,9 +405,10 @@ magma_zscal(
 
     cl_int err = CLBlastZscal(
         n, alpha, dx, dx_offset, incx,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 #ifdef COMPLEX
@@ -525,9 +442,10 @@ magma_zdscal(
 
     cl_int err = CLBlastHscal(
         n, alpha, dx, dx_offset, incx,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 #endif // COMPLEX
 
@@ -566,9 +484,10 @@ magma_zswap(
     cl_int err = CLBlastZswap(
         n, dx, dx_offset, incx,
            dy, dy_offset, incy,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 
@@ -642,9 +561,10 @@ magma_zgemv(
         alpha, dA, dA_offset, ldda,
                dx, dx_offset, incx,
         beta,  dy, dy_offset, incy,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -697,8 +617,9 @@ magma_zgerc(
         alpha, dx, dx_offset, incx,
                dy, dy_offset, incy,
                dA, dA_offset, ldda,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 #ifdef COMPLEX
@@ -752,8 +673,9 @@ magma_zgeru(
         alpha, dx, dx_offset, incx,
                dy, dy_offset, incy,
                dA, dA_offset, ldda,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 #endif // COMPLEX
 
@@ -835,9 +757,10 @@ magma_zhemv(
         alpha, dA, dA_offset, ldda,
                dx, dx_offset, incx,
         beta,  dy, dy_offset, incy,
-        1, &queue, 0, NULL, g_event );
+        1, &queue, 0, NULL, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 #endif
 }
 
@@ -884,8 +807,9 @@ magma_zher(
         n,
         alpha, dx, dx_offset, incx,
                dA, dA_offset, ldda,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -940,8 +864,9 @@ magma_zher2(
         alpha, dx, dx_offset, incx,
                dy, dy_offset, incy,
                dA, dA_offset, ldda,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -997,9 +922,10 @@ magma_ztrmv(
         n,
         dA, dA_offset, ldda,
         dx, dx_offset, incx,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -1056,9 +982,10 @@ magma_ztrsv(
         n,
         dA, dA_offset, ldda,
         dx, dx_offset, incx,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // ========================================
@@ -1135,9 +1062,10 @@ magma_zgemm(
         alpha, dA, dA_offset, ldda,
                dB, dB_offset, lddb,
         beta,  dC, dC_offset, lddc,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -1207,8 +1135,9 @@ magma_zsymm(
         alpha, dA, dA_offset, ldda,
                dB, dB_offset, lddb,
         beta,  dC, dC_offset, lddc,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -1272,8 +1201,9 @@ magma_zsyrk(
         n, k,
         alpha, dA, dA_offset, ldda,
         beta,  dC, dC_offset, lddc,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -1344,8 +1274,9 @@ magma_zsyr2k(
         alpha, dA, dA_offset, ldda,
                dB, dB_offset, lddb,
         beta,  dC, dC_offset, lddc,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 #ifdef COMPLEX
@@ -1419,9 +1350,10 @@ magma_zhemm(
         alpha, dA, dA_offset, ldda,
                dB, dB_offset, lddb,
         beta,  dC, dC_offset, lddc,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -1485,9 +1417,10 @@ magma_zherk(
         n, k,
         alpha, dA, dA_offset, ldda,
         beta,  dC, dC_offset, lddc,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 
 // --------------------
@@ -1561,9 +1494,10 @@ magma_zher2k(
         alpha, dA, dA_offset, ldda,
         dB, dB_offset, lddb,
         beta, dC, dC_offset, lddc,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 }
 #endif // COMPLEX
 
@@ -1663,9 +1597,10 @@ else {
         m, n,
         alpha, dA, dA_offset, ldda,
                dB, dB_offset, lddb,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 #ifdef PRECISION_z
 }
 #endif
@@ -1765,9 +1700,10 @@ printf( "ztrsm done\n" );
         m, n,
         alpha, dA, dA_offset, ldda,
                dB, dB_offset, lddb,
-        &queue, g_event );
+        &queue, trace_event( g_event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "kernel", __func__ );
 #endif
 }
 
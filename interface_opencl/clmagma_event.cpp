@@ -0,0 +1,251 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include "clmagma_event.h"
+#include "error.h"
+#include "trace.h"
+
+
+// ------------------------------------------------------------
+clmagma_events::clmagma_events():
+    m_context( NULL )
+{
+    pthread_mutex_init( &m_mutex, NULL );
+}
+
+
+// ------------------------------------------------------------
+clmagma_events::~clmagma_events()
+{
+    quit();
+    pthread_mutex_destroy( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Attaches to context, in which handles are created.
+void clmagma_events::init( cl_context context )
+{
+    pthread_mutex_lock( &m_mutex );
+    m_context = context;
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Releases all handles and their markers.
+void clmagma_events::quit()
+{
+    pthread_mutex_lock( &m_mutex );
+    marker_map_t::iterator it;
+    for( it = m_markers.begin(); it != m_markers.end(); ++it ) {
+        if ( it->second != NULL ) {
+            clReleaseEvent( it->second );
+        }
+        clReleaseEvent( it->first );
+    }
+    m_markers.clear();
+    m_context = NULL;
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Creates a handle. Until it is recorded, the event is complete.
+magma_int_t clmagma_events::create( magma_event_t* eventPtr )
+{
+    *eventPtr = NULL;
+    if ( m_context == NULL ) {
+        fprintf( stderr, "Error in %s: runtime not initialized.\n", __func__ );
+        return MAGMA_ERR_NOT_INITIALIZED;
+    }
+
+    cl_int err;
+    magma_event_t handle = clCreateUserEvent( m_context, &err );
+    check_error( err );
+    if ( err != CL_SUCCESS ) {
+        return MAGMA_ERR_UNKNOWN;
+    }
+
+    pthread_mutex_lock( &m_mutex );
+    m_markers[ handle ] = NULL;
+    pthread_mutex_unlock( &m_mutex );
+
+    *eventPtr = handle;
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Releases a handle and its marker. Other events are simply released,
+/// which drops the reference returned by the enqueue call that made them.
+magma_int_t clmagma_events::destroy( magma_event_t event )
+{
+    if ( event == NULL )
+        return MAGMA_SUCCESS;
+
+    magma_event_t marker = NULL;
+    pthread_mutex_lock( &m_mutex );
+    marker_map_t::iterator it = m_markers.find( event );
+    if ( it != m_markers.end() ) {
+        marker = it->second;
+        m_markers.erase( it );
+    }
+    pthread_mutex_unlock( &m_mutex );
+
+    cl_int err;
+    if ( marker != NULL ) {
+        err = clReleaseEvent( marker );
+        check_error( err );
+    }
+    err = clReleaseEvent( event );
+    check_error( err );
+    return err;
+}
+
+
+// ------------------------------------------------------------
+/// Enqueues a marker on queue, which completes when all commands previously
+/// enqueued on queue complete, and points the handle at it.
+/// The queue is flushed so that other queues waiting on the marker cannot
+/// deadlock on commands that were never submitted.
+magma_int_t clmagma_events::record( magma_event_t event, magma_queue_t queue )
+{
+    magma_event_t marker;
+    cl_int err = clEnqueueMarkerWithWaitList( queue, 0, NULL, &marker );
+    check_error( err );
+    if ( err != CL_SUCCESS ) {
+        return err;
+    }
+    err = clFlush( queue );
+    check_error( err );
+
+    magma_event_t old = NULL;
+    pthread_mutex_lock( &m_mutex );
+    marker_map_t::iterator it = m_markers.find( event );
+    if ( it != m_markers.end() ) {
+        old = it->second;
+        it->second = marker;
+        marker = NULL;
+    }
+    pthread_mutex_unlock( &m_mutex );
+
+    if ( marker != NULL ) {
+        // not a handle from create; there is nothing to record into
+        fprintf( stderr, "Error in %s: event was not created by magma_event_create.\n", __func__ );
+        clReleaseEvent( marker );
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    if ( old != NULL ) {
+        clReleaseEvent( old );
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Returns MAGMA_SUCCESS if the event is complete, MAGMA_ERR_NOT_READY if
+/// it is still queued or running, or an error if its command failed.
+magma_int_t clmagma_events::query( magma_event_t event )
+{
+    magma_event_t marker = resolve( event );
+    if ( marker == NULL )
+        return MAGMA_SUCCESS;
+
+    cl_int status;
+    cl_int err = clGetEventInfo( marker, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                                 sizeof(status), &status, NULL );
+    clReleaseEvent( marker );
+    check_error( err );
+    if ( err != CL_SUCCESS )
+        return err;
+    if ( status < 0 )
+        return status;
+    return (status == CL_COMPLETE ? MAGMA_SUCCESS : MAGMA_ERR_NOT_READY);
+}
+
+
+// ------------------------------------------------------------
+/// Blocks the CPU until the event is complete.
+magma_int_t clmagma_events::sync( magma_event_t event )
+{
+    magma_event_t marker = resolve( event );
+    if ( marker == NULL )
+        return MAGMA_SUCCESS;
+
+    double start = (trace_enabled() ? magma_wtime() : 0);
+    cl_int err = clWaitForEvents( 1, &marker );
+    if ( trace_enabled() ) {
+        trace_sync( marker, start );
+    }
+    clReleaseEvent( marker );
+    check_error( err );
+    return err;
+}
+
+
+// ------------------------------------------------------------
+/// Blocks commands enqueued on queue after this call, but not the CPU,
+/// until the event is complete.
+/// The event must have been recorded on a queue in the same cl_context as
+/// queue; OpenCL cannot wait across contexts, so that returns
+/// MAGMA_ERR_ILLEGAL_VALUE.
+magma_int_t clmagma_events::wait( magma_queue_t queue, magma_event_t event )
+{
+    magma_event_t marker = resolve( event );
+    if ( marker == NULL )
+        return MAGMA_SUCCESS;
+
+    // a queue can only wait on events from its own context
+    cl_context event_context = NULL, queue_context = NULL;
+    cl_int err;
+    err = clGetEventInfo( marker, CL_EVENT_CONTEXT, sizeof(cl_context), &event_context, NULL );
+    check_error( err );
+    err = clGetCommandQueueInfo( queue, CL_QUEUE_CONTEXT, sizeof(cl_context), &queue_context, NULL );
+    check_error( err );
+    if ( event_context != queue_context ) {
+        fprintf( stderr, "Error in %s: event and queue are in different OpenCL contexts.\n", __func__ );
+        clReleaseEvent( marker );
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+
+    // while tracing, keep the barrier, to draw the dependency on marker
+    cl_event barrier = NULL;
+    err = clEnqueueBarrierWithWaitList( queue, 1, &marker,
+                                        (trace_enabled() ? &barrier : NULL) );
+    if ( barrier != NULL ) {
+        trace_wait( queue, marker, barrier );
+        clReleaseEvent( barrier );
+    }
+    clReleaseEvent( marker );
+    check_error( err );
+    return err;
+}
+
+
+// ------------------------------------------------------------
+/// Returns the event to wait on for event, with a reference the caller must
+/// release: the marker for a handle (NULL if never recorded), otherwise
+/// the event itself.
+magma_event_t clmagma_events::resolve( magma_event_t event )
+{
+    if ( event == NULL )
+        return NULL;
+
+    magma_event_t marker = event;
+    pthread_mutex_lock( &m_mutex );
+    marker_map_t::iterator it = m_markers.find( event );
+    if ( it != m_markers.end() ) {
+        marker = it->second;
+    }
+    if ( marker != NULL ) {
+        clRetainEvent( marker );
+    }
+    pthread_mutex_unlock( &m_mutex );
+    return marker;
+}
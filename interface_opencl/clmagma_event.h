@@ -0,0 +1,63 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#ifndef CLMAGMA_EVENT_H
+#define CLMAGMA_EVENT_H
+
+#include <map>
+
+#include "common_magma.h"  // includes OpenCL, pthread, etc.
+
+
+// ------------------------------------------------------------
+// Recordable events for a single cl_context.
+//
+// An OpenCL event is produced by an enqueue call and cannot be re-pointed at
+// a later command, so the magma_event_t returned by magma_event_create is a
+// handle (a user event, never signaled) that maps to the marker enqueued by
+// the most recent magma_event_record. Markers are retained while mapped and
+// released when the handle is re-recorded or destroyed.
+//
+// Events not created by magma_event_create, e.g., returned by the _async
+// set/get routines, are not in the map and resolve to themselves, so they
+// can be passed to the same query, sync, and wait functions.
+//
+// Handles are user events in MAGMA's context. They can be recorded on any
+// queue, but a queue can only wait on a marker from its own context, so
+// queues in other contexts (on other platforms' devices, or created by the
+// application) cannot be ordered against MAGMA's queues with wait; use
+// sync (a host wait) instead.
+class clmagma_events
+{
+public:
+    // ------------------------------
+    clmagma_events();
+    ~clmagma_events();
+
+    // ------------------------------
+    void        init( cl_context context );
+    void        quit();
+
+    magma_int_t create ( magma_event_t* eventPtr );
+    magma_int_t destroy( magma_event_t  event );
+    magma_int_t record ( magma_event_t  event, magma_queue_t queue );
+    magma_int_t query  ( magma_event_t  event );
+    magma_int_t sync   ( magma_event_t  event );
+    magma_int_t wait   ( magma_queue_t  queue, magma_event_t event );
+
+    // ==============================
+private:
+    magma_event_t resolve( magma_event_t event );
+
+    typedef std::map< magma_event_t, magma_event_t > marker_map_t;
+
+    cl_context      m_context;
+    pthread_mutex_t m_mutex;    ///< lock for m_markers
+    marker_map_t    m_markers;  ///< handle -> last recorded marker, or NULL
+};
+
+#endif        //  #ifndef CLMAGMA_EVENT_H
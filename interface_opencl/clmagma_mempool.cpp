@@ -0,0 +1,351 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "clmagma_mempool.h"
+#include "error.h"
+
+
+// smallest size class, in bytes
+static const size_t c_min_size = 256;
+
+
+// ------------------------------------------------------------
+clmagma_mempool::clmagma_mempool():
+    m_context( NULL ),
+    m_enabled( true ),
+    m_epoch( 0 ),
+    m_max_cached( 0 )
+{
+    pthread_mutex_init( &m_mutex, NULL );
+    memset( &m_stats, 0, sizeof(m_stats) );
+}
+
+
+// ------------------------------------------------------------
+clmagma_mempool::~clmagma_mempool()
+{
+    quit();
+    pthread_mutex_destroy( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Returns size rounded up to its size class.
+/// Classes are 1, 1.25, 1.5, 1.75 times a power of 2, with a minimum of 256 bytes.
+size_t clmagma_mempool::size_class( size_t size )
+{
+    if ( size <= c_min_size )
+        return c_min_size;
+
+    // find p such that p < size <= 2p
+    size_t p = c_min_size;
+    while ( p < size - p ) {
+        p *= 2;
+    }
+    size_t step = p / 4;
+    return ((size + step - 1) / step) * step;
+}
+
+
+// ------------------------------------------------------------
+/// Attaches pool to context. Reads $MAGMA_MEMPOOL; a value of 0 disables caching.
+/// Reads $MAGMA_MEMPOOL_MAX, the limit on cached MiB; by default, a quarter
+/// of the memory of the smallest device in context. A limit of 0 disables it.
+void clmagma_mempool::init( cl_context context )
+{
+    size_t max_cached = 0;
+    cl_uint ndevices = 0;
+    clGetContextInfo( context, CL_CONTEXT_NUM_DEVICES, sizeof(ndevices), &ndevices, NULL );
+    if ( ndevices > 0 ) {
+        std::vector< cl_device_id > devices( ndevices );
+        clGetContextInfo( context, CL_CONTEXT_DEVICES, ndevices*sizeof(cl_device_id), &devices[0], NULL );
+        for( cl_uint i=0; i < ndevices; ++i ) {
+            cl_ulong mem = 0;
+            clGetDeviceInfo( devices[i], CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(mem), &mem, NULL );
+            if ( mem > 0 && (max_cached == 0 || mem/4 < max_cached) ) {
+                max_cached = mem/4;
+            }
+        }
+    }
+    const char* max_str = getenv( "MAGMA_MEMPOOL_MAX" );
+    if ( max_str != NULL ) {
+        max_cached = (size_t) atol( max_str ) << 20;
+    }
+
+    pthread_mutex_lock( &m_mutex );
+    m_context = context;
+    m_max_cached = max_cached;
+    memset( &m_stats, 0, sizeof(m_stats) );
+
+    const char* pool_str = getenv( "MAGMA_MEMPOOL" );
+    m_enabled = ! (pool_str != NULL && strcmp( pool_str, "0" ) == 0);
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Releases all cached buffers. Buffers still in use are left alone,
+/// but are forgotten, so a later magma_free releases them directly.
+void clmagma_mempool::quit()
+{
+    pthread_mutex_lock( &m_mutex );
+    trim_locked();
+    m_used.clear();
+    m_queues.clear();
+    m_context = NULL;
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Allocates a buffer of at least size bytes, reusing a cached buffer of
+/// the same size class if one is available, once the commands that used it
+/// are done. If the device is out of memory, releases all cached buffers
+/// and tries again.
+magma_int_t clmagma_mempool::malloc( magma_ptr* ptrPtr, size_t size )
+{
+    if ( m_context == NULL ) {
+        fprintf( stderr, "Error in %s: runtime not initialized.\n", __func__ );
+        *ptrPtr = NULL;
+        return MAGMA_ERR_NOT_INITIALIZED;
+    }
+
+    bool enabled = m_enabled;
+    size_t bytes = (enabled ? size_class( size ) : size);
+    cl_mem ptr = NULL;
+    std::vector< cl_event > markers;
+
+    pthread_mutex_lock( &m_mutex );
+    m_stats.num_allocs += 1;
+    if ( enabled ) {
+        free_list_t::iterator it = m_free.find( bytes );
+        if ( it != m_free.end() && ! it->second.empty() ) {
+            ptr = it->second.back().mem;
+            markers.swap( it->second.back().markers );
+            it->second.pop_back();
+            m_stats.bytes_cached -= bytes;
+            m_stats.num_hits     += 1;
+        }
+    }
+    pthread_mutex_unlock( &m_mutex );
+
+    // wait for commands enqueued before the buffer was freed
+    if ( ! markers.empty() ) {
+        cl_int err = clWaitForEvents( (cl_uint) markers.size(), &markers[0] );
+        check_error( err );
+        for( size_t i=0; i < markers.size(); ++i ) {
+            clReleaseEvent( markers[i] );
+        }
+    }
+
+    if ( ptr == NULL ) {
+        cl_int err;
+        ptr = clCreateBuffer( m_context, CL_MEM_READ_WRITE, bytes, NULL, &err );
+        if ( err == CL_MEM_OBJECT_ALLOCATION_FAILURE || err == CL_OUT_OF_RESOURCES ) {
+            trim();
+            ptr = clCreateBuffer( m_context, CL_MEM_READ_WRITE, bytes, NULL, &err );
+        }
+        if ( err != CL_SUCCESS ) {
+            *ptrPtr = NULL;
+            return MAGMA_ERR_DEVICE_ALLOC;
+        }
+    }
+
+    pthread_mutex_lock( &m_mutex );
+    used_t used = { bytes, ++m_epoch };
+    m_used[ ptr ] = used;
+    m_stats.bytes_in_use += bytes;
+    m_stats.high_water_mark = max( m_stats.high_water_mark,
+                                   m_stats.bytes_in_use + m_stats.bytes_cached );
+    pthread_mutex_unlock( &m_mutex );
+
+    *ptrPtr = ptr;
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Returns buffer to its free list, with a marker on each live queue used
+/// since the buffer was allocated. If the cached bytes then exceed the
+/// high-water limit, releases cached buffers, largest first, down to it.
+/// Buffers that did not come from the pool (or when caching is disabled)
+/// are released immediately; clReleaseMemObject defers the release until
+/// commands using the buffer are done.
+magma_int_t clmagma_mempool::free( magma_ptr ptr )
+{
+    if ( ptr == NULL )
+        return MAGMA_SUCCESS;
+
+    bool cached = false;
+    pthread_mutex_lock( &m_mutex );
+    std::map< cl_mem, used_t >::iterator it = m_used.find( ptr );
+    if ( it != m_used.end() ) {
+        size_t bytes = it->second.bytes;
+        unsigned long long epoch = it->second.epoch;
+        m_used.erase( it );
+        m_stats.bytes_in_use -= bytes;
+        m_stats.num_frees    += 1;
+        if ( m_enabled ) {
+            cached_t entry;
+            entry.mem = ptr;
+            std::map< cl_command_queue, unsigned long long >::iterator q;
+            for( q = m_queues.begin(); q != m_queues.end(); ++q ) {
+                if ( q->second < epoch )
+                    continue;  // not used since the buffer was allocated
+                cl_event marker;
+                if ( clEnqueueMarkerWithWaitList( q->first, 0, NULL, &marker ) == CL_SUCCESS ) {
+                    entry.markers.push_back( marker );
+                }
+            }
+            m_free[ bytes ].push_back( entry );
+            m_stats.bytes_cached += bytes;
+            cached = true;
+            if ( m_max_cached > 0 && m_stats.bytes_cached > m_max_cached ) {
+                trim_to_locked( m_max_cached );
+            }
+        }
+    }
+    pthread_mutex_unlock( &m_mutex );
+
+    if ( ! cached ) {
+        cl_int err = clReleaseMemObject( ptr );
+        if ( err != CL_SUCCESS ) {
+            return MAGMA_ERR_INVALID_PTR;
+        }
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Releases all cached buffers back to the OpenCL runtime.
+magma_int_t clmagma_mempool::trim()
+{
+    pthread_mutex_lock( &m_mutex );
+    trim_locked();
+    pthread_mutex_unlock( &m_mutex );
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Releases all cached buffers; m_mutex must be held by caller.
+void clmagma_mempool::trim_locked()
+{
+    cl_int err;
+    free_list_t::iterator it;
+    for( it = m_free.begin(); it != m_free.end(); ++it ) {
+        for( size_t i=0; i < it->second.size(); ++i ) {
+            cached_t& entry = it->second[i];
+            for( size_t j=0; j < entry.markers.size(); ++j ) {
+                clReleaseEvent( entry.markers[j] );
+            }
+            err = clReleaseMemObject( entry.mem );
+            check_error( err );
+        }
+    }
+    m_free.clear();
+    m_stats.bytes_cached = 0;
+    m_stats.num_trims   += 1;
+}
+
+
+// ------------------------------------------------------------
+/// Releases cached buffers, largest first, until at most max_bytes are
+/// cached; m_mutex must be held by caller.
+void clmagma_mempool::trim_to_locked( size_t max_bytes )
+{
+    cl_int err;
+    while ( m_stats.bytes_cached > max_bytes && ! m_free.empty() ) {
+        free_list_t::iterator it = --m_free.end();
+        if ( it->second.empty() ) {
+            m_free.erase( it );
+            continue;
+        }
+        cached_t& entry = it->second.back();
+        for( size_t j=0; j < entry.markers.size(); ++j ) {
+            clReleaseEvent( entry.markers[j] );
+        }
+        err = clReleaseMemObject( entry.mem );
+        check_error( err );
+        it->second.pop_back();
+        m_stats.bytes_cached -= it->first;
+    }
+}
+
+
+// ------------------------------------------------------------
+/// Sets the high-water limit on cached bytes, releasing cached buffers
+/// down to it; 0 disables the limit.
+void clmagma_mempool::set_max_cached( size_t bytes )
+{
+    pthread_mutex_lock( &m_mutex );
+    m_max_cached = bytes;
+    if ( m_max_cached > 0 ) {
+        trim_to_locked( m_max_cached );
+    }
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+void clmagma_mempool::get_stats( magma_mempool_stats_t* stats )
+{
+    pthread_mutex_lock( &m_mutex );
+    *stats = m_stats;
+    stats->enabled = m_enabled;
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Registers a queue that may use pool buffers. Queues of other contexts
+/// cannot use them, and are ignored.
+void clmagma_mempool::add_queue( cl_command_queue queue )
+{
+    cl_context context = NULL;
+    clGetCommandQueueInfo( queue, CL_QUEUE_CONTEXT, sizeof(context), &context, NULL );
+    pthread_mutex_lock( &m_mutex );
+    if ( context != NULL && context == m_context ) {
+        m_queues[ queue ] = 0;  // not used yet
+    }
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Unregisters a queue before it is released. Markers already enqueued on
+/// it are events of their own, and stay valid.
+void clmagma_mempool::remove_queue( cl_command_queue queue )
+{
+    pthread_mutex_lock( &m_mutex );
+    m_queues.erase( queue );
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Notes that a command is being enqueued on queue, so it may use any
+/// buffer allocated so far, and free must order reuse after it.
+/// Called by the transfer and BLAS wrappers, through trace_command, and
+/// by magma_enqueue_kernel.
+void clmagma_mempool::note_use( cl_command_queue queue )
+{
+    if ( ! m_enabled )
+        return;
+
+    pthread_mutex_lock( &m_mutex );
+    std::map< cl_command_queue, unsigned long long >::iterator q = m_queues.find( queue );
+    if ( q != m_queues.end() ) {
+        q->second = m_epoch;
+    }
+    pthread_mutex_unlock( &m_mutex );
+}
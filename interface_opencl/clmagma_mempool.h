@@ -0,0 +1,99 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#ifndef CLMAGMA_MEMPOOL_H
+#define CLMAGMA_MEMPOOL_H
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include "common_magma.h"  // includes OpenCL, pthread, etc.
+
+
+// ------------------------------------------------------------
+// Caching allocator for device buffers of a single cl_context.
+//
+// Freed buffers are kept on a free list per size class and handed out again
+// by later allocations of the same class, avoiding clCreateBuffer /
+// clReleaseMemObject for the many short-lived workspaces in MAGMA drivers.
+// Sizes are rounded up to 4 classes per power of 2 (1, 1.25, 1.5, 1.75 * 2^k),
+// so at most 25% of each buffer is wasted.
+//
+// magma_free takes no queue, so commands on any queue may still be using a
+// freed buffer. The pool knows the queues of magma_queue_create, registered
+// by add_queue, and MAGMA's transfers, BLAS calls, and kernels tell it which
+// queues they enqueue on, with note_use. On free, the pool enqueues a marker
+// on each of those queues used since the buffer was allocated, and waits for
+// the markers before handing the buffer out again. Buffers used on queues
+// created by other means, or by commands enqueued other than through MAGMA,
+// must not be freed until those queues are synced.
+//
+// The cached bytes are kept under a high-water limit, $MAGMA_MEMPOOL_MAX MiB,
+// by default a quarter of the smallest device's memory; a free that exceeds
+// it releases cached buffers, largest first. When an allocation fails, all
+// cached buffers are released.
+//
+// Set $MAGMA_MEMPOOL=0 to disable caching; buffers are then created and
+// released directly, but statistics are still collected.
+class clmagma_mempool
+{
+public:
+    // ------------------------------
+    clmagma_mempool();
+    ~clmagma_mempool();
+
+    // ------------------------------
+    void        init( cl_context context );
+    void        quit();
+
+    magma_int_t malloc( magma_ptr* ptrPtr, size_t size );
+    magma_int_t free( magma_ptr ptr );
+    magma_int_t trim();
+    void        get_stats( magma_mempool_stats_t* stats );
+
+    void        add_queue( cl_command_queue queue );
+    void        remove_queue( cl_command_queue queue );
+    void        note_use( cl_command_queue queue );
+
+    void        set_max_cached( size_t bytes );
+    size_t      max_cached() const { return m_max_cached; }
+
+    bool        enabled() const { return m_enabled; }
+
+    static size_t size_class( size_t size );
+
+    // ==============================
+private:
+    void trim_locked();
+    void trim_to_locked( size_t max_bytes );
+
+    // cached buffer, with markers of the commands that may still use it
+    struct cached_t {
+        cl_mem mem;
+        std::vector< cl_event > markers;
+    };
+    typedef std::map< size_t, std::vector< cached_t > > free_list_t;
+
+    // buffer in use, with the epoch it was allocated in
+    struct used_t {
+        size_t             bytes;
+        unsigned long long epoch;
+    };
+
+    cl_context      m_context;
+    std::atomic< bool > m_enabled;
+    pthread_mutex_t m_mutex;     ///< lock for free lists, used map, queues, and stats
+    free_list_t     m_free;      ///< size class -> cached buffers
+    std::map< cl_command_queue, unsigned long long > m_queues;  ///< live queue in m_context -> epoch of its last use
+    std::map< cl_mem, used_t > m_used;  ///< live buffer -> size class and epoch
+    unsigned long long         m_epoch;       ///< number of buffers handed out
+    size_t                     m_max_cached;  ///< high-water limit on bytes_cached
+    magma_mempool_stats_t      m_stats;
+};
+
+#endif        //  #ifndef CLMAGMA_MEMPOOL_H
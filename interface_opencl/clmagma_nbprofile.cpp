@@ -0,0 +1,338 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "clmagma_nbprofile.h"
+
+
+// ------------------------------------------------------------
+/// Creates directory and its parents, like mkdir -p.
+/// Returns true if the directory exists afterwards.
+static bool make_dirs( const std::string& dir )
+{
+    size_t i = 0;
+    while( i != std::string::npos ) {
+        i = dir.find( '/', i+1 );
+        std::string sub = dir.substr( 0, i );
+        if ( mkdir( sub.c_str(), 0755 ) != 0 && errno != EEXIST ) {
+            return false;
+        }
+    }
+    struct stat s;
+    return (stat( dir.c_str(), &s ) == 0 && S_ISDIR( s.st_mode ));
+}
+
+
+// ------------------------------------------------------------
+/// Returns device info string, or "unknown".
+static std::string get_info( cl_device_id device, cl_device_info param )
+{
+    char data[1024];
+    if ( clGetDeviceInfo( device, param, sizeof(data), data, NULL ) != CL_SUCCESS ) {
+        return "unknown";
+    }
+    data[ sizeof(data)-1 ] = '\0';
+    return data;
+}
+
+
+// ------------------------------------------------------------
+/// Returns str with characters other than letters, digits, '.', and '-'
+/// replaced by '_', so it can be part of a file name.
+static std::string sanitize( const std::string& str )
+{
+    std::string out( str );
+    for( size_t i=0; i < out.size(); ++i ) {
+        char c = out[i];
+        if ( ! ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                (c >= '0' && c <= '9') || c == '.' || c == '-') ) {
+            out[i] = '_';
+        }
+    }
+    return out;
+}
+
+
+// ------------------------------------------------------------
+clmagma_nbprofile::clmagma_nbprofile():
+    m_snapshot( NULL )
+{
+    pthread_mutex_init( &m_mutex, NULL );
+    pthread_key_create( &m_thread_key, NULL );
+}
+
+
+// ------------------------------------------------------------
+clmagma_nbprofile::~clmagma_nbprofile()
+{
+    quit();
+    pthread_key_delete( m_thread_key );
+    pthread_mutex_destroy( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Picks the profile of each device and loads the ones that exist.
+void clmagma_nbprofile::init( int ndevices, const cl_device_id* devices )
+{
+    const char* dir  = getenv( "CLMAGMA_NB_PROFILE_DIR" );
+    const char* xdg  = getenv( "XDG_CONFIG_HOME" );
+    const char* home = getenv( "HOME" );
+
+    pthread_mutex_lock( &m_mutex );
+    if ( dir != NULL ) {
+        m_dir = dir;
+    }
+    else if ( xdg != NULL && xdg[0] != '\0' ) {
+        m_dir = std::string( xdg ) + "/clmagma";
+    }
+    else if ( home != NULL && home[0] != '\0' ) {
+        m_dir = std::string( home ) + "/.config/clmagma";
+    }
+    else {
+        m_dir = "";
+    }
+    while( m_dir.size() > 1 && m_dir[ m_dir.size()-1 ] == '/' ) {
+        m_dir.erase( m_dir.size()-1 );
+    }
+
+    m_files.clear();
+    m_devices.assign( devices, devices + ndevices );
+    m_device_files.assign( ndevices, -1 );
+    for( int dev=0; dev < ndevices; ++dev ) {
+        file_t file;
+        file.device = get_info( devices[dev], CL_DEVICE_NAME    );
+        file.driver = get_info( devices[dev], CL_DRIVER_VERSION );
+        file.path   = m_dir + '/' + sanitize( file.device ) + '-' + sanitize( file.driver ) + ".nb";
+        size_t f = 0;
+        while( f < m_files.size() && m_files[f].path != file.path ) {
+            ++f;
+        }
+        if ( f == m_files.size() ) {
+            m_files.push_back( file );
+        }
+        m_device_files[dev] = (int) f;
+    }
+
+    snapshot_t* snapshot = new snapshot_t;
+    snapshot->enabled = (m_dir != "");
+    snapshot->tables.resize( m_files.size() );
+    if ( snapshot->enabled ) {
+        for( size_t f=0; f < m_files.size(); ++f ) {
+            load( m_files[f].path, snapshot->tables[f] );
+        }
+    }
+    publish( snapshot );
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+void clmagma_nbprofile::quit()
+{
+    pthread_mutex_lock( &m_mutex );
+    delete m_snapshot.exchange( NULL, std::memory_order_acq_rel );
+    for( size_t i=0; i < m_old_snapshots.size(); ++i ) {
+        delete m_old_snapshots[i];
+    }
+    m_old_snapshots.clear();
+    m_files.clear();
+    m_devices.clear();
+    m_device_files.clear();
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Reads the profile at path into table, skipping comments and malformed lines.
+void clmagma_nbprofile::load( const std::string& path, table_t& table )
+{
+    FILE* file = fopen( path.c_str(), "r" );
+    if ( file == NULL )
+        return;
+
+    char line[256], routine[64];
+    long max_m, nb;
+    while( fgets( line, sizeof(line), file ) != NULL ) {
+        if ( line[0] == '#' )
+            continue;
+        if ( sscanf( line, "%63s %ld %ld", routine, &max_m, &nb ) == 3
+             && max_m > 0 && nb > 0 ) {
+            table[ routine ][ max_m ] = nb;
+        }
+    }
+    fclose( file );
+}
+
+
+// ------------------------------------------------------------
+/// Replaces m_snapshot with snapshot.
+/// Must be called with m_mutex held.
+void clmagma_nbprofile::publish( snapshot_t* snapshot )
+{
+    snapshot_t* old = m_snapshot.exchange( snapshot, std::memory_order_acq_rel );
+    if ( old != NULL ) {
+        m_old_snapshots.push_back( old );
+    }
+}
+
+
+// ------------------------------------------------------------
+/// Returns the index in m_files of the calling thread's device, or -1.
+int clmagma_nbprofile::thread_file()
+{
+    size_t dev = (size_t) pthread_getspecific( m_thread_key );
+    dev = (dev == 0 ? 0 : dev - 1);
+    if ( dev >= m_device_files.size() )
+        return -1;
+    return m_device_files[ dev ];
+}
+
+
+// ------------------------------------------------------------
+/// Sets the device whose profile the calling thread uses.
+magma_int_t clmagma_nbprofile::set_device( cl_device_id device )
+{
+    pthread_mutex_lock( &m_mutex );
+    size_t dev = 0;
+    while( dev < m_devices.size() && m_devices[dev] != device ) {
+        ++dev;
+    }
+    bool found = (dev < m_devices.size());
+    pthread_mutex_unlock( &m_mutex );
+    if ( ! found )
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    pthread_setspecific( m_thread_key, (void*) (dev + 1) );
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Enables or disables lookups in all profiles, e.g., to time the built-in
+/// tables. The profiles are kept, and set and save still work.
+void clmagma_nbprofile::set_enabled( bool enabled )
+{
+    pthread_mutex_lock( &m_mutex );
+    snapshot_t* current = m_snapshot.load( std::memory_order_acquire );
+    if ( current != NULL && m_dir != "" && current->enabled != enabled ) {
+        snapshot_t* snapshot = new snapshot_t( *current );
+        snapshot->enabled = enabled;
+        publish( snapshot );
+    }
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Returns the tuned nb for routine and size m on the calling thread's
+/// device, or 0 if its profile has none. Takes no lock.
+magma_int_t clmagma_nbprofile::get( const char* routine, magma_int_t m )
+{
+    const snapshot_t* snapshot = m_snapshot.load( std::memory_order_acquire );
+    if ( snapshot == NULL || ! snapshot->enabled )
+        return 0;
+    int f = thread_file();
+    if ( f < 0 || f >= (int) snapshot->tables.size() )
+        return 0;
+    const table_t& table = snapshot->tables[f];
+    if ( table.empty() )
+        return 0;
+    table_t::const_iterator r = table.find( routine );
+    if ( r == table.end() )
+        return 0;
+    buckets_t::const_iterator b = r->second.lower_bound( m );
+    if ( b == r->second.end() )
+        return 0;  // larger than every tuned size
+    return b->second;
+}
+
+
+// ------------------------------------------------------------
+/// Sets nb for routine and sizes up to m on the calling thread's device,
+/// in memory; save writes it out. nb <= 0 removes the bucket.
+void clmagma_nbprofile::set( const char* routine, magma_int_t m, magma_int_t nb )
+{
+    pthread_mutex_lock( &m_mutex );
+    snapshot_t* current = m_snapshot.load( std::memory_order_acquire );
+    int f = thread_file();
+    if ( current != NULL && f >= 0 ) {
+        snapshot_t* snapshot = new snapshot_t( *current );
+        if ( nb > 0 ) {
+            snapshot->tables[f][ routine ][ m ] = nb;
+        }
+        else {
+            snapshot->tables[f][ routine ].erase( m );
+        }
+        publish( snapshot );
+    }
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Writes the profile of the calling thread's device to a temporary file
+/// and renames it into place.
+magma_int_t clmagma_nbprofile::save()
+{
+    pthread_mutex_lock( &m_mutex );
+    const snapshot_t* snapshot = m_snapshot.load( std::memory_order_acquire );
+    int f = thread_file();
+    if ( m_dir == "" || snapshot == NULL || f < 0 ) {
+        pthread_mutex_unlock( &m_mutex );
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    // snapshots are immutable, so they can be written after unlocking
+    const file_t   info  = m_files[f];
+    const table_t& table = snapshot->tables[f];
+    const std::string dir = m_dir;
+    pthread_mutex_unlock( &m_mutex );
+
+    if ( ! make_dirs( dir )) {
+        fprintf( stderr, "Error: can't create nb profile directory '%s': %s (%d)\n",
+                 dir.c_str(), strerror(errno), errno );
+        return MAGMA_ERR;
+    }
+
+    char suffix[64];
+    snprintf( suffix, sizeof(suffix), ".tmp.%ld", (long) getpid() );
+    std::string tmp = info.path + suffix;
+    FILE* file = fopen( tmp.c_str(), "w" );
+    if ( file == NULL ) {
+        fprintf( stderr, "Error: can't write nb profile '%s': %s (%d)\n",
+                 tmp.c_str(), strerror(errno), errno );
+        return MAGMA_ERR;
+    }
+
+    fprintf( file, "# clMAGMA nb profile: routine, max size, nb\n" );
+    fprintf( file, "# device: %s\n", info.device.c_str() );
+    fprintf( file, "# driver: %s\n", info.driver.c_str() );
+    table_t::const_iterator r;
+    for( r = table.begin(); r != table.end(); ++r ) {
+        buckets_t::const_iterator b;
+        for( b = r->second.begin(); b != r->second.end(); ++b ) {
+            fprintf( file, "%-12s %6ld %4ld\n", r->first.c_str(), (long) b->first, (long) b->second );
+        }
+    }
+
+    bool ok = (fflush( file ) == 0);
+    ok = (fclose( file ) == 0) && ok;
+    if ( ok ) {
+        ok = (rename( tmp.c_str(), info.path.c_str() ) == 0);
+    }
+    if ( ! ok ) {
+        fprintf( stderr, "Error: can't write nb profile '%s': %s (%d)\n",
+                 info.path.c_str(), strerror(errno), errno );
+        unlink( tmp.c_str() );
+        return MAGMA_ERR;
+    }
+    return MAGMA_SUCCESS;
+}
@@ -0,0 +1,86 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#ifndef CLMAGMA_NBPROFILE_H
+#define CLMAGMA_NBPROFILE_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common_magma.h"  // includes OpenCL, pthread, etc.
+
+
+// ------------------------------------------------------------
+// Block sizes tuned on each device, which the magma_get_*_nb functions
+// use in place of their built-in tables.
+//
+// The profile is a text file, written by the testing_*tune_nb testers,
+// with lines "routine max_m nb": for routine and sizes m <= max_m, above
+// the next smaller max_m, use nb. Sizes beyond the largest max_m were not
+// tuned, so they use the built-in tables.
+// Each device and driver has its own file, named by CL_DEVICE_NAME and
+// CL_DRIVER_VERSION, in $CLMAGMA_NB_PROFILE_DIR, or $XDG_CONFIG_HOME/clmagma,
+// or $HOME/.config/clmagma, in that order. Identical devices share a file.
+//
+// Since magma_get_*_nb take no queue, lookups use the calling thread's
+// device, set with set_device; the default is the first device.
+// Lookups take no lock: they read an immutable snapshot of all profiles,
+// which set and set_enabled replace, not modify; old snapshots are kept
+// until quit, since readers may still hold them.
+//
+// Set $CLMAGMA_NB_PROFILE_DIR to an empty string to ignore profiles.
+class clmagma_nbprofile
+{
+public:
+    // ------------------------------
+    clmagma_nbprofile();
+    ~clmagma_nbprofile();
+
+    // ------------------------------
+    void        init( int ndevices, const cl_device_id* devices );
+    void        quit();
+
+    magma_int_t set_device ( cl_device_id device );
+    void        set_enabled( bool enabled );
+
+    magma_int_t get ( const char* routine, magma_int_t m );
+    void        set ( const char* routine, magma_int_t m, magma_int_t nb );
+    magma_int_t save();
+
+    // ==============================
+private:
+    typedef std::map< magma_int_t, magma_int_t > buckets_t;  ///< max_m -> nb
+    typedef std::map< std::string, buckets_t >   table_t;    ///< routine -> buckets
+
+    struct file_t {
+        std::string  path;       ///< profile file
+        std::string  device;     ///< CL_DEVICE_NAME
+        std::string  driver;     ///< CL_DRIVER_VERSION
+    };
+
+    struct snapshot_t {
+        bool                   enabled;
+        std::vector< table_t > tables;  ///< one per file in m_files
+    };
+
+    void        load( const std::string& path, table_t& table );
+    int         thread_file();
+    void        publish( snapshot_t* snapshot );
+
+    std::string                 m_dir;      ///< profile directory, or "" if disabled
+    std::vector< file_t >       m_files;    ///< profiles of all devices
+    std::vector< cl_device_id > m_devices;  ///< devices, in magma_getdevices order
+    std::vector< int >          m_device_files;  ///< index in m_files of each device
+    pthread_key_t               m_thread_key;    ///< device index + 1 of each thread, or 0
+    std::atomic< snapshot_t* >  m_snapshot;      ///< current profiles
+    std::vector< snapshot_t* >  m_old_snapshots; ///< replaced snapshots
+    pthread_mutex_t             m_mutex;    ///< lock for replacing m_snapshot
+};
+
+#endif        //  #ifndef CLMAGMA_NBPROFILE_H
@@ -0,0 +1,211 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "clmagma_pinned.h"
+#include "clmagma_mempool.h"
+#include "error.h"
+
+
+// ------------------------------------------------------------
+clmagma_pinned::clmagma_pinned():
+    m_context( NULL ),
+    m_enabled( true ),
+    m_default_queue( NULL )
+{
+    pthread_mutex_init( &m_mutex, NULL );
+}
+
+
+// ------------------------------------------------------------
+clmagma_pinned::~clmagma_pinned()
+{
+    quit();
+    pthread_mutex_destroy( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Attaches to context, creating a queue per device to map buffers with.
+/// Reads $MAGMA_MEMPOOL; a value of 0 disables caching.
+void clmagma_pinned::init( cl_context context, int ndevices, const cl_device_id* devices )
+{
+    cl_int err;
+    pthread_mutex_lock( &m_mutex );
+    m_context = context;
+    for( int dev=0; dev < ndevices; ++dev ) {
+        cl_command_queue queue = clCreateCommandQueue( m_context, devices[dev], 0, &err );
+        check_error( err );
+        if ( err == CL_SUCCESS ) {
+            m_queues[ devices[dev] ] = queue;
+            if ( m_default_queue == NULL ) {
+                m_default_queue = queue;
+            }
+        }
+    }
+    const char* pool_str = getenv( "MAGMA_MEMPOOL" );
+    m_enabled = ! (pool_str != NULL && strcmp( pool_str, "0" ) == 0);
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Unmaps and releases all pinned buffers, and releases the map queues.
+void clmagma_pinned::quit()
+{
+    cl_int err;
+    pthread_mutex_lock( &m_mutex );
+    registry_t::iterator it;
+    for( it = m_registry.begin(); it != m_registry.end(); ++it ) {
+        err = clEnqueueUnmapMemObject( it->second.queue, it->second.buffer, (void*) it->first, 0, NULL, NULL );
+        check_error( err );
+    }
+    trim_locked();
+    std::map< cl_device_id, cl_command_queue >::iterator q;
+    for( q = m_queues.begin(); q != m_queues.end(); ++q ) {
+        err = clFinish( q->second );
+        check_error( err );
+    }
+    for( it = m_registry.begin(); it != m_registry.end(); ++it ) {
+        err = clReleaseMemObject( it->second.buffer );
+        check_error( err );
+    }
+    m_registry.clear();
+    for( q = m_queues.begin(); q != m_queues.end(); ++q ) {
+        err = clReleaseCommandQueue( q->second );
+        check_error( err );
+    }
+    m_queues.clear();
+    m_default_queue = NULL;
+    m_context = NULL;
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Returns a cached buffer of the same size class, mapped for the same
+/// device, if one is available; otherwise allocates a CL_MEM_ALLOC_HOST_PTR
+/// buffer and maps it with the queue of device, or of the first device if
+/// device is NULL or unknown. Registers the mapped host pointer.
+magma_int_t clmagma_pinned::malloc( void** ptrPtr, size_t size, cl_device_id device )
+{
+    *ptrPtr = NULL;
+    if ( m_context == NULL ) {
+        fprintf( stderr, "Error in %s: runtime not initialized.\n", __func__ );
+        return MAGMA_ERR_NOT_INITIALIZED;
+    }
+
+    pthread_mutex_lock( &m_mutex );
+    cl_command_queue queue = m_default_queue;
+    std::map< cl_device_id, cl_command_queue >::iterator q = m_queues.find( device );
+    if ( q != m_queues.end() ) {
+        queue = q->second;
+    }
+    size_t bytes = (m_enabled ? clmagma_mempool::size_class( size ) : size);
+    free_list_t::iterator f = m_free.find( free_key_t( queue, bytes ));
+    if ( f != m_free.end() && ! f->second.empty() ) {
+        void* ptr = f->second.back().first;
+        m_registry[ (const char*) ptr ] = f->second.back().second;
+        f->second.pop_back();
+        pthread_mutex_unlock( &m_mutex );
+        *ptrPtr = ptr;
+        return MAGMA_SUCCESS;
+    }
+    pthread_mutex_unlock( &m_mutex );
+
+    cl_int err;
+    cl_mem buffer = clCreateBuffer( m_context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                                    bytes, NULL, &err );
+    if ( err != CL_SUCCESS ) {
+        return MAGMA_ERR_HOST_ALLOC;
+    }
+    void* ptr = clEnqueueMapBuffer( queue, buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE,
+                                    0, bytes, 0, NULL, NULL, &err );
+    if ( err != CL_SUCCESS ) {
+        clReleaseMemObject( buffer );
+        return MAGMA_ERR_HOST_ALLOC;
+    }
+
+    pthread_mutex_lock( &m_mutex );
+    entry e = { buffer, bytes, queue };
+    m_registry[ (const char*) ptr ] = e;
+    pthread_mutex_unlock( &m_mutex );
+    *ptrPtr = ptr;
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Returns a buffer allocated by malloc to the free list of its device and
+/// size class, still mapped;
+/// if caching is disabled, unmaps and releases it.
+magma_int_t clmagma_pinned::free( void* ptr )
+{
+    if ( ptr == NULL )
+        return MAGMA_SUCCESS;
+
+    cl_int err;
+    pthread_mutex_lock( &m_mutex );
+    registry_t::iterator it = m_registry.find( (const char*) ptr );
+    if ( it == m_registry.end() ) {
+        pthread_mutex_unlock( &m_mutex );
+        return MAGMA_ERR_INVALID_PTR;
+    }
+    entry e = it->second;
+    m_registry.erase( it );
+    if ( m_enabled ) {
+        m_free[ free_key_t( e.queue, e.size ) ].push_back( std::make_pair( ptr, e ));
+        pthread_mutex_unlock( &m_mutex );
+        return MAGMA_SUCCESS;
+    }
+    pthread_mutex_unlock( &m_mutex );
+
+    err = clEnqueueUnmapMemObject( e.queue, e.buffer, ptr, 0, NULL, NULL );
+    check_error( err );
+    err = clFinish( e.queue );
+    check_error( err );
+    err = clReleaseMemObject( e.buffer );
+    if ( err != CL_SUCCESS ) {
+        return MAGMA_ERR_INVALID_PTR;
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Unmaps and releases all cached buffers.
+magma_int_t clmagma_pinned::trim()
+{
+    pthread_mutex_lock( &m_mutex );
+    trim_locked();
+    pthread_mutex_unlock( &m_mutex );
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Unmaps and releases all cached buffers; m_mutex must be held by caller.
+void clmagma_pinned::trim_locked()
+{
+    cl_int err;
+    free_list_t::iterator it;
+    for( it = m_free.begin(); it != m_free.end(); ++it ) {
+        for( size_t i=0; i < it->second.size(); ++i ) {
+            entry& e = it->second[i].second;
+            err = clEnqueueUnmapMemObject( e.queue, e.buffer, it->second[i].first, 0, NULL, NULL );
+            check_error( err );
+            err = clFinish( e.queue );
+            check_error( err );
+            err = clReleaseMemObject( e.buffer );
+            check_error( err );
+        }
+    }
+    m_free.clear();
+}
@@ -0,0 +1,70 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#ifndef CLMAGMA_PINNED_H
+#define CLMAGMA_PINNED_H
+
+#include <map>
+#include <vector>
+
+#include "common_magma.h"  // includes OpenCL, pthread, etc.
+
+
+// ------------------------------------------------------------
+// Pinned (page-locked) host memory for a single cl_context.
+//
+// Each allocation is a CL_MEM_ALLOC_HOST_PTR buffer that stays mapped for
+// its lifetime; the mapped pointer is what magma_malloc_pinned returns.
+// It is mapped with a queue of the device it is allocated for, one queue
+// per device of the context. Because the buffer stays mapped, it must not
+// be passed to kernels or device copies; the set/get routines transfer it
+// with clEnqueueReadBuffer and clEnqueueWriteBuffer from the mapped host
+// pointer, which the driver DMAs directly since it is page-locked.
+//
+// Freed buffers stay mapped and are kept on a free list per device and size
+// class (as in clmagma_mempool), so routines that allocate a pinned workspace
+// on every call, e.g., zhetrd, reuse it instead of creating and mapping a new
+// buffer. A buffer is reused only for the device it was mapped for.
+// Set $MAGMA_MEMPOOL=0 to disable caching.
+class clmagma_pinned
+{
+public:
+    // ------------------------------
+    clmagma_pinned();
+    ~clmagma_pinned();
+
+    // ------------------------------
+    void        init( cl_context context, int ndevices, const cl_device_id* devices );
+    void        quit();
+
+    magma_int_t malloc( void** ptrPtr, size_t size, cl_device_id device );
+    magma_int_t free( void* ptr );
+    magma_int_t trim();
+
+    // ==============================
+private:
+    void trim_locked();
+
+    struct entry {
+        cl_mem           buffer;
+        size_t           size;
+        cl_command_queue queue;  ///< queue that mapped buffer
+    };
+    typedef std::map< const char*, entry > registry_t;
+    typedef std::pair< cl_command_queue, size_t > free_key_t;  ///< (map queue, size class)
+    typedef std::map< free_key_t, std::vector< std::pair< void*, entry > > > free_list_t;
+
+    cl_context       m_context;
+    bool             m_enabled;
+    std::map< cl_device_id, cl_command_queue > m_queues;  ///< per-device queues to map and unmap buffers
+    cl_command_queue m_default_queue;  ///< queue of the first device
+    pthread_mutex_t  m_mutex;     ///< lock for registry and free lists
+    registry_t       m_registry;  ///< host address -> buffer, of allocations in use
+    free_list_t      m_free;      ///< (map queue, size class) -> cached, still mapped buffers
+};
+
+#endif        //  #ifndef CLMAGMA_PINNED_H
@@ -0,0 +1,307 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "clmagma_progcache.h"
+#include "error.h"
+
+
+// Bump when the entry layout or key contents change.
+static const char   c_magic[8]  = { 'c','l','m','a','g','m','a','1' };
+static const size_t c_max_entry = 512*1024*1024;
+
+
+// ------------------------------------------------------------
+/// 64-bit FNV-1a hash of data, continuing from hash.
+static unsigned long long fnv1a(
+    const std::string& data, unsigned long long hash )
+{
+    for( size_t i=0; i < data.size(); ++i ) {
+        hash ^= (unsigned char) data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+// ------------------------------------------------------------
+/// Creates directory and its parents, like mkdir -p.
+/// Returns true if the directory exists afterwards.
+static bool make_dirs( const std::string& dir )
+{
+    size_t i = 0;
+    while( i != std::string::npos ) {
+        i = dir.find( '/', i+1 );
+        std::string sub = dir.substr( 0, i );
+        if ( mkdir( sub.c_str(), 0755 ) != 0 && errno != EEXIST ) {
+            return false;
+        }
+    }
+    struct stat s;
+    return (stat( dir.c_str(), &s ) == 0 && S_ISDIR( s.st_mode ));
+}
+
+
+// ------------------------------------------------------------
+/// Appends a device info string to str, followed by a separator.
+static void append_info( std::string& str, cl_device_id device, cl_device_info param )
+{
+    char data[1024];
+    if ( clGetDeviceInfo( device, param, sizeof(data), data, NULL ) == CL_SUCCESS ) {
+        data[ sizeof(data)-1 ] = '\0';
+        str += data;
+    }
+    str += '\n';
+}
+
+
+// ------------------------------------------------------------
+clmagma_progcache::clmagma_progcache():
+    m_context ( NULL ),
+    m_enabled ( false ),
+    m_readonly( false ),
+    m_seq     ( 0 )
+{
+    pthread_mutex_init( &m_mutex, NULL );
+}
+
+
+// ------------------------------------------------------------
+clmagma_progcache::~clmagma_progcache()
+{
+    quit();
+    pthread_mutex_destroy( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Attaches to context and its devices, and picks the cache directory.
+void clmagma_progcache::init(
+    cl_context context, cl_uint num_devices, const cl_device_id* devices )
+{
+    m_context = context;
+    m_devices.assign( devices, devices + num_devices );
+
+    m_fingerprint.clear();
+    for( cl_uint dev=0; dev < num_devices; ++dev ) {
+        append_info( m_fingerprint, devices[dev], CL_DEVICE_NAME    );
+        append_info( m_fingerprint, devices[dev], CL_DEVICE_VENDOR  );
+        append_info( m_fingerprint, devices[dev], CL_DEVICE_VERSION );
+        append_info( m_fingerprint, devices[dev], CL_DRIVER_VERSION );
+    }
+
+    const char* dir  = getenv( "CLMAGMA_CACHE_DIR" );
+    const char* xdg  = getenv( "XDG_CACHE_HOME" );
+    const char* home = getenv( "HOME" );
+    if ( dir != NULL ) {
+        m_dir = dir;
+    }
+    else if ( xdg != NULL && xdg[0] != '\0' ) {
+        m_dir = std::string( xdg ) + "/clmagma";
+    }
+    else if ( home != NULL && home[0] != '\0' ) {
+        m_dir = std::string( home ) + "/.cache/clmagma";
+    }
+    else {
+        m_dir = "";
+    }
+    while( m_dir.size() > 1 && m_dir[ m_dir.size()-1 ] == '/' ) {
+        m_dir.erase( m_dir.size()-1 );
+    }
+
+    // directory is created on first store
+    m_enabled  = (m_dir != "");
+    pthread_mutex_lock( &m_mutex );
+    m_readonly = false;
+    pthread_mutex_unlock( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+void clmagma_progcache::quit()
+{
+    m_context = NULL;
+    m_enabled = false;
+    m_devices.clear();
+}
+
+
+// ------------------------------------------------------------
+/// Returns the name of the entry for source compiled with options on the
+/// current devices. src should include the contents of any included files: 32 hex digits from two independent 64-bit hashes.
+std::string clmagma_progcache::key(
+    const std::string& src, const std::string& options ) const
+{
+    std::string meta = std::string( c_magic, sizeof(c_magic) ) + '\n'
+                     + m_fingerprint + options + '\n';
+    unsigned long long h1 = 14695981039346656037ULL;
+    unsigned long long h2 = 0x6a09e667f3bcc908ULL;
+    h1 = fnv1a( src, fnv1a( meta, h1 ));
+    h2 = fnv1a( meta, fnv1a( src, h2 ));
+
+    char buf[40];
+    snprintf( buf, sizeof(buf), "%016llx%016llx", h1, h2 );
+    return buf;
+}
+
+
+// ------------------------------------------------------------
+std::string clmagma_progcache::entry_path( const std::string& key ) const
+{
+    return m_dir + '/' + key + ".co";
+}
+
+
+// ------------------------------------------------------------
+/// Returns the program stored under key, built for all devices,
+/// or NULL if there is no usable entry. The caller releases the program.
+/// Entries the driver rejects are removed so that they are rebuilt.
+cl_program clmagma_progcache::load( const std::string& key )
+{
+    if ( ! m_enabled || m_context == NULL )
+        return NULL;
+
+    std::string path = entry_path( key );
+    FILE* file = fopen( path.c_str(), "rb" );
+    if ( file == NULL )
+        return NULL;
+
+    // layout: magic, key, # devices, then size and binary per device
+    cl_uint num_devices = (cl_uint) m_devices.size();
+    std::vector< size_t >        sizes( num_devices );
+    std::vector< std::string >   binaries( num_devices );
+    std::vector< const unsigned char* > ptrs( num_devices );
+    std::vector< cl_int >        statuses( num_devices );
+
+    char     magic[ sizeof(c_magic) ];
+    char     stored_key[ 32 ];
+    cl_uint  stored_devices = 0;
+    bool ok = (fread( magic,       1, sizeof(magic),      file ) == sizeof(magic)
+            && fread( stored_key,  1, sizeof(stored_key), file ) == sizeof(stored_key)
+            && fread( &stored_devices, sizeof(stored_devices), 1, file ) == 1
+            && memcmp( magic, c_magic, sizeof(magic) ) == 0
+            && key.size() == sizeof(stored_key)
+            && memcmp( stored_key, key.data(), sizeof(stored_key) ) == 0
+            && stored_devices == num_devices);
+    for( cl_uint dev=0; ok && dev < num_devices; ++dev ) {
+        ok = (fread( &sizes[dev], sizeof(sizes[dev]), 1, file ) == 1
+              && sizes[dev] > 0 && sizes[dev] <= c_max_entry);
+        if ( ok ) {
+            binaries[dev].resize( sizes[dev] );
+            ok = (fread( &binaries[dev][0], 1, sizes[dev], file ) == sizes[dev]);
+            ptrs[dev] = (const unsigned char*) binaries[dev].data();
+        }
+    }
+    fclose( file );
+
+    cl_program program = NULL;
+    cl_int err = CL_SUCCESS;
+    if ( ok ) {
+        program = clCreateProgramWithBinary(
+            m_context, num_devices, &m_devices[0],
+            &sizes[0], &ptrs[0], &statuses[0], &err );
+        for( cl_uint dev=0; err == CL_SUCCESS && dev < num_devices; ++dev ) {
+            err = statuses[dev];
+        }
+        if ( err == CL_SUCCESS ) {
+            err = clBuildProgram( program, num_devices, &m_devices[0], NULL, NULL, NULL );
+        }
+        if ( err != CL_SUCCESS && program != NULL ) {
+            clReleaseProgram( program );
+            program = NULL;
+        }
+    }
+    if ( program == NULL ) {
+        unlink( path.c_str() );
+    }
+    return program;
+}
+
+
+// ------------------------------------------------------------
+/// Stores the binaries of program under key. Failures are silent apart from
+/// a warning, since the program can always be rebuilt from source.
+void clmagma_progcache::store( const std::string& key, cl_program program )
+{
+    if ( ! m_enabled || m_context == NULL )
+        return;
+
+    cl_uint num_devices = (cl_uint) m_devices.size();
+    std::vector< size_t >         sizes( num_devices );
+    std::vector< unsigned char* > binaries( num_devices );
+
+    cl_int err = clGetProgramInfo( program, CL_PROGRAM_BINARY_SIZES,
+                                   num_devices*sizeof(sizes[0]), &sizes[0], NULL );
+    if ( err != CL_SUCCESS )
+        return;
+    for( cl_uint dev=0; dev < num_devices; ++dev ) {
+        if ( sizes[dev] == 0 )
+            return;  // not built for this device
+    }
+    for( cl_uint dev=0; dev < num_devices; ++dev ) {
+        binaries[dev] = new unsigned char[ sizes[dev] ];
+    }
+    err = clGetProgramInfo( program, CL_PROGRAM_BINARIES,
+                            num_devices*sizeof(binaries[0]), &binaries[0], NULL );
+
+    // write to a unique temporary file in the same directory,
+    // then rename over the entry, which is atomic
+    std::string tmp;
+    FILE* file = NULL;
+    pthread_mutex_lock( &m_mutex );
+    bool readonly = m_readonly;
+    unsigned long seq = m_seq++;
+    pthread_mutex_unlock( &m_mutex );
+    bool ok = (err == CL_SUCCESS && key.size() == 32 && ! readonly && make_dirs( m_dir ));
+    if ( ok ) {
+
+        char suffix[64];
+        snprintf( suffix, sizeof(suffix), ".tmp.%ld.%lu", (long) getpid(), seq );
+        tmp = entry_path( key ) + suffix;
+
+        file = fopen( tmp.c_str(), "wb" );
+        ok = (file != NULL);
+        if ( ok ) {
+            ok = (fwrite( c_magic,    1, sizeof(c_magic), file ) == sizeof(c_magic)
+               && fwrite( key.data(), 1, key.size(),      file ) == key.size()
+               && fwrite( &num_devices, sizeof(num_devices), 1, file ) == 1);
+            for( cl_uint dev=0; ok && dev < num_devices; ++dev ) {
+                ok = (fwrite( &sizes[dev], sizeof(sizes[dev]), 1, file ) == 1
+                   && fwrite( binaries[dev], 1, sizes[dev], file ) == sizes[dev]);
+            }
+            ok = (fflush( file ) == 0) && ok;
+            ok = (fclose( file ) == 0) && ok;
+        }
+        if ( ok ) {
+            ok = (rename( tmp.c_str(), entry_path( key ).c_str() ) == 0);
+        }
+    }
+    if ( ! ok && err == CL_SUCCESS && ! readonly ) {
+        // warn once; entries may still be read from a pre-populated directory
+        int save_errno = errno;
+        pthread_mutex_lock( &m_mutex );
+        bool warn = ! m_readonly;
+        m_readonly = true;
+        pthread_mutex_unlock( &m_mutex );
+        if ( warn ) {
+            fprintf( stderr, "Warning: can't write kernel cache in '%s': %s (%d)\n",
+                     m_dir.c_str(), strerror(save_errno), save_errno );
+        }
+        if ( file != NULL ) {
+            unlink( tmp.c_str() );
+        }
+    }
+
+    for( cl_uint dev=0; dev < num_devices; ++dev ) {
+        delete [] binaries[dev];
+    }
+}
@@ -0,0 +1,59 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#ifndef CLMAGMA_PROGCACHE_H
+#define CLMAGMA_PROGCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "common_magma.h"  // includes OpenCL, pthread, etc.
+
+
+// ------------------------------------------------------------
+// On-disk cache of compiled OpenCL programs for the devices of a context.
+//
+// Entries live in $CLMAGMA_CACHE_DIR, or $XDG_CACHE_HOME/clmagma, or
+// $HOME/.cache/clmagma, in that order. Each entry is named by a hash of the
+// program source together with the headers it includes, build options, and
+// the name, vendor, device version, and driver version of every device, so a driver upgrade or different GPU
+// misses instead of loading a stale binary. Entries are written to a
+// temporary file and renamed into place, so concurrent processes never
+// see a partial entry; the last writer of identical content wins.
+//
+// Set $CLMAGMA_CACHE_DIR to an empty string to disable the cache.
+class clmagma_progcache
+{
+public:
+    // ------------------------------
+    clmagma_progcache();
+    ~clmagma_progcache();
+
+    // ------------------------------
+    void        init( cl_context context, cl_uint num_devices, const cl_device_id* devices );
+    void        quit();
+
+    bool        enabled() const { return m_enabled; }
+    std::string key  ( const std::string& src, const std::string& options ) const;
+    cl_program  load ( const std::string& key );
+    void        store( const std::string& key, cl_program program );
+
+    // ==============================
+private:
+    std::string entry_path( const std::string& key ) const;
+
+    cl_context      m_context;
+    bool            m_enabled;
+    bool            m_readonly;     ///< set after a failed store, under m_mutex
+    std::string     m_dir;          ///< cache directory
+    std::string     m_fingerprint;  ///< platform and devices, part of every key
+    std::vector< cl_device_id > m_devices;
+    pthread_mutex_t m_mutex;        ///< lock for m_seq and m_readonly
+    unsigned long   m_seq;          ///< makes temporary file names unique
+};
+
+#endif        //  #ifndef CLMAGMA_PROGCACHE_H
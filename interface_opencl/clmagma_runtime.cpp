@@ -1,7 +1,9 @@
 #include <sys/stat.h>
 #include <errno.h>
 
+#include <algorithm>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -138,24 +140,321 @@ void replace_all(
 
 
 // ------------------------------------------------------------
-/// Initialize clMagma runtime.
-/// Queries for OpenCL platforms and devices, and creates an OpenCL context.
-void clmagma_runtime::init( bool require_double )
+/// Returns the build option that adds the directory of infile to the
+/// include path, so kernels can #include headers next to them.
+std::string include_option( const std::string& infile )
 {
-    char device_name[1024];
-    cl_int err;
+    size_t i = infile.find_last_of( '/' );
+    if ( i != std::string::npos ) {
+        return "-I " + infile.substr( 0, i );
+    }
+    else {
+        return "-I .";
+    }
+}
+
+
+// ------------------------------------------------------------
+/// Appends to deps the contents of the files that src includes with
+/// #include "file", recursively, resolved in dir as the -I option from
+/// include_option does. Each file is appended once; seen holds the files
+/// already visited. Files that don't exist are skipped, since the compiler
+/// will report them.
+static void append_includes(
+    const std::string& src, const std::string& dir,
+    std::set< std::string >& seen, std::string& deps )
+{
+    size_t i = 0;
+    while( (i = src.find( "#include", i )) != std::string::npos ) {
+        i += 8;
+        size_t begin = src.find_first_not_of( " \t", i );
+        if ( begin == std::string::npos || src[begin] != '"' )
+            continue;
+        size_t end = src.find( '"', begin+1 );
+        if ( end == std::string::npos || src.find( '\n', begin ) < end )
+            continue;
+        std::string name = src.substr( begin+1, end-begin-1 );
+        std::string file = path_join( dir, name );
+        if ( seen.count( file ) || ! path_exists( file ))
+            continue;
+        seen.insert( file );
+        // hash the name as written, not the install path
+        std::string contents = read_file( file );
+        deps += name + '\n' + contents + '\n';
+        append_includes( contents, dir, seen, deps );
+    }
+}
+
+
+// ------------------------------------------------------------
+/// Returns src followed by the contents of all files it includes, so that
+/// the program cache key changes when a shared header changes.
+std::string source_with_includes( const std::string& infile, const std::string& src )
+{
+    size_t i = infile.find_last_of( '/' );
+    std::string dir = (i != std::string::npos ? infile.substr( 0, i ) : ".");
+    std::set< std::string > seen;
+    std::string deps = src;
+    append_includes( src, dir, seen, deps );
+    return deps;
+}
+
+
+// ------------------------------------------------------------
+/// Immutable open-addressing hash table from kernel name to kernel.
+struct clmagma_runtime::kernel_table_t
+{
+    struct entry_t {
+        std::string name;    ///< "" for an empty slot
+        cl_kernel   kernel;
+    };
+    
+    std::vector< entry_t > slots;  ///< size is a power of 2, at most half full
+    
+    static size_t hash( const char* name )
+    {
+        // FNV-1a
+        size_t h = 2166136261u;
+        for( ; *name != '\0'; ++name ) {
+            h ^= (unsigned char) *name;
+            h *= 16777619u;
+        }
+        return h;
+    }
+    
+    kernel_table_t( const std::map< std::string, cl_kernel >& kernels )
+    {
+        size_t size = 16;
+        while( size < 2*kernels.size() ) {
+            size *= 2;
+        }
+        entry_t empty = { "", NULL };
+        slots.resize( size, empty );
+        std::map< std::string, cl_kernel >::const_iterator it;
+        for( it = kernels.begin(); it != kernels.end(); ++it ) {
+            size_t i = hash( it->first.c_str() ) & (size - 1);
+            while( slots[i].kernel != NULL ) {
+                i = (i + 1) & (size - 1);
+            }
+            slots[i].name   = it->first;
+            slots[i].kernel = it->second;
+        }
+    }
+    
+    cl_kernel find( const char* name ) const
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = hash( name ) & mask;
+        while( slots[i].kernel != NULL ) {
+            if ( slots[i].name == name ) {
+                return slots[i].kernel;
+            }
+            i = (i + 1) & mask;
+        }
+        return NULL;
+    }
+};
+
+
+// ------------------------------------------------------------
+/// Clones of kernels owned by one thread, keyed by the kernel in m_table.
+/// Clones from before the last quit (older generation) are already released.
+struct clmagma_runtime::thread_kernels_t
+{
+    unsigned generation;
+    std::map< cl_kernel, cl_kernel > clones;
+};
 
-    cl_platform_id platform;
-    cl_uint num_platforms;
-    err = clGetPlatformIDs( 1, &platform, &num_platforms );
+
+// ------------------------------------------------------------
+clmagma_runtime::clmagma_runtime():
+    m_bExternalContext (false),
+    m_platform     ( NULL ),
+    m_num_devices  ( 0 ),
+    m_context      ( NULL ),
+    m_table        ( NULL ),
+    m_generation   ( 0 )
+{
+    pthread_mutex_init( &m_kernels_mutex, NULL );
+    pthread_mutex_init( &m_compile_mutex, NULL );
+    pthread_key_create( &m_thread_key, release_thread_kernels );
+}
+
+
+// ------------------------------------------------------------
+clmagma_runtime::~clmagma_runtime()
+{
+    quit();
+    pthread_key_delete( m_thread_key );
+    pthread_mutex_destroy( &m_compile_mutex );
+    pthread_mutex_destroy( &m_kernels_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Returns kernel for use by the calling thread, compiling its file on first
+/// use. Lookup takes no lock; only the first call for a kernel in each
+/// thread, which creates the thread's clone, locks briefly.
+cl_kernel clmagma_runtime::get_kernel( const char* name )
+{
+    //printf( "kernel: %s\n", name );
+    kernel_table_t* table = m_table.load( std::memory_order_acquire );
+    cl_kernel k = (table == NULL ? NULL : table->find( name ));
+    if ( k == NULL ) {
+        // another thread may be compiling the same file; check again after it
+        pthread_mutex_lock( &m_compile_mutex );
+        table = m_table.load( std::memory_order_acquire );
+        k = (table == NULL ? NULL : table->find( name ));
+        int err = 0;
+        if ( k == NULL ) {
+            err = compile_kernel( name );
+            table = m_table.load( std::memory_order_acquire );
+            k = (table == NULL ? NULL : table->find( name ));
+        }
+        pthread_mutex_unlock( &m_compile_mutex );
+        if ( err != 0 || k == NULL ) {
+            fprintf( stderr, "Error: kernel '%s' not found\n", name );
+            return NULL;
+        }
+    }
+    return get_thread_kernel( k, name );
+}
+
+
+// ------------------------------------------------------------
+/// Returns the calling thread's clone of kernel, creating it on first use.
+cl_kernel clmagma_runtime::get_thread_kernel( cl_kernel kernel, const char* name )
+{
+    unsigned generation = m_generation.load( std::memory_order_acquire );
+    thread_kernels_t* mine = (thread_kernels_t*) pthread_getspecific( m_thread_key );
+    if ( mine == NULL ) {
+        mine = new thread_kernels_t;
+        mine->generation = generation;
+        pthread_setspecific( m_thread_key, mine );
+    }
+    else if ( mine->generation != generation ) {
+        mine->clones.clear();
+        mine->generation = generation;
+    }
+    
+    std::map< cl_kernel, cl_kernel >::const_iterator it = mine->clones.find( kernel );
+    if ( it != mine->clones.end() ) {
+        return it->second;
+    }
+    
+    cl_program program;
+    cl_int err = clGetKernelInfo( kernel, CL_KERNEL_PROGRAM, sizeof(program), &program, NULL );
     check_error( err );
+    if ( err != CL_SUCCESS ) {
+        return NULL;
+    }
+    cl_kernel clone = clCreateKernel( program, name, &err );
+    check_error( err );
+    if ( err != CL_SUCCESS ) {
+        return NULL;
+    }
     
-    // TODO allocate m_devices. This next (commented out) line counts them.
-    //err = clGetDeviceIDs( platform, CL_DEVICE_TYPE_GPU, 0, NULL, &m_num_devices );
+    pthread_mutex_lock( &m_kernels_mutex );
+    m_clones.insert( clone );
+    pthread_mutex_unlock( &m_kernels_mutex );
+    mine->clones[ kernel ] = clone;
+    return clone;
+}
 
-    // err = clGetDeviceIDs( platform, CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR, MAX_DEVICES, m_devices, &m_num_devices );
-    err = clGetDeviceIDs( platform, CL_DEVICE_TYPE_ALL, MAX_DEVICES, m_devices, &m_num_devices );
+
+// ------------------------------------------------------------
+/// Releases a thread's clones when the thread exits.
+/// Registered as the destructor of m_thread_key.
+void clmagma_runtime::release_thread_kernels( void* arg )
+{
+    thread_kernels_t* mine = (thread_kernels_t*) arg;
+    clmagma_runtime& rt = g_runtime;
+    pthread_mutex_lock( &rt.m_kernels_mutex );
+    if ( mine->generation == rt.m_generation.load() ) {
+        std::map< cl_kernel, cl_kernel >::iterator it;
+        for( it = mine->clones.begin(); it != mine->clones.end(); ++it ) {
+            if ( rt.m_clones.erase( it->second ) > 0 ) {
+                clReleaseKernel( it->second );
+            }
+        }
+    }
+    pthread_mutex_unlock( &rt.m_kernels_mutex );
+    delete mine;
+}
+
+
+// ------------------------------------------------------------
+/// Replaces m_table with a snapshot of m_kernels.
+/// Must be called with m_kernels_mutex held.
+void clmagma_runtime::publish_kernels()
+{
+    kernel_table_t* table = new kernel_table_t( m_kernels );
+    kernel_table_t* old = m_table.exchange( table, std::memory_order_acq_rel );
+    if ( old != NULL ) {
+        m_old_tables.push_back( old );
+    }
+}
+
+
+// ------------------------------------------------------------
+/// Returns the visible devices of all platforms.
+/// $MAGMA_VISIBLE_DEVICES is a comma-separated list of indices into all
+/// devices of all platforms, numbered in the order the platforms and their
+/// devices are reported, e.g., "2,0". If unset, all devices are visible.
+/// If require_double, devices without double precision are skipped.
+void clmagma_runtime::select_devices(
+    std::vector< cl_device_id >& devices, bool require_double )
+{
+    char device_name[1024];
+    cl_int err;
+    
+    cl_uint num_platforms = 0;
+    err = clGetPlatformIDs( 0, NULL, &num_platforms );
     check_error( err );
+    std::vector< cl_platform_id > platforms( num_platforms );
+    if ( num_platforms > 0 ) {
+        err = clGetPlatformIDs( num_platforms, &platforms[0], NULL );
+        check_error( err );
+    }
+    
+    // a platform without devices is not an error
+    std::vector< cl_device_id > all;
+    for( cl_uint p=0; p < num_platforms; ++p ) {
+        cl_uint num = 0;
+        err = clGetDeviceIDs( platforms[p], CL_DEVICE_TYPE_ALL, 0, NULL, &num );
+        if ( err != CL_SUCCESS || num == 0 )
+            continue;
+        size_t first = all.size();
+        all.resize( first + num );
+        err = clGetDeviceIDs( platforms[p], CL_DEVICE_TYPE_ALL, num, &all[first], NULL );
+        check_error( err );
+    }
+    
+    devices.clear();
+    const char* visible = getenv( "MAGMA_VISIBLE_DEVICES" );
+    if ( visible == NULL ) {
+        devices = all;
+    }
+    else {
+        const char* str = visible;
+        while( *str != '\0' ) {
+            char* endptr;
+            long dev = strtol( str, &endptr, 10 );
+            if ( endptr == str || (*endptr != ',' && *endptr != '\0') ) {
+                fprintf( stderr, "Warning: $MAGMA_VISIBLE_DEVICES='%s' is invalid after '%.*s'; ignoring rest.\n",
+                         visible, (int)(str - visible), visible );
+                break;
+            }
+            if ( dev < 0 || dev >= (long) all.size() ) {
+                fprintf( stderr, "Warning: $MAGMA_VISIBLE_DEVICES='%s': device %ld does not exist; %d devices available.\n",
+                         visible, dev, (int) all.size() );
+            }
+            else if ( std::find( devices.begin(), devices.end(), all[dev] ) == devices.end() ) {
+                devices.push_back( all[dev] );
+            }
+            str = (*endptr == ',' ? endptr+1 : endptr);
+        }
+    }
     
     // MAGMA requires double precision; skip devices that lack it.
     // Otherwise we get compile errors for some devices but not others,
@@ -163,40 +462,218 @@ void clmagma_runtime::init( bool require_double )
     // and such to fail (abort).
     // 不支持双精度， 修改了 clmagma_runtime.h 中 require_double = false
     if ( require_double ) {
-        unsigned int good = 0;
-        for( unsigned int dev=0; dev < m_num_devices; ++dev ) {
+        size_t good = 0;
+        for( size_t dev=0; dev < devices.size(); ++dev ) {
             cl_device_fp_config config;
-            err = clGetDeviceInfo( m_devices[dev], CL_DEVICE_DOUBLE_FP_CONFIG, sizeof(config), &config, NULL );
+            err = clGetDeviceInfo( devices[dev], CL_DEVICE_DOUBLE_FP_CONFIG, sizeof(config), &config, NULL );
             check_error( err );
             if ( config == 0 ) {
-                clGetDeviceInfo( m_devices[dev], CL_DEVICE_NAME, sizeof(device_name), device_name,  NULL );
+                clGetDeviceInfo( devices[dev], CL_DEVICE_NAME, sizeof(device_name), device_name,  NULL );
                 //fprintf( stderr, "skippping device %s: doesn't support double precision\n", device_name );
             }
             else {
                 // move good devices up
-                if ( dev != good ) {
-                    m_devices[good] = m_devices[dev];
-                }
+                devices[good] = devices[dev];
                 ++good;
             }
         }
-        m_num_devices = good;
+        devices.resize( good );
+    }
+}
+
+
+// ------------------------------------------------------------
+/// Returns the properties for clCreateSubDevices to split device as given
+/// by partition (see partition_devices), or an empty list if partition is
+/// invalid for device.
+static std::vector< cl_device_partition_property >
+partition_properties( const std::string& partition, cl_device_id device )
+{
+    static const struct {
+        const char* name;
+        cl_device_affinity_domain domain;
+    } c_domains[] = {
+        { "numa", CL_DEVICE_AFFINITY_DOMAIN_NUMA },
+        { "l4",   CL_DEVICE_AFFINITY_DOMAIN_L4_CACHE },
+        { "l3",   CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE },
+        { "l2",   CL_DEVICE_AFFINITY_DOMAIN_L2_CACHE },
+        { "l1",   CL_DEVICE_AFFINITY_DOMAIN_L1_CACHE },
+        { "next", CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE },
+    };
+    
+    std::vector< cl_device_partition_property > props;
+    for( size_t i=0; i < sizeof(c_domains)/sizeof(*c_domains); ++i ) {
+        if ( partition == c_domains[i].name ) {
+            props.push_back( CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN );
+            props.push_back( (cl_device_partition_property) c_domains[i].domain );
+            props.push_back( 0 );
+            return props;
+        }
     }
     
-    //char driver[1024];
-    //cl_ulong mem_size, alloc_size;
-    //for( int dev=0; dev < m_num_devices; ++dev ) {
-    //    clGetDeviceInfo( m_devices[dev], CL_DEVICE_NAME,               sizeof(device_name), device_name, NULL );
-    //    clGetDeviceInfo( m_devices[dev], CL_DEVICE_GLOBAL_MEM_SIZE,    sizeof(mem_size),    &mem_size,   NULL );
-    //    clGetDeviceInfo( m_devices[dev], CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(alloc_size),  &alloc_size, NULL );
-    //    clGetDeviceInfo( m_devices[dev], CL_DRIVER_VERSION,            sizeof(driver),      driver,      NULL );
-    //    printf( "Device %d: %-16s (memory %3.1f GiB, max allocation %3.1f GiB, driver %s)\n",
-    //            dev, device_name, mem_size/(1024.*1024.*1024.), alloc_size/(1024.*1024.*1024.), driver );
-    //}
-    // JJW 的 m_num_device 只有一个
-    m_num_devices = 1;
-    m_context = clCreateContext( NULL, m_num_devices, m_devices, NULL, NULL, &err );
-    check_error( err );
+    // number of equal parts, or list of compute units per part
+    std::vector< cl_uint > counts;
+    const char* str = partition.c_str();
+    while( *str != '\0' ) {
+        char* endptr;
+        long count = strtol( str, &endptr, 10 );
+        if ( endptr == str || count < 1 || (*endptr != ',' && *endptr != '\0') ) {
+            return props;
+        }
+        counts.push_back( (cl_uint) count );
+        str = (*endptr == ',' ? endptr+1 : endptr);
+    }
+    if ( counts.size() == 1 ) {
+        // give the remainder of compute units to the first parts
+        cl_uint nparts = counts[0];
+        cl_uint units  = 0;
+        clGetDeviceInfo( device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(units), &units, NULL );
+        if ( nparts > units ) {
+            return props;
+        }
+        counts.assign( nparts, units / nparts );
+        for( cl_uint i=0; i < units % nparts; ++i ) {
+            counts[i] += 1;
+        }
+    }
+    if ( counts.size() > 0 ) {
+        props.push_back( CL_DEVICE_PARTITION_BY_COUNTS );
+        for( size_t i=0; i < counts.size(); ++i ) {
+            props.push_back( counts[i] );
+        }
+        props.push_back( CL_DEVICE_PARTITION_BY_COUNTS_LIST_END );
+        props.push_back( 0 );
+    }
+    return props;
+}
+
+
+// ------------------------------------------------------------
+/// Replaces each device by its sub-devices, as given by partition:
+///     n           n sub-devices with equal numbers of compute units;
+///     c1,c2,...   sub-devices with c1, c2, ... compute units;
+///     numa, l4, l3, l2, l1, next
+///                 a sub-device per NUMA node or shared cache, or per
+///                 the device's first partitionable affinity domain.
+/// An empty partition or "1" leaves devices whole. Devices that can't be
+/// partitioned, e.g., most GPUs, are kept whole, with a warning.
+/// Sub-devices are released by quit.
+void clmagma_runtime::partition_devices(
+    std::vector< cl_device_id >& devices, const std::string& partition )
+{
+    if ( partition == "" || partition == "1" )
+        return;
+    
+    std::vector< cl_device_id > result;
+    for( size_t dev=0; dev < devices.size(); ++dev ) {
+        std::vector< cl_device_partition_property > props
+            = partition_properties( partition, devices[dev] );
+        cl_uint num = 0;
+        cl_int err = CL_INVALID_VALUE;
+        if ( props.size() > 0 ) {
+            err = clCreateSubDevices( devices[dev], &props[0], 0, NULL, &num );
+        }
+        if ( err == CL_SUCCESS && num > 0 ) {
+            size_t first = result.size();
+            result.resize( first + num );
+            err = clCreateSubDevices( devices[dev], &props[0], num, &result[first], NULL );
+            if ( err == CL_SUCCESS ) {
+                m_subdevices.insert( m_subdevices.end(), result.begin() + first, result.end() );
+                continue;
+            }
+            result.resize( first );
+        }
+        char name[1024] = "";
+        clGetDeviceInfo( devices[dev], CL_DEVICE_NAME, sizeof(name), name, NULL );
+        fprintf( stderr, "Warning: can't partition device %s into sub-devices '%s' (error %d); using whole device.\n",
+                 name, partition.c_str(), (int) err );
+        result.push_back( devices[dev] );
+    }
+    devices = result;
+}
+
+
+// ------------------------------------------------------------
+/// Initialize clMagma runtime.
+/// Queries for OpenCL platforms and devices, and creates an OpenCL context
+/// for each platform that has visible devices. The context of the first
+/// visible device's platform, m_context, is the one MAGMA computes in: its
+/// memory pool, pinned buffers, events, and kernels are all in m_context.
+/// Devices are split into sub-devices as given by partition, or if NULL,
+/// by $MAGMA_NUM_SUBDEVICES; see partition_devices.
+void clmagma_runtime::init( bool require_double, const char* partition )
+{
+    cl_int err;
+    
+    std::vector< cl_device_id > devices;
+    select_devices( devices, require_double );
+    if ( partition == NULL ) {
+        partition = getenv( "MAGMA_NUM_SUBDEVICES" );
+    }
+    partition_devices( devices, partition == NULL ? "" : partition );
+    if ( devices.empty() ) {
+        fprintf( stderr, "Error in %s: no OpenCL devices found (check $MAGMA_VISIBLE_DEVICES).\n", __func__ );
+        return;
+    }
+    
+    // group devices by platform, in order of each platform's first device
+    std::vector< cl_platform_id > platforms;
+    std::vector< size_t > device_platforms( devices.size() );
+    for( size_t dev=0; dev < devices.size(); ++dev ) {
+        cl_platform_id platform = NULL;
+        err = clGetDeviceInfo( devices[dev], CL_DEVICE_PLATFORM, sizeof(platform), &platform, NULL );
+        check_error( err );
+        size_t p = std::find( platforms.begin(), platforms.end(), platform ) - platforms.begin();
+        if ( p == platforms.size() ) {
+            platforms.push_back( platform );
+        }
+        device_platforms[dev] = p;
+    }
+    
+    m_devices.clear();
+    m_device_contexts.clear();
+    m_contexts.clear();
+    m_platform = NULL;
+    for( size_t p=0; p < platforms.size(); ++p ) {
+        std::vector< cl_device_id > pdevices;
+        for( size_t dev=0; dev < devices.size(); ++dev ) {
+            if ( device_platforms[dev] == p ) {
+                pdevices.push_back( devices[dev] );
+            }
+        }
+        cl_context_properties props[] = {
+            CL_CONTEXT_PLATFORM, (cl_context_properties) platforms[p], 0
+        };
+        cl_context context = clCreateContext( props, (cl_uint) pdevices.size(), &pdevices[0],
+                                              NULL, NULL, &err );
+        check_error( err );
+        if ( err != CL_SUCCESS ) {
+            continue;  // skip this platform's devices
+        }
+        if ( m_contexts.empty() ) {
+            m_platform = platforms[p];
+        }
+        m_contexts.push_back( context );
+        for( size_t dev=0; dev < pdevices.size(); ++dev ) {
+            m_devices.push_back( pdevices[dev] );
+            m_device_contexts.push_back( (int) m_contexts.size() - 1 );
+        }
+    }
+    if ( m_contexts.empty() ) {
+        fprintf( stderr, "Error in %s: can't create an OpenCL context.\n", __func__ );
+        return;
+    }
+    
+    m_context = m_contexts[0];
+    m_num_devices = 0;
+    while( m_num_devices < m_devices.size() && m_device_contexts[ m_num_devices ] == 0 ) {
+        ++m_num_devices;
+    }
+    m_mempool.init( m_context );
+    m_pinned.init( m_context, m_num_devices, &m_devices[0] );
+    m_events.init( m_context );
+    m_progcache.init( m_context, m_num_devices, &m_devices[0] );
+    m_nbprofile.init( m_num_devices, get_devices() );
     
     // create map from kernel name -> file name
     for( int i=0; i < c_kernel_files_len; ++i ) {
@@ -222,11 +699,8 @@ void clmagma_runtime::init(std::vector<cl_device_id> devices, cl_context context
 
     m_bExternalContext = true;
 
+    m_devices = devices;
     m_num_devices = devices.size();
-    for (unsigned int i=0;i<m_num_devices;i++)
-    {
-        m_devices[i] = devices[i];
-    }
 
     if ( require_double )
     {
@@ -251,9 +725,22 @@ void clmagma_runtime::init(std::vector<cl_device_id> devices, cl_context context
             }
         }
         m_num_devices = good;
+        m_devices.resize( good );
     }
 
     m_context = context;
+    m_contexts.assign( 1, context );
+    m_device_contexts.assign( m_num_devices, 0 );
+    m_platform = NULL;
+    if ( m_num_devices > 0 )
+    {
+        clGetDeviceInfo( m_devices[0], CL_DEVICE_PLATFORM, sizeof(m_platform), &m_platform, NULL );
+    }
+    m_mempool.init( m_context );
+    m_pinned.init( m_context, m_num_devices, &m_devices[0] );
+    m_events.init( m_context );
+    m_progcache.init( m_context, m_num_devices, &m_devices[0] );
+    m_nbprofile.init( m_num_devices, get_devices() );
 
     // create map from kernel name -> file name
     for( int i=0; i < c_kernel_files_len; ++i )
@@ -275,27 +762,77 @@ void clmagma_runtime::init(std::vector<cl_device_id> devices, cl_context context
 
 // ------------------------------------------------------------
 /// Quit clMagma runtime.
-/// Releases all kernels and the OpenCL context.
+/// Releases all kernels, events, pinned and cached device buffers, and the OpenCL context.
 void clmagma_runtime::quit()
 {
     cl_int err;
-    std::map< std::string, cl_kernel >::iterator it, end;
-    it  = m_kernels.begin();
-    end = m_kernels.end();
-    for( ; it != end; ++it ) {
-        if ( (*it).second != NULL ) {
-            err = clReleaseKernel( (*it).second );
+    m_progcache.quit();
+    m_nbprofile.quit();
+    m_events.quit();
+    m_pinned.quit();
+    m_scratch.quit();
+    m_mempool.quit();
+    
+    // threads' cached clones become stale when the generation changes
+    pthread_mutex_lock( &m_kernels_mutex );
+    m_generation.fetch_add( 1, std::memory_order_acq_rel );
+    std::set< cl_kernel >::iterator c;
+    for( c = m_clones.begin(); c != m_clones.end(); ++c ) {
+        err = clReleaseKernel( *c );
+        check_error( err );
+    }
+    m_clones.clear();
+    
+    std::map< std::string, cl_kernel >::iterator it;
+    for( it = m_kernels.begin(); it != m_kernels.end(); ++it ) {
+        if ( it->second != NULL ) {
+            err = clReleaseKernel( it->second );
             check_error( err );
         }
-        m_kernels[ (*it).first ] = NULL;  // TODO how to delete entry from map?
     }
     m_kernels.clear();
+    for( size_t i=0; i < m_old_kernels.size(); ++i ) {
+        err = clReleaseKernel( m_old_kernels[i] );
+        check_error( err );
+    }
+    m_old_kernels.clear();
+    
+    delete m_table.exchange( NULL );
+    for( size_t i=0; i < m_old_tables.size(); ++i ) {
+        delete m_old_tables[i];
+    }
+    m_old_tables.clear();
+    pthread_mutex_unlock( &m_kernels_mutex );
     
-    if ( m_context && !m_bExternalContext ) {
-        err = clReleaseContext( m_context );
+    if ( ! m_bExternalContext ) {
+        for( size_t i=0; i < m_contexts.size(); ++i ) {
+            err = clReleaseContext( m_contexts[i] );
+            check_error( err );
+        }
+    }
+    m_context = NULL;
+    m_contexts.clear();
+    for( size_t i=0; i < m_subdevices.size(); ++i ) {
+        err = clReleaseDevice( m_subdevices[i] );
         check_error( err );
-        m_context = NULL;
     }
+    m_subdevices.clear();
+    m_devices.clear();
+    m_device_contexts.clear();
+    m_num_devices = 0;
+}
+
+
+// ------------------------------------------------------------
+/// Returns the context of a visible device, or NULL if device is not visible.
+cl_context clmagma_runtime::get_device_context( cl_device_id device ) const
+{
+    for( size_t dev=0; dev < m_devices.size(); ++dev ) {
+        if ( m_devices[dev] == device ) {
+            return m_contexts[ m_device_contexts[dev] ];
+        }
+    }
+    return NULL;
 }
 
 
@@ -305,11 +842,12 @@ void clmagma_runtime::quit()
 int clmagma_runtime::compile_kernel(
     const char* kernel )
 {
-    std::string file = m_kernel_files[ kernel ];
-    if ( file == "" ) {
+    std::map< std::string, std::string >::const_iterator it = m_kernel_files.find( kernel );
+    if ( it == m_kernel_files.end() ) {
         fprintf( stderr, "Error: kernel '%s' not found in kernel_files map (check clmagmablas/kernels.cpp)\n", kernel );
         return MAGMA_ERR_NOT_FOUND;
     }
+    const std::string& file = it->second;
     
     std::string path = search_path( file, m_path );
     if ( path == "" ) {
@@ -317,7 +855,7 @@ int clmagma_runtime::compile_kernel(
         return MAGMA_ERR_NOT_FOUND;
     }
     
-    return compile_file( path.c_str(), NULL );
+    return compile_cached( path.c_str() );
 }
 
 
@@ -328,6 +866,7 @@ int clmagma_runtime::compile_kernel(
 /// If outfile is NULL, determines outfile name by replacing .cl with .co in infile.
 /// Also stores kernels into m_kernels map, where get_kernel() can obtain them.
 /// Prints compiler warnings & errors to stderr.
+/// Used by clcompile at build time; at run time, see compile_cached.
 int clmagma_runtime::compile_file(
     const char* infile,
     const char* outfile )
@@ -338,8 +877,7 @@ int clmagma_runtime::compile_file(
     }
     
     cl_program program = NULL;
-    cl_int     err, build_err;
-    char       data[ 32*1024 ];
+    cl_int     build_err;
     std::string src;
     
     //double start = get_wtime();
@@ -386,23 +924,147 @@ int clmagma_runtime::compile_file(
     }
     
     // compile
-    const char* src_str = src.c_str();
-    program = clCreateProgramWithSource( m_context, 1, (const char**)&src_str, NULL, &err );
-    check_error( err );
+    build_err = build_program( src, include_option( infile ), &program, NULL, NULL );
+    if ( program != NULL ) {
+        print_build_log( infile, program, build_err );
+    }
     
-    std::string inc = infile;
-    size_t i = inc.find_last_of( '/' );
-    if ( i != std::string::npos ) {
-        inc = "-I " + inc.substr( 0, i );
-        //printf( "path %s, inc %s\n", infile, inc.c_str() );
+    // save compiled binary
+    if ( build_err == 0 ) {
+        std::vector< cl_program > programs( 1, program );
+        load_kernels( programs );
+        save_programs( programs, outfile_str.c_str() );
     }
-    else {
-        inc = "-I .";
-        //printf( "path %s, no / using inc %s\n", infile, inc.c_str() );
+    if ( program != NULL ) {
+        clReleaseProgram( program );
+        program = NULL;
     }
-    build_err = clBuildProgram( program, m_num_devices, m_devices, inc.c_str(), NULL, NULL );
     
-    // print warnings & errors
+    //printf( "compile       time %.4f\n", get_wtime() - start );
+    return build_err;
+}
+
+
+// ------------------------------------------------------------
+/// Compiles a single file containing OpenCL kernels, going through the
+/// on-disk program cache (see clmagma_progcache) instead of writing a .co
+/// file next to the source, which may be in a read-only install tree.
+/// Used when kernels are compiled at run time, on first use.
+/// Also stores kernels into m_kernels map, where get_kernel() can obtain them.
+int clmagma_runtime::compile_cached(
+    const char* infile )
+{
+    cl_program  program = NULL;
+    std::string key;
+    bool        cached;
+    cl_int err = start_build( infile, &program, &key, &cached, NULL, NULL );
+    if ( program == NULL ) {
+        return err;
+    }
+    return finish_build( infile, program, key, cached );
+}
+
+
+// ------------------------------------------------------------
+/// First half of compile_cached: loads the program for infile from the
+/// program cache, or creates it from source and starts clBuildProgram with
+/// notify and user_data. If the program came from the cache, cached is set
+/// and notify is not called. Returns the error from clBuildProgram, or an
+/// error with program set to NULL if no program was created.
+/// Does not touch the kernel map, so it may be called from several threads.
+cl_int clmagma_runtime::start_build(
+    const char* infile, cl_program* program, std::string* key, bool* cached,
+    void (CL_CALLBACK *notify)( cl_program, void* ), void* user_data )
+{
+    *program = NULL;
+    *cached  = false;
+    if ( m_context == NULL ) {
+        fprintf( stderr, "Error in %s: runtime not initialized.\n", __func__ );
+        return -1;
+    }
+    
+    std::string src = read_file( infile );
+    if ( src.size() == 0 ) {
+        fprintf( stderr, "Error: empty file\n" );
+        return -1;
+    }
+    
+    std::string options = include_option( infile );
+    *key     = m_progcache.key( source_with_includes( infile, src ), options );
+    *program = m_progcache.load( *key );
+    if ( *program != NULL ) {
+        *cached = true;
+        return CL_SUCCESS;
+    }
+    return build_program( src, options, program, notify, user_data );
+}
+
+
+// ------------------------------------------------------------
+/// Second half of compile_cached, after the build has completed:
+/// prints compiler warnings & errors, stores a new program in the program
+/// cache, loads its kernels into the m_kernels map, and releases it.
+/// Returns 0 if the program was built for all devices.
+int clmagma_runtime::finish_build(
+    const char* infile, cl_program program, const std::string& key, bool cached )
+{
+    cl_int build_err = CL_SUCCESS;
+    for( unsigned int dev=0; dev < m_num_devices; ++dev ) {
+        cl_build_status status;
+        cl_int err = clGetProgramBuildInfo( program, m_devices[dev], CL_PROGRAM_BUILD_STATUS,
+                                            sizeof(status), &status, NULL );
+        if ( err != CL_SUCCESS || status != CL_BUILD_SUCCESS ) {
+            build_err = CL_BUILD_PROGRAM_FAILURE;
+        }
+    }
+    if ( ! cached ) {
+        print_build_log( infile, program, build_err );
+        if ( build_err == CL_SUCCESS ) {
+            m_progcache.store( key, program );
+        }
+    }
+    if ( build_err == CL_SUCCESS ) {
+        std::vector< cl_program > programs( 1, program );
+        load_kernels( programs );
+    }
+    clReleaseProgram( program );
+    return build_err;
+}
+
+
+// ------------------------------------------------------------
+/// Creates a program from src and builds it for all devices with the given
+/// options. If notify is not NULL, the build may be asynchronous and notify
+/// is called when it completes, as for clBuildProgram.
+/// Returns the result of clBuildProgram; the program is returned even if
+/// the build failed, and the caller releases it.
+cl_int clmagma_runtime::build_program(
+    const std::string& src, const std::string& options, cl_program* program,
+    void (CL_CALLBACK *notify)( cl_program, void* ), void* user_data )
+{
+    cl_int err;
+    
+    const char* src_str = src.c_str();
+    *program = clCreateProgramWithSource( m_context, 1, (const char**)&src_str, NULL, &err );
+    check_error( err );
+    if ( err != CL_SUCCESS ) {
+        *program = NULL;
+        return err;
+    }
+    
+    return clBuildProgram( *program, m_num_devices, &m_devices[0], options.c_str(), notify, user_data );
+}
+
+
+// ------------------------------------------------------------
+/// Prints compiler warnings & errors for program, compiled from infile,
+/// to stderr.
+void clmagma_runtime::print_build_log(
+    const char* infile, cl_program program, cl_int build_err )
+{
+    cl_int err;
+    char   data[ 32*1024 ];
+    
     // oddly, even when err == 0, there can be errors for some devices (e.g., double not supported).
     for( unsigned int dev=0; dev < m_num_devices; ++dev ) {
         err = clGetProgramBuildInfo( program, m_devices[dev], CL_PROGRAM_BUILD_LOG, sizeof(data), data, NULL );
@@ -426,18 +1088,53 @@ int clmagma_runtime::compile_file(
                      infile, dev, build_err, data_str.c_str() );
         }
     }
-    
-    // save compiled binary
-    if ( build_err == 0 ) {
-        std::vector< cl_program > programs( 1, program );
-        load_kernels( programs );
-        save_programs( programs, outfile_str.c_str() );
+}
+
+
+// ------------------------------------------------------------
+/// Returns the name of the source file containing kernel (e.g., "zlaswp.cl"),
+/// or "" if kernel is unknown.
+std::string clmagma_runtime::get_kernel_file( const char* kernel )
+{
+    std::map< std::string, std::string >::const_iterator it = m_kernel_files.find( kernel );
+    if ( it == m_kernel_files.end() ) {
+        return "";
+    }
+    return it->second;
+}
+
+
+// ------------------------------------------------------------
+/// Returns names of all kernel source files (e.g., "zlaswp.cl") in files.
+/// If missing_only, skips files whose kernels are all loaded already,
+/// e.g., from the precompiled libclmagma_kernels.co.
+/// Takes no lock: m_kernel_files is not modified after init.
+void clmagma_runtime::get_kernel_files(
+    std::vector< std::string >& files, bool missing_only )
+{
+    kernel_table_t* table = m_table.load( std::memory_order_acquire );
+    std::map< std::string, bool > need;  // file -> has a kernel not loaded
+    std::map< std::string, std::string >::const_iterator it;
+    for( it = m_kernel_files.begin(); it != m_kernel_files.end(); ++it ) {
+        bool missing = (table == NULL || table->find( it->first.c_str() ) == NULL);
+        need[ it->second ] = need[ it->second ] || missing || ! missing_only;
+    }
+    files.clear();
+    std::map< std::string, bool >::const_iterator f;
+    for( f = need.begin(); f != need.end(); ++f ) {
+        if ( f->second ) {
+            files.push_back( f->first );
+        }
     }
-    clReleaseProgram( program );
-    program = NULL;
-    
-    //printf( "compile       time %.4f\n", get_wtime() - start );
-    return build_err;
+}
+
+
+// ------------------------------------------------------------
+/// Returns path to file, searching $CLMAGMA_PATH or $LD_LIBRARY_PATH,
+/// or "" if it isn't found.
+std::string clmagma_runtime::find_file( const std::string& file )
+{
+    return search_path( file, m_path );
 }
 
 
@@ -554,8 +1251,12 @@ void clmagma_runtime::load_programs(
         len = fread( &num_devices, sizeof(num_devices), 1, file );
         if ( len != 1 ) { fprintf( stderr, "Error reading num devices\n" ); }
         if ( num_devices != m_num_devices ) {
-            fprintf( stderr, "Error: num_devices %u does not match current m_num_devices %u\n",
-                     num_devices, m_num_devices );
+            // e.g., compiled for one device but several are visible;
+            // kernels are compiled at run time instead
+            fprintf( stderr, "Warning: '%s' was compiled for %u devices, but %u are in use; skipping it.\n",
+                     path_str.c_str(), num_devices, m_num_devices );
+            fclose( file );
+            continue;
         }
         
         // read # programs
@@ -581,7 +1282,7 @@ void clmagma_runtime::load_programs(
             }
             
             program = clCreateProgramWithBinary(
-                m_context, m_num_devices, m_devices,
+                m_context, m_num_devices, &m_devices[0],
                 &binary_sizes[0], (const unsigned char**) &binaries[0], &statuses[0], &err );
             check_error( err );
             
@@ -605,6 +1306,7 @@ void clmagma_runtime::load_programs(
                 programs.push_back( program );
             }
         }
+        fclose( file );
     }
     //printf( "load programs time %.4f\n", get_wtime() - start );
 }
@@ -677,6 +1379,7 @@ void clmagma_runtime::load_kernels(
     std::vector< cl_kernel > kernels;
     
     //double start = get_wtime();
+    pthread_mutex_lock( &m_kernels_mutex );
     for( unsigned int i=0; i < programs.size(); ++i ) {
         // this implementation works with OpenCL 1.0 (previously required OpenCL 1.2)
         // query # kernels
@@ -690,8 +1393,15 @@ void clmagma_runtime::load_kernels(
         for( unsigned int j=0; j < num_kernels; ++j ) {
             err = clGetKernelInfo( kernels[j], CL_KERNEL_FUNCTION_NAME, sizeof(data), data, NULL );
             check_error( err );
-            m_kernels[ data ] = kernels[j];
+            // threads' clones are keyed by the old kernel, so keep it until quit
+            cl_kernel& k = m_kernels[ data ];
+            if ( k != NULL ) {
+                m_old_kernels.push_back( k );
+            }
+            k = kernels[j];
         }
     }
+    publish_kernels();
+    pthread_mutex_unlock( &m_kernels_mutex );
     //printf( "load kernels  time %.4f\n", get_wtime() - start );
 }
@@ -8,12 +8,20 @@
 #ifndef CLMAGMA_RUNTIME_H
 #define CLMAGMA_RUNTIME_H
 
+#include <atomic>
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "common_magma.h"  // includes OpenCL, etc.
 #include "error.h"
+#include "clmagma_event.h"
+#include "clmagma_mempool.h"
+#include "clmagma_nbprofile.h"
+#include "clmagma_pinned.h"
+#include "clmagma_progcache.h"
+#include "clmagma_scratch.h"
 
 
 // ------------------------------------------------------------
@@ -21,33 +29,23 @@ class clmagma_runtime
 {
 public:
     // ------------------------------
-    const static int MAX_DEVICES = 8;
-    // const static int MAX_DEVICES = 1;
-    
-    // ------------------------------
-    clmagma_runtime():
-        m_bExternalContext (false),
-        m_num_devices  ( 0 ),
-        m_context      ( NULL )
-    {
-        for( int dev=0; dev < MAX_DEVICES; ++dev ) {
-            m_devices[dev] = NULL;
-        }
-    }
-
-    // ------------------------------
-    ~clmagma_runtime()
-    {
-        quit();
-    }
+    clmagma_runtime();
+    ~clmagma_runtime();
     
     // ------------------------------
     // void init( bool require_double=true );
-    void init( bool require_double = false );
+    void init( bool require_double = false, const char* partition = NULL );
     void init(std::vector<cl_device_id> devices, cl_context context, bool require_double = false );
     void quit();
     int  compile_kernel( const char* kernel );
     int  compile_file( const char* infile, const char* outfile );
+    int  compile_cached( const char* infile );
+    cl_int start_build( const char* infile, cl_program* program, std::string* key, bool* cached,
+                        void (CL_CALLBACK *notify)( cl_program, void* ), void* user_data );
+    int  finish_build( const char* infile, cl_program program, const std::string& key, bool cached );
+    std::string find_file( const std::string& file );
+    std::string get_kernel_file( const char* kernel );
+    void get_kernel_files( std::vector< std::string >& files, bool missing_only );
     void save_programs( std::vector< cl_program >& programs, const char* filename );
     void load_programs( int nfiles, const char* const* infiles, std::vector< cl_program >& programs );
     void archive_files( int nfiles, const char* const* infiles, const char* outfile );
@@ -55,37 +53,78 @@ public:
     void load_kernels( const std::vector< cl_program >& programs );
     
     // ------------------------------
-    cl_kernel get_kernel( const char* name )
-    {
-        //printf( "kernel: %s\n", name );
-        cl_kernel k = m_kernels[ name ];
-        if ( k == NULL ) {
-            int err = compile_kernel( name );
-            k = m_kernels[ name ];
-            if ( err != 0 || k == NULL ) {
-                fprintf( stderr, "Error: kernel '%s' not found\n", name );
-                return NULL;
-            }
-        }
-        return k;
-    }
+    cl_kernel get_kernel( const char* name );
     
     // ------------------------------
     cl_platform_id get_platform()     const { return m_platform;    }
     int            get_num_devices()  const { return m_num_devices; }
     cl_context     get_context()      const { return m_context;     }
-    cl_device_id*  get_devices()            { return m_devices;     }
+    cl_device_id*  get_devices()            { return m_devices.empty() ? NULL : &m_devices[0]; }
+    
+    int            get_num_visible_devices() const { return (int) m_devices.size(); }
+    int            get_num_contexts() const { return (int) m_contexts.size(); }
+    cl_context     get_context( int index ) const { return m_contexts[ index ]; }
+    cl_context     get_device_context( cl_device_id device ) const;
+    int            get_num_subdevices() const { return (int) m_subdevices.size(); }
+    clmagma_events&  get_events()           { return m_events;      }
+    clmagma_mempool& get_mempool()          { return m_mempool;     }
+    clmagma_nbprofile& get_nbprofile()      { return m_nbprofile;   }
+    clmagma_pinned&  get_pinned()           { return m_pinned;      }
+    clmagma_progcache& get_progcache()      { return m_progcache;   }
+    clmagma_scratch& get_scratch()          { return m_scratch;     }
     
     // ==============================
 private:
+    cl_int build_program( const std::string& src, const std::string& options, cl_program* program,
+                          void (CL_CALLBACK *notify)( cl_program, void* ), void* user_data );
+    void   print_build_log( const char* infile, cl_program program, cl_int build_err );
+    void   select_devices( std::vector< cl_device_id >& devices, bool require_double );
+    void   partition_devices( std::vector< cl_device_id >& devices, const std::string& partition );
+    
+    struct kernel_table_t;
+    struct thread_kernels_t;
+    void   publish_kernels();
+    cl_kernel get_thread_kernel( cl_kernel kernel, const char* name );
+    static void release_thread_kernels( void* arg );
+
     bool             m_bExternalContext;
     std::string      m_path;
-    cl_platform_id   m_platform;
-    cl_uint          m_num_devices;
-    cl_context       m_context;
-    cl_device_id     m_devices[ MAX_DEVICES ];
-    std::map< std::string, cl_kernel > m_kernels;
-    std::map< std::string, std::string > m_kernel_files;
+    
+    // Visible devices of all platforms, with a context per platform.
+    // Devices of the first platform, whose context is m_context, come first.
+    // MAGMA allocates memory, builds kernels, and creates pinned buffers and
+    // events in m_context, so those are the devices that routines use;
+    // queues on devices of other platforms are in their platform's context.
+    cl_platform_id   m_platform;        ///< platform of m_context
+    cl_uint          m_num_devices;     ///< # devices in m_context
+    cl_context       m_context;         ///< m_contexts[0]
+    std::vector< cl_device_id > m_devices;          ///< all visible devices
+    std::vector< int >          m_device_contexts;  ///< index in m_contexts of each device
+    std::vector< cl_context >   m_contexts;         ///< context of each platform used
+    std::vector< cl_device_id > m_subdevices;       ///< created by partition_devices
+    
+    // Kernels are looked up without locking in m_table, an immutable hash
+    // table that is replaced, not modified, when kernels are loaded; old
+    // tables are kept until quit, since readers may still hold them.
+    // Because clSetKernelArg and clEnqueueNDRangeKernel on one cl_kernel are
+    // not thread safe, get_kernel returns a per-thread clone of the kernel,
+    // created on first use in each thread.
+    std::map< std::string, cl_kernel > m_kernels;  ///< name -> kernel, under m_kernels_mutex
+    std::atomic< kernel_table_t* > m_table;        ///< snapshot of m_kernels
+    std::vector< kernel_table_t* > m_old_tables;   ///< replaced snapshots
+    std::vector< cl_kernel >       m_old_kernels;  ///< replaced kernels
+    std::set< cl_kernel >          m_clones;       ///< all threads' clones
+    std::atomic< unsigned >        m_generation;   ///< incremented by quit
+    pthread_key_t    m_thread_key;      ///< thread_kernels_t of each thread
+    pthread_mutex_t  m_kernels_mutex;   ///< lock for kernel map, old lists, and clones
+    pthread_mutex_t  m_compile_mutex;   ///< serializes compiles on first use
+    std::map< std::string, std::string > m_kernel_files;  ///< kernel -> file; read-only after init
+    clmagma_events   m_events;
+    clmagma_mempool  m_mempool;
+    clmagma_nbprofile m_nbprofile;
+    clmagma_pinned   m_pinned;
+    clmagma_progcache m_progcache;
+    clmagma_scratch  m_scratch;
 };
 
 
@@ -93,4 +132,20 @@ private:
 // global runtime
 extern clmagma_runtime g_runtime;
 
+
+// ------------------------------------------------------------
+// Enqueues a kernel, as clEnqueueNDRangeKernel does, after telling the
+// memory pool that queue is used (see clmagma_mempool::note_use).
+// clmagmablas launches its kernels with this.
+inline cl_int
+magma_enqueue_kernel(
+    cl_command_queue queue, cl_kernel kernel, cl_uint ndim,
+    const size_t* offset, const size_t* global, const size_t* local,
+    cl_uint nevents, const cl_event* wait_list, cl_event* event )
+{
+    g_runtime.get_mempool().note_use( queue );
+    return clEnqueueNDRangeKernel( queue, kernel, ndim, offset, global, local,
+                                   nevents, wait_list, event );
+}
+
 #endif        //  #ifndef CLMAGMA_RUNTIME_H
@@ -0,0 +1,166 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include "clmagma_scratch.h"
+#include "error.h"
+
+
+// Smallest buffer; enough for the level 1 BLAS reductions, so they never
+// reallocate.
+static const size_t c_min_size = 16*1024;
+
+
+// ------------------------------------------------------------
+clmagma_scratch::clmagma_scratch()
+{
+    pthread_mutex_init( &m_mutex, NULL );
+}
+
+
+// ------------------------------------------------------------
+clmagma_scratch::~clmagma_scratch()
+{
+    quit();
+    pthread_mutex_destroy( &m_mutex );
+}
+
+
+// ------------------------------------------------------------
+/// Releases all queues' buffers and companion queues.
+void clmagma_scratch::quit()
+{
+    cl_int err;
+    pthread_mutex_lock( &m_mutex );
+    std::map< magma_queue_t, arena_t >::iterator it;
+    for( it = m_arenas.begin(); it != m_arenas.end(); ++it ) {
+        err = clReleaseMemObject( it->second.buffer );
+        check_error( err );
+    }
+    m_arenas.clear();
+    std::map< magma_queue_t, magma_queue_t > companions;
+    companions.swap( m_companions );
+    pthread_mutex_unlock( &m_mutex );
+
+    // magma_queue_destroy calls release, so destroy outside the lock
+    std::map< magma_queue_t, magma_queue_t >::iterator c;
+    for( c = companions.begin(); c != companions.end(); ++c ) {
+        magma_queue_destroy( c->second );
+    }
+}
+
+
+// ------------------------------------------------------------
+/// Returns in buffer the scratch buffer of queue, of at least bytes,
+/// allocating or growing it as needed. Sizes grow by at least double.
+magma_int_t clmagma_scratch::get( magma_queue_t queue, size_t bytes, cl_mem* buffer )
+{
+    *buffer = NULL;
+    magma_int_t info = MAGMA_SUCCESS;
+    pthread_mutex_lock( &m_mutex );
+    arena_t& arena = m_arenas[ queue ];  // buffer is NULL if new
+    if ( arena.buffer == NULL || arena.size < bytes ) {
+        size_t size = max( c_min_size, max( bytes, 2*arena.size ));
+        cl_context context = NULL;
+        cl_int err = clGetCommandQueueInfo( queue, CL_QUEUE_CONTEXT, sizeof(context), &context, NULL );
+        cl_mem ptr = NULL;
+        if ( err == CL_SUCCESS ) {
+            ptr = clCreateBuffer( context, CL_MEM_READ_WRITE, size, NULL, &err );
+        }
+        if ( err != CL_SUCCESS ) {
+            info = MAGMA_ERR_DEVICE_ALLOC;
+        }
+        else {
+            if ( arena.buffer != NULL ) {
+                // freed once commands already enqueued with it finish
+                err = clReleaseMemObject( arena.buffer );
+                check_error( err );
+            }
+            arena.buffer = ptr;
+            arena.size   = size;
+        }
+    }
+    if ( arena.buffer == NULL ) {
+        m_arenas.erase( queue );
+    }
+    else if ( info == MAGMA_SUCCESS ) {
+        *buffer = arena.buffer;
+    }
+    pthread_mutex_unlock( &m_mutex );
+    return info;
+}
+
+
+// ------------------------------------------------------------
+/// Returns in companion a second queue on the same device as queue,
+/// creating it on first use. Later calls return the same queue.
+magma_int_t clmagma_scratch::get_companion( magma_queue_t queue, magma_queue_t* companion )
+{
+    *companion = NULL;
+    pthread_mutex_lock( &m_mutex );
+    std::map< magma_queue_t, magma_queue_t >::iterator it = m_companions.find( queue );
+    if ( it != m_companions.end() ) {
+        *companion = it->second;
+    }
+    pthread_mutex_unlock( &m_mutex );
+    if ( *companion != NULL ) {
+        return MAGMA_SUCCESS;
+    }
+
+    // magma_queue_create registers with the mempool; create outside the lock
+    cl_device_id device;
+    cl_int err = clGetCommandQueueInfo( queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL );
+    if ( err != CL_SUCCESS ) {
+        return err;
+    }
+    magma_queue_t created;
+    magma_int_t info = magma_queue_create( device, &created );
+    if ( info != MAGMA_SUCCESS ) {
+        return info;
+    }
+
+    // another thread may have created one in the meantime
+    pthread_mutex_lock( &m_mutex );
+    magma_queue_t& entry = m_companions[ queue ];  // NULL if new
+    if ( entry == NULL ) {
+        entry = created;
+        created = NULL;
+    }
+    *companion = entry;
+    pthread_mutex_unlock( &m_mutex );
+    if ( created != NULL ) {
+        magma_queue_destroy( created );
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+// ------------------------------------------------------------
+/// Releases the buffer and companion queue of queue, e.g., when the queue
+/// is destroyed.
+void clmagma_scratch::release( magma_queue_t queue )
+{
+    magma_queue_t companion = NULL;
+    pthread_mutex_lock( &m_mutex );
+    std::map< magma_queue_t, arena_t >::iterator it = m_arenas.find( queue );
+    if ( it != m_arenas.end() ) {
+        cl_int err = clReleaseMemObject( it->second.buffer );
+        check_error( err );
+        m_arenas.erase( it );
+    }
+    std::map< magma_queue_t, magma_queue_t >::iterator c = m_companions.find( queue );
+    if ( c != m_companions.end() ) {
+        companion = c->second;
+        m_companions.erase( c );
+    }
+    pthread_mutex_unlock( &m_mutex );
+
+    // magma_queue_destroy calls release, so destroy outside the lock
+    if ( companion != NULL ) {
+        magma_queue_destroy( companion );
+    }
+}
@@ -0,0 +1,58 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#ifndef CLMAGMA_SCRATCH_H
+#define CLMAGMA_SCRATCH_H
+
+#include <map>
+
+#include "common_magma.h"  // includes OpenCL, pthread, etc.
+
+
+// ------------------------------------------------------------
+// Per-queue device scratch space for short-lived workspace, such as the
+// partial results of reductions, so that small routines called in loops
+// (e.g., pivot search in a panel) don't allocate and free on every call.
+//
+// Each queue has one buffer, in the queue's context, that grows as needed
+// and is never shrunk. Since commands in a queue execute in order, a
+// routine may use the buffer for commands it enqueues on that queue
+// without further synchronization. The buffer is valid until the next get
+// on the same queue, which may replace it; OpenCL keeps a replaced buffer
+// alive until the commands already enqueued with it finish.
+//
+// Each queue can also have a companion queue on the same device, for
+// routines that overlap work on two queues (e.g., look-ahead in getrf).
+// It is created on first use and destroyed with its queue. A routine must
+// leave the companion idle (synced) when it returns.
+class clmagma_scratch
+{
+public:
+    // ------------------------------
+    clmagma_scratch();
+    ~clmagma_scratch();
+
+    // ------------------------------
+    void        quit();
+
+    magma_int_t get( magma_queue_t queue, size_t bytes, cl_mem* buffer );
+    magma_int_t get_companion( magma_queue_t queue, magma_queue_t* companion );
+    void        release( magma_queue_t queue );
+
+    // ==============================
+private:
+    struct arena_t {
+        cl_mem buffer;
+        size_t size;
+    };
+
+    pthread_mutex_t  m_mutex;   ///< lock for m_arenas and m_companions
+    std::map< magma_queue_t, arena_t > m_arenas;  ///< queue -> buffer
+    std::map< magma_queue_t, magma_queue_t > m_companions;  ///< queue -> companion
+};
+
+#endif        //  #ifndef CLMAGMA_SCRATCH_H
@@ -192,6 +192,12 @@ const char* magma_strerror( magma_int_t error )
         case MAGMA_ERR_INVALID_PTR:
             return "invalid pointer";
         
+        case MAGMA_ERR_NOT_IMPLEMENTED:
+            return "not implemented";
+        
+        case MAGMA_ERR_NOT_READY:
+            return "event not ready";
+        
         default:
             return "unknown MAGMA error code";
     }
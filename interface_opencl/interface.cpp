@@ -29,6 +29,8 @@ void acmlversion(int *major, int *minor, int *patch);
 #include "clmagma_runtime.h"
 #include "common_magma.h"
 #include "error.h"
+#include "trace.h"
+#include "magma_stats.h"
 
 #ifdef HAVE_clBLAS
 
@@ -42,6 +44,17 @@ const char* clmagma_kernels = "libclmagma_kernels.co";
 
 // ========================================
 // initialization
+// --------------------
+// If $CLMAGMA_EAGER_COMPILE is nonzero, compiles all kernels not in
+// libclmagma_kernels.co now, instead of on first use.
+static void magma_init_eager()
+{
+    const char* eager = getenv( "CLMAGMA_EAGER_COMPILE" );
+    if ( eager != NULL && atoi( eager ) != 0 ) {
+        magma_warmup( NULL );
+    }
+}
+
 // --------------------
 extern "C" magma_int_t
 magma_init()
@@ -49,6 +62,30 @@ magma_init()
     g_runtime.init();
     g_runtime.load_kernels( 1, &clmagma_kernels );
     gContext = g_runtime.get_context();
+    magma_stats_startup();
+    trace_startup();
+    magma_init_eager();
+    
+    g_event = NULL;
+
+    return 0;
+}
+
+// --------------------
+// Like magma_init, but splits devices into sub-devices as given by
+// partition instead of $MAGMA_NUM_SUBDEVICES, e.g., "4" for four equal
+// parts, "8,8,16" for parts of 8, 8, and 16 compute units, or "numa" for
+// a part per NUMA node. Each sub-device is then a device for the _mgpu and
+// _msub routines.
+extern "C" magma_int_t
+magma_init_subdevices( const char* partition )
+{
+    g_runtime.init( false, partition == NULL ? "" : partition );
+    g_runtime.load_kernels( 1, &clmagma_kernels );
+    gContext = g_runtime.get_context();
+    magma_stats_startup();
+    trace_startup();
+    magma_init_eager();
     
     g_event = NULL;
 
@@ -61,6 +98,9 @@ magma_init_1(std::vector<cl_device_id> devices, cl_context context)
     g_runtime.init(devices, context);
     g_runtime.load_kernels(1, &clmagma_kernels);
     gContext = g_runtime.get_context();
+    magma_stats_startup();
+    trace_startup();
+    magma_init_eager();
 
     g_event = NULL;
 
@@ -90,6 +130,8 @@ magma_init_1(std::vector<cl_device_id> devices, cl_context context)
 extern "C" magma_int_t
 magma_finalize()
 {
+    trace_shutdown();
+    magma_stats_shutdown();
     g_runtime.quit();
     return MAGMA_SUCCESS;
 }
@@ -150,8 +192,9 @@ magma_print_environment()
 
     printf( "\n" );
     
-    // print devices
-    int ndevices = g_runtime.get_num_devices();
+    // print devices; devices after the first platform's have their own
+    // context, but MAGMA's routines don't compute on them
+    int ndevices = g_runtime.get_num_visible_devices();
     cl_device_id* devices = g_runtime.get_devices();
     cl_ulong mem_size, alloc_size;
     for( int dev=0; dev < ndevices; ++dev ) {
@@ -159,44 +202,48 @@ magma_print_environment()
         clGetDeviceInfo( devices[dev], CL_DEVICE_GLOBAL_MEM_SIZE,    sizeof(mem_size),    &mem_size,   NULL );
         clGetDeviceInfo( devices[dev], CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(alloc_size),  &alloc_size, NULL );
         clGetDeviceInfo( devices[dev], CL_DRIVER_VERSION,            sizeof(driver),      driver,      NULL );
-        printf( "%% Device: %s, %.1f MiB memory, max allocation %.1f MiB, driver  %s\n",
-                device_name, mem_size/(1024.*1024.), alloc_size/(1024.*1024.), driver );
+        printf( "%% Device %d: %s, %.1f MiB memory, max allocation %.1f MiB, driver  %s%s\n",
+                dev, device_name, mem_size/(1024.*1024.), alloc_size/(1024.*1024.), driver,
+                (dev < g_runtime.get_num_devices() ? "" : " (other platform, not used by MAGMA routines)") );
     }
 }
 
 
 // ========================================
 // device support
+// --------------------
+// Returns the usable devices: the visible devices, as selected by
+// $MAGMA_VISIBLE_DEVICES, of the first visible device's platform, which
+// share MAGMA's context. Devices of other platforms are not returned.
 extern "C" magma_int_t
 magma_getdevices(
     magma_device_t* devices,
     magma_int_t     size,
     magma_int_t*    numPtr )
 {
-    // TODO just copy from g_runtime.get_devices()
-    cl_int err;
-    //err = clGetDeviceIDs( gPlatform, CL_DEVICE_TYPE_GPU, 1, size, devices, num );
-    size_t n;
-    err = clGetContextInfo(
-        g_runtime.get_context(), CL_CONTEXT_DEVICES,
-        size*sizeof(magma_device_t), devices, &n );
-    *numPtr = n / sizeof(magma_device_t);
-    check_error( err );
-    return err;
+    int n = min( (int) size, g_runtime.get_num_devices() );
+    cl_device_id* all = g_runtime.get_devices();
+    for( int dev=0; dev < n; ++dev ) {
+        devices[dev] = all[dev];
+    }
+    *numPtr = n;
+    return MAGMA_SUCCESS;
 }
 
 // --------------------
+// Returns $MAGMA_NUM_GPUS if set, else the number of devices in MAGMA's
+// context (see magma_getdevices), limited to MagmaMaxGPUs, since the _mgpu
+// routines keep per-device queues and matrices in arrays of that size.
 extern "C" magma_int_t
 magma_num_gpus( void )
 {
     const char *ngpu_str = getenv("MAGMA_NUM_GPUS");
-    cl_uint ngpu = 1;
+    cl_uint ndevices = max( 1, g_runtime.get_num_devices() );
+    cl_uint ngpu = min( ndevices, MagmaMaxGPUs );
     if ( ngpu_str != NULL ) {
         char* endptr;
         ngpu = strtol( ngpu_str, &endptr, 10 );
 
-        cl_uint ndevices = g_runtime.get_num_devices();
-
         if ( ngpu < 1 || *endptr != '\0' ) {
             ngpu = 1;
             fprintf( stderr, "$MAGMA_NUM_GPUS='%s' is an invalid number; using %d GPU.\n",
@@ -226,6 +273,69 @@ magma_queue_meminfo( magma_queue_t queue )
     return mem_size;
 }
 
+// --------------------
+// Returns the local memory size of the queue's device, in bytes.
+extern "C" magma_int_t
+magma_queue_local_meminfo( magma_queue_t queue )
+{
+    cl_device_id dev;
+    clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(cl_device_id), &dev, NULL);
+
+    cl_ulong mem_size = 0;
+    clGetDeviceInfo(dev, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &mem_size, NULL);
+
+    return mem_size;
+}
+
+
+// ========================================
+// nb profile support
+
+// --------------------
+// Returns the tuned nb for routine (e.g., "zpotrf") and size m from the nb
+// profile of the calling thread's device, or 0 if the profile has none.
+extern "C" magma_int_t
+magma_nb_profile_get( const char* routine, magma_int_t m )
+{
+    return g_runtime.get_nbprofile().get( routine, m );
+}
+
+// --------------------
+// Sets nb for routine and sizes up to m in the nb profile of the calling
+// thread's device; nb <= 0 removes it.
+// Takes effect immediately; magma_nb_profile_save writes it to disk.
+extern "C" void
+magma_nb_profile_set( const char* routine, magma_int_t m, magma_int_t nb )
+{
+    g_runtime.get_nbprofile().set( routine, m, nb );
+}
+
+// --------------------
+// Sets the device whose nb profile the calling thread's magma_get_*_nb and
+// magma_nb_profile_* use. The default is the first device.
+extern "C" magma_int_t
+magma_nb_profile_set_device( magma_device_t device )
+{
+    return g_runtime.get_nbprofile().set_device( device );
+}
+
+// --------------------
+// Enables or disables nb profiles for all threads. While disabled,
+// magma_get_*_nb use only their built-in tables, e.g., to time them.
+extern "C" void
+magma_nb_profile_enable( magma_bool_t enable )
+{
+    g_runtime.get_nbprofile().set_enabled( enable == MagmaTrue );
+}
+
+// --------------------
+// Writes the nb profile of the calling thread's device to disk.
+extern "C" magma_int_t
+magma_nb_profile_save( void )
+{
+    return g_runtime.get_nbprofile().save();
+}
+
 
 // ========================================
 // queue support
@@ -236,24 +346,83 @@ magma_queue_create( magma_device_t device, magma_queue_t* queuePtr )
 {
     assert( queuePtr != NULL );
     cl_int err;
-    #ifdef TRACING
-    *queuePtr = clCreateCommandQueue( g_runtime.get_context(), device, CL_QUEUE_PROFILING_ENABLE, &err );
-    #else
-    *queuePtr = clCreateCommandQueue( g_runtime.get_context(), device, 0, &err );
-    #endif
+    // a device of another platform gets a queue in its platform's context;
+    // MAGMA's memory and kernels are in g_runtime.get_context(), so such a
+    // queue can run only the application's own commands
+    cl_context context = g_runtime.get_device_context( device );
+    if ( context == NULL ) {
+        context = g_runtime.get_context();
+    }
+    // profiling gives command times for the trace and kernel time counters
+    cl_command_queue_properties properties =
+        (trace_enabled() || magma_stats_kernel_time() ? CL_QUEUE_PROFILING_ENABLE : 0);
+    *queuePtr = clCreateCommandQueue( context, device, properties, &err );
     check_error( err );
+    if ( err == CL_SUCCESS && context == g_runtime.get_context() ) {
+        g_runtime.get_mempool().add_queue( *queuePtr );
+    }
     return err;
 }
 
+// --------------------
+// Creates the two queues per device that the _mgpu and _msub routines take:
+// queues[2*d] and queues[2*d+1] on device d, for the first ngpu devices of
+// magma_getdevices, which may be sub-devices (see magma_init_subdevices).
+extern "C" magma_int_t
+magma_queues_create_mgpu( magma_int_t ngpu, magma_queue_t* queues )
+{
+    if ( ngpu < 1 || ngpu > g_runtime.get_num_devices() ) {
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    cl_device_id* devices = g_runtime.get_devices();
+    for( magma_int_t i=0; i < 2*ngpu; ++i ) {
+        magma_int_t err = magma_queue_create( devices[i/2], &queues[i] );
+        if ( err != MAGMA_SUCCESS ) {
+            while( i > 0 ) {
+                magma_queue_destroy( queues[--i] );
+            }
+            return err;
+        }
+    }
+    return MAGMA_SUCCESS;
+}
+
+// --------------------
+extern "C" magma_int_t
+magma_queues_destroy_mgpu( magma_int_t ngpu, magma_queue_t* queues )
+{
+    magma_int_t info = MAGMA_SUCCESS;
+    for( magma_int_t i=0; i < 2*ngpu; ++i ) {
+        magma_int_t err = magma_queue_destroy( queues[i] );
+        if ( err != MAGMA_SUCCESS ) {
+            info = err;
+        }
+    }
+    return info;
+}
+
 // --------------------
 extern "C" magma_int_t
 magma_queue_destroy( magma_queue_t  queue )
 {
+    g_runtime.get_scratch().release( queue );
+    g_runtime.get_mempool().remove_queue( queue );
+    magma_stats_queue_destroy( queue );
     cl_int err = clReleaseCommandQueue( queue );
     check_error( err );
     return err;
 }
 
+// --------------------
+// Returns a second queue on the same device as queue, for routines that
+// overlap work on two queues. It is created on first use, reused by later
+// calls, and destroyed with queue. Callers must sync it before returning.
+extern "C" magma_int_t
+magma_queue_get_companion( magma_queue_t queue, magma_queue_t* companionPtr )
+{
+    return g_runtime.get_scratch().get_companion( queue, companionPtr );
+}
+
 // --------------------
 extern "C" magma_int_t
 magma_queue_sync( magma_queue_t queue )
@@ -267,36 +436,39 @@ magma_queue_sync( magma_queue_t queue )
 
 // ========================================
 // event support
+// Events from magma_event_create are handles, re-pointed by each
+// magma_event_record; see clmagma_event.h. Events returned by _async
+// routines may also be passed to magma_event_query, magma_event_sync,
+// magma_queue_wait_event, and magma_event_destroy.
+
 // --------------------
 extern "C" magma_int_t
 magma_event_create( magma_event_t* event )
 {
-    printf( "%s not implemented\n", __func__ );
-    return 0;
+    return g_runtime.get_events().create( event );
 }
 
 // --------------------
 extern "C" magma_int_t
 magma_event_destroy( magma_event_t event )
 {
-    printf( "%s not implemented\n", __func__ );
-    return 0;
+    return g_runtime.get_events().destroy( event );
 }
 
 // --------------------
+// records event at current end of queue
 extern "C" magma_int_t
 magma_event_record( magma_event_t event, magma_queue_t queue )
 {
-    printf( "%s not implemented\n", __func__ );
-    return 0;
+    return g_runtime.get_events().record( event, queue );
 }
 
 // --------------------
+// returns MAGMA_SUCCESS if event occurred, MAGMA_ERR_NOT_READY if not yet
 extern "C" magma_int_t
 magma_event_query( magma_event_t event )
 {
-    printf( "%s not implemented\n", __func__ );
-    return 0;
+    return g_runtime.get_events().query( event );
 }
 
 // --------------------
@@ -304,33 +476,26 @@ magma_event_query( magma_event_t event )
 extern "C" magma_int_t
 magma_event_sync( magma_event_t event )
 {
-    cl_int err = clWaitForEvents(1, &event);
-    check_error( err );
-    return err;
+    return g_runtime.get_events().sync( event );
 }
 
 // --------------------
-// blocks queue (but not CPU) until event occurs
-// In OpenCL, the event should be passed directly to the kernel, instead of a separate function call.
-// Make an empty kernel? Seems a waste.
-extern "C" void
+// blocks queue (but not CPU) until event occurs.
+// Event and queue must be in the same OpenCL context; returns
+// MAGMA_ERR_ILLEGAL_VALUE otherwise.
+extern "C" magma_int_t
 magma_queue_wait_event( magma_queue_t queue, magma_event_t event )
 {
-    printf( "%s not implemented\n", __func__ );
+    return g_runtime.get_events().wait( queue, event );
 }
 
 // --------------------
-// Sets global event used for tracing.
-// TODO put this into tracing code, not in interface.cpp?
+// Sets global event that the set/get and BLAS wrappers return their
+// commands' events in, or NULL to stop.
 extern "C" magma_int_t
 magma_setevent( magma_event_t* event )
 {
-    #ifdef TRACING
     g_event = event;
-    #else
-    printf("%s not implemented\n", __func__ );
-    #endif
-
     return 0;
 }
 
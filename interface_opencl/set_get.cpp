@@ -11,9 +11,13 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "clmagma_runtime.h"
 #include "magma.h"
 #include "error.h"
+#include "trace.h"
+#include "magma_stats.h"
 
 #if defined(HAVE_clBLAS)
 
@@ -24,6 +28,125 @@
 // globals, defined in interface.c
 extern magma_event_t* g_event;
 
+// ========================================
+// strided vectors
+// A strided vector is transferred packed: its elements go between the host
+// and the queue's scratch buffer in one contiguous DMA, and
+// magmablas_copyvector_async scatters or gathers them on the device, rather
+// than a rectangular transfer of n one-element rows. If the host side is
+// strided too, it is packed or unpacked on the host around a blocking DMA.
+// Pinned host memory takes the same path: it stays mapped, so it must not
+// be passed to the copy kernel (see clmagma_pinned.h).
+// These return false, having done nothing, if there is no copy kernel for
+// elemSize or increments are not positive; then the caller falls back to a
+// rectangular transfer.
+static bool
+magma_vector_packable( magma_int_t elemSize, magma_int_t incx, magma_int_t incy )
+{
+    return (elemSize == 4 || elemSize == 8 || elemSize == 16)
+        && incx > 0 && incy > 0;
+}
+
+// --------------------
+static bool
+magma_setvector_packed(
+    magma_int_t n, magma_int_t elemSize,
+    void const* hx_src,                   magma_int_t incx,
+    magma_ptr   dy_dst, size_t dy_offset, magma_int_t incy,
+    magma_queue_t queue, magma_event_t *event, bool blocking )
+{
+    if ( ! magma_vector_packable( elemSize, incx, incy ))
+        return false;
+
+    cl_int err;
+    size_t bytes = n*elemSize;
+    cl_mem dwork;
+    if ( g_runtime.get_scratch().get( queue, bytes, &dwork ) != MAGMA_SUCCESS )
+        return false;
+
+    // pack strided host vector
+    char* hwork = NULL;
+    if ( incx != 1 ) {
+        hwork = (char*) malloc( bytes );
+        if ( hwork == NULL )
+            return false;
+        const char* hx = (const char*) hx_src;
+        for( magma_int_t i = 0; i < n; ++i ) {
+            memcpy( hwork + i*elemSize, hx + i*incx*elemSize, elemSize );
+        }
+    }
+    err = clEnqueueWriteBuffer(
+        queue, dwork, (blocking || hwork != NULL ? CL_TRUE : CL_FALSE),
+        0, bytes,
+        (hwork != NULL ? hwork : hx_src), 0, NULL, trace_event( NULL ));
+    check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, bytes, 0 );
+    free( hwork );
+
+    // the copy kernel exists, as magma_vector_packable checked its size
+    magmablas_copyvector_async(
+        n, elemSize, dwork, 0, 1,
+        dy_dst, dy_offset, incy, queue, event );
+    if ( blocking ) {
+        err = clFinish( queue );
+        check_error( err );
+    }
+    else {
+        clFlush( queue );
+    }
+    return true;
+}
+
+// --------------------
+static bool
+magma_getvector_packed(
+    magma_int_t n, magma_int_t elemSize,
+    magma_const_ptr dx_src, size_t dx_offset, magma_int_t incx,
+    void*           hy_dst,                   magma_int_t incy,
+    magma_queue_t queue, magma_event_t *event, bool blocking )
+{
+    if ( ! magma_vector_packable( elemSize, incx, incy ))
+        return false;
+
+    cl_int err;
+    size_t bytes = n*elemSize;
+    cl_mem dwork;
+    if ( g_runtime.get_scratch().get( queue, bytes, &dwork ) != MAGMA_SUCCESS )
+        return false;
+    char* hwork = NULL;
+    if ( incy != 1 ) {
+        hwork = (char*) malloc( bytes );
+        if ( hwork == NULL )
+            return false;
+    }
+
+    // the copy kernel exists, as magma_vector_packable checked its size
+    magmablas_copyvector_async(
+        n, elemSize, dx_src, dx_offset, incx,
+        dwork, 0, 1, queue, NULL );
+    err = clEnqueueReadBuffer(
+        queue, dwork, (blocking || hwork != NULL ? CL_TRUE : CL_FALSE),
+        0, bytes,
+        (hwork != NULL ? (void*) hwork : hy_dst), 0, NULL, trace_event( event ));
+    check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, 0, bytes );
+
+    // unpack into strided host vector
+    if ( hwork != NULL ) {
+        char* hy = (char*) hy_dst;
+        for( magma_int_t i = 0; i < n; ++i ) {
+            memcpy( hy + i*incy*elemSize, hwork + i*elemSize, elemSize );
+        }
+        free( hwork );
+    }
+    else if ( ! blocking ) {
+        clFlush( queue );
+    }
+    return true;
+}
+
 // ========================================
 // copying vectors
 extern "C" void
@@ -40,8 +163,15 @@ magma_setvector(
         cl_int err = clEnqueueWriteBuffer(
             queue, dy_dst, CL_TRUE,
             dy_offset*elemSize, n*elemSize,
-            hx_src, 0, NULL, g_event);
+            hx_src, 0, NULL, trace_event( g_event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, n*elemSize, 0 );
+    }
+    else if ( magma_setvector_packed( n, elemSize, hx_src, incx,
+                                      dy_dst, dy_offset, incy,
+                                      queue, g_event, true )) {
+        // done
     }
     else {
         magma_int_t ldha = incx;
@@ -68,8 +198,15 @@ magma_setvector_async(
         cl_int err = clEnqueueWriteBuffer(
             queue, dy_dst, CL_FALSE,
             dy_offset*elemSize, n*elemSize,
-            hx_src, 0, NULL, event);
+            hx_src, 0, NULL, trace_event( event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, n*elemSize, 0 );
+    }
+    else if ( magma_setvector_packed( n, elemSize, hx_src, incx,
+                                      dy_dst, dy_offset, incy,
+                                      queue, event, false )) {
+        // done
     }
     else {
         magma_int_t ldha = incx;
@@ -96,8 +233,15 @@ magma_getvector(
         cl_int err = clEnqueueReadBuffer(
             queue, dx_src, CL_TRUE,
             dx_offset*elemSize, n*elemSize,
-            hy_dst, 0, NULL, g_event);
+            hy_dst, 0, NULL, trace_event( g_event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, 0, n*elemSize );
+    }
+    else if ( magma_getvector_packed( n, elemSize, dx_src, dx_offset, incx,
+                                      hy_dst, incy,
+                                      queue, g_event, true )) {
+        // done
     }
     else {
         magma_int_t ldda = incx;
@@ -124,8 +268,15 @@ magma_getvector_async(
         cl_int err = clEnqueueReadBuffer(
             queue, dx_src, CL_FALSE,
             dx_offset*elemSize, n*elemSize,
-            hy_dst, 0, NULL, event);
+            hy_dst, 0, NULL, trace_event( event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, 0, n*elemSize );
+    }
+    else if ( magma_getvector_packed( n, elemSize, dx_src, dx_offset, incx,
+                                      hy_dst, incy,
+                                      queue, event, false )) {
+        // done
     }
     else {
         magma_int_t ldda = incx;
@@ -149,10 +300,20 @@ magma_copyvector(
         return;
 
     if (incx == 1 && incy == 1) {
-        cl_int err = clEnqueueReadBuffer(
-            queue, dx_src, CL_TRUE,
-            dx_offset*elemSize, n*elemSize,
-            dy_dst, dy_offset*elemSize, NULL, g_event);
+        cl_int err = clEnqueueCopyBuffer(
+            queue, dx_src, dy_dst,
+            dx_offset*elemSize, dy_offset*elemSize, n*elemSize,
+            0, NULL, trace_event( g_event ));
+        check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        err = clFinish( queue );
+        check_error( err );
+    }
+    else if ( magma_vector_packable( elemSize, incx, incy )
+              && magmablas_copyvector_async( n, elemSize, dx_src, dx_offset, incx,
+                                             dy_dst, dy_offset, incy,
+                                             queue, g_event ) == MAGMA_SUCCESS ) {
+        cl_int err = clFinish( queue );
         check_error( err );
     }
     else {
@@ -177,11 +338,18 @@ magma_copyvector_async(
         return;
 
     if (incx == 1 && incy == 1) {
-        cl_int err = clEnqueueReadBuffer(
-            queue, dx_src, CL_FALSE,
-            dx_offset*elemSize, n*elemSize,
-            dy_dst, dy_offset*elemSize, NULL, event);
+        cl_int err = clEnqueueCopyBuffer(
+            queue, dx_src, dy_dst,
+            dx_offset*elemSize, dy_offset*elemSize, n*elemSize,
+            0, NULL, trace_event( event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+    }
+    else if ( magma_vector_packable( elemSize, incx, incy )
+              && magmablas_copyvector_async( n, elemSize, dx_src, dx_offset, incx,
+                                             dy_dst, dy_offset, incy,
+                                             queue, event ) == MAGMA_SUCCESS ) {
+        clFlush( queue );
     }
     else {
         magma_int_t ldda = incx;
@@ -215,8 +383,10 @@ magma_setmatrix(
         buffer_origin, host_orig, region,
         lddb*elemSize, 0,
         ldha*elemSize, 0,
-        hA_src, 0, NULL, g_event );
+        hA_src, 0, NULL, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, region[0]*region[1], 0 );
 }
 
 // --------------------
@@ -238,9 +408,11 @@ magma_setmatrix_async(
         buffer_origin, host_orig, region,
         lddb*elemSize, 0,
         ldha*elemSize, 0,
-        hA_src, 0, NULL, event );
+        hA_src, 0, NULL, trace_event( event ) );
     clFlush( queue );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, region[0]*region[1], 0 );
 }
 
 // --------------------
@@ -262,8 +434,10 @@ magma_getmatrix(
         buffer_origin, host_orig, region,
         ldda*elemSize, 0,
         ldhb*elemSize, 0,
-        hB_dst, 0, NULL, g_event );
+        hB_dst, 0, NULL, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, 0, region[0]*region[1] );
 }
 
 // --------------------
@@ -285,9 +459,11 @@ magma_getmatrix_async(
         buffer_origin, host_orig, region,
         ldda*elemSize, 0,
         ldhb*elemSize, 0,
-        hB_dst, 0, NULL, event );
+        hB_dst, 0, NULL, trace_event( event ) );
     clFlush( queue );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, 0, region[0]*region[1] );
 }
 
 // --------------------
@@ -309,8 +485,9 @@ magma_copymatrix(
         src_origin, dst_orig, region,
         ldda*elemSize, 0,
         lddb*elemSize, 0,
-        0, NULL, g_event );
+        0, NULL, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
 }
 
 // --------------------
@@ -333,8 +510,9 @@ magma_copymatrix_async(
         src_origin, dst_orig, region,
         ldda*elemSize, 0,
         lddb*elemSize, 0,
-        0, NULL, event );
+        0, NULL, trace_event( event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
 }
 
 #endif // HAVE_clBLAS
@@ -0,0 +1,487 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "clmagma_runtime.h"
+#include "common_magma.h"
+#include "magma_threadsetting.h"
+#include "thread_queue.hpp"
+
+
+// ========================================
+// Kernel files used by drivers, by routine name without precision and
+// without _gpu, etc. suffix, including the magmablas routines they call
+// through other drivers. Files are given in double-complex; see
+// warmup_file for the precision substitution. Drivers that rely only on
+// BLAS (e.g., potrf) list no files, so they are still recognized.
+// Mixed-precision drivers (zcgesv, dsgesv) are listed as "cgesv", etc.
+struct routine_files_t {
+    const char* routine;
+    const char* files;
+};
+
+static const routine_files_t c_routine_files[] = {
+    { "gb2bd",   "" },
+    { "ge2gb",   "" },
+    { "gebrd",   "" },
+    { "geev",    "zlaset.cl" },
+    { "gehrd",   "zlaset.cl" },
+    { "gelqf",   "ztranspose.cl,ztranspose_inplace.cl" },
+    { "gels",    "" },
+    { "geqlf",   "" },
+    { "geqr2x3", "dznrm2.cl,zgemm_reduce.cl,zlacpy.cl,zlarfbx.cl,zlarfgx-v2.cl,zlarfx.cl" },
+    { "geqrf",   "zlaset.cl" },
+    { "geqrf2",  "" },
+    { "geqrs",   "" },
+    { "gesdd",   "zlaset.cl" },
+    { "gesv",    "zlaswp.cl,ztranspose.cl,ztranspose_inplace.cl" },
+    { "gesvd",   "zlaset.cl" },
+    { "getrf",   "zlaswp.cl,ztranspose.cl,ztranspose_inplace.cl" },
+    { "getrf2",  "zlaswp.cl,ztranspose.cl,ztranspose_inplace.cl" },
+    { "getri",   "zlacpy.cl,zlaset.cl,zswap.cl" },
+    { "getrs",   "" },
+    { "heevd",   "zlaset.cl" },
+    { "heevdx",  "" },
+    { "hesv",    "zlacpy_cnjg.cl,zlascl_2x2.cl,zswap.cl" },
+    { "hetrd",   "" },
+    { "hetrf",   "zlacpy_cnjg.cl,zlascl_2x2.cl,zlascl_diag.cl,zswap.cl" },
+    { "hseqr",   "" },
+    { "labrd",   "" },
+    { "lahef",   "zlacpy_cnjg.cl,zlascl_2x2.cl,zswap.cl" },
+    { "lahr2",   "" },
+    { "lahru",   "" },
+    { "larfb",   "" },
+    { "larfb2",  "zgemm_reduce.cl" },
+    { "latrd",   "" },
+    { "lauum",   "" },
+    { "posv",    "" },
+    { "potrf",   "" },
+    { "potrf2",  "" },
+    { "potri",   "" },
+    { "potrs",   "" },
+    { "stedx",   "" },
+    { "trevc3",  "" },
+    { "trtri",   "" },
+    { "unghr",   "zlaset.cl" },
+    { "ungqr",   "zlaset.cl" },
+    { "ungqr2",  "zlaset.cl" },
+    { "unmbr",   "" },
+    { "unmlq",   "" },
+    { "unmql",   "" },
+    { "unmqr",   "zlaset.cl" },
+    { "unmtr",   "" },
+
+    // mixed precision
+    { "cgeqrsv", "clag2z.cl,magma_dmax_nan.cl,zcaxpycp.cl,zlacpy.cl,zlag2c.cl,zlange.cl" },
+    { "cgesv",   "clag2z.cl,magma_dmax_nan.cl,zaxpycp.cl,zclaswp.cl,zlacpy.cl,zlag2c.cl,"
+                 "zlange.cl,zlaswp.cl,ztranspose.cl,ztranspose_inplace.cl" },
+    { "cgetrs",  "clag2z.cl,zclaswp.cl,zlag2c.cl" },
+    { "cposv",   "clag2z.cl,magma_dmax_nan.cl,zcaxpycp.cl,zlacpy.cl,zlag2c.cl,zlat2c.cl" },
+};
+
+// Real-precision names of routines listed above by their complex name.
+static const routine_files_t c_routine_aliases[] = {
+    { "lasyf",   "lahef"  },
+    { "orghr",   "unghr"  },
+    { "orgqr",   "ungqr"  },
+    { "orgqr2",  "ungqr2" },
+    { "ormbr",   "unmbr"  },
+    { "ormlq",   "unmlq"  },
+    { "ormql",   "unmql"  },
+    { "ormqr",   "unmqr"  },
+    { "ormtr",   "unmtr"  },
+    { "syevd",   "heevd"  },
+    { "syevdx",  "heevdx" },
+    { "sysv",    "hesv"   },
+    { "sytrd",   "hetrd"  },
+    { "sytrf",   "hetrf"  },
+};
+
+
+// --------------------
+// Returns the name of double-complex kernel file in the given precision,
+// following the names that tools/codegen.py generates: zlaswp.cl becomes
+// slaswp.cl, dznrm2.cl becomes scnrm2.cl, and for mixed precision
+// zclaswp.cl and clag2z.cl become dslaswp.cl and slag2d.cl.
+// Files without a precision (magma_dmax_nan.cl) are unchanged.
+static std::string warmup_file( std::string file, char precision, bool mixed )
+{
+    if ( precision == 'z' ) {
+        return file;
+    }
+    if ( mixed ) {
+        // only zc -> ds exists
+        if ( file.compare( 0, 2, "zc" ) == 0 ) {
+            file.replace( 0, 2, "ds" );
+        }
+        else if ( file[0] == 'z' ) {
+            file[0] = 'd';
+            size_t i = file.find( "2c" );
+            if ( i != std::string::npos ) {
+                file.replace( i, 2, "2s" );
+            }
+        }
+        else if ( file[0] == 'c' ) {
+            file[0] = 's';
+            size_t i = file.find( "2z" );
+            if ( i != std::string::npos ) {
+                file.replace( i, 2, "2d" );
+            }
+        }
+    }
+    else if ( file.compare( 0, 2, "dz" ) == 0 ) {
+        file.replace( 0, 2, (precision == 'c' ? "sc" : std::string( 1, precision )));
+    }
+    else if ( file[0] == 'z' ) {
+        file[0] = precision;
+    }
+    return file;
+}
+
+
+// ========================================
+// State shared by the build tasks of one magma_warmup call.
+// A build is done when its clBuildProgram callback fires, or when it
+// finishes without one (cache hit, or error before the build started).
+//
+// The state is on the heap and reference counted, because after a failed
+// clBuildProgram the driver may or may not still call the callback, so
+// magma_warmup cannot wait for it. Each build holds a reference while a
+// callback may be pending, and the last release deletes the state. If a
+// failed build's callback never fires, its state is leaked.
+struct warmup_state_t;
+
+struct warmup_build_t {
+    warmup_state_t* state;
+    std::string path;
+    cl_program  program;
+    std::string key;
+    bool        cached;
+    bool        done;
+};
+
+struct warmup_state_t {
+    std::vector< warmup_build_t > builds;
+    int             ndone;
+    int             refs;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+};
+
+// --------------------
+static warmup_state_t* warmup_state_create()
+{
+    warmup_state_t* state = new warmup_state_t;
+    state->ndone = 0;
+    state->refs  = 1;
+    pthread_mutex_init( &state->mutex, NULL );
+    pthread_cond_init( &state->cond, NULL );
+    return state;
+}
+
+// --------------------
+static void warmup_state_retain( warmup_state_t* state )
+{
+    pthread_mutex_lock( &state->mutex );
+    state->refs += 1;
+    pthread_mutex_unlock( &state->mutex );
+}
+
+// --------------------
+static void warmup_state_release( warmup_state_t* state )
+{
+    pthread_mutex_lock( &state->mutex );
+    bool last = (--state->refs == 0);
+    pthread_mutex_unlock( &state->mutex );
+    if ( last ) {
+        pthread_cond_destroy( &state->cond );
+        pthread_mutex_destroy( &state->mutex );
+        delete state;
+    }
+}
+
+// --------------------
+static void warmup_done( warmup_build_t* build )
+{
+    warmup_state_t* state = build->state;
+    pthread_mutex_lock( &state->mutex );
+    if ( ! build->done ) {
+        build->done = true;
+        state->ndone += 1;
+        pthread_cond_broadcast( &state->cond );
+    }
+    pthread_mutex_unlock( &state->mutex );
+}
+
+
+// --------------------
+// clBuildProgram callback. On platforms that build asynchronously, it is
+// called from a driver thread once the build completes. Releases the
+// reference that the task took for it.
+extern "C" void CL_CALLBACK
+warmup_notify( cl_program program, void* user_data )
+{
+    warmup_build_t* build = (warmup_build_t*) user_data;
+    warmup_state_t* state = build->state;
+    warmup_done( build );
+    warmup_state_release( state );
+}
+
+
+// --------------------
+// Starts one build on a worker thread. On platforms where clBuildProgram
+// returns immediately, the worker moves on to the next file while the
+// driver compiles; otherwise the workers provide the parallelism.
+class warmup_task: public magma_task
+{
+public:
+    warmup_task( warmup_build_t* build ):
+        m_build( build ) {}
+
+    virtual void run()
+    {
+        // reference for the callback, taken before it can fire
+        warmup_state_t* state = m_build->state;
+        warmup_state_retain( state );
+        cl_int err = g_runtime.start_build(
+            m_build->path.c_str(), &m_build->program, &m_build->key, &m_build->cached,
+            warmup_notify, m_build );
+        if ( m_build->program == NULL || m_build->cached ) {
+            // no build was started, so no callback will fire
+            warmup_done( m_build );
+            warmup_state_release( state );
+        }
+        else if ( err != CL_SUCCESS ) {
+            // failed build: a callback may still fire and release the
+            // reference, so keep it; count the build as done now
+            warmup_done( m_build );
+        }
+    }
+
+private:
+    warmup_build_t* m_build;
+};
+
+
+// --------------------
+// Adds the kernel files named by token to files. Returns false if token
+// does not name a file, kernel, magmablas routine, or driver.
+static bool warmup_lookup( std::string token, std::vector< std::string >& files )
+{
+    // strip magma_ and magmablas_ prefixes
+    if ( token.compare( 0, 10, "magmablas_" ) == 0 ) {
+        token = token.substr( 10 );
+    }
+    else if ( token.compare( 0, 6, "magma_" ) == 0 ) {
+        token = token.substr( 6 );
+    }
+    if ( token.size() == 0 ) {
+        return false;
+    }
+
+    // file name, with or without .cl
+    std::string file = token;
+    if ( file.size() < 3 || file.compare( file.size()-3, 3, ".cl" ) != 0 ) {
+        file += ".cl";
+    }
+    std::vector< std::string > all;
+    g_runtime.get_kernel_files( all, false );
+    for( size_t i=0; i < all.size(); ++i ) {
+        if ( all[i] == file ) {
+            files.push_back( file );
+            return true;
+        }
+    }
+
+    // kernel name
+    file = g_runtime.get_kernel_file( token.c_str() );
+    if ( file != "" ) {
+        files.push_back( file );
+        return true;
+    }
+
+    // driver name: precision, routine, optional _gpu, etc. suffix
+    char precision = token[0];
+    if ( precision != 's' && precision != 'd' && precision != 'c' && precision != 'z' ) {
+        return false;
+    }
+    std::string routine = token.substr( 1, token.find( '_' ) - 1 );
+    int nalias = sizeof(c_routine_aliases) / sizeof(*c_routine_aliases);
+    for( int i=0; i < nalias; ++i ) {
+        if ( routine == c_routine_aliases[i].routine ) {
+            routine = c_routine_aliases[i].files;
+            break;
+        }
+    }
+    int n = sizeof(c_routine_files) / sizeof(*c_routine_files);
+    int found = -1;
+    for( int i=0; i < n && found < 0; ++i ) {
+        if ( routine == c_routine_files[i].routine ) {
+            found = i;
+        }
+    }
+    // mixed precision: zc... or ds..., listed as c...
+    bool mixed = false;
+    if ( found < 0 && ((precision == 'z' && routine[0] == 'c') ||
+                       (precision == 'd' && routine[0] == 's')) ) {
+        mixed = true;
+        routine[0] = 'c';
+        for( int i=0; i < n && found < 0; ++i ) {
+            if ( routine == c_routine_files[i].routine ) {
+                found = i;
+            }
+        }
+    }
+    if ( found >= 0 ) {
+        std::string list = c_routine_files[found].files;
+        size_t i1=0, i2=0;
+        while( list != "" && i2 != std::string::npos ) {
+            i2 = list.find( ',', i1 );
+            files.push_back( warmup_file( list.substr( i1, i2-i1 ), precision, mixed ));
+            i1 = i2+1;
+        }
+        return true;
+    }
+    return false;
+}
+
+
+// ========================================
+/**
+    Purpose
+    -------
+    Compiles, ahead of first use, the OpenCL kernels needed by a list of
+    routines, so their first call does not stall in clBuildProgram.
+    Files are compiled concurrently on a pool of magma_get_parallel_numthreads()
+    threads, using clBuildProgram callbacks so that platforms that build
+    asynchronously overlap builds further. Programs go through the on-disk
+    kernel cache, so a warm cache makes this fast.
+
+    Kernels already loaded, e.g., from the precompiled libclmagma_kernels.co,
+    are not recompiled.
+
+    magma_init calls magma_warmup( NULL ) if $CLMAGMA_EAGER_COMPILE is set
+    to a nonzero value.
+
+    Arguments
+    ---------
+    @param[in]
+    routines    Comma-separated list of names. Each name is a kernel source
+                file (zlaswp.cl or zlaswp), a kernel (zlaswpx_kernel),
+                a magmablas routine (magmablas_zlaswp), or a driver
+                (zgetrf_gpu, magma_sgesv). If NULL, empty, or "all",
+                all kernel files are compiled.
+
+    @return MAGMA_SUCCESS, or
+            MAGMA_ERR_NOT_FOUND if a name or file was not found, or
+            an OpenCL error if a build failed.
+            Other names are still compiled in either case.
+*/
+extern "C" magma_int_t
+magma_warmup( const char* routines )
+{
+    if ( g_runtime.get_context() == NULL ) {
+        fprintf( stderr, "Error in %s: runtime not initialized.\n", __func__ );
+        return MAGMA_ERR_NOT_INITIALIZED;
+    }
+
+    magma_int_t info = MAGMA_SUCCESS;
+
+    // resolve names to files
+    std::vector< std::string > files, missing;
+    std::string list = (routines == NULL ? "" : routines);
+    if ( list == "" || list == "all" ) {
+        g_runtime.get_kernel_files( files, false );
+    }
+    else {
+        size_t i1=0, i2=0;
+        while( i2 != std::string::npos ) {
+            i2 = list.find( ',', i1 );
+            std::string token = list.substr( i1, i2-i1 );
+            i1 = i2+1;
+            // trim spaces
+            size_t b = token.find_first_not_of( " \t" );
+            size_t e = token.find_last_not_of( " \t" );
+            if ( b == std::string::npos )
+                continue;
+            token = token.substr( b, e-b+1 );
+            if ( ! warmup_lookup( token, files )) {
+                fprintf( stderr, "Warning: %s: '%s' not found\n", __func__, token.c_str() );
+                info = MAGMA_ERR_NOT_FOUND;
+            }
+        }
+    }
+
+    // skip files whose kernels are loaded, and remove duplicates
+    g_runtime.get_kernel_files( missing, true );
+    std::map< std::string, bool > need;
+    for( size_t i=0; i < missing.size(); ++i ) {
+        need[ missing[i] ] = true;
+    }
+
+    warmup_state_t* state = warmup_state_create();
+    for( size_t i=0; i < files.size(); ++i ) {
+        if ( ! need[ files[i] ] )
+            continue;
+        need[ files[i] ] = false;
+
+        warmup_build_t build;
+        build.state   = state;
+        build.path    = g_runtime.find_file( files[i] );
+        build.program = NULL;
+        build.cached  = false;
+        build.done    = false;
+        if ( build.path == "" ) {
+            fprintf( stderr, "Error: file '%s' not found in $CLMAGMA_PATH or $LD_LIBRARY_PATH\n",
+                     files[i].c_str() );
+            info = MAGMA_ERR_NOT_FOUND;
+            continue;
+        }
+        state->builds.push_back( build );
+    }
+
+    // start builds; builds vector must not be resized after this
+    int nbuild = (int) state->builds.size();
+    if ( nbuild > 0 ) {
+        magma_thread_queue pool;
+        pool.launch( min( nbuild, (int) magma_get_parallel_numthreads() ));
+        for( int i=0; i < nbuild; ++i ) {
+            pool.push_task( new warmup_task( &state->builds[i] ));
+        }
+        pool.sync();
+        pool.quit();
+
+        // wait for asynchronous builds
+        pthread_mutex_lock( &state->mutex );
+        while( state->ndone < nbuild ) {
+            pthread_cond_wait( &state->cond, &state->mutex );
+        }
+        pthread_mutex_unlock( &state->mutex );
+
+        // load kernels on this thread, since the kernel map is not thread safe
+        for( int i=0; i < nbuild; ++i ) {
+            warmup_build_t& build = state->builds[i];
+            if ( build.program == NULL ) {
+                info = (info == MAGMA_SUCCESS ? MAGMA_ERR_UNKNOWN : info);
+                continue;
+            }
+            cl_int err = g_runtime.finish_build( build.path.c_str(), build.program,
+                                                 build.key, build.cached );
+            if ( err != CL_SUCCESS && info == MAGMA_SUCCESS ) {
+                info = err;
+            }
+        }
+    }
+    warmup_state_release( state );
+
+    return info;
+}
@@ -14,6 +14,8 @@
 
 #include "magma.h"
 #include "error.h"
+#include "trace.h"
+#include "magma_stats.h"
 
 #if defined(HAVE_clBLAS)
 
@@ -38,8 +40,10 @@ magma_zsetvector(
         cl_int err = clEnqueueWriteBuffer(
             queue, dy_dst, CL_TRUE,
             dy_offset*sizeof(magmaDoubleComplex), n*sizeof(magmaDoubleComplex),
-            hx_src, 0, NULL, g_event);
+            hx_src, 0, NULL, trace_event( g_event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, n*sizeof(magmaDoubleComplex), 0 );
     }
     else {
         magma_int_t ldha = incx;
@@ -66,8 +70,10 @@ magma_zsetvector_async(
         cl_int err = clEnqueueWriteBuffer(
             queue, dy_dst, CL_FALSE,
             dy_offset*sizeof(magmaDoubleComplex), n*sizeof(magmaDoubleComplex),
-            hx_src, 0, NULL, event);
+            hx_src, 0, NULL, trace_event( event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, n*sizeof(magmaDoubleComplex), 0 );
     }
     else {
         magma_int_t ldha = incx;
@@ -94,8 +100,10 @@ magma_zgetvector(
         cl_int err = clEnqueueReadBuffer(
             queue, dx_src, CL_TRUE,
             dx_offset*sizeof(magmaDoubleComplex), n*sizeof(magmaDoubleComplex),
-            hy_dst, 0, NULL, g_event);
+            hy_dst, 0, NULL, trace_event( g_event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, 0, n*sizeof(magmaDoubleComplex) );
     }
     else {
         magma_int_t ldda = incx;
@@ -122,8 +130,10 @@ magma_zgetvector_async(
         cl_int err = clEnqueueReadBuffer(
             queue, dx_src, CL_FALSE,
             dx_offset*sizeof(magmaDoubleComplex), n*sizeof(magmaDoubleComplex),
-            hy_dst, 0, NULL, event);
+            hy_dst, 0, NULL, trace_event( event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
+        magma_stats_transfer( queue, 0, n*sizeof(magmaDoubleComplex) );
     }
     else {
         magma_int_t ldda = incx;
@@ -150,8 +160,9 @@ magma_zcopyvector(
         cl_int err = clEnqueueReadBuffer(
             queue, dx_src, CL_TRUE,
             dx_offset*sizeof(magmaDoubleComplex), n*sizeof(magmaDoubleComplex),
-            dy_dst, dy_offset*sizeof(magmaDoubleComplex), NULL, g_event);
+            dy_dst, dy_offset*sizeof(magmaDoubleComplex), NULL, trace_event( g_event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
     }
     else {
         magma_int_t ldda = incx;
@@ -178,8 +189,9 @@ magma_zcopyvector_async(
         cl_int err = clEnqueueReadBuffer(
             queue, dx_src, CL_FALSE,
             dx_offset*sizeof(magmaDoubleComplex), n*sizeof(magmaDoubleComplex),
-            dy_dst, dy_offset*sizeof(magmaDoubleComplex), NULL, event);
+            dy_dst, dy_offset*sizeof(magmaDoubleComplex), NULL, trace_event( event ));
         check_error( err );
+        trace_command( queue, "transfer", __func__ );
     }
     else {
         magma_int_t ldda = incx;
@@ -213,8 +225,10 @@ magma_zsetmatrix(
         buffer_origin, host_orig, region,
         lddb*sizeof(magmaDoubleComplex), 0,
         ldha*sizeof(magmaDoubleComplex), 0,
-        hA_src, 0, NULL, g_event );
+        hA_src, 0, NULL, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, region[0]*region[1], 0 );
 }
 
 // --------------------
@@ -236,9 +250,11 @@ magma_zsetmatrix_async(
         buffer_origin, host_orig, region,
         lddb*sizeof(magmaDoubleComplex), 0,
         ldha*sizeof(magmaDoubleComplex), 0,
-        hA_src, 0, NULL, event );
+        hA_src, 0, NULL, trace_event( event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, region[0]*region[1], 0 );
 }
 
 // --------------------
@@ -260,8 +276,10 @@ magma_zgetmatrix(
         buffer_origin, host_orig, region,
         ldda*sizeof(magmaDoubleComplex), 0,
         ldhb*sizeof(magmaDoubleComplex), 0,
-        hB_dst, 0, NULL, g_event );
+        hB_dst, 0, NULL, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, 0, region[0]*region[1] );
 }
 
 // --------------------
@@ -283,9 +301,11 @@ magma_zgetmatrix_async(
         buffer_origin, host_orig, region,
         ldda*sizeof(magmaDoubleComplex), 0,
         ldhb*sizeof(magmaDoubleComplex), 0,
-        hB_dst, 0, NULL, event );
+        hB_dst, 0, NULL, trace_event( event ) );
     clFlush(queue);
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
+    magma_stats_transfer( queue, 0, region[0]*region[1] );
 }
 
 // --------------------
@@ -307,8 +327,9 @@ magma_zcopymatrix(
         src_origin, dst_orig, region,
         ldda*sizeof(magmaDoubleComplex), 0,
         lddb*sizeof(magmaDoubleComplex), 0,
-        0, NULL, g_event );
+        0, NULL, trace_event( g_event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
 }
 
 // --------------------
@@ -331,8 +352,9 @@ magma_zcopymatrix_async(
         src_origin, dst_orig, region,
         ldda*sizeof(magmaDoubleComplex), 0,
         lddb*sizeof(magmaDoubleComplex), 0,
-        0, NULL, event );
+        0, NULL, trace_event( event ) );
     check_error( err );
+    trace_command( queue, "transfer", __func__ );
 }
 
 #endif // HAVE_clBLAS
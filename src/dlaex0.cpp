@@ -8,15 +8,169 @@
 
     @precisions normal d -> s
 */
+#include <deque>
+#include <vector>
+
 #include "common_magma.h"
+#include "thread_queue.hpp"
 #include "magma_timer.h"
 
+// maximum number of queues for sibling merges that multiply on the device
+const magma_int_t dlaex0_nqueue = 4;
+
+// A node of the divide and conquer tree covers rows and columns
+// [submat, submat + matsiz) of Q: a leaf is solved by dsteqr, a merge by
+// magma_dlaex1. Nodes whose ranges are disjoint run concurrently, so each
+// uses the part of every workspace that belongs to its rows:
+//   work  from 4*submat + submat*n,   4*matsiz + matsiz**2 entries;
+//   iwork from 4*submat,              4*matsiz entries;
+//   dwork from 3*submat*(n/2 + 1),    3*matsiz*(matsiz/2 + 1) entries;
+// these stay in 4*N + N**2, 4*N, and 3*N*N/2 + 3*N.
+struct dlaex0_data
+{
+    magma_int_t         n;
+    double*             d;
+    double*             e;
+    double*             Q;
+    magma_int_t         ldq;
+    double*             work;
+    magma_int_t*        iwork;
+    magma_int_t*        indxq;
+    magmaDouble_ptr     dwork;
+    magma_range_t       range;
+    double              vl, vu;
+    magma_int_t         il, iu;
+    magma_queue_t       queue;
+    magma_queue_pool*   pool;
+    magma_int_t*        info;
+    volatile bool       failed;
+
+    double*      node_work ( magma_int_t submat ) const { return work + 4*submat + submat*n; }
+    magma_int_t* node_iwork( magma_int_t submat ) const { return iwork + 4*submat; }
+    size_t       node_dwork( magma_int_t submat ) const { return 3*submat*(n/2 + 1); }
+};
+
+
+// ----------------------------------------
+// Solves the eigenproblem of a leaf.
+class dlaex0_leaf_task: public magma_task
+{
+public:
+    dlaex0_leaf_task( dlaex0_data* data, magma_int_t submat, magma_int_t matsiz ):
+        m_data( data ), m_submat( submat ), m_matsiz( matsiz )
+    {}
+
+    virtual void run()
+    {
+        dlaex0_data* data = m_data;
+        if ( data->failed )
+            return;
+
+        magma_int_t submat = m_submat;
+        magma_int_t matsiz = m_matsiz;
+        magma_int_t iinfo;
+
+        lapackf77_dsteqr( "I", &matsiz, &data->d[submat], &data->e[submat],
+                          data->Q + submat + submat*data->ldq, &data->ldq,
+                          data->node_work( submat ), &iinfo );  // change to edc?
+        if ( iinfo != 0 ) {
+            *data->info  = (submat+1)*(data->n+1) + submat + matsiz;
+            data->failed = true;
+            return;
+        }
+        for( magma_int_t j = 0; j < matsiz; ++j ) {
+            data->indxq[submat + j] = j + 1;
+        }
+    }
+
+private:
+    dlaex0_data* m_data;
+    magma_int_t  m_submat, m_matsiz;
+};
+
+
+// ----------------------------------------
+// Merges the eigensystems of sizes msd2 and matsiz - msd2 of two adjacent
+// nodes into one of size matsiz. Merges large enough to multiply on the
+// device take a queue from the pool, so sibling merges' dgemms run
+// concurrently on different queues.
+static void dlaex0_merge(
+    dlaex0_data* data, magma_int_t submat, magma_int_t matsiz, magma_int_t msd2 )
+{
+    if ( data->failed )
+        return;
+
+    magma_int_t n = data->n;
+    magma_int_t iinfo;
+
+    // DLAEX1 is used only for the full eigensystem of a tridiagonal
+    // matrix; we need all the eigenvectors if it is not the last step.
+    magma_range_t range2 = (matsiz == n ? data->range : MagmaRangeAll);
+
+    magma_int_t on_device = (matsiz >= magma_get_dlaed3_k());
+    magma_queue_t queue = (on_device ? data->pool->acquire( 0 ) : data->queue);
+
+    magma_dlaex1( matsiz, &data->d[submat],
+                  data->Q + submat + submat*data->ldq, data->ldq,
+                  &data->indxq[submat], data->e[submat+msd2-1], msd2,
+                  data->node_work( submat ), data->node_iwork( submat ),
+                  data->dwork, data->node_dwork( submat ),
+                  range2, data->vl, data->vu, data->il, data->iu,
+                  queue, data->pool, &iinfo );
+
+    if ( on_device ) {
+        data->pool->release( 0, queue );
+    }
+    if ( iinfo != 0 ) {
+        *data->info  = (submat+1)*(n+1) + submat + matsiz;
+        data->failed = true;
+    }
+}
+
+
+// ----------------------------------------
+// Merges two children, once both are done; see dlaex0_merge.
+class dlaex0_merge_task: public magma_task
+{
+public:
+    dlaex0_merge_task( dlaex0_data* data, magma_int_t submat, magma_int_t matsiz,
+                       magma_int_t msd2 ):
+        m_data( data ), m_submat( submat ), m_matsiz( matsiz ), m_msd2( msd2 )
+    {}
+
+    virtual void run()
+    {
+        dlaex0_merge( m_data, m_submat, m_matsiz, m_msd2 );
+    }
+
+private:
+    dlaex0_data* m_data;
+    magma_int_t  m_submat, m_matsiz, m_msd2;
+};
+
+
 /**
     Purpose
     -------
     DLAEX0 computes all eigenvalues and the choosen eigenvectors of a
     symmetric tridiagonal matrix using the divide and conquer method.
 
+    The leaves and merges of the divide and conquer tree are tasks of a
+    magma_thread_queue: a merge starts as soon as its two children are done,
+    so independent merges run concurrently, each with its share of the CPU
+    threads. The LAPACK thread count is process-wide, so it is set once
+    before the tasks start, and again for the final merge, which runs alone
+    after them with all threads. Merges large enough to multiply on the
+    device use their own queues, up to dlaex0_nqueue: queue and a chain of
+    companions (see magma_queue_get_companion), which are kept between calls,
+    so the dgemms of sibling merges overlap on the device.
+
+    Q stays on the CPU, and each merge that multiplies on the device uploads
+    its part of Q again (see magma_dlaex3). Q cannot stay on the device
+    between levels, because the deflation in LAPACK's dlaed2, called by
+    magma_dlaex1, permutes the columns of Q and applies Givens rotations to
+    them on the CPU.
+
     Arguments
     ---------
     @param[in]
@@ -110,9 +264,8 @@ magma_dlaex0(
 #define Q(i_,j_) (Q + (i_) + (j_)*ldq)
 
     magma_int_t ione = 1;
-    magma_range_t range2;
-    magma_int_t curlvl, i, indxq;
-    magma_int_t j, k, matsiz, msd2, smlsiz;
+    magma_int_t i, indxq;
+    magma_int_t j, matsiz, msd2, smlsiz;
     magma_int_t submat, subpbs, tlvls;
 
 
@@ -158,84 +311,115 @@ magma_dlaex0(
         d[submat] -= MAGMA_D_ABS(e[submat-1]);
     }
 
+    // The nodes use the leading 4*N entries of IWORK, so keep the
+    // partition elsewhere.
+    std::vector< magma_int_t > part( iwork, iwork + subpbs );
+
     indxq = 4*n + 3;
 
-    // Solve each submatrix eigenproblem at the bottom of the divide and
-    // conquer tree.
+    // Queues for merges that multiply on the device, if there can be several
+    // such merges at once: queue, its companion, the companion's companion,
+    // etc. Companions are created once and destroyed with queue.
+    magma_queue_t queues[ dlaex0_nqueue ];
+    magma_int_t nqueue = 1;
+    queues[0] = queue;
+    magma_int_t nqueue_max = min( dlaex0_nqueue, n / magma_get_dlaed3_k() );
+    while( nqueue < nqueue_max &&
+           MAGMA_SUCCESS == magma_queue_get_companion( queues[nqueue-1], &queues[nqueue] )) {
+        ++nqueue;
+    }
+    magma_queue_pool pool( 1, nqueue, queues );
+
+    magma_int_t nthread_save = magma_get_lapack_numthreads();
+    magma_int_t nthread = max( 1, magma_get_parallel_numthreads() );
+    magma_int_t ntask_thread = min( nthread, subpbs );
+
+    dlaex0_data data;
+    data.n       = n;
+    data.d       = d;
+    data.e       = e;
+    data.Q       = Q;
+    data.ldq     = ldq;
+    data.work    = work;
+    data.iwork   = iwork;
+    data.indxq   = &iwork[indxq];
+    data.dwork   = dwork;
+    data.range   = range;
+    data.vl      = vl;
+    data.vu      = vu;
+    data.il      = il;
+    data.iu      = iu;
+    data.queue   = queue;
+    data.pool    = &pool;
+    data.info    = info;
+    data.failed  = false;
+
     magma_timer_t time=0;
     timer_start( time );
 
+    // LAPACK threads are shared by the concurrent tasks
+    magma_set_lapack_numthreads( max( 1, nthread / ntask_thread ));
+    magma_thread_queue tasks;
+    tasks.launch( ntask_thread );
+
+    // Solve each submatrix eigenproblem at the bottom of the divide and
+    // conquer tree.
+    std::vector< magma_task* > nodes( subpbs );
     for (i = 0; i < subpbs; ++i){
-        if(i == 0){
-            submat = 0;
-            matsiz = iwork[0];
-        } else {
-            submat = iwork[i-1];
-            matsiz = iwork[i] - iwork[i-1];
-        }
-        lapackf77_dsteqr("I" , &matsiz, &d[submat], &e[submat],
-                         Q(submat, submat), &ldq, work, info);  // change to edc?
-        if(*info != 0){
-            printf("info: %d\n, submat: %d\n", (int) *info, (int) submat);
-            *info = (submat+1)*(n+1) + submat + matsiz;
-            printf("info: %d\n", (int) *info);
-            return *info;
-        }
-        k = 1;
-        for(j = submat; j < iwork[i]; ++j){
-            iwork[indxq+j] = k;
-            ++k;
-        }
+        submat = (i == 0 ? 0 : part[i-1]);
+        matsiz = part[i] - submat;
+        nodes[i] = new dlaex0_leaf_task( &data, submat, matsiz );
+        tasks.push_task( nodes[i] );
     }
 
-    timer_stop( time );
-    timer_printf( "  for: dsteqr = %6.2f\n", time );
-
     // Successively merge eigensystems of adjacent submatrices
     // into eigensystem for the corresponding larger matrix.
-    curlvl = 1;
-    while (subpbs > 1){
-        timer_start( time );
-
+    // Higher levels have higher priority, as they are on the critical path.
+    // The final merge is done after the tasks, below.
+    magma_int_t curlvl = 1;
+    while (subpbs > 2){
         for (i=0; i<subpbs-1; i+=2){
             if(i == 0){
                 submat = 0;
-                matsiz = iwork[1];
-                msd2 = iwork[0];
+                matsiz = part[1];
+                msd2 = part[0];
             } else {
-                submat = iwork[i-1];
-                matsiz = iwork[i+1] - iwork[i-1];
+                submat = part[i-1];
+                matsiz = part[i+1] - part[i-1];
                 msd2 = matsiz / 2;
             }
 
             // Merge lower order eigensystems (of size MSD2 and MATSIZ - MSD2)
-            // into an eigensystem of size MATSIZ.
-            // DLAEX1 is used only for the full eigensystem of a tridiagonal
-            // matrix.
-            if (matsiz == n)
-                range2 = range;
-            else
-                // We need all the eigenvectors if it is not last step
-                range2 = MagmaRangeAll;
-
-            magma_dlaex1(matsiz, &d[submat], Q(submat, submat), ldq,
-                         &iwork[indxq+submat], e[submat+msd2-1], msd2,
-                         work, &iwork[subpbs], dwork,
-                         range2, vl, vu, il, iu, queue, info);
-
-            if(*info != 0){
-                *info = (submat+1)*(n+1) + submat + matsiz;
-                return *info;
-            }
-            iwork[i/2]= iwork[i+1];
+            // into an eigensystem of size MATSIZ, after both are done.
+            magma_task* children[2] = { nodes[i], nodes[i+1] };
+            nodes[i/2] = new dlaex0_merge_task( &data, submat, matsiz, msd2 );
+            tasks.push_task( nodes[i/2], curlvl, 2, children );
+            part[i/2] = part[i+1];
         }
         subpbs /= 2;
         ++curlvl;
+    }
+
+    tasks.sync();
+    tasks.quit();
 
-        timer_stop( time );
-        timer_printf("%d: time: %6.2f\n", (int) curlvl, time );
+    // Final merge, alone, so with all LAPACK threads.
+    if (subpbs == 2) {
+        magma_set_lapack_numthreads( nthread );
+        dlaex0_merge( &data, 0, part[1], part[0] );
     }
 
+    timer_stop( time );
+    timer_printf( "  dsteqr + %d levels of merges: time: %6.2f\n", (int) tlvls, time );
+
+    magma_set_lapack_numthreads( nthread_save );
+    for( magma_int_t q = 1; q < nqueue; ++q ) {
+        magma_queue_sync( queues[q] );
+    }
+
+    if (*info != 0)
+        return *info;
+
     // Re-merge the eigenvalues/vectors which were deflated at the final
     // merge step.
     for(i = 0; i<n; ++i){
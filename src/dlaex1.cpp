@@ -85,7 +85,8 @@
     iwork   (workspace) INTEGER array, dimension (4*N)
 
     @param
-    dwork   (workspace) DOUBLE PRECISION array, dimension (3*N*N/2+3*N)
+    dwork   (workspace) DOUBLE PRECISION array on the GPU, dimension (3*N*N/2+3*N),
+            starting at element dwork_offset.
 
     @param[in]
     range   magma_range_t
@@ -111,6 +112,15 @@
             1 <= IL <= IU <= N, if N > 0; IL = 1 and IU = 0 if N = 0.
             Not referenced if RANGE = MagmaRangeAll or MagmaRangeV.
 
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[in]
+    pool    magma_queue_pool*
+            In the C++ variant only: the queue pool of magma_dlaex0, whose
+            concurrent merges lock the BLAS kernels they enqueue, or NULL.
+
     @param[out]
     info    INTEGER
       -     = 0:  successful exit.
@@ -133,11 +143,31 @@ magma_dlaex1(
     double *Q, magma_int_t ldq,
     magma_int_t *indxq, double rho, magma_int_t cutpnt,
     double *work, magma_int_t *iwork,
-    magmaDouble_ptr dwork,
+    magmaDouble_ptr dwork, size_t dwork_offset,
     magma_range_t range, double vl, double vu,
     magma_int_t il, magma_int_t iu,
     magma_queue_t queue,
     magma_int_t *info)
+{
+    return magma_dlaex1( n, d, Q, ldq, indxq, rho, cutpnt, work, iwork,
+                         dwork, dwork_offset, range, vl, vu, il, iu,
+                         queue, NULL, info );
+}
+
+
+// ----------------------------------------
+magma_int_t
+magma_dlaex1(
+    magma_int_t n,
+    double *d,
+    double *Q, magma_int_t ldq,
+    magma_int_t *indxq, double rho, magma_int_t cutpnt,
+    double *work, magma_int_t *iwork,
+    magmaDouble_ptr dwork, size_t dwork_offset,
+    magma_range_t range, double vl, double vu,
+    magma_int_t il, magma_int_t iu,
+    magma_queue_t queue, magma_queue_pool* pool,
+    magma_int_t *info)
 {
 #define Q(i_,j_) (Q + (i_) + (j_)*ldq)
 
@@ -203,7 +233,7 @@ magma_dlaex1(
         magma_dlaex3(k, n, cutpnt, d, Q, ldq, rho,
                      &work[idlmda], &work[iq2], &iwork[indxc],
                      &iwork[coltyp], &work[iw], &work[is],
-                     indxq, dwork, range, vl, vu, il, iu, queue, info );
+                     indxq, dwork, dwork_offset, range, vl, vu, il, iu, queue, pool, info );
         if( *info != 0 )
             return *info;
     }
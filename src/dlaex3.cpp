@@ -13,12 +13,16 @@
 #include <omp.h>
 #endif
 
+#include <deque>
+#include <vector>
+
 #include "common_magma.h"
+#include "thread_queue.hpp"
 #include "magma_timer.h"
 
 extern "C" {
 
-int magma_get_dlaed3_k() { return 512; }
+magma_int_t magma_get_dlaed3_k() { return 512; }
 
 void magma_dvrange(
     magma_int_t k, double *d, magma_int_t *il, magma_int_t *iu, double vl, double vu)
@@ -168,7 +172,8 @@ void magma_dirange(
             i.e. D( INDXQ( I = 1, N ) ) will be in ascending order.
 
     @param
-    dwork   (workspace) DOUBLE PRECISION array, dimension (3*N*N/2+3*N)
+    dwork   (workspace) DOUBLE PRECISION array on the GPU, dimension (3*N*N/2+3*N),
+            starting at element dwork_offset.
 
     @param[in]
     range   magma_range_t
@@ -195,6 +200,15 @@ void magma_dirange(
             1 <= IL <= IU <= N, if N > 0; IL = 1 and IU = 0 if N = 0.
             Not referenced if RANGE = MagmaRangeAll or MagmaRangeV.
 
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[in]
+    pool    magma_queue_pool*
+            In the C++ variant only: the queue pool of magma_dlaex0, whose
+            concurrent merges lock the BLAS kernels they enqueue, or NULL.
+
     @param[out]
     info    INTEGER
       -     = 0:  successful exit.
@@ -217,10 +231,29 @@ magma_dlaex3(
     double *Q, magma_int_t ldq, double rho,
     double *dlamda, double *Q2, magma_int_t *indx,
     magma_int_t *ctot, double *w, double *s, magma_int_t *indxq,
-    magmaDouble_ptr dwork,
+    magmaDouble_ptr dwork, size_t dwork_offset,
     magma_range_t range, double vl, double vu, magma_int_t il, magma_int_t iu,
     magma_queue_t queue,
     magma_int_t *info )
+{
+    return magma_dlaex3( k, n, n1, d, Q, ldq, rho, dlamda, Q2, indx, ctot,
+                         w, s, indxq, dwork, dwork_offset,
+                         range, vl, vu, il, iu, queue, NULL, info );
+}
+
+
+// ----------------------------------------
+magma_int_t
+magma_dlaex3(
+    magma_int_t k, magma_int_t n, magma_int_t n1,
+    double *d,
+    double *Q, magma_int_t ldq, double rho,
+    double *dlamda, double *Q2, magma_int_t *indx,
+    magma_int_t *ctot, double *w, double *s, magma_int_t *indxq,
+    magmaDouble_ptr dwork, size_t dwork_offset,
+    magma_range_t range, double vl, double vu, magma_int_t il, magma_int_t iu,
+    magma_queue_t queue, magma_queue_pool* pool,
+    magma_int_t *info )
 {
     #define   Q(i_,j_) (Q + (i_) + (j_)*ldq)
     #define  dQ(i_,j_) dQ,  ( dq_offset + (i_) + (j_)*lddq)
@@ -235,7 +268,7 @@ magma_dlaex3(
     magma_int_t iil, iiu, rk;
 
     magma_int_t lddq = n/2 + 1;
-    magmaDouble_ptr dQ2 = dwork; size_t dq2_offset = 0;
+    magmaDouble_ptr dQ2 = dwork; size_t dq2_offset = dwork_offset;
     magmaDouble_ptr dS  = dQ2;   size_t ds_offset  = dq2_offset + n*lddq;
     magmaDouble_ptr dQ  = dS;    size_t dq_offset  = ds_offset  + n*lddq;
 
@@ -305,7 +338,10 @@ magma_dlaex3(
     iq2 = n1 * n12;
     lq2 = iq2 + n2 * n23;
 
-    magma_dsetvector_async( lq2, Q2, 1, dQ2(0,0), 1, queue, NULL );
+    // the products below run on the device only if rk >= dlaed3_k, and
+    // rk <= k; then send Q2 now, while the CPU solves the secular equation
+    if (k >= magma_get_dlaed3_k())
+        magma_dsetvector_async( lq2, Q2, 1, dQ2(0,0), 1, queue, NULL );
 
 #ifdef _OPENMP
     /////////////////////////////////////////////////////////////////////////////////
@@ -512,7 +548,8 @@ magma_dlaex3(
     // Compute the updated eigenvectors.
 
     timer_start( time );
-    magma_queue_sync( queue );
+    if (k >= magma_get_dlaed3_k())
+        magma_queue_sync( queue );
 
     if (rk != 0) {
         if ( n23 != 0 ) {
@@ -522,10 +559,12 @@ magma_dlaex3(
                               s, &n23, &d_zero, Q(n1,iil-1), &ldq );
             } else {
                 magma_dsetmatrix( n23, rk, Q(ctot[0],iil-1), ldq, dS(0,0), n23, queue );
+                if ( pool != NULL ) pool->lock_kernels( "gemm" );
                 magma_dgemm( MagmaNoTrans, MagmaNoTrans, n2, rk, n23,
                              d_one,  dQ2(iq2,0), n2,
                                      dS(0,0), n23,
                              d_zero, dQ(0,0), lddq, queue);
+                if ( pool != NULL ) pool->unlock_kernels( "gemm" );
                 magma_dgetmatrix( n2, rk, dQ(0,0), lddq, Q(n1,iil-1), ldq, queue );
             }
         } else
@@ -538,10 +577,12 @@ magma_dlaex3(
                               s, &n12, &d_zero, Q(0,iil-1), &ldq);
             } else {
                 magma_dsetmatrix( n12, rk, Q(0,iil-1), ldq, dS(0,0), n12, queue );
+                if ( pool != NULL ) pool->lock_kernels( "gemm" );
                 magma_dgemm( MagmaNoTrans, MagmaNoTrans, n1, rk, n12,
                              d_one,  dQ2(0,0), n1,
                                      dS(0,0), n12,
                              d_zero, dQ(0,0), lddq, queue);
+                if ( pool != NULL ) pool->unlock_kernels( "gemm" );
                 magma_dgetmatrix( n1, rk, dQ(0,0), lddq, Q(0,iil-1), ldq, queue );
             }
         } else
@@ -0,0 +1,102 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Raffaele Solca
+
+       @precisions normal d -> s
+
+*/
+#include "common_magma.h"
+
+/**
+    Purpose
+    -------
+    Moves the selected eigenvalues to the beginning of the array w, and
+    returns in il, iu the indices of the first and last of them, so that
+    eigenvectors il through iu are the ones to keep.
+
+    Arguments
+    ---------
+    @param[in]
+    range   magma_range_t
+      -     = MagmaRangeAll: all eigenvalues are selected.
+      -     = MagmaRangeV:   the eigenvalues in the half-open interval (VL,VU]
+                             are selected.
+      -     = MagmaRangeI:   the IL-th through IU-th eigenvalues are selected.
+
+    @param[in]
+    n       INTEGER
+            The number of eigenvalues.  N >= 0.
+
+    @param[in,out]
+    w       DOUBLE PRECISION array, dimension (N)
+            On entry, all of the eigenvalues, in ascending order.
+            On exit, the first M elements are the selected eigenvalues.
+
+    @param[in,out]
+    il      INTEGER
+    @param[in,out]
+    iu      INTEGER
+            On entry, if RANGE=MagmaRangeI, the indices (in ascending order)
+            of the smallest and largest eigenvalues to select.
+            On exit, the indices of the smallest and largest selected
+            eigenvalues, for any RANGE.
+
+    @param[in]
+    vl      DOUBLE PRECISION
+    @param[in]
+    vu      DOUBLE PRECISION
+            If RANGE=MagmaRangeV, the lower and upper bounds of the interval.
+            Not referenced if RANGE = MagmaRangeAll or MagmaRangeI.
+
+    @param[out]
+    m       INTEGER
+            The number of selected eigenvalues.
+
+    @ingroup magma_dsyev_comp
+    ********************************************************************/
+extern "C" void
+magma_dmove_eig(
+    magma_range_t range, magma_int_t n, double *w,
+    magma_int_t *il, magma_int_t *iu, double vl, double vu, magma_int_t *m)
+{
+    magma_int_t valeig, indeig, i;
+
+    valeig = (range == MagmaRangeV);
+    indeig = (range == MagmaRangeI);
+
+    if (indeig) {
+        *m = *iu - *il + 1;
+        if (*il > 1)
+            for (i = 0; i < *m; ++i)
+                w[i] = w[*il - 1 + i];
+    }
+    else if (valeig) {
+        *il = 1;
+        *iu = n;
+        for (i = 0; i < n; ++i) {
+            if (w[i] > vu) {
+                *iu = i;
+                break;
+            }
+            else if (w[i] <= vl) {
+                ++*il;
+            }
+            else if (*il > 1) {
+                w[i - *il + 1] = w[i];
+            }
+        }
+        *m = *iu - *il + 1;
+    }
+    else {
+        *il = 1;
+        *iu = n;
+        *m  = n;
+    }
+
+    return;
+}
@@ -313,7 +313,8 @@ magma_dstedx(
             magma_int_t nm = n-1;
             lapackf77_dlascl("G", &izero, &izero, &orgnrm, &d_one, &nm, &ione, e, &nm, info);
 
-            magma_dlaex0( n, d, e, Z, ldz, work, iwork, dwork, range, vl, vu, il, iu, queue, info);
+            // the interval is in the units of the scaled matrix
+            magma_dlaex0( n, d, e, Z, ldz, work, iwork, dwork, range, vl/orgnrm, vu/orgnrm, il, iu, queue, info);
 
             if ( *info != 0) {
                 return *info;
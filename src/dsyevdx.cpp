@@ -0,0 +1,390 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Stan Tomov
+       @author Raffaele Solca
+       @author Mark Gates
+
+       @precisions normal d -> s
+
+*/
+#include "common_magma.h"
+#include "magma_timer.h"
+
+/**
+    Purpose
+    -------
+    DSYEVDX computes selected eigenvalues and, optionally, eigenvectors
+    of a real symmetric matrix A. Eigenvalues and eigenvectors can
+    be selected by specifying either a range of values or a range of
+    indices for the desired eigenvalues.
+
+    Like magma_dsyevd, it uses a divide and conquer algorithm, but
+    magma_dstedx computes the eigenvectors of the tridiagonal matrix only
+    for the selected eigenvalues in the last merge, and magma_dormtr
+    back-transforms only those M columns.
+
+    Arguments
+    ---------
+    @param[in]
+    jobz    magma_vec_t
+      -     = MagmaNoVec:  Compute eigenvalues only;
+      -     = MagmaVec:    Compute eigenvalues and eigenvectors.
+
+    @param[in]
+    range   magma_range_t
+      -     = MagmaRangeAll: all eigenvalues will be found.
+      -     = MagmaRangeV:   all eigenvalues in the half-open interval (VL,VU]
+                             will be found.
+      -     = MagmaRangeI:   the IL-th through IU-th eigenvalues will be found.
+
+    @param[in]
+    uplo    magma_uplo_t
+      -     = MagmaUpper:  Upper triangle of A is stored;
+      -     = MagmaLower:  Lower triangle of A is stored.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix A.  N >= 0.
+
+    @param[in,out]
+    A       DOUBLE PRECISION array, dimension (LDA, N)
+            On entry, the symmetric matrix A.  If UPLO = MagmaUpper, the
+            leading N-by-N upper triangular part of A contains the
+            upper triangular part of the matrix A.  If UPLO = MagmaLower,
+            the leading N-by-N lower triangular part of A contains
+            the lower triangular part of the matrix A.
+            On exit, if JOBZ = MagmaVec, then if INFO = 0, the first M
+            columns of A contain the orthonormal eigenvectors of the
+            matrix A corresponding to the selected eigenvalues.
+            If JOBZ = MagmaNoVec, then on exit the lower triangle (if
+            UPLO = MagmaLower) or the upper triangle (if UPLO = MagmaUpper)
+            of A, including the diagonal, is destroyed.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,N).
+
+    @param[in]
+    vl      DOUBLE PRECISION
+    @param[in]
+    vu      DOUBLE PRECISION
+            If RANGE=MagmaRangeV, the lower and upper bounds of the interval to
+            be searched for eigenvalues. VL < VU.
+            Not referenced if RANGE = MagmaRangeAll or MagmaRangeI.
+
+    @param[in]
+    il      INTEGER
+    @param[in]
+    iu      INTEGER
+            If RANGE=MagmaRangeI, the indices (in ascending order) of the
+            smallest and largest eigenvalues to be returned.
+            1 <= IL <= IU <= N, if N > 0; IL = 1 and IU = 0 if N = 0.
+            Not referenced if RANGE = MagmaRangeAll or MagmaRangeV.
+
+    @param[out]
+    m       INTEGER
+            The total number of eigenvalues found.  0 <= M <= N.
+            If RANGE = MagmaRangeAll, M = N, and if RANGE = MagmaRangeI,
+            M = IU-IL+1.
+
+    @param[out]
+    w       DOUBLE PRECISION array, dimension (N)
+            If INFO = 0, the first M elements are the selected eigenvalues
+            in ascending order.
+
+    @param[out]
+    work    (workspace) DOUBLE PRECISION array, dimension (MAX(1,LWORK))
+            On exit, if INFO = 0, WORK[0] returns the optimal LWORK.
+
+    @param[in]
+    lwork   INTEGER
+            The length of the array WORK; the same as for magma_dsyevd.
+            If N <= 1,                      LWORK >= 1.
+            If JOBZ = MagmaNoVec and N > 1, LWORK >= 2*N + N*NB.
+            If JOBZ = MagmaVec   and N > 1, LWORK >= max( 2*N + N*NB, 1 + 6*N + 2*N**2 ).
+            NB can be obtained through magma_get_dsytrd_nb(N).
+    \n
+            If LWORK = -1, then a workspace query is assumed; the routine
+            only calculates the optimal sizes of the WORK and IWORK
+            arrays, returns these values as the first entries of the WORK
+            and IWORK arrays, and no error message related to LWORK or
+            LIWORK is issued by XERBLA.
+
+    @param[out]
+    iwork   (workspace) INTEGER array, dimension (MAX(1,LIWORK))
+            On exit, if INFO = 0, IWORK[0] returns the optimal LIWORK.
+
+    @param[in]
+    liwork  INTEGER
+            The dimension of the array IWORK.
+            If N <= 1,                      LIWORK >= 1.
+            If JOBZ = MagmaNoVec and N > 1, LIWORK >= 1.
+            If JOBZ = MagmaVec   and N > 1, LIWORK >= 3 + 5*N.
+    \n
+            If LIWORK = -1, then a workspace query is assumed; see LWORK.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+      -     > 0:  if INFO = i and JOBZ = MagmaNoVec, then the algorithm
+                  failed to converge; i off-diagonal elements of an
+                  intermediate tridiagonal form did not converge to zero;
+                  if INFO = i and JOBZ = MagmaVec, then the algorithm failed
+                  to compute an eigenvalue while working on the submatrix
+                  lying in rows and columns INFO/(N+1) through
+                  mod(INFO,N+1).
+
+    @ingroup magma_dsyev_driver
+    ********************************************************************/
+extern "C" magma_int_t
+magma_dsyevdx(
+    magma_vec_t jobz, magma_range_t range, magma_uplo_t uplo,
+    magma_int_t n,
+    double *A, magma_int_t lda,
+    double vl, double vu, magma_int_t il, magma_int_t iu,
+    magma_int_t *m, double *w,
+    double *work, magma_int_t lwork,
+    magma_int_t *iwork, magma_int_t liwork,
+    magma_queue_t queue,
+    magma_int_t *info)
+{
+    const char* uplo_  = lapack_uplo_const( uplo );
+    const char* jobz_  = lapack_vec_const( jobz );
+    magma_int_t ione = 1;
+    magma_int_t izero = 0;
+    double d_one = 1.;
+
+    double d__1;
+
+    double eps;
+    magma_int_t inde;
+    double anrm;
+    magma_int_t imax;
+    double rmin, rmax;
+    double sigma;
+    magma_int_t iinfo, lwmin;
+    magma_int_t lower;
+    magma_int_t wantz;
+    magma_int_t alleig, valeig, indeig;
+    magma_int_t indwk2, llwrk2;
+    magma_int_t iscale;
+    double safmin;
+    double bignum;
+    magma_int_t indtau;
+    magma_int_t indwrk, liwmin;
+    magma_int_t llwork;
+    double smlnum;
+    magma_int_t lquery;
+
+    magmaDouble_ptr dwork;
+
+    wantz  = (jobz == MagmaVec);
+    lower  = (uplo == MagmaLower);
+    alleig = (range == MagmaRangeAll);
+    valeig = (range == MagmaRangeV);
+    indeig = (range == MagmaRangeI);
+    lquery = (lwork == -1 || liwork == -1);
+
+    *info = 0;
+    if (! (wantz || (jobz == MagmaNoVec))) {
+        *info = -1;
+    } else if (! (alleig || valeig || indeig)) {
+        *info = -2;
+    } else if (! (lower || (uplo == MagmaUpper))) {
+        *info = -3;
+    } else if (n < 0) {
+        *info = -4;
+    } else if (lda < max(1,n)) {
+        *info = -6;
+    } else {
+        if (valeig) {
+            if (n > 0 && vu <= vl) {
+                *info = -8;
+            }
+        } else if (indeig) {
+            if (il < 1 || il > max(1,n)) {
+                *info = -9;
+            } else if (iu < min(n,il) || iu > n) {
+                *info = -10;
+            }
+        }
+    }
+
+    magma_int_t nb = magma_get_dsytrd_nb( n );
+    if ( n <= 1 ) {
+        lwmin  = 1;
+        liwmin = 1;
+    }
+    else if ( wantz ) {
+        lwmin  = max( 2*n + n*nb, 1 + 6*n + 2*n*n );
+        liwmin = 3 + 5*n;
+    }
+    else {
+        lwmin  = 2*n + n*nb;
+        liwmin = 1;
+    }
+    // multiply by 1+eps to ensure length gets rounded up,
+    // if it cannot be exactly represented in floating point.
+    double one_eps = 1. + lapackf77_dlamch("Epsilon");
+    work[0]  = lwmin * one_eps;
+    iwork[0] = liwmin;
+
+    if (*info == 0) {
+        if ((lwork < lwmin) && !lquery) {
+            *info = -14;
+        } else if ((liwork < liwmin) && ! lquery) {
+            *info = -16;
+        }
+    }
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+    else if (lquery) {
+        return *info;
+    }
+
+    /* Quick return if possible */
+    *m = 0;
+    if (n == 0) {
+        return *info;
+    }
+
+    if (n == 1) {
+        w[0] = A[0];
+        if (valeig && ! (vl < w[0] && w[0] <= vu)) {
+            return *info;
+        }
+        *m = 1;
+        if (wantz) {
+            A[0] = 1.;
+        }
+        return *info;
+    }
+
+    /* Check if matrix is very small then just call LAPACK on CPU, no need for GPU */
+    if (n <= 128) {
+        lapackf77_dsyevd(jobz_, uplo_,
+                         &n, A, &lda,
+                         w, work, &lwork,
+                         iwork, &liwork, info);
+        magma_dmove_eig(range, n, w, &il, &iu, vl, vu, m);
+        if (wantz && il > 1) {
+            for (magma_int_t j = 0; j < *m; ++j) {
+                blasf77_dcopy(&n, &A[(il-1+j)*lda], &ione, &A[j*lda], &ione);
+            }
+        }
+        return *info;
+    }
+
+    /* Get machine constants. */
+    safmin = lapackf77_dlamch("Safe minimum");
+    eps    = lapackf77_dlamch("Precision");
+    smlnum = safmin / eps;
+    bignum = 1. / smlnum;
+    rmin = magma_dsqrt(smlnum);
+    rmax = magma_dsqrt(bignum);
+
+    /* Scale matrix to allowable range, if necessary. */
+    anrm = lapackf77_dlansy("M", uplo_, &n, A, &lda, work );
+    iscale = 0;
+    if (anrm > 0. && anrm < rmin) {
+        iscale = 1;
+        sigma = rmin / anrm;
+    } else if (anrm > rmax) {
+        iscale = 1;
+        sigma = rmax / anrm;
+    }
+    if (iscale == 1) {
+        lapackf77_dlascl(uplo_, &izero, &izero, &d_one, &sigma, &n, &n, A,
+                         &lda, info);
+        if (valeig) {
+            vl *= sigma;
+            vu *= sigma;
+        }
+    }
+
+    /* Call DSYTRD to reduce symmetric matrix to tridiagonal form. */
+    // dsytrd work: e (n) + tau (n) + llwork (n*nb)  ==>  2n + n*nb
+    // dstedx work: e (n) + tau (n) + z (n*n) + llwrk2 (1 + 4*n + n^2)  ==>  1 + 6n + 2n^2
+    inde   = 0;
+    indtau = inde   + n;
+    indwrk = indtau + n;
+    indwk2 = indwrk + n*n;
+    llwork = lwork - indwrk;
+    llwrk2 = lwork - indwk2;
+
+    magma_timer_t time;
+    timer_start( time );
+
+    magma_dsytrd(uplo, n, A, lda, w, &work[inde],
+                 &work[indtau], &work[indwrk], llwork, queue, &iinfo);
+
+    timer_stop( time );
+    timer_printf( "time dsytrd = %6.2f\n", time );
+
+    /* For eigenvalues only, call DSTERF and select them.  For eigenvectors,
+     * first call DSTEDX to generate the eigenvectors of the tridiagonal
+     * matrix for the selected eigenvalues, in columns IL through IU of
+     * WORK(INDWRK), then call DORMTR to multiply only those M columns by the
+     * Householder transformations represented as Householder vectors in A. */
+    if (! wantz) {
+        lapackf77_dsterf(&n, w, &work[inde], info);
+        magma_dmove_eig(range, n, w, &il, &iu, vl, vu, m);
+    }
+    else {
+        timer_start( time );
+
+        if (MAGMA_SUCCESS != magma_dmalloc( &dwork, 3*n*(n/2 + 1) )) {
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+
+        magma_dstedx(range, n, vl, vu, il, iu, w, &work[inde],
+                     &work[indwrk], n, &work[indwk2],
+                     llwrk2, iwork, liwork, dwork, queue, info);
+
+        magma_free( dwork );
+
+        timer_stop( time );
+        timer_printf( "time dstedx = %6.2f\n", time );
+        timer_start( time );
+
+        magma_dmove_eig(range, n, w, &il, &iu, vl, vu, m);
+
+        magma_dormtr(MagmaLeft, uplo, MagmaNoTrans, n, *m, A, lda, &work[indtau],
+                     &work[indwrk + n*(il-1)], n, &work[indwk2], llwrk2, queue, &iinfo);
+
+        lapackf77_dlacpy("A", &n, m, &work[indwrk + n*(il-1)], &n, A, &lda);
+
+        timer_stop( time );
+        timer_printf( "time dormtr + copy = %6.2f\n", time );
+    }
+
+    /* If matrix was scaled, then rescale eigenvalues appropriately. */
+    if (iscale == 1) {
+        if (*info == 0) {
+            imax = *m;
+        } else {
+            imax = *info - 1;
+        }
+        d__1 = 1. / sigma;
+        blasf77_dscal(&imax, &d__1, w, &ione);
+    }
+
+    work[0]  = lwmin * one_eps;  // round up
+    iwork[0] = liwmin;
+
+    return *info;
+} /* magma_dsyevdx */
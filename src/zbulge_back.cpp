@@ -0,0 +1,236 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Mark Gates
+
+       @precisions normal z -> s d c
+
+*/
+#include "common_magma.h"
+
+/**
+    Purpose
+    -------
+    Returns the number of consecutive sweeps of the bulge chase that
+    magma_zbulge_back groups into one block reflector.
+
+    @param[in]
+    m       INTEGER
+            The order of the matrix.
+
+    @param[in]
+    nb      INTEGER
+            The bandwidth of the band matrix.
+
+    @ingroup magma_zheev_2stage
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zbulge_get_Vblksiz( magma_int_t m, magma_int_t nb )
+{
+    if ( m <= 2000 )
+        return min( nb, 32 );
+    else
+        return min( nb, 64 );
+}
+
+
+/**
+    Purpose
+    -------
+    ZBULGE_BACK applies Q2, from the bulge chase of magma_zhetrd_hb2st, to
+    the n-by-ne matrix Z on the device: Z = Q2 Z. Applied to eigenvectors of
+    the tridiagonal matrix, this gives eigenvectors of the band matrix.
+
+    The reflectors of Vblksiz consecutive sweeps that cover the same rows
+    are one block reflector, with a V of nb + Vblksiz - 1 rows. For each
+    group of sweeps, the CPU forms V and T of all of its block reflectors
+    and sends them to the device in one transfer, while the device applies
+    the previous group with magma_zlarfb_gpu.
+
+    Arguments
+    ---------
+    @param[in]
+    n       INTEGER
+            The order of Q2.  N >= 0.
+
+    @param[in]
+    nb      INTEGER
+            The bandwidth of the band matrix reduced by magma_zhetrd_hb2st.
+
+    @param[in]
+    ne      INTEGER
+            The number of columns of Z.  NE >= 0.
+
+    @param[in]
+    Vblksiz INTEGER
+            The number of sweeps in a block reflector; see
+            magma_zbulge_get_Vblksiz.  VBLKSIZ >= 1.
+
+    @param[in]
+    V2      COMPLEX_16 array, dimension (N*(N-1)/2)
+            The Householder vectors from magma_zhetrd_hb2st.
+
+    @param[in]
+    tau2    COMPLEX_16 array, dimension (LDTAU,N-1)
+            The scalar factors from magma_zhetrd_hb2st.
+
+    @param[in]
+    ldtau   INTEGER
+            The leading dimension of the array tau2.
+
+    @param[in,out]
+    dZ      COMPLEX_16 array on the GPU, dimension (LDDZ,NE)
+            On entry, the n-by-ne matrix Z.
+            On exit, Z is overwritten by Q2 Z.
+
+    @param[in]
+    lddz    INTEGER
+            The leading dimension of the array dZ.  LDDZ >= max(1,N).
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+
+    @ingroup magma_zheev_2stage
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zbulge_back(
+    magma_int_t n, magma_int_t nb, magma_int_t ne, magma_int_t Vblksiz,
+    magmaDoubleComplex *V2, magmaDoubleComplex *tau2, magma_int_t ldtau,
+    magmaDoubleComplex_ptr dZ, size_t dZ_offset, magma_int_t lddz,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define dZ(i_, j_)  dZ,    (dZ_offset + (i_) + (j_)*lddz)
+    #define dV(b_, k_)  dwork, (dVT_offset[b_] + (k_)*lslot)
+    #define dT(b_, k_)  dwork, (dVT_offset[b_] + (k_)*lslot + ldv*Vblksiz)
+    #define dW          dwork, dW_offset
+
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+
+    *info = 0;
+    if ( n < 0 ) {
+        *info = -1;
+    } else if ( nb < 1 ) {
+        *info = -2;
+    } else if ( ne < 0 ) {
+        *info = -3;
+    } else if ( Vblksiz < 1 ) {
+        *info = -4;
+    } else if ( ldtau < max( 1, magma_ceildiv( n, nb ))) {
+        *info = -7;
+    } else if ( lddz < max(1,n) ) {
+        *info = -10;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( n <= 1 || ne == 0 )
+        return *info;
+
+    // a slot holds V (ldv-by-Vblksiz) and T (Vblksiz-by-Vblksiz) of one
+    // block reflector; a group has at most nblock of them.
+    // Two groups are in flight, so there are two buffers, on each side.
+    magma_int_t ldv    = nb + Vblksiz - 1;
+    magma_int_t lslot  = ldv*Vblksiz + Vblksiz*Vblksiz;
+    magma_int_t nblock = magma_ceildiv( n-1, nb );
+    magma_int_t lgroup = nblock*lslot;
+
+    magmaDoubleComplex *hVT[2], *htau;
+    magmaDoubleComplex_ptr dwork;
+    size_t dVT_offset[2] = { 0, (size_t) lgroup };
+    size_t dW_offset = 2*lgroup;
+    if (MAGMA_SUCCESS != magma_zmalloc_pinned( &hVT[0], 2*lgroup )) {
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+    hVT[1] = hVT[0] + lgroup;
+    if (MAGMA_SUCCESS != magma_zmalloc_cpu( &htau, Vblksiz )) {
+        magma_free_pinned( hVT[0] );
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+    if (MAGMA_SUCCESS != magma_zmalloc( &dwork, 2*lgroup + ne*Vblksiz )) {
+        magma_free_pinned( hVT[0] );
+        magma_free_cpu( htau );
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+    magma_event_t event[2] = { NULL, NULL };
+
+    // Q2 = G(0) G(1) ..., G(g) the product of the reflectors of sweep group
+    // g. Within a group, reflector k of a sweep overlaps reflector k-1 of
+    // the later sweeps, so G(g) = B(g,K) ... B(g,1) B(g,0), where B(g,k) is
+    // the block reflector of the k-th reflectors of its sweeps.
+    // Z = G(0) ( G(1) ( ... Z )): the last group and its B(g,0) go first.
+    magma_int_t ngroup = magma_ceildiv( n-1, Vblksiz );
+    for( magma_int_t g = ngroup-1; g >= 0; --g ) {
+        magma_int_t b  = (ngroup-1-g) % 2;
+        magma_int_t s0 = g*Vblksiz;
+        magma_int_t s1 = min( s0 + Vblksiz, n-1 );
+        magmaDoubleComplex *hgroup = hVT[b];
+
+        // the transfer from this buffer two groups ago must be done
+        if ( event[b] != NULL ) {
+            magma_event_sync( event[b] );
+            magma_event_destroy( event[b] );
+            event[b] = NULL;
+        }
+
+        magma_int_t kmax = magma_ceildiv( n-1-s0, nb );
+        for( magma_int_t k = 0; k < kmax; ++k ) {
+            magma_int_t r0 = s0 + 1 + k*nb;            // first row of the block
+            magma_int_t m  = min( ldv, n - r0 );       // rows of V
+            magma_int_t kk = min( s1 - s0, m );        // sweeps that reach row r0+i
+            magmaDoubleComplex *hV   = hgroup + k*lslot;
+            magmaDoubleComplex *hT   = hV + ldv*Vblksiz;
+
+            lapackf77_zlaset( MagmaFullStr, &ldv, &kk, &c_zero, &c_zero, hV, &ldv );
+            for( magma_int_t i = 0; i < kk; ++i ) {
+                magma_int_t s   = s0 + i;
+                magma_int_t len = min( nb, m - i );
+                // row r0+i of sweep s is at offset r0+i-s-1 = k*nb in its column
+                memcpy( hV + i + i*ldv, V2 + s*(2*n - s - 1)/2 + k*nb,
+                        len*sizeof(magmaDoubleComplex) );
+                htau[i] = tau2[ s*ldtau + k ];
+            }
+            lapackf77_zlarft( MagmaForwardStr, MagmaColumnwiseStr, &m, &kk,
+                              hV, &ldv, htau, hT, &Vblksiz );
+        }
+        magma_zsetvector_async( kmax*lslot, hgroup, 1, dV(b, 0), 1, queue, &event[b] );
+
+        for( magma_int_t k = 0; k < kmax; ++k ) {
+            magma_int_t r0 = s0 + 1 + k*nb;
+            magma_int_t m  = min( ldv, n - r0 );
+            magma_int_t kk = min( s1 - s0, m );
+            magma_zlarfb_gpu( MagmaLeft, MagmaNoTrans, MagmaForward, MagmaColumnwise,
+                              m, ne, kk,
+                              dV(b, k),  ldv,
+                              dT(b, k),  Vblksiz,
+                              dZ(r0, 0), lddz,
+                              dW,        ne, queue );
+        }
+    }
+
+    magma_queue_sync( queue );
+    for( magma_int_t b = 0; b < 2; ++b ) {
+        if ( event[b] != NULL )
+            magma_event_destroy( event[b] );
+    }
+    magma_free( dwork );
+    magma_free_pinned( hVT[0] );
+    magma_free_cpu( htau );
+    return *info;
+} /* magma_zbulge_back */
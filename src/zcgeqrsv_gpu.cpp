@@ -0,0 +1,365 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+
+*/
+#include "common_magma.h"
+
+#define BWDMAX 1.0
+#define ITERMAX 30
+
+/**
+    Purpose
+    -------
+    ZCGEQRSV solves the least squares problem
+       min || A*X - B ||,
+    where A is an M-by-N matrix with M >= N, and X and B are
+    N-by-NRHS and M-by-NRHS matrices.
+
+    ZCGEQRSV first attempts to factorize the matrix in complex SINGLE PRECISION
+    and use this factorization within an iterative refinement procedure
+    to produce a solution with complex DOUBLE PRECISION norm-wise backward error
+    quality (see below). If the approach fails the method switches to a
+    complex DOUBLE PRECISION factorization and solve.
+
+    The iterative refinement is not going to be a winning strategy if
+    the ratio complex SINGLE PRECISION performance over complex DOUBLE PRECISION
+    performance is too small. A reasonable strategy should take the
+    number of right-hand sides and the size of the matrix into account.
+    This might be done with a call to ILAENV in the future. Up to now, we
+    always try iterative refinement.
+
+    The iterative refinement process is stopped if
+        ITER > ITERMAX
+    or for all the RHS we have:
+        RNRM < SQRT(N)*XNRM*ANRM*EPS*BWDMAX
+    where
+        o ITER is the number of the current iteration in the iterative
+          refinement process
+        o RNRM is the infinity-norm of the residual
+        o XNRM is the infinity-norm of the solution
+        o ANRM is the infinity-operator-norm of the matrix A
+        o EPS is the machine epsilon returned by DLAMCH('Epsilon')
+    The value ITERMAX and BWDMAX are fixed to 30 and 1.0D+00 respectively.
+
+    Workspace is allocated in the routine.
+
+    Arguments
+    ---------
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrix A. M >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrix A. M >= N >= 0.
+
+    @param[in]
+    nrhs    INTEGER
+            The number of right hand sides, i.e., the number of columns
+            of the matrix B.  NRHS >= 0.
+
+    @param[in,out]
+    dA      COMPLEX_16 array on the GPU, dimension (LDDA,N)
+            On entry, the M-by-N coefficient matrix A.
+            On exit, if iterative refinement has been successfully used
+            (INFO.EQ.0 and ITER.GE.0, see description below), A is
+            unchanged. If double precision factorization has been used
+            (INFO.EQ.0 and ITER.LT.0, see description below), then the
+            array dA contains the QR factorization of A as returned by
+            function MAGMA_ZGEQRF_GPU.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of the array dA.  LDDA >= max(1,M).
+
+    @param[in]
+    dB      COMPLEX_16 array on the GPU, dimension (LDDB,NRHS)
+            The M-by-NRHS right hand side matrix B.
+
+    @param[in]
+    lddb    INTEGER
+            The leading dimension of the array dB.  LDDB >= max(1,M).
+
+    @param[out]
+    dX      COMPLEX_16 array on the GPU, dimension (LDDX,NRHS)
+            If INFO = 0, the N-by-NRHS solution matrix X.
+
+    @param[in]
+    lddx    INTEGER
+            The leading dimension of the array dX.  LDDX >= max(1,N).
+
+    @param[out]
+    iter    INTEGER
+      -     < 0: iterative refinement has failed, double precision
+                 factorization has been performed
+        +        -1 : the routine fell back to full precision for
+                      implementation- or machine-specific reasons
+        +        -2 : narrowing the precision induced an overflow,
+                      the routine fell back to full precision
+        +        -3 : failure of CGEQRF
+        +        -31: stop the iterative refinement after the 30th iteration
+      -     > 0: iterative refinement has been successfully used.
+                 Returns the number of iterations
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+                  or another error occured, such as memory allocation failed.
+
+    @ingroup magma_zgels_driver
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zcgeqrsv_gpu(
+    magma_int_t m, magma_int_t n, magma_int_t nrhs,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda,
+    magmaDoubleComplex_ptr dB, size_t dB_offset, magma_int_t lddb,
+    magmaDoubleComplex_ptr dX, size_t dX_offset, magma_int_t lddx,
+    magma_int_t *iter,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define dA(i,j)     dA, ( (dA_offset) + (i) + (j)*ldda )
+    #define dB(i,j)     dB, ( (dB_offset) + (i) + (j)*lddb )
+    #define dX(i,j)     dX, ( (dX_offset) + (i) + (j)*lddx )
+    #define dR(i,j)     dR, (                (i) + (j)*lddr )
+    #define dSA(i,j)   dSA, (                (i) + (j)*lddsa)
+    #define dSX(i,j)   dSX, (lddsa*n       + (i) + (j)*lddsx)
+
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    magmaDoubleComplex_ptr dR = NULL, dT = NULL;
+    magmaFloatComplex_ptr dSA = NULL, dSX, dST = NULL;
+    magmaDoubleComplex *hwork = NULL, *tau = NULL;
+    magmaFloatComplex  *hworks = NULL, *stau = NULL;
+    magmaDoubleComplex Xnrmv, Rnrmv;
+    double          Anrm, Xnrm, Rnrm, cte, eps;
+    magma_int_t     i, j, iiter, lddsa, lddsx, lddr, k;
+    magma_int_t     nb, lhwork, ldtwork, nbs, lhworks, ldtworks;
+
+    /* Check arguments */
+    *iter = 0;
+    *info = 0;
+    if ( m < 0 )
+        *info = -1;
+    else if ( n < 0 || n > m )
+        *info = -2;
+    else if ( nrhs < 0 )
+        *info = -3;
+    else if ( ldda < max(1,m))
+        *info = -5;
+    else if ( lddb < max(1,m))
+        *info = -7;
+    else if ( lddx < max(1,n))
+        *info = -9;
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( m == 0 || n == 0 || nrhs == 0 )
+        return *info;
+
+    k = min(m,n);
+    lddsa = m;
+    lddsx = m;
+    lddr  = m;
+
+    /* workspace sizes, as in magma_zgels_gpu */
+    nb       = magma_get_zgeqrf_nb(m);
+    lhwork   = (m - n + nb)*(nrhs + nb) + nrhs*nb;
+    ldtwork  = ( 2*k + magma_roundup( n, 32 ) )*max( nb, nrhs );
+    nbs      = magma_get_cgeqrf_nb(m);
+    lhworks  = (m - n + nbs)*(nrhs + nbs) + nrhs*nbs;
+    ldtworks = ( 2*k + magma_roundup( n, 32 ) )*max( nbs, nrhs );
+
+    /* double precision workspace: residual dR, and dT for the fallback */
+    if ( MAGMA_SUCCESS != magma_zmalloc( &dR, lddr*nrhs )
+      || MAGMA_SUCCESS != magma_zmalloc( &dT, ldtwork )) {
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        goto CLEANUP;
+    }
+    if ( MAGMA_SUCCESS != magma_zmalloc_cpu( &tau,   k      )
+      || MAGMA_SUCCESS != magma_zmalloc_cpu( &hwork, lhwork )) {
+        *info = MAGMA_ERR_HOST_ALLOC;
+        goto CLEANUP;
+    }
+
+    /* single precision workspace: dSA and dSX, dST; if it can't be
+       allocated, go straight to double precision */
+    if ( MAGMA_SUCCESS != magma_cmalloc( &dSA, lddsa*n + lddsx*nrhs )
+      || MAGMA_SUCCESS != magma_cmalloc( &dST, ldtworks )
+      || MAGMA_SUCCESS != magma_cmalloc_cpu( &stau,   k       )
+      || MAGMA_SUCCESS != magma_cmalloc_cpu( &hworks, lhworks )) {
+        *iter = -1;
+        goto FALLBACK;
+    }
+    dSX = dSA;
+
+    eps  = lapackf77_dlamch("Epsilon");
+    Anrm = magmablas_zlange( MagmaInfNorm, m, n, dA(0,0), ldda,
+                             dR(0,0), lddr*nrhs, queue );
+    cte  = Anrm * eps * magma_dsqrt( n ) * BWDMAX;
+
+    /*
+     * Convert to single precision
+     */
+    magmablas_zlag2c( m, nrhs, dB(0,0), lddb, dSX(0,0), lddsx, queue, info );
+    if (*info != 0) {
+        *iter = -2;
+        goto FALLBACK;
+    }
+
+    magmablas_zlag2c( m, n, dA(0,0), ldda, dSA(0,0), lddsa, queue, info );
+    if (*info != 0) {
+        *iter = -2;
+        goto FALLBACK;
+    }
+
+    // factor dSA in single precision
+    magma_cgeqrf_gpu( m, n, dSA(0,0), lddsa, stau, dST, 0, queue, info );
+    if (*info != 0) {
+        *iter = -3;
+        goto FALLBACK;
+    }
+
+    // solve dSA*dSX = dB in single precision
+    magma_cgeqrs_gpu( m, n, nrhs, dSA(0,0), lddsa, stau, dST, 0,
+                      dSX(0,0), lddsx, hworks, lhworks, queue, info );
+
+    // residual dR = dB - dA*dX in double precision
+    magmablas_clag2z( n, nrhs, dSX(0,0), lddsx, dX(0,0), lddx, queue, info );
+    magmablas_zlacpy( MagmaUpperLower, m, nrhs, dB(0,0), lddb, dR(0,0), lddr, queue );
+    if ( nrhs == 1 ) {
+        magma_zgemv( MagmaNoTrans, m, n,
+                     c_neg_one, dA(0,0), ldda,
+                                dX(0,0), 1,
+                     c_one,     dR(0,0), 1, queue );
+    }
+    else {
+        magma_zgemm( MagmaNoTrans, MagmaNoTrans, m, nrhs, n,
+                     c_neg_one, dA(0,0), ldda,
+                                dX(0,0), lddx,
+                     c_one,     dR(0,0), lddr, queue );
+    }
+
+    for( j=0; j < nrhs; j++ ) {
+        i = magma_izamax( n, dX(0,j), 1, queue) - 1;
+        magma_zgetmatrix( 1, 1, dX(i,j), 1, &Xnrmv, 1, queue );
+        Xnrm = MAGMA_Z_ABS( Xnrmv );
+
+        i = magma_izamax ( m, dR(0,j), 1, queue ) - 1;
+        magma_zgetmatrix( 1, 1, dR(i,j), 1, &Rnrmv, 1, queue );
+        Rnrm = MAGMA_Z_ABS( Rnrmv );
+
+        if ( Rnrm >  Xnrm*cte ) {
+            goto REFINEMENT;
+        }
+    }
+
+    *iter = 0;
+    goto CLEANUP;
+
+REFINEMENT:
+    for( iiter=1; iiter < ITERMAX; ) {
+        *info = 0;
+        // convert residual dR to single precision dSX
+        magmablas_zlag2c( m, nrhs, dR(0,0), lddr, dSX(0,0), lddsx, queue, info );
+        if (*info != 0) {
+            *iter = -2;
+            goto FALLBACK;
+        }
+        // solve dSA*dSX = R in single precision
+        magma_cgeqrs_gpu( m, n, nrhs, dSA(0,0), lddsa, stau, dST, 0,
+                          dSX(0,0), lddsx, hworks, lhworks, queue, info );
+
+        // Add correction and setup residual
+        // dX += dSX [including conversion]  --and--
+        // dR(0:n) = dB(0:n), then dR(n:m) = dB(n:m)
+        for( j=0; j < nrhs; j++ ) {
+            magmablas_zcaxpycp( n, dSX(0,j), dX(0,j), dB(0,j), dR(0,j), queue );
+        }
+        if ( m > n ) {
+            magmablas_zlacpy( MagmaUpperLower, m-n, nrhs, dB(n,0), lddb, dR(n,0), lddr, queue );
+        }
+
+        // residual dR = dB - dA*dX in double precision
+        if ( nrhs == 1 ) {
+            magma_zgemv( MagmaNoTrans, m, n,
+                         c_neg_one, dA(0,0), ldda,
+                                    dX(0,0), 1,
+                         c_one,     dR(0,0), 1, queue );
+        }
+        else {
+            magma_zgemm( MagmaNoTrans, MagmaNoTrans, m, nrhs, n,
+                         c_neg_one, dA(0,0), ldda,
+                                    dX(0,0), lddx,
+                         c_one,     dR(0,0), lddr, queue );
+        }
+
+        /*  Check whether the nrhs normwise backward errors satisfy the
+         *  stopping criterion. If yes, set ITER=IITER > 0 and return. */
+        for( j=0; j < nrhs; j++ ) {
+            i = magma_izamax( n, dX(0,j), 1, queue) - 1;
+            magma_zgetmatrix( 1, 1, dX(i,j), 1, &Xnrmv, 1, queue );
+            Xnrm = MAGMA_Z_ABS( Xnrmv );
+
+            i = magma_izamax ( m, dR(0,j), 1, queue ) - 1;
+            magma_zgetmatrix( 1, 1, dR(i,j), 1, &Rnrmv, 1, queue );
+            Rnrm = MAGMA_Z_ABS( Rnrmv );
+
+            if ( Rnrm >  Xnrm*cte ) {
+                goto L20;
+            }
+        }
+
+        /*  If we are here, the nrhs normwise backward errors satisfy
+         *  the stopping criterion, we are good to exit. */
+        *iter = iiter;
+        goto CLEANUP;
+
+      L20:
+        iiter++;
+    }
+
+    /* If we are at this place of the code, this is because we have
+     * performed ITER=ITERMAX iterations and never satisified the
+     * stopping criterion. Set up the ITER flag accordingly and follow
+     * up on double precision routine. */
+    *iter = -ITERMAX - 1;
+
+FALLBACK:
+    /* Single-precision iterative refinement failed to converge to a
+     * satisfactory solution, so we resort to double precision. */
+    magma_zgeqrf_gpu( m, n, dA(0,0), ldda, tau, dT, 0, queue, info );
+    if (*info == 0) {
+        // solve in dR, as zgeqrs overwrites B, then copy the first n rows to dX
+        magmablas_zlacpy( MagmaUpperLower, m, nrhs, dB(0,0), lddb, dR(0,0), lddr, queue );
+        magma_zgeqrs_gpu( m, n, nrhs, dA(0,0), ldda, tau, dT, 0,
+                          dR(0,0), lddr, hwork, lhwork, queue, info );
+        magmablas_zlacpy( MagmaUpperLower, n, nrhs, dR(0,0), lddr, dX(0,0), lddx, queue );
+    }
+
+CLEANUP:
+    if ( dR  != NULL ) magma_free( dR  );
+    if ( dT  != NULL ) magma_free( dT  );
+    if ( dSA != NULL ) magma_free( dSA );
+    if ( dST != NULL ) magma_free( dST );
+    magma_free_cpu( tau    );
+    magma_free_cpu( hwork  );
+    magma_free_cpu( stau   );
+    magma_free_cpu( hworks );
+
+    return *info;
+}
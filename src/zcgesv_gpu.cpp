@@ -0,0 +1,373 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+
+*/
+#include "common_magma.h"
+
+#define BWDMAX 1.0
+#define ITERMAX 30
+
+/**
+    Purpose
+    -------
+    ZCGESV computes the solution to a complex system of linear equations
+        A * X = B,  A**T * X = B,  or  A**H * X = B,
+    where A is an N-by-N matrix and X and B are N-by-NRHS matrices.
+
+    ZCGESV first attempts to factorize the matrix in complex SINGLE PRECISION
+    and use this factorization within an iterative refinement procedure
+    to produce a solution with complex DOUBLE PRECISION norm-wise backward error
+    quality (see below). If the approach fails the method switches to a
+    complex DOUBLE PRECISION factorization and solve.
+
+    The iterative refinement is not going to be a winning strategy if
+    the ratio complex SINGLE PRECISION performance over complex DOUBLE PRECISION
+    performance is too small. A reasonable strategy should take the
+    number of right-hand sides and the size of the matrix into account.
+    This might be done with a call to ILAENV in the future. Up to now, we
+    always try iterative refinement.
+
+    The iterative refinement process is stopped if
+        ITER > ITERMAX
+    or for all the RHS we have:
+        RNRM < SQRT(N)*XNRM*ANRM*EPS*BWDMAX
+    where
+        o ITER is the number of the current iteration in the iterative
+          refinement process
+        o RNRM is the infinity-norm of the residual
+        o XNRM is the infinity-norm of the solution
+        o ANRM is the infinity-operator-norm of the matrix A
+        o EPS is the machine epsilon returned by DLAMCH('Epsilon')
+    The value ITERMAX and BWDMAX are fixed to 30 and 1.0D+00 respectively.
+
+    Arguments
+    ---------
+    @param[in]
+    trans   magma_trans_t
+            Specifies the form of the system of equations:
+      -     = MagmaNoTrans:    A    * X = B  (No transpose)
+      -     = MagmaTrans:      A**T * X = B  (Transpose)
+      -     = MagmaConjTrans:  A**H * X = B  (Conjugate transpose)
+
+    @param[in]
+    n       INTEGER
+            The number of linear equations, i.e., the order of the
+            matrix A.  N >= 0.
+
+    @param[in]
+    nrhs    INTEGER
+            The number of right hand sides, i.e., the number of columns
+            of the matrix B.  NRHS >= 0.
+
+    @param[in,out]
+    dA      COMPLEX_16 array on the GPU, dimension (LDDA,N)
+            On entry, the N-by-N coefficient matrix A.
+            On exit, if iterative refinement has been successfully used
+            (INFO.EQ.0 and ITER.GE.0, see description below), then A is
+            unchanged, if double factorization has been used
+            (INFO.EQ.0 and ITER.LT.0, see description below), then the
+            array dA contains the factors L and U from the factorization
+            A = P*L*U; the unit diagonal elements of L are not stored.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of the array dA.  LDDA >= max(1,N).
+
+    @param[out]
+    ipiv    INTEGER array, dimension (N)
+            The pivot indices that define the permutation matrix P;
+            row i of the matrix was interchanged with row IPIV(i).
+            Corresponds either to the single precision factorization
+            (if INFO.EQ.0 and ITER.GE.0) or the double precision
+            factorization (if INFO.EQ.0 and ITER.LT.0).
+
+    @param[out]
+    dipiv   INTEGER array on the GPU, dimension (N)
+            The permutation from the single precision factorization, as
+            used by magma_zcgetrs_gpu: row i of P*A is row dipiv(i) of A,
+            0-based.
+
+    @param[in]
+    dB      COMPLEX_16 array on the GPU, dimension (LDDB,NRHS)
+            The N-by-NRHS right hand side matrix B.
+
+    @param[in]
+    lddb    INTEGER
+            The leading dimension of the array dB.  LDDB >= max(1,N).
+
+    @param[out]
+    dX      COMPLEX_16 array on the GPU, dimension (LDDX,NRHS)
+            If INFO = 0, the N-by-NRHS solution matrix X.
+
+    @param[in]
+    lddx    INTEGER
+            The leading dimension of the array dX.  LDDX >= max(1,N).
+
+    @param
+    dworkd  (workspace) COMPLEX_16 array on the GPU, dimension (N*NRHS)
+            This array is used to hold the residual vectors.
+
+    @param
+    dworks  (workspace) COMPLEX array on the GPU, dimension (N*(N+NRHS))
+            This array is used to store the complex single precision matrix
+            and the right-hand sides or solutions in single precision.
+
+    @param[out]
+    iter    INTEGER
+      -     < 0: iterative refinement has failed, double precision
+                 factorization has been performed
+        +        -1 : the routine fell back to full precision for
+                      implementation- or machine-specific reasons
+        +        -2 : narrowing the precision induced an overflow,
+                      the routine fell back to full precision
+        +        -3 : failure of CGETRF
+        +        -31: stop the iterative refinement after the 30th iteration
+      -     > 0: iterative refinement has been successfully used.
+                 Returns the number of iterations
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+      -     > 0:  if INFO = i, U(i,i) computed in DOUBLE PRECISION is
+                  exactly zero.  The factorization has been completed,
+                  but the factor U is exactly singular, so the solution
+                  could not be computed.
+
+    @ingroup magma_zgesv_driver
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zcgesv_gpu(
+    magma_trans_t trans, magma_int_t n, magma_int_t nrhs,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda,
+    magma_int_t *ipiv,
+    magmaInt_ptr dipiv,
+    magmaDoubleComplex_ptr dB, size_t dB_offset, magma_int_t lddb,
+    magmaDoubleComplex_ptr dX, size_t dX_offset, magma_int_t lddx,
+    magmaDoubleComplex_ptr dworkd, size_t dworkd_offset,
+    magmaFloatComplex_ptr dworks, size_t dworks_offset,
+    magma_int_t *iter,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define dA(i,j)     dA, ( (dA_offset) + (i) + (j)*ldda )
+    #define dB(i,j)     dB, ( (dB_offset) + (i) + (j)*lddb )
+    #define dX(i,j)     dX, ( (dX_offset) + (i) + (j)*lddx )
+    #define dR(i,j)     dR, ( (dR_offset) + (i) + (j)*lddr )
+    #define dSA(i,j)   dSA, ((dSA_offset) + (i) + (j)*lddsa)
+    #define dSX(i,j)   dSX, ((dSX_offset) + (i) + (j)*lddsx)
+
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    magmaDoubleComplex_ptr dR;
+    magmaFloatComplex_ptr dSA, dSX;
+    size_t dR_offset, dSA_offset, dSX_offset;
+    magmaDoubleComplex Xnrmv, Rnrmv;
+    double          Anrm, Xnrm, Rnrm, cte, eps;
+    magma_int_t     i, j, iiter, lddsa, lddsx, lddr, tmp;
+    magma_int_t    *perm;
+
+    /* Check arguments */
+    *iter = 0;
+    *info = 0;
+    if ( (trans != MagmaNoTrans) &&
+         (trans != MagmaTrans)   &&
+         (trans != MagmaConjTrans) )
+        *info = -1;
+    else if ( n < 0 )
+        *info = -2;
+    else if ( nrhs < 0 )
+        *info = -3;
+    else if ( ldda < max(1,n))
+        *info = -5;
+    else if ( lddb < max(1,n))
+        *info = -9;
+    else if ( lddx < max(1,n))
+        *info = -11;
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( n == 0 || nrhs == 0 )
+        return *info;
+
+    lddsa = n;
+    lddsx = n;
+    lddr  = n;
+
+    dSA = dworks;
+    dSA_offset = dworks_offset;
+
+    dSX = dSA;
+    dSX_offset = dSA_offset + lddsa*n;
+
+    dR  = dworkd;
+    dR_offset = dworkd_offset;
+
+    if ( MAGMA_SUCCESS != magma_imalloc_cpu( &perm, n )) {
+        *iter = -1;
+        goto FALLBACK;
+    }
+
+    eps  = lapackf77_dlamch("Epsilon");
+    Anrm = magmablas_zlange( MagmaInfNorm, n, n, dA(0,0), ldda,
+                             dworkd, dworkd_offset, n*nrhs, queue );
+    cte  = Anrm * eps * magma_dsqrt( n ) * BWDMAX;
+
+    /*
+     * Convert to single precision
+     */
+    magmablas_zlag2c( n, n, dA(0,0), ldda, dSA(0,0), lddsa, queue, info );
+    if (*info != 0) {
+        *iter = -2;
+        goto FALLBACK;
+    }
+
+    // factor dSA in single precision
+    magma_cgetrf_gpu( n, n, dSA(0,0), lddsa, ipiv, queue, info );
+    if (*info != 0) {
+        *iter = -3;
+        goto FALLBACK;
+    }
+
+    // turn the interchanges into a permutation, so zclaswp
+    // permutes all rows at once
+    for( i=0; i < n; i++ ) {
+        perm[i] = i;
+    }
+    for( i=0; i < n; i++ ) {
+        tmp = perm[i];
+        perm[i] = perm[ ipiv[i]-1 ];
+        perm[ ipiv[i]-1 ] = tmp;
+    }
+    magma_setvector( n, sizeof(magma_int_t), perm, 1, dipiv, 0, 1, queue );
+
+    // solve dSA*dSX = dB in single precision
+    // converts result back to double precision in dX
+    magma_zcgetrs_gpu( trans, n, nrhs, dSA(0,0), lddsa, dipiv, 0,
+                       dB(0,0), lddb, dX(0,0), lddx, dSX(0,0), queue, info );
+
+    // residual dR = dB - dA*dX in double precision
+    magmablas_zlacpy( MagmaUpperLower, n, nrhs, dB(0,0), lddb, dR(0,0), lddr, queue );
+    if ( nrhs == 1 ) {
+        magma_zgemv( trans, n, n,
+                     c_neg_one, dA(0,0), ldda,
+                                dX(0,0), 1,
+                     c_one,     dR(0,0), 1, queue );
+    }
+    else {
+        magma_zgemm( trans, MagmaNoTrans, n, nrhs, n,
+                     c_neg_one, dA(0,0), ldda,
+                                dX(0,0), lddx,
+                     c_one,     dR(0,0), lddr, queue );
+    }
+
+    for( j=0; j < nrhs; j++ ) {
+        i = magma_izamax( n, dX(0,j), 1, queue) - 1;
+        magma_zgetmatrix( 1, 1, dX(i,j), 1, &Xnrmv, 1, queue );
+        Xnrm = MAGMA_Z_ABS( Xnrmv );
+
+        i = magma_izamax ( n, dR(0,j), 1, queue ) - 1;
+        magma_zgetmatrix( 1, 1, dR(i,j), 1, &Rnrmv, 1, queue );
+        Rnrm = MAGMA_Z_ABS( Rnrmv );
+
+        if ( Rnrm >  Xnrm*cte ) {
+            goto REFINEMENT;
+        }
+    }
+
+    *iter = 0;
+    magma_free_cpu( perm );
+    return *info;
+
+REFINEMENT:
+    for( iiter=1; iiter < ITERMAX; ) {
+        *info = 0;
+        // convert residual dR to single precision dSX,
+        // solve dSA*dSX = dR in single precision,
+        // convert result back to double precision in dR
+        // it's okay that dR is used for both dB input and dX output.
+        magma_zcgetrs_gpu( trans, n, nrhs, dSA(0,0), lddsa, dipiv, 0,
+                           dR(0,0), lddr, dR(0,0), lddr, dSX(0,0), queue, info );
+        if (*info != 0) {
+            *iter = -2;
+            goto FALLBACK;
+        }
+
+        // Add correction and setup residual
+        // dX += dR  --and--
+        // dR = dB
+        for( j=0; j < nrhs; j++ ) {
+            magmablas_zaxpycp( n, dR(0,j), dX(0,j), dB(0,j), queue );
+        }
+
+        // residual dR = dB - dA*dX in double precision
+        if ( nrhs == 1 ) {
+            magma_zgemv( trans, n, n,
+                         c_neg_one, dA(0,0), ldda,
+                                    dX(0,0), 1,
+                         c_one,     dR(0,0), 1, queue );
+        }
+        else {
+            magma_zgemm( trans, MagmaNoTrans, n, nrhs, n,
+                         c_neg_one, dA(0,0), ldda,
+                                    dX(0,0), lddx,
+                         c_one,     dR(0,0), lddr, queue );
+        }
+
+        /*  Check whether the nrhs normwise backward errors satisfy the
+         *  stopping criterion. If yes, set ITER=IITER > 0 and return. */
+        for( j=0; j < nrhs; j++ ) {
+            i = magma_izamax( n, dX(0,j), 1, queue) - 1;
+            magma_zgetmatrix( 1, 1, dX(i,j), 1, &Xnrmv, 1, queue );
+            Xnrm = MAGMA_Z_ABS( Xnrmv );
+
+            i = magma_izamax ( n, dR(0,j), 1, queue ) - 1;
+            magma_zgetmatrix( 1, 1, dR(i,j), 1, &Rnrmv, 1, queue );
+            Rnrm = MAGMA_Z_ABS( Rnrmv );
+
+            if ( Rnrm >  Xnrm*cte ) {
+                goto L20;
+            }
+        }
+
+        /*  If we are here, the nrhs normwise backward errors satisfy
+         *  the stopping criterion, we are good to exit. */
+        *iter = iiter;
+        magma_free_cpu( perm );
+        return *info;
+
+      L20:
+        iiter++;
+    }
+
+    /* If we are at this place of the code, this is because we have
+     * performed ITER=ITERMAX iterations and never satisified the
+     * stopping criterion. Set up the ITER flag accordingly and follow
+     * up on double precision routine. */
+    *iter = -ITERMAX - 1;
+
+FALLBACK:
+    /* Single-precision iterative refinement failed to converge to a
+     * satisfactory solution, so we resort to double precision. */
+    magma_free_cpu( perm );
+    magma_zgetrf_gpu( n, n, dA(0,0), ldda, ipiv, queue, info );
+    if (*info == 0) {
+        magmablas_zlacpy( MagmaUpperLower, n, nrhs, dB(0,0), lddb, dX(0,0), lddx, queue );
+        magma_zgetrs_gpu( trans, n, nrhs, dA(0,0), ldda, ipiv, dX(0,0), lddx, queue, info );
+    }
+
+    return *info;
+}
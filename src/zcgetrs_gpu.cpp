@@ -0,0 +1,158 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+
+*/
+#include "common_magma.h"
+
+/**
+    Purpose
+    -------
+    ZCGETRS solves a system of linear equations
+        A * X = B,  A**T * X = B,  or  A**H * X = B
+    with a general N-by-N matrix A using the LU factorization computed
+    by MAGMA_CGETRF_GPU, in complex SINGLE PRECISION. B and X are in
+    complex DOUBLE PRECISION; the conversions are done on the GPU, fused
+    with the row permutation.
+
+    Arguments
+    ---------
+    @param[in]
+    trans   magma_trans_t
+            Specifies the form of the system of equations:
+      -     = MagmaNoTrans:    A    * X = B  (No transpose)
+      -     = MagmaTrans:      A**T * X = B  (Transpose)
+      -     = MagmaConjTrans:  A**H * X = B  (Conjugate transpose)
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix A.  N >= 0.
+
+    @param[in]
+    nrhs    INTEGER
+            The number of right hand sides, i.e., the number of columns
+            of the matrix B.  NRHS >= 0.
+
+    @param[in]
+    dA      COMPLEX array on the GPU, dimension (LDDA,N)
+            The factors L and U from the factorization A = P*L*U
+            as computed by MAGMA_CGETRF_GPU.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of the array dA.  LDDA >= max(1,N).
+
+    @param[in]
+    dipiv   INTEGER array on the GPU, dimension (N)
+            The row permutation from the factorization, 0-based: row i of
+            P*A is row dipiv(i) of A. Unlike IPIV from CGETRF, these are
+            not interchanges to apply one after another; see magma_zcgesv_gpu.
+
+    @param[in]
+    dB      COMPLEX_16 array on the GPU, dimension (LDDB,NRHS)
+            On entry, the right hand side matrix B.
+
+    @param[in]
+    lddb    INTEGER
+            The leading dimension of the array dB.  LDDB >= max(1,N).
+
+    @param[out]
+    dX      COMPLEX_16 array on the GPU, dimension (LDDX,NRHS)
+            On exit, the solution matrix X. dX may be the same as dB.
+
+    @param[in]
+    lddx    INTEGER
+            The leading dimension of the array dX.  LDDX >= max(1,N).
+
+    @param
+    dSX     (workspace) COMPLEX array on the GPU, dimension (N*NRHS)
+            The right hand side and solution in single precision.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+
+    @ingroup magma_zgesv_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zcgetrs_gpu(
+    magma_trans_t trans, magma_int_t n, magma_int_t nrhs,
+    magmaFloatComplex_ptr  dA, size_t dA_offset, magma_int_t ldda,
+    magmaInt_ptr        dipiv, size_t dipiv_offset,
+    magmaDoubleComplex_ptr dB, size_t dB_offset, magma_int_t lddb,
+    magmaDoubleComplex_ptr dX, size_t dX_offset, magma_int_t lddx,
+    magmaFloatComplex_ptr dSX, size_t dSX_offset,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define dA(i,j)     dA, ( (dA_offset) + (i) + (j)*ldda )
+    #define dB(i,j)     dB, ( (dB_offset) + (i) + (j)*lddb )
+    #define dX(i,j)     dX, ( (dX_offset) + (i) + (j)*lddx )
+    #define dSX(i,j)   dSX, ((dSX_offset) + (i) + (j)*lddsx)
+
+    magmaFloatComplex c_one = MAGMA_C_ONE;
+    magma_int_t lddsx = n;
+
+    *info = 0;
+    if ( (trans != MagmaNoTrans) &&
+         (trans != MagmaTrans)   &&
+         (trans != MagmaConjTrans) ) {
+        *info = -1;
+    } else if ( n < 0 ) {
+        *info = -2;
+    } else if ( nrhs < 0 ) {
+        *info = -3;
+    } else if ( ldda < max(1,n) ) {
+        *info = -5;
+    } else if ( lddb < max(1,n) ) {
+        *info = -8;
+    } else if ( lddx < max(1,n) ) {
+        *info = -10;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    /* Quick return if possible */
+    if ( n == 0 || nrhs == 0 )
+        return *info;
+
+    if ( trans == MagmaNoTrans ) {
+        /* Solve A * X = B: dSX = P*dB in single, then L and U solves */
+        magmablas_zclaswp( nrhs, dB(0,0), lddb, dSX(0,0), lddsx,
+                           n, dipiv, dipiv_offset, 1, queue );
+
+        magma_ctrsm( MagmaLeft, MagmaLower, MagmaNoTrans, MagmaUnit,
+                     n, nrhs, c_one, dA(0,0), ldda, dSX(0,0), lddsx, queue );
+        magma_ctrsm( MagmaLeft, MagmaUpper, MagmaNoTrans, MagmaNonUnit,
+                     n, nrhs, c_one, dA(0,0), ldda, dSX(0,0), lddsx, queue );
+
+        magmablas_clag2z( n, nrhs, dSX(0,0), lddsx, dX(0,0), lddx, queue, info );
+    }
+    else {
+        /* Solve A**T * X = B or A**H * X = B: U and L solves in single,
+           then dX = P**T * dSX in double */
+        magmablas_zlag2c( n, nrhs, dB(0,0), lddb, dSX(0,0), lddsx, queue, info );
+
+        magma_ctrsm( MagmaLeft, MagmaUpper, trans, MagmaNonUnit,
+                     n, nrhs, c_one, dA(0,0), ldda, dSX(0,0), lddsx, queue );
+        magma_ctrsm( MagmaLeft, MagmaLower, trans, MagmaUnit,
+                     n, nrhs, c_one, dA(0,0), ldda, dSX(0,0), lddsx, queue );
+
+        magmablas_zclaswp( nrhs, dX(0,0), lddx, dSX(0,0), lddsx,
+                           n, dipiv, dipiv_offset, -1, queue );
+    }
+
+    return *info;
+}
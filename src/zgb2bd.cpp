@@ -0,0 +1,444 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Mark Gates
+
+       @precisions normal z -> s d c
+
+*/
+#include "common_magma.h"
+
+#define PRECISION_z
+
+// General band matrix with room for nb subdiagonals (the bulge) and 2*nb
+// superdiagonals (the band and the fill), so element (i,j) is at
+// Ab + j*ldab + (2*nb + i - j). Then lapack routines can operate on the
+// band as a regular matrix with leading dimension ldab-1.
+#define A(i_, j_)  (Ab + 2*nb + (j_)*(ldab-1) + (i_))
+
+// Householder vectors of one sweep: rows (or columns) sweep+1, ..., n-1 of
+// the sweep are in v[0], ..., v[n-sweep-2]; block k of the sweep has its
+// tau in tau[k]. vq and tauq are the left reflectors, vp and taup the right.
+#define VQ(i_)     (vq   + (i_) - sweep - 1)
+#define VP(i_)     (vp   + (i_) - sweep - 1)
+#define TAUQ(i_)   (tauq + ((i_) - sweep - 1)/nb)
+#define TAUP(i_)   (taup + ((i_) - sweep - 1)/nb)
+
+
+// ----------------------------------------
+// eliminates column st of the block A(st:ed, st:ed) below the diagonal, and
+// applies the reflector from the left to the rest of the block.
+static void
+magma_zgbelimcol(
+    magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *vq, magmaDoubleComplex *tauq,
+    magma_int_t sweep, magma_int_t st, magma_int_t ed,
+    magmaDoubleComplex *work )
+{
+    const magma_int_t ione = 1;
+    magma_int_t ldx = ldab - 1;
+    magma_int_t len = ed - st + 1;
+    magma_int_t len1 = len - 1;
+
+    *VQ(st) = MAGMA_Z_ONE;
+    for( magma_int_t i = 1; i < len; ++i ) {
+        *VQ(st+i)      = *A(st+i, st);
+        *A(st+i, st)   = MAGMA_Z_ZERO;
+    }
+    lapackf77_zlarfg( &len, A(st, st), VQ(st+1), &ione, TAUQ(st) );
+    if ( len1 > 0 ) {
+        magmaDoubleComplex ctau = MAGMA_Z_CNJG( *TAUQ(st) );
+        lapackf77_zlarfx( "L", &len, &len1, VQ(st), &ctau, A(st, st+1), &ldx, work );
+    }
+}
+
+
+// ----------------------------------------
+// eliminates row r of A right of column j1, for columns j1:j2, and returns
+// the reflector in VP(j1) and TAUP(j1). Row r itself is done here; the
+// caller applies the reflector to the other rows.
+static void
+magma_zgbelimrow(
+    magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *vp, magmaDoubleComplex *taup,
+    magma_int_t sweep, magma_int_t r, magma_int_t j1, magma_int_t j2 )
+{
+    const magma_int_t ione = 1;
+    magma_int_t lem = j2 - j1 + 1;
+    magmaDoubleComplex alpha;
+
+    // zlarfg on the conjugate of the row gives r H = beta e1^T
+    *VP(j1) = MAGMA_Z_ONE;
+    alpha = MAGMA_Z_CNJG( *A(r, j1) );
+    for( magma_int_t i = 1; i < lem; ++i ) {
+        *VP(j1+i)     = MAGMA_Z_CNJG( *A(r, j1+i) );
+        *A(r, j1+i)   = MAGMA_Z_ZERO;
+    }
+    lapackf77_zlarfg( &lem, &alpha, VP(j1+1), &ione, TAUP(j1) );
+    *A(r, j1) = alpha;
+}
+
+
+// ----------------------------------------
+// Task 1 of a sweep: eliminates row st-1 right of its superdiagonal,
+// applies the reflector to the diagonal block A(st:ed, st:ed), then
+// eliminates the bulge this created in column st.
+static void
+magma_zgbtype1cb(
+    magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *vq, magmaDoubleComplex *tauq,
+    magmaDoubleComplex *vp, magmaDoubleComplex *taup,
+    magma_int_t sweep, magma_int_t st, magma_int_t ed,
+    magmaDoubleComplex *work )
+{
+    magma_int_t ldx = ldab - 1;
+    magma_int_t len = ed - st + 1;
+
+    // reflectors of length 1 too, so the superdiagonal and diagonal are real
+    magma_zgbelimrow( nb, Ab, ldab, vp, taup, sweep, st-1, st, ed );
+    lapackf77_zlarfx( "R", &len, &len, VP(st), TAUP(st), A(st, st), &ldx, work );
+    magma_zgbelimcol( nb, Ab, ldab, vq, tauq, sweep, st, ed, work );
+}
+
+
+// ----------------------------------------
+// Task 2: applies the left reflector of block st:ed to the columns right
+// of it, then eliminates the fill this created in row st, and applies
+// that right reflector to the rest of the rows of the block.
+static void
+magma_zgbtype2cb(
+    magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *vq, magmaDoubleComplex *tauq,
+    magmaDoubleComplex *vp, magmaDoubleComplex *taup,
+    magma_int_t sweep, magma_int_t st, magma_int_t ed,
+    magmaDoubleComplex *work )
+{
+    magma_int_t ldx = ldab - 1;
+    magma_int_t j1  = ed + 1;
+    magma_int_t j2  = min( ed + nb, n - 1 );
+    magma_int_t len = ed - st + 1;
+    magma_int_t lem = j2 - j1 + 1;
+
+    if ( lem > 0 ) {
+        magmaDoubleComplex ctau = MAGMA_Z_CNJG( *TAUQ(st) );
+        lapackf77_zlarfx( "L", &len, &lem, VQ(st), &ctau, A(st, j1), &ldx, work );
+    }
+    if ( lem > 1 ) {
+        magma_zgbelimrow( nb, Ab, ldab, vp, taup, sweep, st, j1, j2 );
+
+        // row st is done; apply the reflector to rows st+1:ed
+        len -= 1;
+        if ( len > 0 ) {
+            lapackf77_zlarfx( "R", &len, &lem, VP(j1), TAUP(j1), A(st+1, j1), &ldx, work );
+        }
+    }
+}
+
+
+// ----------------------------------------
+// Task 3: applies the right reflector created by task 2 of the previous
+// block to the diagonal block A(st:ed, st:ed), then eliminates the bulge
+// this created in column st.
+static void
+magma_zgbtype3cb(
+    magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *vq, magmaDoubleComplex *tauq,
+    magmaDoubleComplex *vp, magmaDoubleComplex *taup,
+    magma_int_t sweep, magma_int_t st, magma_int_t ed,
+    magmaDoubleComplex *work )
+{
+    magma_int_t ldx = ldab - 1;
+    magma_int_t len = ed - st + 1;
+
+    // a block of one column got no reflector from task 2
+    if ( len > 1 ) {
+        lapackf77_zlarfx( "R", &len, &len, VP(st), TAUP(st), A(st, st), &ldx, work );
+        magma_zgbelimcol( nb, Ab, ldab, vq, tauq, sweep, st, ed, work );
+    }
+}
+
+
+// ----------------------------------------
+// Sweeps are dealt round-robin to threads. Task j of a sweep overlaps tasks
+// up to j+2 of the previous sweep, so it waits for those; progress[s] is
+// the number of tasks of sweep s done.
+struct zgbbulge_data {
+    magma_int_t n, nb;
+    magmaDoubleComplex *Ab;
+    magma_int_t ldab;
+    magmaDoubleComplex *VQ2, *tauq2, *VP2, *taup2;
+    magma_int_t ldtau;
+    magma_int_t wantz;
+    magma_int_t nthread;
+    volatile magma_int_t *progress;
+};
+
+struct zgbbulge_arg {
+    zgbbulge_data *data;
+    magma_int_t tid;
+};
+
+static void*
+magma_zgbbulge_thread( void* arg_ )
+{
+    zgbbulge_arg  *arg  = (zgbbulge_arg*) arg_;
+    zgbbulge_data *data = arg->data;
+
+    magma_int_t n     = data->n;
+    magma_int_t nb    = data->nb;
+    magma_int_t ldab  = data->ldab;
+    magmaDoubleComplex *Ab = data->Ab;
+    volatile magma_int_t *progress = data->progress;
+
+    magmaDoubleComplex *work, *vloc=NULL, *tauloc=NULL;
+    magma_zmalloc_cpu( &work, nb );
+    if ( ! data->wantz ) {
+        magma_zmalloc_cpu( &vloc,   2*n );
+        magma_zmalloc_cpu( &tauloc, 2*data->ldtau );
+    }
+
+    for( magma_int_t sweep = arg->tid; sweep < n-1; sweep += data->nthread ) {
+        magmaDoubleComplex *vq, *tauq, *vp, *taup;
+        if ( data->wantz ) {
+            vq   = data->VQ2   + sweep*(2*n - sweep - 1)/2;
+            vp   = data->VP2   + sweep*(2*n - sweep - 1)/2;
+            tauq = data->tauq2 + sweep*data->ldtau;
+            taup = data->taup2 + sweep*data->ldtau;
+        }
+        else {
+            vq   = vloc;
+            vp   = vloc + n;
+            tauq = tauloc;
+            taup = tauloc + data->ldtau;
+        }
+
+        magma_int_t nblock = magma_ceildiv( n-1-sweep, nb );
+        magma_int_t nprev  = 2*magma_ceildiv( n-sweep, nb );  // tasks of sweep-1
+        for( magma_int_t j = 0; j < 2*nblock; ++j ) {
+            if ( sweep > 0 ) {
+                magma_int_t need = min( j+3, nprev );
+                while( progress[sweep-1] < need ) {
+                    // spin
+                }
+                __sync_synchronize();
+            }
+
+            magma_int_t st = sweep + 1 + (j/2)*nb;
+            magma_int_t ed = min( st + nb - 1, n - 1 );
+            if ( j == 0 ) {
+                magma_zgbtype1cb( nb, Ab, ldab, vq, tauq, vp, taup, sweep, st, ed, work );
+            }
+            else if ( j % 2 == 0 ) {
+                magma_zgbtype3cb( nb, Ab, ldab, vq, tauq, vp, taup, sweep, st, ed, work );
+            }
+            else {
+                magma_zgbtype2cb( n, nb, Ab, ldab, vq, tauq, vp, taup, sweep, st, ed, work );
+            }
+
+            __sync_synchronize();
+            progress[sweep] = j+1;
+        }
+    }
+
+    magma_free_cpu( work );
+    magma_free_cpu( vloc );
+    magma_free_cpu( tauloc );
+    return NULL;
+}
+
+
+/**
+    Purpose
+    -------
+    ZGB2BD reduces a complex upper band matrix B, of bandwidth nb, to real
+    upper bidiagonal form by a unitary transformation, Q2^H B P2 = BD.
+    This is the second stage of the two-stage bidiagonal reduction; see
+    magma_zge2gb for the first stage.
+
+    The reduction is a bulge chase: sweep s eliminates row s right of the
+    superdiagonal, which creates a bulge below the diagonal; eliminating
+    that creates fill right of the band, and so on, nb rows at a time down
+    the band. Each sweep is a sequence of small tasks on the CPU. Several
+    sweeps run concurrently in magma_get_parallel_numthreads() threads,
+    each following the previous sweep two tasks behind it.
+
+    Arguments
+    ---------
+    @param[in]
+    n       INTEGER
+            The order of the matrix B.  N >= 0.
+
+    @param[in]
+    nb      INTEGER
+            The bandwidth of B.  NB >= 1.
+
+    @param[in]
+    A       COMPLEX_16 array, dimension (LDA,N)
+            The band matrix B, in the diagonal and the first nb
+            superdiagonals of A, as left by magma_zge2gb; the diagonal
+            element B(0,0) must be real. A is not modified.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,N).
+
+    @param[out]
+    d       DOUBLE PRECISION array, dimension (N)
+            The diagonal elements of BD.
+
+    @param[out]
+    e       DOUBLE PRECISION array, dimension (N-1)
+            The superdiagonal elements of BD.
+
+    @param[out]
+    VQ2     COMPLEX_16 array, dimension (N*(N-1)/2)
+    @param[out]
+    tauq2   COMPLEX_16 array, dimension (LDTAU,N-1)
+            If wantz, the Householder vectors and scalar factors of Q2,
+            packed by sweep as magma_zhetrd_hb2st packs them, so
+            magma_zbulge_back applies Q2. Not referenced if wantz = 0.
+
+    @param[out]
+    VP2     COMPLEX_16 array, dimension (N*(N-1)/2)
+    @param[out]
+    taup2   COMPLEX_16 array, dimension (LDTAU,N-1)
+            If wantz, the same for P2, of which block k of sweep s
+            covers columns s+1+k*nb, ..., min(s+(k+1)*nb, n-1).
+            Not referenced if wantz = 0.
+
+    @param[in]
+    ldtau   INTEGER
+            The leading dimension of the arrays tauq2 and taup2.
+            LDTAU >= max(1, ceil(N/NB)).
+
+    @param[in]
+    wantz   INTEGER
+            If nonzero, Q2 and P2 are saved for magma_zbulge_back.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+
+    @ingroup magma_zgesvd_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zgb2bd(
+    magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    double *d, double *e,
+    magmaDoubleComplex *VQ2, magmaDoubleComplex *tauq2,
+    magmaDoubleComplex *VP2, magmaDoubleComplex *taup2,
+    magma_int_t ldtau,
+    magma_int_t wantz,
+    magma_int_t *info )
+{
+    *info = 0;
+    if ( n < 0 ) {
+        *info = -1;
+    } else if ( nb < 1 ) {
+        *info = -2;
+    } else if ( lda < max(1,n) ) {
+        *info = -4;
+    } else if ( ldtau < max( 1, magma_ceildiv( n, nb ))) {
+        *info = -11;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( n == 0 )
+        return *info;
+
+    // band copy, with room for the bulge below and the fill right of the band
+    magma_int_t ldab = 3*nb + 1;
+    magmaDoubleComplex *Ab;
+    if (MAGMA_SUCCESS != magma_zmalloc_cpu( &Ab, ldab*n )) {
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+    memset( Ab, 0, ldab*n*sizeof(magmaDoubleComplex) );
+    for( magma_int_t j = 0; j < n; ++j ) {
+        magma_int_t i0 = max( 0, j-nb );
+        memcpy( A(i0,j), &A[ i0 + j*lda ], (j - i0 + 1)*sizeof(magmaDoubleComplex) );
+    }
+
+    if ( wantz ) {
+        memset( VQ2,   0, (n*(n-1)/2)*sizeof(magmaDoubleComplex) );
+        memset( VP2,   0, (n*(n-1)/2)*sizeof(magmaDoubleComplex) );
+        memset( tauq2, 0, ldtau*(n-1)*sizeof(magmaDoubleComplex) );
+        memset( taup2, 0, ldtau*(n-1)*sizeof(magmaDoubleComplex) );
+    }
+
+    magma_int_t nthread = max( 1, min( magma_get_parallel_numthreads(), n-1 ));
+    magma_int_t  *progress;
+    pthread_t    *threads;
+    zgbbulge_arg *args;
+    magma_imalloc_cpu( &progress, max(1,n) );
+    threads = (pthread_t*)    malloc( nthread*sizeof(pthread_t)    );
+    args    = (zgbbulge_arg*) malloc( nthread*sizeof(zgbbulge_arg) );
+    if ( progress == NULL || threads == NULL || args == NULL ) {
+        magma_free_cpu( progress );
+        free( threads );
+        free( args );
+        magma_free_cpu( Ab );
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+    memset( progress, 0, max(1,n)*sizeof(magma_int_t) );
+
+    zgbbulge_data data;
+    data.n        = n;
+    data.nb       = nb;
+    data.Ab       = Ab;
+    data.ldab     = ldab;
+    data.VQ2      = VQ2;
+    data.tauq2    = tauq2;
+    data.VP2      = VP2;
+    data.taup2    = taup2;
+    data.ldtau    = ldtau;
+    data.wantz    = wantz;
+    data.nthread  = nthread;
+    data.progress = progress;
+
+    // the tasks are too small for a multithreaded BLAS
+    magma_int_t nthread_save = magma_get_lapack_numthreads();
+    magma_set_lapack_numthreads( 1 );
+
+    for( magma_int_t t = 1; t < nthread; ++t ) {
+        args[t].data = &data;
+        args[t].tid  = t;
+        pthread_create( &threads[t], NULL, magma_zgbbulge_thread, &args[t] );
+    }
+    args[0].data = &data;
+    args[0].tid  = 0;
+    magma_zgbbulge_thread( &args[0] );
+    for( magma_int_t t = 1; t < nthread; ++t ) {
+        pthread_join( threads[t], NULL );
+    }
+
+    magma_set_lapack_numthreads( nthread_save );
+
+    for( magma_int_t i = 0; i < n-1; ++i ) {
+        d[i] = MAGMA_Z_REAL( *A(i,i)   );
+        e[i] = MAGMA_Z_REAL( *A(i,i+1) );
+    }
+    d[n-1] = MAGMA_Z_REAL( *A(n-1,n-1) );
+
+    magma_free_cpu( progress );
+    free( threads );
+    free( args );
+    magma_free_cpu( Ab );
+    return *info;
+}
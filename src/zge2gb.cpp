@@ -0,0 +1,249 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Mark Gates
+
+       @precisions normal z -> s d c
+
+*/
+#include "common_magma.h"
+
+#define PRECISION_z
+
+/**
+    Purpose
+    -------
+    ZGE2GB reduces a complex M-by-N matrix A, M >= N, to upper band form B,
+    of bandwidth nb, by a unitary transformation: Q1^H A P1 = B. This is
+    the first stage of the two-stage bidiagonal reduction;
+    magma_zgb2bd reduces B to bidiagonal form.
+
+    Unlike magma_zgebrd, all of the work on the trailing matrix is level 3
+    BLAS on the device. For each block of nb columns, the CPU computes the
+    QR factorization of the column panel, the device applies it from the
+    left, the CPU computes the LQ factorization of the nb rows to the right
+    of the diagonal block, and the device applies it from the right.
+    Each update does the part that the CPU factors next first and sends it
+    to the CPU, so the CPU factors it while the device updates the rest.
+
+    Arguments
+    ---------
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrix A.  M >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrix A.  M >= N >= 0.
+
+    @param[in]
+    nb      INTEGER
+            The bandwidth of B.  NB >= 1.
+
+    @param[in,out]
+    A       COMPLEX_16 array, dimension (LDA,N)
+            On entry, the M-by-N matrix A.
+            On exit, the diagonal and the first nb superdiagonals of A are
+            overwritten by the upper band matrix B; the diagonal of B is
+            real. The elements below the diagonal, with the array TAUQ,
+            represent Q1 as a product of elementary reflectors, as zgeqrf
+            would leave them. The elements above the nb-th superdiagonal,
+            with the array TAUP, represent P1 as a product of elementary
+            reflectors: rows 0:n-nb-1 of A(0:n-1, nb:n-1) are as zgelqf
+            would leave the LQ factorization of an (n-nb)-by-(n-nb) matrix,
+            so P1^H is applied by zunmlq with K = N-NB on A(0,nb).
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,M).
+
+    @param[out]
+    tauq    COMPLEX_16 array, dimension (N)
+            The scalar factors of the elementary reflectors of Q1.
+
+    @param[out]
+    taup    COMPLEX_16 array, dimension (N)
+            The scalar factors of the elementary reflectors of P1;
+            taup[i] belongs to row i, for i < n-nb.
+
+    @param
+    work    (workspace) COMPLEX_16 array, dimension (LWORK)
+
+    @param[in]
+    lwork   INTEGER
+            The dimension of the array WORK.  LWORK >= (M + N + 3*NB)*NB.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value.
+                  If the device workspace cannot be allocated, A is not
+                  modified.
+
+    @ingroup magma_zgesvd_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zge2gb(
+    magma_int_t m, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *tauq, magmaDoubleComplex *taup,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define  A(i_, j_) (A + (i_) + (j_)*lda)
+    #define dA(i_, j_)  dA,    (dA_offset + (i_) + (j_)*ldda)
+    #define dV(i_)      dwork, (dV_offset + (i_))
+    #define dVr(j_)     dwork, (dVr_offset + (j_)*nb)
+    #define dW          dwork, dW_offset
+    #define dT          dwork, dT_offset
+    #define dTr         dwork, dTr_offset
+
+    const magmaDoubleComplex c_zero     = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one      = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_neg_one  = MAGMA_Z_NEG_ONE;
+
+    *info = 0;
+    if ( m < 0 ) {
+        *info = -1;
+    } else if ( n < 0 || n > m ) {
+        *info = -2;
+    } else if ( nb < 1 ) {
+        *info = -3;
+    } else if ( lda < max(1,m) ) {
+        *info = -5;
+    } else if ( lwork < (m + n + 3*nb)*nb ) {
+        *info = -9;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( n == 0 )
+        return *info;
+
+    magma_int_t ldda = magma_roundup( m, 32 );
+    magmaDoubleComplex_ptr dA, dwork;
+    size_t dA_offset  = 0;
+    size_t dV_offset  = 0;
+    size_t dVr_offset = dV_offset  + ldda*nb;
+    size_t dW_offset  = dVr_offset + n*nb;
+    size_t dT_offset  = dW_offset  + ldda*nb;
+    size_t dTr_offset = dT_offset  + nb*nb;
+    if (MAGMA_SUCCESS != magma_zmalloc( &dA, ldda*n )) {
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+    if (MAGMA_SUCCESS != magma_zmalloc( &dwork, (2*ldda + n + 2*nb)*nb )) {
+        magma_free( dA );
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+
+    // work: V of the column panel (m*nb), V of the row panel (nb*n),
+    // their T's (2*nb*nb), zgeqrf and zgelqf (nb*nb), with explicit
+    // zeros and ones so they can go to the device as is
+    magmaDoubleComplex *hV  = work;
+    magmaDoubleComplex *hVr = hV  + m*nb;
+    magmaDoubleComplex *hT  = hVr + nb*n;
+    magmaDoubleComplex *hTr = hT  + nb*nb;
+    magmaDoubleComplex *hwork = hTr + nb*nb;
+    magma_int_t ldv = m;
+    magma_int_t lhwork = lwork - (m + n + 2*nb)*nb;
+
+    magma_event_t event = NULL;
+    magma_int_t iinfo;
+
+    magma_zsetmatrix( m, n, A(0,0), lda, dA(0,0), ldda, queue );
+
+    // A(i:m, i:i+nb) is up to date on the CPU at the start of step i
+    for( magma_int_t i = 0; i < n; i += nb ) {
+        magma_int_t ib = min( nb, n-i );  // columns of the panel
+        magma_int_t pm = m - i;           // rows of the panel
+        magma_int_t pn = n - i - ib;      // columns right of the panel
+
+        lapackf77_zgeqrf( &pm, &ib, A(i, i), &lda, &tauq[i], hwork, &lhwork, &iinfo );
+        if ( pn == 0 )
+            break;
+
+        // A(i:m, i+ib:n) = Q^H A = A - V W^H,  with W = A^H V T
+        lapackf77_zlarft( MagmaForwardStr, MagmaColumnwiseStr, &pm, &ib,
+                          A(i, i), &lda, &tauq[i], hT, &ib );
+        lapackf77_zlacpy( MagmaLowerStr, &pm, &ib, A(i, i), &lda, hV, &ldv );
+        lapackf77_zlaset( MagmaUpperStr, &ib, &ib, &c_zero, &c_one, hV, &ldv );
+        magma_zsetmatrix_async( pm, ib, hV, ldv, dV(0), ldda, queue, NULL );
+        magma_zsetmatrix_async( ib, ib, hT, ib,  dT,    ib,   queue, NULL );
+
+        magma_zgemm( MagmaConjTrans, MagmaNoTrans, pn, ib, pm,
+                     c_one,  dA(i, i+ib), ldda,
+                             dV(0),       ldda,
+                     c_zero, dW,          ldda, queue );
+        magma_ztrmm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaNonUnit, pn, ib,
+                     c_one, dT, ib,
+                            dW, ldda, queue );
+
+        // update the row panel and send it to the CPU, then the rows below
+        magma_zgemm( MagmaNoTrans, MagmaConjTrans, ib, pn, ib,
+                     c_neg_one, dV(0),       ldda,
+                                dW,          ldda,
+                     c_one,     dA(i, i+ib), ldda, queue );
+        magma_zgetmatrix_async( ib, pn, dA(i, i+ib), ldda, A(i, i+ib), lda,
+                                queue, &event );
+        magma_zgemm( MagmaNoTrans, MagmaConjTrans, pm-ib, pn, ib,
+                     c_neg_one, dV(ib),         ldda,
+                                dW,             ldda,
+                     c_one,     dA(i+ib, i+ib), ldda, queue );
+        magma_event_sync( event );
+        magma_event_destroy( event );
+
+        // A(i+ib:m, i+ib:n) = A Q^H = A - W Vr,  with W = A Vr^H T
+        magma_int_t mr = m - i - ib;      // rows below the panel
+        magma_int_t pk = min( ib, pn );   // reflectors of the row panel
+        magma_int_t nb2 = min( nb, pn );  // columns of the next panel
+        lapackf77_zgelqf( &ib, &pn, A(i, i+ib), &lda, &taup[i], hwork, &lhwork, &iinfo );
+        lapackf77_zlarft( MagmaForwardStr, MagmaRowwiseStr, &pn, &pk,
+                          A(i, i+ib), &lda, &taup[i], hTr, &pk );
+        lapackf77_zlacpy( MagmaUpperStr, &pk, &pn, A(i, i+ib), &lda, hVr, &nb );
+        lapackf77_zlaset( MagmaLowerStr, &pk, &pk, &c_zero, &c_one, hVr, &nb );
+        magma_zsetmatrix_async( pk, pn, hVr, nb, dVr(0), nb, queue, NULL );
+        magma_zsetmatrix_async( pk, pk, hTr, pk, dTr,    pk, queue, NULL );
+
+        magma_zgemm( MagmaNoTrans, MagmaConjTrans, mr, pk, pn,
+                     c_one,  dA(i+ib, i+ib), ldda,
+                             dVr(0),         nb,
+                     c_zero, dW,             ldda, queue );
+        magma_ztrmm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaNonUnit, mr, pk,
+                     c_one, dTr, pk,
+                            dW,  ldda, queue );
+
+        // update the next column panel and send it to the CPU, then the rest
+        magma_zgemm( MagmaNoTrans, MagmaNoTrans, mr, nb2, pk,
+                     c_neg_one, dW,             ldda,
+                                dVr(0),         nb,
+                     c_one,     dA(i+ib, i+ib), ldda, queue );
+        magma_zgetmatrix_async( mr, nb2, dA(i+ib, i+ib), ldda, A(i+ib, i+ib), lda,
+                                queue, &event );
+        if ( pn > nb2 ) {
+            magma_zgemm( MagmaNoTrans, MagmaNoTrans, mr, pn-nb2, pk,
+                         c_neg_one, dW,                 ldda,
+                                    dVr(nb2),           nb,
+                         c_one,     dA(i+ib, i+ib+nb2), ldda, queue );
+        }
+        magma_event_sync( event );
+        magma_event_destroy( event );
+    }
+
+    magma_free( dA );
+    magma_free( dwork );
+    return *info;
+} /* magma_zge2gb */
@@ -24,14 +24,15 @@
 
 /*
  * TREVC version 1 - LAPACK
- *
- * newer versions not yet in clMAGMA
  * TREVC version 2 - new blocked LAPACK
- * TREVC version 3 - blocked, single-threaded (MAGMA)
- * TREVC version 4 - blocked, multi-threaded  (MAGMA)
  * TREVC version 5 - blocked, multi-threaded, GPU (MAGMA)
+ *
+ * versions 3 and 4 (blocked single- and multi-threaded, CPU only) are
+ * not in clMAGMA.
+ * TREVC_VERSION is the default; environment variable MAGMA_TREVC_VERSION
+ * selects another version at runtime.
  */
-#define TREVC_VERSION 1
+#define TREVC_VERSION 5
 
 /**
     Purpose
@@ -307,13 +308,12 @@ magma_zgeev(
         timer_start( time_hseqr );
         flops_start( flop_hseqr );
         /* Perform QR iteration, accumulating Schur vectors in VL
-         * (CWorkspace: need 1, prefer HSWORK (see comments) )
+         * (CWorkspace: none)
          * (RWorkspace: N)
          *  - including N reserved for gebal/gebak, unused by zhseqr */
         iwrk = itau;
-        liwrk = lwork - iwrk;
-        lapackf77_zhseqr( "S", "V", &n, &ilo, &ihi, A, &lda, w,
-                          VL, &ldvl, &work[iwrk], &liwrk, info );
+        magma_zhseqr( 1, 1, n, ilo, ihi, A, lda, w,
+                      VL, ldvl, queue, info );
         time_sum += timer_stop( time_hseqr );
         flop_sum += flops_stop( flop_hseqr );
 
@@ -348,35 +348,33 @@ magma_zgeev(
         flop_sum += flops_stop( flop_unghr );
 
         /* Perform QR iteration, accumulating Schur vectors in VR
-         * (CWorkspace: need 1, prefer HSWORK (see comments) )
+         * (CWorkspace: none)
          * (RWorkspace: N)
          *  - including N reserved for gebal/gebak, unused by zhseqr */
         timer_start( time_hseqr );
         flops_start( flop_hseqr );
         iwrk = itau;
-        liwrk = lwork - iwrk;
-        lapackf77_zhseqr( "S", "V", &n, &ilo, &ihi, A, &lda, w,
-                          VR, &ldvr, &work[iwrk], &liwrk, info );
+        magma_zhseqr( 1, 1, n, ilo, ihi, A, lda, w,
+                      VR, ldvr, queue, info );
         time_sum += timer_stop( time_hseqr );
         flop_sum += flops_stop( flop_hseqr );
     }
     else {
         /* Compute eigenvalues only
-         * (CWorkspace: need 1, prefer HSWORK (see comments) )
+         * (CWorkspace: none)
          * (RWorkspace: N)
          *  - including N reserved for gebal/gebak, unused by zhseqr */
         timer_start( time_hseqr );
         flops_start( flop_hseqr );
         iwrk = itau;
-        liwrk = lwork - iwrk;
-        lapackf77_zhseqr( "E", "N", &n, &ilo, &ihi, A, &lda, w,
-                          VR, &ldvr, &work[iwrk], &liwrk, info );
+        magma_zhseqr( 0, 0, n, ilo, ihi, A, lda, w,
+                      VR, ldvr, queue, info );
         time_sum += timer_stop( time_hseqr );
         flop_sum += flops_stop( flop_hseqr );
     }
 
-    /* If INFO > 0 from ZHSEQR, then quit */
-    if (*info > 0) {
+    /* If INFO != 0 from ZHSEQR, then quit */
+    if (*info != 0) {
         goto CLEANUP;
     }
 
@@ -384,29 +382,28 @@ magma_zgeev(
     flops_start( flop_trevc );
     if (wantvl || wantvr) {
         /* Compute left and/or right eigenvectors
-         * (CWorkspace: need 2*N)
+         * (CWorkspace: need 2*N, prefer 2*N*64 for version 5)
          * (RWorkspace: need 2*N)
          *  - including N reserved for gebal/gebak, unused by ztrevc */
         irwork = ibal + n;
-        #if TREVC_VERSION == 1
-        lapackf77_ztrevc( lapack_side_const(side), "B", select, &n, A, &lda, VL, &ldvl,
-                          VR, &ldvr, &n, &nout, &work[iwrk], &rwork[irwork], &ierr );
-        #elif TREVC_VERSION == 2
         liwrk = lwork - iwrk;
-        lapackf77_ztrevc3( lapack_side_const(side), "B", select, &n, A, &lda, VL, &ldvl,
-                           VR, &ldvr, &n, &nout, &work[iwrk], &liwrk, &rwork[irwork], &ierr );
-        #elif TREVC_VERSION == 3
-        magma_ztrevc3( side, MagmaBacktransVec, select, n, A, lda, VL, ldvl,
-                       VR, ldvr, n, &nout, &work[iwrk], liwrk, &rwork[irwork], queue, &ierr );
-        #elif TREVC_VERSION == 4
-        magma_ztrevc3_mt( side, MagmaBacktransVec, select, n, A, lda, VL, ldvl,
-                          VR, ldvr, n, &nout, &work[iwrk], liwrk, &rwork[irwork], queue, &ierr );
-        #elif TREVC_VERSION == 5
-        magma_ztrevc3_mt_gpu( side, MagmaBacktransVec, select, n, A, lda, VL, ldvl,
-                              VR, ldvr, n, &nout, &work[iwrk], liwrk, &rwork[irwork], queue, &ierr );
-        #else
-        #error Unknown TREVC_VERSION
-        #endif
+        magma_int_t trevc_version = TREVC_VERSION;
+        const char* trevc_version_char = getenv("MAGMA_TREVC_VERSION");
+        if ( trevc_version_char != NULL )
+            trevc_version = atoi( trevc_version_char );
+        if (trevc_version == 1) {
+            lapackf77_ztrevc( lapack_side_const(side), "B", select, &n, A, &lda, VL, &ldvl,
+                              VR, &ldvr, &n, &nout, &work[iwrk], &rwork[irwork], &ierr );
+        }
+        else if (trevc_version == 2) {
+            lapackf77_ztrevc3( lapack_side_const(side), "B", select, &n, A, &lda, VL, &ldvl,
+                               VR, &ldvr, &n, &nout, &work[iwrk], &liwrk, &rwork[irwork], &ierr );
+        }
+        else {
+            // versions 3 and 4 are not in clMAGMA; use the GPU version
+            magma_ztrevc3_mt_gpu( side, MagmaBacktransVec, select, n, A, lda, VL, ldvl,
+                                  VR, ldvr, n, &nout, &work[iwrk], liwrk, &rwork[irwork], queue, &ierr );
+        }
     }
     time_sum += timer_stop( time_trevc );
     flop_sum += flops_stop( flop_trevc );
@@ -461,7 +458,7 @@ magma_zgeev(
 
 CLEANUP:
     /* Undo scaling if necessary */
-    if (scalea) {
+    if (scalea && *info >= 0) {
         // converged eigenvalues, stored in WR[i+1:n] and WI[i+1:n] for i = INFO
         magma_int_t nval = n - (*info);
         magma_int_t ld   = max( nval, 1 );
@@ -10,6 +10,69 @@
 
 */
 #include "common_magma.h"
+#include "magma_stats.h"
+
+
+// ----------------------------------------
+// Distributes A over ngpu GPUs in 1D block-column cyclic layout, with the
+// block size nb of magma_zgeqrf2_mgpu, factors it with magma_zgeqrf2_mgpu,
+// and gathers the factors back to A.
+// Returns MAGMA_ERR_DEVICE_ALLOC, leaving A unchanged, if A doesn't fit on
+// the GPUs; otherwise returns MAGMA_SUCCESS, with the LAPACK info in info.
+static magma_int_t
+zgeqrf_mgpu_host(
+    magma_int_t ngpu, magma_int_t m, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda, magmaDoubleComplex *tau,
+    magma_int_t *info )
+{
+    magmaDoubleComplex_ptr d_lA[ MagmaMaxGPUs ];
+    magma_queue_t queues2[ 2*MagmaMaxGPUs ];
+    magma_queue_t queues [ MagmaMaxGPUs ];
+    magma_int_t d, n_local, err;
+    magma_int_t ldda = magma_roundup( m, 32 );
+
+    err = magma_queues_create_mgpu( ngpu, queues2 );
+    if ( err != MAGMA_SUCCESS ) {
+        return err;
+    }
+    for( d=0; d < ngpu; d++ ) {
+        queues[d] = queues2[2*d];
+    }
+
+    for( d=0; d < ngpu; d++ ) {
+        n_local = ((n/nb)/ngpu)*nb;
+        if (d < (n/nb) % ngpu)
+            n_local += nb;
+        else if (d == (n/nb) % ngpu)
+            n_local += n % nb;
+        if ( MAGMA_SUCCESS != magma_zmalloc( &d_lA[d], ldda*n_local )) {
+            while( d > 0 ) {
+                magma_free( d_lA[--d] );
+            }
+            magma_queues_destroy_mgpu( ngpu, queues2 );
+            return MAGMA_ERR_DEVICE_ALLOC;
+        }
+    }
+
+    magma_zsetmatrix_1D_col_bcyclic( m, n, A, lda, d_lA, ldda, ngpu, nb, queues );
+    magma_zgeqrf2_mgpu( ngpu, m, n, d_lA, ldda, tau, queues2, info );
+    if ( *info == MAGMA_ERR_DEVICE_ALLOC ) {
+        err = MAGMA_ERR_DEVICE_ALLOC;
+    }
+    else {
+        magma_zgetmatrix_1D_col_bcyclic( m, n, d_lA, ldda, A, lda, ngpu, nb, queues );
+        for( d=0; d < ngpu; d++ ) {
+            magma_queue_sync( queues[d] );
+        }
+    }
+
+    for( d=0; d < ngpu; d++ ) {
+        magma_free( d_lA[d] );
+    }
+    magma_queues_destroy_mgpu( ngpu, queues2 );
+    return err;
+}
+
 
 extern "C" magma_int_t
 magma_zgeqrf(
@@ -34,6 +97,11 @@ magma_zgeqrf(
     If the current stream is NULL, this version replaces it with user defined
     stream to overlap computation with communication.
 
+    If magma_num_gpus() > 1, A is distributed over the GPUs and factored
+    by magma_zgeqrf2_mgpu. If A does not fit in GPU memory, or $MAGMA_NGR_NB
+    limits the number of columns held on the GPU to fewer than N, the
+    out-of-core magma_zgeqrf_ooc is used instead.
+
     Arguments
     =========
     M       (input) INTEGER
@@ -106,6 +174,9 @@ magma_zgeqrf(
 
     magma_int_t i, k, lddwork, old_i, old_ib;
     magma_int_t ib, ldda;
+    double cpu_time;
+
+    MAGMA_STATS_ROUTINE();
 
     *info = 0;
     magma_int_t nb = magma_get_zgeqrf_nb(min(m, n));
@@ -142,18 +213,27 @@ magma_zgeqrf(
 
     magma_int_t num_gpus = magma_num_gpus();
     if( num_gpus > 1 ) {
-        /* call multiple-GPU interface  */
-        printf("multiple-GPU verison not implemented\n");
-        return MAGMA_ERR_NOT_IMPLEMENTED;
-        //return magma_zgeqrf4(num_gpus, m, n, A, lda, tau, work, lwork, info);
+        /* call multiple-GPU interface, with at least one block column per GPU;
+           if A doesn't fit on the GPUs, continue with one GPU */
+        magma_int_t nb_mgpu = magma_get_zgeqrf_nb(m);
+        magma_int_t ngpu = min( num_gpus, magma_ceildiv( n, nb_mgpu ));
+        if ( ngpu > 1 &&
+             zgeqrf_mgpu_host( ngpu, m, n, nb_mgpu, A, lda, tau, info ) == MAGMA_SUCCESS ) {
+            return *info;
+        }
+        *info = 0;
+    }
+
+    /* $MAGMA_NGR_NB limits the number of columns held on the GPU */
+    const char* ngr_nb_char = getenv("MAGMA_NGR_NB");
+    if ( ngr_nb_char != NULL && atoi(ngr_nb_char) < n ) {
+        return magma_zgeqrf_ooc(m, n, A, lda, tau, work, lwork, queues, info);
     }
 
     // allocate space for dA, dwork, and dT
     if (MAGMA_SUCCESS != magma_zmalloc( &dA, n*ldda + nb*lddwork + nb*nb )) {
         /* Switch to the "out-of-core" (out of GPU-memory) version */
-        printf("non-GPU-resident version not implemented\n");
-        return MAGMA_ERR_NOT_IMPLEMENTED;
-        //return magma_zgeqrf_ooc(m, n, A, lda, tau, work, lwork, info);
+        return magma_zgeqrf_ooc(m, n, A, lda, tau, work, lwork, queues, info);
     }
 
     dA_offset = 0;
@@ -195,12 +275,14 @@ magma_zgeqrf(
             }
 
             magma_int_t rows = m-i;
+            cpu_time = magma_wtime();
             lapackf77_zgeqrf(&rows, &ib, A(i,i), &lda, tau+i, work, &lwork, info);
 
             /* Form the triangular factor of the block reflector
                H = H(i) H(i+1) . . . H(i+ib-1) */
             lapackf77_zlarft( MagmaForwardStr, MagmaColumnwiseStr,
                               &rows, &ib, A(i,i), &lda, tau+i, work, &ib);
+            magma_stats_cpu( magma_wtime() - cpu_time );
 
             magma_zpanel_to_q( MagmaUpper, ib, A(i,i), lda, work+ib*ib );
 
@@ -246,7 +328,9 @@ magma_zgeqrf(
            magma_zgetmatrix( m, ib, dA(0,i), ldda, A(0,i), lda, queues[1] );
         }
         magma_int_t rows = m-i;
+        cpu_time = magma_wtime();
         lapackf77_zgeqrf(&rows, &ib, A(i,i), &lda, tau+i, work, &lwork, info);
+        magma_stats_cpu( magma_wtime() - cpu_time );
     }
 
     magma_queue_sync( queues[0] );
@@ -10,9 +10,9 @@
 
 */
 #include "common_magma.h"
+#include "magma_stats.h"
 
 // using 2 queues, 1 for comm, 1 for comp.
-extern cl_context     gContext;
 
 
 extern "C" magma_int_t
@@ -90,6 +90,9 @@ magma_zgeqrf2_gpu(
     magma_int_t i, k, ldwork, lddwork, old_i, old_ib, rows;
     magma_int_t nbmin, nx, ib, nb;
     magma_int_t lhwork, lwork;
+    double cpu_time;
+
+    MAGMA_STATS_ROUTINE();
 
     *info = 0;
     if (m < 0) {
@@ -118,20 +121,11 @@ magma_zgeqrf2_gpu(
         return *info;
     }
 
-    /*    
-    if ( MAGMA_SUCCESS != magma_zmalloc_cpu( &work, lwork ) ) {
+    if ( MAGMA_SUCCESS != magma_zmalloc_pinned( &work, lwork ) ) {
         *info = MAGMA_ERR_HOST_ALLOC;
         magma_free( dwork );
         return *info;
     }
-    */
-
-    cl_mem buffer = clCreateBuffer(gContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, 
-                                   sizeof(magmaDoubleComplex)*lwork, NULL, NULL);
-    work = (magmaDoubleComplex*)clEnqueueMapBuffer(queues[0], buffer, CL_TRUE, 
-                                                   CL_MAP_READ | CL_MAP_WRITE, 
-                                                   0, lwork*sizeof(magmaDoubleComplex), 
-                                                   0, NULL, NULL, NULL);
 
     nbmin = 2;
     nx    = nb;
@@ -160,6 +154,7 @@ magma_zgeqrf2_gpu(
             }
 
             magma_queue_sync( queues[0] );
+            cpu_time = magma_wtime();
             lapackf77_zgeqrf(&rows, &ib, work(i), &ldwork, tau+i, hwork, &lhwork, info);
    
             /* Form the triangular factor of the block reflector
@@ -167,6 +162,7 @@ magma_zgeqrf2_gpu(
             lapackf77_zlarft( MagmaForwardStr, MagmaColumnwiseStr,
                               &rows, &ib,
                               work(i), &ldwork, tau+i, hwork, &ib);
+            magma_stats_cpu( magma_wtime() - cpu_time );
 
             magma_zpanel_to_q( MagmaUpper, ib, work(i), ldwork, hwork+ib*ib );
 
@@ -213,7 +209,9 @@ magma_zgeqrf2_gpu(
         magma_queue_sync( queues[1] );
         
         lhwork = lwork - rows*ib;
+        cpu_time = magma_wtime();
         lapackf77_zgeqrf(&rows, &ib, work, &rows, tau+i, work+ib*rows, &lhwork, info);
+        magma_stats_cpu( magma_wtime() - cpu_time );
         
         magma_zsetmatrix_async(rows, ib, work, rows, dA(i, i), ldda, queues[1], NULL);
     }
@@ -221,9 +219,7 @@ magma_zgeqrf2_gpu(
     magma_queue_sync( queues[0] );
     magma_queue_sync( queues[1] );
 
-    // magma_free_cpu(work);
-    clEnqueueUnmapMemObject(queues[0], buffer, work, 0, NULL, NULL);
-    clReleaseMemObject(buffer);
+    magma_free_pinned( work );
 
     return *info;
 } /* magma_zgeqrf2_gpu */
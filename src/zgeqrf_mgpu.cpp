@@ -83,15 +83,20 @@ magma_zgeqrf2_mgpu(
 #define hwrk_ref(a_1)    ( local_work + (a_1))
 #define lhwrk            ( local_work + (nb)*(m))
 
-    magmaDoubleComplex_ptr dwork[4], panel[4];
-    size_t panel_offset[4];
+    magmaDoubleComplex_ptr dwork[MagmaMaxGPUs], panel[MagmaMaxGPUs];
+    size_t panel_offset[MagmaMaxGPUs];
     magmaDoubleComplex *local_work;
 
     magma_int_t i, j, k, ldwork, lddwork, old_i, old_ib, rows;
     magma_int_t nbmin, nx, ib, nb;
     magma_int_t lhwork, lwork;
 
-    int panel_gpunum=0, i_local, n_local[4], la_gpu, displacement; 
+    int panel_gpunum=0, i_local, n_local[MagmaMaxGPUs], la_gpu, displacement; 
+
+    /* events ordering each gpu's compute queue, queues[2*j],
+       and transfer queue, queues[2*j+1] */
+    magma_event_t compute_event[MagmaMaxGPUs];   /* look-ahead done on compute queue */
+    magma_event_t transfer_event[MagmaMaxGPUs];  /* panel and T arrived on transfer queue */
 
     *info = 0;
     if (m < 0) {
@@ -142,6 +147,11 @@ magma_zgeqrf2_mgpu(
         return *info;
     }
 
+    for(j=0; j<num_gpus; j++){
+        magma_event_create( &compute_event[j]  );
+        magma_event_create( &transfer_event[j] );
+    }
+
     nbmin = 2;
     nx    = nb;
     ldwork = m;
@@ -160,8 +170,9 @@ magma_zgeqrf2_mgpu(
 
             ib = min(k-i, nb);
             rows = m -i;
-            /* Send current panel to the CPU */
-            magma_queue_sync(queues[panel_gpunum*2]);
+            /* Send current panel to the CPU, after its look-ahead update */
+            magma_event_record( compute_event[panel_gpunum], queues[panel_gpunum*2] );
+            magma_queue_wait_event( queues[panel_gpunum*2+1], compute_event[panel_gpunum] );
             magma_zgetmatrix_async( rows, ib,
                     dlA(panel_gpunum, i, i_local), ldda,
                     hwrk_ref(i), ldwork, queues[panel_gpunum*2+1], NULL );
@@ -209,7 +220,9 @@ magma_zgeqrf2_mgpu(
                     panel[j] = dwork[j];
                     panel_offset[j] = displacement;
                 }
-                magma_queue_sync( queues[j*2] );
+                /* previous update done with panel and dwork? */
+                magma_event_record( compute_event[j], queues[j*2] );
+                magma_queue_wait_event( queues[j*2+1], compute_event[j] );
                 magma_zsetmatrix_async( rows, ib,
                         hwrk_ref(i), ldwork,
                         panel[j], panel_offset[j], ldda, queues[j*2+1], NULL );
@@ -220,9 +233,11 @@ magma_zgeqrf2_mgpu(
                                         dwork[j], 0, lddwork, queues[2*j+1], NULL );
             }
 
+            /* panel and T arrived before the update */
             for(j=0; j<num_gpus; j++)
             {
-                magma_queue_sync( queues[j*2+1] );
+                magma_event_record( transfer_event[j], queues[j*2+1] );
+                magma_queue_wait_event( queues[j*2], transfer_event[j] );
             }
 
             if (i + ib < n) 
@@ -260,7 +275,10 @@ magma_zgeqrf2_mgpu(
                                     queues[j*2]);
                     }
 
-                    /* Restore the panel */
+                    /* Restore the panel, once it has been sent */
+                    for(j=0; j<num_gpus; j++){
+                        magma_event_sync( transfer_event[j] );
+                    }
                     magma_zq_to_panel( MagmaUpper, ib, hwrk_ref(i), ldwork, lhwrk+ib*ib );
                 }
                 else {
@@ -276,7 +294,10 @@ magma_zgeqrf2_mgpu(
                             dwork[la_gpu], ib, lddwork,
                             queues[la_gpu*2]);
  
-                    /* Restore the panel */
+                    /* Restore the panel, once it has been sent */
+                    for(j=0; j<num_gpus; j++){
+                        magma_event_sync( transfer_event[j] );
+                    }
                     magma_zq_to_panel( MagmaUpper, ib, hwrk_ref(i), ldwork, lhwrk+ib*ib ); 
                     
                     //magma_setdevice(panel_gpunum);                    
@@ -295,6 +316,8 @@ magma_zgeqrf2_mgpu(
 
     for(j=0; j<num_gpus; j++){
         magma_free( dwork[j] );
+        magma_event_destroy( compute_event[j]  );
+        magma_event_destroy( transfer_event[j] );
     }
 
     /* Use unblocked code to factor the last or only block. */
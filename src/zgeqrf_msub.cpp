@@ -10,11 +10,6 @@
  */
 #include "common_magma.h"
 
-#define USE_PINNED_CLMEMORY
-#ifdef  USE_PINNED_CLMEMORY
-extern cl_context gContext;
-#endif
-
 extern "C" magma_int_t
 magma_zgeqrf_msub(
     magma_int_t num_subs, magma_int_t num_gpus, 
@@ -100,6 +95,11 @@ magma_zgeqrf_msub(
     int panel_id = -1, i_local, n_local[MagmaMaxGPUs * MagmaMaxSubs], la_id, displacement,
         tot_subs = num_gpus * num_subs; 
 
+    /* events ordering each gpu's compute queue, queues[2*j],
+       and transfer queue, queues[2*j+1] */
+    magma_event_t compute_event[MagmaMaxGPUs];   /* look-ahead done on compute queue */
+    magma_event_t transfer_event[MagmaMaxGPUs];  /* panel and T arrived on transfer queue */
+
     *info = 0;
     if (m < 0) {
         *info = -1;
@@ -138,14 +138,7 @@ magma_zgeqrf_msub(
         else if (i == (n/nb)%tot_subs)
             n_local[i] += n%nb;
     }
-    #ifdef USE_PINNED_CLMEMORY
-    cl_mem buffer = clCreateBuffer(gContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sizeof(magmaDoubleComplex)*lwork, NULL, NULL);
-    for (j=0; j<num_gpus; j++) {
-        local_work = (magmaDoubleComplex*)clEnqueueMapBuffer(queues[2*j], buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0,
-                                                       sizeof(magmaDoubleComplex)*lwork, 0, NULL, NULL, NULL);
-    }
-    #else
-    if (MAGMA_SUCCESS != magma_zmalloc_cpu( (&local_work), lwork )) {
+    if (MAGMA_SUCCESS != magma_zmalloc_pinned( (&local_work), lwork )) {
         *info = -9;
         for (i=0; i<num_gpus; i++) {
             magma_free( dwork[i] );
@@ -153,7 +146,11 @@ magma_zgeqrf_msub(
         *info = MAGMA_ERR_HOST_ALLOC;
         return *info;
     }
-    #endif
+
+    for (j=0; j<num_gpus; j++) {
+        magma_event_create( &compute_event[j]  );
+        magma_event_create( &transfer_event[j] );
+    }
 
     nbmin = 2;
     nx    = nb;
@@ -172,8 +169,9 @@ magma_zgeqrf_msub(
 
             ib = min(k-i, nb);
             rows = m -i;
-            /* Send current panel to the CPU */
-            magma_queue_sync(queues[2*(panel_id%num_gpus)]);
+            /* Send current panel to the CPU, after its look-ahead update */
+            magma_event_record( compute_event[panel_id%num_gpus], queues[2*(panel_id%num_gpus)] );
+            magma_queue_wait_event( queues[2*(panel_id%num_gpus)+1], compute_event[panel_id%num_gpus] );
             magma_zgetmatrix_async( rows, ib,
                                     dlA(panel_id, i, i_local), ldda,
                                     hwrk(i), ldwork, 
@@ -222,7 +220,9 @@ magma_zgeqrf_msub(
                     panel[j] = dwork[j];
                     panel_offset[j] = displacement;
                 }
-                magma_queue_sync( queues[2*j] );
+                /* previous update done with panel and dwork? */
+                magma_event_record( compute_event[j], queues[2*j] );
+                magma_queue_wait_event( queues[2*j+1], compute_event[j] );
                 magma_zsetmatrix_async( rows, ib,
                                         hwrk(i), ldwork,
                                         panel[j], panel_offset[j], ldda, 
@@ -235,8 +235,10 @@ magma_zgeqrf_msub(
                                         queues[2*j+1], NULL );
             }
 
+            /* panel and T arrived before the update */
             for(j=0; j<num_gpus; j++) {
-                magma_queue_sync( queues[2*j+1] );
+                magma_event_record( transfer_event[j], queues[2*j+1] );
+                magma_queue_wait_event( queues[2*j], transfer_event[j] );
             }
 
             if (i + ib < n) {
@@ -272,7 +274,10 @@ magma_zgeqrf_msub(
                                               queues[2*(j%num_gpus)]);
                     }
 
-                    /* Restore the panel */
+                    /* Restore the panel, once it has been sent */
+                    for(j=0; j<num_gpus; j++) {
+                        magma_event_sync( transfer_event[j] );
+                    }
                     magma_zq_to_panel( MagmaUpper, ib, hwrk(i), ldwork, lhwrk+ib*ib );
                 } else {
                     /* do the entire update as we exit and there would be no lookahead */
@@ -287,7 +292,10 @@ magma_zgeqrf_msub(
                                       dwork[la_id%num_gpus], ib, lddwork,
                                       queues[2*(la_id%num_gpus)]);
  
-                    /* Restore the panel */
+                    /* Restore the panel, once it has been sent */
+                    for(j=0; j<num_gpus; j++) {
+                        magma_event_sync( transfer_event[j] );
+                    }
                     magma_zq_to_panel( MagmaUpper, ib, hwrk(i), ldwork, lhwrk+ib*ib ); 
                     
                     magma_zsetmatrix( ib, ib,
@@ -305,6 +313,8 @@ magma_zgeqrf_msub(
 
     for (j=0; j<num_gpus; j++) {
         magma_free( dwork[j] );
+        magma_event_destroy( compute_event[j]  );
+        magma_event_destroy( transfer_event[j] );
     }
 
     /* Use unblocked code to factor the last or only block. */
@@ -329,10 +339,7 @@ magma_zgeqrf_msub(
                           dlA(panel_id, i, i_loc), ldda, 
                           queues[2*(panel_id%num_gpus)]);
     }
-    #ifdef USE_PINNED_CLMEMORY
-    #else
-    magma_free_cpu( local_work );
-    #endif
+    magma_free_pinned( local_work );
 
     return *info;
 } /* magma_zgeqrf_msub */
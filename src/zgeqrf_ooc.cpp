@@ -0,0 +1,263 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "common_magma.h"
+
+
+extern "C" magma_int_t
+magma_zgeqrf_ooc(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex *A,    magma_int_t lda, magmaDoubleComplex *tau,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    magma_queue_t queues[2],
+    magma_int_t *info )
+{
+/*  -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+    Purpose
+    =======
+    ZGEQRF_OOC computes a QR factorization of a COMPLEX_16 M-by-N matrix A:
+    A = Q * R, for matrices that do not fit in GPU memory
+    (out-of-core, or non-GPU-resident). The matrix stays in CPU memory and
+    the problem size is bounded by host memory only.
+
+    This is a left-looking algorithm over big block columns of width NB,
+    which is sized to fit the GPU memory reported by magma_queue_meminfo
+    and may be reduced by setting $MAGMA_NGR_NB. Each big block column is
+    sent to a GPU window, where the block reflectors of the columns on its
+    left are applied with magma_zlarfb_gpu. Their V and T are streamed
+    through two GPU buffers in blocks of nb columns, so the transfer of one
+    block on queues[1] overlaps the update with the previous block on
+    queues[0]. The window is then factored by magma_zgeqrf2_gpu and copied
+    back, and the triangular factors T of its block reflectors are formed
+    on the CPU and kept in WORK for the following big block columns.
+
+    magma_zgeqrf calls this routine when A does not fit in GPU memory.
+
+    Arguments
+    =========
+    M       (input) INTEGER
+            The number of rows of the matrix A.  M >= 0.
+
+    N       (input) INTEGER
+            The number of columns of the matrix A.  N >= 0.
+
+    A       (input/output) COMPLEX_16 array, dimension (LDA,N)
+            On entry, the M-by-N matrix A.
+            On exit, the elements on and above the diagonal of the array
+            contain the min(M,N)-by-N upper trapezoidal matrix R (R is
+            upper triangular if m >= n); the elements below the diagonal,
+            with the array TAU, represent the orthogonal matrix Q as a
+            product of min(m,n) elementary reflectors (see Further
+            Details).
+
+            Higher performance is achieved if A is in pinned memory, e.g.
+            allocated using magma_malloc_pinned.
+
+    LDA     (input) INTEGER
+            The leading dimension of the array A.  LDA >= max(1,M).
+
+    TAU     (output) COMPLEX_16 array, dimension (min(M,N))
+            The scalar factors of the elementary reflectors (see Further
+            Details).
+
+    WORK    (workspace/output) COMPLEX_16 array, dimension (MAX(1,LWORK))
+            On exit, if INFO = 0, WORK(1) returns the optimal LWORK.
+
+    LWORK   (input) INTEGER
+            The dimension of the array WORK.  LWORK >= N*NB,
+            where NB can be obtained through magma_get_zgeqrf_nb(min(M,N)).
+            If LWORK = -1, then a workspace query is assumed; the routine
+            only calculates the optimal size of the WORK array, returns
+            this value as the first entry of the WORK array, and no error
+            message related to LWORK is issued.
+
+    QUEUES  (input) magma_queue_t array, dimension (2)
+            Queues on the same device. queues[0] executes the updates and
+            factorization; queues[1] streams the block reflectors.
+
+    INFO    (output) INTEGER
+            = 0:  successful exit
+            < 0:  if INFO = -i, the i-th argument had an illegal value
+                  or another error occured, such as memory allocation failed.
+
+    Further Details
+    ===============
+    The matrix Q is represented as a product of elementary reflectors
+
+       Q = H(1) H(2) . . . H(k), where k = min(m,n).
+
+    Each H(i) has the form
+
+       H(i) = I - tau * v * v'
+
+    where tau is a complex scalar, and v is a complex vector with
+    v(1:i-1) = 0 and v(i) = 1; v(i+1:m) is stored on exit in A(i+1:m,i),
+    and tau in TAU(i).
+    =====================================================================    */
+
+    #define  A(i_, j_) (A + (i_) + (j_)*lda)
+    #define  T(j_)     (work + (j_)*nb)
+    #define dW(i_, j_)  dW, (i_) + (j_)*ldda
+    #define dV(b_)      dV[(b_)], 0
+    #define dT(b_)      dT, (b_)*nb*nb
+
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+
+    magmaDoubleComplex_ptr dW, dT, dwork, dV[2] = { NULL, NULL };
+    magma_event_t load_event[2], done_event[2];
+    magma_int_t nb, NB, k, ldda, lddwork, lwkopt, rows, iinfo;
+    magma_int_t j, jb, jk, c, cb, b;
+
+    magma_queue_t compute_queue  = queues[0];
+    magma_queue_t transfer_queue = queues[1];
+
+    *info = 0;
+    nb = magma_get_zgeqrf_nb(min(m, n));
+    lwkopt = n*nb;
+    work[0] = MAGMA_Z_MAKE( (double)lwkopt, 0 );
+    int lquery = (lwork == -1);
+    if (m < 0) {
+        *info = -1;
+    } else if (n < 0) {
+        *info = -2;
+    } else if (lda < max(1,m)) {
+        *info = -4;
+    } else if (lwork < max(1, lwkopt) && ! lquery) {
+        *info = -7;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+    else if (lquery)
+        return *info;
+
+    k = min(m,n);
+    if (k == 0) {
+        work[0] = c_one;
+        return *info;
+    }
+
+    ldda = magma_roundup( m, 32 );
+
+    /* Size the window from the device memory, which magma_queue_meminfo
+       returns in units of 16 bytes. Besides the window, the GPU holds the
+       two V buffers and the larfb workspace. */
+    double totalMem = 16. * magma_queue_meminfo( compute_queue ) / sizeof(magmaDoubleComplex);
+    NB = (magma_int_t)(0.8*totalMem/ldda - 3*nb);
+    const char* ngr_nb_char = getenv("MAGMA_NGR_NB");
+    if ( ngr_nb_char != NULL )
+        NB = min( NB, atoi(ngr_nb_char) );
+    NB = max( nb, (NB / nb) * nb );
+    NB = min( NB, magma_roundup( n, nb ));
+
+    /* the window may exceed the largest single allocation; halve it until it fits */
+    while( MAGMA_SUCCESS != magma_zmalloc( &dW, ldda*NB )) {
+        if ( NB == nb ) {
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+        NB = max( nb, (NB / (2*nb)) * nb );
+    }
+    lddwork = magma_roundup( NB, 32 );
+    if ( MAGMA_SUCCESS != magma_zmalloc( &dwork, lddwork*nb + 2*nb*nb )) {
+        magma_free( dW );
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+    dT = dwork;
+    if ( MAGMA_SUCCESS != magma_zmalloc( &dV[0], ldda*nb )
+      || MAGMA_SUCCESS != magma_zmalloc( &dV[1], ldda*nb )) {
+        if ( dV[0] != NULL )
+            magma_free( dV[0] );
+        magma_free( dwork );
+        magma_free( dW );
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+
+    magma_event_create( &load_event[0] );
+    magma_event_create( &load_event[1] );
+    magma_event_create( &done_event[0] );
+    magma_event_create( &done_event[1] );
+
+    for( j = 0; j < n; j += NB ) {
+        jb = min( NB, n-j );
+        jk = min( j, k );       // reflectors computed so far
+
+        magma_zsetmatrix( m, jb, A(0,j), lda, dW(0,0), ldda, compute_queue );
+
+        /* left-looking update: apply H(1:jk)' to the window, in blocks of nb,
+           double buffered: block b+1 is sent while block b is applied */
+        for( c = 0, b = 0; c < jk; c += nb, ++b ) {
+            cb   = min( nb, jk-c );
+            rows = m - c;
+            if ( b >= 2 ) {
+                // buffers are free once the update two blocks ago is done
+                magma_queue_wait_event( transfer_queue, done_event[b%2] );
+            }
+            magma_zsetmatrix_async( rows, cb, A(c,c), lda, dV(b%2), ldda,
+                                    transfer_queue, NULL );
+            magma_zsetmatrix_async( cb, cb, T(c), nb, dT(b%2), nb,
+                                    transfer_queue, NULL );
+            magma_event_record( load_event[b%2], transfer_queue );
+
+            magma_queue_wait_event( compute_queue, load_event[b%2] );
+            // V has unit diagonal and zeros above; R is stored there on the host
+            magmablas_zlaset( MagmaUpper, cb, cb, c_zero, c_one, dV(b%2), ldda,
+                              compute_queue );
+            magma_zlarfb_gpu( MagmaLeft, MagmaConjTrans, MagmaForward, MagmaColumnwise,
+                              rows, jb, cb,
+                              dV(b%2),  ldda,
+                              dT(b%2),  nb,
+                              dW(c,0),  ldda,
+                              dwork, 2*nb*nb, lddwork, compute_queue );
+            magma_event_record( done_event[b%2], compute_queue );
+        }
+
+        /* factor the part of the window below the diagonal */
+        if ( j < k ) {
+            rows = m - j;
+            magma_zgeqrf2_gpu( rows, jb, dW(j,0), ldda, tau+j, queues, &iinfo );
+            if ( iinfo != 0 ) {
+                *info = iinfo;
+                break;
+            }
+        }
+        magma_zgetmatrix( m, jb, dW(0,0), ldda, A(0,j), lda, compute_queue );
+
+        /* form T of the window's block reflectors, for later windows */
+        for( c = j; c < min( j+jb, k ); c += nb ) {
+            cb   = min( nb, k-c );
+            rows = m - c;
+            lapackf77_zlarft( MagmaForwardStr, MagmaColumnwiseStr,
+                              &rows, &cb, A(c,c), &lda, tau+c, T(c), &nb );
+        }
+    }
+    magma_queue_sync( transfer_queue );
+
+    magma_event_destroy( load_event[0] );
+    magma_event_destroy( load_event[1] );
+    magma_event_destroy( done_event[0] );
+    magma_event_destroy( done_event[1] );
+
+    magma_free( dV[0] );
+    magma_free( dV[1] );
+    magma_free( dwork );
+    magma_free( dW );
+
+    work[0] = MAGMA_Z_MAKE( (double)lwkopt, 0 );
+    return *info;
+} /* magma_zgeqrf_ooc */
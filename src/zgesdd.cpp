@@ -18,6 +18,11 @@
 // Version 2 - MAGMA
 #define VERSION 2
 
+// Matrices with min(m,n) >= SVD_2STAGE_NMIN are reduced to bidiagonal form
+// in two stages, by magma_zgesvd_2stage. The environment variable
+// MAGMA_SVD_2STAGE_NMIN overrides it; 0 disables the two-stage reduction.
+#define SVD_2STAGE_NMIN 2000
+
 /**
     Purpose
     -------
@@ -36,6 +41,9 @@
 
     Note that the routine returns VT = V**H, not V.
 
+    Large matrices are reduced to bidiagonal form in two stages, band form
+    and then bidiagonal, by magma_zgesvd_2stage; see SVD_2STAGE_NMIN.
+
     The divide and conquer algorithm makes very mild assumptions about
     floating point arithmetic. It will work on machines with a guard
     digit in add/subtract, or on those binary machines without guard
@@ -144,6 +152,12 @@
                 if x >> y, LWORK >= y*y + 2*y + max( (2*y)*nb, x    ),
                    prefer  LWORK >= y*y + 2*y + max( (2*y)*nb, x*nb );
                 otherwise, LWORK >=       2*y +      (x+y)*nb.
+      \n
+            If min(M,N) >= SVD_2STAGE_NMIN, A is reduced in two stages by
+            magma_zgesvd_2stage only if LWORK is at least its workspace,
+            about 2*y + (x+y+3*nb)*nb, plus y*y + 2*y*(y/nb+1) if vectors
+            are wanted; otherwise the one-stage reduction is used.
+            The workspace query returns the larger of the two sizes.
       \n
             If lwork = -1, a workspace query is assumed.  The optimal
             size for the WORK array is calculated and stored in WORK[0],
@@ -448,7 +462,34 @@ magma_zgesdd(
         }
         maxwrk = max(maxwrk, minwrk);
     }
+
+    /* Reduce large matrices to bidiagonal form in two stages,
+       if LWORK is large enough for it */
+    magma_int_t nmin_2stage = SVD_2STAGE_NMIN;
+    const char* nmin_2stage_char = getenv("MAGMA_SVD_2STAGE_NMIN");
+    if ( nmin_2stage_char != NULL ) {
+        nmin_2stage = atoi( nmin_2stage_char );
+    }
+    const magma_int_t use_2stage = (nmin_2stage > 0 && minmn >= nmin_2stage);
+    magma_int_t lwork_2stage = 0;
+
+    /* jobz = O overwrites A with whichever of U and VT is smaller */
+    magma_vec_t jobu  = jobz;
+    magma_vec_t jobvt = jobz;
+    if (wantqo && m >= n) {
+        jobvt = MagmaSomeVec;
+    }
+    else if (wantqo) {
+        jobu = MagmaSomeVec;
+    }
+
     if (*info == 0) {
+        if (use_2stage) {
+            magma_zgesvd_2stage( jobu, jobvt, m, n, A(1,1), lda, s, U, ldu, VT, ldvt,
+                                 1, &work[1], -1, &rwork[1], iwork, queue, &ierr );
+            lwork_2stage = (magma_int_t) MAGMA_Z_REAL( work[1] );
+            maxwrk = max( maxwrk, lwork_2stage );
+        }
         work[1] = MAGMA_Z_MAKE( maxwrk, 0 );
         if (lwork < minwrk && ! lquery) {
             *info = -13;
@@ -468,6 +509,13 @@ magma_zgesdd(
         return *info;
     }
 
+    /* Otherwise, fall back to the one-stage reduction below */
+    if (use_2stage && lwork >= lwork_2stage) {
+        magma_zgesvd_2stage( jobu, jobvt, m, n, A(1,1), lda, s, U, ldu, VT, ldvt,
+                             1, &work[1], lwork, &rwork[1], iwork, queue, info );
+        return *info;
+    }
+
     /* Get machine constants */
     eps = lapackf77_dlamch("P");
     smlnum = sqrt(lapackf77_dlamch("S")) / eps;
@@ -15,6 +15,11 @@
 #define PRECISION_z
 #define COMPLEX
 
+// Matrices with min(m,n) >= SVD_2STAGE_NMIN are reduced to bidiagonal form
+// in two stages, by magma_zgesvd_2stage. The environment variable
+// MAGMA_SVD_2STAGE_NMIN overrides it; 0 disables the two-stage reduction.
+#define SVD_2STAGE_NMIN 2000
+
 /**
     Purpose
     -------
@@ -33,6 +38,9 @@
 
     Note that the routine returns V**H, not V.
 
+    Large matrices are reduced to bidiagonal form in two stages, band form
+    and then bidiagonal, by magma_zgesvd_2stage; see SVD_2STAGE_NMIN.
+
     Arguments
     ---------
     @param[in]
@@ -124,6 +132,13 @@
             For optimum performance with some paths
             (m >> n and jobu=A,S,O; or n >> m and jobvt=A,S,O),
             LWORK >= (M+N)*nb + 2*min(M,N) + 2*min(M,N)**2 (see comments inside code).
+      \n
+            If min(M,N) >= SVD_2STAGE_NMIN, A is reduced in two stages by
+            magma_zgesvd_2stage only if LWORK is at least its workspace,
+            about 2*y + (M+N+3*nb)*nb, plus y*y + 2*y*(y/nb+1) if vectors
+            are wanted, where y = min(M,N); otherwise the one-stage
+            reduction is used.
+            The workspace query returns the larger of the two sizes.
     \n
             If LWORK = -1, then a workspace query is assumed; the routine
             only calculates the required size of the WORK array, returns
@@ -231,6 +246,15 @@ magma_zgesvd(
         *info = -11;
     }
     
+    // Reduce large matrices to bidiagonal form in two stages,
+    // if LWORK is large enough for it
+    magma_int_t nmin_2stage = SVD_2STAGE_NMIN;
+    const char* nmin_2stage_char = getenv("MAGMA_SVD_2STAGE_NMIN");
+    if ( nmin_2stage_char != NULL )
+        nmin_2stage = atoi( nmin_2stage_char );
+    bool use_2stage = (nmin_2stage > 0 && minmn >= nmin_2stage);
+    magma_int_t lwork_2stage = 0;
+    
     // Compute workspace
     lapackf77_zgesvd(jobu_, jobvt_, &m, &n, A, &lda, s, U, &ldu, VT, &ldvt,
                      work, &ineg_one, rwork, info);
@@ -239,11 +263,16 @@ magma_zgesvd(
         // Return required workspace in WORK[0]
         nb = magma_get_zgesvd_nb(n);
         minwrk = (m + n)*nb + 2*minmn;
+        if ( use_2stage ) {
+            magma_zgesvd_2stage( jobu, jobvt, m, n, A, lda, s, U, ldu, VT, ldvt,
+                                 0, work, -1, rwork, NULL, queue, &ierr );
+            lwork_2stage = (magma_int_t) MAGMA_Z_REAL( work[0] );
+        }
         
         // multiply by 1+eps (in Double!) to ensure length gets rounded up,
         // if it cannot be exactly represented in floating point.
         real_Double_t one_eps = 1. + lapackf77_dlamch("Epsilon");
-        work[0] = MAGMA_Z_MAKE( minwrk * one_eps, 0 );
+        work[0] = MAGMA_Z_MAKE( max( minwrk, lwork_2stage ) * one_eps, 0 );
         if ( !lquery && (lwork < minwrk) ) {
             *info = -13;
         }
@@ -262,6 +291,13 @@ magma_zgesvd(
         return *info;
     }
     
+    // Otherwise, fall back to the one-stage reduction below
+    if ( use_2stage && lwork >= lwork_2stage ) {
+        magma_zgesvd_2stage( jobu, jobvt, m, n, A, lda, s, U, ldu, VT, ldvt,
+                             0, work, lwork, rwork, NULL, queue, info );
+        return *info;
+    }
+    
     wrkbl  = maxwrk; // Not optimal
     wrkbrd = (m + n)*nb + 2*minmn;
     
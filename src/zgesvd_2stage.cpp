@@ -0,0 +1,467 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Mark Gates
+
+       @precisions normal z -> c
+
+*/
+#include "common_magma.h"
+#include "magma_timer.h"
+
+#define PRECISION_z
+#define COMPLEX
+
+// B = A^H, for the m-by-n matrix A
+static void
+magma_zconjtrans_cpu(
+    magma_int_t m, magma_int_t n,
+    const magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *B, magma_int_t ldb )
+{
+    for( magma_int_t j = 0; j < n; ++j ) {
+        for( magma_int_t i = 0; i < m; ++i ) {
+            B[ j + i*ldb ] = MAGMA_Z_CNJG( A[ i + j*lda ] );
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    ZGESVD_2STAGE computes the singular value decomposition (SVD) of a
+    complex M-by-N matrix A, optionally computing the left and/or right
+    singular vectors, A = U * SIGMA * conjugate-transpose(V), as
+    magma_zgesvd and magma_zgesdd do, but reducing A to bidiagonal form in
+    two stages:
+
+     1. magma_zge2gb reduces A to band form, with level 3 BLAS on the device;
+     2. magma_zgb2bd reduces the band to bidiagonal form by a bulge chase
+        on the CPU.
+
+    The bidiagonal SVD is computed by QR iteration (bdsqr) or by divide
+    and conquer (bdsdc). Singular vectors are back-transformed on the
+    device: by magma_zbulge_back for the second stage, and by magma_zunmbr
+    and magma_zunmlq, which apply block reflectors with GEMMs, for the first.
+    If M < N, the SVD of A^H is computed instead.
+
+    magma_zgesvd and magma_zgesdd call this for large matrices, if their
+    LWORK is at least the size this returns for a workspace query. All CPU
+    workspace comes from WORK, RWORK, and IWORK; only a min(M,N)-by-min(M,N)
+    matrix on the device is allocated, if vectors are wanted.
+
+    Arguments
+    ---------
+    @param[in]
+    jobu    magma_vec_t
+    @param[in]
+    jobvt   magma_vec_t
+            Which singular vectors to compute, as in magma_zgesvd.
+            JOBVT and JOBU cannot both be MagmaOverwriteVec.
+
+    @param[in]
+    m       INTEGER
+            The number of rows of the input matrix A.  M >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the input matrix A.  N >= 0.
+
+    @param[in,out]
+    A       COMPLEX_16 array, dimension (LDA,N)
+            On entry, the M-by-N matrix A.
+            On exit, as in magma_zgesvd.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,M).
+
+    @param[out]
+    s       DOUBLE_PRECISION array, dimension (min(M,N))
+            The singular values of A, sorted so that S(i) >= S(i+1).
+
+    @param[out]
+    U       COMPLEX_16 array, dimension (LDU,UCOL)
+            The left singular vectors, as in magma_zgesvd.
+
+    @param[in]
+    ldu     INTEGER
+            The leading dimension of the array U.  LDU >= 1; if
+            JOBU = MagmaSomeVec or MagmaAllVec, LDU >= M.
+
+    @param[out]
+    VT      COMPLEX_16 array, dimension (LDVT,N)
+            The right singular vectors, as in magma_zgesvd.
+
+    @param[in]
+    ldvt    INTEGER
+            The leading dimension of the array VT.  LDVT >= 1;
+      -     if JOBVT = MagmaAllVec, LDVT >= N;
+      -     if JOBVT = MagmaSomeVec, LDVT >= min(M,N).
+
+    @param[in]
+    divconq INTEGER
+            If nonzero, the bidiagonal SVD is by divide and conquer, as in
+            magma_zgesdd; otherwise by QR iteration, as in magma_zgesvd.
+
+    @param[out]
+    work    (workspace) COMPLEX_16 array, dimension (max(1,LWORK))
+            On exit, if INFO = 0, WORK[0] returns the required LWORK.
+
+    @param[in]
+    lwork   INTEGER
+            The dimension of the array WORK. With y = min(M,N), about
+            2*y + (M+N+3*nb)*nb, plus y*y + 2*y*(y/nb+1) if vectors are
+            wanted, plus a copy of A^H if M < N, and of U or VT if M < N or
+            they overwrite A.
+    \n
+            If LWORK = -1, a workspace query is assumed; the routine only
+            calculates the required size of WORK, returns it in WORK[0],
+            and no error message related to LWORK is issued.
+
+    @param[out]
+    rwork   (workspace) DOUBLE_PRECISION array, dimension (max(1,LRWORK)),
+            where with y = min(M,N), LRWORK = 5*y*y + 5*y if DIVCONQ and
+            vectors are wanted, otherwise LRWORK = 5*y.
+            If INFO > 0, RWORK(0:y-2) contains the unconverged
+            superdiagonal elements of an upper bidiagonal matrix B whose
+            diagonal is in S, as in magma_zgesvd.
+
+    @param
+    iwork   (workspace) INTEGER array, dimension (8*min(M,N))
+            Referenced only if DIVCONQ.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit.
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value.
+      -     > 0:  the bidiagonal SVD did not converge; see magma_zgesvd
+                  (QR iteration) and magma_zgesdd (divide and conquer).
+
+    @ingroup magma_zgesvd_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zgesvd_2stage(
+    magma_vec_t jobu, magma_vec_t jobvt, magma_int_t m, magma_int_t n,
+    magmaDoubleComplex *A,  magma_int_t lda, double *s,
+    magmaDoubleComplex *U,  magma_int_t ldu,
+    magmaDoubleComplex *VT, magma_int_t ldvt,
+    magma_int_t divconq,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    double *rwork, magma_int_t *iwork,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define At(i_,j_)  (At  + (i_) + (j_)*ldat)
+    #define Ut(i_,j_)  (Ut  + (i_) + (j_)*ldut)
+    #define VTt(i_,j_) (VTt + (i_) + (j_)*ldvtt)
+
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+    const magma_int_t izero = 0;
+    const magma_int_t ione  = 1;
+
+    magma_int_t minmn = min(m,n);
+    magma_int_t lquery = (lwork == -1);
+
+    *info = 0;
+    if (! (jobu == MagmaAllVec || jobu == MagmaSomeVec ||
+           jobu == MagmaOverwriteVec || jobu == MagmaNoVec)) {
+        *info = -1;
+    } else if (! (jobvt == MagmaAllVec || jobvt == MagmaSomeVec ||
+                  jobvt == MagmaOverwriteVec || jobvt == MagmaNoVec) ||
+               (jobu == MagmaOverwriteVec && jobvt == MagmaOverwriteVec)) {
+        *info = -2;
+    } else if (m < 0) {
+        *info = -3;
+    } else if (n < 0) {
+        *info = -4;
+    } else if (lda < max(1,m)) {
+        *info = -6;
+    } else if (ldu < 1 || ((jobu == MagmaAllVec || jobu == MagmaSomeVec) && ldu < m)) {
+        *info = -9;
+    } else if (ldvt < 1 || (jobvt == MagmaAllVec && ldvt < n)
+                        || (jobvt == MagmaSomeVec && ldvt < minmn)) {
+        *info = -11;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if (m == 0 || n == 0) {
+        work[0] = MAGMA_Z_ONE;
+        if ( ! lquery && lwork < 1 ) {
+            *info = -14;
+            magma_xerbla( __func__, -(*info) );
+        }
+        return *info;
+    }
+
+    // Compute the SVD of the tall mt-by-nt matrix At = A, or A^H if m < n,
+    // At = Ut S VTt, with ncu columns of Ut. If m < n, U = VTt^H and VT = Ut^H.
+    magma_int_t trans = (m < n);
+    magma_int_t mt = max(m,n);
+    magma_int_t nt = minmn;
+    magma_vec_t jobut  = (trans ? jobvt : jobu );
+    magma_vec_t jobvtt = (trans ? jobu  : jobvt);
+    magma_int_t wantu  = (jobut  != MagmaNoVec);
+    magma_int_t wantvt = (jobvtt != MagmaNoVec);
+    magma_int_t wantz  = (wantu || wantvt);
+    magma_int_t ncu    = (jobut == MagmaAllVec ? mt : nt);
+
+    magma_int_t nthread = magma_get_parallel_numthreads();
+    magma_int_t nb      = min( nt, magma_get_zbulge_nb( nt, nthread ));
+    magma_int_t Vblksiz = magma_zbulge_get_Vblksiz( nt, nb );
+    magma_int_t ldtau   = max( 1, magma_ceildiv( nt, nb ));
+    magma_int_t lv2     = (wantz ? nt*(nt-1)/2 : 0);
+    magma_int_t ltau2   = (wantz ? ldtau*nt    : 0);
+    magma_int_t lddz    = magma_roundup( nt, 32 );
+    magma_int_t kp      = nt - nb;  // reflectors of P1
+
+    // At, Ut, VTt are A, U, VT when they can be; otherwise, copies in work
+    magma_int_t copy_u  = (wantu  && (trans || jobu  == MagmaOverwriteVec));
+    magma_int_t copy_vt = (wantvt && (trans || jobvt == MagmaOverwriteVec));
+    magma_int_t ldat  = (trans   ? mt : lda );
+    magma_int_t ldut  = (copy_u  ? mt : ldu );
+    magma_int_t ldvtt = (copy_vt ? nt : ldvt);
+
+    // workspace for magma_zunmbr and magma_zunmlq
+    magmaDoubleComplex query[1];
+    magma_int_t iinfo, lwunm = 1;
+    if ( wantu ) {
+        magma_zunmbr( MagmaQ, MagmaLeft, MagmaNoTrans, mt, ncu, nt, A, ldat,
+                      NULL, U, ldut, query, -1, queue, &iinfo );
+        lwunm = max( lwunm, (magma_int_t) MAGMA_Z_REAL( query[0] ));
+    }
+    if ( wantvt && kp > 0 ) {
+        magma_zunmlq( MagmaRight, MagmaNoTrans, nt, kp, kp, A, ldat,
+                      NULL, VT, ldvtt, query, -1, queue, &iinfo );
+        lwunm = max( lwunm, (magma_int_t) MAGMA_Z_REAL( query[0] ));
+    }
+
+    // work:  tauq, taup (2*nt), VQ2, VP2 (2*lv2), tauq2, taup2 (2*ltau2),
+    //        copies of At, Ut, VTt,
+    //        zge2gb (mt + nt + 3*nb)*nb or zunmbr/zunmlq work
+    // rwork: e (nt), then bdsqr (4*nt),
+    //        or Ub, VTb (2*nt^2) and bdsdc (3*nt^2 + 4*nt)
+    magma_int_t lwge   = (mt + nt + 3*nb)*nb;
+    magma_int_t lwcopy = (trans   ? ldat*nt   : 0)
+                       + (copy_u  ? ldut*ncu  : 0)
+                       + (copy_vt ? ldvtt*nt  : 0);
+    magma_int_t lwmin  = 2*nt + 2*lv2 + 2*ltau2 + lwcopy + max( lwge, lwunm );
+
+    // multiply by 1+eps (in Double!) to ensure length gets rounded up,
+    // if it cannot be exactly represented in floating point.
+    real_Double_t one_eps = 1. + lapackf77_dlamch("Epsilon");
+    work[0] = MAGMA_Z_MAKE( lwmin * one_eps, 0 );
+    if ( ! lquery && lwork < lwmin ) {
+        *info = -14;
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+    if ( lquery ) {
+        return *info;
+    }
+
+    magmaDoubleComplex_ptr dZ = NULL;
+    if ( wantz && MAGMA_SUCCESS != magma_zmalloc( &dZ, lddz*nt )) {
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+
+    {
+    magmaDoubleComplex *tauq  = work;
+    magmaDoubleComplex *taup  = tauq  + nt;
+    magmaDoubleComplex *VQ2   = taup  + nt;
+    magmaDoubleComplex *VP2   = VQ2   + lv2;
+    magmaDoubleComplex *tauq2 = VP2   + lv2;
+    magmaDoubleComplex *taup2 = tauq2 + ltau2;
+    magmaDoubleComplex *At    = (trans   ? taup2 + ltau2 : A );
+    magmaDoubleComplex *Ut    = (copy_u  ? taup2 + ltau2 + (trans ? ldat*nt : 0) : U );
+    magmaDoubleComplex *VTt   = (copy_vt ? taup2 + ltau2 + lwcopy - ldvtt*nt     : VT);
+    magmaDoubleComplex *hwork = taup2 + ltau2 + lwcopy;
+    magma_int_t lhwork = lwork - (hwork - work);
+    double *e      = rwork;
+    double *Ub     = e + nt;
+    double *VTb    = Ub  + (divconq && wantz ? nt*nt : 0);
+    double *rwork2 = VTb + (divconq && wantz ? nt*nt : 0);
+    magmaDoubleComplex cdummy[1];
+    double dummy[1];
+    magma_int_t idummy[1];
+
+    magma_timer_t time, time_total;
+    timer_start( time_total );
+
+    if ( trans ) {
+        magma_zconjtrans_cpu( m, n, A, lda, At, ldat );
+    }
+
+    // Scale A if max element outside range [SMLNUM,BIGNUM]
+    double eps    = lapackf77_dlamch("P");
+    double smlnum = magma_dsqrt(lapackf77_dlamch("S")) / eps;
+    double bignum = 1. / smlnum;
+    double anrm   = lapackf77_zlange("M", &mt, &nt, At, &ldat, dummy);
+    magma_int_t iscl = 0;
+    if (anrm > 0. && anrm < smlnum) {
+        iscl = 1;
+        lapackf77_zlascl("G", &izero, &izero, &anrm, &smlnum, &mt, &nt, At, &ldat, &iinfo);
+    }
+    else if (anrm > bignum) {
+        iscl = 1;
+        lapackf77_zlascl("G", &izero, &izero, &anrm, &bignum, &mt, &nt, At, &ldat, &iinfo);
+    }
+
+    // Reduce to band form, then to bidiagonal form
+    timer_start( time );
+    magma_zge2gb( mt, nt, nb, At, ldat, tauq, taup, hwork, lhwork, queue, &iinfo );
+    if ( iinfo != 0 ) {
+        *info = iinfo;
+        goto CLEANUP;
+    }
+    timer_stop( time );
+    timer_printf( "time zge2gb = %6.2f\n", time );
+
+    timer_start( time );
+    magma_zgb2bd( nt, nb, At, ldat, s, e, VQ2, tauq2, VP2, taup2, ldtau, wantz, &iinfo );
+    if ( iinfo != 0 ) {
+        *info = iinfo;
+        goto CLEANUP;
+    }
+    timer_stop( time );
+    timer_printf( "time zgb2bd = %6.2f\n", time );
+
+    // SVD of the bidiagonal matrix, B = Ub S VTb
+    timer_start( time );
+    if ( divconq ) {
+        const char* compq = (wantz ? "I" : "N");
+        lapackf77_dbdsdc( "U", compq, &nt, s, e, Ub, &nt, VTb, &nt,
+                          dummy, idummy, rwork2, iwork, info );
+    }
+    else {
+        // Ub and VTb go directly into Ut and VTt
+        magma_int_t ncvt = (wantvt ? nt : 0);
+        magma_int_t nru  = (wantu  ? nt : 0);
+        if ( wantu ) {
+            lapackf77_zlaset( "F", &mt, &ncu, &c_zero, &c_one, Ut, &ldut );
+        }
+        if ( wantvt ) {
+            lapackf77_zlaset( "F", &nt, &nt, &c_zero, &c_one, VTt, &ldvtt );
+        }
+        lapackf77_zbdsqr( "U", &nt, &ncvt, &nru, &izero, s, e, VTt, &ldvtt, Ut, &ldut,
+                          cdummy, &ione, rwork2, info );
+    }
+    timer_stop( time );
+    timer_printf( "time bdsvd  = %6.2f\n", time );
+    if ( *info != 0 )
+        goto UNSCALE;
+
+    timer_start( time );
+    if ( wantu ) {
+        // Ut = Q1 Q2 [ Ub 0; 0 I ]
+        if ( divconq ) {
+            lapackf77_zlaset( "F", &mt, &ncu, &c_zero, &c_one, Ut, &ldut );
+            lapackf77_zlacp2( "F", &nt, &nt, Ub, &nt, Ut, &ldut );
+        }
+        magma_zsetmatrix( nt, nt, Ut, ldut, dZ, 0, lddz, queue );
+        magma_zbulge_back( nt, nb, nt, Vblksiz, VQ2, tauq2, ldtau,
+                           dZ, 0, lddz, queue, &iinfo );
+        magma_zgetmatrix( nt, nt, dZ, 0, lddz, Ut, ldut, queue );
+        magma_zunmbr( MagmaQ, MagmaLeft, MagmaNoTrans, mt, ncu, nt, At, ldat,
+                      tauq, Ut, ldut, hwork, lhwork, queue, &iinfo );
+    }
+    if ( wantvt ) {
+        // VTt = [ VTb P2^H ] P1^H, that is VTt^H = P1 P2 VTb^H;
+        // VTb is real, so VTb^H is its transpose
+        if ( divconq ) {
+            for( magma_int_t j = 0; j < nt; ++j ) {
+                for( magma_int_t i = 0; i < nt; ++i ) {
+                    *VTt(i,j) = MAGMA_Z_MAKE( VTb[ j + i*nt ], 0. );
+                }
+            }
+        }
+        else {
+            for( magma_int_t j = 0; j < nt; ++j ) {
+                for( magma_int_t i = 0; i < j; ++i ) {
+                    magmaDoubleComplex tmp = *VTt(i,j);
+                    *VTt(i,j) = *VTt(j,i);
+                    *VTt(j,i) = tmp;
+                }
+            }
+        }
+        magma_zsetmatrix( nt, nt, VTt, ldvtt, dZ, 0, lddz, queue );
+        magma_zbulge_back( nt, nb, nt, Vblksiz, VP2, taup2, ldtau,
+                           dZ, 0, lddz, queue, &iinfo );
+        magma_zgetmatrix( nt, nt, dZ, 0, lddz, VTt, ldvtt, queue );
+        for( magma_int_t j = 0; j < nt; ++j ) {
+            for( magma_int_t i = 0; i < j; ++i ) {
+                magmaDoubleComplex tmp = *VTt(i,j);
+                *VTt(i,j) = MAGMA_Z_CNJG( *VTt(j,i) );
+                *VTt(j,i) = MAGMA_Z_CNJG( tmp );
+            }
+            *VTt(j,j) = MAGMA_Z_CNJG( *VTt(j,j) );
+        }
+        if ( kp > 0 ) {
+            magma_zunmlq( MagmaRight, MagmaNoTrans, nt, kp, kp, At(0,nb), ldat,
+                          taup, VTt(0,nb), ldvtt, hwork, lhwork, queue, &iinfo );
+        }
+    }
+    timer_stop( time );
+    timer_printf( "time back   = %6.2f\n", time );
+
+    // Move the singular vectors to where they belong
+    if ( trans ) {
+        if ( wantvt ) {
+            magmaDoubleComplex *dst = (jobu == MagmaOverwriteVec ? A   : U  );
+            magma_int_t         ldd = (jobu == MagmaOverwriteVec ? lda : ldu);
+            magma_zconjtrans_cpu( nt, nt, VTt, ldvtt, dst, ldd );
+        }
+        if ( wantu ) {
+            magmaDoubleComplex *dst = (jobvt == MagmaOverwriteVec ? A   : VT  );
+            magma_int_t         ldd = (jobvt == MagmaOverwriteVec ? lda : ldvt);
+            magma_zconjtrans_cpu( mt, ncu, Ut, ldut, dst, ldd );
+        }
+    }
+    else if ( jobu == MagmaOverwriteVec ) {
+        lapackf77_zlacpy( "F", &mt, &nt, Ut, &ldut, A, &lda );
+    }
+    else if ( jobvt == MagmaOverwriteVec ) {
+        lapackf77_zlacpy( "F", &nt, &nt, VTt, &ldvtt, A, &lda );
+    }
+
+UNSCALE:
+    // Undo scaling if necessary
+    if (iscl == 1) {
+        magma_int_t nt_1 = nt - 1;
+        if (anrm > bignum) {
+            lapackf77_dlascl("G", &izero, &izero, &bignum, &anrm, &nt, &ione, s, &nt, &iinfo);
+            if (*info != 0) {
+                lapackf77_dlascl("G", &izero, &izero, &bignum, &anrm, &nt_1, &ione, e, &nt, &iinfo);
+            }
+        }
+        if (anrm < smlnum) {
+            lapackf77_dlascl("G", &izero, &izero, &smlnum, &anrm, &nt, &ione, s, &nt, &iinfo);
+            if (*info != 0) {
+                lapackf77_dlascl("G", &izero, &izero, &smlnum, &anrm, &nt_1, &ione, e, &nt, &iinfo);
+            }
+        }
+    }
+
+    timer_stop( time_total );
+    timer_printf( "time zgesvd_2stage total = %6.2f\n", time_total );
+    }
+
+CLEANUP:
+    magma_free( dZ );
+    return *info;
+} /* magma_zgesvd_2stage */
@@ -9,6 +9,67 @@
        @precisions normal z -> s d c
 */
 #include "common_magma.h"
+#include "magma_stats.h"
+
+
+// ----------------------------------------
+// Distributes A over ngpu GPUs in 1D block-column cyclic layout, factors it
+// with magma_zgetrf_mgpu, and gathers the factors back to A.
+// Returns MAGMA_ERR_DEVICE_ALLOC, leaving A unchanged, if A doesn't fit on
+// the GPUs; otherwise returns MAGMA_SUCCESS, with the LAPACK info in info.
+static magma_int_t
+zgetrf_mgpu_host(
+    magma_int_t ngpu, magma_int_t m, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda, magma_int_t *ipiv,
+    magma_int_t *info )
+{
+    magmaDoubleComplex_ptr d_lA[ MagmaMaxGPUs ];
+    magma_queue_t queues2[ 2*MagmaMaxGPUs ];
+    magma_queue_t queues [ MagmaMaxGPUs ];
+    magma_int_t d, n_local, err;
+    magma_int_t ldda = magma_roundup( m, 32 );
+
+    err = magma_queues_create_mgpu( ngpu, queues2 );
+    if ( err != MAGMA_SUCCESS ) {
+        return err;
+    }
+    for( d=0; d < ngpu; d++ ) {
+        queues[d] = queues2[2*d];
+    }
+
+    for( d=0; d < ngpu; d++ ) {
+        n_local = ((n/nb)/ngpu)*nb;
+        if (d < (n/nb) % ngpu)
+            n_local += nb;
+        else if (d == (n/nb) % ngpu)
+            n_local += n % nb;
+        if ( MAGMA_SUCCESS != magma_zmalloc( &d_lA[d], ldda*n_local )) {
+            while( d > 0 ) {
+                magma_free( d_lA[--d] );
+            }
+            magma_queues_destroy_mgpu( ngpu, queues2 );
+            return MAGMA_ERR_DEVICE_ALLOC;
+        }
+    }
+
+    magma_zsetmatrix_1D_col_bcyclic( m, n, A, lda, d_lA, ldda, ngpu, nb, queues );
+    magma_zgetrf_mgpu( ngpu, m, n, d_lA, 0, ldda, ipiv, queues2, info );
+    if ( *info == MAGMA_ERR_DEVICE_ALLOC ) {
+        err = MAGMA_ERR_DEVICE_ALLOC;
+    }
+    else {
+        magma_zgetmatrix_1D_col_bcyclic( m, n, d_lA, ldda, A, lda, ngpu, nb, queues );
+        for( d=0; d < ngpu; d++ ) {
+            magma_queue_sync( queues[d] );
+        }
+    }
+
+    for( d=0; d < ngpu; d++ ) {
+        magma_free( d_lA[d] );
+    }
+    magma_queues_destroy_mgpu( ngpu, queues2 );
+    return err;
+}
 
 
 
@@ -42,6 +103,11 @@ magma_zgetrf(
     If the current stream is NULL, this version replaces it with user defined
     stream to overlap computation with communication. 
 
+    If magma_num_gpus() > 1, A is distributed over the GPUs and factored
+    by magma_zgetrf_mgpu. If A does not fit in GPU memory, or $MAGMA_NGR_NB
+    limits the number of columns held on the GPU to fewer than N, the
+    non-GPU-resident magma_zgetrf_m is used instead.
+
     Arguments
     =========
     M       (input) INTEGER
@@ -76,14 +142,10 @@ magma_zgetrf(
 
     =====================================================================    */
 
-#define dAT(i,j) dAT, dAT_offset + ((i)*nb*lddat + (j)*nb)
+    magmaDoubleComplex_ptr dA;
+    magma_int_t nb;
 
-    magmaDoubleComplex *work;
-    magmaDoubleComplex_ptr dAT, dA, dwork, dAP;
-    size_t dA_offset, dAT_offset;
-    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
-    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
-    magma_int_t     iinfo, nb;
+    MAGMA_STATS_ROUTINE();
 
     *info = 0;
 
@@ -110,30 +172,27 @@ magma_zgetrf(
         lapackf77_zgetrf(&m, &n, A, &lda, ipiv, info);
     } else {
         /* Use hybrid blocked code. */
-        magma_int_t maxm, maxn, ldda, maxdim, lddat;
-        magma_int_t i, j, rows, cols, s = min(m, n)/nb;
-        
-        maxm = magma_roundup( m, 32 );
-        maxn = magma_roundup( n, 32 );
+        magma_int_t maxm, ldda;
 
-        lddat   = maxn;
-        ldda    = maxm;
-
-        maxdim = max(maxm, maxn);
+        maxm = magma_roundup( m, 32 );
+        ldda = maxm;
 
         /* set number of GPUs */
         magma_int_t num_gpus = magma_num_gpus();
         if ( num_gpus > 1 ) {
-            /* call multi-GPU non-GPU-resident interface  */
-            printf("multiple-GPU verison not implemented\n");
-            return MAGMA_ERR_NOT_IMPLEMENTED;
-            // magma_zgetrf_m(num_gpus, m, n, A, lda, ipiv, info);
-            // return *info;
+            /* call multi-GPU interface, with at least one block column per GPU;
+               if A doesn't fit on the GPUs, continue with one GPU */
+            magma_int_t ngpu = min( num_gpus, magma_ceildiv( n, nb ));
+            if ( zgetrf_mgpu_host( ngpu, m, n, nb, A, lda, ipiv, info ) == MAGMA_SUCCESS ) {
+                return *info;
+            }
+            num_gpus = 1;
+            *info = 0;
         }
 
         /* explicitly checking the memory requirement */
-        magma_int_t totalMem = magma_queue_meminfo( queue[0] );
-        totalMem /= sizeof(magmaDoubleComplex);
+        /* magma_queue_meminfo returns memory in units of 16 bytes */
+        double totalMem = 16. * magma_queue_meminfo( queue[0] ) / sizeof(magmaDoubleComplex);
 
         int h = 1+(2+num_gpus), num_gpus2 = num_gpus;
         int NB = (magma_int_t)(0.8*totalMem/maxm-h*nb);
@@ -148,179 +207,22 @@ magma_zgetrf(
         } 
         if( num_gpus2*NB < n ) {
             /* require too much memory, so call non-GPU-resident version */
-            printf("non-GPU-resident version not implemented\n");
-            return MAGMA_ERR_NOT_IMPLEMENTED; 
-            //magma_zgetrf_m(num_gpus, m, n, A, lda, ipiv, info);
-            //return *info;
+            magma_zgetrf_m( m, n, A, lda, ipiv, queue, info );
+            return *info;
         }
 
-        work = A;
-        if (maxdim*maxdim < 2*maxm*maxn) {
-            // if close to square, allocate square matrix and transpose in-place
-            if (MAGMA_SUCCESS != 
-                magma_zmalloc( &dwork, (nb*maxm + maxdim*maxdim) ) ) {
-                /* alloc failed so call non-GPU-resident version */
-                printf("non-GPU-resident version not implemented\n");
-                return MAGMA_ERR_NOT_IMPLEMENTED;
-                //magma_zgetrf_m(num_gpus, m, n, A, lda, ipiv, info);
-                //return *info;
-            }
-            dAP = dwork;
-
-            dA = dwork;
-            dA_offset = nb*maxm;            
-
-            ldda = lddat = maxdim;
-            magma_zsetmatrix( m, n, A, lda, dA, dA_offset, ldda, queue[0] );
-            
-            dAT = dA;
-            dAT_offset = dA_offset;
-            magmablas_ztranspose_inplace( m, dAT, dAT_offset, ldda, queue[0] );
-        }
-        else {
-            // if very rectangular, allocate dA and dAT and transpose out-of-place
-            if (MAGMA_SUCCESS != 
-                magma_zmalloc( &dwork, (nb + maxn)*maxm )) {
-                /* alloc failed so call non-GPU-resident version */
-                printf("non-GPU-resident version not implemented\n");
-                return MAGMA_ERR_NOT_IMPLEMENTED;
-                //magma_zgetrf_m(num_gpus, m, n, A, lda, ipiv, info);
-                //return *info;
-            }
-            dAP = dwork;
-
-            dA = dwork;
-            dA_offset = nb*maxm;
-            
-            magma_zsetmatrix( m, n, A, lda, dA, dA_offset, ldda, queue[0] );
-            
-            if (MAGMA_SUCCESS != magma_zmalloc( &dAT, maxm*maxn )) {
-                /* alloc failed so call non-GPU-resident version */
-                magma_free( dwork );
-                printf("non-GPU-resident version not implemented\n");
-                return MAGMA_ERR_NOT_IMPLEMENTED;
-                //magma_zgetrf_m(num_gpus, m, n, A, lda, ipiv, info);
-                //return *info;
-            }
-            dAT_offset = 0;   
-            magmablas_ztranspose( m, n, dA, dA_offset, ldda, dAT, dAT_offset, lddat, queue[0] );
+        if ( MAGMA_SUCCESS != magma_zmalloc( &dA, ldda*n )) {
+            /* alloc failed so call non-GPU-resident version */
+            magma_zgetrf_m( m, n, A, lda, ipiv, queue, info );
+            return *info;
         }
-        
-        lapackf77_zgetrf( &m, &nb, work, &lda, ipiv, &iinfo);
-
-        for( j = 0; j < s; j++ )
-        {
-            // download j-th panel
-            cols = maxm - j*nb;
-            
-            if (j>0){
-                // download j-th panel 
-                magmablas_ztranspose( nb, cols, dAT(j,j), lddat, dAP, 0, cols, queue[0] );
-
-                magma_queue_sync(queue[0]);
-                magma_zgetmatrix_async( m-j*nb, nb, dAP, 0, cols, work, lda, 
-                                        queue[1], NULL);
-                
-                magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
-                             n - (j+1)*nb, nb,
-                             c_one, dAT(j-1,j-1), lddat,
-                                    dAT(j-1,j+1), lddat, queue[0] );
-                magma_zgemm( MagmaNoTrans, MagmaNoTrans,
-                             n-(j+1)*nb, m-j*nb, nb,
-                             c_neg_one, dAT(j-1,j+1), lddat,
-                                        dAT(j,  j-1), lddat,
-                             c_one,     dAT(j,  j+1), lddat, queue[0] );
-
-                // do the cpu part
-                rows = m - j*nb;
-                magma_queue_sync( queue[1] );
-                lapackf77_zgetrf( &rows, &nb, work, &lda, ipiv+j*nb, &iinfo);
-            }
-            if (*info == 0 && iinfo > 0)
-                *info = iinfo + j*nb;
 
-            for( i=j*nb; i < j*nb + nb; ++i ) {
-                ipiv[i] += j*nb;
-            }
-            magmablas_zlaswp( n, dAT, dAT_offset, lddat, j*nb + 1, j*nb + nb, ipiv, 1, queue[0] );
-
-            // upload j-th panel
-            magma_zsetmatrix_async( m-j*nb, nb, work, lda, dAP, 0, maxm,
-                                    queue[1], NULL);
-            magma_queue_sync( queue[1] );
-
-            magmablas_ztranspose( cols, nb, dAP, 0, maxm, dAT(j,j), lddat, queue[0] );
-
-            // do the small non-parallel computations
-            if (s > (j+1)){
-                magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
-                             nb, nb,
-                             c_one, dAT(j, j  ), lddat,
-                                    dAT(j, j+1), lddat, queue[0]);
-                magma_zgemm( MagmaNoTrans, MagmaNoTrans,
-                             nb, m-(j+1)*nb, nb,
-                             c_neg_one, dAT(j,   j+1), lddat,
-                                        dAT(j+1, j  ), lddat,
-                             c_one,     dAT(j+1, j+1), lddat, queue[0] );
-            }
-            else{
-                magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
-                             n-s*nb, nb,
-                             c_one, dAT(j, j  ), lddat,
-                                    dAT(j, j+1), lddat, queue[0] );
-                magma_zgemm( MagmaNoTrans, MagmaNoTrans,
-                             n-(j+1)*nb, m-(j+1)*nb, nb,
-                             c_neg_one, dAT(j,   j+1), lddat,
-                                        dAT(j+1, j  ), lddat,
-                             c_one,     dAT(j+1, j+1), lddat, queue[0] );
-            }
-        }
-        
-        magma_int_t nb0 = min(m - s*nb, n - s*nb);
-        if ( nb0 > 0 ) {
-            rows = m - s*nb;
-            cols = maxm - s*nb;
-    
-            magmablas_ztranspose( nb0, rows, dAT(s,s), lddat, dAP, 0, maxm, queue[0]);
-            magma_queue_sync(queue[0]);
-            magma_zgetmatrix_async( rows, nb0, dAP, 0, maxm, work, lda, queue[1], NULL );
-            magma_queue_sync(queue[1]);
-
-            // do the cpu part
-            lapackf77_zgetrf( &rows, &nb0, work, &lda, ipiv+s*nb, &iinfo);
-            if (*info == 0 && iinfo > 0)
-                *info = iinfo + s*nb;
-            
-            for( i=s*nb; i < s*nb + nb0; ++i ) {
-                ipiv[i] += s*nb;
-            }
-            magmablas_zlaswp( n, dAT, dAT_offset, lddat, s*nb + 1, s*nb + nb0, ipiv, 1, queue[0] );
-    
-            magma_zsetmatrix_async( rows, nb0, work, lda, dAP, 0, maxm, queue[1], NULL );
-            magma_queue_sync(queue[1]);
-            magmablas_ztranspose( rows, nb0, dAP, 0, maxm, dAT(s,s), lddat, queue[0]);
-    
-            magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
-                         n-s*nb-nb0, nb0,
-                         c_one, dAT(s, s),     lddat,
-                                dAT(s, s)+nb0, lddat, queue[0] );
-        }
-       
-        if (maxdim*maxdim < 2*maxm*maxn) {
-            magmablas_ztranspose_inplace( m, dAT, dAT_offset, lddat, queue[0] );
-            magma_zgetmatrix( m, n, dA, dA_offset, ldda, A, lda, queue[0] );
-        } else {
-            magmablas_ztranspose( n, m, dAT, dAT_offset, lddat, dA, dA_offset, ldda, queue[0] );
-            magma_zgetmatrix( m, n, dA, dA_offset, ldda, A, lda, queue[0] );
-            magma_queue_sync(queue[0]);
-            magma_free( dAT );
-        }
+        magma_zsetmatrix( m, n, A, lda, dA, 0, ldda, queue[0] );
+        magma_zgetrf_lookahead_gpu( m, n, dA, 0, ldda, ipiv, 0, queue, info );
+        magma_zgetmatrix( m, n, dA, 0, ldda, A, lda, queue[0] );
 
-        magma_queue_sync(queue[0]);
-        magma_free( dwork );
+        magma_free( dA );
     }
     
     return *info;
 } /* magma_zgetrf */
-
-#undef dAT
@@ -91,6 +91,12 @@ magma_zgetrf2_mgpu(
     magmaDoubleComplex_ptr d_panel[4], panel_local[4];
     size_t d_panel_offset[4];
     size_t panel_local_offset[4];
+
+    /* events ordering each gpu's compute queue, queues[2*d],
+       and transfer queue, queues[2*d+1] */
+    magma_event_t swap_event[4];   /* pivoting done on compute queue */
+    magma_event_t panel_event[4];  /* panel arrived on transfer queue */
+    magma_event_t read_event[4];   /* d_lAP read on compute queue */
     //cudaStream_t streaml[4][2];
 
     /* Check arguments */
@@ -138,6 +144,12 @@ magma_zgetrf2_mgpu(
         
         }
         
+        for( d=0; d < num_gpus; d++ ) {
+            magma_event_create( &swap_event[d]  );
+            magma_event_create( &panel_event[d] );
+            magma_event_create( &read_event[d]  );
+        }
+        
         /* start sending the panel to cpu */
         nb0 = min(mindim, nb);
         magmablas_ztranspose( nb0, maxm, d_lAT(0,0,0), lddat, d_lAP[0], 0, maxm, queues[2*0+1] );
@@ -173,6 +185,8 @@ magma_zgetrf2_mgpu(
             /* start sending the panel to all the gpus */
             d = (j+1)%num_gpus;
             for( dd=0; dd<num_gpus; dd++ ) {
+                /* don't overwrite d_lAP before the previous panel is read */
+                magma_queue_wait_event( queues[2*d+1], read_event[d] );
                 magma_zsetmatrix_async( rows, nb,
                                         W(j), ldw,
                                         d_lAP[d], dlAP_offset, cols, queues[2*d+1], NULL );
@@ -242,9 +256,13 @@ magma_zgetrf2_mgpu(
                 
                 /* gpu updating the trailing matrix */
                 if(d == (j+1)%num_gpus){
-                magma_queue_sync(queues[2*d]);
+                /* pivoting done? (overwrite with panel) */
+                magma_event_record( swap_event[d], queues[2*d] );
+                magma_queue_wait_event( queues[2*d+1], swap_event[d] );
                 magmablas_ztranspose( cols, nb, d_lAP[d], 0, cols, panel_local[d], panel_local_offset[d], ldpan[d], queues[2*d+1] );
-                magma_queue_sync(queues[2*d+1]);
+                /* panel transposed for remaining update */
+                magma_event_record( panel_event[d], queues[2*d+1] );
+                magma_queue_wait_event( queues[2*d], panel_event[d] );
                 magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit, 
                              nb1, nb, c_one,
                              panel_local[d], panel_local_offset[d], ldpan[d],
@@ -257,8 +275,11 @@ magma_zgetrf2_mgpu(
                               c_one,     d_lAT(d, j+1, i_local2),         lddat,
                               queues[2*d+1]);
                 }else{
-                magma_queue_sync(queues[2*d+1]);
+                /* panel arrived? */
+                magma_event_record( panel_event[d], queues[2*d+1] );
+                magma_queue_wait_event( queues[2*d], panel_event[d] );
                 magmablas_ztranspose( cols, nb, d_lAP[d], 0, cols, panel_local[d], panel_local_offset[d], ldpan[d], queues[2*d] );
+                magma_event_record( read_event[d], queues[2*d] );
                 magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit, 
                              nb1, nb, c_one,
                              panel_local[d], panel_local_offset[d], ldpan[d],
@@ -345,6 +366,7 @@ magma_zgetrf2_mgpu(
                 if( d < id ) i_local2 ++;
         
                 if( d == id || n_local[d] > i_local2*nb ) {
+                    magma_queue_wait_event( queues[2*d+1], read_event[d] );
                     magma_zsetmatrix_async( rows, nb0,
                                             W(s), ldw,
                                             d_lAP[d], 0, cols, queues[2*d+1], NULL );
@@ -362,7 +384,8 @@ magma_zgetrf2_mgpu(
             for( d=0; d<num_gpus; d++ ) {
                 //magma_queue_sync( queues[2*d+1] );
                 /* wait for the pivoting to be done */
-                magma_queue_sync( queues[2*d] );
+                magma_event_record( swap_event[d], queues[2*d] );
+                magma_queue_wait_event( queues[2*d+1], swap_event[d] );
         
                 i_local2 = i_local;
                 if( d < id ) i_local2++;
@@ -407,6 +430,9 @@ magma_zgetrf2_mgpu(
         for( d=0; d<num_gpus; d++ ) {
                 magma_queue_sync( queues[2*d] );
                 magma_queue_sync( queues[2*d+1] );
+                magma_event_destroy( swap_event[d]  );
+                magma_event_destroy( panel_event[d] );
+                magma_event_destroy( read_event[d]  );
                 //magma_queue_destroy(streaml[d][0]);
                 //magma_queue_destroy(streaml[d][1]);
         } 
@@ -91,6 +91,12 @@ magma_zgetrf2_msub(
     magma_int_t i, j, d, dd, rows, cols, s;
     magma_int_t id, j_local, j_local2, nb0, nb1;
 
+    /* events ordering each gpu's compute queue, queues[2*d],
+       and transfer queue, queues[2*d+1] */
+    magma_event_t swap_event[MagmaMaxGPUs];   /* pivoting done on compute queue */
+    magma_event_t panel_event[MagmaMaxGPUs];  /* panel arrived on transfer queue */
+    magma_event_t read_event[MagmaMaxGPUs];   /* panel buffer read on compute queue */
+
     /* local submatrix info */
     magma_int_t ldpan[MagmaMaxSubs * MagmaMaxGPUs],
                 n_local[MagmaMaxSubs * MagmaMaxGPUs]; 
@@ -135,6 +141,12 @@ magma_zgetrf2_msub(
                 n_local[i] += n%nb;
         }
         
+        for (d=0; d < ngpu; d++) {
+            magma_event_create( &swap_event[d]  );
+            magma_event_create( &panel_event[d] );
+            magma_event_create( &read_event[d]  );
+        }
+        
         /* start sending the first panel to cpu */
         nb0 = min(mindim, nb);
         magmablas_ztranspose(  nb0, maxm, d_lAT(0,0,0), lddat, d_lAP[0], dlAP_offset, maxm, queues[2*0+1] );
@@ -169,6 +181,8 @@ magma_zgetrf2_msub(
             /* start sending the panel to all the gpus */
             d = (j+1)%ngpu;
             for (dd=0; dd < ngpu; dd++) {
+                /* don't overwrite the panel buffer before the previous panel is read */
+                magma_queue_wait_event( queues[2*d+1], read_event[d] );
                 magma_zsetmatrix_async( rows, nb,
                                         W(j), ldw,
                                         d_lAP[d], dlAP_offset+(j%(2+ngpu))*nb*maxm, maxm, 
@@ -226,12 +240,16 @@ magma_zgetrf2_msub(
                 
                 /* gpu updating the trailing matrix */
                 if (d == (j+1)%tot_subs) { /* look-ahead, this is executed first (j.e., dd=0)  */
-                    magma_queue_sync(queues[2*(d%ngpu)]);   /* pivoting done? (overwrite with panel) */
+                    /* pivoting done? (overwrite with panel) */
+                    magma_event_record( swap_event[d%ngpu], queues[2*(d%ngpu)] );
+                    magma_queue_wait_event( queues[2*(d%ngpu)+1], swap_event[d%ngpu] );
                     magmablas_ztranspose( cols, nb,
                                           d_lAP[d%ngpu], dlAP_offset+(j%(2+ngpu))*nb*maxm, maxm,
                                           dpanel_local[d], dpanel_local_offset[d], ldpan[d], 
                                           queues[2*(d%ngpu)+1] );
-                    magma_queue_sync(queues[2*(d%ngpu)+1]); /* panel arrived and transposed for remaining update ? */
+                    /* panel arrived and transposed for remaining update */
+                    magma_event_record( panel_event[d%ngpu], queues[2*(d%ngpu)+1] );
+                    magma_queue_wait_event( queues[2*(d%ngpu)], panel_event[d%ngpu] );
         
                     magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit, 
                                  nb1, nb, c_one,
@@ -247,11 +265,14 @@ magma_zgetrf2_msub(
                 } else { /* no look-ahead */
                     if (dd < ngpu) {
                         /* synch and transpose only the first time */
-                        magma_queue_sync(queues[2*(d%ngpu)+1]); /* panel arrived? */
+                        /* panel arrived? */
+                        magma_event_record( panel_event[d%ngpu], queues[2*(d%ngpu)+1] );
+                        magma_queue_wait_event( queues[2*(d%ngpu)], panel_event[d%ngpu] );
                         magmablas_ztranspose( cols, nb,
                                               d_lAP[d%ngpu], dlAP_offset+(j%(2+ngpu))*nb*maxm, maxm,
                                               dpanel_local[d], dpanel_local_offset[d], ldpan[d], 
                                               queues[2*(d%ngpu)] );
+                        magma_event_record( read_event[d%ngpu], queues[2*(d%ngpu)] );
                     }
         
                     magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit, 
@@ -335,6 +356,7 @@ magma_zgetrf2_msub(
         
             /* send the factor to gpus */
             for (d=0; d < ngpu; d++) {
+                magma_queue_wait_event( queues[2*d+1], read_event[d] );
                 magma_zsetmatrix_async( rows, nb0, W(s), ldw,
                                         d_lAP[d], dlAP_offset+(s%(2+ngpu))*nb*maxm, cols, 
                                         queues[2*d+1], NULL );
@@ -352,7 +374,8 @@ magma_zgetrf2_msub(
                 /* wait for the pivoting to be done */
                 if (dd < ngpu) {
                     /* synch only the first time */
-                    magma_queue_sync( queues[2*(d%ngpu)] );
+                    magma_event_record( swap_event[d%ngpu], queues[2*(d%ngpu)] );
+                    magma_queue_wait_event( queues[2*(d%ngpu)+1], swap_event[d%ngpu] );
                 }
         
                 j_local2 = j_local;
@@ -409,6 +432,9 @@ magma_zgetrf2_msub(
         for (d=0; d < ngpu; d++) {
             magma_queue_sync( queues[2*d] );
             magma_queue_sync( queues[2*d+1] );
+            magma_event_destroy( swap_event[d]  );
+            magma_event_destroy( panel_event[d] );
+            magma_event_destroy( read_event[d]  );
         } 
     }
     return *info;
@@ -0,0 +1,367 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+
+*/
+#include "common_magma.h"
+#include "magma_stats.h"
+
+
+/*
+    Applies the update from the panel at rows/columns j0:j0+jb of the
+    transposed matrix dAT to columns c0:c1 of A (rows c0:c1 of dAT):
+    row interchanges, triangular solve for U12, and GEMM update of A22.
+*/
+static void
+magma_zgetrf_update_cols(
+    magma_int_t m, magma_int_t j0, magma_int_t jb,
+    magma_int_t c0, magma_int_t c1,
+    magmaDoubleComplex_ptr dAT, size_t dAT_offset, magma_int_t lddat,
+    magma_int_t *ipiv,
+    magma_queue_t queue )
+{
+    #define dAT(i_, j_) dAT, dAT_offset + (i_) + (j_)*lddat
+
+    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+
+    magma_int_t cols = c1 - c0;
+    magma_int_t rows = m - j0 - jb;
+    if ( cols <= 0 )
+        return;
+
+    magmablas_zlaswp( cols, dAT(c0, 0), lddat, j0 + 1, j0 + jb, ipiv, 1, queue );
+    magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
+                 cols, jb,
+                 c_one, dAT(j0, j0), lddat,
+                        dAT(c0, j0), lddat, queue );
+    if ( rows > 0 ) {
+        magma_zgemm( MagmaNoTrans, MagmaNoTrans,
+                     cols, rows, jb,
+                     c_neg_one, dAT(c0, j0),    lddat,
+                                dAT(j0, j0+jb), lddat,
+                     c_one,     dAT(c0, j0+jb), lddat, queue );
+    }
+
+    #undef dAT
+}
+
+
+extern "C" magma_int_t
+magma_zgetrf_lookahead_gpu(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda,
+    magma_int_t *ipiv,
+    magma_int_t depth,
+    magma_queue_t queues[2],
+    magma_int_t *info )
+{
+/*  -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+    Purpose
+    =======
+    ZGETRF_LOOKAHEAD computes an LU factorization of a general M-by-N
+    matrix A using partial pivoting with row interchanges.
+
+    The factorization has the form
+        A = P * L * U
+    where P is a permutation matrix, L is lower triangular with unit
+    diagonal elements (lower trapezoidal if m > n), and U is upper
+    triangular (upper trapezoidal if m < n).
+
+    This is the right-looking Level 3 BLAS version of the algorithm,
+    and the engine behind magma_zgetrf_gpu, magma_zgetrf2_gpu, and
+    magma_zgetrf. Panels are factored on the CPU while the GPU updates
+    the trailing matrix. The DEPTH block columns following the current
+    panel are updated first, on queues[1], which also carries all
+    host-device transfers; the rest of the trailing matrix is updated on
+    queues[0]. Dependencies between the queues and the CPU are tracked
+    with events, so neither queue is synchronized inside the loop and
+    the CPU waits only for the next panel to arrive.
+
+    Arguments
+    =========
+    M       (input) INTEGER
+            The number of rows of the matrix A.  M >= 0.
+
+    N       (input) INTEGER
+            The number of columns of the matrix A.  N >= 0.
+
+    A       (input/output) COMPLEX_16 array on the GPU, dimension (LDDA,N).
+            On entry, the M-by-N matrix to be factored.
+            On exit, the factors L and U from the factorization
+            A = P*L*U; the unit diagonal elements of L are not stored.
+
+    LDDA    (input) INTEGER
+            The leading dimension of the array A.  LDDA >= max(1,M).
+
+    IPIV    (output) INTEGER array, dimension (min(M,N))
+            The pivot indices; for 1 <= i <= min(M,N), row i of the
+            matrix was interchanged with row IPIV(i).
+
+    DEPTH   (input) INTEGER
+            The number of block columns updated ahead of the trailing
+            matrix.  DEPTH >= 0.  If DEPTH = 0, the depth is taken from
+            magma_get_zgetrf_lookahead.
+
+    QUEUES  (input) magma_queue_t array, dimension (2)
+            Queues on the same device. queues[0] executes the trailing
+            matrix update; queues[1] executes transfers and the look-ahead.
+            Both may be the same queue, which serializes the GPU work.
+
+    INFO    (output) INTEGER
+            = 0:  successful exit
+            < 0:  if INFO = -i, the i-th argument had an illegal value
+                  or another error occured, such as memory allocation failed.
+            > 0:  if INFO = i, U(i,i) is exactly zero. The factorization
+                  has been completed, but the factor U is exactly
+                  singular, and division by zero will occur if it is used
+                  to solve a system of equations.
+    =====================================================================    */
+
+    #define  dA(i_, j_) dA,   dA_offset  + (i_)*nb       + (j_)*nb*ldda
+    #define dAT(i_, j_) dAT,  dAT_offset + (i_)*nb*lddat + (j_)*nb
+    #define dAP(i_, j_) dAP,               (i_)          + (j_)*maxm
+    #define work(i_)   (work + (i_))
+
+    magma_int_t iinfo, nb;
+    magma_int_t maxm, maxn, mindim;
+    magma_int_t i, j, jb, rows, s, nb0, lddat, ldwork;
+    magma_int_t c0, c1;
+    magmaDoubleComplex_ptr dAT, dAP;
+    magmaDoubleComplex *work;
+    size_t dAT_offset;
+    double cpu_time;
+
+    magma_queue_t compute_queue = queues[0];
+    magma_queue_t la_queue      = queues[1];
+
+    // events:
+    // download -- next panel is in work (CPU waits)
+    // panel    -- factored panel is back in dAT (compute queue waits)
+    // entering -- block column entering the look-ahead window has its
+    //             last trailing update (look-ahead queue waits)
+    // sync     -- hand-off at start and end of factorization
+    magma_event_t download_event, panel_event, entering_event, sync_event;
+
+    /* Check arguments */
+    *info = 0;
+    if (m < 0)
+        *info = -1;
+    else if (n < 0)
+        *info = -2;
+    else if (ldda < max(1,m))
+        *info = -4;
+    else if (depth < 0)
+        *info = -6;
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    /* Quick return if possible */
+    if (m == 0 || n == 0)
+        return *info;
+
+    /* Function Body */
+    mindim = min(m, n);
+    nb     = magma_get_zgetrf_nb(m);
+    s      = mindim / nb;
+    if ( depth == 0 )
+        depth = magma_get_zgetrf_lookahead( m, n );
+
+    if (nb <= 1 || nb >= min(m,n)) {
+        /* Use CPU code. */
+        if ( MAGMA_SUCCESS != magma_zmalloc_cpu( &work, m*n )) {
+            *info = MAGMA_ERR_HOST_ALLOC;
+            return *info;
+        }
+        magma_zgetmatrix( m, n, dA(0,0), ldda, work(0), m, compute_queue );
+        lapackf77_zgetrf( &m, &n, work, &m, ipiv, info );
+        magma_zsetmatrix( m, n, work(0), m, dA(0,0), ldda, compute_queue );
+        magma_free_cpu( work );
+        return *info;
+    }
+
+    /* Use hybrid blocked code. */
+    maxm = magma_roundup( m, 32 );
+    maxn = magma_roundup( n, 32 );
+
+    if ( MAGMA_SUCCESS != magma_zmalloc( &dAP, nb*maxm )) {
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+
+    // square matrices can be done in place;
+    // rectangular requires copy to transpose
+    if ( m == n ) {
+        dAT = dA;
+        dAT_offset = dA_offset;
+        lddat = ldda;
+    }
+    else {
+        lddat = maxn;  // N-by-M
+        dAT_offset = 0;
+        if ( MAGMA_SUCCESS != magma_zmalloc( &dAT, lddat*maxm )) {
+            magma_free( dAP );
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+    }
+
+    ldwork = maxm;
+    if ( MAGMA_SUCCESS != magma_zmalloc_pinned( &work, ldwork*nb )) {
+        magma_free( dAP );
+        if ( dA != dAT )
+            magma_free( dAT );
+
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+
+    magma_event_create( &download_event );
+    magma_event_create( &panel_event    );
+    magma_event_create( &entering_event );
+    magma_event_create( &sync_event     );
+
+    if ( dA == dAT ) {
+        magmablas_ztranspose_inplace( m, dAT(0,0), lddat, compute_queue );
+    }
+    else {
+        magmablas_ztranspose( m, n, dA(0,0), ldda, dAT(0,0), lddat, compute_queue );
+    }
+    magma_event_record( sync_event, compute_queue );
+    magma_queue_wait_event( la_queue, sync_event );
+
+    // download 0-th panel
+    magmablas_ztranspose( nb, m, dAT(0,0), lddat, dAP(0,0), maxm, la_queue );
+    magma_zgetmatrix_async( m, nb, dAP(0,0), maxm, work(0), ldwork, la_queue, NULL );
+    magma_event_record( download_event, la_queue );
+
+    nb0 = min( m - s*nb, n - s*nb );
+    for( j=0; j < s; j++ ) {
+        // do the cpu part
+        magma_event_sync( download_event );
+        rows = m - j*nb;
+        cpu_time = magma_wtime();
+        lapackf77_zgetrf( &rows, &nb, work, &ldwork, ipiv+j*nb, &iinfo );
+        magma_stats_cpu( magma_wtime() - cpu_time );
+        if ( *info == 0 && iinfo > 0 )
+            *info = iinfo + j*nb;
+
+        for( i=j*nb; i < j*nb + nb; ++i ) {
+            ipiv[i] += j*nb;
+        }
+
+        // upload j-th panel
+        magma_zsetmatrix_async( rows, nb, work(0), ldwork, dAP(0,0), maxm, la_queue, NULL );
+        magmablas_ztranspose( rows, nb, dAP(0,0), maxm, dAT(j,j), lddat, la_queue );
+        magma_event_record( panel_event, la_queue );
+
+        // look-ahead: update next block column and send it to the CPU,
+        // then update the rest of the window while the CPU factors it.
+        // With depth 1, the next block column is the one entering the window.
+        c0 = (j+1)*nb;
+        c1 = min( (j+2)*nb, n );
+        if ( depth == 1 && j > 0 && c0 < n ) {
+            magma_queue_wait_event( la_queue, entering_event );
+        }
+        magma_zgetrf_update_cols( m, j*nb, nb, c0, c1,
+                                  dAT(0,0), lddat, ipiv, la_queue );
+        if ( j+1 < s || nb0 > 0 ) {
+            jb = ( j+1 < s ? nb : nb0 );
+            magmablas_ztranspose( jb, m-c0, dAT(j+1,j+1), lddat, dAP(0,0), maxm, la_queue );
+            magma_zgetmatrix_async( m-c0, jb, dAP(0,0), maxm, work(0), ldwork, la_queue, NULL );
+            magma_event_record( download_event, la_queue );
+        }
+        c0 = c1;
+        c1 = min( (j+1+depth)*nb, n );
+        if ( depth > 1 && j > 0 && (j+depth)*nb < n ) {
+            magma_queue_wait_event( la_queue, entering_event );
+        }
+        magma_zgetrf_update_cols( m, j*nb, nb, c0, c1,
+                                  dAT(0,0), lddat, ipiv, la_queue );
+
+        // apply pivots to previous panels, and update the trailing matrix
+        // beyond the window, first the block column that enters it next.
+        magma_queue_wait_event( compute_queue, panel_event );
+        if ( j > 0 ) {
+            magmablas_zlaswp( j*nb, dAT(0,0), lddat, j*nb + 1, j*nb + nb, ipiv, 1, compute_queue );
+        }
+        c0 = c1;
+        c1 = min( c0 + nb, n );
+        if ( c0 < n ) {
+            magma_zgetrf_update_cols( m, j*nb, nb, c0, c1,
+                                      dAT(0,0), lddat, ipiv, compute_queue );
+            magma_event_record( entering_event, compute_queue );
+            magma_zgetrf_update_cols( m, j*nb, nb, c1, n,
+                                      dAT(0,0), lddat, ipiv, compute_queue );
+        }
+    }
+
+    if ( nb0 > 0 ) {
+        // do the cpu part
+        magma_event_sync( download_event );
+        rows = m - s*nb;
+        cpu_time = magma_wtime();
+        lapackf77_zgetrf( &rows, &nb0, work, &ldwork, ipiv+s*nb, &iinfo );
+        magma_stats_cpu( magma_wtime() - cpu_time );
+        if ( *info == 0 && iinfo > 0 )
+            *info = iinfo + s*nb;
+
+        for( i=s*nb; i < s*nb + nb0; ++i ) {
+            ipiv[i] += s*nb;
+        }
+
+        // upload s-th panel
+        magma_zsetmatrix_async( rows, nb0, work(0), ldwork, dAP(0,0), maxm, la_queue, NULL );
+        magmablas_ztranspose( rows, nb0, dAP(0,0), maxm, dAT(s,s), lddat, la_queue );
+        magma_event_record( panel_event, la_queue );
+
+        // the compute queue now owns everything; if m < n,
+        // the columns right of the panel still need U12
+        magma_queue_wait_event( compute_queue, panel_event );
+        magmablas_zlaswp( s*nb, dAT(0,0), lddat, s*nb + 1, s*nb + nb0, ipiv, 1, compute_queue );
+        magma_zgetrf_update_cols( m, s*nb, nb0, s*nb + nb0, n,
+                                  dAT(0,0), lddat, ipiv, compute_queue );
+    }
+    else {
+        magma_event_record( sync_event, la_queue );
+        magma_queue_wait_event( compute_queue, sync_event );
+    }
+
+    // undo transpose
+    if ( dA == dAT ) {
+        magmablas_ztranspose_inplace( m, dAT(0,0), lddat, compute_queue );
+    }
+    else {
+        magmablas_ztranspose( n, m, dAT(0,0), lddat, dA(0,0), ldda, compute_queue );
+    }
+
+    magma_queue_sync( compute_queue );
+    magma_queue_sync( la_queue );
+
+    magma_event_destroy( download_event );
+    magma_event_destroy( panel_event    );
+    magma_event_destroy( entering_event );
+    magma_event_destroy( sync_event     );
+
+    if ( dA != dAT )
+        magma_free( dAT );
+    magma_free( dAP );
+    magma_free_pinned( work );
+
+    return *info;
+} /* magma_zgetrf_lookahead_gpu */
+
+#undef dAT
@@ -0,0 +1,240 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "common_magma.h"
+
+
+extern "C" magma_int_t
+magma_zgetrf_m(
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex *A, magma_int_t lda, magma_int_t *ipiv,
+    magma_queue_t queues[2],
+    magma_int_t *info)
+{
+/*  -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+    Purpose
+    =======
+    ZGETRF_M computes an LU factorization of a general M-by-N matrix A
+    using partial pivoting with row interchanges, for matrices that do
+    not fit in GPU memory (non-GPU-resident). The matrix stays in CPU
+    memory and the problem size is bounded by host memory only.
+
+    The factorization has the form
+       A = P * L * U
+    where P is a permutation matrix, L is lower triangular with unit
+    diagonal elements (lower trapezoidal if m > n), and U is upper
+    triangular (upper trapezoidal if m < n).
+
+    This is a left-looking algorithm over big block columns of width NB,
+    which is sized to fit the GPU memory reported by magma_queue_meminfo
+    and may be reduced by setting $MAGMA_NGR_NB. For each big block
+    column, the CPU applies earlier row interchanges and sends it to a
+    GPU window; the factored L columns to its left are streamed through
+    two GPU buffers in blocks of nb columns, so the transfer of one block
+    on queues[1] overlaps the triangular solve and GEMM update with the
+    previous block on queues[0]. The window is then factored by
+    magma_zgetrf_gpu, copied back, and its row interchanges are applied
+    to the L columns on the CPU.
+
+    magma_zgetrf calls this routine when A does not fit in GPU memory.
+
+    Arguments
+    =========
+    M       (input) INTEGER
+            The number of rows of the matrix A.  M >= 0.
+
+    N       (input) INTEGER
+            The number of columns of the matrix A.  N >= 0.
+
+    A       (input/output) COMPLEX_16 array, dimension (LDA,N)
+            On entry, the M-by-N matrix to be factored.
+            On exit, the factors L and U from the factorization
+            A = P*L*U; the unit diagonal elements of L are not stored.
+
+            Higher performance is achieved if A is in pinned memory, e.g.
+            allocated using magma_malloc_pinned.
+
+    LDA     (input) INTEGER
+            The leading dimension of the array A.  LDA >= max(1,M).
+
+    IPIV    (output) INTEGER array, dimension (min(M,N))
+            The pivot indices; for 1 <= i <= min(M,N), row i of the
+            matrix was interchanged with row IPIV(i).
+
+    QUEUES  (input) magma_queue_t array, dimension (2)
+            Queues on the same device. queues[0] executes the updates and
+            factorization; queues[1] streams the L blocks.
+
+    INFO    (output) INTEGER
+            = 0:  successful exit
+            < 0:  if INFO = -i, the i-th argument had an illegal value
+                  or another error occured, such as memory allocation failed.
+            > 0:  if INFO = i, U(i,i) is exactly zero. The factorization
+                  has been completed, but the factor U is exactly
+                  singular, and division by zero will occur if it is used
+                  to solve a system of equations.
+
+    =====================================================================    */
+
+    #define  A(i_, j_) (A + (i_) + (j_)*lda)
+    #define dW(i_, j_)  dW,       (i_) + (j_)*ldda
+    #define dL(k_, i_)  dL[(k_)], (i_)
+
+    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    magma_int_t ione = 1;
+
+    magmaDoubleComplex_ptr dW, dL[2] = { NULL, NULL };
+    magma_event_t load_event[2], done_event[2];
+    magma_int_t nb, NB, ldda, iinfo;
+    magma_int_t j, jb, jrows, jpiv, k, kb, kk, i1, i2;
+
+    magma_queue_t compute_queue  = queues[0];
+    magma_queue_t transfer_queue = queues[1];
+
+    *info = 0;
+
+    if (m < 0)
+        *info = -1;
+    else if (n < 0)
+        *info = -2;
+    else if (lda < max(1,m))
+        *info = -4;
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    /* Quick return if possible */
+    if (m == 0 || n == 0)
+        return *info;
+
+    nb     = magma_get_zgetrf_nb(m);
+    ldda   = magma_roundup( m, 32 );
+
+    /* Size the window from the device memory, which magma_queue_meminfo
+       returns in units of 16 bytes. Besides the window, the GPU holds the
+       two L buffers, and magma_zgetrf_gpu needs about a window and a panel
+       more for its transposed copy. */
+    double totalMem = 16. * magma_queue_meminfo( compute_queue ) / sizeof(magmaDoubleComplex);
+    NB = (magma_int_t)(0.8*totalMem/ldda - 3*nb) / 2;
+    const char* ngr_nb_char = getenv("MAGMA_NGR_NB");
+    if ( ngr_nb_char != NULL )
+        NB = min( NB, atoi(ngr_nb_char) );
+    NB = max( nb, (NB / nb) * nb );
+    NB = min( NB, magma_roundup( n, nb ));
+
+    /* the window may exceed the largest single allocation; halve it until it fits */
+    while( MAGMA_SUCCESS != magma_zmalloc( &dW, ldda*NB )) {
+        if ( NB == nb ) {
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+        NB = max( nb, (NB / (2*nb)) * nb );
+    }
+    if ( NB < n ) {
+        if ( MAGMA_SUCCESS != magma_zmalloc( &dL[0], ldda*nb )) {
+            magma_free( dW );
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+        if ( MAGMA_SUCCESS != magma_zmalloc( &dL[1], ldda*nb )) {
+            magma_free( dL[0] );
+            magma_free( dW );
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+    }
+
+    magma_event_create( &load_event[0] );
+    magma_event_create( &load_event[1] );
+    magma_event_create( &done_event[0] );
+    magma_event_create( &done_event[1] );
+
+    for( j = 0; j < n; j += NB ) {
+        jb    = min( NB, n-j );
+        jrows = m - j;           // rows of the window still to factor
+        jpiv  = min( j, m );     // pivots computed so far
+
+        /* apply earlier row interchanges to the window's columns, then send it */
+        if ( jpiv > 0 )
+            lapackf77_zlaswp( &jb, A(0,j), &lda, &ione, &jpiv, ipiv, &ione );
+        magma_zsetmatrix( m, jb, A(0,j), lda, dW(0,0), ldda, compute_queue );
+
+        /* left-looking update with the L columns 0:jpiv, in blocks of nb,
+           double buffered: block kk+1 is sent while block kk is applied */
+        for( k = 0, kk = 0; k < jpiv; k += nb, ++kk ) {
+            kb = min( nb, jpiv-k );
+            if ( kk >= 2 ) {
+                // buffer is free once the update two blocks ago is done
+                magma_queue_wait_event( transfer_queue, done_event[kk%2] );
+            }
+            magma_zsetmatrix_async( m-k, kb, A(k,k), lda, dL(kk%2, 0), ldda,
+                                    transfer_queue, NULL );
+            magma_event_record( load_event[kk%2], transfer_queue );
+
+            magma_queue_wait_event( compute_queue, load_event[kk%2] );
+            magma_ztrsm( MagmaLeft, MagmaLower, MagmaNoTrans, MagmaUnit,
+                         kb, jb,
+                         c_one, dL(kk%2, 0), ldda,
+                                dW(k, 0),    ldda, compute_queue );
+            if ( m-k-kb > 0 ) {
+                magma_zgemm( MagmaNoTrans, MagmaNoTrans,
+                             m-k-kb, jb, kb,
+                             c_neg_one, dL(kk%2, kb), ldda,
+                                        dW(k,    0),  ldda,
+                             c_one,     dW(k+kb, 0),  ldda, compute_queue );
+            }
+            magma_event_record( done_event[kk%2], compute_queue );
+        }
+
+        /* factor the part of the window below the diagonal */
+        if ( jrows > 0 ) {
+            magma_zgetrf_gpu( jrows, jb, dW(j, 0), ldda, ipiv + j,
+                              compute_queue, &iinfo );
+            if ( iinfo > 0 && *info == 0 )
+                *info = iinfo + j;
+            else if ( iinfo < 0 ) {
+                *info = iinfo;
+                break;
+            }
+            for( i1 = j; i1 < j + min( jrows, jb ); ++i1 ) {
+                ipiv[i1] += j;
+            }
+        }
+        magma_zgetmatrix( m, jb, dW(0,0), ldda, A(0,j), lda, compute_queue );
+
+        /* apply the window's row interchanges to the L columns on its left */
+        if ( jrows > 0 && j > 0 ) {
+            i1 = j + 1;
+            i2 = j + min( jrows, jb );
+            lapackf77_zlaswp( &j, A(0,0), &lda, &i1, &i2, ipiv, &ione );
+        }
+    }
+    magma_queue_sync( transfer_queue );
+
+    magma_event_destroy( load_event[0] );
+    magma_event_destroy( load_event[1] );
+    magma_event_destroy( done_event[0] );
+    magma_event_destroy( done_event[1] );
+
+    if ( dL[0] != NULL ) {
+        magma_free( dL[0] );
+        magma_free( dL[1] );
+    }
+    magma_free( dW );
+
+    return *info;
+} /* magma_zgetrf_m */
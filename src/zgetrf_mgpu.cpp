@@ -159,8 +159,13 @@ magma_zgetrf_mgpu(
 
             magmablas_ztranspose( m, n_local[d], d_lA[d], 0, ldda, d_lAT[d], 0, lddat, queues[2*d+1] );
         }
+        /* transposes done before the factorization uses both queues */
         for( d=0; d < ngpu; d++ ) {
-            magma_queue_sync(queues[2*d+1]);
+            magma_event_t event;
+            magma_event_create( &event );
+            magma_event_record( event, queues[2*d+1] );
+            magma_queue_wait_event( queues[2*d], event );
+            magma_event_destroy( event );
         }
 
         /* cpu workspace */
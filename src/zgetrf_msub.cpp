@@ -11,11 +11,6 @@
 #include <math.h>
 #include "common_magma.h"
 
-#define USE_PINNED_CLMEMORY
-#ifdef  USE_PINNED_CLMEMORY
-extern cl_context gContext;
-#endif
-
 extern "C" magma_int_t
 magma_zgetrf_msub(
     magma_trans_t trans, magma_int_t num_subs, magma_int_t num_gpus, 
@@ -201,20 +196,18 @@ magma_zgetrf_msub(
             }
         }
         if (trans == MagmaNoTrans) {
+            /* transposes done before the factorization uses both queues */
             for (d=0; d < num_gpus; d++){
-                magma_queue_sync(queues[2*d+1]);
+                magma_event_t event;
+                magma_event_create( &event );
+                magma_event_record( event, queues[2*d+1] );
+                magma_queue_wait_event( queues[2*d], event );
+                magma_event_destroy( event );
             }
         }
 
-        /* cpu workspace */
-        #ifdef USE_PINNED_CLMEMORY
-        cl_mem buffer = clCreateBuffer(gContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sizeof(magmaDoubleComplex)*maxm*nb*(1+num_gpus), NULL, NULL);
-        for (d=0; d < num_gpus; d++) {
-            work = (magmaDoubleComplex*)clEnqueueMapBuffer(queues[2*d], buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0,
-                                                           sizeof(magmaDoubleComplex)*maxm*nb*(1+num_gpus), 0, NULL, NULL, NULL);
-        }
-        #else
-        if (MAGMA_SUCCESS != magma_zmalloc_cpu( &work, maxm*nb*(1+num_gpus) )) {
+        /* cpu workspace, pinned */
+        if (MAGMA_SUCCESS != magma_zmalloc_pinned( &work, maxm*nb*(1+num_gpus) )) {
             for(d=0; d < num_gpus; d++ ) magma_free( d_panel[d] );
             for(d=0; d < tot_subs; d++ ) {
                 if( d_lAT[d] != d_lA[d] ) magma_free( d_lAT[d] );
@@ -222,7 +215,6 @@ magma_zgetrf_msub(
             *info = MAGMA_ERR_HOST_ALLOC;
             return *info;
         }
-        #endif
 
         /* calling multi-gpu interface with allocated workspaces and streams */
         magma_zgetrf2_msub(num_subs, num_gpus, m, n, nb, 0, d_lAT, 0, lddat, ipiv, d_lAP, d_panel, 0, work, maxm,
@@ -253,14 +245,7 @@ magma_zgetrf_msub(
                 d_lAT[d] = NULL;
             }
         }
-        #ifdef USE_PINNED_CLMEMORY
-        for (d=0; d < num_gpus; d++) {
-            clEnqueueUnmapMemObject(queues[2*d], buffer, work, 0, NULL, NULL);
-        }
-        clReleaseMemObject( buffer );
-        #else
-        magma_free_cpu( work );
-        #endif
+        magma_free_pinned( work );
         work = NULL;
       }
       return *info;       
@@ -0,0 +1,424 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <deque>
+#include <vector>
+
+#include "common_magma.h"
+#include "thread_queue.hpp"
+#include "trace.h"
+#include "magma_stats.h"
+
+// The matrix is factored transposed, as in magma_zgetrf_mgpu: d_lAT[d] holds
+// device d's block columns as rows, and block (i,j) of A, for j on device
+// j % ngpu, is at d_lAT[d] offset (j/ngpu)*nb + i*nb*lddat.
+//
+// Each device gets panel k, transposed, in its ring slot k % nbuf of d_lP.
+// Row interchanges of panel k are applied to the block columns right of it
+// by the updates, and to those left of it after the factorization.
+
+// number of ring slots; panels can be this many columns ahead of updates
+const magma_int_t zgetrf_tile_nbuf = 3;
+
+struct zgetrf_tile_data
+{
+    magma_int_t             ngpu, m, n, nb, maxm, lddat;
+    magma_int_t             n_local[ MagmaMaxGPUs ];
+    magmaDoubleComplex_ptr  d_lAT[ MagmaMaxGPUs ];
+    magmaDoubleComplex_ptr  d_lP [ MagmaMaxGPUs ];  // ring of transposed panels, then panel
+    magmaDoubleComplex*     hW;                     // panel on the host
+    magma_int_t*            ipiv;
+    magma_queue_pool*       pool;
+    magma_int_t*            info;
+
+    // offset in d_lAT[j % ngpu] of block (i,j)
+    size_t offset( magma_int_t i, magma_int_t j ) const
+    {
+        return (j / ngpu)*nb + i*nb*lddat;
+    }
+
+    // offset in d_lP[d] of slot for panel k
+    size_t slot_offset( magma_int_t k ) const
+    {
+        return (k % zgetrf_tile_nbuf)*nb*maxm;
+    }
+
+    // offset in d_lP[d] of panel in column major, as sent to and from the host
+    size_t work_offset() const
+    {
+        return zgetrf_tile_nbuf*nb*maxm;
+    }
+
+    // number of pivots of panel k
+    magma_int_t npivots( magma_int_t k ) const
+    {
+        return min( m - k*nb, min( nb, n - k*nb ));
+    }
+
+    // whether device d has block columns j or right of it
+    bool has_cols( magma_int_t d, magma_int_t j ) const
+    {
+        return ((j + ngpu - 1 - d) / ngpu)*nb < n_local[d];
+    }
+};
+
+
+// ----------------------------------------
+// Factors panel k on the CPU, and sends it to devices with block columns
+// right of it.
+class zgetrf_tile_panel_task: public magma_task
+{
+public:
+    zgetrf_tile_panel_task( zgetrf_tile_data* data, magma_int_t k ):
+        m_data( data ), m_k( k )
+    {}
+
+    virtual void run()
+    {
+        zgetrf_tile_data* data = m_data;
+        magma_int_t k    = m_k;
+        magma_int_t nb   = data->nb;
+        magma_int_t maxm = data->maxm;
+        magma_int_t rows = data->m - k*nb;
+        magma_int_t kb   = min( nb, data->n - k*nb );
+        magma_int_t dk   = k % data->ngpu;
+        size_t offset    = data->offset( k, k );
+        magma_int_t i, iinfo;
+
+        magma_queue_t queue = data->pool->acquire( dk );
+        magmablas_ztranspose( kb, rows, data->d_lAT[dk], offset, data->lddat,
+                              data->d_lP[dk], data->work_offset(), maxm, queue );
+        magma_zgetmatrix( rows, kb, data->d_lP[dk], data->work_offset(), maxm, data->hW, maxm, queue );
+        data->pool->release( dk, queue );
+
+        trace_cpu_start( "getrf", "getrf" );
+        lapackf77_zgetrf( &rows, &kb, data->hW, &maxm, data->ipiv + k*nb, &iinfo );
+        trace_cpu_end();
+        if ( *data->info == 0 && iinfo > 0 ) {
+            *data->info = iinfo + k*nb;
+        }
+        for( i = k*nb; i < k*nb + data->npivots( k ); ++i ) {
+            data->ipiv[i] += k*nb;
+        }
+
+        for( magma_int_t d = 0; d < data->ngpu; ++d ) {
+            if ( d == dk || data->has_cols( d, k+1 )) {
+                queue = data->pool->acquire( d );
+                magma_zsetmatrix( rows, kb, data->hW, maxm, data->d_lP[d], data->work_offset(), maxm, queue );
+                if ( d == dk ) {
+                    magmablas_ztranspose( rows, kb, data->d_lP[d], data->work_offset(), maxm,
+                                          data->d_lAT[d], offset, data->lddat, queue );
+                }
+                magmablas_ztranspose( rows, kb, data->d_lP[d], data->work_offset(), maxm,
+                                      data->d_lP[d], data->slot_offset( k ), nb, queue );
+                magma_queue_sync( queue );
+                data->pool->release( d, queue );
+            }
+        }
+    }
+
+private:
+    zgetrf_tile_data* m_data;
+    magma_int_t       m_k;
+};
+
+
+// ----------------------------------------
+// Updates block column j with panel k: applies the panel's row interchanges,
+// solves for U(k,j), and updates the blocks below it.
+class zgetrf_tile_update_task: public magma_task
+{
+public:
+    zgetrf_tile_update_task( zgetrf_tile_data* data, magma_int_t j, magma_int_t k ):
+        m_data( data ), m_j( j ), m_k( k )
+    {}
+
+    virtual void run()
+    {
+        zgetrf_tile_data* data = m_data;
+        magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+        magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+        magma_int_t j     = m_j;
+        magma_int_t k     = m_k;
+        magma_int_t nb    = data->nb;
+        magma_int_t lddat = data->lddat;
+        magma_int_t jb    = min( nb, data->n - j*nb );
+        magma_int_t kpiv  = data->npivots( k );
+        magma_int_t rows  = data->m - k*nb;
+        magma_int_t d     = j % data->ngpu;
+        magmaDoubleComplex_ptr dAT = data->d_lAT[d];
+        size_t offset = data->offset( k, j );
+
+        magma_queue_t queue = data->pool->acquire( d );
+        magmablas_zlaswp( jb, dAT, data->offset( 0, j ), lddat,
+                          k*nb + 1, k*nb + kpiv, data->ipiv, 1, queue );
+        data->pool->lock_kernels( "trsm" );
+        magma_ztrsm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaUnit,
+                     jb, kpiv, c_one,
+                     data->d_lP[d], data->slot_offset( k ), nb,
+                     dAT, offset, lddat, queue );
+        data->pool->unlock_kernels( "trsm" );
+        if ( rows > kpiv ) {
+            data->pool->lock_kernels( "gemm" );
+            magma_zgemm( MagmaNoTrans, MagmaNoTrans,
+                         jb, rows - kpiv, kpiv,
+                         c_neg_one, dAT, offset, lddat,
+                                    data->d_lP[d], data->slot_offset( k ) + kpiv*nb, nb,
+                         c_one,     dAT, offset + kpiv*lddat, lddat, queue );
+            data->pool->unlock_kernels( "gemm" );
+        }
+        magma_queue_sync( queue );
+        data->pool->release( d, queue );
+    }
+
+private:
+    zgetrf_tile_data* m_data;
+    magma_int_t       m_j, m_k;
+};
+
+
+/**
+    Purpose
+    -------
+    ZGETRF_TILE computes an LU factorization of a general M-by-N matrix A
+    distributed over multiple GPUs, using partial pivoting with row
+    interchanges.
+
+    The factorization has the form
+        A = P * L * U
+    where P is a permutation matrix, L is lower triangular with unit
+    diagonal elements (lower trapezoidal if m > n), and U is upper
+    triangular (upper trapezoidal if m < n).
+
+    This is a tile version of the algorithm: the factorization is a DAG of
+    tasks run by a work-stealing magma_thread_queue. Panels are factored on
+    the CPU; updates of each block column run on the GPUs as soon as their
+    panel and the previous update of that column are done, so the next
+    panel starts while the rest of the trailing matrix is updated.
+    The data distribution is that of magma_zgetrf_mgpu.
+
+    Arguments
+    ---------
+    @param[in]
+    ngpu    INTEGER
+            Number of GPUs to use. ngpu > 0.
+
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrix A.  M >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrix A.  N >= 0.
+
+    @param[in,out]
+    d_lA    COMPLEX_16 array of pointers on the GPU, dimension (ngpu)
+            On entry, the M-by-N matrix A distributed over GPUs,
+            block-column cyclic with block size magma_get_zgetrf_nb(m).
+            On exit, the factors L and U from the factorization
+            A = P*L*U; the unit diagonal elements of L are not stored.
+
+    @param[in]
+    dlA_offset INTEGER
+            Offset of the local matrices in d_lA.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of the local arrays.  LDDA >= max(1,M).
+
+    @param[out]
+    ipiv    INTEGER array, dimension (min(M,N))
+            The pivot indices; for 1 <= i <= min(M,N), row i of the
+            matrix was interchanged with row IPIV(i).
+
+    @param[in]
+    queues  magma_queue_t array, dimension (2*ngpu)
+            Queues 2*d and 2*d+1 are on GPU d.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+                  or another error occured, such as memory allocation failed.
+      -     > 0:  if INFO = i, U(i,i) is exactly zero. The factorization
+                  has been completed, but the factor U is exactly
+                  singular, and division by zero will occur if it is used
+                  to solve a system of equations.
+
+    @ingroup magma_zgesv_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zgetrf_tile_mgpu(
+    magma_int_t ngpu,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex_ptr *d_lA, size_t dlA_offset, magma_int_t ldda,
+    magma_int_t *ipiv,
+    magma_queue_t *queues,
+    magma_int_t *info )
+{
+    magma_int_t d, d2, j, jl, k, nb, nt, kt, mindim, k1;
+    zgetrf_tile_data data;
+
+    MAGMA_STATS_ROUTINE();
+
+    /* Check arguments */
+    *info = 0;
+    if ( ngpu < 1 || ngpu > MagmaMaxGPUs )
+        *info = -1;
+    else if ( m < 0 )
+        *info = -2;
+    else if ( n < 0 )
+        *info = -3;
+    else if ( ldda < max( 1, m ))
+        *info = -6;
+    if ( *info != 0 ) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    /* Quick return if possible */
+    if ( m == 0 || n == 0 )
+        return *info;
+
+    nb = magma_get_zgetrf_nb( m );
+    if ( nb <= 1 || nb >= n ) {
+        /* Use the CPU code of magma_zgetrf_mgpu. */
+        return magma_zgetrf_mgpu( ngpu, m, n, d_lA, dlA_offset, ldda, ipiv, queues, info );
+    }
+
+    nt     = magma_ceildiv( n, nb );
+    mindim = min( m, n );
+    kt     = magma_ceildiv( mindim, nb );
+    if ( ngpu > nt ) {
+        printf( " * too many GPUs for the matrix size, using %d GPUs\n", (int) ngpu );
+        *info = -1;
+        return *info;
+    }
+
+    data.ngpu  = ngpu;
+    data.m     = m;
+    data.n     = n;
+    data.nb    = nb;
+    data.maxm  = magma_roundup( m, 32 );
+    data.lddat = magma_roundup( magma_ceildiv( nt, ngpu )*nb, 32 );
+    data.ipiv  = ipiv;
+    data.info  = info;
+
+    /* allocate workspace for each GPU */
+    for( d = 0; d < ngpu; ++d ) {
+        data.n_local[d] = ((n/nb)/ngpu)*nb;
+        if ( d < (n/nb) % ngpu )
+            data.n_local[d] += nb;
+        else if ( d == (n/nb) % ngpu )
+            data.n_local[d] += n % nb;
+
+        if ( MAGMA_SUCCESS != magma_zmalloc( &data.d_lAT[d], data.lddat*data.maxm )) {
+            for( d2 = 0; d2 < d; ++d2 ) {
+                magma_free( data.d_lAT[d2] );
+                magma_free( data.d_lP[d2]  );
+            }
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+        /* panel ring followed by the column-major panel */
+        if ( MAGMA_SUCCESS != magma_zmalloc( &data.d_lP[d], (zgetrf_tile_nbuf + 1)*nb*data.maxm )) {
+            for( d2 = 0; d2 < d; ++d2 ) {
+                magma_free( data.d_lAT[d2] );
+                magma_free( data.d_lP[d2]  );
+            }
+            magma_free( data.d_lAT[d] );
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+    }
+    if ( MAGMA_SUCCESS != magma_zmalloc_pinned( &data.hW, data.maxm*nb )) {
+        for( d = 0; d < ngpu; ++d ) {
+            magma_free( data.d_lAT[d] );
+            magma_free( data.d_lP[d]  );
+        }
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+
+    for( d = 0; d < ngpu; ++d ) {
+        magmablas_ztranspose( m, data.n_local[d], d_lA[d], dlA_offset, ldda,
+                              data.d_lAT[d], 0, data.lddat, queues[2*d+1] );
+    }
+    for( d = 0; d < ngpu; ++d ) {
+        magma_queue_sync( queues[2*d+1] );
+    }
+
+    /* one thread for panels, and one for each queue */
+    magma_queue_pool pool( ngpu, 2, queues );
+    data.pool = &pool;
+
+    magma_thread_queue tasks;
+    tasks.launch( 2*ngpu + 1 );
+
+    /* latest task updating block column j is update[j] */
+    std::vector< magma_task* > update( nt, (magma_task*) NULL );
+    std::vector< magma_task* > done( kt, (magma_task*) NULL );
+    std::vector< magma_task* > deps;
+
+    for( k = 0; k < kt; ++k ) {
+        /* factor panel, after its updates and after the slot it sends to
+         * is free */
+        deps.clear();
+        deps.push_back( update[k] );
+        if ( k >= zgetrf_tile_nbuf )
+            deps.push_back( done[ k - zgetrf_tile_nbuf ] );
+        magma_task* panel = new zgetrf_tile_panel_task( &data, k );
+        tasks.push_task( panel, 3*nt, deps.size(), &deps[0] );
+
+        /* updates of block columns right of it; the next one first */
+        std::vector< magma_task* > readers;
+        for( j = k+1; j < nt; ++j ) {
+            deps.clear();
+            deps.push_back( panel );
+            deps.push_back( update[j] );
+            update[j] = new zgetrf_tile_update_task( &data, j, k );
+            tasks.push_task( update[j], (j == k+1 ? 2*nt : nt - (j - k)),
+                             deps.size(), &deps[0] );
+            readers.push_back( update[j] );
+        }
+
+        /* slot k % nbuf is free once panel k's updates are done */
+        if ( k + zgetrf_tile_nbuf < kt ) {
+            done[k] = new magma_empty_task();
+            tasks.push_task( done[k], 0, readers.size(), &readers[0] );
+        }
+    }
+    tasks.sync();
+    tasks.quit();
+
+    for( d = 0; d < ngpu; ++d ) {
+        /* row interchanges of later panels, left of them */
+        for( jl = 0; jl*nb < data.n_local[d]; ++jl ) {
+            j  = jl*ngpu + d;
+            k1 = (j+1)*nb + 1;
+            if ( k1 <= mindim ) {
+                magmablas_zlaswp( min( nb, n - j*nb ), data.d_lAT[d], jl*nb, data.lddat,
+                                  k1, mindim, ipiv, 1, queues[2*d+1] );
+            }
+        }
+        /* save on output */
+        magmablas_ztranspose( data.n_local[d], m, data.d_lAT[d], 0, data.lddat,
+                              d_lA[d], dlA_offset, ldda, queues[2*d+1] );
+    }
+
+    /* clean up */
+    for( d = 0; d < ngpu; ++d ) {
+        magma_queue_sync( queues[2*d+1] );
+        magma_free( data.d_lAT[d] );
+        magma_free( data.d_lP[d]  );
+    }
+    magma_free_pinned( data.hW );
+
+    return *info;
+} /* magma_zgetrf_tile_mgpu */
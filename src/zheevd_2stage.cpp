@@ -0,0 +1,393 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Stan Tomov
+       @author Raffaele Solca
+       @author Mark Gates
+
+       @precisions normal z -> c
+
+*/
+#include "common_magma.h"
+#include "magma_timer.h"
+
+#define PRECISION_z
+
+/**
+    Purpose
+    -------
+    ZHEEVD_2STAGE computes all eigenvalues and, optionally, eigenvectors of
+    a complex Hermitian matrix A, like magma_zheevd, but reduces A to
+    tridiagonal form in two stages:
+      1. magma_zhetrd_he2hb reduces A to band form, with level 3 BLAS on
+         the device;
+      2. magma_zhetrd_hb2st reduces the band to tridiagonal form by a
+         bulge chase, in several CPU threads.
+    The eigenvectors of the tridiagonal matrix, from the divide and conquer
+    magma_zstedx, are back-transformed on the device: by magma_zbulge_back
+    for the second stage, then by magma_zunmqr_gpu_2stages for the first.
+
+    This avoids the level 2 BLAS zhemv of magma_zhetrd, which is memory
+    bound, at the cost of the second back-transformation.
+
+    Arguments
+    ---------
+    @param[in]
+    jobz    magma_vec_t
+      -     = MagmaNoVec:  Compute eigenvalues only;
+      -     = MagmaVec:    Compute eigenvalues and eigenvectors.
+
+    @param[in]
+    uplo    magma_uplo_t
+      -     = MagmaUpper:  Upper triangle of A is stored;
+      -     = MagmaLower:  Lower triangle of A is stored.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix A.  N >= 0.
+
+    @param[in,out]
+    A       COMPLEX_16 array, dimension (LDA, N)
+            On entry, the Hermitian matrix A.  If UPLO = MagmaUpper, the
+            leading N-by-N upper triangular part of A contains the
+            upper triangular part of the matrix A.  If UPLO = MagmaLower,
+            the leading N-by-N lower triangular part of A contains
+            the lower triangular part of the matrix A.
+            On exit, if JOBZ = MagmaVec, then if INFO = 0, A contains the
+            orthonormal eigenvectors of the matrix A.
+            If JOBZ = MagmaNoVec, then on exit the contents of A are
+            destroyed.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,N).
+
+    @param[out]
+    w       DOUBLE PRECISION array, dimension (N)
+            If INFO = 0, the eigenvalues in ascending order.
+
+    @param[out]
+    work    (workspace) COMPLEX_16 array, dimension (MAX(1,LWORK))
+            On exit, if INFO = 0, WORK[0] returns the optimal LWORK.
+
+    @param[in]
+    lwork   INTEGER
+            The length of the array WORK. With NB = magma_get_zbulge_nb(N),
+            LDTAU = ceil(N/NB), and N > 1:
+            If JOBZ = MagmaNoVec, LWORK >= N + 2*N*NB + NB**2.
+            If JOBZ = MagmaVec,   LWORK >= N + N*NB + N*(N-1)/2 + N*LDTAU
+                                           + max( N**2, (N + NB)*NB ).
+    \n
+            If LWORK = -1, then a workspace query is assumed; the routine
+            only calculates the optimal sizes of the WORK, RWORK and
+            IWORK arrays, returns these values as the first entries of
+            the WORK, RWORK and IWORK arrays, and no error message
+            related to LWORK or LRWORK or LIWORK is issued by XERBLA.
+
+    @param[out]
+    rwork   (workspace) DOUBLE PRECISION array, dimension (LRWORK)
+            On exit, if INFO = 0, RWORK[0] returns the optimal LRWORK.
+
+    @param[in]
+    lrwork  INTEGER
+            The dimension of the array RWORK.
+            If N <= 1,                    LRWORK >= 1.
+            If JOBZ = MagmaNoVec and N > 1, LRWORK >= N.
+            If JOBZ = MagmaVec   and N > 1, LRWORK >= 1 + 5*N + 2*N**2.
+    \n
+            If LRWORK = -1, then a workspace query is assumed; see LWORK.
+
+    @param[out]
+    iwork   (workspace) INTEGER array, dimension (MAX(1,LIWORK))
+            On exit, if INFO = 0, IWORK[0] returns the optimal LIWORK.
+
+    @param[in]
+    liwork  INTEGER
+            The dimension of the array IWORK.
+            If N <= 1,                    LIWORK >= 1.
+            If JOBZ = MagmaNoVec and N > 1, LIWORK >= 1.
+            If JOBZ = MagmaVec   and N > 1, LIWORK >= 3 + 5*N.
+    \n
+            If LIWORK = -1, then a workspace query is assumed; see LWORK.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+      -     > 0:  if INFO = i and JOBZ = MagmaNoVec, then the algorithm
+                  failed to converge; i off-diagonal elements of an
+                  intermediate tridiagonal form did not converge to zero;
+                  if INFO = i and JOBZ = MagmaVec, then the algorithm failed
+                  to compute an eigenvalue while working on the submatrix
+                  lying in rows and columns INFO/(N+1) through
+                  mod(INFO,N+1).
+
+    @ingroup magma_zheev_2stage
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zheevd_2stage(
+    magma_vec_t jobz, magma_uplo_t uplo,
+    magma_int_t n,
+    magmaDoubleComplex *A, magma_int_t lda,
+    double *w,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    double *rwork, magma_int_t lrwork,
+    magma_int_t *iwork, magma_int_t liwork,
+    magma_queue_t queue,
+    magma_int_t *info)
+{
+    #define A(i_, j_)  (A + (i_) + (j_)*lda)
+    #define dZ(i_, j_)  dZ, ((i_) + (j_)*lddz)
+
+    const char* uplo_ = lapack_uplo_const( uplo );
+    const char* jobz_ = lapack_vec_const( jobz );
+    magma_int_t ione  = 1;
+    magma_int_t izero = 0;
+    double d_one = 1.;
+
+    magma_int_t wantz  = (jobz == MagmaVec);
+    magma_int_t lower  = (uplo == MagmaLower);
+    magma_int_t lquery = (lwork == -1 || lrwork == -1 || liwork == -1);
+
+    *info = 0;
+    if (! (wantz || (jobz == MagmaNoVec))) {
+        *info = -1;
+    } else if (! (lower || (uplo == MagmaUpper))) {
+        *info = -2;
+    } else if (n < 0) {
+        *info = -3;
+    } else if (lda < max(1,n)) {
+        *info = -5;
+    }
+
+    magma_int_t nthread = magma_get_parallel_numthreads();
+    magma_int_t nb      = magma_get_zbulge_nb( n, nthread );
+    magma_int_t Vblksiz = magma_zbulge_get_Vblksiz( n, nb );
+    magma_int_t ldt     = nb;
+    magma_int_t ldtau   = max( 1, magma_ceildiv( n, nb ));
+    magma_int_t lv2     = n*(n-1)/2;
+    magma_int_t ltau2   = ldtau*n;
+
+    magma_int_t lwmin, lrwmin, liwmin;
+    if ( n <= 1 ) {
+        lwmin  = 1;
+        lrwmin = 1;
+        liwmin = 1;
+    }
+    else if ( wantz ) {
+        lwmin  = n + n*nb + lv2 + ltau2 + max( n*n, (n + nb)*nb );
+        lrwmin = 1 + 5*n + 2*n*n;
+        liwmin = 3 + 5*n;
+    }
+    else {
+        lwmin  = n + n*nb + (n + nb)*nb;
+        lrwmin = n;
+        liwmin = 1;
+    }
+    // multiply by 1+eps to ensure length gets rounded up,
+    // if it cannot be exactly represented in floating point.
+    double one_eps = 1. + lapackf77_dlamch("Epsilon");
+    work[0]  = MAGMA_Z_MAKE( lwmin * one_eps, 0.);
+    rwork[0] = lrwmin * one_eps;
+    iwork[0] = liwmin;
+
+    if ((lwork < lwmin) && !lquery) {
+        *info = -8;
+    } else if ((lrwork < lrwmin) && ! lquery) {
+        *info = -10;
+    } else if ((liwork < liwmin) && ! lquery) {
+        *info = -12;
+    }
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+    else if (lquery) {
+        return *info;
+    }
+
+    /* Quick return if possible */
+    if (n == 0) {
+        return *info;
+    }
+
+    if (n == 1) {
+        w[0] = MAGMA_Z_REAL( *A(0,0) );
+        if (wantz) {
+            *A(0,0) = MAGMA_Z_ONE;
+        }
+        return *info;
+    }
+
+    /* Check if matrix is very small then just call LAPACK on CPU, no need for GPU */
+    if (n <= 128) {
+        lapackf77_zheevd( jobz_, uplo_, &n, A, &lda, w,
+                          work, &lwork, rwork, &lrwork,
+                          iwork, &liwork, info );
+        return *info;
+    }
+
+    /* Get machine constants. */
+    double safmin = lapackf77_dlamch("Safe minimum");
+    double eps    = lapackf77_dlamch("Precision");
+    double smlnum = safmin / eps;
+    double bignum = 1. / smlnum;
+    double rmin = magma_dsqrt(smlnum);
+    double rmax = magma_dsqrt(bignum);
+
+    /* Scale matrix to allowable range, if necessary. */
+    double anrm = lapackf77_zlanhe("M", uplo_, &n, A, &lda, rwork);
+    double sigma = 1.;
+    magma_int_t iscale = 0;
+    if (anrm > 0. && anrm < rmin) {
+        iscale = 1;
+        sigma = rmin / anrm;
+    } else if (anrm > rmax) {
+        iscale = 1;
+        sigma = rmax / anrm;
+    }
+    if (iscale == 1) {
+        lapackf77_zlascl( uplo_, &izero, &izero, &d_one, &sigma, &n, &n, A,
+                          &lda, info);
+    }
+
+    /* The first stage works on the lower triangle; copy an upper one there. */
+    if ( ! lower ) {
+        for( magma_int_t j = 0; j < n; ++j ) {
+            for( magma_int_t i = j+1; i < n; ++i ) {
+                *A(i,j) = MAGMA_Z_CNJG( *A(j,i) );
+            }
+        }
+    }
+
+    // rwork: e (n) + zstedx rwork (1 + 4n + 2n^2)  ==>  1 + 5n + 2n^2
+    magma_int_t inde   = 0;
+    magma_int_t indrwk = inde + n;
+    magma_int_t llrwk  = lrwork - indrwk;
+
+    // work: tau1 (n) + T1 (nb*n) + V2 (n(n-1)/2) + tau2 (ldtau*n) + Z (n^2);
+    // zhetrd_he2hb work ((n + nb)*nb) is in place of V2, tau2, Z, which
+    // are not needed until after it.
+    magma_int_t indtau1 = 0;
+    magma_int_t indT1   = indtau1 + n;
+    magma_int_t indV2   = indT1   + n*nb;
+    magma_int_t indtau2 = indV2   + lv2;
+    magma_int_t indZ    = indtau2 + ltau2;
+    magma_int_t indwrk  = indV2;
+    magma_int_t llwork  = lwork - indwrk;
+
+    magma_int_t iinfo;
+    magma_timer_t time, time_total;
+    timer_start( time_total );
+    timer_start( time );
+
+    magma_zhetrd_he2hb( MagmaLower, n, nb, A, lda, &work[indtau1],
+                        &work[indwrk], llwork, &work[indT1], ldt, queue, &iinfo );
+
+    timer_stop( time );
+    timer_printf( "time zhetrd_he2hb = %6.2f\n", time );
+    timer_start( time );
+
+    if ( wantz ) {
+        magma_zhetrd_hb2st( MagmaLower, n, nb, A, lda, w, &rwork[inde],
+                            &work[indV2], &work[indtau2], ldtau, wantz, &iinfo );
+    }
+    else {
+        magma_zhetrd_hb2st( MagmaLower, n, nb, A, lda, w, &rwork[inde],
+                            NULL, NULL, ldtau, wantz, &iinfo );
+    }
+
+    timer_stop( time );
+    timer_printf( "time zhetrd_hb2st = %6.2f\n", time );
+
+    /* For eigenvalues only, call DSTERF.  For eigenvectors, first call
+       ZSTEDX to generate the eigenvector matrix Z of the tridiagonal
+       matrix, then apply Q2 and Q1 to it on the device. */
+    if (! wantz) {
+        lapackf77_dsterf(&n, w, &rwork[inde], info);
+    }
+    else {
+        timer_start( time );
+
+        magmaDouble_ptr dwork;
+        if (MAGMA_SUCCESS != magma_dmalloc( &dwork, 3*n*(n/2 + 1) )) {
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+
+        magma_zstedx(MagmaRangeAll, n, 0., 0., 0, 0, w, &rwork[inde],
+                     &work[indZ], n, &rwork[indrwk],
+                     llrwk, iwork, liwork, dwork, queue, info);
+
+        magma_free( dwork );
+
+        timer_stop( time );
+        timer_printf( "time zstedx = %6.2f\n", time );
+        timer_start( time );
+
+        magma_int_t lddz = magma_roundup( n, 32 );
+        magmaDoubleComplex_ptr dZ, dV1;
+        if (MAGMA_SUCCESS != magma_zmalloc( &dZ, lddz*n )) {
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+        if (MAGMA_SUCCESS != magma_zmalloc( &dV1, lddz*(n - nb) )) {
+            magma_free( dZ );
+            *info = MAGMA_ERR_DEVICE_ALLOC;
+            return *info;
+        }
+
+        magma_zsetmatrix( n, n, &work[indZ], n, dZ(0,0), lddz, queue );
+        magma_zsetmatrix_async( n-nb, n-nb, A(nb,0), lda, dV1, 0, lddz, queue, NULL );
+
+        magma_zbulge_back( n, nb, n, Vblksiz, &work[indV2], &work[indtau2], ldtau,
+                           dZ(0,0), lddz, queue, &iinfo );
+
+        timer_stop( time );
+        timer_printf( "time zbulge_back = %6.2f\n", time );
+        timer_start( time );
+
+        magma_zunmqr_gpu_2stages( MagmaLeft, MagmaNoTrans, n-nb, n, n-nb,
+                                  dV1, 0, lddz, dZ(nb,0), lddz,
+                                  &work[indT1], ldt, nb, queue, &iinfo );
+
+        magma_zgetmatrix( n, n, dZ(0,0), lddz, A(0,0), lda, queue );
+
+        magma_free( dZ );
+        magma_free( dV1 );
+
+        timer_stop( time );
+        timer_printf( "time zunmqr_gpu_2stages + copy = %6.2f\n", time );
+    }
+
+    timer_stop( time_total );
+    timer_printf( "time zheevd_2stage total = %6.2f\n", time_total );
+
+    /* If matrix was scaled, then rescale eigenvalues appropriately. */
+    if (iscale == 1) {
+        magma_int_t imax;
+        if (*info == 0) {
+            imax = n;
+        } else {
+            imax = *info - 1;
+        }
+        double d__1 = 1. / sigma;
+        blasf77_dscal(&imax, &d__1, w, &ione);
+    }
+
+    work[0]  = MAGMA_Z_MAKE( lwmin * one_eps, 0.);  // round up
+    rwork[0] = lrwmin * one_eps;
+    iwork[0] = liwmin;
+
+    return *info;
+} /* magma_zheevd_2stage */
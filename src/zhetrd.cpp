@@ -197,6 +197,15 @@ magma_zhetrd(
     magmaDoubleComplex_ptr dwork = da;
     size_t dwork_offset = da_offset + (n)*ldda;
 
+    /* W is copied to the GPU for every panel, so stage it in pinned memory,
+       which magma_free_pinned caches, so later calls reuse it;
+       fall back to the user's workspace if pinned memory is unavailable. */
+    magmaDoubleComplex *hwork;
+    if (MAGMA_SUCCESS != magma_zmalloc_pinned( &hwork, ldwork*nb )) {
+        hwork = NULL;
+    }
+    magmaDoubleComplex *W = (hwork != NULL ? hwork : work);
+
     if (n < 2048)
         nx = n;
     else
@@ -220,11 +229,11 @@ magma_zhetrd(
                 magma_zgetmatrix( i+nb, nb, dA(0, i), ldda, A(0, i), lda, queue );
             
             magma_zlatrd(uplo, i+nb, nb, A(0, 0), lda, e, tau,
-                         work, ldwork, dA(0, 0), ldda, dwork, dwork_offset, lddwork, queue);
+                         W, ldwork, dA(0, 0), ldda, dwork, dwork_offset, lddwork, queue);
 
             /* Update the unreduced submatrix A(0:i-2,0:i-2), using an
                update of the form:  A := A - V*W' - W*V' */
-            magma_zsetmatrix( i + nb, nb, work, ldwork, dwork, dwork_offset, lddwork, queue );
+            magma_zsetmatrix( i + nb, nb, W, ldwork, dwork, dwork_offset, lddwork, queue );
 
             magma_zher2k(uplo, MagmaNoTrans, i, nb, c_neg_one,
                          dA(0, i), ldda, dwork, dwork_offset,
@@ -269,18 +278,18 @@ magma_zhetrd(
             #ifdef FAST_HEMV
             // unported
             magma_zlatrd2(uplo, n-i, nb, A(i, i), lda, &e[i],
-                         &tau[i], work, ldwork,
+                         &tau[i], W, ldwork,
                          dA(i, i), ldda,
                          dwork, lddwork, dwork2, n*n);
             #else
             magma_zlatrd(uplo, n-i, nb, A(i, i), lda, &e[i],
-                         &tau[i], work, ldwork,
+                         &tau[i], W, ldwork,
                          dA(i, i), ldda,
                          dwork, dwork_offset, lddwork, queue);
             #endif
             /* Update the unreduced submatrix A(i+ib:n,i+ib:n), using
                an update of the form:  A := A - V*W' - W*V' */
-            magma_zsetmatrix( n-i, nb, work, ldwork, dwork, dwork_offset, lddwork, queue );
+            magma_zsetmatrix( n-i, nb, W, ldwork, dwork, dwork_offset, lddwork, queue );
 
             magma_zher2k(MagmaLower, MagmaNoTrans, n-i-nb, nb, c_neg_one,
                          dA(i+nb, i), ldda,
@@ -308,6 +317,7 @@ magma_zhetrd(
     }
     
     magma_free( da );
+    magma_free_pinned( hwork );
     work[0] = MAGMA_Z_MAKE( lwkopt, 0 );
 
     return *info;
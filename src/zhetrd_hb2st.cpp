@@ -0,0 +1,408 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Mark Gates
+
+       @precisions normal z -> s d c
+
+*/
+#include "common_magma.h"
+
+#define PRECISION_z
+
+// Band matrix with the diagonal in row 0 of each column, so element (i,j)
+// is at Ab + j*ldab + (i-j). Then lapack routines can operate on the band
+// as a regular matrix with leading dimension ldab-1.
+#define AB(i_, j_) (Ab + (j_)*(ldab-1) + (i_))
+
+// Householder vectors of one sweep: rows sweep+1, ..., n-1 of the sweep are
+// in v[0], ..., v[n-sweep-2]; block k of the sweep has its tau in tau[k].
+#define V(i_)      (v   + (i_) - sweep - 1)
+#define TAU(i_)    (tau + ((i_) - sweep - 1)/nb)
+
+
+// ----------------------------------------
+// applies H = I - tau v v^H from both sides to the n-by-n Hermitian matrix
+// A, of which the lower triangle is stored: A = H^H A H.
+static void
+magma_zlarfxsym(
+    magma_int_t n, magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *v, magmaDoubleComplex *tau,
+    magmaDoubleComplex *work )
+{
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_half = MAGMA_Z_HALF;
+    const magma_int_t ione = 1;
+    magmaDoubleComplex alpha;
+
+    // work = tau A v
+    blasf77_zhemv( "L", &n, tau, A, &lda, v, &ione, &c_zero, work, &ione );
+    // work -= 1/2 tau (work^H v) v
+    alpha = magma_cblas_zdotc( n, work, ione, v, ione );
+    alpha = -(c_half * (*tau)) * alpha;
+    blasf77_zaxpy( &n, &alpha, v, &ione, work, &ione );
+    // A -= v work^H + work v^H
+    alpha = MAGMA_Z_NEG_ONE;
+    blasf77_zher2( "L", &n, &alpha, work, &ione, v, &ione, A, &lda );
+}
+
+
+// ----------------------------------------
+// Task 1 of a sweep: eliminates column st-1 below its subdiagonal, and
+// applies the reflector to the diagonal block AB(st:ed, st:ed).
+static void
+magma_zhbtype1cb(
+    magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *v, magmaDoubleComplex *tau,
+    magma_int_t sweep, magma_int_t st, magma_int_t ed,
+    magmaDoubleComplex *work )
+{
+    const magma_int_t ione = 1;
+    magma_int_t ldx = ldab - 1;
+    magma_int_t len = ed - st + 1;
+
+    *V(st) = MAGMA_Z_ONE;
+    for( magma_int_t i = 1; i < len; ++i ) {
+        *V(st+i)        = *AB(st+i, st-1);
+        *AB(st+i, st-1) = MAGMA_Z_ZERO;
+    }
+    lapackf77_zlarfg( &len, AB(st, st-1), V(st+1), &ione, TAU(st) );
+    magma_zlarfxsym( len, AB(st, st), ldx, V(st), TAU(st), work );
+}
+
+
+// ----------------------------------------
+// Task 2: applies the reflector of block st:ed from the right to the rows
+// below it, then eliminates the bulge this created in column st, and
+// applies that new reflector from the left to the rest of the rows.
+static void
+magma_zhbtype2cb(
+    magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *v, magmaDoubleComplex *tau,
+    magma_int_t sweep, magma_int_t st, magma_int_t ed,
+    magmaDoubleComplex *work )
+{
+    const magma_int_t ione = 1;
+    magma_int_t ldx = ldab - 1;
+    magma_int_t j1  = ed + 1;
+    magma_int_t j2  = min( ed + nb, n - 1 );
+    magma_int_t len = ed - st + 1;
+    magma_int_t lem = j2 - j1 + 1;
+
+    if ( lem > 0 ) {
+        lapackf77_zlarfx( "R", &lem, &len, V(st), TAU(st), AB(j1, st), &ldx, work );
+    }
+    if ( lem > 1 ) {
+        *V(j1) = MAGMA_Z_ONE;
+        for( magma_int_t i = 1; i < lem; ++i ) {
+            *V(j1+i)      = *AB(j1+i, st);
+            *AB(j1+i, st) = MAGMA_Z_ZERO;
+        }
+        lapackf77_zlarfg( &lem, AB(j1, st), V(j1+1), &ione, TAU(j1) );
+
+        // column st is done; apply the conjugate to columns st+1:ed
+        len -= 1;
+        if ( len > 0 ) {
+            magmaDoubleComplex ctau = MAGMA_Z_CNJG( *TAU(j1) );
+            lapackf77_zlarfx( "L", &lem, &len, V(j1), &ctau, AB(j1, st+1), &ldx, work );
+        }
+    }
+}
+
+
+// ----------------------------------------
+// Task 3: applies the reflector created by task 2 of the previous block to
+// the diagonal block AB(st:ed, st:ed), from both sides.
+static void
+magma_zhbtype3cb(
+    magma_int_t nb,
+    magmaDoubleComplex *Ab, magma_int_t ldab,
+    magmaDoubleComplex *v, magmaDoubleComplex *tau,
+    magma_int_t sweep, magma_int_t st, magma_int_t ed,
+    magmaDoubleComplex *work )
+{
+    magma_int_t ldx = ldab - 1;
+    magma_int_t len = ed - st + 1;
+
+    // a block of one row got no reflector from task 2
+    if ( len > 1 ) {
+        magma_zlarfxsym( len, AB(st, st), ldx, V(st), TAU(st), work );
+    }
+}
+
+
+// ----------------------------------------
+// Sweeps are dealt round-robin to threads. Task j of a sweep overlaps tasks
+// up to j+2 of the previous sweep, so it waits for those; progress[s] is
+// the number of tasks of sweep s done.
+struct zbulge_data {
+    magma_int_t n, nb;
+    magmaDoubleComplex *Ab;
+    magma_int_t ldab;
+    magmaDoubleComplex *V2, *tau2;
+    magma_int_t ldtau;
+    magma_int_t wantz;
+    magma_int_t nthread;
+    volatile magma_int_t *progress;
+};
+
+struct zbulge_arg {
+    zbulge_data *data;
+    magma_int_t tid;
+};
+
+static void*
+magma_zbulge_thread( void* arg_ )
+{
+    zbulge_arg  *arg  = (zbulge_arg*) arg_;
+    zbulge_data *data = arg->data;
+
+    magma_int_t n     = data->n;
+    magma_int_t nb    = data->nb;
+    magma_int_t ldab  = data->ldab;
+    magmaDoubleComplex *Ab = data->Ab;
+    volatile magma_int_t *progress = data->progress;
+
+    magmaDoubleComplex *work, *vloc=NULL, *tauloc=NULL;
+    magma_zmalloc_cpu( &work, nb );
+    if ( ! data->wantz ) {
+        magma_zmalloc_cpu( &vloc,   n );
+        magma_zmalloc_cpu( &tauloc, data->ldtau );
+    }
+
+    for( magma_int_t sweep = arg->tid; sweep < n-1; sweep += data->nthread ) {
+        magmaDoubleComplex *v, *tau;
+        if ( data->wantz ) {
+            v   = data->V2   + sweep*(2*n - sweep - 1)/2;
+            tau = data->tau2 + sweep*data->ldtau;
+        }
+        else {
+            v   = vloc;
+            tau = tauloc;
+        }
+
+        magma_int_t nblock = magma_ceildiv( n-1-sweep, nb );
+        magma_int_t nprev  = 2*magma_ceildiv( n-sweep, nb );  // tasks of sweep-1
+        for( magma_int_t j = 0; j < 2*nblock; ++j ) {
+            if ( sweep > 0 ) {
+                magma_int_t need = min( j+3, nprev );
+                while( progress[sweep-1] < need ) {
+                    // spin
+                }
+                __sync_synchronize();
+            }
+
+            magma_int_t st = sweep + 1 + (j/2)*nb;
+            magma_int_t ed = min( st + nb - 1, n - 1 );
+            if ( j == 0 ) {
+                magma_zhbtype1cb( nb, Ab, ldab, v, tau, sweep, st, ed, work );
+            }
+            else if ( j % 2 == 0 ) {
+                magma_zhbtype3cb( nb, Ab, ldab, v, tau, sweep, st, ed, work );
+            }
+            else {
+                magma_zhbtype2cb( n, nb, Ab, ldab, v, tau, sweep, st, ed, work );
+            }
+
+            __sync_synchronize();
+            progress[sweep] = j+1;
+        }
+    }
+
+    magma_free_cpu( work );
+    magma_free_cpu( vloc );
+    magma_free_cpu( tauloc );
+    return NULL;
+}
+
+
+/**
+    Purpose
+    -------
+    ZHETRD_HB2ST reduces a complex Hermitian band matrix B, of bandwidth nb,
+    to real symmetric tridiagonal form T by a unitary similarity
+    transformation, Q2^H B Q2 = T. This is the second stage of the two-stage
+    tridiagonal reduction; see magma_zhetrd_he2hb for the first stage.
+
+    The reduction is a bulge chase: sweep s eliminates column s below the
+    subdiagonal, which creates a bulge that the sweep chases down the band,
+    nb rows at a time. Each sweep is a sequence of small tasks on the CPU.
+    Several sweeps run concurrently in magma_get_parallel_numthreads()
+    threads, each following the previous sweep two tasks behind it.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+            The band is stored in the lower triangle of A; only
+            uplo = MagmaLower is supported.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix B.  N >= 0.
+
+    @param[in]
+    nb      INTEGER
+            The bandwidth of B.  NB >= 1.
+
+    @param[in]
+    A       COMPLEX_16 array, dimension (LDA,N)
+            The band matrix B, in the diagonal and the first nb
+            subdiagonals of A, as left by magma_zhetrd_he2hb.
+            A is not modified.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,N).
+
+    @param[out]
+    d       DOUBLE PRECISION array, dimension (N)
+            The diagonal elements of T.
+
+    @param[out]
+    e       DOUBLE PRECISION array, dimension (N-1)
+            The off-diagonal elements of T.
+
+    @param[out]
+    V2      COMPLEX_16 array, dimension (N*(N-1)/2)
+            If wantz, the Householder vectors of Q2, packed by sweep:
+            sweep s has the rows s+1, ..., n-1 of its vectors starting at
+            V2[ s*(2n-s-1)/2 ]. Its block k, of rows s+1+k*nb, ...,
+            min(s+(k+1)*nb, n-1), is one Householder vector with a leading 1.
+            Not referenced if wantz = 0.
+
+    @param[out]
+    tau2    COMPLEX_16 array, dimension (LDTAU,N-1)
+            If wantz, tau2[ s*ldtau + k ] is the scalar factor of block k of
+            sweep s, or zero if the block has no reflector.
+            Not referenced if wantz = 0.
+
+    @param[in]
+    ldtau   INTEGER
+            The leading dimension of the array tau2.
+            LDTAU >= max(1, ceil(N/NB)).
+
+    @param[in]
+    wantz   INTEGER
+            If nonzero, Q2 is saved in V2 and tau2 for magma_zbulge_back.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+
+    @ingroup magma_zheev_2stage
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zhetrd_hb2st(
+    magma_uplo_t uplo, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    double *d, double *e,
+    magmaDoubleComplex *V2, magmaDoubleComplex *tau2, magma_int_t ldtau,
+    magma_int_t wantz,
+    magma_int_t *info )
+{
+    *info = 0;
+    if ( uplo != MagmaLower ) {
+        *info = -1;
+    } else if ( n < 0 ) {
+        *info = -2;
+    } else if ( nb < 1 ) {
+        *info = -3;
+    } else if ( lda < max(1,n) ) {
+        *info = -5;
+    } else if ( ldtau < max( 1, magma_ceildiv( n, nb ))) {
+        *info = -10;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( n == 0 )
+        return *info;
+
+    // band copy, with room for the bulge of nb-1 rows below the band
+    magma_int_t ldab = 2*nb;
+    magmaDoubleComplex *Ab;
+    if (MAGMA_SUCCESS != magma_zmalloc_cpu( &Ab, ldab*n )) {
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+    memset( Ab, 0, ldab*n*sizeof(magmaDoubleComplex) );
+    for( magma_int_t j = 0; j < n; ++j ) {
+        magma_int_t len = min( nb+1, n-j );
+        memcpy( AB(j,j), &A[ j + j*lda ], len*sizeof(magmaDoubleComplex) );
+    }
+
+    if ( wantz ) {
+        memset( V2,   0, (n*(n-1)/2)*sizeof(magmaDoubleComplex) );
+        memset( tau2, 0, ldtau*(n-1)*sizeof(magmaDoubleComplex) );
+    }
+
+    magma_int_t nthread = max( 1, min( magma_get_parallel_numthreads(), n-1 ));
+    magma_int_t *progress;
+    pthread_t   *threads;
+    zbulge_arg  *args;
+    magma_imalloc_cpu( &progress, max(1,n) );
+    threads = (pthread_t*)  malloc( nthread*sizeof(pthread_t)  );
+    args    = (zbulge_arg*) malloc( nthread*sizeof(zbulge_arg) );
+    if ( progress == NULL || threads == NULL || args == NULL ) {
+        magma_free_cpu( progress );
+        free( threads );
+        free( args );
+        magma_free_cpu( Ab );
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+    memset( progress, 0, max(1,n)*sizeof(magma_int_t) );
+
+    zbulge_data data;
+    data.n        = n;
+    data.nb       = nb;
+    data.Ab       = Ab;
+    data.ldab     = ldab;
+    data.V2       = V2;
+    data.tau2     = tau2;
+    data.ldtau    = ldtau;
+    data.wantz    = wantz;
+    data.nthread  = nthread;
+    data.progress = progress;
+
+    // the tasks are too small for a multithreaded BLAS
+    magma_int_t nthread_save = magma_get_lapack_numthreads();
+    magma_set_lapack_numthreads( 1 );
+
+    for( magma_int_t t = 1; t < nthread; ++t ) {
+        args[t].data = &data;
+        args[t].tid  = t;
+        pthread_create( &threads[t], NULL, magma_zbulge_thread, &args[t] );
+    }
+    args[0].data = &data;
+    args[0].tid  = 0;
+    magma_zbulge_thread( &args[0] );
+    for( magma_int_t t = 1; t < nthread; ++t ) {
+        pthread_join( threads[t], NULL );
+    }
+
+    magma_set_lapack_numthreads( nthread_save );
+
+    for( magma_int_t i = 0; i < n-1; ++i ) {
+        d[i] = MAGMA_Z_REAL( *AB(i,i)   );
+        e[i] = MAGMA_Z_REAL( *AB(i+1,i) );
+    }
+    d[n-1] = MAGMA_Z_REAL( *AB(n-1,n-1) );
+
+    magma_free_cpu( progress );
+    free( threads );
+    free( args );
+    magma_free_cpu( Ab );
+    return *info;
+}
@@ -0,0 +1,231 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Stan Tomov
+       @author Mark Gates
+
+       @precisions normal z -> s d c
+
+*/
+#include "common_magma.h"
+
+#define PRECISION_z
+
+/**
+    Purpose
+    -------
+    ZHETRD_HE2HB reduces a complex Hermitian matrix A to Hermitian band
+    form B, of bandwidth nb, by a unitary similarity transformation:
+    Q1^H A Q1 = B. This is the first stage of the two-stage tridiagonal
+    reduction; magma_zhetrd_hb2st reduces B to tridiagonal form.
+
+    Unlike magma_zhetrd, all of the work on the trailing matrix is level 3
+    BLAS on the device: for each panel of nb columns, the CPU computes the
+    QR factorization of the panel, and the device applies the block
+    reflector from both sides with zhemm, zgemm, and zher2k. The update of
+    the next panel is done first and sent to the CPU, so the CPU factors it
+    while the device updates the rest of the trailing matrix.
+
+    Arguments
+    ---------
+    @param[in]
+    uplo    magma_uplo_t
+            Only uplo = MagmaLower is supported: the lower triangle of A
+            is stored.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix A.  N >= 0.
+
+    @param[in]
+    nb      INTEGER
+            The bandwidth of B.  NB >= 1.
+
+    @param[in,out]
+    A       COMPLEX_16 array, dimension (LDA,N)
+            On entry, the Hermitian matrix A, of which the lower triangle
+            is referenced.
+            On exit, the diagonal and the first nb subdiagonals of A are
+            overwritten by the band matrix B. The elements below the nb-th
+            subdiagonal, with the array TAU, represent Q1 as a product of
+            elementary reflectors: panel i, of columns i:i+nb-1, has the
+            QR factorization of rows i+nb:n-1, as zgeqrf would leave it.
+            The strictly upper triangles of the nb-by-nb diagonal blocks
+            are destroyed.
+
+    @param[in]
+    lda     INTEGER
+            The leading dimension of the array A.  LDA >= max(1,N).
+
+    @param[out]
+    tau     COMPLEX_16 array, dimension (N)
+            The scalar factors of the elementary reflectors;
+            tau[i:i+nb-1] belong to panel i.
+
+    @param
+    work    (workspace) COMPLEX_16 array, dimension (LWORK)
+
+    @param[in]
+    lwork   INTEGER
+            The dimension of the array WORK.  LWORK >= (N + NB)*NB.
+
+    @param[out]
+    T       COMPLEX_16 array, dimension (LDT,N)
+            The triangular factors of the block reflectors: T(0:nb-1, i:i+nb-1)
+            is the T of panel i, as zlarft computes it. Lower triangles are
+            not referenced. Used by magma_zunmqr_gpu_2stages to apply Q1.
+
+    @param[in]
+    ldt     INTEGER
+            The leading dimension of the array T.  LDT >= NB.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+
+    @ingroup magma_zheev_2stage
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zhetrd_he2hb(
+    magma_uplo_t uplo, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *A, magma_int_t lda,
+    magmaDoubleComplex *tau,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define  A(i_, j_) (A + (i_) + (j_)*lda)
+    #define  T(i_, j_) (T + (i_) + (j_)*ldt)
+    #define dA(i_, j_)  dA,    (dA_offset + (i_) + (j_)*ldda)
+    #define dV(i_)      dwork, (dV_offset + (i_))
+    #define dW(i_)      dwork, (dW_offset + (i_))
+    #define dT          dwork, dT_offset
+    #define dM          dwork, dM_offset
+
+    const magmaDoubleComplex c_zero     = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one      = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_neg_one  = MAGMA_Z_NEG_ONE;
+    const magmaDoubleComplex c_neg_half = MAGMA_Z_NEG_HALF;
+
+    *info = 0;
+    if ( uplo != MagmaLower ) {
+        *info = -1;
+    } else if ( n < 0 ) {
+        *info = -2;
+    } else if ( nb < 1 ) {
+        *info = -3;
+    } else if ( lda < max(1,n) ) {
+        *info = -5;
+    } else if ( lwork < (n + nb)*nb ) {
+        *info = -8;
+    } else if ( ldt < nb ) {
+        *info = -10;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( n <= nb )
+        return *info;
+
+    magma_int_t ldda = magma_roundup( n, 32 );
+    magmaDoubleComplex_ptr dA, dwork;
+    size_t dA_offset = 0;
+    size_t dV_offset = 0;
+    size_t dW_offset = dV_offset + ldda*nb;
+    size_t dT_offset = dW_offset + ldda*nb;
+    size_t dM_offset = dT_offset + nb*nb;
+    if (MAGMA_SUCCESS != magma_zmalloc( &dA, ldda*n )) {
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+    if (MAGMA_SUCCESS != magma_zmalloc( &dwork, 2*ldda*nb + 2*nb*nb )) {
+        magma_free( dA );
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+
+    // work: V of the panel with explicit zeros and ones (n*nb), zgeqrf (nb*nb)
+    magmaDoubleComplex *hV = work;
+    magma_int_t ldv = n;
+    magmaDoubleComplex *hwork = work + n*nb;
+    magma_int_t lhwork = lwork - n*nb;
+
+    magma_event_t event = NULL;
+    magma_int_t iinfo;
+
+    magma_zsetmatrix( n, n, A(0,0), lda, dA(0,0), ldda, queue );
+
+    // A(i+nb:n, i:i+nb) is up to date on the CPU at the start of step i
+    for( magma_int_t i = 0; i < n-nb; i += nb ) {
+        magma_int_t pm  = n - i - nb;     // rows of the panel and of the trailing matrix
+        magma_int_t pk  = min( pm, nb );  // reflectors
+        magma_int_t nb2 = min( pm, nb );  // columns of the next panel
+
+        // factor the panel and send its V and T to the device
+        lapackf77_zgeqrf( &pm, &nb, A(i+nb, i), &lda, &tau[i], hwork, &lhwork, &iinfo );
+        lapackf77_zlarft( MagmaForwardStr, MagmaColumnwiseStr, &pm, &pk,
+                          A(i+nb, i), &lda, &tau[i], T(0, i), &ldt );
+        lapackf77_zlacpy( MagmaLowerStr, &pm, &pk, A(i+nb, i), &lda, hV, &ldv );
+        lapackf77_zlaset( MagmaUpperStr, &pk, &pk, &c_zero, &c_one, hV, &ldv );
+        magma_zsetmatrix_async( pm, pk, hV, ldv, dV(0), ldda, queue, NULL );
+        magma_zsetmatrix_async( pk, pk, T(0, i), ldt, dT, nb, queue, NULL );
+
+        // A22 = Q^H A22 Q = A22 - W V^H - V W^H, with
+        // X = A22 V T,  W = X - 1/2 V (T^H V^H X)
+        magma_zhemm( MagmaLeft, MagmaLower, pm, pk,
+                     c_one,  dA(i+nb, i+nb), ldda,
+                             dV(0),          ldda,
+                     c_zero, dW(0),          ldda, queue );
+        magma_ztrmm( MagmaRight, MagmaUpper, MagmaNoTrans, MagmaNonUnit, pm, pk,
+                     c_one, dT,    nb,
+                            dW(0), ldda, queue );
+        magma_zgemm( MagmaConjTrans, MagmaNoTrans, pk, pk, pm,
+                     c_one,  dV(0), ldda,
+                             dW(0), ldda,
+                     c_zero, dM,    nb, queue );
+        magma_ztrmm( MagmaLeft, MagmaUpper, MagmaConjTrans, MagmaNonUnit, pk, pk,
+                     c_one, dT, nb,
+                            dM, nb, queue );
+        magma_zgemm( MagmaNoTrans, MagmaNoTrans, pm, pk, pk,
+                     c_neg_half, dV(0), ldda,
+                                 dM,    nb,
+                     c_one,      dW(0), ldda, queue );
+
+        // update the next panel and send it to the CPU, then the rest of A22
+        magma_zgemm( MagmaNoTrans, MagmaConjTrans, pm, nb2, pk,
+                     c_neg_one, dW(0), ldda,
+                                dV(0), ldda,
+                     c_one,     dA(i+nb, i+nb), ldda, queue );
+        magma_zgemm( MagmaNoTrans, MagmaConjTrans, pm, nb2, pk,
+                     c_neg_one, dV(0), ldda,
+                                dW(0), ldda,
+                     c_one,     dA(i+nb, i+nb), ldda, queue );
+        magma_zgetmatrix_async( pm, nb2, dA(i+nb, i+nb), ldda, A(i+nb, i+nb), lda,
+                                queue, &event );
+        if ( pm > nb2 ) {
+            magma_zher2k( MagmaLower, MagmaNoTrans, pm-nb2, pk,
+                          c_neg_one, dW(nb2), ldda,
+                                     dV(nb2), ldda,
+                          1.,        dA(i+nb+nb2, i+nb+nb2), ldda, queue );
+        }
+        magma_event_sync( event );
+        magma_event_destroy( event );
+    }
+
+    magma_free( dA );
+    magma_free( dwork );
+    return *info;
+} /* magma_zhetrd_he2hb */
@@ -118,7 +118,7 @@ magma_zhetrf_nopiv(
     }
 
     //magma_event_t event = NULL;
-    trace_init( 1, 1, 2, queues );
+    trace_init( 1, 2, queues );
 
     /* Use hybrid blocked code. */
     if (upper) {
@@ -147,9 +147,9 @@ magma_zhetrf_nopiv(
             
             // factorize the diagonal block
             magma_queue_sync( queues[0] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             zhetrf_nopiv_cpu(MagmaUpper, jb, ib, A(j, j), lda, info);
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0){
                 *info = *info + j;
                 break;
@@ -224,9 +224,9 @@ magma_zhetrf_nopiv(
 
             // factorize the diagonal block
             magma_queue_sync( queues[0] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             zhetrf_nopiv_cpu(MagmaLower, jb, ib, A(j, j), lda, info);
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0){
                 *info = *info + j;
                 break;
@@ -278,7 +278,6 @@ magma_zhetrf_nopiv(
         }
     }
 
-    trace_finalize( "zhetrf.svg","trace.css" );
     //magma_event_destroy( event );
     magma_queue_sync( queues[0] );
     magma_free(dW);
@@ -107,7 +107,7 @@ magma_zhetrf_nopiv_gpu(
     ib = min(32, nb); // inner-block for diagonal factorization
 
     //magma_event_t event = NULL;
-    trace_init( 1, 1, 2, queues );
+    trace_init( 1, 2, queues );
 
     // CPU workspace
     magmaDoubleComplex *A;
@@ -141,9 +141,9 @@ magma_zhetrf_nopiv_gpu(
 
             // factorize the diagonal block
             magma_queue_sync( queues[0] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             zhetrf_nopiv_cpu(MagmaUpper, jb, ib, A(j, j), nb, info);
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0){
                 *info = *info + j;
                 break;
@@ -203,9 +203,9 @@ magma_zhetrf_nopiv_gpu(
             
             // factorize the diagonal block
             magma_queue_sync( queues[0] );
-            trace_cpu_start( 0, "potrf", "potrf" );
+            trace_cpu_start( "potrf", "potrf" );
             zhetrf_nopiv_cpu(MagmaLower, jb, ib, A(j, j), nb, info);
-            trace_cpu_end( 0 );
+            trace_cpu_end();
             if (*info != 0){
                 *info = *info + j;
                 break;
@@ -251,7 +251,6 @@ magma_zhetrf_nopiv_gpu(
         }
     }
     
-    trace_finalize( "zhetrf.svg","trace.css" );
     //magma_event_destroy( event );
     magma_queue_sync( queues[0] );
     magma_free( dW );
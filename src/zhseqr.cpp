@@ -0,0 +1,446 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Mark Gates
+
+       @precisions normal z -> c
+
+*/
+#include "common_magma.h"
+
+#define PRECISION_z
+
+// Active blocks of this order or smaller are finished by zlahqr, as in
+// LAPACK's zlaqr0 (NMIN from iparmq).
+const magma_int_t zhseqr_nmin = 75;
+
+// Number of shifts in a sweep, for an active block of order nh.
+static magma_int_t zhseqr_nshift( magma_int_t nh )
+{
+    if      (nh <  590) return 16;
+    else if (nh < 3000) return 32;
+    else                return 64;
+}
+
+
+// ----------------------------------------
+// Applies the reflectors accumulated in the nw-by-nw U, of the window of
+// rows and columns [w0, w1 = w0 + nw - 1] of H, to the rest of H and to Z:
+//     H(w0:w1, w1+1:jend)   = U^H H(w0:w1, w1+1:jend),
+//     H(istart:w0-1, w0:w1) = H(istart:w0-1, w0:w1) U,
+//     Z(:, w0:w1)           = Z(:, w0:w1) U.
+// The window itself, hW, was updated on the CPU and is sent back first.
+static void
+zhseqr_update(
+    magma_int_t wantt, magma_int_t wantz, magma_int_t n,
+    magma_int_t ktop, magma_int_t kbot, magma_int_t w0, magma_int_t nw,
+    magmaDoubleComplex *hW, magmaDoubleComplex *hU,
+    magmaDoubleComplex_ptr dH, size_t dH_offset, magma_int_t lddh,
+    magmaDoubleComplex_ptr dZ, size_t dZ_offset, magma_int_t lddz,
+    magmaDoubleComplex_ptr dwork,
+    magma_queue_t queue )
+{
+    #define dH(i_, j_)  dH,    (dH_offset + (i_) + (j_)*lddh)
+    #define dZ(i_, j_)  dZ,    (dZ_offset + (i_) + (j_)*lddz)
+    #define dU          dwork, 0
+    #define dW          dwork, nw*nw
+
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+
+    magma_int_t w1     = w0 + nw - 1;
+    magma_int_t istart = (wantt ? 0   : ktop);
+    magma_int_t jend   = (wantt ? n-1 : kbot);
+    magma_int_t nr     = w0 - istart;
+    magma_int_t nc     = jend - w1;
+
+    magma_zsetmatrix( nw, nw, hW, nw, dH(w0, w0), lddh, queue );
+    magma_zsetmatrix( nw, nw, hU, nw, dU, nw, queue );
+    if ( nc > 0 ) {
+        magma_zgemm( MagmaConjTrans, MagmaNoTrans, nw, nc, nw,
+                     c_one,  dU,             nw,
+                             dH(w0, w1+1),   lddh,
+                     c_zero, dW,             nw, queue );
+        magma_zcopymatrix( nw, nc, dW, nw, dH(w0, w1+1), lddh, queue );
+    }
+    if ( nr > 0 ) {
+        magma_zgemm( MagmaNoTrans, MagmaNoTrans, nr, nw, nw,
+                     c_one,  dH(istart, w0), lddh,
+                             dU,             nw,
+                     c_zero, dW,             nr, queue );
+        magma_zcopymatrix( nr, nw, dW, nr, dH(istart, w0), lddh, queue );
+    }
+    if ( wantz ) {
+        magma_zgemm( MagmaNoTrans, MagmaNoTrans, n, nw, nw,
+                     c_one,  dZ(0, w0),      lddz,
+                             dU,             nw,
+                     c_zero, dW,             n, queue );
+        magma_zcopymatrix( n, nw, dW, n, dZ(0, w0), lddz, queue );
+    }
+
+    #undef dH
+    #undef dZ
+    #undef dU
+    #undef dW
+}
+
+
+/**
+    Purpose
+    -------
+    ZHSEQR computes the eigenvalues of a complex upper Hessenberg matrix H
+    and, optionally, the Schur form T = Z^H H Z and the Schur vectors Z,
+    like LAPACK's zhseqr, with H and Z kept on the device.
+
+    Each iteration chases a chain of ns single-shift bulges, tightly
+    packed, through the active block, by the small-bulge multishift QR
+    algorithm. The chain is moved in steps: the CPU chases it through a
+    window of a few times ns rows and columns of H, and accumulates the
+    reflectors in an orthogonal matrix U; the device then applies U to the
+    rest of the rows and columns of the window, and to Z, with zgemm.
+    Shifts are the eigenvalues of the trailing ns-by-ns block, computed by
+    zlahqr. Active blocks of order 75 or less are finished the same way,
+    by zlahqr in one window. Matrices of order 75 or less are passed to
+    LAPACK's zhseqr, as are larger ones if the workspace cannot be allocated.
+
+    Arguments
+    ---------
+    @param[in]
+    wantt   INTEGER
+      -     = 0: only eigenvalues are required;
+      -     = 1: the Schur form T is required.
+
+    @param[in]
+    wantz   INTEGER
+      -     = 0: no Schur vectors are computed;
+      -     = 1: Z must contain an N-by-N unitary matrix Q on entry, and the
+                 product Q*Z is returned.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix H.  N >= 0.
+
+    @param[in]
+    ilo     INTEGER
+    @param[in]
+    ihi     INTEGER
+            It is assumed that H is already upper triangular in rows and
+            columns 1:ILO-1 and IHI+1:N, as from zgebal.
+            1 <= ILO <= IHI <= N, if N > 0; ILO=1 and IHI=0, if N=0.
+
+    @param[in,out]
+    H       COMPLEX_16 array, dimension (LDH,N)
+            On entry, the upper Hessenberg matrix H.
+            On exit, if INFO = 0 and WANTT = 1, H contains the upper
+            triangular matrix T from the Schur decomposition. If WANTT = 0,
+            the contents of H are unspecified on exit.
+
+    @param[in]
+    ldh     INTEGER
+            The leading dimension of the array H.  LDH >= max(1,N).
+
+    @param[out]
+    w       COMPLEX_16 array, dimension (N)
+            The computed eigenvalues. If WANTT = 1, they are stored in the
+            same order as on the diagonal of T.
+
+    @param[in,out]
+    Z       COMPLEX_16 array, dimension (LDZ,N)
+            If WANTZ = 1, on entry the unitary matrix Q, and on exit Q*Z.
+            Not referenced if WANTZ = 0.
+
+    @param[in]
+    ldz     INTEGER
+            The leading dimension of the array Z.
+            LDZ >= max(1,N) if WANTZ = 1, else LDZ >= 1.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+      -     > 0:  if INFO = i, the algorithm failed to compute all the
+                  eigenvalues; elements i+1:ihi of w contain those
+                  eigenvalues which have been computed.
+
+    @ingroup magma_zgeev_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zhseqr(
+    magma_int_t wantt, magma_int_t wantz, magma_int_t n,
+    magma_int_t ilo, magma_int_t ihi,
+    magmaDoubleComplex *H, magma_int_t ldh,
+    magmaDoubleComplex *w,
+    magmaDoubleComplex *Z, magma_int_t ldz,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define  H(i_, j_) (H  + (i_) + (j_)*ldh)
+    #define hW(i_, j_) (hW + (i_) + (j_)*nw)
+    #define hU(i_, j_) (hU + (i_) + (j_)*nw)
+    #define dH(i_, j_)  dH, ((i_) + (j_)*lddh)
+    #define dZ(i_, j_)  dZ, ((i_) + (j_)*lddz)
+
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+    const magma_int_t izero = 0;
+    const magma_int_t ione  = 1;
+    const magma_int_t itwo  = 2;
+
+    *info = 0;
+    if ( n < 0 ) {
+        *info = -3;
+    } else if ( ilo < 1 || ilo > max(1,n) ) {
+        *info = -4;
+    } else if ( ihi < min(ilo,n) || ihi > n ) {
+        *info = -5;
+    } else if ( ldh < max(1,n) ) {
+        *info = -7;
+    } else if ( ldz < 1 || (wantz && ldz < max(1,n)) ) {
+        *info = -10;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( n == 0 )
+        return *info;
+
+    // eigenvalues isolated by zgebal
+    for( magma_int_t i = 0; i < ilo-1; ++i ) {
+        w[i] = *H(i,i);
+    }
+    for( magma_int_t i = ihi; i < n; ++i ) {
+        w[i] = *H(i,i);
+    }
+    if ( ilo == ihi ) {
+        w[ilo-1] = *H(ilo-1,ilo-1);
+        return *info;
+    }
+
+    double safmin = lapackf77_dlamch( "Safe minimum" );
+    double ulp    = lapackf77_dlamch( "Precision" );
+    double smlnum = safmin*( double(ihi - ilo + 1) / ulp );
+
+    // a window holds a sweep of nstep steps of a chain of ns bulges,
+    // spread over at most nstep + 2*ns + 1 rows
+    magma_int_t ns_max = zhseqr_nshift( ihi - ilo + 1 );
+    magma_int_t nwmax  = min( n, max( zhseqr_nmin, 4*ns_max + 4 ));
+
+    magma_int_t lddh = magma_roundup( n, 32 );
+    magma_int_t lddz = (wantz ? lddh : 1);
+    magmaDoubleComplex_ptr dH=NULL, dZ=NULL, dwork=NULL;
+    magmaDoubleComplex *hW=NULL, *hU, *shift=NULL, *diag, *sub;
+    // small matrices are not worth the device
+    bool on_device = (n > zhseqr_nmin);
+    if ( on_device &&
+         (MAGMA_SUCCESS != magma_zmalloc( &dH, lddh*n ) ||
+          (wantz && MAGMA_SUCCESS != magma_zmalloc( &dZ, lddz*n )) ||
+          MAGMA_SUCCESS != magma_zmalloc( &dwork, nwmax*nwmax + n*nwmax ) ||
+          MAGMA_SUCCESS != magma_zmalloc_pinned( &hW, 2*nwmax*nwmax ) ||
+          MAGMA_SUCCESS != magma_zmalloc_cpu( &shift, 3*n ))) {
+        // alloc failed so call LAPACK
+        magma_free( dH );
+        magma_free( dZ );
+        magma_free( dwork );
+        magma_free_pinned( hW );
+        on_device = false;
+    }
+    if ( ! on_device ) {
+        magmaDoubleComplex lwork[1];
+        magma_int_t llwork = -1;
+        lapackf77_zhseqr( (wantt ? "S" : "E"), (wantz ? "V" : "N"),
+                          &n, &ilo, &ihi, H, &ldh, w, Z, &ldz,
+                          lwork, &llwork, info );
+        llwork = max( n, (magma_int_t) MAGMA_Z_REAL( lwork[0] ));
+        magmaDoubleComplex *hwork;
+        if (MAGMA_SUCCESS != magma_zmalloc_cpu( &hwork, llwork )) {
+            *info = MAGMA_ERR_HOST_ALLOC;
+            return *info;
+        }
+        lapackf77_zhseqr( (wantt ? "S" : "E"), (wantz ? "V" : "N"),
+                          &n, &ilo, &ihi, H, &ldh, w, Z, &ldz,
+                          hwork, &llwork, info );
+        magma_free_cpu( hwork );
+        return *info;
+    }
+    hU   = hW + nwmax*nwmax;
+    diag = shift + n;
+    sub  = diag  + n;
+
+    magma_zsetmatrix( n, n, H, ldh, dH(0,0), lddh, queue );
+    if ( wantz ) {
+        magma_zsetmatrix( n, n, Z, ldz, dZ(0,0), lddz, queue );
+    }
+
+    magma_int_t kbot  = ihi - 1;  // 0-based bottom of the active block
+    magma_int_t its   = 0;        // iterations since the last deflation at kbot
+    magma_int_t itmax = 30 * max( 10, ihi - ilo + 1 );
+    magma_int_t iinfo;
+
+    while ( kbot >= ilo - 1 ) {
+        if ( its > itmax ) {
+            *info = kbot + 1;
+            break;
+        }
+
+        // find the top of the active block: the lowest negligible subdiagonal,
+        // by the test of zlahqr
+        magma_int_t kfirst = ilo - 1;
+        magma_int_t nk = kbot - kfirst + 1;
+        magma_zgetvector( nk, dH(kfirst, kfirst), lddh+1, &diag[kfirst], 1, queue );
+        if ( nk > 1 ) {
+            magma_zgetvector( nk-1, dH(kfirst+1, kfirst), lddh+1, &sub[kfirst+1], 1, queue );
+        }
+        magma_int_t ktop = kfirst;
+        for( magma_int_t k = kbot; k > kfirst; --k ) {
+            double tst = MAGMA_Z_ABS1( diag[k-1] ) + MAGMA_Z_ABS1( diag[k] );
+            if ( MAGMA_Z_ABS1( sub[k] ) <= max( smlnum, ulp*tst ) ) {
+                magma_zsetvector( 1, &c_zero, 1, dH(k, k-1), 1, queue );
+                ktop = k;
+                break;
+            }
+        }
+        magma_int_t nh = kbot - ktop + 1;
+
+        if ( nh <= zhseqr_nmin ) {
+            // finish the active block in one window, with zlahqr
+            magma_int_t nw = nh;
+            magma_zgetmatrix( nw, nw, dH(ktop, ktop), lddh, hW, nw, queue );
+            if ( wantt || wantz ) {
+                lapackf77_zlaset( "A", &nw, &nw, &c_zero, &c_one, hU, &nw );
+                lapackf77_zlahqr( &ione, &ione, &nw, &ione, &nw, hW, &nw, &w[ktop],
+                                  &ione, &nw, hU, &nw, &iinfo );
+                zhseqr_update( wantt, wantz, n, ktop, kbot, ktop, nw, hW, hU,
+                               dH(0,0), lddh, dZ, 0, lddz, dwork, queue );
+            }
+            else {
+                lapackf77_zlahqr( &izero, &izero, &nw, &ione, &nw, hW, &nw, &w[ktop],
+                                  &ione, &nw, hU, &nw, &iinfo );
+            }
+            if ( iinfo != 0 ) {
+                *info = ktop + iinfo;
+                break;
+            }
+            kbot = ktop - 1;
+            its  = 0;
+            continue;
+        }
+
+        // shifts: eigenvalues of the trailing ns-by-ns block,
+        // or exceptional shifts after 6 iterations without deflation
+        magma_int_t ns = min( zhseqr_nshift( nh ), (nh - 1)/2 );
+        if ( its > 0 && its % 6 == 0 ) {
+            for( magma_int_t i = 0; i < ns; ++i ) {
+                shift[i] = diag[kbot-i] + 0.75*MAGMA_Z_ABS1( sub[kbot-i] );
+            }
+        }
+        else {
+            magma_zgetmatrix( ns, ns, dH(kbot-ns+1, kbot-ns+1), lddh, hW, ns, queue );
+            lapackf77_zlahqr( &izero, &izero, &ns, &ione, &ns, hW, &ns, shift,
+                              &ione, &ns, hU, &ns, &iinfo );
+            if ( iinfo != 0 ) {
+                for( magma_int_t i = 0; i < ns; ++i ) {
+                    shift[i] = diag[kbot-i];
+                }
+            }
+        }
+
+        // Sweep. Bulge j is introduced at time 2j, and at time t does step
+        // q = t - 2j: a reflector on rows and columns ktop+q, ktop+q+1 that
+        // annihilates the bulge at H(ktop+q+1, ktop+q-1), or, for q = 0,
+        // introduces the shift. Bulges are processed leading first.
+        magma_int_t qlast = kbot - ktop - 1;
+        magma_int_t tlast = 2*(ns - 1) + qlast;
+        magma_int_t nstep = 2*ns;
+        for( magma_int_t t0 = 0; t0 <= tlast; t0 += nstep ) {
+            magma_int_t t1 = min( t0 + nstep, tlast + 1 );
+
+            // window [w0, w0 + nw) covering every step in [t0, t1)
+            magma_int_t w0 = kbot, w1 = ktop;
+            for( magma_int_t j = 0; j < ns; ++j ) {
+                magma_int_t qmin = max( t0   - 2*j, 0 );
+                magma_int_t qmax = min( t1-1 - 2*j, qlast );
+                if ( qmin > qmax )
+                    continue;
+                w0 = min( w0, ktop + qmin - (qmin > 0 ? 1 : 0) );
+                w1 = max( w1, min( ktop + qmax + 2, kbot ));
+            }
+            magma_int_t nw = w1 - w0 + 1;
+
+            magma_zgetmatrix( nw, nw, dH(w0, w0), lddh, hW, nw, queue );
+            lapackf77_zlaset( "A", &nw, &nw, &c_zero, &c_one, hU, &nw );
+
+            for( magma_int_t t = t0; t < t1; ++t ) {
+                for( magma_int_t j = 0; j < ns; ++j ) {
+                    magma_int_t q = t - 2*j;
+                    if ( q < 0 || q > qlast )
+                        continue;
+                    magma_int_t r = ktop + q - w0;  // window row of the reflector
+                    magmaDoubleComplex alpha, v1, tau, sum;
+                    magma_int_t c0;
+                    if ( q == 0 ) {
+                        alpha = *hW(r, r) - shift[j];
+                        v1    = *hW(r+1, r);
+                        c0    = r;
+                    }
+                    else {
+                        alpha = *hW(r,   r-1);
+                        v1    = *hW(r+1, r-1);
+                        c0    = r - 1;
+                    }
+                    lapackf77_zlarfg( &itwo, &alpha, &v1, &ione, &tau );
+                    if ( q > 0 ) {
+                        *hW(r,   r-1) = alpha;
+                        *hW(r+1, r-1) = c_zero;
+                        c0 = r;
+                    }
+
+                    // H = (I - tau v v^H)^H H, columns c0 to the end of the window
+                    for( magma_int_t c = c0; c < nw; ++c ) {
+                        sum = MAGMA_Z_CNJG( tau ) * (*hW(r, c) + MAGMA_Z_CNJG( v1 ) * *hW(r+1, c));
+                        *hW(r,   c) -= sum;
+                        *hW(r+1, c) -= sum * v1;
+                    }
+                    // H = H (I - tau v v^H), rows down to the bulge it creates
+                    magma_int_t rend = min( ktop + q + 2, kbot ) - w0;
+                    for( magma_int_t i = 0; i <= rend; ++i ) {
+                        sum = tau * (*hW(i, r) + *hW(i, r+1) * v1);
+                        *hW(i, r)   -= sum;
+                        *hW(i, r+1) -= sum * MAGMA_Z_CNJG( v1 );
+                    }
+                    // U = U (I - tau v v^H)
+                    for( magma_int_t i = 0; i < nw; ++i ) {
+                        sum = tau * (*hU(i, r) + *hU(i, r+1) * v1);
+                        *hU(i, r)   -= sum;
+                        *hU(i, r+1) -= sum * MAGMA_Z_CNJG( v1 );
+                    }
+                }
+            }
+
+            zhseqr_update( wantt, wantz, n, ktop, kbot, w0, nw, hW, hU,
+                           dH(0,0), lddh, dZ, 0, lddz, dwork, queue );
+        }
+        its += 1;
+    }
+
+    magma_zgetmatrix( n, n, dH(0,0), lddh, H, ldh, queue );
+    if ( wantz ) {
+        magma_zgetmatrix( n, n, dZ(0,0), lddz, Z, ldz, queue );
+    }
+
+    magma_free( dH );
+    if ( wantz ) magma_free( dZ );
+    magma_free( dwork );
+    magma_free_pinned( hW );
+    magma_free_cpu( shift );
+    return *info;
+} /* magma_zhseqr */
@@ -9,6 +9,78 @@
        @precisions normal z -> s d c
 */
 #include "common_magma.h"
+#include "magma_stats.h"
+
+
+// ----------------------------------------
+// Distributes A over ngpu GPUs, in 1D block-column cyclic layout if upper
+// or 1D block-row cyclic layout if lower, as magma_zpotrf_mgpu requires,
+// factors it with magma_zpotrf_mgpu, and gathers the factor back to A.
+// Returns MAGMA_ERR_DEVICE_ALLOC, leaving A unchanged, if A doesn't fit on
+// the GPUs; otherwise returns MAGMA_SUCCESS, with the LAPACK info in info.
+static magma_int_t
+zpotrf_mgpu_host(
+    magma_int_t ngpu, magma_uplo_t uplo, magma_int_t n, magma_int_t nb,
+    magmaDoubleComplex *a, magma_int_t lda,
+    magma_int_t *info )
+{
+    magmaDoubleComplex_ptr d_lA[ MagmaMaxGPUs ];
+    magma_queue_t queues2[ 2*MagmaMaxGPUs ];
+    magma_queue_t queues [ MagmaMaxGPUs ];
+    magma_int_t d, ldda, err;
+
+    // largest block of A that any GPU stores, rounded up to full blocks
+    magma_int_t max_nlocal = (1 + n/(nb*ngpu))*nb;
+    magma_int_t max_size   = max_nlocal * magma_roundup( n, nb );
+
+    err = magma_queues_create_mgpu( ngpu, queues2 );
+    if ( err != MAGMA_SUCCESS ) {
+        return err;
+    }
+    for( d=0; d < ngpu; d++ ) {
+        queues[d] = queues2[2*d];
+    }
+
+    for( d=0; d < ngpu; d++ ) {
+        if ( MAGMA_SUCCESS != magma_zmalloc( &d_lA[d], max_size )) {
+            while( d > 0 ) {
+                magma_free( d_lA[--d] );
+            }
+            magma_queues_destroy_mgpu( ngpu, queues2 );
+            return MAGMA_ERR_DEVICE_ALLOC;
+        }
+    }
+
+    if ( uplo == MagmaUpper ) {
+        ldda = magma_roundup( n, nb );
+        magma_zsetmatrix_1D_col_bcyclic( n, n, a, lda, d_lA, ldda, ngpu, nb, queues );
+    }
+    else {
+        ldda = max_nlocal;
+        magma_zsetmatrix_1D_row_bcyclic( n, n, a, lda, d_lA, ldda, ngpu, nb, queues );
+    }
+    magma_zpotrf_mgpu( ngpu, uplo, n, d_lA, 0, ldda, queues2, info );
+    if ( *info == MAGMA_ERR_DEVICE_ALLOC ) {
+        err = MAGMA_ERR_DEVICE_ALLOC;
+    }
+    else {
+        if ( uplo == MagmaUpper ) {
+            magma_zgetmatrix_1D_col_bcyclic( n, n, d_lA, ldda, a, lda, ngpu, nb, queues );
+        }
+        else {
+            magma_zgetmatrix_1D_row_bcyclic( n, n, d_lA, ldda, a, lda, ngpu, nb, queues );
+        }
+        for( d=0; d < ngpu; d++ ) {
+            magma_queue_sync( queues[d] );
+        }
+    }
+
+    for( d=0; d < ngpu; d++ ) {
+        magma_free( d_lA[d] );
+    }
+    magma_queues_destroy_mgpu( ngpu, queues2 );
+    return err;
+}
 
 
 #define A(i, j)  (a   +(j)*lda  + (i))
@@ -43,6 +115,9 @@ magma_zpotrf(
     If the current stream is NULL, this version replaces it with user defined
     stream to overlap computation with communication.
 
+    If magma_num_gpus() > 1, A is distributed over the GPUs and factored
+    by magma_zpotrf_mgpu.
+
     Arguments
     =========
     UPLO    (input) CHARACTER*1
@@ -86,6 +161,9 @@ magma_zpotrf(
     magmaDoubleComplex_ptr  dwork;
     double             d_one     =  1.0;
     double             d_neg_one = -1.0;
+    double             cpu_time;
+
+    MAGMA_STATS_ROUTINE();
 
     *info = 0;
     if( (uplo != MagmaUpper) && (uplo != MagmaLower) ) {
@@ -104,12 +182,17 @@ magma_zpotrf(
     if ( n == 0 )
         return *info;
 
+    nb = magma_get_zpotrf_nb(n);
+
     magma_int_t num_gpus = magma_num_gpus();
-    if( num_gpus > 1 ) {
-        /* call multiple-GPU interface  */
-      printf("multiple-GPU verison not implemented\n"); 
-        return MAGMA_ERR_NOT_IMPLEMENTED;
-        //return magma_zpotrf_m(num_gpus, uplo, n, a, lda, info);
+    if( num_gpus > 1 && nb > 1 && nb < n ) {
+        /* call multiple-GPU interface, with at least one block per GPU;
+           if A doesn't fit on the GPUs, continue with one GPU */
+        magma_int_t ngpu = min( num_gpus, magma_ceildiv( n, nb ));
+        if ( zpotrf_mgpu_host( ngpu, uplo, n, nb, a, lda, info ) == MAGMA_SUCCESS ) {
+            return *info;
+        }
+        *info = 0;
     }
 
     ldda = magma_roundup( n, 32 );
@@ -121,8 +204,6 @@ magma_zpotrf(
         //return magma_zpotrf_m(num_gpus, uplo, n, a, lda, info);
     }
 
-    nb = magma_get_zpotrf_nb(n);
-
     if (nb <= 1 || nb >= n) {
         lapackf77_zpotrf(lapack_uplo_const(uplo), &n, a, &lda, info);
     } else {
@@ -157,7 +238,9 @@ magma_zpotrf(
                                         dA(0, j), ldda,
                                         A (0, j), lda, queues[0], NULL );
 
+                cpu_time = magma_wtime();
                 lapackf77_zpotrf(MagmaUpperStr, &jb, A(j, j), &lda, info);
+                magma_stats_cpu( magma_wtime() - cpu_time );
                 if (*info != 0) {
                     *info = *info + j;
                     break;
@@ -206,7 +289,9 @@ magma_zpotrf(
                                         dA(j, 0), ldda,
                                         A(j, 0), lda, queues[1], NULL );
 
+                cpu_time = magma_wtime();
                 lapackf77_zpotrf(MagmaLowerStr, &jb, A(j, j), &lda, info);
+                magma_stats_cpu( magma_wtime() - cpu_time );
                 if (*info != 0){
                     *info = *info + j;
                     break;
@@ -12,7 +12,6 @@
 #include "common_magma.h"
 
 // using 2 queues, 1 for comm, 1 for comp.
-extern cl_context     gContext;
 
 /**
     Purpose
@@ -103,14 +102,10 @@ magma_zpotrf2_gpu(
     }
     
     nb = magma_get_zpotrf_nb( n );
-    /*
-    if (MAGMA_SUCCESS != magma_zmalloc_cpu( &work, nb*nb )) {
+    if (MAGMA_SUCCESS != magma_zmalloc_pinned( &work, nb*nb )) {
         *info = MAGMA_ERR_HOST_ALLOC;
         return *info;
     }
-    */
-    cl_mem buffer = clCreateBuffer( gContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sizeof(magmaDoubleComplex)*nb*nb, NULL, NULL );
-    work = (magmaDoubleComplex*)clEnqueueMapBuffer( queues[0], buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, nb*nb*sizeof(magmaDoubleComplex), 0, NULL, NULL, NULL );
 
     if ((nb <= 1) || (nb >= n)) {
         // Use unblocked code.
@@ -216,9 +211,7 @@ magma_zpotrf2_gpu(
     magma_queue_sync( queues[0] );
     magma_queue_sync( queues[1] );
     
-    //magma_free_cpu( work );
-    clEnqueueUnmapMemObject( queues[0], buffer, work, 0, NULL, NULL );
-    clReleaseMemObject( buffer );
+    magma_free_pinned( work );
     
     return *info;
 }
@@ -99,6 +99,11 @@ magma_zpotrf2_mgpu(
     magma_int_t n_local[MagmaMaxGPUs], ldpanel;
     magma_event_t events[MagmaMaxGPUs];
 
+    /* events ordering each gpu's transfer queue, queues[2*d],
+       and compute queue, queues[2*d+1] */
+    magma_event_t transfer_event[MagmaMaxGPUs];  /* data arrived on transfer queue */
+    magma_event_t compute_event[MagmaMaxGPUs];   /* update done on compute queue */
+
     *info = 0;
     if ( (uplo != MagmaUpper) && (uplo != MagmaLower) ) {
         *info = -1;
@@ -133,6 +138,11 @@ magma_zpotrf2_mgpu(
         }
       }
 
+      for( d=0; d<num_gpus; d++ ) {
+          magma_event_create( &transfer_event[d] );
+          magma_event_create( &compute_event[d]  );
+      }
+
       /* Use blocked code. */
       if (uplo == MagmaUpper) 
         {
@@ -172,7 +182,9 @@ magma_zpotrf2_mgpu(
                                 queues[2*id+1]);
                                                                                                 }
                 /* send the diagonal to cpu */
-                magma_queue_sync(queues[2*id+1]);// wait for syrk
+                /* wait for syrk */
+                magma_event_record( compute_event[id], queues[2*id+1] );
+                magma_queue_wait_event( queues[2*id], compute_event[id] );
                 magma_zgetmatrix_async( jb, jb, 
                                         dlA(id, j, nb*j_local), ldda,
                                         Aup(j,j), lda,
@@ -193,7 +205,8 @@ magma_zpotrf2_mgpu(
                                 ldpanel = lddp;
                         
                                 /* wait for the offdiagonal column */
-                                magma_queue_sync(queues[d*2]);
+                                magma_event_record( transfer_event[d], queues[d*2] );
+                                magma_queue_wait_event( queues[d*2+1], transfer_event[d] );
                             }else{
                                 dlpanel = d_lA[d];
                                 dlpanel_offset = dlA_offset(0, nb*j_local);
@@ -265,7 +278,9 @@ magma_zpotrf2_mgpu(
                         }
                         nb2 = n_local[d]-nb*j_local2;
                         nb0 = min(nb, nb2 );
-                        magma_queue_sync( queues[2*d]); // wait for the diagonal
+                        /* wait for the diagonal */
+                        magma_event_record( transfer_event[d], queues[2*d] );
+                        magma_queue_wait_event( queues[2*d+1], transfer_event[d] );
                         if(j+jb < m && d == (j/nb+1)%num_gpus){
                             /* owns the next column, look-ahead the column */
                             magma_ztrsm( MagmaLeft, MagmaUpper, MagmaConjTrans, MagmaNonUnit,
@@ -275,7 +290,9 @@ magma_zpotrf2_mgpu(
                                          queues[2*d+1]);
                             /* send the column to cpu */
                             if(j+jb < m){
-                                magma_queue_sync(queues[2*d+1]);  // wait for lookahead
+                                /* wait for lookahead */
+                                magma_event_record( compute_event[d], queues[2*d+1] );
+                                magma_queue_wait_event( queues[2*d], compute_event[d] );
                                  magma_zgetmatrix_async( (j+jb), nb0, 
                                                          dlA(d, 0, nb*j_local2), ldda, 
                                                          Aup(0,j+jb), lda,
@@ -346,7 +363,9 @@ magma_zpotrf2_mgpu(
                               d_neg_one, dlA(id, nb*j_local, 0), ldda,
                               d_one,     dlA(id, nb*j_local, j), ldda,
                               queues[id*2+1]);
-                magma_queue_sync( queues[id*2+1] ); // wait for syrk
+                /* wait for syrk */
+                magma_event_record( compute_event[id], queues[id*2+1] );
+                magma_queue_wait_event( queues[id*2], compute_event[id] );
               }
 
               /* update the offdiagonal blocks */
@@ -366,7 +385,8 @@ magma_zpotrf2_mgpu(
                               ldpanel = nb;
 
                               /* wait for offdiagonal row */
-                              magma_queue_sync(queues[d*2]);
+                              magma_event_record( transfer_event[d], queues[d*2] );
+                              magma_queue_wait_event( queues[d*2+1], transfer_event[d] );
                           } else {
                               dlpanel = d_lA[d];
                               dlpanel_offset = dlA_offset(nb*j_local, 0);
@@ -391,7 +411,8 @@ magma_zpotrf2_mgpu(
                                       queues[id*2], &events[id] );
               clFlush(queues[id*2]);
               /* factor the diagonal */
-              magma_queue_sync( queues[id*2] );
+              magma_event_sync( events[id] );
+              magma_event_destroy( events[id] );
               lapackf77_zpotrf(MagmaLowerStr, &jb, Alo(j,j), &lda, info);
               if (*info != 0) {
                   printf("row number: %d\n", (int) j);
@@ -448,8 +469,9 @@ magma_zpotrf2_mgpu(
                       nb2 = n_local[d] - j_local2*nb;
                       nb0 = min(nb, nb2 );
                         
-                      magma_queue_sync(queues[d*2]);
-                      // wait for the diagonal
+                      /* wait for the diagonal */
+                      magma_event_record( transfer_event[d], queues[d*2] );
+                      magma_queue_wait_event( queues[d*2+1], transfer_event[d] );
                       if( j+jb < n && d == (j/nb+1)%num_gpus ) {
                           /* owns the next column, look-ahead the column */
                           magma_ztrsm( MagmaRight, MagmaLower, MagmaConjTrans, MagmaNonUnit, 
@@ -459,7 +481,9 @@ magma_zpotrf2_mgpu(
                                        queues[d*2+1]);
                           /* send the column to cpu */
                           if( j+jb < n ) {
-                              magma_queue_sync( queues[d*2+1] ); // wait for lookahead
+                              /* wait for lookahead */
+                              magma_event_record( compute_event[d], queues[d*2+1] );
+                              magma_queue_wait_event( queues[d*2], compute_event[d] );
                               magma_zgetmatrix_async( nb0, j+jb,
                                                       dlA(d, nb*j_local2, 0), ldda,
                                                       Alo(j+jb,0),            lda, 
@@ -491,6 +515,8 @@ magma_zpotrf2_mgpu(
           for( d=0; d<num_gpus; d++ ) {
               magma_queue_sync( queues[d*2] );
               magma_queue_sync( queues[d*2+1] );
+              magma_event_destroy( transfer_event[d] );
+              magma_event_destroy( compute_event[d]  );
           }
 
     } /* end of not lapack */
@@ -142,7 +142,7 @@ magma_zpotrf2_mgpu(
           /* ---------------------------------------------- */
             printf("support Lower case only!\n");
         } else { 
-            trace_init(1, num_gpus, 2, queues);
+            trace_init(num_gpus, 2, queues);
             /* -------------------------------------------- */
             /* Lower-triangular case                        */
             /* Compute the Cholesky factorization A = L*L'. */
@@ -254,9 +254,9 @@ magma_zpotrf2_mgpu(
               */
               /* factor the diagonal */
               magma_queue_sync( queues[id*2] );
-              trace_cpu_start(0, "potrf", "potrf");
+              trace_cpu_start("potrf", "potrf");
               lapackf77_zpotrf(MagmaLowerStr, &jb, Alo(j,j), &lda, info);
-              trace_cpu_end(0);
+              trace_cpu_end();
               if (*info != 0) {
                   printf("row number: %d\n", j);
                   *info = *info + j;
@@ -368,7 +368,6 @@ magma_zpotrf2_mgpu(
               magma_queue_sync( queues[d*2] );
               magma_queue_sync( queues[d*2+1] );
           }
-          trace_finalize("dpotrf2_mgpu.svg", "trace.css");
 
     } /* end of not lapack */
 
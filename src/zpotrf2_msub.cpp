@@ -94,8 +94,13 @@ magma_zpotrf2_msub(
     size_t dlpanel_offset;
     magma_int_t n_local[MagmaMaxSubs * MagmaMaxGPUs], ldpanel;
 
+    /* events ordering each gpu's transfer queue, queues[2*d],
+       and compute queue, queues[2*d+1] */
+    magma_event_t transfer_event[MagmaMaxGPUs];  /* data arrived on transfer queue */
+    magma_event_t compute_event[MagmaMaxGPUs];   /* update done on compute queue */
+
     // initialize trace
-    trace_init(1, num_gpus, 2, queues);
+    trace_init(num_gpus, 2, queues);
 
     *info = 0;
     if ( (uplo != MagmaUpper) && (uplo != MagmaLower) ) {
@@ -129,6 +134,11 @@ magma_zpotrf2_msub(
         }
     }
 
+    for (d=0; d<num_gpus; d++) {
+        magma_event_create( &transfer_event[d] );
+        magma_event_create( &compute_event[d]  );
+    }
+
     /* Use blocked code. */
     if (uplo == MagmaUpper) {
         /* ---------------------------------------------- */
@@ -152,7 +162,7 @@ magma_zpotrf2_msub(
                                                 Aup(0,j),                lda, 
                                                 dlP(d,jb,0,id%num_gpus), lddp, 
                                                 queues[2*d], 
-                                                trace_gpu_event(d, 0, "set", "set-col") );
+                                                trace_gpu_event("set-col") );
                     }
                     d = (d+1)%num_gpus;
                 }
@@ -162,14 +172,17 @@ magma_zpotrf2_msub(
                             d_neg_one, dlA(id, 0, nb*j_local), ldda,
                             d_one,     dlA(id, j, nb*j_local), ldda,
                             queues[2*(id%num_gpus)+1]);
-                magma_queue_sync(queues[2*(id%num_gpus)+1]); // Wait for syrk
+                trace_gpu_end(id%num_gpus, 1);
+                /* wait for syrk before sending the diagonal */
+                magma_event_record( compute_event[id%num_gpus], queues[2*(id%num_gpus)+1] );
+                magma_queue_wait_event( queues[2*(id%num_gpus)], compute_event[id%num_gpus] );
             }
             /* Send the diagonal to cpu */
             magma_zgetmatrix_async( jb, jb, 
                                     dlA(id, j, nb*j_local), ldda,
                                     Aup(j,j),               lda,
                                     queues[2*(id%num_gpus)], 
-                                    trace_gpu_event(id%num_gpus, 0, "get", "get-diag") );
+                                    trace_gpu_event("get-diag") );
             if (j > 0) {
                 /* Compute the local block column of the panel. */
                 d = (j/nb+1)%tot_subs;
@@ -183,7 +196,10 @@ magma_zpotrf2_msub(
                             dlpanel_offset = dlP_offset(jb, 0, id%num_gpus);
                             ldpanel = lddp;
                             /* Wait for the offdiagonal column */
-                            if (dd < num_gpus) magma_queue_sync(queues[2*(d%num_gpus)]);
+                            if (dd < num_gpus) {
+                                magma_event_record( transfer_event[d%num_gpus], queues[2*(d%num_gpus)] );
+                                magma_queue_wait_event( queues[2*(d%num_gpus)+1], transfer_event[d%num_gpus] );
+                            }
                         } else {
                             dlpanel = d_lA[id];
                             dlpanel_offset = dlA_offset(0, nb*j_local);
@@ -197,15 +213,16 @@ magma_zpotrf2_msub(
                                                dlA(d, 0, nb0), ldda, 
                                     c_one,     dlA(d, j, nb0), ldda,
                                     queues[2*(d%num_gpus)+1]);
+                        trace_gpu_end(d%num_gpus, 1);
                     }
                     d = (d+1)%tot_subs;
                 }
             }
             /* factor the diagonal */
             magma_queue_sync( queues[2*(id%num_gpus)] ); // wait for the diagonal
-            trace_cpu_start(0, "potrf", "potrf");
+            trace_cpu_start("potrf", "potrf");
             lapackf77_zpotrf(MagmaUpperStr, &jb, Aup(j,j), &lda, info);
-            trace_cpu_end(0);
+            trace_cpu_end();
             if (*info != 0) {
                 *info = *info + j;
                 break;
@@ -228,7 +245,7 @@ magma_zpotrf2_msub(
                                             Aup(j,j),                lda,
                                             dlpanel, dlpanel_offset, ldpanel, 
                                             queues[2*d], 
-                                            trace_gpu_event(d, 0, "set", "set-diag"));
+                                            trace_gpu_event("set-diag"));
                     d = (d+1)%num_gpus;
                 }
             } else {
@@ -236,7 +253,7 @@ magma_zpotrf2_msub(
                                         Aup(j,j),               lda, 
                                         dlA(id, j, nb*j_local), ldda,
                                         queues[2*(id%num_gpus)], 
-                                        trace_gpu_event(id%num_gpus, 0, "set", "set-diag") );
+                                        trace_gpu_event("set-diag") );
             }
 
             /* panel-factorize the off-diagonal */
@@ -257,7 +274,11 @@ magma_zpotrf2_msub(
                     }
                     nb2 = n_local[d]-nb*j_local2;
                     nb0 = min(nb, nb2);
-                    if (dd < num_gpus) magma_queue_sync( queues[2*(d%num_gpus)] ); // wait for the diagonal
+                    /* wait for the diagonal */
+                    if (dd < num_gpus) {
+                        magma_event_record( transfer_event[d%num_gpus], queues[2*(d%num_gpus)] );
+                        magma_queue_wait_event( queues[2*(d%num_gpus)+1], transfer_event[d%num_gpus] );
+                    }
                     if (j+jb < m && d == (j/nb+1)%tot_subs) {
                         /* owns the next column, look-ahead the column */
                         trace_gpu_start(d%num_gpus, 1, "trsm", "trsm");
@@ -266,13 +287,16 @@ magma_zpotrf2_msub(
                                      dlpanel, dlpanel_offset, ldpanel,
                                      dlA(d, j, nb*j_local2), ldda, 
                                      queues[2*(d%num_gpus)+1] );
+                        trace_gpu_end(d%num_gpus, 1);
                         /* send the column to cpu */
-                        magma_queue_sync(queues[2*(d%num_gpus)+1]);  // wait for lookahead
+                        /* wait for lookahead */
+                        magma_event_record( compute_event[d%num_gpus], queues[2*(d%num_gpus)+1] );
+                        magma_queue_wait_event( queues[2*(d%num_gpus)], compute_event[d%num_gpus] );
                         magma_zgetmatrix_async( (j+jb), nb0, 
                                                 dlA(d, 0, nb*j_local2), ldda, 
                                                 Aup(0,j+jb),            lda,
                                                 queues[2*(d%num_gpus)], 
-                                                trace_gpu_event(d%num_gpus, 0, "get", "get-col") );
+                                                trace_gpu_event("get-col") );
                         /* update the remaining blocks */
                         nb2 = nb2 - nb0;
                         trace_gpu_start(d%num_gpus, 1, "trsm", "trsm");
@@ -281,6 +305,7 @@ magma_zpotrf2_msub(
                                      dlpanel, dlpanel_offset, ldpanel,
                                      dlA(d, j, nb*j_local2+nb0), ldda, 
                                      queues[2*(d%num_gpus)+1] );
+                        trace_gpu_end(d%num_gpus, 1);
                     } else if (nb2 > 0) {
                         /* update the entire trailing matrix */
                         trace_gpu_start(d%num_gpus, 1, "trsm", "trsm");
@@ -289,6 +314,7 @@ magma_zpotrf2_msub(
                                      dlpanel, dlpanel_offset, ldpanel,
                                      dlA(d, j, nb*j_local2), ldda,
                                      queues[2*(d%num_gpus)+1] );
+                        trace_gpu_end(d%num_gpus, 1);
                     }
                     d = (d+1)%tot_subs;
                 }
@@ -319,7 +345,7 @@ magma_zpotrf2_msub(
                                                 Alo(j,0),                 lda,
                                                 dlPT(d,0,jb,id%num_gpus), nb, 
                                                 queues[2*d], 
-                                                trace_gpu_event(d, 0, "set", "set-row") );
+                                                trace_gpu_event("set-row") );
                     }
                     d = (d+1)%num_gpus;
                 }
@@ -329,14 +355,17 @@ magma_zpotrf2_msub(
                             d_neg_one, dlA(id, nb*j_local, 0), ldda,
                             d_one,     dlA(id, nb*j_local, j), ldda,
                             queues[2*(id%num_gpus)+1]);
-                magma_queue_sync(queues[2*(id%num_gpus)+1]); // wait for syrk
+                trace_gpu_end(id%num_gpus, 1);
+                /* wait for syrk before sending the diagonal */
+                magma_event_record( compute_event[id%num_gpus], queues[2*(id%num_gpus)+1] );
+                magma_queue_wait_event( queues[2*(id%num_gpus)], compute_event[id%num_gpus] );
             }
             /* send the diagonal to cpu */
             magma_zgetmatrix_async( jb, jb,
                                     dlA(id, nb*j_local, j), ldda,
                                     Alo(j,j),               lda, 
                                     queues[2*(id%num_gpus)], 
-                                    trace_gpu_event(id%num_gpus, 0, "get", "get") );
+                                    trace_gpu_event("get") );
             /* update the offdiagonal blocks */
             if (j > 0) {
                 /* compute the block-rows of the panel */
@@ -351,7 +380,10 @@ magma_zpotrf2_msub(
                             dlpanel_offset = dlPT_offset(0, jb, id%num_gpus);
                             ldpanel = nb;
                             /* Wait for offdiagonal row */
-                            if (dd < num_gpus) magma_queue_sync(queues[2*(d%num_gpus)]);
+                            if (dd < num_gpus) {
+                                magma_event_record( transfer_event[d%num_gpus], queues[2*(d%num_gpus)] );
+                                magma_queue_wait_event( queues[2*(d%num_gpus)+1], transfer_event[d%num_gpus] );
+                            }
                         } else {
                             dlpanel = d_lA[id];
                             dlpanel_offset = dlA_offset(nb*j_local, 0);
@@ -365,6 +397,7 @@ magma_zpotrf2_msub(
                                                 dlpanel, dlpanel_offset, ldpanel,
                                      c_one,     dlA(d, nb0, j), ldda, 
                                      queues[2*(d%num_gpus)+1]);
+                        trace_gpu_end(d%num_gpus, 1);
                     }
                     d = (d+1)%tot_subs;
                 }
@@ -372,9 +405,9 @@ magma_zpotrf2_msub(
 
             /* factor the diagonal */
             magma_queue_sync( queues[2*(id%num_gpus)] );
-            trace_cpu_start(0, "potrf", "potrf");
+            trace_cpu_start("potrf", "potrf");
             lapackf77_zpotrf(MagmaLowerStr, &jb, Alo(j,j), &lda, info);
-            trace_cpu_end(0);
+            trace_cpu_end();
             if (*info != 0) {
                 printf( " zpotrf returned %d (id=%d,j=%d,j_local=%d,jb=%d)\n",*info,id,j,j_local,jb );
                 *info = *info + j;
@@ -398,7 +431,7 @@ magma_zpotrf2_msub(
                                             Alo(j,j), lda,
                                             dlpanel,  dlpanel_offset, ldpanel, 
                                             queues[2*d], 
-                                            trace_gpu_event(d, 0, "set", "set-diag") );
+                                            trace_gpu_event("set-diag") );
                     d = (d+1)%num_gpus;
                 }
             } else {
@@ -406,7 +439,7 @@ magma_zpotrf2_msub(
                                         Alo(j,j),               lda,
                                         dlA(id, nb*j_local, j), ldda, 
                                         queues[2*(id%num_gpus)],
-                                        trace_gpu_event(id%num_gpus, 0, "set", "set-diag") );
+                                        trace_gpu_event("set-diag") );
             }
 
             /* factorize off-diagonal blocks */
@@ -428,7 +461,10 @@ magma_zpotrf2_msub(
                     nb2 = n_local[d] - j_local2*nb;
                     nb0 = min(nb, nb2 );
                     // wait for the diagonal
-                    if (dd < num_gpus) magma_queue_sync(queues[2*(d%num_gpus)]);
+                    if (dd < num_gpus) {
+                        magma_event_record( transfer_event[d%num_gpus], queues[2*(d%num_gpus)] );
+                        magma_queue_wait_event( queues[2*(d%num_gpus)+1], transfer_event[d%num_gpus] );
+                    }
                     if (j+jb < n && d == (j/nb+1)%tot_subs) {
                         /* owns the next column, look-ahead the column */
                         trace_gpu_start(d%num_gpus, 1, "trsm", "trsm");
@@ -437,13 +473,16 @@ magma_zpotrf2_msub(
                                      dlpanel,  dlpanel_offset, ldpanel, 
                                      dlA(d, nb*j_local2, j), ldda,
                                      queues[2*(d%num_gpus)+1]);
+                        trace_gpu_end(d%num_gpus, 1);
                         /* send the column to cpu */
-                        magma_queue_sync( queues[2*(d%num_gpus)+1] ); // wait for lookahead
+                        /* wait for lookahead */
+                        magma_event_record( compute_event[d%num_gpus], queues[2*(d%num_gpus)+1] );
+                        magma_queue_wait_event( queues[2*(d%num_gpus)], compute_event[d%num_gpus] );
                         magma_zgetmatrix_async( nb0, j+jb,
                                                 dlA(d, nb*j_local2, 0), ldda,
                                                 Alo(j+jb,0),            lda, 
                                                 queues[2*(d%num_gpus)], 
-                                                trace_gpu_event(d%num_gpus, 0, "get", "get") );
+                                                trace_gpu_event("get") );
                         /* update the remaining blocks */
                         nb2 = nb2 - nb0;
                         trace_gpu_start(d%num_gpus, 1, "trsm", "trsm");
@@ -452,6 +491,7 @@ magma_zpotrf2_msub(
                                      dlpanel, dlpanel_offset, ldpanel, 
                                      dlA(d, nb*j_local2+nb0, j), ldda, 
                                      queues[2*(d%num_gpus)+1]);
+                        trace_gpu_end(d%num_gpus, 1);
                     } else if (nb2 > 0) {
                         /* update the entire trailing matrix */
                         trace_gpu_start(d%num_gpus, 1, "trsm", "trsm");
@@ -460,6 +500,7 @@ magma_zpotrf2_msub(
                                      dlpanel, dlpanel_offset, ldpanel, 
                                      dlA(d, nb*j_local2, j), ldda, 
                                      queues[2*(d%num_gpus)+1]);
+                        trace_gpu_end(d%num_gpus, 1);
                     }
                     d = (d+1)%tot_subs;
                 }
@@ -471,8 +512,9 @@ magma_zpotrf2_msub(
     for( d=0; d<num_gpus; d++ ) {
         magma_queue_sync( queues[2*d] );
         magma_queue_sync( queues[2*d+1] );
+        magma_event_destroy( transfer_event[d] );
+        magma_event_destroy( compute_event[d]  );
     }
 
-    trace_finalize("zpotrf_msub.svg", "trace.css");
     return *info;
 } /* magma_zpotrf2_msub */
@@ -10,6 +10,8 @@
         @precisions normal z -> s d c
 */
 #include "common_magma.h"
+#include "trace.h"
+#include "magma_stats.h"
 
 /**
     Purpose
@@ -85,6 +87,9 @@ magma_zpotrf_gpu(
     double    d_one =  1.0;
     double  d_neg_one = -1.0;
     int upper = (uplo == MagmaUpper);
+    double cpu_time;
+    
+    MAGMA_STATS_ROUTINE();
     
     *info = 0;
     if (! upper && uplo != MagmaLower) {
@@ -101,7 +106,7 @@ magma_zpotrf_gpu(
     
     nb = magma_get_zpotrf_nb( n );
     
-    if (MAGMA_SUCCESS != magma_zmalloc_cpu( &work, nb*nb )) {
+    if (MAGMA_SUCCESS != magma_zmalloc_pinned( &work, nb*nb )) {
         *info = MAGMA_ERR_HOST_ALLOC;
         return *info;
     }
@@ -117,6 +122,7 @@ magma_zpotrf_gpu(
     }
     else {
         // Use blocked code.
+        trace_cpu_start( "driver", __func__ );
         if (upper) {
             // --------------------
             // Compute the Cholesky factorization A = U'*U.
@@ -143,8 +149,12 @@ magma_zpotrf_gpu(
                 
                 // simultaneous with above zgemm, transfer diagonal block,
                 // factor it on CPU, and test for positive definiteness
+                trace_cpu_start( "panel", "potrf" );
                 magma_event_sync( event );
+                cpu_time = magma_wtime();
                 lapackf77_zpotrf( MagmaUpperStr, &jb, work, &jb, info );
+                magma_stats_cpu( magma_wtime() - cpu_time );
+                trace_cpu_end();
                 if ( *info != 0 ) {
                     *info = *info + j;
                     break;
@@ -189,8 +199,12 @@ magma_zpotrf_gpu(
                 
                 // simultaneous with above zgemm, transfer diagonal block,
                 // factor it on CPU, and test for positive definiteness
+                trace_cpu_start( "panel", "potrf" );
                 magma_event_sync( event );
+                cpu_time = magma_wtime();
                 lapackf77_zpotrf( MagmaLowerStr, &jb, work, &jb, info );
+                magma_stats_cpu( magma_wtime() - cpu_time );
+                trace_cpu_end();
                 if ( *info != 0 ) {
                     *info = *info + j;
                     break;
@@ -209,10 +223,11 @@ magma_zpotrf_gpu(
                 }
             }
         }
+        trace_cpu_end();
     }
     
     magma_queue_sync( queue );
-    magma_free_cpu( work );
+    magma_free_pinned( work );
     
     return *info;
 }
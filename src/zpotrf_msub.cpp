@@ -10,11 +10,6 @@
 */
 #include "common_magma.h"
 
-#define USE_PINNED_CLMEMORY
-#ifdef  USE_PINNED_CLMEMORY
-extern cl_context gContext;
-#endif
-
 extern "C" magma_int_t
 magma_zpotrf_msub(
     magma_int_t num_subs, magma_int_t num_gpus, magma_uplo_t uplo, magma_int_t n, 
@@ -120,18 +115,11 @@ magma_zpotrf_msub(
             }
         }
         h = 1; //num_gpus; //magma_ceildiv( n, nb );
-        #ifdef USE_PINNED_CLMEMORY
-        cl_mem buffer = clCreateBuffer(gContext, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sizeof(magmaDoubleComplex)*n*nb*h, NULL, NULL);
-        for (d=0; d<num_gpus; d++) {
-            work = (magmaDoubleComplex*)clEnqueueMapBuffer(queues[2*d], buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, 
-                                                           sizeof(magmaDoubleComplex)*n*nb*h, 0, NULL, NULL, NULL);
-        }
-        #else
-        if (MAGMA_SUCCESS != magma_zmalloc_cpu( &work, n*nb*h )) {
+        if (MAGMA_SUCCESS != magma_zmalloc_pinned( &work, n*nb*h )) {
+            for (d=0; d<num_gpus; d++) magma_free( dwork[d] );
             *info = MAGMA_ERR_HOST_ALLOC;
             return *info;
         }
-        #endif
         if (uplo == MagmaUpper) {
             /* with two queues for each device */
             magma_zpotrf2_msub(num_subs, num_gpus, uplo, n, n, 0, 0, nb, d_lA, 0, ldda, 
@@ -156,14 +144,7 @@ magma_zpotrf_msub(
 
         /* clean up */
         for (d=0; d<num_gpus; d++) magma_free( dwork[d] );
-        #ifdef USE_PINNED_CLMEMORY
-        for (d=0; d<num_gpus; d++) {
-            clEnqueueUnmapMemObject(queues[2*d], buffer, work, 0, NULL, NULL);
-        }
-        clReleaseMemObject( buffer );
-        #else
-        magma_free_cpu( work );
-        #endif
+        magma_free_pinned( work );
     } /* end of not lapack */
 
     return *info;
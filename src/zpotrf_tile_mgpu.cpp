@@ -0,0 +1,567 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <deque>
+#include <vector>
+
+#include "common_magma.h"
+#include "thread_queue.hpp"
+#include "trace.h"
+#include "magma_stats.h"
+
+// Tiles are nb-by-nb blocks of L (or U), indexed by block row and block
+// column of the lower triangle: tile (i,j), i >= j, is L(i,j), or U(j,i) for
+// upper. Tile (i,j) is on device i % ngpu, as local block i / ngpu.
+//
+// Tiles of column k that a device needs from others are kept in its ring
+// slot k % nbuf of d_lP, which has a region of ldl rows (columns for upper)
+// per source device, laid out as that device's local blocks.
+
+// number of ring slots; panels can be this many columns ahead of updates
+const magma_int_t zpotrf_tile_nbuf = 3;
+
+struct zpotrf_tile_data
+{
+    magma_uplo_t            uplo;
+    magma_int_t             ngpu, n, nb, nt, nbuf;
+    magma_int_t             n_local[ MagmaMaxGPUs ];
+    magmaDoubleComplex_ptr* d_lA;
+    size_t                  dA_offset;
+    magma_int_t             ldda;
+    magmaDoubleComplex_ptr  d_lP[ MagmaMaxGPUs ];
+    magma_int_t             ldl;   // rows of a device's region of a slot
+    magma_int_t             lddp;  // ngpu*ldl
+    magmaDoubleComplex*     hP;    // ring of slots on the host
+    magmaDoubleComplex*     hW;    // diagonal tile on the host
+    magma_queue_pool*       pool;
+    magma_int_t*            info;
+    volatile bool           failed;
+
+    // offset in d_lA[d] of local block li of block column j
+    size_t local_offset( magma_int_t li, magma_int_t j ) const
+    {
+        if ( uplo == MagmaLower )
+            return dA_offset + li*nb + j*nb*ldda;
+        else
+            return dA_offset + j*nb + li*nb*ldda;
+    }
+
+    // offset in a slot of local block li of source device s;
+    // same in d_lP and hP
+    size_t slot_offset( magma_int_t k, magma_int_t s, magma_int_t li ) const
+    {
+        size_t offset = (k % nbuf)*lddp*nb;
+        if ( uplo == MagmaLower )
+            return offset + s*ldl + li*nb;
+        else
+            return offset + (s*ldl + li*nb)*nb;
+    }
+
+    // leading dimension of slots
+    magma_int_t ldslot() const
+    {
+        return (uplo == MagmaLower ? lddp : nb);
+    }
+
+    // first local block of device d that is in block row i or below
+    magma_int_t first_local( magma_int_t d, magma_int_t i ) const
+    {
+        return (i + ngpu - 1 - d) / ngpu;
+    }
+
+    // whether device d has local blocks in block row i or below
+    bool has_rows( magma_int_t d, magma_int_t i ) const
+    {
+        return first_local( d, i )*nb < n_local[d];
+    }
+
+    // tile (j,k) as seen by device d: local, or in d's slot for column k
+    void tile( magma_int_t d, magma_int_t j, magma_int_t k,
+               magmaDoubleComplex_ptr* dT, size_t* offset, magma_int_t* ld ) const
+    {
+        if ( j % ngpu == d ) {
+            *dT     = d_lA[d];
+            *offset = local_offset( j / ngpu, k );
+            *ld     = ldda;
+        }
+        else {
+            *dT     = d_lP[d];
+            *offset = slot_offset( k, j % ngpu, j / ngpu );
+            *ld     = ldslot();
+        }
+    }
+};
+
+
+// ----------------------------------------
+// Factors diagonal tile (k,k) on the CPU, and sends it to other devices.
+class zpotrf_tile_potrf_task: public magma_task
+{
+public:
+    zpotrf_tile_potrf_task( zpotrf_tile_data* data, magma_int_t k ):
+        m_data( data ), m_k( k )
+    {}
+
+    virtual void run()
+    {
+        zpotrf_tile_data* data = m_data;
+        if ( data->failed )
+            return;
+
+        magma_int_t k  = m_k;
+        magma_int_t nb = data->nb;
+        magma_int_t kb = min( nb, data->n - k*nb );
+        magma_int_t dk = k % data->ngpu;
+        size_t offset  = data->local_offset( k / data->ngpu, k );
+        magma_int_t iinfo;
+
+        magma_queue_t queue = data->pool->acquire( dk );
+        magma_zgetmatrix( kb, kb, data->d_lA[dk], offset, data->ldda, data->hW, nb, queue );
+        data->pool->release( dk, queue );
+
+        trace_cpu_start( "potrf", "potrf" );
+        lapackf77_zpotrf( lapack_uplo_const( data->uplo ), &kb, data->hW, &nb, &iinfo );
+        trace_cpu_end();
+        if ( iinfo != 0 ) {
+            *data->info  = iinfo + k*nb;
+            data->failed = true;
+            return;
+        }
+
+        queue = data->pool->acquire( dk );
+        magma_zsetmatrix( kb, kb, data->hW, nb, data->d_lA[dk], offset, data->ldda, queue );
+        data->pool->release( dk, queue );
+
+        for( magma_int_t d = 0; d < data->ngpu; ++d ) {
+            if ( d != dk && data->has_rows( d, k+1 )) {
+                queue = data->pool->acquire( d );
+                magma_zsetmatrix( kb, kb, data->hW, nb,
+                                  data->d_lP[d], data->slot_offset( k, dk, k / data->ngpu ),
+                                  data->ldslot(), queue );
+                data->pool->release( d, queue );
+            }
+        }
+    }
+
+private:
+    zpotrf_tile_data* m_data;
+    magma_int_t       m_k;
+};
+
+
+// ----------------------------------------
+// Solves for device d's tiles below the diagonal in column k,
+// and sends them to other devices.
+class zpotrf_tile_trsm_task: public magma_task
+{
+public:
+    zpotrf_tile_trsm_task( zpotrf_tile_data* data, magma_int_t d, magma_int_t k ):
+        m_data( data ), m_d( d ), m_k( k )
+    {}
+
+    virtual void run()
+    {
+        zpotrf_tile_data* data = m_data;
+        if ( data->failed )
+            return;
+
+        magmaDoubleComplex c_one = MAGMA_Z_ONE;
+        magma_int_t d  = m_d;
+        magma_int_t k  = m_k;
+        magma_int_t nb = data->nb;
+        magma_int_t kb = min( nb, data->n - k*nb );
+        magma_int_t li = data->first_local( d, k+1 );
+        magma_int_t mb = data->n_local[d] - li*nb;
+        size_t offset  = data->local_offset( li, k );
+        magmaDoubleComplex* hT = NULL;
+        if ( data->ngpu > 1 )
+            hT = data->hP + data->slot_offset( k, d, li );
+
+        magmaDoubleComplex_ptr dT;
+        size_t dT_offset;
+        magma_int_t lddt;
+        data->tile( d, k, k, &dT, &dT_offset, &lddt );
+
+        magma_queue_t queue = data->pool->acquire( d );
+        data->pool->lock_kernels( "trsm" );
+        if ( data->uplo == MagmaLower ) {
+            magma_ztrsm( MagmaRight, MagmaLower, MagmaConjTrans, MagmaNonUnit,
+                         mb, kb, c_one,
+                         dT, dT_offset, lddt,
+                         data->d_lA[d], offset, data->ldda, queue );
+        }
+        else {
+            magma_ztrsm( MagmaLeft, MagmaUpper, MagmaConjTrans, MagmaNonUnit,
+                         kb, mb, c_one,
+                         dT, dT_offset, lddt,
+                         data->d_lA[d], offset, data->ldda, queue );
+        }
+        data->pool->unlock_kernels( "trsm" );
+        if ( data->ngpu > 1 ) {
+            if ( data->uplo == MagmaLower )
+                magma_zgetmatrix( mb, kb, data->d_lA[d], offset, data->ldda, hT, data->lddp, queue );
+            else
+                magma_zgetmatrix( kb, mb, data->d_lA[d], offset, data->ldda, hT, nb, queue );
+        }
+        else {
+            magma_queue_sync( queue );
+        }
+        data->pool->release( d, queue );
+
+        for( magma_int_t d2 = 0; d2 < data->ngpu; ++d2 ) {
+            if ( d2 != d && data->has_rows( d2, k+1 )) {
+                queue = data->pool->acquire( d2 );
+                if ( data->uplo == MagmaLower )
+                    magma_zsetmatrix( mb, kb, hT, data->lddp,
+                                      data->d_lP[d2], data->slot_offset( k, d, li ), data->lddp, queue );
+                else
+                    magma_zsetmatrix( kb, mb, hT, nb,
+                                      data->d_lP[d2], data->slot_offset( k, d, li ), nb, queue );
+                data->pool->release( d2, queue );
+            }
+        }
+    }
+
+private:
+    zpotrf_tile_data* m_data;
+    magma_int_t       m_d, m_k;
+};
+
+
+// ----------------------------------------
+// Updates device d's tiles of column j, in block row j and below,
+// with column k: A(j:n, j) -= A(j:n, k) * A(j, k)**H.
+class zpotrf_tile_update_task: public magma_task
+{
+public:
+    zpotrf_tile_update_task( zpotrf_tile_data* data, magma_int_t d, magma_int_t j, magma_int_t k ):
+        m_data( data ), m_d( d ), m_j( j ), m_k( k )
+    {}
+
+    virtual void run()
+    {
+        zpotrf_tile_data* data = m_data;
+        if ( data->failed )
+            return;
+
+        magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+        magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+        double             d_one     =  1.0;
+        double             d_neg_one = -1.0;
+        magma_int_t d  = m_d;
+        magma_int_t j  = m_j;
+        magma_int_t k  = m_k;
+        magma_int_t nb = data->nb;
+        magma_int_t jb = min( nb, data->n - j*nb );
+        magma_int_t kb = min( nb, data->n - k*nb );
+        magma_int_t li = data->first_local( d, j );
+        magma_int_t mb = data->n_local[d] - li*nb;
+        magma_int_t ldda = data->ldda;
+        magmaDoubleComplex_ptr dA = data->d_lA[d];
+
+        magmaDoubleComplex_ptr dT;
+        size_t dT_offset;
+        magma_int_t lddt;
+        data->tile( d, j, k, &dT, &dT_offset, &lddt );
+
+        magma_queue_t queue = data->pool->acquire( d );
+        if ( data->uplo == MagmaLower ) {
+            if ( j % data->ngpu == d ) {
+                data->pool->lock_kernels( "herk" );
+                magma_zherk( MagmaLower, MagmaNoTrans, jb, kb,
+                             d_neg_one, dA, data->local_offset( li, k ), ldda,
+                             d_one,     dA, data->local_offset( li, j ), ldda, queue );
+                data->pool->unlock_kernels( "herk" );
+                if ( mb > jb ) {
+                    data->pool->lock_kernels( "gemm" );
+                    magma_zgemm( MagmaNoTrans, MagmaConjTrans, mb-jb, jb, kb,
+                                 c_neg_one, dA, data->local_offset( li+1, k ), ldda,
+                                            dA, data->local_offset( li,   k ), ldda,
+                                 c_one,     dA, data->local_offset( li+1, j ), ldda, queue );
+                    data->pool->unlock_kernels( "gemm" );
+                }
+            }
+            else {
+                data->pool->lock_kernels( "gemm" );
+                magma_zgemm( MagmaNoTrans, MagmaConjTrans, mb, jb, kb,
+                             c_neg_one, dA, data->local_offset( li, k ), ldda,
+                                        dT, dT_offset, lddt,
+                             c_one,     dA, data->local_offset( li, j ), ldda, queue );
+                data->pool->unlock_kernels( "gemm" );
+            }
+        }
+        else {
+            if ( j % data->ngpu == d ) {
+                data->pool->lock_kernels( "herk" );
+                magma_zherk( MagmaUpper, MagmaConjTrans, jb, kb,
+                             d_neg_one, dA, data->local_offset( li, k ), ldda,
+                             d_one,     dA, data->local_offset( li, j ), ldda, queue );
+                data->pool->unlock_kernels( "herk" );
+                if ( mb > jb ) {
+                    data->pool->lock_kernels( "gemm" );
+                    magma_zgemm( MagmaConjTrans, MagmaNoTrans, jb, mb-jb, kb,
+                                 c_neg_one, dA, data->local_offset( li,   k ), ldda,
+                                            dA, data->local_offset( li+1, k ), ldda,
+                                 c_one,     dA, data->local_offset( li+1, j ), ldda, queue );
+                    data->pool->unlock_kernels( "gemm" );
+                }
+            }
+            else {
+                data->pool->lock_kernels( "gemm" );
+                magma_zgemm( MagmaConjTrans, MagmaNoTrans, jb, mb, kb,
+                             c_neg_one, dT, dT_offset, lddt,
+                                        dA, data->local_offset( li, k ), ldda,
+                             c_one,     dA, data->local_offset( li, j ), ldda, queue );
+                data->pool->unlock_kernels( "gemm" );
+            }
+        }
+        magma_queue_sync( queue );
+        data->pool->release( d, queue );
+    }
+
+private:
+    zpotrf_tile_data* m_data;
+    magma_int_t       m_d, m_j, m_k;
+};
+
+
+/**
+    Purpose
+    -------
+    ZPOTRF_TILE computes the Cholesky factorization of a complex Hermitian
+    positive definite matrix dA distributed over multiple GPUs.
+
+    The factorization has the form
+        dA = U**H * U,   if UPLO = MagmaUpper, or
+        dA = L  * L**H,  if UPLO = MagmaLower,
+    where U is an upper triangular matrix and L is lower triangular.
+
+    This is a tile version of the algorithm: the factorization is a DAG of
+    tasks run by a work-stealing magma_thread_queue. Diagonal tiles are
+    factored on the CPU; triangular solves and trailing updates run on the
+    GPUs as soon as their dependencies are done, so updates of later columns
+    overlap the panels. The data distribution is that of magma_zpotrf_mgpu.
+
+    Arguments
+    ---------
+    @param[in]
+    ngpu    INTEGER
+            Number of GPUs to use. ngpu > 0.
+
+    @param[in]
+    uplo    magma_uplo_t
+      -     = MagmaUpper:  Upper triangle of dA is stored;
+      -     = MagmaLower:  Lower triangle of dA is stored.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix dA.  N >= 0.
+
+    @param[in,out]
+    d_lA    COMPLEX_16 array of pointers on the GPU, dimension (ngpu)
+            On entry, the Hermitian matrix dA distributed over GPUs,
+            block-column cyclic if UPLO = MagmaUpper, block-row cyclic if
+            UPLO = MagmaLower, with block size magma_get_zpotrf_nb(n).
+    \n
+            On exit, if INFO = 0, the factor U or L from the Cholesky
+            factorization dA = U**H * U or dA = L * L**H.
+
+    @param[in]
+    dA_offset INTEGER
+            Offset of the local matrices in d_lA.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of the local arrays.
+            LDDA >= max(1,N) if UPLO = MagmaUpper; if UPLO = MagmaLower,
+            LDDA >= number of rows local to a GPU.
+
+    @param[in]
+    queues  magma_queue_t array, dimension (2*ngpu)
+            Queues 2*d and 2*d+1 are on GPU d.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+      -     > 0:  if INFO = i, the leading minor of order i is not
+                  positive definite, and the factorization could not be
+                  completed.
+
+    @ingroup magma_zposv_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zpotrf_tile_mgpu(
+    magma_int_t ngpu, magma_uplo_t uplo, magma_int_t n,
+    magmaDoubleComplex_ptr *d_lA, size_t dA_offset,
+    magma_int_t ldda,
+    magma_queue_t *queues,
+    magma_int_t *info )
+{
+    magma_int_t d, d2, j, k, nb, nt, maxrows;
+    zpotrf_tile_data data;
+
+    MAGMA_STATS_ROUTINE();
+
+    *info = 0;
+    nb = magma_get_zpotrf_nb( n );
+    maxrows = nb*(n/(nb*ngpu));
+    if ( n % (nb*ngpu) != 0 )
+        maxrows += min( nb, n - ngpu*maxrows );
+    if ( ngpu < 1 || ngpu > MagmaMaxGPUs ) {
+        *info = -1;
+    } else if ( uplo != MagmaUpper && uplo != MagmaLower ) {
+        *info = -2;
+    } else if ( n < 0 ) {
+        *info = -3;
+    } else if ( uplo == MagmaLower && ldda < max( 1, maxrows )) {
+        *info = -6;
+    } else if ( uplo == MagmaUpper && ldda < max( 1, n )) {
+        *info = -6;
+    }
+    if ( *info != 0 ) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    /* Quick return if possible */
+    if ( n == 0 )
+        return *info;
+
+    nt = magma_ceildiv( n, nb );
+
+    data.uplo      = uplo;
+    data.ngpu      = ngpu;
+    data.n         = n;
+    data.nb        = nb;
+    data.nt        = nt;
+    data.nbuf      = zpotrf_tile_nbuf;
+    data.d_lA      = d_lA;
+    data.dA_offset = dA_offset;
+    data.ldda      = ldda;
+    data.ldl       = magma_ceildiv( nt, ngpu )*nb;
+    data.lddp      = ngpu*data.ldl;
+    data.hP        = NULL;
+    data.hW        = NULL;
+    data.info      = info;
+    data.failed    = false;
+    for( d = 0; d < ngpu; ++d ) {
+        data.n_local[d] = ((n/nb)/ngpu)*nb;
+        if ( d < (n/nb) % ngpu )
+            data.n_local[d] += nb;
+        else if ( d == (n/nb) % ngpu )
+            data.n_local[d] += n % nb;
+        data.d_lP[d] = NULL;
+    }
+
+    /* allocate workspace */
+    if ( ngpu > 1 ) {
+        for( d = 0; d < ngpu; ++d ) {
+            if ( MAGMA_SUCCESS != magma_zmalloc( &data.d_lP[d], data.nbuf*data.lddp*nb )) {
+                for( d2 = 0; d2 < d; ++d2 ) {
+                    magma_free( data.d_lP[d2] );
+                }
+                *info = MAGMA_ERR_DEVICE_ALLOC;
+                return *info;
+            }
+        }
+        if ( MAGMA_SUCCESS != magma_zmalloc_pinned( &data.hP, data.nbuf*data.lddp*nb )) {
+            for( d = 0; d < ngpu; ++d ) {
+                magma_free( data.d_lP[d] );
+            }
+            *info = MAGMA_ERR_HOST_ALLOC;
+            return *info;
+        }
+    }
+    if ( MAGMA_SUCCESS != magma_zmalloc_pinned( &data.hW, nb*nb )) {
+        if ( ngpu > 1 ) {
+            for( d = 0; d < ngpu; ++d ) {
+                magma_free( data.d_lP[d] );
+            }
+            magma_free_pinned( data.hP );
+        }
+        *info = MAGMA_ERR_HOST_ALLOC;
+        return *info;
+    }
+
+    /* one thread for panels, and one for each queue */
+    magma_queue_pool pool( ngpu, 2, queues );
+    data.pool = &pool;
+
+    magma_thread_queue tasks;
+    tasks.launch( 2*ngpu + 1 );
+
+    /* latest task updating device d's part of column j is update[ d*nt + j ] */
+    std::vector< magma_task* > update( ngpu*nt, (magma_task*) NULL );
+    std::vector< magma_task* > trsm( ngpu, (magma_task*) NULL );
+    std::vector< magma_task* > done( nt, (magma_task*) NULL );
+    std::vector< magma_task* > deps;
+
+    for( k = 0; k < nt; ++k ) {
+        magma_int_t dk = k % ngpu;
+
+        /* factor diagonal tile, after its updates and after the slot it
+         * sends to is free */
+        deps.clear();
+        deps.push_back( update[ dk*nt + k ] );
+        if ( k >= data.nbuf )
+            deps.push_back( done[ k - data.nbuf ] );
+        magma_task* potrf = new zpotrf_tile_potrf_task( &data, k );
+        tasks.push_task( potrf, 3*nt, deps.size(), &deps[0] );
+
+        /* triangular solves for the tiles below it */
+        for( d = 0; d < ngpu; ++d ) {
+            trsm[d] = NULL;
+            if ( data.has_rows( d, k+1 )) {
+                deps.clear();
+                deps.push_back( potrf );
+                deps.push_back( update[ d*nt + k ] );
+                trsm[d] = new zpotrf_tile_trsm_task( &data, d, k );
+                tasks.push_task( trsm[d], 2*nt, deps.size(), &deps[0] );
+            }
+        }
+
+        /* updates of later columns; the next column first */
+        std::vector< magma_task* > readers( trsm.begin(), trsm.end() );
+        for( j = k+1; j < nt; ++j ) {
+            for( d = 0; d < ngpu; ++d ) {
+                if ( data.has_rows( d, j )) {
+                    deps.clear();
+                    deps.push_back( trsm[d] );
+                    deps.push_back( trsm[ j % ngpu ] );
+                    deps.push_back( update[ d*nt + j ] );
+                    update[ d*nt + j ] = new zpotrf_tile_update_task( &data, d, j, k );
+                    tasks.push_task( update[ d*nt + j ],
+                                     (j == k+1 ? 2*nt - 1 : nt - (j - k)),
+                                     deps.size(), &deps[0] );
+                    readers.push_back( update[ d*nt + j ] );
+                }
+            }
+        }
+
+        /* slot k % nbuf is free once column k's tasks are done */
+        if ( ngpu > 1 && k + data.nbuf < nt ) {
+            done[k] = new magma_empty_task();
+            tasks.push_task( done[k], 0, readers.size(), &readers[0] );
+        }
+    }
+    tasks.sync();
+    tasks.quit();
+
+    /* clean up */
+    if ( ngpu > 1 ) {
+        for( d = 0; d < ngpu; ++d ) {
+            magma_free( data.d_lP[d] );
+        }
+        magma_free_pinned( data.hP );
+    }
+    magma_free_pinned( data.hW );
+
+    return *info;
+} /* magma_zpotrf_tile_mgpu */
@@ -0,0 +1,653 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Mark Gates
+
+       @precisions normal z -> c
+
+*/
+#include <deque>
+#include <vector>
+
+#include "common_magma.h"
+#include "thread_queue.hpp"
+
+#define PRECISION_z
+
+// Order of the diagonal blocks of T that zlatrs solves; the rest of each
+// triangular solve is done by zgemv.
+const magma_int_t ztrevc3_bs = 32;
+
+// Number of eigenvectors computed, and back-transformed by one zgemm,
+// per block (if LWORK allows).
+const magma_int_t ztrevc3_nb = 64;
+
+struct ztrevc3_data
+{
+    magma_int_t               n;
+    const magmaDoubleComplex* T;
+    magma_int_t               ldt;
+    const double*             cnorm;      ///< cnorm[j] = sum |T(0:j-1, j)|
+    double                    cnorm_max;  ///< max cnorm[j]
+    double                    ulp;
+    double                    smlnum;
+    double                    bignum;
+};
+
+
+// ----------------------------------------
+// Copies the jb-by-jb diagonal block T(j0:j0+jb-1, j0:j0+jb-1) to Tjj,
+// and subtracts lambda from its diagonal, perturbing diagonal entries
+// smaller than smin to smin, as ztrevc does.
+static void
+ztrevc3_shifted_block(
+    const ztrevc3_data* data, magma_int_t j0, magma_int_t jb,
+    magmaDoubleComplex lambda, double smin, magmaDoubleComplex* Tjj )
+{
+    #define T(i_, j_) (data->T + (i_) + (j_)*data->ldt)
+
+    for( magma_int_t j = 0; j < jb; ++j ) {
+        for( magma_int_t i = 0; i < j; ++i ) {
+            Tjj[i + j*jb] = *T(j0+i, j0+j);
+        }
+        magmaDoubleComplex d = *T(j0+j, j0+j) - lambda;
+        if ( MAGMA_Z_ABS1( d ) < smin ) {
+            d = MAGMA_Z_MAKE( smin, 0. );
+        }
+        Tjj[j + j*jb] = d;
+    }
+
+    #undef T
+}
+
+
+// ----------------------------------------
+// Computes in x the right eigenvector of T for eigenvalue T(ki,ki),
+// as a vector of length n, unnormalized, with x(ki+1:n-1) = 0:
+// it solves (T(0:ki-1, 0:ki-1) - T(ki,ki) I) x = -T(0:ki-1, ki) upwards,
+// by zlatrs on diagonal blocks and zgemv on the blocks above them.
+static void
+ztrevc3_right_vector(
+    const ztrevc3_data* data, magma_int_t ki, magmaDoubleComplex* x )
+{
+    #define T(i_, j_) (data->T + (i_) + (j_)*data->ldt)
+
+    const magmaDoubleComplex c_zero    = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    const magma_int_t ione = 1;
+
+    magmaDoubleComplex Tjj[ ztrevc3_bs*ztrevc3_bs ];
+    double cnorm[ ztrevc3_bs ];
+    double scale, xnorm, tnorm, rec;
+    magma_int_t j0, j1, jb, k, nr, iinfo;
+
+    magma_int_t n   = data->n;
+    magma_int_t ldt = data->ldt;
+    magma_int_t nx  = ki + 1;
+
+    magmaDoubleComplex lambda = *T(ki, ki);
+    double smin = max( data->ulp * MAGMA_Z_ABS1( lambda ), data->smlnum );
+
+    for( k = 0; k < ki; ++k ) {
+        x[k] = -( *T(k, ki) );
+    }
+    x[ki] = c_one;
+    for( k = ki+1; k < n; ++k ) {
+        x[k] = c_zero;
+    }
+
+    for( j1 = ki; j1 > 0; j1 = j0 ) {
+        j0 = max( 0, j1 - ztrevc3_bs );
+        jb = j1 - j0;
+
+        ztrevc3_shifted_block( data, j0, jb, lambda, smin, Tjj );
+        lapackf77_zlatrs( MagmaUpperStr, MagmaNoTransStr, MagmaNonUnitStr, "N",
+                          &jb, Tjj, &jb, &x[j0], &scale, cnorm, &iinfo );
+        if ( scale != 1. ) {
+            // zlatrs scaled x(j0:j1-1); scale x(0:j0-1) and x(j1:ki) to match
+            nr = nx - j1;
+            blasf77_zdscal( &j0, &scale, x,     &ione );
+            blasf77_zdscal( &nr, &scale, &x[j1], &ione );
+        }
+
+        if ( j0 > 0 ) {
+            // rescale x if x(0:j0-1) -= T(0:j0-1, j0:j1-1) x(j0:j1-1) could overflow
+            xnorm = 0.;
+            tnorm = 0.;
+            for( k = j0; k < j1; ++k ) {
+                xnorm  = max( xnorm, MAGMA_Z_ABS1( x[k] ));
+                tnorm += data->cnorm[k];
+            }
+            if ( xnorm > 1. && tnorm > data->bignum / xnorm ) {
+                rec = 1. / xnorm;
+                blasf77_zdscal( &nx, &rec, x, &ione );
+            }
+            blasf77_zgemv( MagmaNoTransStr, &j0, &jb,
+                           &c_neg_one, T(0, j0), &ldt,
+                                       &x[j0],   &ione,
+                           &c_one,     x,        &ione );
+        }
+    }
+
+    #undef T
+}
+
+
+// ----------------------------------------
+// Computes in x the left eigenvector of T for eigenvalue T(ki,ki),
+// as a vector of length n, unnormalized, with x(0:ki-1) = 0:
+// it solves (T(ki+1:n-1, ki+1:n-1) - T(ki,ki) I)^H x = -T(ki, ki+1:n-1)^H
+// downwards, by zlatrs on diagonal blocks and zgemv on the blocks right of
+// them.
+static void
+ztrevc3_left_vector(
+    const ztrevc3_data* data, magma_int_t ki, magmaDoubleComplex* x )
+{
+    #define T(i_, j_) (data->T + (i_) + (j_)*data->ldt)
+
+    const magmaDoubleComplex c_zero    = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    const magma_int_t ione = 1;
+
+    magmaDoubleComplex Tjj[ ztrevc3_bs*ztrevc3_bs ];
+    double cnorm[ ztrevc3_bs ];
+    double scale, xnorm, rec;
+    magma_int_t j0, j1, jb, k, nl, nr, iinfo;
+
+    magma_int_t n   = data->n;
+    magma_int_t ldt = data->ldt;
+    magma_int_t nx  = n - ki;
+
+    magmaDoubleComplex lambda = *T(ki, ki);
+    double smin = max( data->ulp * MAGMA_Z_ABS1( lambda ), data->smlnum );
+
+    for( k = 0; k < ki; ++k ) {
+        x[k] = c_zero;
+    }
+    x[ki] = c_one;
+    for( k = ki+1; k < n; ++k ) {
+        x[k] = -MAGMA_Z_CNJG( *T(ki, k) );
+    }
+
+    for( j0 = ki+1; j0 < n; j0 = j1 ) {
+        j1 = min( n, j0 + ztrevc3_bs );
+        jb = j1 - j0;
+
+        ztrevc3_shifted_block( data, j0, jb, lambda, smin, Tjj );
+        lapackf77_zlatrs( MagmaUpperStr, MagmaConjTransStr, MagmaNonUnitStr, "N",
+                          &jb, Tjj, &jb, &x[j0], &scale, cnorm, &iinfo );
+        if ( scale != 1. ) {
+            // zlatrs scaled x(j0:j1-1); scale x(ki:j0-1) and x(j1:n-1) to match
+            nl = j0 - ki;
+            nr = n  - j1;
+            blasf77_zdscal( &nl, &scale, &x[ki], &ione );
+            blasf77_zdscal( &nr, &scale, &x[j1], &ione );
+        }
+
+        if ( j1 < n ) {
+            // rescale x if x(j1:n-1) -= T(j0:j1-1, j1:n-1)^H x(j0:j1-1) could overflow
+            xnorm = 0.;
+            for( k = j0; k < j1; ++k ) {
+                xnorm = max( xnorm, MAGMA_Z_ABS1( x[k] ));
+            }
+            if ( xnorm > 1. && data->cnorm_max > data->bignum / xnorm ) {
+                rec = 1. / xnorm;
+                blasf77_zdscal( &nx, &rec, &x[ki], &ione );
+            }
+            nr = n - j1;
+            blasf77_zgemv( MagmaConjTransStr, &jb, &nr,
+                           &c_neg_one, T(j0, j1), &ldt,
+                                       &x[j0],    &ione,
+                           &c_one,     &x[j1],    &ione );
+        }
+    }
+
+    #undef T
+}
+
+
+// ----------------------------------------
+// Computes one eigenvector in a thread of the queue.
+class ztrevc3_task: public magma_task
+{
+public:
+    ztrevc3_task( const ztrevc3_data* data, magma_side_t side, magma_int_t ki,
+                  magmaDoubleComplex* x ):
+        m_data( data ), m_side( side ), m_ki( ki ), m_x( x )
+    {}
+
+    virtual void run()
+    {
+        magma_set_lapack_numthreads( 1 );
+        if ( m_side == MagmaRight ) {
+            ztrevc3_right_vector( m_data, m_ki, m_x );
+        }
+        else {
+            ztrevc3_left_vector( m_data, m_ki, m_x );
+        }
+    }
+
+private:
+    const ztrevc3_data* m_data;
+    magma_side_t        m_side;
+    magma_int_t         m_ki;
+    magmaDoubleComplex* m_x;
+};
+
+
+// ----------------------------------------
+// Computes the right (side = MagmaRight) or left (side = MagmaLeft)
+// eigenvectors selected by howmany and select into V, nb at a time.
+// The eigenvectors of block b+1 are solved by the threads of tasks into
+// X(:, ((b+1)%2)*nb : ((b+1)%2)*nb + nb-1), while the host thread
+// back-transforms those of block b with a zgemm on the device: V = Q X,
+// where Q was in V on entry. dwork holds Q, then the blocks of X and Q X.
+static void
+ztrevc3_vectors(
+    magma_side_t side, magma_vec_t howmany, const magma_int_t *select,
+    const ztrevc3_data* data,
+    magmaDoubleComplex *V, magma_int_t ldv,
+    magmaDoubleComplex *X, magma_int_t nb,
+    magmaDoubleComplex_ptr dwork, magma_int_t lddq,
+    magma_thread_queue& tasks,
+    magma_queue_t queue )
+{
+    #define V(i_, j_) (V + (i_) + (j_)*ldv)
+    #define dQ(i_, j_) dwork, ((i_) + (j_)*lddq)
+    #define dX(i_, j_) dwork, ((i_) + (j_)*lddq + n*lddq)
+    #define dV(i_, j_) dwork, ((i_) + (j_)*lddq + (n + nb)*lddq)
+
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+    const magma_int_t ione = 1;
+
+    magma_int_t n = data->n;
+    bool backtransform = (howmany == MagmaBacktransVec);
+
+    // eigenvectors to compute, in the order of their columns in V
+    std::vector< magma_int_t > kis;
+    for( magma_int_t ki = 0; ki < n; ++ki ) {
+        if ( howmany != MagmaSomeVec || select[ki] ) {
+            kis.push_back( ki );
+        }
+    }
+    magma_int_t m = kis.size();
+    if ( m == 0 )
+        return;
+    magma_int_t nblock = magma_ceildiv( m, nb );
+
+    if ( backtransform ) {
+        magma_zsetmatrix( n, n, V, ldv, dQ(0,0), lddq, queue );
+    }
+
+    for( magma_int_t j = 0; j < min( nb, m ); ++j ) {
+        tasks.push_task( new ztrevc3_task( data, side, kis[j], X + j*n ));
+    }
+    tasks.sync();
+
+    for( magma_int_t b = 0; b < nblock; ++b ) {
+        // solve the next block while this one is back-transformed
+        if ( b+1 < nblock ) {
+            magmaDoubleComplex *Xn = X + ((b+1) % 2)*nb*n;
+            for( magma_int_t j = (b+1)*nb; j < min( (b+2)*nb, m ); ++j ) {
+                tasks.push_task( new ztrevc3_task( data, side, kis[j],
+                                                   Xn + (j - (b+1)*nb)*n ));
+            }
+        }
+
+        magmaDoubleComplex *Xb = X + (b % 2)*nb*n;
+        magma_int_t j0 = b*nb;
+        magma_int_t jb = min( nb, m - j0 );
+
+        // column j0 of V: in backtransform and all cases, kis[j] = j
+        if ( backtransform ) {
+            if ( side == MagmaRight ) {
+                // x(k1:n-1) = 0 for all x in the block
+                magma_int_t k1 = kis[j0 + jb - 1] + 1;
+                magma_zsetmatrix( k1, jb, Xb, n, dX(0,0), lddq, queue );
+                magma_zgemm( MagmaNoTrans, MagmaNoTrans, n, jb, k1,
+                             c_one,  dQ(0,0), lddq,
+                                     dX(0,0), lddq,
+                             c_zero, dV(0,0), lddq, queue );
+            }
+            else {
+                // x(0:k0-1) = 0 for all x in the block
+                magma_int_t k0 = kis[j0];
+                magma_zsetmatrix( n-k0, jb, Xb + k0, n, dX(0,0), lddq, queue );
+                magma_zgemm( MagmaNoTrans, MagmaNoTrans, n, jb, n-k0,
+                             c_one,  dQ(0,k0), lddq,
+                                     dX(0,0),  lddq,
+                             c_zero, dV(0,0),  lddq, queue );
+            }
+            magma_zgetmatrix( n, jb, dV(0,0), lddq, V(0,j0), ldv, queue );
+        }
+        else {
+            lapackf77_zlacpy( "F", &n, &jb, Xb, &n, V(0,j0), &ldv );
+        }
+
+        // normalize so that the element of largest magnitude has magnitude 1
+        for( magma_int_t j = j0; j < j0 + jb; ++j ) {
+            double emax = 0.;
+            for( magma_int_t k = 0; k < n; ++k ) {
+                emax = max( emax, MAGMA_Z_ABS1( *V(k,j) ));
+            }
+            double remax = 1. / emax;
+            blasf77_zdscal( &n, &remax, V(0,j), &ione );
+        }
+
+        tasks.sync();
+    }
+
+    #undef V
+    #undef dQ
+    #undef dX
+    #undef dV
+}
+
+
+/**
+    Purpose
+    -------
+    ZTREVC3_MT_GPU computes some or all of the right and/or left eigenvectors
+    of a complex upper triangular matrix T.
+    Matrices of this type are produced by the Schur factorization of
+    a complex general matrix:  A = Q*T*Q**H, as computed by ZHSEQR.
+
+    The right eigenvector x and the left eigenvector y of T corresponding
+    to an eigenvalue w are defined by:
+
+                 T*x = w*x,     (y**H)*T = w*(y**H)
+
+    where y**H denotes the conjugate transpose of the vector y.
+    The eigenvalues are not input to this routine, but are read directly
+    from the diagonal of T.
+
+    This routine returns the matrices X and/or Y of right and left
+    eigenvectors of T, or the products Q*X and/or Q*Y, where Q is an
+    input matrix. If Q is the unitary factor that reduces a matrix A to
+    Schur form T, then Q*X and Q*Y are the matrices of right and left
+    eigenvectors of A.
+
+    The eigenvectors are solved concurrently, one per task of a
+    magma_thread_queue with magma_get_parallel_numthreads() threads, each
+    by zlatrs on 32-by-32 diagonal blocks of T and zgemv on the rest.
+    The solves are level 2, one eigenvector at a time, as in LAPACK's
+    ztrevc3; only the back-transform is blocked.
+    They are back-transformed in blocks of up to 64, by a zgemm with Q on
+    the device, which overlaps the solves of the next block.
+    If the device memory for Q cannot be allocated, LAPACK's ztrevc is
+    called instead.
+
+    Arguments
+    ---------
+    @param[in]
+    side    magma_side_t
+      -     = MagmaRight:      compute right eigenvectors only;
+      -     = MagmaLeft:       compute left eigenvectors only;
+      -     = MagmaBothSides:  compute both right and left eigenvectors.
+
+    @param[in]
+    howmany magma_vec_t
+      -     = MagmaAllVec:        compute all right and/or left eigenvectors;
+      -     = MagmaBacktransVec:  compute all right and/or left eigenvectors,
+                                  backtransformed by the matrices in VR and/or VL;
+      -     = MagmaSomeVec:       compute selected right and/or left eigenvectors,
+                                  as indicated by the logical array select.
+
+    @param[in]
+    select  INTEGER array, dimension (N)
+            If howmany = MagmaSomeVec, select specifies the eigenvectors to be
+            computed.
+            The eigenvector corresponding to the j-th eigenvalue is
+            computed if select[j] is true.
+            Not referenced if howmany = MagmaAllVec or MagmaBacktransVec.
+
+    @param[in]
+    n       INTEGER
+            The order of the matrix T. N >= 0.
+
+    @param[in]
+    T       COMPLEX_16 array, dimension (LDT,N)
+            The upper triangular matrix T.
+
+    @param[in]
+    ldt     INTEGER
+            The leading dimension of the array T. LDT >= max(1,N).
+
+    @param[in,out]
+    VL      COMPLEX_16 array, dimension (LDVL,MM)
+            On entry, if side = MagmaLeft or MagmaBothSides and
+            howmany = MagmaBacktransVec, VL must contain an N-by-N matrix Q
+            (usually the unitary matrix Q of Schur vectors returned by ZHSEQR).
+            On exit, if side = MagmaLeft or MagmaBothSides, VL contains:
+            if howmany = MagmaAllVec, the matrix Y of left eigenvectors of T;
+            if howmany = MagmaBacktransVec, the matrix Q*Y;
+            if howmany = MagmaSomeVec, the left eigenvectors of T specified by
+                         select, stored consecutively in the columns
+                         of VL, in the same order as their eigenvalues.
+            Not referenced if side = MagmaRight.
+
+    @param[in]
+    ldvl    INTEGER
+            The leading dimension of the array VL.
+            LDVL >= 1, and if side = MagmaLeft or MagmaBothSides, LDVL >= N.
+
+    @param[in,out]
+    VR      COMPLEX_16 array, dimension (LDVR,MM)
+            On entry, if side = MagmaRight or MagmaBothSides and
+            howmany = MagmaBacktransVec, VR must contain an N-by-N matrix Q
+            (usually the unitary matrix Q of Schur vectors returned by ZHSEQR).
+            On exit, if side = MagmaRight or MagmaBothSides, VR contains:
+            if howmany = MagmaAllVec, the matrix X of right eigenvectors of T;
+            if howmany = MagmaBacktransVec, the matrix Q*X;
+            if howmany = MagmaSomeVec, the right eigenvectors of T specified by
+                         select, stored consecutively in the columns
+                         of VR, in the same order as their eigenvalues.
+            Not referenced if side = MagmaLeft.
+
+    @param[in]
+    ldvr    INTEGER
+            The leading dimension of the array VR.
+            LDVR >= 1, and if side = MagmaRight or MagmaBothSides, LDVR >= N.
+
+    @param[in]
+    mm      INTEGER
+            The number of columns in the arrays VL and/or VR. MM >= M.
+
+    @param[out]
+    mout    INTEGER
+            The number of columns in the arrays VL and/or VR actually
+            used to store the eigenvectors.
+            If howmany = MagmaAllVec or MagmaBacktransVec, M is set to N.
+            Each selected eigenvector occupies one column.
+
+    @param
+    work    (workspace) COMPLEX_16 array, dimension (MAX(1,LWORK))
+            On exit, if INFO = 0, WORK[0] returns the optimal LWORK.
+
+    @param[in]
+    lwork   INTEGER
+            The dimension of array WORK. LWORK >= max(1,2*N).
+            For optimum performance, LWORK >= 2*N*64; with less, fewer
+            eigenvectors are computed per block.
+    \n
+            If LWORK = -1, then a workspace query is assumed; the routine
+            only calculates the optimal size of the WORK array, returns
+            this value as the first entry of the WORK array, and no error
+            message related to LWORK is issued by XERBLA.
+
+    @param
+    rwork   (workspace) DOUBLE PRECISION array, dimension (N)
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+
+    Further Details
+    ---------------
+    The algorithm used in this program is basically backward (forward)
+    substitution, with scaling to make the code robust against
+    possible overflow.
+
+    Each eigenvector is normalized so that the element of largest
+    magnitude has magnitude 1; here the magnitude of a complex number
+    (x,y) is taken to be |x| + |y|.
+
+    @ingroup magma_zgeev_comp
+    ********************************************************************/
+extern "C" magma_int_t
+magma_ztrevc3_mt_gpu(
+    magma_side_t side, magma_vec_t howmany,
+    magma_int_t *select,  // logical in fortran
+    magma_int_t n,
+    magmaDoubleComplex *T,  magma_int_t ldt,
+    magmaDoubleComplex *VL, magma_int_t ldvl,
+    magmaDoubleComplex *VR, magma_int_t ldvr,
+    magma_int_t mm, magma_int_t *mout,
+    magmaDoubleComplex *work, magma_int_t lwork,
+    double *rwork,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define T(i_, j_) (T + (i_) + (j_)*ldt)
+
+    // Decode and test the input parameters
+    bool rightv = (side == MagmaRight || side == MagmaBothSides);
+    bool leftv  = (side == MagmaLeft  || side == MagmaBothSides);
+
+    bool allv  = (howmany == MagmaAllVec);
+    bool over  = (howmany == MagmaBacktransVec);
+    bool somev = (howmany == MagmaSomeVec);
+
+    // Set mout to the number of columns required to store the selected
+    // eigenvectors.
+    if ( somev ) {
+        *mout = 0;
+        for( magma_int_t j = 0; j < n; ++j ) {
+            if ( select[j] ) {
+                ++*mout;
+            }
+        }
+    }
+    else {
+        *mout = n;
+    }
+
+    magma_int_t lwmin = max( 1, 2*n );
+    magma_int_t lwopt = max( lwmin, 2*n*ztrevc3_nb );
+    work[0] = MAGMA_Z_MAKE( lwopt, 0. );
+    bool lquery = (lwork == -1);
+
+    *info = 0;
+    if ( ! rightv && ! leftv ) {
+        *info = -1;
+    }
+    else if ( ! allv && ! over && ! somev ) {
+        *info = -2;
+    }
+    else if ( n < 0 ) {
+        *info = -4;
+    }
+    else if ( ldt < max( 1, n )) {
+        *info = -6;
+    }
+    else if ( ldvl < 1 || ( leftv && ldvl < n )) {
+        *info = -8;
+    }
+    else if ( ldvr < 1 || ( rightv && ldvr < n )) {
+        *info = -10;
+    }
+    else if ( mm < *mout ) {
+        *info = -11;
+    }
+    else if ( lwork < lwmin && ! lquery ) {
+        *info = -14;
+    }
+
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+    else if ( lquery ) {
+        return *info;
+    }
+
+    // Quick return if possible
+    if ( n == 0 ) {
+        return *info;
+    }
+
+    // eigenvectors per block, as many as fit two blocks in work
+    magma_int_t nb = max( 1, min( ztrevc3_nb, lwork / (2*n) ));
+
+    // Set the constants to control overflow.
+    double unfl = lapackf77_dlamch( "Safe minimum" );
+    double ovfl = 1. / unfl;
+    lapackf77_dlabad( &unfl, &ovfl );
+    double ulp    = lapackf77_dlamch( "Precision" );
+    double smlnum = unfl*( n / ulp );
+
+    // Store the 1-norm of each column of the strictly upper triangular
+    // part of T to control overflow in the triangular solves.
+    rwork[0] = 0.;
+    double cnorm_max = 0.;
+    for( magma_int_t j = 1; j < n; ++j ) {
+        rwork[j] = magma_cblas_dzasum( j, T(0,j), 1 );
+        cnorm_max = max( cnorm_max, rwork[j] );
+    }
+
+    ztrevc3_data data;
+    data.n         = n;
+    data.T         = T;
+    data.ldt       = ldt;
+    data.cnorm     = rwork;
+    data.cnorm_max = cnorm_max;
+    data.ulp       = ulp;
+    data.smlnum    = smlnum;
+    data.bignum    = ( 1. - ulp ) / smlnum;
+
+    // Q and the blocks of X and Q*X on the device
+    magma_int_t lddq = magma_roundup( n, 32 );
+    magmaDoubleComplex_ptr dwork=NULL;
+    if ( over && MAGMA_SUCCESS != magma_zmalloc( &dwork, lddq*(n + 2*nb) )) {
+        // alloc failed so call LAPACK
+        lapackf77_ztrevc( lapack_side_const(side), "B", select, &n, T, &ldt,
+                          VL, &ldvl, VR, &ldvr, &mm, mout, work, rwork, info );
+        return *info;
+    }
+
+    magma_int_t nthread_save = magma_get_lapack_numthreads();
+    magma_int_t nthread = max( 1, magma_get_parallel_numthreads() );
+
+    magma_thread_queue tasks;
+    tasks.launch( nthread );
+
+    if ( rightv ) {
+        ztrevc3_vectors( MagmaRight, howmany, select, &data, VR, ldvr,
+                         work, nb, dwork, lddq, tasks, queue );
+    }
+    if ( leftv ) {
+        ztrevc3_vectors( MagmaLeft,  howmany, select, &data, VL, ldvl,
+                         work, nb, dwork, lddq, tasks, queue );
+    }
+
+    tasks.quit();
+    magma_set_lapack_numthreads( nthread_save );
+
+    if ( over ) {
+        magma_free( dwork );
+    }
+
+    return *info;
+} /* magma_ztrevc3_mt_gpu */
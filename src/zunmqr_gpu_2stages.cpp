@@ -0,0 +1,209 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Azzam Haidar
+       @author Mark Gates
+
+       @precisions normal z -> s d c
+
+*/
+#include "common_magma.h"
+
+/**
+    Purpose
+    -------
+    ZUNMQR_GPU_2STAGES overwrites the general complex M-by-N matrix C with
+
+                                SIDE = MagmaLeft    SIDE = MagmaRight
+    TRANS = MagmaNoTrans:       Q * C               C * Q
+    TRANS = Magma_ConjTrans:    Q**H * C            C**H * Q
+
+    where Q is a complex unitary matrix defined as the product of k
+    elementary reflectors, in panels of nb, whose V is on the device and
+    whose T factors were saved when they were generated, as by
+    magma_zhetrd_he2hb. All of the work is done on the device, by
+    magma_zlarfb_gpu, with no transfers but the T factors.
+
+    Arguments
+    ---------
+    @param[in]
+    side    magma_side_t
+      -     = MagmaLeft:      apply Q or Q**H from the Left;
+      -     = MagmaRight:     apply Q or Q**H from the Right.
+
+    @param[in]
+    trans   magma_trans_t
+      -     = MagmaNoTrans:    No transpose, apply Q;
+      -     = Magma_ConjTrans: Conjugate transpose, apply Q**H.
+
+    @param[in]
+    m       INTEGER
+            The number of rows of the matrix C. M >= 0.
+
+    @param[in]
+    n       INTEGER
+            The number of columns of the matrix C. N >= 0.
+
+    @param[in]
+    k       INTEGER
+            The number of elementary reflectors whose product defines
+            the matrix Q.
+            If SIDE = MagmaLeft,  M >= K >= 0;
+            if SIDE = MagmaRight, N >= K >= 0.
+
+    @param[in,out]
+    dA      COMPLEX_16 array on the GPU, dimension (LDDA,K)
+            The i-th column must contain the vector which defines the
+            elementary reflector H(i), for i = 1,2,...,k, as returned by
+            zgeqrf in the first k columns of its array argument A.
+            On exit, the upper triangles of the nb-by-nb diagonal blocks
+            are overwritten with the identity, the explicit form of V
+            that magma_zlarfb_gpu needs.
+
+    @param[in]
+    ldda    INTEGER
+            The leading dimension of the array A.
+            LDDA >= max(1,M) if SIDE = MagmaLeft;
+            LDDA >= max(1,N) if SIDE = MagmaRight.
+
+    @param[in,out]
+    dC      COMPLEX_16 array on the GPU, dimension (LDDC,N)
+            On entry, the M-by-N matrix C.
+            On exit, C is overwritten by Q*C or Q**H * C or C * Q**H or C*Q.
+
+    @param[in]
+    lddc    INTEGER
+            The leading dimension of the array C. LDDC >= max(1,M).
+
+    @param[in]
+    T       COMPLEX_16 array, dimension (LDT,K)
+            T(0:nb-1, i:i+nb-1) is the triangular factor of the block
+            reflector of columns i:i+nb-1, as zlarft computes it.
+
+    @param[in]
+    ldt     INTEGER
+            The leading dimension of the array T.  LDT >= NB.
+
+    @param[in]
+    nb      INTEGER
+            The number of reflectors in each block reflector.
+
+    @param[in]
+    queue   magma_queue_t
+            Queue to execute in.
+
+    @param[out]
+    info    INTEGER
+      -     = 0:  successful exit
+      -     < 0:  if INFO = -i, the i-th argument had an illegal value
+
+    @ingroup magma_zheev_2stage
+    ********************************************************************/
+extern "C" magma_int_t
+magma_zunmqr_gpu_2stages(
+    magma_side_t side, magma_trans_t trans,
+    magma_int_t m, magma_int_t n, magma_int_t k,
+    magmaDoubleComplex_ptr dA, size_t dA_offset, magma_int_t ldda,
+    magmaDoubleComplex_ptr dC, size_t dC_offset, magma_int_t lddc,
+    magmaDoubleComplex *T, magma_int_t ldt,
+    magma_int_t nb,
+    magma_queue_t queue,
+    magma_int_t *info )
+{
+    #define dA(i_, j_)  dA,    (dA_offset + (i_) + (j_)*ldda)
+    #define dC(i_, j_)  dC,    (dC_offset + (i_) + (j_)*lddc)
+    #define dT(j_)      dwork, (dT_offset + (j_)*nb)
+    #define dW          dwork, dW_offset
+
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+
+    magma_int_t left   = (side  == MagmaLeft);
+    magma_int_t notran = (trans == MagmaNoTrans);
+
+    // nq is the order of Q and nw is the minimum dimension of WORK
+    magma_int_t nq, nw;
+    if (left) {
+        nq = m;
+        nw = n;
+    } else {
+        nq = n;
+        nw = m;
+    }
+
+    *info = 0;
+    if ( ! left && side != MagmaRight ) {
+        *info = -1;
+    } else if ( ! notran && trans != Magma_ConjTrans ) {
+        *info = -2;
+    } else if ( m < 0 ) {
+        *info = -3;
+    } else if ( n < 0 ) {
+        *info = -4;
+    } else if ( k < 0 || k > nq ) {
+        *info = -5;
+    } else if ( ldda < max(1,nq) ) {
+        *info = -8;
+    } else if ( lddc < max(1,m) ) {
+        *info = -11;
+    } else if ( nb < 1 ) {
+        *info = -14;
+    } else if ( ldt < nb ) {
+        *info = -13;
+    }
+    if (*info != 0) {
+        magma_xerbla( __func__, -(*info) );
+        return *info;
+    }
+
+    if ( m == 0 || n == 0 || k == 0 )
+        return *info;
+
+    magmaDoubleComplex_ptr dwork;
+    size_t dT_offset = 0;
+    size_t dW_offset = nb*k;
+    if (MAGMA_SUCCESS != magma_zmalloc( &dwork, nb*k + nw*nb )) {
+        *info = MAGMA_ERR_DEVICE_ALLOC;
+        return *info;
+    }
+
+    // all of the T factors, then V in explicit form
+    magma_zsetmatrix_async( nb, k, T, ldt, dT(0), nb, queue, NULL );
+
+    // Q = H(0) ... H(k-1); apply the last block first for Q*C and C*Q**H
+    magma_int_t i1, i2, step;
+    if ( (left && notran) || (! left && ! notran) ) {
+        i1 = ((k - 1)/nb)*nb;
+        i2 = -1;
+        step = -nb;
+    }
+    else {
+        i1 = 0;
+        i2 = k;
+        step = nb;
+    }
+    for( magma_int_t i = i1; (step > 0 ? i < i2 : i > i2); i += step ) {
+        magma_int_t ib = min( nb, k - i );
+        magmablas_zlaset( MagmaUpper, ib, ib, c_zero, c_one, dA(i, i), ldda, queue );
+        if ( left ) {
+            magma_zlarfb_gpu( MagmaLeft, trans, MagmaForward, MagmaColumnwise,
+                              m-i, n, ib,
+                              dA(i, i), ldda, dT(i), nb,
+                              dC(i, 0), lddc, dW, nw, queue );
+        }
+        else {
+            magma_zlarfb_gpu( MagmaRight, trans, MagmaForward, MagmaColumnwise,
+                              m, n-i, ib,
+                              dA(i, i), ldda, dT(i), nb,
+                              dC(0, i), lddc, dW, nw, queue );
+        }
+    }
+
+    magma_queue_sync( queue );
+    magma_free( dwork );
+    return *info;
+} /* magma_zunmqr_gpu_2stages */
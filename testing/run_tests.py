@@ -558,7 +558,9 @@ if ( opts.hesv ):
 lu = (
 	# ----------
 	# LU, GPU interface
-##	('testing_zcgesv_gpu',             '-c',  n,    ''),
+	('testing_zcgesv_gpu',             '-c',  n,    ''),
+	('testing_zcgesv_gpu',          '-T -c',  n,    ''),
+	('testing_zcgesv_gpu',          '-C -c',  n,    ''),
 	('testing_zgesv_gpu',              '-c',  n,    ''),
 	('testing_zgetrf_gpu',            '-c2',  n,    ''),
 	('testing_zgetrf_gpu', '--version 2 -c2', n,    ''),
@@ -572,6 +574,8 @@ lu = (
 	('testing_zgesv',                  '-c',  n,    ''),
 ##	('testing_zgesv_rbt',              '-c',  n,    ''),
 	('testing_zgetrf',                '-c2',  n,    ''),
+	('testing_zgetrf_m',      '--nb 64 -c2',  n,    ''),
+	('testing_zgetrf_m',      '--nb 64 -c',   mn,   ''),
 )
 if ( opts.lu ):
 	tests += lu
@@ -579,7 +583,7 @@ if ( opts.lu ):
 qr = (
 	# ----------
 	# QR and least squares, GPU interface
-##	('testing_zcgeqrsv_gpu',           '-c',  mn,   ''),
+	('testing_zcgeqrsv_gpu',           '-c',  mn,   ''),
 	
 ##	('testing_zgegqr_gpu', '--version 1 -c',  mn,   ''),
 ##	('testing_zgegqr_gpu', '--version 2 -c',  mn,   ''),
@@ -618,6 +622,7 @@ qr = (
 	('testing_zgeqlf',                 '-c',  mn,   ''),
 ##	('testing_zgeqp3',                 '-c',  mn,   ''),
 	('testing_zgeqrf',                '-c2',  mn,   ''),
+	('testing_zgeqrf_ooc',    '--nb 64 -c2',  mn,   ''),
 	('testing_zungqr',                 '-c',  mnk,  ''),
 	('testing_zunmlq',                 '-c',  mnk,  ''),
 	('testing_zunmql',                 '-c',  mnk,  ''),
@@ -654,6 +659,18 @@ syev = (
 	('testing_zheevd',          '-L -JV -c',  n,    ''),
 	('testing_zheevd',          '-U -JV -c',  n,    ''),
 	
+	# 2-stage: he2hb, hb2st, bulge_back; no vectors/vectors, lower/upper
+	('testing_zheevd', '--version 2 -L -JN -c',  n,    ''),
+	('testing_zheevd', '--version 2 -U -JN -c',  n,    ''),
+	('testing_zheevd', '--version 2 -L -JV -c',  n,    ''),
+	('testing_zheevd', '--version 2 -U -JV -c',  n,    ''),
+	
+	# subset of eigenpairs by index and value, incl. badly scaled A
+	('testing_zheevdx',         '-L -JN -c',  n,    ''),
+	('testing_zheevdx',         '-U -JN -c',  n,    ''),
+	('testing_zheevdx',         '-L -JV -c',  n,    ''),
+	('testing_zheevdx',         '-U -JV -c',  n,    ''),
+	
 	# lower/upper
 	('testing_zhetrd',          '-L     -c',  n,    ''),
 	('testing_zhetrd',          '-U     -c',  n,    ''),
@@ -779,6 +796,9 @@ geev = (
 	('testing_zgeev',          '-RN -LN -c',  n,    ''),
 	('testing_zgeev',          '-RV -LV -c',  n,    ''),
 	
+	# nearly defective triangular matrix, so ztrevc3 scales the eigenvectors
+	('testing_zgeev', '--version 2 -RV -LV -c',  n,    ''),
+	
 ##	#('testing_dgeev_m',                 '',  n,    ''),  # covered by testing_zgeev_m
 ##	('testing_zgeev_m', ngpu + '-RN -LN -c',  n,    ''),
 ##	('testing_zgeev_m', ngpu + '-RV -LV -c',  n,    ''),
@@ -805,6 +825,10 @@ svd = (
 	('testing_zgesvd',         '-UO -VS -c',  mn,   ''),
 	('testing_zgesvd',         '-UA -VA -c',  mn,   ''),
 	
+	# two-stage bidiagonal reduction for all sizes; all jobu, jobvt
+	('testing_zgesdd',  '--version 2 --all -c',  mn,   ''),
+	('testing_zgesvd',  '--version 2 --all -c',  mn,   ''),
+	
 	('testing_zgebrd',                 '-c',  mn,   ''),
 	('testing_zunmbr',                 '-c',  mnk,  ''),
 )
@@ -880,12 +904,14 @@ batched = (
 ##	('testing_ztrsv_batched',     batch + '    -U -C -DU  -c',  n,    ''),
 	
 	# ----- QR
-##	('testing_zgeqrf_batched',    batch + '               -c',  mn,   ''),
+	('testing_zgeqrf_batched',    batch + '--version 1    -c',  mn,   ''),
+	('testing_zgeqrf_batched',    batch + '--version 2    -c',  mn,   ''),
 	
 	# ----- LU
 ##	('testing_zgesv_batched',         batch + '           -c',  mn,   ''),
 ##	('testing_zgesv_nopiv_batched',   batch + '           -c',  mn,   ''),
-##	('testing_zgetrf_batched',        batch + '          -c2',  mn,   ''),
+	('testing_zgetrf_batched',        batch + '--version 1 -c',  mn,   ''),
+	('testing_zgetrf_batched',        batch + '--version 2 -c',  mn,   ''),
 ##	('testing_zgetrf_nopiv_batched',  batch + '          -c2',  mn,   ''),
 ##	('testing_zgetri_batched',        batch + '           -c',  n,    ''),
 	
@@ -893,8 +919,10 @@ batched = (
 ##	('testing_zposv_batched',     batch + '         -L    -c',  n,    ''),
 ##	('#testing_zposv_batched',    batch + '         -U    -c',  n,    'upper not implemented'),
 	
-##	('testing_zpotrf_batched',    batch + '         -L    -c2', n,    ''),
-##	('#testing_zpotrf_batched',   batch + '         -U    -c2', n,    'upper not implemented'),
+	('testing_zpotrf_batched',    batch + '--version 1 -L -c', n,    ''),
+	('testing_zpotrf_batched',    batch + '--version 1 -U -c', n,    ''),
+	('testing_zpotrf_batched',    batch + '--version 2 -L -c', n,    ''),
+	('testing_zpotrf_batched',    batch + '--version 2 -U -c', n,    ''),
 )
 if ( opts.batched ):
 	tests += batched
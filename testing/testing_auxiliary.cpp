@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <algorithm>
+
 // tests internal routines: magma_{set,get}_lapack_numthreads, magma_get_parallel_numthreads
 // so include common_magma.h instead of magma.h
 #include "../interface_opencl/clmagma_runtime.h"  // private header
@@ -46,8 +48,8 @@ void test_num_gpus()
     
     unsetenv("MAGMA_NUM_GPUS");
     ngpu = magma_num_gpus();
-    printf( "%-18s  %7d  %6d\n\n", "not set", ngpu, 1 );
-    warn( ngpu == 1 );
+    printf( "%-18s  %7d  %6d (maxgpu)\n\n", "not set", ngpu, maxgpu );
+    warn( ngpu == maxgpu );
     
     setenv("MAGMA_NUM_GPUS", "", 1 );
     ngpu = magma_num_gpus();
@@ -100,6 +102,43 @@ void test_num_gpus()
     warn( ngpu == min( 1000, maxgpu ) );
     
 #endif // not Windows
+    
+    // only devices in MAGMA's context are returned; other platforms'
+    // visible devices come after them, each platform with its own context
+    magma_int_t num;
+    int nvisible = g_runtime.get_num_visible_devices();
+    std::vector< magma_device_t > devices( nvisible + 1 );
+    magma_getdevices( &devices[0], nvisible + 1, &num );
+    cl_device_id* visible = g_runtime.get_devices();
+    std::vector< cl_platform_id > platforms;
+    for( int dev=0; dev < nvisible; ++dev ) {
+        cl_platform_id platform = NULL;
+        clGetDeviceInfo( visible[dev], CL_DEVICE_PLATFORM, sizeof(platform), &platform, NULL );
+        if ( std::find( platforms.begin(), platforms.end(), platform ) == platforms.end() ) {
+            platforms.push_back( platform );
+        }
+    }
+    printf( "devices %d, visible devices %d, platforms %d, contexts %d\n",
+            ndevices, nvisible, (int) platforms.size(), g_runtime.get_num_contexts() );
+    warn( num == ndevices );
+    warn( ndevices >= 1 && ndevices <= nvisible );
+    warn( g_runtime.get_num_contexts() == (int) platforms.size() );
+    for( int dev=0; dev < nvisible; ++dev ) {
+        cl_context context = g_runtime.get_device_context( visible[dev] );
+        warn( context != NULL );
+        warn( (context == g_runtime.get_context()) == (dev < ndevices) );
+        if ( dev < ndevices ) {
+            warn( visible[dev] == devices[dev] );
+        }
+        // devices of one platform share its context
+        for( int dev2=0; dev2 < dev; ++dev2 ) {
+            cl_platform_id p1 = NULL, p2 = NULL;
+            clGetDeviceInfo( visible[dev],  CL_DEVICE_PLATFORM, sizeof(p1), &p1, NULL );
+            clGetDeviceInfo( visible[dev2], CL_DEVICE_PLATFORM, sizeof(p2), &p2, NULL );
+            cl_context context2 = g_runtime.get_device_context( visible[dev2] );
+            warn( (p1 == p2) == (context == context2) );
+        }
+    }
 }
 
 
@@ -243,6 +282,278 @@ void test_xerbla()
 }
 
 
+////////////////////////////////////////////////////////////////////////////
+void test_mempool()
+{
+    printf( "%%=====================================================================\n%s\n", __func__ );
+    
+    // size classes are 1, 1.25, 1.5, 1.75 * 2^k, minimum 256 bytes
+    warn( clmagma_mempool::size_class(    0 ) ==  256 );
+    warn( clmagma_mempool::size_class(  256 ) ==  256 );
+    warn( clmagma_mempool::size_class(  257 ) ==  320 );
+    warn( clmagma_mempool::size_class(  320 ) ==  320 );
+    warn( clmagma_mempool::size_class(  500 ) ==  512 );
+    warn( clmagma_mempool::size_class( 1000 ) == 1024 );
+    warn( clmagma_mempool::size_class( 1025 ) == 1280 );
+    warn( clmagma_mempool::size_class( 3000 ) == 3072 );
+    
+    magma_mempool_trim();
+    magma_mempool_stats_t stats0, stats;
+    magma_mempool_stats( &stats0 );
+    
+    magma_ptr dA, dB;
+    magma_malloc( &dA, 1000 );
+    magma_mempool_stats( &stats );
+    warn( stats.bytes_in_use == stats0.bytes_in_use + 1024 );
+    warn( stats.high_water_mark >= stats.bytes_in_use );
+    
+    // freeing then allocating the same size class should reuse the buffer
+    magma_free( dA );
+    magma_malloc( &dB, 1024 );
+    magma_mempool_stats( &stats );
+    printf( "enabled %d, allocs %lu, hits %lu, in use %lu, cached %lu, high-water %lu\n",
+            stats.enabled,
+            (unsigned long) (stats.num_allocs   - stats0.num_allocs),
+            (unsigned long) (stats.num_hits     - stats0.num_hits),
+            (unsigned long)  stats.bytes_in_use,
+            (unsigned long)  stats.bytes_cached,
+            (unsigned long)  stats.high_water_mark );
+    warn( stats.num_allocs == stats0.num_allocs + 2 );
+    if ( stats.enabled ) {
+        warn( dB == dA );
+        warn( stats.num_hits == stats0.num_hits + 1 );
+    }
+    magma_free( dB );
+    
+    magma_mempool_trim();
+    magma_mempool_stats( &stats );
+    warn( stats.bytes_cached == 0 );
+    warn( stats.bytes_in_use == stats0.bytes_in_use );
+    
+    // freeing past the high-water limit releases cached buffers, largest first
+    if ( stats.enabled ) {
+        magma_ptr dC;
+        size_t max_cached = g_runtime.get_mempool().max_cached();
+        g_runtime.get_mempool().set_max_cached( 2048 );
+        magma_malloc( &dA, 1024 );
+        magma_malloc( &dB, 1024 );
+        magma_malloc( &dC, 2048 );
+        magma_free( dA );
+        magma_free( dB );
+        magma_mempool_stats( &stats );
+        warn( stats.bytes_cached == 2048 );
+        magma_free( dC );
+        magma_mempool_stats( &stats );
+        warn( stats.bytes_cached == 2048 );
+        // dA and dB, 1024 bytes each, are kept; the 2048 byte dC is released
+        magma_malloc( &dC, 1024 );
+        warn( dC == dA || dC == dB );
+        magma_free( dC );
+        g_runtime.get_mempool().set_max_cached( max_cached );
+        magma_mempool_trim();
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+void test_pinned()
+{
+    printf( "%%=====================================================================\n%s\n", __func__ );
+    
+    magma_queue_t queue;
+    magma_device_t device;
+    magma_int_t num;
+    magma_getdevices( &device, 1, &num );
+    magma_queue_create( device, &queue );
+    
+    const magma_int_t m = 100, n = 20, lda = 128;
+    float *hA, *hB;
+    magmaFloat_ptr dA;
+    warn( magma_smalloc_pinned( &hA, lda*n ) == MAGMA_SUCCESS );
+    warn( magma_smalloc_pinned( &hB, lda*n ) == MAGMA_SUCCESS );
+    magma_smalloc( &dA, lda*n );
+    
+    // pointers into the middle of a pinned buffer must also work
+    for( int i=0; i < lda*n; ++i ) {
+        hA[i] = i;
+        hB[i] = 0;
+    }
+    magma_ssetmatrix( m, n, hA+1, lda, dA, 0, lda, queue );
+    magma_sgetmatrix( m, n, dA, 0, lda, hB+1, lda, queue );
+    int errors = 0;
+    for( int j=0; j < n; ++j ) {
+        for( int i=0; i < m; ++i ) {
+            errors += (hB[1 + i + j*lda] != hA[1 + i + j*lda]);
+        }
+    }
+    warn( errors == 0 );
+    warn( hB[0] == 0 );
+    
+    magma_ssetvector_async( m, hA+lda, 1, dA, 0, 1, queue, NULL );
+    magma_sgetvector_async( m, dA, 0, 1, hB, 1, queue, NULL );
+    magma_queue_sync( queue );
+    errors = 0;
+    for( int i=0; i < m; ++i ) {
+        errors += (hB[i] != hA[lda + i]);
+    }
+    warn( errors == 0 );
+    
+    warn( magma_free_pinned( hA ) == MAGMA_SUCCESS );
+    warn( magma_free_pinned( hB ) == MAGMA_SUCCESS );
+    warn( magma_free_pinned( hA ) == MAGMA_ERR_INVALID_PTR );
+    
+    // a freed buffer is cached, still mapped, and reused by the next
+    // allocation of its size class, unless caching is disabled
+    magma_mempool_stats_t stats;
+    magma_mempool_stats( &stats );
+    float *hC;
+    warn( magma_smalloc_pinned( &hC, lda*n ) == MAGMA_SUCCESS );
+    if ( stats.enabled ) {
+        warn( hC == hA || hC == hB );
+    }
+    hC[0] = 1;
+    warn( magma_free_pinned( hC ) == MAGMA_SUCCESS );
+    magma_mempool_trim();
+    
+    // pinned memory mapped for a given device
+    warn( magma_malloc_pinned_device( device, (void**) &hC, m*sizeof(float) ) == MAGMA_SUCCESS );
+    float hD[m];
+    for( int i=0; i < m; ++i ) {
+        hC[i] = i;
+        hD[i] = 0;
+    }
+    magma_ssetvector( m, hC, 1, dA, 0, 1, queue );
+    magma_sgetvector( m, dA, 0, 1, hD, 1, queue );
+    errors = 0;
+    for( int i=0; i < m; ++i ) {
+        errors += (hD[i] != hC[i]);
+    }
+    warn( errors == 0 );
+    warn( magma_free_pinned( hC ) == MAGMA_SUCCESS );
+    magma_free( dA );
+    magma_queue_destroy( queue );
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+void test_events()
+{
+    printf( "%%=====================================================================\n%s\n", __func__ );
+    
+    magma_queue_t queues[2];
+    magma_device_t device;
+    magma_int_t num;
+    magma_getdevices( &device, 1, &num );
+    magma_queue_create( device, &queues[0] );
+    magma_queue_create( device, &queues[1] );
+    
+    magma_event_t event;
+    warn( magma_event_create( &event ) == MAGMA_SUCCESS );
+    
+    // an event that was never recorded is complete
+    warn( magma_event_query( event ) == MAGMA_SUCCESS );
+    warn( magma_event_sync( event ) == MAGMA_SUCCESS );
+    
+    // copy on queue 0, then copy it back on queue 1 after waiting for event
+    const magma_int_t n = 1000;
+    float *hx, *hy;
+    magmaFloat_ptr dx;
+    magma_smalloc_cpu( &hx, n );
+    magma_smalloc_cpu( &hy, n );
+    magma_smalloc( &dx, n );
+    for( int i=0; i < n; ++i ) {
+        hx[i] = i;
+        hy[i] = 0;
+    }
+    magma_ssetvector_async( n, hx, 1, dx, 0, 1, queues[0], NULL );
+    warn( magma_event_record( event, queues[0] ) == MAGMA_SUCCESS );
+    warn( magma_queue_wait_event( queues[1], event ) == MAGMA_SUCCESS );
+    magma_sgetvector_async( n, dx, 0, 1, hy, 1, queues[1], NULL );
+    magma_queue_sync( queues[1] );
+    warn( magma_event_query( event ) == MAGMA_SUCCESS );
+    int errors = 0;
+    for( int i=0; i < n; ++i ) {
+        errors += (hy[i] != hx[i]);
+    }
+    warn( errors == 0 );
+    
+    // re-record the same event
+    warn( magma_event_record( event, queues[1] ) == MAGMA_SUCCESS );
+    warn( magma_event_sync( event ) == MAGMA_SUCCESS );
+    warn( magma_event_destroy( event ) == MAGMA_SUCCESS );
+    
+    // events from _async routines can be waited on and released, too
+    magma_sgetvector_async( n, dx, 0, 1, hy, 1, queues[0], &event );
+    warn( magma_event_sync( event ) == MAGMA_SUCCESS );
+    warn( magma_event_destroy( event ) == MAGMA_SUCCESS );
+    
+    magma_free_cpu( hx );
+    magma_free_cpu( hy );
+    magma_free( dx );
+    magma_queue_destroy( queues[0] );
+    magma_queue_destroy( queues[1] );
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+void test_warmup()
+{
+    printf( "%%=====================================================================\n%s\n", __func__ );
+    
+    // unknown names are reported, but don't stop the others
+    warn( magma_warmup( "no_such_routine" ) == MAGMA_ERR_NOT_FOUND );
+    warn( magma_warmup( "sgetrf_gpu, no_such_routine" ) == MAGMA_ERR_NOT_FOUND );
+    
+    // names may be drivers, magmablas routines, files, or kernels;
+    // compiling twice finds the kernels loaded and does nothing
+    warn( magma_warmup( "sgetrf_gpu,magmablas_slaswp,slaswp.cl,slaswp_kernel" ) == MAGMA_SUCCESS );
+    warn( magma_warmup( "sgetrf_gpu" ) == MAGMA_SUCCESS );
+    
+    // drivers that use only BLAS are known, with nothing to compile;
+    // real names of complex routines are accepted
+    warn( magma_warmup( "sgetrf_gpu,sgeqrf_gpu" ) == MAGMA_SUCCESS );
+    warn( magma_warmup( "spotrf_gpu,cpotrf,magma_cgesv_gpu" ) == MAGMA_SUCCESS );
+    warn( magma_warmup( "sorgqr,cungqr,ssyevd,cheevd,sstedx" ) == MAGMA_SUCCESS );
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+extern "C" void* get_kernel_thread( void* arg )
+{
+    return g_runtime.get_kernel( (const char*) arg );
+}
+
+void test_kernels()
+{
+    printf( "%%=====================================================================\n%s\n", __func__ );
+    
+    // same thread gets same kernel; each thread gets its own clone
+    const char* name = "slaswp_kernel";
+    cl_kernel k1 = g_runtime.get_kernel( name );
+    cl_kernel k2 = g_runtime.get_kernel( name );
+    warn( k1 != NULL );
+    warn( k1 == k2 );
+    
+    pthread_t thread[2];
+    void* result[2];
+    for( int i=0; i < 2; ++i ) {
+        pthread_create( &thread[i], NULL, get_kernel_thread, (void*) name );
+    }
+    for( int i=0; i < 2; ++i ) {
+        pthread_join( thread[i], &result[i] );
+    }
+    // threads' clones are released when they exit, so compare only to k1
+    warn( result[0] != NULL && result[1] != NULL );
+    warn( result[0] != (void*) k1 && result[1] != (void*) k1 );
+    
+    char fname[256];
+    clGetKernelInfo( (cl_kernel) k1, CL_KERNEL_FUNCTION_NAME, sizeof(fname), fname, NULL );
+    warn( strcmp( fname, name ) == 0 );
+    
+    warn( g_runtime.get_kernel( "no_such_kernel" ) == NULL );
+}
+
+
 ////////////////////////////////////////////////////////////////////////////
 int main( int argc, char** argv )
 {
@@ -251,6 +562,11 @@ int main( int argc, char** argv )
     test_num_gpus();
     test_num_threads();
     test_xerbla();
+    test_mempool();
+    test_pinned();
+    test_events();
+    test_warmup();
+    test_kernels();
     
     if ( gFailures > 0 ) {
         printf( "\n%d tests failed.\n", gFailures );
@@ -122,28 +122,49 @@ int main( int argc, char** argv )
         }
         
         // ----- test IZAMAX
-        // get argmax of column of A
+        // get argmax of column of A, sync and async, compared to BLAS
         magma_zsetmatrix( m, k, A, ld, dA, 0, ld, opts.queue );
+        magmaInt_ptr di2;
+        err = magma_malloc( &di2, sizeof(magma_int_t) );  assert( err == 0 );
         error = 0;
         for( int j = 0; j < k; ++j ) {
             magma_int_t i1 = magma_izamax( m, dA(0,j), 1, opts.queue );
             magma_int_t i2 = 0;
-            cl_mem di2;
-            magma_malloc( &di2,       sizeof(magma_int_t) );
-            magma_setvector( 1, sizeof(magma_int_t), &i2, 1, di2, 0, 1, opts.queue );
-            CLBlastiZamax (m, di2, 0,
-                            dA(0,j), 1,
-                            &opts.queue, NULL);
-            // i2 = clblasiZamax( m, dA(0,j), 1,
-            //                    1, &opts.queue, 0, NULL, NULL );
-            // todo need sync here?
-            magma_getvector( 1, sizeof(unsigned int), di2, 0, 1, &i2, 1, opts.queue );
-            // assert( i1 == i2 );
-            error += abs( i1 - i2 );
+            magma_izamax_async( m, dA(0,j), 1, di2, 0, opts.queue, NULL );
+            magma_getvector( 1, sizeof(magma_int_t), di2, 0, 1, &i2, 1, opts.queue );
+            magma_int_t i3 = blasf77_izamax( &m, A + j*ld, &ione );
+            error += abs( i1 - i3 ) + abs( i2 - i3 );
         }
+        // n = 0 writes 0, as in BLAS; dimax is required
+        {
+            magma_int_t i2 = -1;
+            magma_izamax_async( 0, dA(0,0), 1, di2, 0, opts.queue, NULL );
+            magma_getvector( 1, sizeof(magma_int_t), di2, 0, 1, &i2, 1, opts.queue );
+            error += abs( i2 );
+            error += (magma_izamax_async( 0, dA(0,0), 1, NULL, 0, opts.queue, NULL )
+                      != MAGMA_ERR_ILLEGAL_VALUE);
+        }
+        magma_free( di2 );
         total_error += error;
         gflops = (double)m * k / 1e9;
         printf( "izamax            diff %.2g\n", error );
+        
+        // ----- test DZASUM
+        // get one norm of column of A, sync and async, compared to BLAS
+        magmaDouble_ptr dsum;
+        err = magma_dmalloc( &dsum, 1 );  assert( err == 0 );
+        error = 0;
+        for( int j = 0; j < k; ++j ) {
+            double s1 = magma_dzasum( m, dA(0,j), 1, opts.queue );
+            double s2 = 0;
+            magma_dzasum_async( m, dA(0,j), 1, dsum, 0, opts.queue, NULL );
+            magma_dgetvector( 1, dsum, 0, 1, &s2, 1, opts.queue );
+            double s3 = magma_cblas_dzasum( m, A + j*ld, 1 );
+            error = max( error, (fabs( s1 - s3 ) + fabs( s2 - s3 )) / s3 );
+        }
+        magma_free( dsum );
+        total_error += error;
+        printf( "dzasum            diff %.2g\n", error );
         printf( "\n" );
         
         printf( "%%========= Level 2 BLAS ==========\n" );
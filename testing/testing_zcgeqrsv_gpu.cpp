@@ -0,0 +1,261 @@
+/*
+    -- clMAGMA (version 0.1) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "flops.h"
+#include "magma.h"
+#include "magma_lapack.h"
+#include "testings.h"
+
+#define PRECISION_z
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zcgeqrsv_gpu
+   The right-hand sides are consistent, B = A*X, so the least squares
+   residual is zero and the refinement's stopping criterion can be met.
+   Each size is solved twice: once with a random matrix, where iterative
+   refinement should succeed (iter >= 0), and once with A and B scaled
+   beyond single precision range, which forces the fallback to a double
+   precision factorization (iter = -2).
+*/
+int main(int argc, char **argv)
+{
+    TESTING_INIT();
+
+    real_Double_t   gflopsF, gflopsS, gpu_perf, gpu_time;
+    real_Double_t   gpu_perfdf, gpu_perfds;
+    real_Double_t   gpu_perfsf, gpu_perfss;
+    double          error, Rnorm, Anorm, Xnorm, *work;
+    magmaDoubleComplex c_zero    = MAGMA_Z_ZERO;
+    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    magmaDoubleComplex *h_A, *h_B, *h_X, *h_R, *tau, *h_workd;
+    magmaFloatComplex  *tau_s, *h_works;
+    magmaDoubleComplex_ptr d_A, d_B, d_X, d_T;
+    magmaFloatComplex_ptr  d_SA, d_SB, d_ST;
+    magma_int_t M, N, min_mn, nrhs, lda, ldb, ldx, lworkgpu, lworkgpu_s, lddt, lddt_s;
+    magma_int_t nb, nbs, gesv_iter, info, size;
+    magma_int_t ione     = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+
+    // beyond single precision range, but not double
+    double big = 1e40;
+
+    printf("%% Epsilon(double): %8.6e\n"
+           "%% Epsilon(single): %8.6e\n\n",
+           lapackf77_dlamch("Epsilon"), lapackf77_slamch("Epsilon") );
+    magma_int_t status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+
+    nrhs = opts.nrhs;
+
+    printf("%%   M     N NRHS   DP-Factor  DP-Solve  SP-Factor  SP-Solve  MP-Solve  Iter   |b-Ax|/N|A||x|\n");
+    printf("%%==============================================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            M = opts.msize[itest];
+            N = opts.nsize[itest];
+            if ( M < N ) {
+                printf( "%5d %5d %5d   skipping because M < N is not supported.\n",
+                        (int) M, (int) N, (int) nrhs );
+                continue;
+            }
+            min_mn = min(M, N);
+            lda = ldb = M;
+            ldx = N;
+            gflopsF = FLOPS_ZGEQRF( M, N ) / 1e9;
+            gflopsS = gflopsF + FLOPS_ZGEQRS( M, N, nrhs ) / 1e9;
+
+            // workspace, as in magma_zgels_gpu
+            nb         = magma_get_zgeqrf_nb( M );
+            nbs        = magma_get_cgeqrf_nb( M );
+            lworkgpu   = (M - N + nb )*(nrhs + nb ) + nrhs*nb;
+            lworkgpu_s = (M - N + nbs)*(nrhs + nbs) + nrhs*nbs;
+            lddt       = ( 2*min_mn + magma_roundup( N, 32 ) )*max( nb,  nrhs );
+            lddt_s     = ( 2*min_mn + magma_roundup( N, 32 ) )*max( nbs, nrhs );
+
+            TESTING_MALLOC_CPU( h_A,     magmaDoubleComplex, lda*N      );
+            TESTING_MALLOC_CPU( h_B,     magmaDoubleComplex, ldb*nrhs   );
+            TESTING_MALLOC_CPU( h_X,     magmaDoubleComplex, ldx*nrhs   );
+            TESTING_MALLOC_CPU( h_R,     magmaDoubleComplex, ldb*nrhs   );
+            TESTING_MALLOC_CPU( tau,     magmaDoubleComplex, min_mn     );
+            TESTING_MALLOC_CPU( tau_s,   magmaFloatComplex,  min_mn     );
+            TESTING_MALLOC_CPU( h_workd, magmaDoubleComplex, lworkgpu   );
+            TESTING_MALLOC_CPU( h_works, magmaFloatComplex,  lworkgpu_s );
+            TESTING_MALLOC_CPU( work,    double,             M          );
+
+            TESTING_MALLOC_DEV( d_A,     magmaDoubleComplex, lda*N      );
+            TESTING_MALLOC_DEV( d_B,     magmaDoubleComplex, ldb*nrhs   );
+            TESTING_MALLOC_DEV( d_X,     magmaDoubleComplex, ldx*nrhs   );
+            TESTING_MALLOC_DEV( d_T,     magmaDoubleComplex, lddt       );
+            TESTING_MALLOC_DEV( d_SA,    magmaFloatComplex,  lda*N      );
+            TESTING_MALLOC_DEV( d_SB,    magmaFloatComplex,  ldb*nrhs   );
+            TESTING_MALLOC_DEV( d_ST,    magmaFloatComplex,  lddt_s     );
+
+            /* Initialize the matrix, and consistent right-hand sides */
+            size = lda * N;
+            lapackf77_zlarnv( &ione, ISEED, &size, h_A );
+
+            size = ldx * nrhs;
+            lapackf77_zlarnv( &ione, ISEED, &size, h_X );
+            blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &M, &nrhs, &N,
+                           &c_one,  h_A, &lda,
+                                    h_X, &ldx,
+                           &c_zero, h_B, &ldb );
+
+            // first pass uses iterative refinement; second pass falls back
+            for( int scaled = 0; scaled < 2; ++scaled ) {
+                if ( scaled ) {
+                    double one = 1;
+                    lapackf77_zlascl( "G", &ione, &ione, &one, &big, &M, &N,    h_A, &lda, &info );
+                    lapackf77_zlascl( "G", &ione, &ione, &one, &big, &M, &nrhs, h_B, &ldb, &info );
+                }
+                magma_zsetmatrix( M, N,    h_A, lda, d_A, 0, lda, opts.queue );
+                magma_zsetmatrix( M, nrhs, h_B, ldb, d_B, 0, ldb, opts.queue );
+
+                //=====================================================================
+                //              Mixed Precision Iterative Refinement - GPU
+                //=====================================================================
+                gpu_time = magma_wtime();
+                magma_zcgeqrsv_gpu( M, N, nrhs, d_A, 0, lda, d_B, 0, ldb, d_X, 0, ldx,
+                                    &gesv_iter, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perf = gflopsS / gpu_time;
+                if (info != 0)
+                    printf("magma_zcgeqrsv returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Error Computation
+                //=====================================================================
+                magma_zgetmatrix( N, nrhs, d_X, 0, ldx, h_X, ldx, opts.queue );
+
+                Anorm = lapackf77_zlange( "I", &M, &N,    h_A, &lda, work );
+                Xnorm = lapackf77_zlange( "I", &N, &nrhs, h_X, &ldx, work );
+
+                lapackf77_zlacpy( "F", &M, &nrhs, h_B, &ldb, h_R, &ldb );
+                blasf77_zgemm( MagmaNoTransStr, MagmaNoTransStr, &M, &nrhs, &N,
+                               &c_one,     h_A, &lda,
+                                           h_X, &ldx,
+                               &c_neg_one, h_R, &ldb );
+                Rnorm = lapackf77_zlange( "I", &M, &nrhs, h_R, &ldb, work );
+                error = Rnorm / (N*Anorm*Xnorm);
+
+                // refinement must succeed on the random matrix and fall back
+                // because of overflow on the scaled one
+                bool iter_ok = (scaled ? gesv_iter == -2 : gesv_iter >= 0);
+                bool okay    = (error < tol && iter_ok && info == 0);
+
+                if ( scaled ) {
+                    printf("%5d %5d %5d     ---       ---       ---       ---     %7.2f    %4d   %8.2e   %s (fallback)\n",
+                           (int) M, (int) N, (int) nrhs, gpu_perf,
+                           (int) gesv_iter, error, (okay ? "ok" : "failed"));
+                    status += ! okay;
+                    continue;
+                }
+
+                //=====================================================================
+                //                 Double Precision Factor
+                //=====================================================================
+                magma_zsetmatrix( M, N, h_A, lda, d_A, 0, lda, opts.queue );
+
+                gpu_time = magma_wtime();
+                magma_zgeqrf_gpu( M, N, d_A, 0, lda, tau, d_T, 0, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfdf = gflopsF / gpu_time;
+                if (info != 0)
+                    printf("magma_zgeqrf returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Double Precision Solve
+                //=====================================================================
+                magma_zsetmatrix( M, N,    h_A, lda, d_A, 0, lda, opts.queue );
+                magma_zsetmatrix( M, nrhs, h_B, ldb, d_B, 0, ldb, opts.queue );
+
+                gpu_time = magma_wtime();
+                magma_zgels_gpu( MagmaNoTrans, M, N, nrhs, d_A, 0, lda,
+                                 d_B, 0, ldb, h_workd, lworkgpu, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfds = gflopsS / gpu_time;
+                if (info != 0)
+                    printf("magma_zgels returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Single Precision Factor
+                //=====================================================================
+                magma_zsetmatrix( M, N, h_A, lda, d_A, 0, lda, opts.queue );
+                magmablas_zlag2c( M, N, d_A, 0, lda, d_SA, 0, lda, opts.queue, &info );
+
+                gpu_time = magma_wtime();
+                magma_cgeqrf_gpu( M, N, d_SA, 0, lda, tau_s, d_ST, 0, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfsf = gflopsF / gpu_time;
+                if (info != 0)
+                    printf("magma_cgeqrf returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Single Precision Solve
+                //=====================================================================
+                magmablas_zlag2c( M, N,    d_A, 0, lda, d_SA, 0, lda, opts.queue, &info );
+                magmablas_zlag2c( M, nrhs, d_B, 0, ldb, d_SB, 0, ldb, opts.queue, &info );
+
+                gpu_time = magma_wtime();
+                magma_cgels_gpu( MagmaNoTrans, M, N, nrhs, d_SA, 0, lda,
+                                 d_SB, 0, ldb, h_works, lworkgpu_s, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfss = gflopsS / gpu_time;
+                if (info != 0)
+                    printf("magma_cgels returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                printf("%5d %5d %5d   %7.2f   %7.2f   %7.2f   %7.2f   %7.2f    %4d   %8.2e   %s\n",
+                       (int) M, (int) N, (int) nrhs,
+                       gpu_perfdf, gpu_perfds, gpu_perfsf, gpu_perfss, gpu_perf,
+                       (int) gesv_iter, error, (okay ? "ok" : "failed"));
+                status += ! okay;
+            }
+
+            TESTING_FREE_CPU( h_A );
+            TESTING_FREE_CPU( h_B );
+            TESTING_FREE_CPU( h_X );
+            TESTING_FREE_CPU( h_R );
+            TESTING_FREE_CPU( tau );
+            TESTING_FREE_CPU( tau_s );
+            TESTING_FREE_CPU( h_workd );
+            TESTING_FREE_CPU( h_works );
+            TESTING_FREE_CPU( work );
+
+            TESTING_FREE_DEV( d_A );
+            TESTING_FREE_DEV( d_B );
+            TESTING_FREE_DEV( d_X );
+            TESTING_FREE_DEV( d_T );
+            TESTING_FREE_DEV( d_SA );
+            TESTING_FREE_DEV( d_SB );
+            TESTING_FREE_DEV( d_ST );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    TESTING_FINALIZE();
+    return status;
+}
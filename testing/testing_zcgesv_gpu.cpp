@@ -0,0 +1,245 @@
+/*
+    -- clMAGMA (version 0.1) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "flops.h"
+#include "magma.h"
+#include "magma_lapack.h"
+#include "testings.h"
+
+#define PRECISION_z
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zcgesv_gpu
+   Each size is solved twice: once with a random matrix, where iterative
+   refinement should succeed (iter >= 0), and once with the matrix and
+   right-hand sides scaled beyond single precision range, which forces the
+   fallback to a double precision factorization (iter = -2).
+*/
+int main(int argc, char **argv)
+{
+    TESTING_INIT();
+
+    real_Double_t   gflopsF, gflopsS, gpu_perf, gpu_time;
+    real_Double_t   gpu_perfdf, gpu_perfds;
+    real_Double_t   gpu_perfsf, gpu_perfss;
+    double          error, Rnorm, Anorm, Xnorm;
+    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    magmaDoubleComplex *h_A, *h_B, *h_X, *h_R;
+    magmaDoubleComplex_ptr d_A,  d_B,  d_X, d_workd;
+    magmaFloatComplex_ptr  d_As, d_Bs,      d_works;
+    magmaInt_ptr           d_ipiv;
+    size_t d_Bs_offset;
+    double          *h_workd;
+    magma_int_t *h_ipiv;
+    magma_int_t lda, ldb, ldx;
+    magma_int_t N, nrhs, gesv_iter, info, size;
+    magma_int_t ione     = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+
+    // beyond single precision range, but not double
+    double big = 1e40;
+
+    printf("%% Epsilon(double): %8.6e\n"
+           "%% Epsilon(single): %8.6e\n\n",
+           lapackf77_dlamch("Epsilon"), lapackf77_slamch("Epsilon") );
+    magma_int_t status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+
+    nrhs = opts.nrhs;
+
+    printf("%% trans = %s\n",
+           lapack_trans_const(opts.transA));
+
+    printf("%%   N NRHS   DP-Factor  DP-Solve  SP-Factor  SP-Solve  MP-Solve  Iter   |b-Ax|/N|A||x|\n");
+    printf("%%========================================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            N = opts.nsize[itest];
+            ldb = ldx = lda = N;
+            gflopsF = FLOPS_ZGETRF( N, N ) / 1e9;
+            gflopsS = gflopsF + FLOPS_ZGETRS( N, nrhs ) / 1e9;
+
+            TESTING_MALLOC_CPU( h_A,     magmaDoubleComplex, lda*N    );
+            TESTING_MALLOC_CPU( h_B,     magmaDoubleComplex, ldb*nrhs );
+            TESTING_MALLOC_CPU( h_X,     magmaDoubleComplex, ldx*nrhs );
+            TESTING_MALLOC_CPU( h_R,     magmaDoubleComplex, ldb*nrhs );
+            TESTING_MALLOC_CPU( h_ipiv,  magma_int_t,        N        );
+            TESTING_MALLOC_CPU( h_workd, double,             N        );
+
+            TESTING_MALLOC_DEV( d_A,     magmaDoubleComplex, lda*N        );
+            TESTING_MALLOC_DEV( d_B,     magmaDoubleComplex, ldb*nrhs     );
+            TESTING_MALLOC_DEV( d_X,     magmaDoubleComplex, ldx*nrhs     );
+            TESTING_MALLOC_DEV( d_ipiv,  magma_int_t,        N            );
+            TESTING_MALLOC_DEV( d_works, magmaFloatComplex,  lda*(N+nrhs) );
+            TESTING_MALLOC_DEV( d_workd, magmaDoubleComplex, N*nrhs       );
+
+            /* Initialize the matrix */
+            size = lda * N;
+            lapackf77_zlarnv( &ione, ISEED, &size, h_A );
+
+            size = ldb * nrhs;
+            lapackf77_zlarnv( &ione, ISEED, &size, h_B );
+
+            // first pass uses iterative refinement; second pass falls back
+            for( int scaled = 0; scaled < 2; ++scaled ) {
+                if ( scaled ) {
+                    double one = 1;
+                    lapackf77_zlascl( "G", &ione, &ione, &one, &big, &N, &N,    h_A, &lda, &info );
+                    lapackf77_zlascl( "G", &ione, &ione, &one, &big, &N, &nrhs, h_B, &ldb, &info );
+                }
+                magma_zsetmatrix( N, N,    h_A, lda, d_A, 0, lda, opts.queue );
+                magma_zsetmatrix( N, nrhs, h_B, ldb, d_B, 0, ldb, opts.queue );
+
+                //=====================================================================
+                //              Mixed Precision Iterative Refinement - GPU
+                //=====================================================================
+                gpu_time = magma_wtime();
+                magma_zcgesv_gpu( opts.transA, N, nrhs, d_A, 0, lda, h_ipiv, d_ipiv,
+                                  d_B, 0, ldb, d_X, 0, ldx,
+                                  d_workd, 0, d_works, 0, &gesv_iter, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perf = gflopsS / gpu_time;
+                if (info != 0)
+                    printf("magma_zcgesv returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Error Computation
+                //=====================================================================
+                magma_zgetmatrix( N, nrhs, d_X, 0, ldx, h_X, ldx, opts.queue );
+
+                Anorm = lapackf77_zlange( "I", &N, &N,    h_A, &lda, h_workd );
+                Xnorm = lapackf77_zlange( "I", &N, &nrhs, h_X, &ldx, h_workd );
+
+                lapackf77_zlacpy( "F", &N, &nrhs, h_B, &ldb, h_R, &ldb );
+                blasf77_zgemm( lapack_trans_const(opts.transA), MagmaNoTransStr,
+                               &N, &nrhs, &N,
+                               &c_one,     h_A, &lda,
+                                           h_X, &ldx,
+                               &c_neg_one, h_R, &ldb );
+                Rnorm = lapackf77_zlange( "I", &N, &nrhs, h_R, &ldb, h_workd );
+                error = Rnorm / (N*Anorm*Xnorm);
+
+                // refinement must succeed on the random matrix and fall back
+                // because of overflow on the scaled one
+                bool iter_ok = (scaled ? gesv_iter == -2 : gesv_iter >= 0);
+                bool okay    = (error < tol && iter_ok && info == 0);
+
+                if ( scaled ) {
+                    printf("%5d %5d     ---       ---       ---       ---     %7.2f    %4d   %8.2e   %s (fallback)\n",
+                           (int) N, (int) nrhs, gpu_perf,
+                           (int) gesv_iter, error, (okay ? "ok" : "failed"));
+                    status += ! okay;
+                    continue;
+                }
+
+                //=====================================================================
+                //                 Double Precision Factor
+                //=====================================================================
+                magma_zsetmatrix( N, N, h_A, lda, d_A, 0, lda, opts.queue );
+
+                gpu_time = magma_wtime();
+                magma_zgetrf_gpu( N, N, d_A, 0, lda, h_ipiv, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfdf = gflopsF / gpu_time;
+                if (info != 0)
+                    printf("magma_zgetrf returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Double Precision Solve
+                //=====================================================================
+                magma_zsetmatrix( N, N,    h_A, lda, d_A, 0, lda, opts.queue );
+                magma_zsetmatrix( N, nrhs, h_B, ldb, d_B, 0, ldb, opts.queue );
+
+                gpu_time = magma_wtime();
+                magma_zgetrf_gpu( N, N, d_A, 0, lda, h_ipiv, opts.queue, &info );
+                magma_zgetrs_gpu( opts.transA, N, nrhs, d_A, 0, lda, h_ipiv,
+                                  d_B, 0, ldb, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfds = gflopsS / gpu_time;
+                if (info != 0)
+                    printf("magma_zgetrs returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Single Precision Factor
+                //=====================================================================
+                d_As = d_works;
+                d_Bs = d_works;
+                d_Bs_offset = lda*N;
+                magma_zsetmatrix( N, N,    h_A, lda, d_A, 0, lda, opts.queue );
+                magma_zsetmatrix( N, nrhs, h_B, ldb, d_B, 0, ldb, opts.queue );
+                magmablas_zlag2c( N, N,    d_A, 0, lda, d_As, 0, N, opts.queue, &info );
+                magmablas_zlag2c( N, nrhs, d_B, 0, ldb, d_Bs, d_Bs_offset, N, opts.queue, &info );
+
+                gpu_time = magma_wtime();
+                magma_cgetrf_gpu( N, N, d_As, 0, N, h_ipiv, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfsf = gflopsF / gpu_time;
+                if (info != 0)
+                    printf("magma_cgetrf returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                //=====================================================================
+                //                 Single Precision Solve
+                //=====================================================================
+                magmablas_zlag2c( N, N,    d_A, 0, lda, d_As, 0, N, opts.queue, &info );
+                magmablas_zlag2c( N, nrhs, d_B, 0, ldb, d_Bs, d_Bs_offset, N, opts.queue, &info );
+
+                gpu_time = magma_wtime();
+                magma_cgetrf_gpu( N, N, d_As, 0, N, h_ipiv, opts.queue, &info );
+                magma_cgetrs_gpu( opts.transA, N, nrhs, d_As, 0, N, h_ipiv,
+                                  d_Bs, d_Bs_offset, N, opts.queue, &info );
+                gpu_time = magma_wtime() - gpu_time;
+                gpu_perfss = gflopsS / gpu_time;
+                if (info != 0)
+                    printf("magma_cgetrs returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                printf("%5d %5d   %7.2f   %7.2f   %7.2f   %7.2f   %7.2f    %4d   %8.2e   %s\n",
+                       (int) N, (int) nrhs,
+                       gpu_perfdf, gpu_perfds, gpu_perfsf, gpu_perfss, gpu_perf,
+                       (int) gesv_iter, error, (okay ? "ok" : "failed"));
+                status += ! okay;
+            }
+
+            TESTING_FREE_CPU( h_A );
+            TESTING_FREE_CPU( h_B );
+            TESTING_FREE_CPU( h_X );
+            TESTING_FREE_CPU( h_R );
+            TESTING_FREE_CPU( h_ipiv );
+            TESTING_FREE_CPU( h_workd );
+
+            TESTING_FREE_DEV( d_A );
+            TESTING_FREE_DEV( d_B );
+            TESTING_FREE_DEV( d_X );
+            TESTING_FREE_DEV( d_ipiv );
+            TESTING_FREE_DEV( d_works );
+            TESTING_FREE_DEV( d_workd );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    TESTING_FINALIZE();
+    return status;
+}
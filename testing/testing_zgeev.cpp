@@ -61,8 +61,34 @@ double magma_dzlapy2(magmaDoubleComplex x)
 }
 
 
+// Generates the N-by-N test matrix A.
+// version 1: random entries.
+// version 2: upper triangular, random above the diagonal, with diagonal
+// A(i,i) = i*1e-8. Balancing and QR leave it unchanged, so ztrevc3 solves
+// with T = A; since eigenvalues are close relative to the entries above
+// the diagonal, the solves grow fast enough that zlatrs must scale them.
+static void
+make_geev_matrix( magma_int_t version, magma_int_t N,
+                  magmaDoubleComplex* A, magma_int_t lda, magma_int_t* ISEED )
+{
+    magma_int_t ione = 1;
+    magma_int_t n2   = lda*N;
+    lapackf77_zlarnv( &ione, ISEED, &n2, A );
+    if ( version == 2 ) {
+        for( int j = 0; j < N; ++j ) {
+            A[j + j*lda] = MAGMA_Z_MAKE( j*1e-8, 0. );
+            for( int i = j+1; i < N; ++i ) {
+                A[i + j*lda] = MAGMA_Z_ZERO;
+            }
+        }
+    }
+}
+
+
 /* ////////////////////////////////////////////////////////////////////////////
    -- Testing zgeev
+   --version 1 uses a random matrix; --version 2 a nearly defective
+   triangular matrix, whose eigenvectors need scaling (see make_geev_matrix).
 */
 int main( int argc, char** argv)
 {
@@ -99,6 +125,8 @@ int main( int argc, char** argv)
         opts.lapack = true;
     }
     
+    printf("%% version %d: %s matrix\n", (int) opts.version,
+           (opts.version == 2 ? "nearly defective triangular" : "random") );
     printf("%%   N   CPU Time (sec)   GPU Time (sec)   |W_magma - W_lapack| / |W_lapack|\n");
     printf("%%==========================================================================\n");
     for( int itest = 0; itest < opts.ntest; ++itest ) {
@@ -124,7 +152,7 @@ int main( int argc, char** argv)
             TESTING_MALLOC_PIN( h_work, magmaDoubleComplex, lwork );
             
             /* Initialize the matrix */
-            lapackf77_zlarnv( &ione, ISEED, &n2, h_A );
+            make_geev_matrix( opts.version, N, h_A, lda, ISEED );
             lapackf77_zlacpy( MagmaUpperLowerStr, &N, &N, h_A, &lda, h_R, &lda );
             
             /* ====================================================================
@@ -266,7 +294,7 @@ int main( int argc, char** argv)
                 magmaDoubleComplex *LRE, DUM;
                 TESTING_MALLOC_PIN( LRE, magmaDoubleComplex, n2 );
                 
-                lapackf77_zlarnv( &ione, ISEED, &n2, h_A );
+                make_geev_matrix( opts.version, N, h_A, lda, ISEED );
                 lapackf77_zlacpy( MagmaUpperLowerStr, &N, &N, h_A, &lda, h_R, &lda );
                 
                 // ----------
@@ -93,27 +93,14 @@ int main( int argc, char** argv)
 
     /* Initialize */
     magma_queue_t  queues[2*MagmaMaxGPUs];
-    magma_device_t devices[MagmaMaxGPUs];
-    magma_int_t num = 0;
     magma_int_t err;
     magma_init();
-    err = magma_getdevices( devices, MagmaMaxGPUs, &num );
-    if ( err != 0 || num < 1 ) {
-        fprintf( stderr, "magma_getdevices failed: %d\n", (int) err );
+    // devices may be sub-devices, see $MAGMA_NUM_SUBDEVICES
+    err = magma_queues_create_mgpu( num_gpus, queues );
+    if ( err != 0 ) {
+        fprintf( stderr, "magma_queues_create_mgpu failed: %d (ngpu %d)\n", (int) err, (int) num_gpus );
         exit(-1);
     }
-    for (i=0; i<num_gpus; i++){
-        err = magma_queue_create( devices[i], &queues[2*i] );
-        if ( err != 0 ) {
-            fprintf( stderr, "magma_queue_create failed: %d\n", (int) err );
-            exit(-1);
-        }
-        err = magma_queue_create( devices[i], &queues[2*i+1] );
-        if ( err != 0 ) {
-            fprintf( stderr, "magma_queue_create failed: %d\n", (int) err );
-            exit(-1);
-        }
-    }
     printf( "\n" );
     
     printf("  M     N     CPU GFlop/s (sec.)     GPU GFlop/s (sec)   ||R||_F / ||A||_F\n");
@@ -217,10 +204,7 @@ int main( int argc, char** argv)
           break;
     }
     
-    for (i=0; i<num_gpus; i++) {
-        magma_queue_destroy(queues[2*i]);
-        magma_queue_destroy(queues[2*i+1]);
-    }
+    magma_queues_destroy_mgpu( num_gpus, queues );
 
     /* Shutdown */
     magma_finalize();
@@ -0,0 +1,192 @@
+/*
+    -- clMAGMA (version 1.1) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "flops.h"
+#include "magma.h"
+#include "magma_lapack.h"
+#include "testings.h"
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zgeqrf_ooc (non-GPU-resident QR)
+      --nb sets MAGMA_NGR_NB, capping the width of the block column window
+      on the GPU, as if device memory were small, so that even small
+      matrices are factored in several big block columns.
+*/
+int main( int argc, char** argv)
+{
+    TESTING_INIT();
+
+    const double             d_neg_one = MAGMA_D_NEG_ONE;
+    const double             d_one     = MAGMA_D_ONE;
+    const magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    const magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_zero    = MAGMA_Z_ZERO;
+    const magma_int_t        ione      = 1;
+    
+    real_Double_t    gflops, gpu_perf, gpu_time, cpu_perf=0, cpu_time=0;
+    double           Anorm, error=0, error2=0;
+    magmaDoubleComplex *h_A, *h_R, *tau, *h_work, tmp[1];
+    magma_int_t M, N, n2, lda, lwork, info, min_mn;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    magma_int_t status = 0;
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+    
+    if ( opts.nb > 0 ) {
+        char nb_str[ 32 ];
+        snprintf( nb_str, sizeof(nb_str), "%d", (int) opts.nb );
+        setenv( "MAGMA_NGR_NB", nb_str, 1 );
+        printf( "%% MAGMA_NGR_NB %d: window of at most %d columns on the GPU\n",
+                (int) opts.nb, (int) opts.nb );
+    }
+    printf("%%   M     N   CPU GFlop/s (sec)   GPU GFlop/s (sec)   |R - Q^H*A|   |I - Q^H*Q|\n");
+    printf("%%==============================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            M = opts.msize[itest];
+            N = opts.nsize[itest];
+            min_mn = min(M, N);
+            lda    = M;
+            n2     = lda*N;
+            gflops = FLOPS_ZGEQRF( M, N ) / 1e9;
+            
+            // query for workspace size, for both MAGMA and LAPACK
+            lwork = -1;
+            lapackf77_zgeqrf(&M, &N, NULL, &M, NULL, tmp, &lwork, &info);
+            lwork = (magma_int_t)MAGMA_Z_REAL( tmp[0] );
+            magma_zgeqrf_ooc( M, N, NULL, M, NULL, tmp, -1, opts.queues2, &info );
+            lwork = max( lwork, (magma_int_t)MAGMA_Z_REAL( tmp[0] ));
+            
+            TESTING_MALLOC_CPU( tau,    magmaDoubleComplex, min_mn );
+            TESTING_MALLOC_CPU( h_A,    magmaDoubleComplex, n2     );
+            TESTING_MALLOC_CPU( h_work, magmaDoubleComplex, lwork  );
+            
+            TESTING_MALLOC_PIN( h_R,    magmaDoubleComplex, n2     );
+            
+            /* Initialize the matrix */
+            lapackf77_zlarnv( &ione, ISEED, &n2, h_A );
+            lapackf77_zlacpy( MagmaUpperLowerStr, &M, &N, h_A, &lda, h_R, &lda );
+            
+            if ( opts.warmup ) {
+                magma_zgeqrf_ooc( M, N, h_R, lda, tau, h_work, lwork, opts.queues2, &info );
+                lapackf77_zlacpy( MagmaUpperLowerStr, &M, &N, h_A, &lda, h_R, &lda );
+            }
+
+            /* ====================================================================
+               Performs operation using MAGMA
+               =================================================================== */
+            gpu_time = magma_wtime();
+            magma_zgeqrf_ooc( M, N, h_R, lda, tau, h_work, lwork, opts.queues2, &info );
+            gpu_time = magma_wtime() - gpu_time;
+            gpu_perf = gflops / gpu_time;
+            if (info != 0)
+                printf("magma_zgeqrf_ooc returned error %d: %s.\n",
+                       (int) info, magma_strerror( info ));
+            
+            /* =====================================================================
+               Check the result, following zqrt01 except using the reduced Q.
+               This works for any M,N (square, tall, wide).
+               =================================================================== */
+            if ( opts.check ) {
+                magma_int_t ldq = M;
+                magma_int_t ldr = min_mn;
+                magmaDoubleComplex *Q, *R;
+                double *work;
+                TESTING_MALLOC_CPU( Q,    magmaDoubleComplex, ldq*min_mn );  // M by K
+                TESTING_MALLOC_CPU( R,    magmaDoubleComplex, ldr*N );       // K by N
+                TESTING_MALLOC_CPU( work, double,             min_mn );
+                
+                // generate M by K matrix Q, where K = min(M,N)
+                lapackf77_zlacpy( "Lower", &M, &min_mn, h_R, &lda, Q, &ldq );
+                lapackf77_zungqr( &M, &min_mn, &min_mn, Q, &ldq, tau, h_work, &lwork, &info );
+                assert( info == 0 );
+                
+                // copy K by N matrix R
+                lapackf77_zlaset( "Lower", &min_mn, &N, &c_zero, &c_zero, R, &ldr );
+                lapackf77_zlacpy( "Upper", &min_mn, &N, h_R, &lda,        R, &ldr );
+                
+                // error = || R - Q^H*A || / (N * ||A||)
+                blasf77_zgemm( "Conj", "NoTrans", &min_mn, &N, &M,
+                               &c_neg_one, Q, &ldq, h_A, &lda, &c_one, R, &ldr );
+                Anorm = lapackf77_zlange( "1", &M,      &N, h_A, &lda, work );
+                error = lapackf77_zlange( "1", &min_mn, &N, R,   &ldr, work );
+                if ( N > 0 && Anorm > 0 )
+                    error /= (N*Anorm);
+                
+                // set R = I (K by K identity), then R = I - Q^H*Q
+                // error = || I - Q^H*Q || / N
+                lapackf77_zlaset( "Upper", &min_mn, &min_mn, &c_zero, &c_one, R, &ldr );
+                blasf77_zherk( "Upper", "Conj", &min_mn, &M, &d_neg_one, Q, &ldq, &d_one, R, &ldr );
+                error2 = lapackf77_zlanhe( "1", "Upper", &min_mn, R, &ldr, work );
+                if ( N > 0 )
+                    error2 /= N;
+                
+                TESTING_FREE_CPU( Q    );  Q    = NULL;
+                TESTING_FREE_CPU( R    );  R    = NULL;
+                TESTING_FREE_CPU( work );  work = NULL;
+            }
+            
+            /* =====================================================================
+               Performs operation using LAPACK
+               =================================================================== */
+            if ( opts.lapack ) {
+                cpu_time = magma_wtime();
+                lapackf77_zgeqrf( &M, &N, h_A, &lda, tau, h_work, &lwork, &info );
+                cpu_time = magma_wtime() - cpu_time;
+                cpu_perf = gflops / cpu_time;
+                if (info != 0)
+                    printf("lapackf77_zgeqrf returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+            }
+            
+            /* =====================================================================
+               Print performance and error.
+               =================================================================== */
+            printf("%5d %5d   ", (int) M, (int) N );
+            if ( opts.lapack ) {
+                printf( "%7.2f (%7.2f)", cpu_perf, cpu_time );
+            }
+            else {
+                printf("  ---   (  ---  )" );
+            }
+            printf( "   %7.2f (%7.2f)   ", gpu_perf, gpu_time );
+            if ( opts.check ) {
+                bool okay = (error < tol && error2 < tol);
+                status += ! okay;
+                printf( "%11.2e   %11.2e   %s\n", error, error2, (okay ? "ok" : "failed") );
+            }
+            else {
+                printf( "    ---\n" );
+            }
+            
+            TESTING_FREE_CPU( tau    );
+            TESTING_FREE_CPU( h_A    );
+            TESTING_FREE_CPU( h_work );
+            
+            TESTING_FREE_PIN( h_R    );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    TESTING_FINALIZE();
+    return status;
+}
@@ -26,6 +26,8 @@
 /* ////////////////////////////////////////////////////////////////////////////
    -- Testing zgesdd (SVD with Divide & Conquer)
       Please keep code in testing_zgesdd.cpp and testing_zgesvd.cpp similar.
+      --version 2 sets MAGMA_SVD_2STAGE_NMIN=1, so that zgesdd reduces
+      matrices of all sizes in two stages (complex precisions only).
 */
 int main( int argc, char** argv)
 {
@@ -54,6 +56,11 @@ int main( int argc, char** argv)
     
     double tol = opts.tolerance * lapackf77_dlamch("E");
     
+    if ( opts.version == 2 ) {
+        setenv( "MAGMA_SVD_2STAGE_NMIN", "1", 1 );
+        printf( "%% version 2: two-stage bidiagonal reduction for all sizes\n" );
+    }
+    
     jobz = opts.jobu;
     
     magma_vec_t jobs[] = { MagmaNoVec, MagmaSomeVec, MagmaOverwriteVec, MagmaAllVec };
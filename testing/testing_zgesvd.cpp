@@ -26,6 +26,8 @@
 /* ////////////////////////////////////////////////////////////////////////////
    -- Testing zgesvd (SVD with QR iteration)
       Please keep code in testing_zgesdd.cpp and testing_zgesvd.cpp similar.
+      --version 2 sets MAGMA_SVD_2STAGE_NMIN=1, so that zgesvd reduces
+      matrices of all sizes in two stages (complex precisions only).
 */
 int main( int argc, char** argv)
 {
@@ -49,6 +51,11 @@ int main( int argc, char** argv)
     
     double tol = opts.tolerance * lapackf77_dlamch("E");
     
+    if ( opts.version == 2 ) {
+        setenv( "MAGMA_SVD_2STAGE_NMIN", "1", 1 );
+        printf( "%% version 2: two-stage bidiagonal reduction for all sizes\n" );
+    }
+    
     jobu  = opts.jobu;
     jobvt = opts.jobvt;
     
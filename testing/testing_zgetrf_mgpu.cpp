@@ -195,7 +195,7 @@ int main( int argc, char** argv )
         }
     }
     
-    printf("%% ngpu %d\n", (int) opts.ngpu );
+    printf("%% ngpu %d, version %d (2: tile DAG)\n", (int) opts.ngpu, (int) opts.version );
     if ( opts.check == 2 ) {
         printf("%%   M     N   CPU GFlop/s (sec)   GPU GFlop/s (sec)   |Ax-b|/(N*|A|*|x|)\n");
     }
@@ -258,7 +258,10 @@ int main( int argc, char** argv )
             magma_zsetmatrix_1D_col_bcyclic( M, N, h_A, lda, d_lA, ldda, ngpu, nb, queues );
     
             gpu_time = magma_wtime();
-            magma_zgetrf_mgpu( ngpu, M, N, d_lA, 0, ldda, ipiv, queues2, &info );
+            if ( opts.version == 2 )
+                magma_zgetrf_tile_mgpu( ngpu, M, N, d_lA, 0, ldda, ipiv, queues2, &info );
+            else
+                magma_zgetrf_mgpu( ngpu, M, N, d_lA, 0, ldda, ipiv, queues2, &info );
             gpu_time = magma_wtime() - gpu_time;
             gpu_perf = gflops / gpu_time;
             if (info != 0)
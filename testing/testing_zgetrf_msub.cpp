@@ -166,28 +166,14 @@ int main( int argc, char** argv)
     
     double tol = opts.tolerance * lapackf77_dlamch("E");
     
-    /* Initialize queues */
+    /* Initialize queues; devices may be sub-devices, see $MAGMA_NUM_SUBDEVICES */
     magma_queue_t  queues[MagmaMaxGPUs * 2];
-    magma_device_t devices[MagmaMaxGPUs];
-    magma_int_t num = 0;
     magma_int_t err;
-    err = magma_getdevices( devices, MagmaMaxGPUs, &num );
-    if ( err != 0 || num < 1 ) {
-        fprintf( stderr, "magma_getdevices failed: %d\n", (int) err );
+    err = magma_queues_create_mgpu( opts.ngpu, queues );
+    if ( err != 0 ) {
+        fprintf( stderr, "magma_queues_create_mgpu failed: %d (ngpu %d)\n", (int) err, (int) opts.ngpu );
         exit(-1);
     }
-    for( dev=0; dev < opts.ngpu; dev++ ) {
-        err = magma_queue_create( devices[dev], &queues[2*dev] );
-        if ( err != 0 ) {
-            fprintf( stderr, "magma_queue_create failed: %d (device %d)\n", (int) err, dev );
-            exit(-1);
-        }
-        err = magma_queue_create( devices[dev], &queues[2*dev+1] );
-        if ( err != 0 ) {
-            fprintf( stderr, "magma_queue_create failed: %d (device %d)\n", (int) err, dev );
-            exit(-1);
-        }
-    }
     
     printf("trans %s, ngpu %d, nsub %d\n",
            lapack_trans_const(opts.transA), (int) opts.ngpu, (int) opts.nsub );
@@ -377,10 +363,7 @@ int main( int argc, char** argv)
     }
     
     /* Free queues */
-    for( dev=0; dev < opts.ngpu; dev++ ) {
-        magma_queue_destroy( queues[2*dev] );
-        magma_queue_destroy( queues[2*dev+1] );
-    }
+    magma_queues_destroy_mgpu( opts.ngpu, queues );
 
     TESTING_FINALIZE();
     return status;
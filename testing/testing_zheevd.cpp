@@ -27,6 +27,7 @@
 
 /* ////////////////////////////////////////////////////////////////////////////
    -- Testing zheevd
+   Version 1 is magma_zheevd; version 2 is magma_zheevd_2stage.
 */
 int main( int argc, char** argv)
 {
@@ -56,8 +57,9 @@ int main( int argc, char** argv)
     // checking NoVec requires LAPACK
     opts.lapack |= (opts.check && opts.jobz == MagmaNoVec);
     
-    printf("%% jobz = %s, uplo = %s\n",
-           lapack_vec_const(opts.jobz), lapack_uplo_const(opts.uplo));
+    printf("%% jobz = %s, uplo = %s, version = %d\n",
+           lapack_vec_const(opts.jobz), lapack_uplo_const(opts.uplo),
+           (int) opts.version );
 
     printf("%%   N   CPU Time (sec)   GPU Time (sec)\n");
     printf("%%======================================\n");
@@ -68,15 +70,28 @@ int main( int argc, char** argv)
             lda = N;
             
             // query for workspace sizes
-            magma_zheevd( opts.jobz, opts.uplo,
-                          N, NULL, lda, NULL,
-                          aux_work,  -1,
-                          #ifdef COMPLEX
-                          aux_rwork, -1,
-                          #endif
-                          aux_iwork, -1,
-                          opts.queue,
-                          &info );
+            if ( opts.version == 2 ) {
+                magma_zheevd_2stage( opts.jobz, opts.uplo,
+                                     N, NULL, lda, NULL,
+                                     aux_work,  -1,
+                                     #ifdef COMPLEX
+                                     aux_rwork, -1,
+                                     #endif
+                                     aux_iwork, -1,
+                                     opts.queue,
+                                     &info );
+            }
+            else {
+                magma_zheevd( opts.jobz, opts.uplo,
+                              N, NULL, lda, NULL,
+                              aux_work,  -1,
+                              #ifdef COMPLEX
+                              aux_rwork, -1,
+                              #endif
+                              aux_iwork, -1,
+                              opts.queue,
+                              &info );
+            }
             lwork  = (magma_int_t) MAGMA_Z_REAL( aux_work[0] );
             #ifdef COMPLEX
             lrwork = (magma_int_t) aux_rwork[0];
@@ -103,7 +118,18 @@ int main( int argc, char** argv)
             
             /* warm up run */
             if ( opts.warmup ) {
-                if (opts.ngpu == 1) {
+                if (opts.ngpu == 1 && opts.version == 2) {
+                    magma_zheevd_2stage( opts.jobz, opts.uplo,
+                                         N, h_R, lda, w1,
+                                         h_work, lwork,
+                                         #ifdef COMPLEX
+                                         rwork, lrwork,
+                                         #endif
+                                         iwork, liwork,
+                                         opts.queue,
+                                         &info );
+                }
+                else if (opts.ngpu == 1) {
                     magma_zheevd( opts.jobz, opts.uplo,
                                   N, h_R, lda, w1,
                                   h_work, lwork,
@@ -135,7 +161,18 @@ int main( int argc, char** argv)
                Performs operation using MAGMA
                =================================================================== */
             gpu_time = magma_wtime();
-            if (opts.ngpu == 1) {
+            if (opts.ngpu == 1 && opts.version == 2) {
+                magma_zheevd_2stage( opts.jobz, opts.uplo,
+                                     N, h_R, lda, w1,
+                                     h_work, lwork,
+                                     #ifdef COMPLEX
+                                     rwork, lrwork,
+                                     #endif
+                                     iwork, liwork,
+                                     opts.queue,
+                                     &info );
+            }
+            else if (opts.ngpu == 1) {
                 magma_zheevd( opts.jobz, opts.uplo,
                               N, h_R, lda, w1,
                               h_work, lwork,
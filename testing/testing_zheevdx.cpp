@@ -0,0 +1,289 @@
+/*
+    -- clMAGMA (version 1.1) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @author Stan Tomov
+       @author Mark Gates
+
+       @precisions normal z -> s d c
+
+*/
+
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "magma.h"
+#include "magma_lapack.h"
+#include "testings.h"
+
+#define COMPLEX
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zheevdx
+   For each size, runs these cases:
+     1. eigenpairs IL = 1 through IU = fraction*N (see --fraction);
+     2. eigenpairs IL = N/4+1 through IU = 3N/4;
+     3. the same eigenpairs, selected by a value range (VL, VU];
+     4. case 3 with A scaled near overflow, so zheevdx and dstedx both
+        scale the matrix and the value range.
+   The value ranges lie halfway between LAPACK's eigenvalues, so the
+   expected eigenpairs are known exactly.
+*/
+int main( int argc, char** argv)
+{
+    TESTING_INIT();
+
+    const int ncase = 4;
+    const char* case_names[ncase] = { "index", "index, middle", "value", "value, scaled" };
+
+    real_Double_t   gpu_time, cpu_time;
+    magmaDoubleComplex *h_A, *h_R, *h_work, *h_W, aux_work[1];
+    #ifdef COMPLEX
+    double *rwork, aux_rwork[1];
+    magma_int_t lrwork;
+    #endif
+    double *w1, *w2, result[3]={0, 0, 0};
+    double vl, vu, scale;
+    magma_int_t *iwork, aux_iwork[1];
+    magma_int_t N, n2, info, lwork, liwork, lda, il, iu, m;
+    magma_range_t range;
+    magma_int_t izero    = 0;
+    magma_int_t ione     = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    magmaDoubleComplex c_zero    = MAGMA_Z_ZERO;
+    magmaDoubleComplex c_one     = MAGMA_Z_ONE;
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    double d_one = 1.;
+    magma_int_t status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    double tol    = opts.tolerance * lapackf77_dlamch("E");
+    double tolulp = opts.tolerance * lapackf77_dlamch("P");
+
+    // large enough that zheevdx scales A down, but |A| does not overflow
+    double big = magma_dsqrt( lapackf77_dlamch("O") );
+
+    printf("%% jobz = %s, uplo = %s, fraction = %.4f\n",
+           lapack_vec_const(opts.jobz), lapack_uplo_const(opts.uplo),
+           opts.fraction );
+
+    printf("%%   N     M   IL    IU   case             CPU Time (sec)   GPU Time (sec)\n");
+    printf("%%============================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            N = opts.nsize[itest];
+            n2  = N*N;
+            lda = N;
+
+            // query for workspace sizes
+            magma_zheevdx( opts.jobz, MagmaRangeI, opts.uplo,
+                           N, NULL, lda, 0., 0., 1, N, &m, NULL,
+                           aux_work,  -1,
+                           #ifdef COMPLEX
+                           aux_rwork, -1,
+                           #endif
+                           aux_iwork, -1,
+                           opts.queue,
+                           &info );
+            lwork  = (magma_int_t) MAGMA_Z_REAL( aux_work[0] );
+            #ifdef COMPLEX
+            lrwork = (magma_int_t) aux_rwork[0];
+            #endif
+            liwork = aux_iwork[0];
+
+            /* Allocate host memory for the matrix */
+            TESTING_MALLOC_CPU( h_A,    magmaDoubleComplex, N*lda  );
+            TESTING_MALLOC_CPU( h_W,    magmaDoubleComplex, N*lda  );
+            TESTING_MALLOC_CPU( w1,     double,             N      );
+            TESTING_MALLOC_CPU( w2,     double,             N      );
+            #ifdef COMPLEX
+            TESTING_MALLOC_CPU( rwork,  double,             lrwork );
+            #endif
+            TESTING_MALLOC_CPU( iwork,  magma_int_t,        liwork );
+
+            TESTING_MALLOC_PIN( h_R,    magmaDoubleComplex, N*lda  );
+            TESTING_MALLOC_PIN( h_work, magmaDoubleComplex, lwork  );
+
+            /* Initialize the matrix */
+            lapackf77_zlarnv( &ione, ISEED, &n2, h_A );
+            magma_zmake_hermitian( N, h_A, N );
+
+            /* =====================================================================
+               Performs operation using LAPACK
+               All eigenvalues are needed to choose the value ranges.
+               =================================================================== */
+            lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+            cpu_time = magma_wtime();
+            lapackf77_zheevd( lapack_vec_const(opts.jobz), lapack_uplo_const(opts.uplo),
+                              &N, h_R, &lda, w2,
+                              h_work, &lwork,
+                              #ifdef COMPLEX
+                              rwork, &lrwork,
+                              #endif
+                              iwork, &liwork,
+                              &info );
+            cpu_time = magma_wtime() - cpu_time;
+            if (info != 0)
+                printf("lapackf77_zheevd returned error %d: %s.\n",
+                       (int) info, magma_strerror( info ));
+
+            for( int icase = 0; icase < ncase; ++icase ) {
+                range = (icase < 2 ? MagmaRangeI : MagmaRangeV);
+                if ( icase == 0 ) {
+                    il = 1;
+                    iu = max( 1, (magma_int_t) (opts.fraction*N) );
+                    iu = min( N, iu );
+                }
+                else {
+                    il = N/4 + 1;
+                    iu = max( il, 3*N/4 );
+                }
+                // (vl, vu] contains exactly eigenvalues il through iu
+                vl = (il == 1 ? w2[0]   - (fabs( w2[0]   ) + 1.) : (w2[il-2] + w2[il-1]) / 2.);
+                vu = (iu == N ? w2[N-1] + (fabs( w2[N-1] ) + 1.) : (w2[iu-1] + w2[iu])   / 2.);
+                scale = 1.;
+                if ( icase == 3 ) {
+                    scale = big;
+                    vl *= scale;
+                    vu *= scale;
+                    lapackf77_zlascl( "G", &izero, &izero, &d_one, &scale, &N, &N, h_A, &lda, &info );
+                }
+
+                lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+
+                /* warm up run */
+                if ( opts.warmup ) {
+                    magma_zheevdx( opts.jobz, range, opts.uplo,
+                                   N, h_R, lda, vl, vu, il, iu, &m, w1,
+                                   h_work, lwork,
+                                   #ifdef COMPLEX
+                                   rwork, lrwork,
+                                   #endif
+                                   iwork, liwork,
+                                   opts.queue,
+                                   &info );
+                    if (info != 0)
+                        printf("magma_zheevdx returned error %d: %s.\n",
+                               (int) info, magma_strerror( info ));
+                    lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+                }
+
+                /* ====================================================================
+                   Performs operation using MAGMA
+                   =================================================================== */
+                gpu_time = magma_wtime();
+                magma_zheevdx( opts.jobz, range, opts.uplo,
+                               N, h_R, lda, vl, vu, il, iu, &m, w1,
+                               h_work, lwork,
+                               #ifdef COMPLEX
+                               rwork, lrwork,
+                               #endif
+                               iwork, liwork,
+                               opts.queue,
+                               &info );
+                gpu_time = magma_wtime() - gpu_time;
+                if (info != 0)
+                    printf("magma_zheevdx returned error %d: %s.\n",
+                           (int) info, magma_strerror( info ));
+
+                if ( opts.check && opts.jobz != MagmaNoVec ) {
+                    /* =====================================================================
+                       Check the M eigenpairs found, U = h_R(:,0:m-1):
+                       (1)    | A U - U S | / ( |A| N )
+                       (2)    | I - U'U | / ( N )
+                       =================================================================== */
+                    double *dwork;
+                    TESTING_MALLOC_CPU( dwork, double, N );
+
+                    double anorm = lapackf77_zlange( "M", &N, &N, h_A, &lda, dwork );
+
+                    // W = A U - U S
+                    lapackf77_zlacpy( MagmaFullStr, &N, &m, h_R, &lda, h_W, &lda );
+                    for( int j=0; j < m; j++ ) {
+                        magmaDoubleComplex s = MAGMA_Z_MAKE( w1[j], 0. );
+                        blasf77_zscal( &N, &s, &h_W[j*lda], &ione );
+                    }
+                    blasf77_zhemm( "L", lapack_uplo_const(opts.uplo), &N, &m,
+                                   &c_one,     h_A, &lda,
+                                               h_R, &lda,
+                                   &c_neg_one, h_W, &lda );
+                    result[0] = lapackf77_zlange( "1", &N, &m, h_W, &lda, dwork )
+                              / (max( anorm, 1. ) * N);
+
+                    // W = I - U'U
+                    lapackf77_zlaset( "A", &m, &m, &c_zero, &c_one, h_W, &m );
+                    blasf77_zgemm( "C", "N", &m, &m, &N,
+                                   &c_neg_one, h_R, &lda,
+                                               h_R, &lda,
+                                   &c_one,     h_W, &m );
+                    result[1] = lapackf77_zlange( "1", &m, &m, h_W, &m, dwork ) / N;
+
+                    TESTING_FREE_CPU( dwork );
+                }
+
+                // compare the eigenvalues found with eigenvalues il through iu
+                double maxw=0, diff=0;
+                if ( m == iu - il + 1 ) {
+                    for( int j=0; j < m; j++ ) {
+                        maxw = max(maxw, fabs(w1[j]));
+                        maxw = max(maxw, fabs(scale*w2[il-1+j]));
+                        diff = max(diff, fabs(w1[j] - scale*w2[il-1+j]));
+                    }
+                    result[2] = diff / (N*maxw);
+                }
+
+                /* =====================================================================
+                   Print execution time
+                   =================================================================== */
+                printf("%5d %5d %5d %5d   %-15s  %7.2f          %7.2f\n",
+                       (int) N, (int) m, (int) il, (int) iu, case_names[icase],
+                       cpu_time, gpu_time);
+                if ( opts.check && opts.jobz != MagmaNoVec ) {
+                    printf("Testing the M eigenpairs A U = U S for correctness:\n");
+                    printf("    | A U - U S | / (|A| N)      = %8.2e   %s\n",   result[0], (result[0] < tol    ? "ok" : "failed") );
+                    printf("    | I -   U'U  | /  N          = %8.2e   %s\n",   result[1], (result[1] < tol    ? "ok" : "failed") );
+                    status += ! (result[0] < tol && result[1] < tol);
+                }
+                if ( opts.check ) {
+                    if ( m == iu - il + 1 ) {
+                        printf("    | S_magma - S_lapack | / |S| = %8.2e   %s\n\n", result[2], (result[2] < tolulp ? "ok" : "failed") );
+                        status += ! (result[2] < tolulp);
+                    }
+                    else {
+                        printf("    found %d eigenvalues, expected %d   failed\n\n",
+                               (int) m, (int) (iu - il + 1) );
+                        status += 1;
+                    }
+                }
+            }
+
+            TESTING_FREE_CPU( h_A   );
+            TESTING_FREE_CPU( h_W   );
+            TESTING_FREE_CPU( w1    );
+            TESTING_FREE_CPU( w2    );
+            #ifdef COMPLEX
+            TESTING_FREE_CPU( rwork );
+            #endif
+            TESTING_FREE_CPU( iwork );
+
+            TESTING_FREE_PIN( h_R    );
+            TESTING_FREE_PIN( h_work );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    TESTING_FINALIZE();
+    return status;
+}
@@ -0,0 +1,191 @@
+/*
+    -- clMAGMA (version 1.1) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "flops.h"
+#include "magma.h"
+#include "magma_lapack.h"
+#include "testings.h"
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing zpotrf_batched
+   Version 1 is magma_zpotrf_batched; version 2 is magma_zpotrf_vbatched,
+   with each matrix a random size up to N, and every 4th matrix empty.
+*/
+int main( int argc, char** argv)
+{
+    TESTING_INIT();
+
+    real_Double_t   gflops, gpu_perf, gpu_time, cpu_perf, cpu_time;
+    magmaDoubleComplex *h_A, *h_R;
+    magmaDoubleComplex_ptr d_A;
+    magmaInt_ptr d_info, d_n, d_ldda, d_offsets;
+    magma_int_t *h_info, *h_n, *h_ldda, *h_offsets;
+    magma_int_t N, Ns, n2, lda, ldda, strideA, info, batchCount;
+    magmaDoubleComplex c_neg_one = MAGMA_Z_NEG_ONE;
+    magma_int_t ione     = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    double      work[1], error, Anorm;
+    magma_int_t     status = 0;
+
+    magma_opts opts( MagmaOptsBatched );
+    opts.parse_opts( argc, argv );
+    opts.lapack |= opts.check;  // check (-c) implies lapack (-l)
+    batchCount = opts.batchcount;
+
+    double tol = opts.tolerance * lapackf77_dlamch("E");
+
+    printf("%% version = %d, batchCount = %d, uplo = %s\n",
+           (int) opts.version, (int) batchCount, lapack_uplo_const(opts.uplo) );
+    printf("%% N     CPU GFlop/s (sec)   GPU GFlop/s (sec)   max ||R_magma - R_lapack||_F / ||R_lapack||_F\n");
+    printf("%%========================================================================\n");
+    for( int itest = 0; itest < opts.ntest; ++itest ) {
+        for( int iter = 0; iter < opts.niter; ++iter ) {
+            N       = opts.nsize[itest];
+            lda     = N;
+            n2      = lda*N*batchCount;
+            ldda    = magma_roundup( N, opts.align );  // multiple of 32 by default
+            strideA = ldda*N;
+
+            TESTING_MALLOC_CPU( h_info,    magma_int_t,        batchCount         );
+            TESTING_MALLOC_CPU( h_n,       magma_int_t,        batchCount         );
+            TESTING_MALLOC_CPU( h_ldda,    magma_int_t,        batchCount         );
+            TESTING_MALLOC_CPU( h_offsets, magma_int_t,        batchCount         );
+            TESTING_MALLOC_CPU( h_A,       magmaDoubleComplex, n2                 );
+            TESTING_MALLOC_PIN( h_R,       magmaDoubleComplex, n2                 );
+            TESTING_MALLOC_DEV( d_A,       magmaDoubleComplex, strideA*batchCount );
+            TESTING_MALLOC_DEV( d_info,    magma_int_t,        batchCount         );
+            TESTING_MALLOC_DEV( d_n,       magma_int_t,        batchCount         );
+            TESTING_MALLOC_DEV( d_ldda,    magma_int_t,        batchCount         );
+            TESTING_MALLOC_DEV( d_offsets, magma_int_t,        batchCount         );
+
+            /* Initialize the matrices, stored one after another, so the
+               batch is one N-by-N*batchCount matrix on both host and device.
+               For vbatched, matrix s is the leading h_n[s]-by-h_n[s] block
+               of its slot; the rest of the slot must be left untouched. */
+            lapackf77_zlarnv( &ione, ISEED, &n2, h_A );
+            gflops = 0;
+            for( int s = 0; s < batchCount; ++s ) {
+                h_n[s] = N;
+                if ( opts.version == 2 ) {
+                    h_n[s] = (s % 4 == 3 || N == 0 ? 0 : 1 + rand() % N);
+                }
+                h_ldda[s]    = ldda;
+                h_offsets[s] = s*strideA;
+                magma_zmake_hpd( h_n[s], h_A + s*lda*N, lda );
+                gflops += FLOPS_ZPOTRF( h_n[s] ) / 1e9;
+            }
+            magma_zsetmatrix( N, N*batchCount, h_A, lda, d_A, 0, ldda, opts.queue );
+            magma_setvector( batchCount, sizeof(magma_int_t), h_n,       1, d_n,       0, 1, opts.queue );
+            magma_setvector( batchCount, sizeof(magma_int_t), h_ldda,    1, d_ldda,    0, 1, opts.queue );
+            magma_setvector( batchCount, sizeof(magma_int_t), h_offsets, 1, d_offsets, 0, 1, opts.queue );
+
+            /* ====================================================================
+               Performs operation using MAGMA
+               =================================================================== */
+            gpu_time = magma_wtime();
+            if ( opts.version == 1 ) {
+                info = magma_zpotrf_batched( opts.uplo, N, d_A, 0, ldda, strideA,
+                                             d_info, 0, batchCount, opts.queue );
+            }
+            else if ( opts.version == 2 ) {
+                info = magma_zpotrf_vbatched( opts.uplo, d_n, N, d_A, 0, d_offsets, d_ldda,
+                                              d_info, 0, batchCount, opts.queue );
+            }
+            else {
+                printf( "Unknown version %d\n", opts.version );
+                exit(1);
+            }
+            magma_queue_sync( opts.queue );
+            gpu_time = magma_wtime() - gpu_time;
+            gpu_perf = gflops / gpu_time;
+            if (info != 0)
+                printf("magma_zpotrf_batched returned error %d: %s.\n",
+                       (int) info, magma_strerror( info ));
+
+            magma_getvector( batchCount, sizeof(magma_int_t), d_info, 0, 1, h_info, 1, opts.queue );
+            for( int s = 0; s < batchCount; ++s ) {
+                if (h_info[s] != 0) {
+                    printf("magma_zpotrf_batched matrix %d returned info %d.\n",
+                           s, (int) h_info[s] );
+                    break;
+                }
+            }
+
+            if ( opts.lapack ) {
+                /* =====================================================================
+                   Performs operation using LAPACK
+                   =================================================================== */
+                cpu_time = magma_wtime();
+                for( int s = 0; s < batchCount; ++s ) {
+                    if ( h_n[s] == 0 )
+                        continue;
+                    lapackf77_zpotrf( lapack_uplo_const(opts.uplo), &h_n[s], h_A + s*lda*N, &lda, &info );
+                    if (info != 0)
+                        printf("lapackf77_zpotrf returned error %d: %s.\n",
+                               (int) info, magma_strerror( info ));
+                }
+                cpu_time = magma_wtime() - cpu_time;
+                cpu_perf = gflops / cpu_time;
+
+                /* =====================================================================
+                   Check the result compared to LAPACK
+                   =================================================================== */
+                magma_zgetmatrix( N, N*batchCount, d_A, 0, ldda, h_R, lda, opts.queue );
+                error = 0;
+                n2 = lda*N;
+                for( int s = 0; s < batchCount; ++s ) {
+                    // the difference is over the whole slot, to catch writes
+                    // outside the matrix, but relative to the matrix's norm
+                    Ns = h_n[s];
+                    Anorm = 1;
+                    if ( Ns > 0 ) {
+                        Anorm = lapackf77_zlange( "f", &Ns, &Ns, h_A + s*n2, &lda, work );
+                    }
+                    blasf77_zaxpy( &n2, &c_neg_one, h_A + s*n2, &ione, h_R + s*n2, &ione );
+                    error = max( error, lapackf77_zlange( "f", &N, &N, h_R + s*n2, &lda, work ) / Anorm );
+                }
+
+                printf("%5d   %7.2f (%7.2f)   %7.2f (%7.2f)   %8.2e   %s\n",
+                       (int) N, cpu_perf, cpu_time, gpu_perf, gpu_time,
+                       error, (error < tol ? "ok" : "failed") );
+                status += ! (error < tol);
+            }
+            else {
+                printf("%5d     ---   (  ---  )   %7.2f (%7.2f)     ---  \n",
+                       (int) N, gpu_perf, gpu_time );
+            }
+            TESTING_FREE_CPU( h_info );
+            TESTING_FREE_CPU( h_n );
+            TESTING_FREE_CPU( h_ldda );
+            TESTING_FREE_CPU( h_offsets );
+            TESTING_FREE_CPU( h_A );
+            TESTING_FREE_PIN( h_R );
+            TESTING_FREE_DEV( d_A );
+            TESTING_FREE_DEV( d_info );
+            TESTING_FREE_DEV( d_n );
+            TESTING_FREE_DEV( d_ldda );
+            TESTING_FREE_DEV( d_offsets );
+            fflush( stdout );
+        }
+        if ( opts.niter > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    TESTING_FINALIZE();
+    return status;
+}
@@ -71,7 +71,7 @@ int main( int argc, char** argv )
         }
     }
     
-    printf("%% ngpu = %d, uplo = %s\n", (int) opts.ngpu, lapack_uplo_const(opts.uplo) );
+    printf("%% ngpu = %d, uplo = %s, version %d (2: tile DAG)\n", (int) opts.ngpu, lapack_uplo_const(opts.uplo), (int) opts.version );
     printf("%%   N   CPU GFlop/s (sec)   GPU GFlop/s (sec)   ||R||_F / ||A||_F\n");
     printf("%%================================================================\n");
     for( int itest = 0; itest < opts.ntest; ++itest ) {
@@ -133,7 +133,10 @@ int main( int argc, char** argv )
             }
             
             gpu_time = magma_wtime();
-            magma_zpotrf_mgpu( ngpu, opts.uplo, N, d_lA, 0, ldda, queues2, &info );
+            if ( opts.version == 2 )
+                magma_zpotrf_tile_mgpu( ngpu, opts.uplo, N, d_lA, 0, ldda, queues2, &info );
+            else
+                magma_zpotrf_mgpu( ngpu, opts.uplo, N, d_lA, 0, ldda, queues2, &info );
             gpu_time = magma_wtime() - gpu_time;
             gpu_perf = gflops / gpu_time;
             if (info != 0)
@@ -84,27 +84,14 @@ int main( int argc, char** argv)
 
     /* Initialize */
     magma_queue_t  queues[2*MagmaMaxGPUs];
-    magma_device_t devices[ MagmaMaxGPUs ];
-    magma_int_t num = 0;
     magma_int_t err;
     magma_init();
-    err = magma_getdevices( devices, MagmaMaxGPUs, &num );
-    if ( err != 0 || num < 1 ) {
-        fprintf( stderr, "magma_getdevices failed: %d\n", (int) err );
+    // devices may be sub-devices, see $MAGMA_NUM_SUBDEVICES
+    err = magma_queues_create_mgpu( num_gpus0, queues );
+    if ( err != 0 ) {
+        fprintf( stderr, "magma_queues_create_mgpu failed: %d (ngpu %d)\n", (int) err, (int) num_gpus0 );
         exit(-1);
     }
-    for(i=0;i<num_gpus0;i++){
-        err = magma_queue_create( devices[i], &queues[2*i] );
-        if ( err != 0 ) {
-            fprintf( stderr, "magma_queue_create failed: %d\n", (int) err );
-            exit(-1);
-        }
-        err = magma_queue_create( devices[i], &queues[2*i+1] );
-        if ( err != 0 ) {
-            fprintf( stderr, "magma_queue_create failed: %d\n", (int) err );
-            exit(-1);
-        }
-    }
 
     printf("\nUsing %d GPUs:\n", num_gpus0);
     printf("  testing_zpotrf_msub -N %d -NGPU %d -NSUB %d -UPLO %c %s\n\n", size[0], num_gpus0,num_subs0,
@@ -343,10 +330,7 @@ int main( int argc, char** argv)
     }
 
     /* clean up */
-    for (i=0; i<num_gpus; i++) {
-        magma_queue_destroy( queues[2*i] );
-        magma_queue_destroy( queues[2*i+1] );
-    }
+    magma_queues_destroy_mgpu( num_gpus0, queues );
     magma_finalize();
     return 0;
 }
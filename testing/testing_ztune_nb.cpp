@@ -0,0 +1,216 @@
+/*
+    -- clMAGMA (version 1.3.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// includes, project
+#include "flops.h"
+#include "magma.h"
+#include "magma_lapack.h"
+#include "testings.h"
+
+#define PRECISION_z
+
+// routines tuned, with their names in the nb profile
+enum { POTRF, GETRF, GEQRF, GEHRD, HETRD, GEBRD, NROUTINES };
+
+static const char* routine_names[ NROUTINES ] = {
+    "zpotrf", "zgetrf", "zgeqrf", "zgehrd", "zhetrd", "zgebrd"
+};
+
+typedef magma_int_t (*get_nb_func)( magma_int_t m );
+
+static get_nb_func routine_get_nb[ NROUTINES ] = {
+    magma_get_zpotrf_nb, magma_get_zgetrf_nb, magma_get_zgeqrf_nb,
+    magma_get_zgehrd_nb, magma_get_zhetrd_nb, magma_get_zgebrd_nb
+};
+
+// candidate block sizes
+static const magma_int_t nb_list[] = { 32, 64, 96, 128, 192, 256, 320, 384, 512 };
+static const int nb_list_len = sizeof(nb_list) / sizeof(nb_list[0]);
+
+
+// ----------------------------------------
+// Runs routine on the N-by-N matrix h_A with the nb currently in effect,
+// returning the best time of niter runs, or -1 on error.
+static double time_routine(
+    int routine, magma_int_t N, const magmaDoubleComplex* h_A,
+    magma_opts& opts )
+{
+    magmaDoubleComplex *h_R, *h_work, *tau, *taup;
+    magmaDoubleComplex_ptr d_A, dT;
+    double *diag, *offdiag;
+    magma_int_t *ipiv;
+    magma_int_t lda, ldda, n2, nb, lwork, info;
+    double time, best = -1;
+
+    lda  = N;
+    n2   = lda*N;
+    ldda = magma_roundup( N, opts.align );  // multiple of 32 by default
+    nb   = routine_get_nb[ routine ]( N );
+    // enough for every routine, given the magma nb is bigger than lapack nb
+    lwork = 2*N*nb;
+
+    TESTING_MALLOC_CPU( tau,     magmaDoubleComplex, N     );
+    TESTING_MALLOC_CPU( taup,    magmaDoubleComplex, N     );
+    TESTING_MALLOC_CPU( diag,    double,             N     );
+    TESTING_MALLOC_CPU( offdiag, double,             N     );
+    TESTING_MALLOC_CPU( ipiv,    magma_int_t,        N     );
+    TESTING_MALLOC_PIN( h_R,     magmaDoubleComplex, n2    );
+    TESTING_MALLOC_PIN( h_work,  magmaDoubleComplex, lwork );
+    TESTING_MALLOC_DEV( d_A,     magmaDoubleComplex, ldda*N );
+    TESTING_MALLOC_DEV( dT,      magmaDoubleComplex, nb*N  );
+
+    for( int iter = 0; iter < opts.niter; ++iter ) {
+        lapackf77_zlacpy( MagmaFullStr, &N, &N, h_A, &lda, h_R, &lda );
+        if ( routine == POTRF || routine == GETRF || routine == GEQRF ) {
+            magma_zsetmatrix( N, N, h_R, lda, d_A, 0, ldda, opts.queue );
+            magma_queue_sync( opts.queue );
+        }
+
+        time = magma_wtime();
+        switch( routine ) {
+            case POTRF:
+                magma_zpotrf_gpu( opts.uplo, N, d_A, 0, ldda, opts.queue, &info );
+                break;
+            case GETRF:
+                magma_zgetrf_gpu( N, N, d_A, 0, ldda, ipiv, opts.queue, &info );
+                break;
+            case GEQRF:
+                magma_zgeqrf2_gpu( N, N, d_A, 0, ldda, tau, opts.queues2, &info );
+                break;
+            case GEHRD:
+                magma_zgehrd( N, 1, N, h_R, lda, tau, h_work, lwork, dT, 0, opts.queue, &info );
+                break;
+            case HETRD:
+                magma_zhetrd( opts.uplo, N, h_R, lda, diag, offdiag, tau,
+                              h_work, lwork, opts.queue, &info );
+                break;
+            case GEBRD:
+                magma_zgebrd( N, N, h_R, lda, diag, offdiag, tau, taup,
+                              h_work, lwork, opts.queue, &info );
+                break;
+        }
+        magma_queue_sync( opts.queue );
+        time = magma_wtime() - time;
+        if (info != 0) {
+            printf("magma_%s returned error %d: %s.\n",
+                   routine_names[ routine ], (int) info, magma_strerror( info ));
+            best = -1;
+            break;
+        }
+        if ( best < 0 || time < best ) {
+            best = time;
+        }
+    }
+
+    TESTING_FREE_CPU( tau     );
+    TESTING_FREE_CPU( taup    );
+    TESTING_FREE_CPU( diag    );
+    TESTING_FREE_CPU( offdiag );
+    TESTING_FREE_CPU( ipiv    );
+    TESTING_FREE_PIN( h_R     );
+    TESTING_FREE_PIN( h_work  );
+    TESTING_FREE_DEV( d_A     );
+    TESTING_FREE_DEV( dT      );
+    return best;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Tunes nb for potrf, getrf, geqrf, gehrd, hetrd, and gebrd
+   For each size N, times each routine with the built-in nb (with the profile
+   disabled) and with each candidate nb < N, and stores the fastest nb in the
+   nb profile of the --dev device, which magma_get_*_nb use for sizes up to N
+   (and above the previous size). Best of niter runs is used.
+   The matrix is Hermitian positive definite so potrf succeeds.
+*/
+int main( int argc, char** argv)
+{
+    TESTING_INIT();
+
+    magmaDoubleComplex *h_A;
+    magma_int_t N, n2, lda, default_nb, best_nb;
+    magma_int_t ione     = 1;
+    magma_int_t ISEED[4] = {0,0,0,1};
+    double      default_time, best_time, time;
+    magma_int_t status = 0;
+
+    magma_opts opts;
+    opts.parse_opts( argc, argv );
+
+    magma_int_t ndevices;
+    magma_device_t devices[ MagmaMaxGPUs ];
+    magma_getdevices( devices, MagmaMaxGPUs, &ndevices );
+    magma_nb_profile_set_device( devices[ opts.device ] );
+
+    printf("%% routine     N   default nb (sec)     tuned nb (sec)    speedup\n");
+    printf("%%========================================================================\n");
+    for( int routine = 0; routine < NROUTINES; ++routine ) {
+        for( int itest = 0; itest < opts.ntest; ++itest ) {
+            N   = opts.nsize[itest];
+            lda = N;
+            n2  = lda*N;
+
+            TESTING_MALLOC_CPU( h_A, magmaDoubleComplex, n2 );
+            lapackf77_zlarnv( &ione, ISEED, &n2, h_A );
+            magma_zmake_hpd( N, h_A, lda );
+
+            // time the built-in tables, ignoring the whole profile,
+            // including buckets of other sizes that the routine may use
+            magma_nb_profile_enable( MagmaFalse );
+            default_nb   = routine_get_nb[ routine ]( N );
+            default_time = time_routine( routine, N, h_A, opts );
+            magma_nb_profile_enable( MagmaTrue );
+            best_nb      = default_nb;
+            best_time    = default_time;
+
+            for( int i = 0; i < nb_list_len; ++i ) {
+                if ( nb_list[i] >= N || nb_list[i] == default_nb )
+                    continue;
+                magma_nb_profile_set( routine_names[ routine ], N, nb_list[i] );
+                time = time_routine( routine, N, h_A, opts );
+                if ( time >= 0 && (best_time < 0 || time < best_time) ) {
+                    best_nb   = nb_list[i];
+                    best_time = time;
+                }
+            }
+            magma_nb_profile_set( routine_names[ routine ], N, best_nb );
+
+            if ( best_time < 0 ) {
+                printf("%-8s %5d   failed with every nb\n",
+                       routine_names[ routine ], (int) N );
+                status += 1;
+            }
+            else {
+                printf("%-8s %5d   %4d   (%7.4f)   %4d   (%7.4f)   %6.2f\n",
+                       routine_names[ routine ], (int) N,
+                       (int) default_nb, default_time, (int) best_nb, best_time,
+                       (default_time > 0 ? default_time / best_time : 1.) );
+            }
+            TESTING_FREE_CPU( h_A );
+            fflush( stdout );
+        }
+        if ( opts.ntest > 1 ) {
+            printf( "\n" );
+        }
+    }
+
+    if ( magma_nb_profile_save() != MAGMA_SUCCESS ) {
+        printf("magma_nb_profile_save failed; nb profile not written.\n");
+        status += 1;
+    }
+
+    TESTING_FINALIZE();
+    return status;
+}
@@ -156,6 +156,8 @@ lapack = [
     ('sgebd2',         'dgebd2',         'cgebd2',         'zgebd2'          ),
     ('sgebrd',         'dgebrd',         'cgebrd',         'zgebrd'          ),
     ('sgbbrd',         'dgbbrd',         'cgbbrd',         'zgbbrd'          ),
+    ('sgb2bd',         'dgb2bd',         'cgb2bd',         'zgb2bd'          ),
+    ('sge2gb',         'dge2gb',         'cge2gb',         'zge2gb'          ),
     ('sgeev',          'dgeev',          'cgeev',          'zgeev'           ),
     ('sgegqr',         'dgegqr',         'cgegqr',         'zgegqr'          ),
     ('sgehd2',         'dgehd2',         'cgehd2',         'zgehd2'          ),
@@ -197,6 +199,7 @@ lapack = [
     ('slag2d',         'dlag2s',         'clag2z',         'zlag2c'          ),
     ('slagsy',         'dlagsy',         'claghe',         'zlaghe'          ),
     ('slagsy',         'dlagsy',         'clagsy',         'zlagsy'          ),
+    ('slahqr',         'dlahqr',         'clahqr',         'zlahqr'          ),
     ('slahr',          'dlahr',          'clahr',          'zlahr'           ),
     ('slaln2',         'dlaln2',         'slaln2',         'dlaln2'          ),
     ('slamc3',         'dlamc3',         'slamc3',         'dlamc3'          ),